@@ -244,7 +244,7 @@ status_t CameraMetadata::update(uint32_t tag,
     if ( (res = checkType(tag, TYPE_INT32)) != OK) {
         return res;
     }
-    return updateImpl(tag, (const void*)data, data_count);
+    return updateImpl(tag, TYPE_INT32, (const void*)data, data_count);
 }
 
 status_t CameraMetadata::update(uint32_t tag,
@@ -257,7 +257,7 @@ status_t CameraMetadata::update(uint32_t tag,
     if ( (res = checkType(tag, TYPE_BYTE)) != OK) {
         return res;
     }
-    return updateImpl(tag, (const void*)data, data_count);
+    return updateImpl(tag, TYPE_BYTE, (const void*)data, data_count);
 }
 
 status_t CameraMetadata::update(uint32_t tag,
@@ -270,7 +270,7 @@ status_t CameraMetadata::update(uint32_t tag,
     if ( (res = checkType(tag, TYPE_FLOAT)) != OK) {
         return res;
     }
-    return updateImpl(tag, (const void*)data, data_count);
+    return updateImpl(tag, TYPE_FLOAT, (const void*)data, data_count);
 }
 
 status_t CameraMetadata::update(uint32_t tag,
@@ -283,7 +283,7 @@ status_t CameraMetadata::update(uint32_t tag,
     if ( (res = checkType(tag, TYPE_INT64)) != OK) {
         return res;
     }
-    return updateImpl(tag, (const void*)data, data_count);
+    return updateImpl(tag, TYPE_INT64, (const void*)data, data_count);
 }
 
 status_t CameraMetadata::update(uint32_t tag,
@@ -296,7 +296,7 @@ status_t CameraMetadata::update(uint32_t tag,
     if ( (res = checkType(tag, TYPE_DOUBLE)) != OK) {
         return res;
     }
-    return updateImpl(tag, (const void*)data, data_count);
+    return updateImpl(tag, TYPE_DOUBLE, (const void*)data, data_count);
 }
 
 status_t CameraMetadata::update(uint32_t tag,
@@ -309,7 +309,7 @@ status_t CameraMetadata::update(uint32_t tag,
     if ( (res = checkType(tag, TYPE_RATIONAL)) != OK) {
         return res;
     }
-    return updateImpl(tag, (const void*)data, data_count);
+    return updateImpl(tag, TYPE_RATIONAL, (const void*)data, data_count);
 }
 
 status_t CameraMetadata::update(uint32_t tag,
@@ -323,7 +323,7 @@ status_t CameraMetadata::update(uint32_t tag,
         return res;
     }
     // string.size() doesn't count the null termination character.
-    return updateImpl(tag, (const void*)string.string(), string.size() + 1);
+    return updateImpl(tag, TYPE_BYTE, (const void*)string.string(), string.size() + 1);
 }
 
 status_t CameraMetadata::update(const camera_metadata_ro_entry &entry) {
@@ -335,21 +335,16 @@ status_t CameraMetadata::update(const camera_metadata_ro_entry &entry) {
     if ( (res = checkType(entry.tag, entry.type)) != OK) {
         return res;
     }
-    return updateImpl(entry.tag, (const void*)entry.data.u8, entry.count);
+    return updateImpl(entry.tag, entry.type, (const void*)entry.data.u8, entry.count);
 }
 
-status_t CameraMetadata::updateImpl(uint32_t tag, const void *data,
+status_t CameraMetadata::updateImpl(uint32_t tag, uint8_t type, const void *data,
         size_t data_count) {
     status_t res;
     if (mLocked) {
         ALOGE("%s: CameraMetadata is locked", __FUNCTION__);
         return INVALID_OPERATION;
     }
-    int type = get_local_camera_metadata_tag_type(tag, mBuffer);
-    if (type == -1) {
-        ALOGE("%s: Tag %d not found", __FUNCTION__, tag);
-        return BAD_VALUE;
-    }
     // Safety check - ensure that data isn't pointing to this metadata, since
     // that would get invalidated if a resize is needed
     size_t bufferSize = get_camera_metadata_size(mBuffer);
@@ -364,15 +359,23 @@ status_t CameraMetadata::updateImpl(uint32_t tag, const void *data,
     size_t data_size = calculate_camera_metadata_entry_data_size(type,
             data_count);
 
-    res = resizeIfNeeded(1, data_size);
-
-    if (res == OK) {
-        camera_metadata_entry_t entry;
-        res = find_camera_metadata_entry(mBuffer, tag, &entry);
-        if (res == NAME_NOT_FOUND) {
+    // Look up the entry first, so that updating an existing entry only grows
+    // the buffer by the extra data it needs. Resizing keeps the entry order,
+    // so the entry index stays valid.
+    camera_metadata_entry_t entry;
+    res = (mBuffer == NULL) ? NAME_NOT_FOUND :
+            find_camera_metadata_entry(mBuffer, tag, &entry);
+    if (res == NAME_NOT_FOUND) {
+        res = resizeIfNeeded(1, data_size);
+        if (res == OK) {
             res = add_camera_metadata_entry(mBuffer,
                     tag, data, data_count);
-        } else if (res == OK) {
+        }
+    } else if (res == OK) {
+        size_t entry_size = calculate_camera_metadata_entry_data_size(entry.type,
+                entry.count);
+        res = resizeIfNeeded(0, (data_size > entry_size) ? data_size - entry_size : 0);
+        if (res == OK) {
             res = update_camera_metadata_entry(mBuffer,
                     entry.index, data, data_count, NULL);
         }
@@ -249,11 +249,11 @@ const char* VendorTagDescriptor::getTagName(uint32_t tag) const {
 }
 
 int VendorTagDescriptor::getTagType(uint32_t tag) const {
-    ssize_t index = mTagToNameMap.indexOfKey(tag);
+    ssize_t index = mTagToTypeMap.indexOfKey(tag);
     if (index < 0) {
         return VENDOR_TAG_TYPE_ERR;
     }
-    return mTagToTypeMap.valueFor(tag);
+    return mTagToTypeMap.valueAt(index);
 }
 
 status_t VendorTagDescriptor::writeToParcel(android::Parcel* parcel) const {
@@ -298,9 +298,10 @@ class CameraMetadata: public Parcelable {
     status_t checkType(uint32_t tag, uint8_t expectedType);
 
     /**
-     * Base update entry method
+     * Base update entry method. The tag must already be checked to have the
+     * given type.
      */
-    status_t updateImpl(uint32_t tag, const void *data, size_t data_count);
+    status_t updateImpl(uint32_t tag, uint8_t type, const void *data, size_t data_count);
 
     /**
      * Resize metadata buffer if needed by reallocating it and copying it over.
@@ -48,6 +48,7 @@ const char* CameraDevice::kSequenceIdKey     = "SequenceId";
 const char* CameraDevice::kFrameNumberKey    = "FrameNumber";
 const char* CameraDevice::kAnwKey            = "Anw";
 const char* CameraDevice::kFailingPhysicalCameraId= "FailingPhysicalCameraId";
+const char* CameraDevice::kResultBatchKey    = "ResultBatch";
 
 /**
  * CameraDevice Implementation
@@ -114,12 +115,32 @@ CameraDevice::~CameraDevice() { }
 
 void
 CameraDevice::postSessionMsgAndCleanup(sp<AMessage>& msg) {
+    closeResultBatchLocked();
     msg->post();
     msg.clear();
     sp<AMessage> cleanupMsg = new AMessage(kWhatCleanUpSessions, mHandler);
     cleanupMsg->post();
 }
 
+void
+CameraDevice::postResultMsgAndCleanupLocked(sp<AMessage>& msg) {
+    if (mResultBatch != nullptr) {
+        Mutex::Autolock _l(mResultBatch->mLock);
+        if (!mResultBatch->mClosed) {
+            mResultBatch->mResults.push_back(msg);
+            msg.clear();
+            return;
+        }
+    }
+    sp<ResultBatch> batch = new ResultBatch();
+    batch->mResults.push_back(msg);
+    msg.clear();
+    sp<AMessage> batchMsg = new AMessage(kWhatCaptureResultBatch, mHandler);
+    batchMsg->setObject(kResultBatchKey, batch);
+    postSessionMsgAndCleanup(batchMsg);
+    mResultBatch = batch;
+}
+
 // TODO: cached created request?
 camera_status_t
 CameraDevice::createCaptureRequest(
@@ -924,6 +945,25 @@ void CameraDevice::CallbackHandler::onMessageReceived(
         case kWhatCleanUpSessions:
             mCachedSessions.clear();
             return;
+        case kWhatCaptureResultBatch:
+        {
+            sp<RefBase> obj;
+            if (!msg->findObject(kResultBatchKey, &obj) || obj == nullptr) {
+                ALOGE("%s: Cannot find result batch!", __FUNCTION__);
+                return;
+            }
+            sp<ResultBatch> batch(static_cast<ResultBatch*>(obj.get()));
+            std::vector<sp<AMessage>> results;
+            {
+                Mutex::Autolock _l(batch->mLock);
+                batch->mClosed = true;
+                results.swap(batch->mResults);
+            }
+            for (const auto& result : results) {
+                onMessageReceived(result);
+            }
+            return;
+        }
         default:
             ALOGE("%s:Error: unknown device callback %d", __FUNCTION__, msg->what());
             return;
@@ -1511,6 +1551,7 @@ CameraDevice::ServiceCallback::onDeviceError(
             msg->setPointer(kContextKey, dev->mAppCallbacks.context);
             msg->setPointer(kDeviceKey, (void*) dev->getWrapper());
             msg->setPointer(kCallbackFpKey, (void*) dev->mAppCallbacks.onDisconnected);
+            dev->closeResultBatchLocked();
             msg->post();
             break;
         }
@@ -1541,6 +1582,7 @@ CameraDevice::ServiceCallback::onDeviceError(
             msg->setPointer(kDeviceKey, (void*) dev->getWrapper());
             msg->setPointer(kCallbackFpKey, (void*) dev->mAppCallbacks.onError);
             msg->setInt32(kErrorCodeKey, errorVal);
+            dev->closeResultBatchLocked();
             msg->post();
             break;
         }
@@ -1682,7 +1724,16 @@ CameraDevice::ServiceCallback::onResultReceived(
         return ret;
     }
 
-    CameraMetadata metadataCopy = metadata;
+    // Size the copy for the two entries added below, so that adding them does not reallocate
+    // and copy the whole result a second time.
+    const camera_metadata_t* buffer = metadata.getAndLock();
+    size_t entryCount = (buffer == nullptr) ? 0 : get_camera_metadata_entry_count(buffer);
+    size_t dataCount = (buffer == nullptr) ? 0 : get_camera_metadata_data_count(buffer);
+    metadata.unlock(buffer);
+    CameraMetadata metadataCopy(entryCount + 2, dataCount + kAddedResultDataBytes);
+    if (entryCount > 0) {
+        metadataCopy.append(metadata);
+    }
     metadataCopy.update(ANDROID_LENS_INFO_SHADING_MAP_SIZE, dev->mShadingMapSize, /*data_count*/2);
     metadataCopy.update(ANDROID_SYNC_FRAME_NUMBER, &frameNumber, /*data_count*/1);
 
@@ -1719,7 +1770,7 @@ CameraDevice::ServiceCallback::onResultReceived(
             msg->setPointer(kCallbackFpKey,
                     (void *)cbh.mOnCaptureCompleted);
         }
-        dev->postSessionMsgAndCleanup(msg);
+        dev->postResultMsgAndCleanupLocked(msg);
     }
 
     if (!isPartialResult) {
@@ -172,6 +172,14 @@ class CameraDevice final : public RefBase {
     // Input message will be posted and cleared after this returns
     void postSessionMsgAndCleanup(sp<AMessage>& msg);
 
+    // Capture results that arrive while the callback looper has not yet reached the previous
+    // result are appended to the same batch, so a burst of results costs one looper message.
+    // Input message will be queued and cleared after this returns.
+    void postResultMsgAndCleanupLocked(sp<AMessage>& msg);
+
+    // Any message posted after this is delivered after the results already batched
+    inline void closeResultBatchLocked() { mResultBatch.clear(); }
+
     static camera_status_t getIGBPfromAnw(
             ANativeWindow* anw, sp<IGraphicBufferProducer>& out);
 
@@ -223,6 +231,7 @@ class CameraDevice final : public RefBase {
         kWhatCaptureSeqEnd,    // onCaptureSequenceCompleted
         kWhatCaptureSeqAbort,  // onCaptureSequenceAborted
         kWhatCaptureBufferLost,// onCaptureBufferLost
+        kWhatCaptureResultBatch, // Several kWhatCaptureResult/kWhatLogicalCaptureResult
         // Internal cleanup
         kWhatCleanUpSessions   // Cleanup cached sp<ACameraCaptureSession>
     };
@@ -240,6 +249,17 @@ class CameraDevice final : public RefBase {
     static const char* kFrameNumberKey;
     static const char* kAnwKey;
     static const char* kFailingPhysicalCameraId;
+    static const char* kResultBatchKey;
+
+    // Result messages waiting for the callback looper, in arrival order
+    struct ResultBatch : public RefBase {
+        Mutex mLock;
+        std::vector<sp<AMessage>> mResults;
+        // Set once the looper starts delivering; later results go to a new batch
+        bool mClosed = false;
+    };
+    // The batch new results are appended to, if its message is still queued
+    sp<ResultBatch> mResultBatch;
 
     class CallbackHandler : public AHandler {
       public:
@@ -386,6 +406,8 @@ class CameraDevice final : public RefBase {
 
     // Misc variables
     int32_t mShadingMapSize[2];   // const after constructor
+    // Data bytes of the shading map size and sync frame number entries added to every result
+    static constexpr size_t kAddedResultDataBytes = 32;
     int32_t mPartialResultCount;  // const after constructor
     std::vector<std::string> mPhysicalIds; // const after constructor
 
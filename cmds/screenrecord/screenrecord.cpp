@@ -14,7 +14,12 @@
  * limitations under the License.
  */
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string_view>
+#include <thread>
 #include <type_traits>
 
 #include <assert.h>
@@ -123,6 +128,7 @@ static AString gCodecName = "";         // codec name override
 static bool gSizeSpecified = false;     // was size explicitly requested?
 static bool gWantInfoScreen = false;    // do we want initial info screen?
 static bool gWantFrameTime = false;     // do we want times on each frame?
+static bool gLowLatency = false;        // direct encoder surface, async muxing
 static uint32_t gVideoWidth = 0;        // default width+height
 static uint32_t gVideoHeight = 0;
 static uint32_t gBitRate = 20000000;     // 20Mbps
@@ -252,6 +258,10 @@ static status_t prepareEncoder(float displayFps, sp<MediaCodec>* pCodec,
         }
     }
     format->setFloat(KEY_FRAME_RATE, displayFps);
+    if (gLowLatency) {
+        format->setInt32(KEY_PRIORITY, 0);  // realtime
+        format->setInt32(KEY_LATENCY, 1);
+    }
 
     err = codec->configure(format, NULL, NULL,
             MediaCodec::CONFIGURE_FLAG_ENCODE);
@@ -504,6 +514,109 @@ static status_t writeWinscopeMetadata(const Vector<std::int64_t>& timestampsMono
     return AMediaMuxer_writeSampleData(muxer, metaTrackIdx, buffer->data(), &bufferInfo);
 }
 
+/*
+ * Writes encoded samples to the muxer on a separate thread, so that the
+ * encoder drain loop doesn't stall while the muxer is blocked on file I/O.
+ * Samples are copied, which lets the encoder output buffer be released
+ * right away.
+ *
+ * The muxer must have been started before the first sample is queued.
+ */
+class MuxerWriter {
+public:
+    explicit MuxerWriter(AMediaMuxer* muxer) :
+            mMuxer(muxer),
+            mThread(&MuxerWriter::threadLoop, this) {}
+
+    ~MuxerWriter() { stop(); }
+
+    /*
+     * Queues a copy of the sample for writing.  Returns the first error the
+     * writer thread got from the muxer, if any.
+     */
+    status_t queueSample(ssize_t trackIdx, const uint8_t* data, size_t size,
+            int64_t ptsUsec, uint32_t flags) {
+        Sample sample = { trackIdx, new ABuffer(size), ptsUsec, flags };
+        memcpy(sample.buffer->data(), data, size);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mErr != NO_ERROR) {
+            return mErr;
+        }
+        mSamples.push_back(std::move(sample));
+        mMaxQueuedSamples = std::max(mMaxQueuedSamples, mSamples.size());
+        mCondition.notify_one();
+        return NO_ERROR;
+    }
+
+    /*
+     * Waits until all queued samples are written, then stops the writer
+     * thread.  Returns the first error from the muxer, if any.
+     */
+    status_t stop() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+            mCondition.notify_one();
+        }
+        if (mThread.joinable()) {
+            mThread.join();
+        }
+        return mErr;
+    }
+
+    size_t getMaxQueuedSamples() const { return mMaxQueuedSamples; }
+
+private:
+    struct Sample {
+        ssize_t trackIdx;
+        sp<ABuffer> buffer;
+        int64_t ptsUsec;
+        uint32_t flags;
+    };
+
+    void threadLoop() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true) {
+            mCondition.wait(lock, [this] { return mStopping || !mSamples.empty(); });
+            if (mSamples.empty()) {
+                break;  // stopping, and everything has been written
+            }
+
+            Sample sample = std::move(mSamples.front());
+            mSamples.pop_front();
+            if (mErr != NO_ERROR) {
+                continue;  // drop the rest after an error
+            }
+
+            lock.unlock();
+            ATRACE_NAME("write sample");
+            AMediaCodecBufferInfo bufferInfo = {
+                0 /* offset */,
+                static_cast<int32_t>(sample.buffer->size()),
+                sample.ptsUsec /* presentationTimeUs */,
+                sample.flags
+            };
+            status_t err = AMediaMuxer_writeSampleData(mMuxer, sample.trackIdx,
+                    sample.buffer->data(), &bufferInfo);
+            lock.lock();
+
+            if (err != NO_ERROR) {
+                mErr = err;
+            }
+        }
+    }
+
+    AMediaMuxer* const mMuxer;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<Sample> mSamples;
+    size_t mMaxQueuedSamples = 0;
+    bool mStopping = false;
+    status_t mErr = NO_ERROR;
+    std::thread mThread;    // last, so it starts after everything else is set up
+};
+
 /*
  * Runs the MediaCodec encoder, sending the output to the MediaMuxer.  The
  * input frames are coming from the virtual display as fast as SurfaceFlinger
@@ -515,8 +628,9 @@ static status_t writeWinscopeMetadata(const Vector<std::int64_t>& timestampsMono
  */
 static status_t runEncoder(const sp<MediaCodec>& encoder,
         AMediaMuxer *muxer, FILE* rawFp, const sp<IBinder>& display,
-        const sp<IBinder>& virtualDpy, ui::Rotation orientation) {
+        const sp<IBinder>& virtualDpy, ui::Rotation orientation, float displayFps) {
     static int kTimeout = 250000;   // be responsive on signal
+    static const int64_t kLowLatencyOrientationPollNsec = milliseconds_to_nanoseconds(250);
     status_t err;
     ssize_t trackIdx = -1;
     ssize_t metaLegacyTrackIdx = -1;
@@ -526,6 +640,17 @@ static status_t runEncoder(const sp<MediaCodec>& encoder,
     int64_t endWhenNsec = startWhenNsec + seconds_to_nanoseconds(gTimeLimitSec);
     Vector<int64_t> timestampsMonotonicUs;
     bool firstFrame = true;
+    int64_t nextOrientationPollNsec = 0;
+
+    // Frames are counted as dropped when the gap to the previous frame spans
+    // more than one display refresh.  The virtual display only produces frames
+    // when the screen content changes, so this is an upper bound.
+    const int64_t frameIntervalUsec = displayFps > 0 ? (int64_t)(1000000 / displayFps) : 0;
+    int64_t prevPtsUsec = -1;
+    uint32_t numDroppedFrames = 0;
+
+    // In low-latency mode the samples are written on a separate thread.
+    std::unique_ptr<MuxerWriter> muxerWriter;
 
     assert((rawFp == NULL && muxer != NULL) || (rawFp != NULL && muxer == NULL));
 
@@ -574,8 +699,10 @@ static status_t runEncoder(const sp<MediaCodec>& encoder,
                 ALOGV("Got data in buffer %zu, size=%zu, pts=%" PRId64,
                         bufIndex, size, ptsUsec);
 
-                { // scope
+                int64_t nowNsec = systemTime(CLOCK_MONOTONIC);
+                if (!gLowLatency || nowNsec >= nextOrientationPollNsec) {
                     ATRACE_NAME("orientation");
+                    nextOrientationPollNsec = nowNsec + kLowLatencyOrientationPollNsec;
                     // Check orientation, update if it has changed.
                     //
                     // Polling for changes is inefficient and wrong, but the
@@ -601,6 +728,17 @@ static status_t runEncoder(const sp<MediaCodec>& encoder,
                     ptsUsec = systemTime(SYSTEM_TIME_MONOTONIC) / 1000;
                 }
 
+                if ((flags & MediaCodec::BUFFER_FLAG_CODECCONFIG) == 0) {
+                    if (prevPtsUsec >= 0 && frameIntervalUsec > 0) {
+                        int64_t gapUsec = ptsUsec - prevPtsUsec;
+                        if (gapUsec > frameIntervalUsec * 3 / 2) {
+                            numDroppedFrames +=
+                                    (gapUsec + frameIntervalUsec / 2) / frameIntervalUsec - 1;
+                        }
+                    }
+                    prevPtsUsec = ptsUsec;
+                }
+
                 if (muxer == NULL) {
                     fwrite(buffers[bufIndex]->data(), 1, size, rawFp);
                     // Flush the data immediately in case we're streaming.
@@ -609,13 +747,28 @@ static status_t runEncoder(const sp<MediaCodec>& encoder,
                     if ((flags & MediaCodec::BUFFER_FLAG_CODECCONFIG) == 0) {
                         fflush(rawFp);
                     }
+                } else if (muxerWriter != nullptr) {
+                    // Copy the sample out so the buffer goes back to the
+                    // encoder without waiting for the muxer.
+                    ATRACE_NAME("queue sample");
+                    assert(trackIdx != -1);
+                    err = muxerWriter->queueSample(trackIdx, buffers[bufIndex]->data(),
+                            buffers[bufIndex]->size(), ptsUsec, flags);
+                    if (err != NO_ERROR) {
+                        fprintf(stderr,
+                            "Failed writing data to muxer (err=%d)\n", err);
+                        return err;
+                    }
+                    if (gOutputFormat == FORMAT_MP4) {
+                        timestampsMonotonicUs.add(ptsUsec);
+                    }
                 } else {
                     // The MediaMuxer docs are unclear, but it appears that we
                     // need to pass either the full set of BufferInfo flags, or
                     // (flags & BUFFER_FLAG_SYNCFRAME).
                     //
-                    // If this blocks for too long we could drop frames.  We may
-                    // want to queue these up and do them on a different thread.
+                    // If this blocks for too long we could drop frames.  Use
+                    // --low-latency to do the writes on a different thread.
                     ATRACE_NAME("write sample");
                     assert(trackIdx != -1);
                     // TODO
@@ -677,6 +830,9 @@ static status_t runEncoder(const sp<MediaCodec>& encoder,
                         fprintf(stderr, "Unable to start muxer (err=%d)\n", err);
                         return err;
                     }
+                    if (gLowLatency && muxerWriter == nullptr) {
+                        muxerWriter = std::make_unique<MuxerWriter>(muxer);
+                    }
                 }
             }
             break;
@@ -701,12 +857,26 @@ static status_t runEncoder(const sp<MediaCodec>& encoder,
     }
 
     ALOGV("Encoder stopping (req=%d)", gStopRequested);
+    if (muxerWriter != nullptr) {
+        // Everything has to be written before the metadata tracks.
+        err = muxerWriter->stop();
+        if (err != NO_ERROR) {
+            fprintf(stderr, "Failed writing data to muxer (err=%d)\n", err);
+            return err;
+        }
+    }
     if (gVerbose) {
         printf("Encoder stopping; recorded %u frames in %" PRId64 " seconds\n",
                 debugNumFrames, nanoseconds_to_seconds(
                         systemTime(CLOCK_MONOTONIC) - startWhenNsec));
         fflush(stdout);
     }
+    if (gLowLatency) {
+        // Report on stderr, stdout may be carrying the video.
+        fprintf(stderr, "Recorded %u frames, %u dropped (max %zu samples queued for muxer)\n",
+                debugNumFrames, numDroppedFrames,
+                muxerWriter != nullptr ? muxerWriter->getMaxQueuedSamples() : 0);
+    }
     if (metaLegacyTrackIdx >= 0 && metaTrackIdx >= 0 && !timestampsMonotonicUs.isEmpty()) {
         err = writeWinscopeMetadataLegacy(timestampsMonotonicUs, metaLegacyTrackIdx, muxer);
         if (err != NO_ERROR) {
@@ -970,7 +1140,8 @@ static status_t recordScreen(const char* fileName) {
         }
     } else {
         // Main encoder loop.
-        err = runEncoder(encoder, muxer, rawFp, display, dpy, displayState.orientation);
+        err = runEncoder(encoder, muxer, rawFp, display, dpy, displayState.orientation,
+                displayMode.refreshRate);
         if (err != NO_ERROR) {
             fprintf(stderr, "Encoder failed (err=%d)\n", err);
             // fall through to cleanup
@@ -1136,6 +1307,11 @@ static void usage() {
         "    in videos captured to illustrate bugs.\n"
         "--time-limit TIME\n"
         "    Set the maximum recording time, in seconds.  Default / maximum is %d.\n"
+        "--low-latency\n"
+        "    Reduce the chance of dropped frames at high resolutions.  The display is\n"
+        "    sent straight to the encoder and the output file is written on a\n"
+        "    separate thread.  Not compatible with --bugreport.  The number of\n"
+        "    dropped frames is reported when recording stops.\n"
         "--display-id ID\n"
         "    specify the physical display ID to record. Default is the primary display.\n"
         "    see \"dumpsys SurfaceFlinger --display-id\" for valid display IDs.\n"
@@ -1161,6 +1337,7 @@ int main(int argc, char* const argv[]) {
         { "bit-rate",           required_argument,  NULL, 'b' },
         { "time-limit",         required_argument,  NULL, 't' },
         { "bugreport",          no_argument,        NULL, 'u' },
+        { "low-latency",        no_argument,        NULL, 'L' },
         // "unofficial" options
         { "show-device-info",   no_argument,        NULL, 'i' },
         { "show-frame-time",    no_argument,        NULL, 'f' },
@@ -1234,6 +1411,9 @@ int main(int argc, char* const argv[]) {
             gWantInfoScreen = true;
             gWantFrameTime = true;
             break;
+        case 'L':
+            gLowLatency = true;
+            break;
         case 'i':
             gWantInfoScreen = true;
             break;
@@ -1298,6 +1478,13 @@ int main(int argc, char* const argv[]) {
         return 2;
     }
 
+    if (gLowLatency && gWantFrameTime) {
+        // The overlay renders every frame with GLES, which is what we're trying
+        // to avoid.
+        fprintf(stderr, "--low-latency can't be combined with a frame time overlay\n");
+        return 2;
+    }
+
     const char* fileName = argv[optind];
     if (gOutputFormat == FORMAT_MP4) {
         // MediaMuxer tries to create the file in the constructor, but we don't
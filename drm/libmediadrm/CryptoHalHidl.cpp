@@ -306,14 +306,11 @@ ssize_t CryptoHalHidl::decrypt(const uint8_t keyId[16], const uint8_t iv[16],
     hPattern.encryptBlocks = pattern.mEncryptBlocks;
     hPattern.skipBlocks = pattern.mSkipBlocks;
 
-    std::vector<SubSample> stdSubSamples;
+    hidl_vec<SubSample> hSubSamples(numSubSamples);
     for (size_t i = 0; i < numSubSamples; i++) {
-        SubSample subSample;
-        subSample.numBytesOfClearData = subSamples[i].mNumBytesOfClearData;
-        subSample.numBytesOfEncryptedData = subSamples[i].mNumBytesOfEncryptedData;
-        stdSubSamples.push_back(subSample);
+        hSubSamples[i].numBytesOfClearData = subSamples[i].mNumBytesOfClearData;
+        hSubSamples[i].numBytesOfEncryptedData = subSamples[i].mNumBytesOfEncryptedData;
     }
-    auto hSubSamples = hidl_vec<SubSample>(stdSubSamples);
 
     bool secure;
     if (hDestination.type == BufferType::SHARED_MEMORY) {
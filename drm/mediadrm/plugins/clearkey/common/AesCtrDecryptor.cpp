@@ -37,31 +37,49 @@ CdmResponseType AesCtrDecryptor::decrypt(const std::vector<uint8_t>& key, const
         return clearkeydrm::ERROR_DECRYPT;
     }
 
+    if (key != mKey) {
+        AES_set_encrypt_key(key.data(), kBlockBitCount, &mKeySchedule);
+        mKey = key;
+    }
+
     uint32_t blockOffset = 0;
     uint8_t previousEncryptedCounter[kBlockSize];
     memset(previousEncryptedCounter, 0, kBlockSize);
-
-    size_t offset = 0;
-    AES_KEY opensslKey;
-    AES_set_encrypt_key(key.data(), kBlockBitCount, &opensslKey);
     Iv opensslIv;
     memcpy(opensslIv, iv, sizeof(opensslIv));
 
+    // The counter runs on across subsamples, so encrypted data of consecutive
+    // subsamples with no clear data in between is decrypted in a single call.
+    size_t offset = 0;
+    size_t encryptedOffset = 0;
+    size_t encryptedSize = 0;
+    auto decryptPending = [&]() {
+        if (encryptedSize > 0) {
+            AES_ctr128_encrypt(source + encryptedOffset, destination + encryptedOffset,
+                               encryptedSize, &mKeySchedule, opensslIv,
+                               previousEncryptedCounter, &blockOffset);
+            encryptedSize = 0;
+        }
+    };
+
     for (size_t i = 0; i < clearDataLengths.size(); ++i) {
         int32_t numBytesOfClearData = clearDataLengths[i];
         if (numBytesOfClearData > 0) {
+            decryptPending();
             memcpy(destination + offset, source + offset, numBytesOfClearData);
             offset += numBytesOfClearData;
         }
 
         int32_t numBytesOfEncryptedData = encryptedDataLengths[i];
         if (numBytesOfEncryptedData > 0) {
-            AES_ctr128_encrypt(source + offset, destination + offset,
-                               numBytesOfEncryptedData, &opensslKey, opensslIv,
-                               previousEncryptedCounter, &blockOffset);
+            if (encryptedSize == 0) {
+                encryptedOffset = offset;
+            }
+            encryptedSize += numBytesOfEncryptedData;
             offset += numBytesOfEncryptedData;
         }
     }
+    decryptPending();
 
     *bytesDecryptedOut = offset;
     return clearkeydrm::OK;
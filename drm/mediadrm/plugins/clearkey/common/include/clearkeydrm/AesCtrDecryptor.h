@@ -15,7 +15,10 @@
  */
 #pragma once
 
+#include <openssl/aes.h>
+
 #include <cstdint>
+#include <vector>
 
 #include "ClearKeyTypes.h"
 
@@ -33,6 +36,10 @@ class AesCtrDecryptor {
 
   private:
     CLEARKEY_DISALLOW_COPY_AND_ASSIGN(AesCtrDecryptor);
+
+    // The key schedule is only expanded again when the key changes.
+    std::vector<uint8_t> mKey;
+    AES_KEY mKeySchedule;
 };
 
 }  // namespace clearkeydrm
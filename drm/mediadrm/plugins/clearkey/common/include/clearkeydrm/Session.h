@@ -21,6 +21,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "AesCtrDecryptor.h"
 #include "ClearKeyTypes.h"
 
 namespace clearkeydrm {
@@ -54,6 +55,8 @@ class Session : public ::android::RefBase {
     const std::vector<uint8_t> mSessionId;
     KeyMap mKeyMap;
     ::android::Mutex mMapLock;
+    // Reused across samples to keep the key schedule, guarded by mMapLock.
+    AesCtrDecryptor mDecryptor;
 
     // For mocking error return scenarios
     CdmResponseType mMockError;
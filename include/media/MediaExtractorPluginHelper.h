@@ -20,7 +20,11 @@
 
 #include <arpa/inet.h>
 #include <stdio.h>
+#include <string.h>
+#include <algorithm>
 #include <map>
+#include <memory>
+#include <mutex>
 
 #include <utils/Errors.h>
 #include <utils/Log.h>
@@ -425,6 +429,105 @@ protected:
     CDataSource *mSource;
 };
 
+// A DataSourceHelper that serves small reads from a read-ahead buffer, so that
+// parsers issuing many tiny reads cross into the data source only once per
+// buffer fill. Fills are aligned to kBlockSize. The read-ahead starts at
+// kMinReadAheadSize and doubles while the reads stay sequential, up to
+// kMaxReadAheadSize; a read outside the buffered range resets it. Reads of at
+// least kMaxReadAheadSize bytes go straight to the data source.
+class BufferedDataSourceHelper : public DataSourceHelper {
+public:
+    static constexpr size_t kBlockSize = 4096;
+    static constexpr size_t kMinReadAheadSize = 16 * 1024;
+    static constexpr size_t kMaxReadAheadSize = 128 * 1024;
+
+    explicit BufferedDataSourceHelper(CDataSource *csource)
+        : DataSourceHelper(csource),
+          mReadAheadSize(kMinReadAheadSize),
+          mBufferOffset(0),
+          mBufferLength(0),
+          mNextOffset(-1),
+          mNumReads(0),
+          mNumSourceReads(0) {
+    }
+
+    virtual ~BufferedDataSourceHelper() {
+        ALOGV("served %llu reads with %llu source reads",
+                (unsigned long long)mNumReads, (unsigned long long)mNumSourceReads);
+    }
+
+    virtual ssize_t readAt(off64_t offset, void *data, size_t size) {
+        std::lock_guard<std::mutex> guard(mLock);
+        ++mNumReads;
+
+        if (offset < 0) {
+            return ERROR_MALFORMED;
+        }
+
+        if (offset >= mBufferOffset && size <= mBufferLength
+                && offset - mBufferOffset <= (off64_t)(mBufferLength - size)) {
+            memcpy(data, mBuffer.get() + (offset - mBufferOffset), size);
+            mNextOffset = offset + size;
+            return size;
+        }
+
+        if (size >= kMaxReadAheadSize) {
+            ++mNumSourceReads;
+            mNextOffset = offset + size;
+            return DataSourceHelper::readAt(offset, data, size);
+        }
+
+        if (offset == mNextOffset) {
+            mReadAheadSize = std::min(mReadAheadSize * 2, kMaxReadAheadSize);
+        } else {
+            mReadAheadSize = kMinReadAheadSize;
+        }
+
+        if (mBuffer == nullptr) {
+            mBuffer.reset(new (std::nothrow) uint8_t[kMaxReadAheadSize + kBlockSize]);
+            if (mBuffer == nullptr) {
+                ++mNumSourceReads;
+                return DataSourceHelper::readAt(offset, data, size);
+            }
+        }
+
+        const off64_t start = offset & ~(off64_t)(kBlockSize - 1);
+        const size_t head = offset - start;
+        size_t length = std::max(mReadAheadSize, head + size);
+        length = (length + kBlockSize - 1) & ~(kBlockSize - 1);
+
+        ++mNumSourceReads;
+        ssize_t n = DataSourceHelper::readAt(start, mBuffer.get(), length);
+        if (n < 0) {
+            mBufferLength = 0;
+            return n;
+        }
+        mBufferOffset = start;
+        mBufferLength = n;
+
+        if ((size_t)n <= head) {
+            return 0;
+        }
+        size_t copied = std::min(size, (size_t)n - head);
+        memcpy(data, mBuffer.get() + head, copied);
+        mNextOffset = offset + copied;
+        return copied;
+    }
+
+private:
+    std::mutex mLock;
+    std::unique_ptr<uint8_t[]> mBuffer;
+    size_t mReadAheadSize;
+    off64_t mBufferOffset;
+    size_t mBufferLength;
+    off64_t mNextOffset;
+    uint64_t mNumReads;
+    uint64_t mNumSourceReads;
+
+    BufferedDataSourceHelper(const BufferedDataSourceHelper &);
+    BufferedDataSourceHelper &operator=(const BufferedDataSourceHelper &);
+};
+
 
 
 // helpers to create a media_uuid_t from a string literal
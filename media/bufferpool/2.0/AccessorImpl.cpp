@@ -278,7 +278,12 @@ void Accessor::Impl::handleInvalidateAck() {
     std::map<ConnectionId, const sp<IObserver>> observers;
     uint32_t invalidationId;
     {
-        std::lock_guard<std::mutex> lock(mBufferPool.mMutex);
+        // This is polled by the invalidator thread. Rather than waiting behind
+        // allocations and transfers, retry on the next poll.
+        std::unique_lock<std::mutex> lock(mBufferPool.mMutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return;
+        }
         mBufferPool.processStatusMessages();
         mBufferPool.mInvalidation.onHandleAck(&observers, &invalidationId);
     }
@@ -570,10 +575,9 @@ bool Accessor::Impl::BufferPool::handleTransferResult(const BufferStatusMessage
 }
 
 void Accessor::Impl::BufferPool::processStatusMessages() {
-    std::vector<BufferStatusMessage> messages;
-    mObserver.getBufferStatusChanges(messages);
+    mObserver.getBufferStatusChanges(mStatusMessages);
     mTimestampUs = getTimestampNow();
-    for (BufferStatusMessage& message: messages) {
+    for (BufferStatusMessage& message: mStatusMessages) {
         bool ret = false;
         switch (message.newStatus) {
             case BufferStatus::NOT_USED:
@@ -612,7 +616,7 @@ void Accessor::Impl::BufferPool::processStatusMessages() {
                   message.newStatus, (long long)message.connectionId);
         }
     }
-    messages.clear();
+    mStatusMessages.clear();
 }
 
 bool Accessor::Impl::BufferPool::handleClose(ConnectionId connectionId) {
@@ -100,6 +100,8 @@ private:
         bool mValid;
         BufferStatusObserver mObserver;
         BufferInvalidationChannel mInvalidationChannel;
+        // Buffer status messages being processed. Kept to reuse the allocation.
+        std::vector<BufferStatusMessage> mStatusMessages;
 
         std::map<ConnectionId, std::set<BufferId>> mUsingBuffers;
         std::map<BufferId, std::set<ConnectionId>> mUsingConnections;
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BufferpoolBenchmark"
+
+#include <benchmark/benchmark.h>
+
+#include <bufferpool/ClientManager.h>
+#include <memory>
+#include <vector>
+#include "allocator.h"
+
+using android::hardware::media::bufferpool::V2_0::ResultStatus;
+using android::hardware::media::bufferpool::V2_0::implementation::ClientManager;
+using android::hardware::media::bufferpool::V2_0::implementation::ConnectionId;
+using android::hardware::media::bufferpool::V2_0::implementation::TransactionId;
+using android::hardware::media::bufferpool::BufferPoolData;
+
+/*
+$ adb shell /data/benchmarktest64/BufferpoolBenchmark/BufferpoolBenchmark
+
+All threads of a benchmark share one buffer pool, so the multi-threaded runs measure the
+throughput of the accessor while clients contend on it.
+*/
+
+namespace {
+
+// A buffer pool with a connection which is also registered as its own receiver.
+struct SharedPool {
+    SharedPool() : valid(false) {
+        manager = ClientManager::getInstance();
+        if (!manager) {
+            return;
+        }
+        allocator = std::make_shared<TestBufferPoolAllocator>();
+        if (manager->create(allocator, &connectionId) != ResultStatus::OK) {
+            return;
+        }
+        ResultStatus status = manager->registerSender(manager, connectionId, &receiverId);
+        valid = status == ResultStatus::ALREADY_EXISTS && receiverId == connectionId;
+        getTestAllocatorParams(&params);
+    }
+
+    android::sp<ClientManager> manager;
+    std::shared_ptr<BufferPoolAllocator> allocator;
+    ConnectionId connectionId;
+    ConnectionId receiverId;
+    std::vector<uint8_t> params;
+    bool valid;
+};
+
+SharedPool &getSharedPool() {
+    static SharedPool pool;
+    return pool;
+}
+
+void closeHandle(native_handle_t *handle) {
+    if (handle) {
+        native_handle_close(handle);
+        native_handle_delete(handle);
+    }
+}
+
+// Allocates a buffer and releases it right away, so that it is recycled.
+void BM_AllocateRecycle(benchmark::State &state) {
+    SharedPool &pool = getSharedPool();
+    if (!pool.valid) {
+        state.SkipWithError("cannot create a buffer pool");
+        return;
+    }
+    for (auto _ : state) {
+        std::shared_ptr<BufferPoolData> buffer;
+        native_handle_t *allocHandle = nullptr;
+        if (pool.manager->allocate(pool.connectionId, pool.params, &allocHandle, &buffer)
+                != ResultStatus::OK) {
+            state.SkipWithError("allocation failed");
+            break;
+        }
+        closeHandle(allocHandle);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Allocates a buffer, transfers it to the receiver and releases both references.
+void BM_Transfer(benchmark::State &state) {
+    SharedPool &pool = getSharedPool();
+    if (!pool.valid) {
+        state.SkipWithError("cannot create a buffer pool");
+        return;
+    }
+    for (auto _ : state) {
+        std::shared_ptr<BufferPoolData> sbuffer, rbuffer;
+        native_handle_t *allocHandle = nullptr;
+        native_handle_t *recvHandle = nullptr;
+        TransactionId transactionId;
+        int64_t postUs;
+        if (pool.manager->allocate(pool.connectionId, pool.params, &allocHandle, &sbuffer)
+                != ResultStatus::OK) {
+            state.SkipWithError("allocation failed");
+            break;
+        }
+        if (pool.manager->postSend(pool.receiverId, sbuffer, &transactionId, &postUs)
+                != ResultStatus::OK
+                || pool.manager->receive(pool.receiverId, transactionId, sbuffer->mId, postUs,
+                                         &recvHandle, &rbuffer) != ResultStatus::OK) {
+            closeHandle(allocHandle);
+            state.SkipWithError("transfer failed");
+            break;
+        }
+        closeHandle(allocHandle);
+        closeHandle(recvHandle);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // anonymous namespace
+
+BENCHMARK(BM_AllocateRecycle)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_Transfer)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -116,6 +116,11 @@ public:
                 .withConstValue(new C2StreamMaxBufferSizeInfo::input(0u, 8192))
                 .build());
 
+        addParameter(
+                DefineParam(mMaxAccessUnitCount, C2_PARAMKEY_INPUT_MAX_ACCESS_UNIT_COUNT)
+                .withConstValue(new C2PortMaxAccessUnitCountInfo::input(kMaxAccessUnitsPerBuffer))
+                .build());
+
         addParameter(
                 DefineParam(mAacFormat, C2_PARAMKEY_AAC_PACKAGING)
                 .withDefault(new C2StreamAacFormatInfo::input(0u, C2Config::AAC_PACKAGING_RAW))
@@ -250,6 +255,7 @@ private:
     std::shared_ptr<C2StreamChannelCountInfo::output> mChannelCount;
     std::shared_ptr<C2StreamBitrateInfo::input> mBitrate;
     std::shared_ptr<C2StreamMaxBufferSizeInfo::input> mInputMaxBufSize;
+    std::shared_ptr<C2PortMaxAccessUnitCountInfo::input> mMaxAccessUnitCount;
     std::shared_ptr<C2StreamAacFormatInfo::input> mAacFormat;
     std::shared_ptr<C2StreamProfileLevelInfo::input> mProfileLevel;
     std::shared_ptr<C2StreamDrcCompressionModeTuning::input> mDrcCompressMode;
@@ -331,7 +337,9 @@ status_t C2SoftAacDec::initDecoder() {
     }
 
     mOutputDelayCompensated = 0;
-    mOutputDelayRingBufferSize = 2048 * MAX_CHANNEL_COUNT * kNumDelayBlocksMax;
+    // Leave room for the output of all access units of an input buffer on top of the delay.
+    mOutputDelayRingBufferSize =
+            2048 * MAX_CHANNEL_COUNT * (kNumDelayBlocksMax + kMaxAccessUnitsPerBuffer);
     mOutputDelayRingBuffer.reset(new short[mOutputDelayRingBufferSize]);
     mOutputDelayRingBufferWritePos = 0;
     mOutputDelayRingBufferReadPos = 0;
@@ -616,6 +624,15 @@ void C2SoftAacDec::process(
         return;
     }
 
+    std::vector<size_t> accessUnitSizes;
+    if (!GetAccessUnitSizes(work, size, kMaxAccessUnitsPerBuffer, &accessUnitSizes)) {
+        mSignalledError = true;
+        work->result = C2_BAD_VALUE;
+        return;
+    }
+    size_t accessUnitIndex = 0;
+    size_t accessUnitEnd = 0;
+
     Info inInfo;
     inInfo.frameIndex = work->input.ordinal.frameIndex.peeku();
     inInfo.timestamp = work->input.ordinal.timestamp.peeku();
@@ -672,9 +689,13 @@ void C2SoftAacDec::process(
                 return;
             }
         } else {
+            // Raw access units are not self-delimiting, so fill them one at a time.
+            if (offset >= accessUnitEnd && accessUnitIndex < accessUnitSizes.size()) {
+                accessUnitEnd += accessUnitSizes[accessUnitIndex++];
+            }
             // const_cast because of libAACdec method signature.
             inBuffer[0] = const_cast<UCHAR *>(view.data() + offset);
-            inBufferLength[0] = size;
+            inBufferLength[0] = accessUnitEnd - offset;
         }
 
         // Fill and decode
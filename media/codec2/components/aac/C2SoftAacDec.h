@@ -47,6 +47,7 @@ struct C2SoftAacDec : public SimpleC2Component {
 private:
     enum {
         kNumDelayBlocksMax      = 8,
+        kMaxAccessUnitsPerBuffer = 8,
     };
 
     std::shared_ptr<IntfImpl> mIntf;
@@ -105,6 +105,11 @@ public:
                 DefineParam(mInputMaxBufSize, C2_PARAMKEY_INPUT_MAX_BUFFER_SIZE)
                 .withConstValue(new C2StreamMaxBufferSizeInfo::input(0u, 8192))
                 .build());
+
+        addParameter(
+                DefineParam(mMaxAccessUnitCount, C2_PARAMKEY_INPUT_MAX_ACCESS_UNIT_COUNT)
+                .withConstValue(new C2PortMaxAccessUnitCountInfo::input(kMaxAccessUnitsPerBuffer))
+                .build());
     }
 
 private:
@@ -112,6 +117,7 @@ private:
     std::shared_ptr<C2StreamChannelCountInfo::output> mChannelCount;
     std::shared_ptr<C2StreamBitrateInfo::input> mBitrate;
     std::shared_ptr<C2StreamMaxBufferSizeInfo::input> mInputMaxBufSize;
+    std::shared_ptr<C2PortMaxAccessUnitCountInfo::input> mMaxAccessUnitCount;
 };
 
 C2SoftAmrDec::C2SoftAmrDec(
@@ -277,6 +283,14 @@ void C2SoftAmrDec::process(
     ALOGV("in buffer attr. size %zu timestamp %d frameindex %d", inSize,
           (int)work->input.ordinal.timestamp.peeku(), (int)work->input.ordinal.frameIndex.peeku());
 
+    // AMR frames are self-delimiting; access unit sizes from the client are only checked.
+    std::vector<size_t> accessUnitSizes;
+    if (!GetAccessUnitSizes(work, inSize, kMaxAccessUnitsPerBuffer, &accessUnitSizes)) {
+        work->result = C2_BAD_VALUE;
+        mSignalledError = true;
+        return;
+    }
+
     std::vector<size_t> frameSizeList;
     if (OK != calculateNumFrames(rView.data() + inOffset, inSize, &frameSizeList,
                                  mIsWide)) {
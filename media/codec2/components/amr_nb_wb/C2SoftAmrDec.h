@@ -47,6 +47,7 @@ private:
     enum {
         kNumSamplesPerFrameNB   = 160,
         kNumSamplesPerFrameWB   = 320,
+        kMaxAccessUnitsPerBuffer = 64,
     };
 
     std::shared_ptr<IntfImpl> mIntf;
@@ -27,6 +27,8 @@
 
 #include "C2SoftAomDec.h"
 
+#include <algorithm>
+
 namespace android {
 
 constexpr size_t kMinInputBufferSize = 2 * 1024 * 1024;
@@ -226,6 +228,10 @@ class C2SoftAomDec::IntfImpl : public SimpleInterface<void>::BaseParams {
         return mDefaultColorAspects;
     }
 
+    std::shared_ptr<C2StreamPictureSizeInfo::output> getSize_l() {
+        return mSize;
+    }
+
     static C2R Hdr10PlusInfoInputSetter(bool mayBlock, C2P<C2StreamHdr10PlusInfo::input> &me) {
         (void)mayBlock;
         (void)me;  // TODO: validate
@@ -322,6 +328,21 @@ static int GetCPUCoreCount() {
     return cpuCoreCount;
 }
 
+// Small frames have few tiles to spread over threads, so more threads than this only add
+// synchronization overhead.
+static int GetThreadCount(uint32_t width, uint32_t height) {
+    const uint32_t pixels = width * height;
+    int maxThreads;
+    if (pixels <= 640 * 480) {
+        maxThreads = 2;
+    } else if (pixels <= 1280 * 720) {
+        maxThreads = 4;
+    } else {
+        maxThreads = 8;
+    }
+    return std::min(GetCPUCoreCount(), maxThreads);
+}
+
 status_t C2SoftAomDec::initDecoder() {
     mSignalledError = false;
     mSignalledOutputEos = false;
@@ -336,7 +357,10 @@ status_t C2SoftAomDec::initDecoder() {
 
     aom_codec_dec_cfg_t cfg;
     memset(&cfg, 0, sizeof(aom_codec_dec_cfg_t));
-    cfg.threads = GetCPUCoreCount();
+    {
+        IntfImpl::Lock lock = mIntf->lock();
+        cfg.threads = GetThreadCount(mIntf->getSize_l()->width, mIntf->getSize_l()->height);
+    }
     cfg.allow_lowbitdepth = 1;
 
     aom_codec_flags_t flags;
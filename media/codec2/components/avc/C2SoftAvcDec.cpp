@@ -64,6 +64,13 @@ public:
                 .withSetter(Setter<decltype(*mActualOutputDelay)>::StrictValueWithNoDeps)
                 .build());
 
+        addParameter(
+                DefineParam(mThreadCount, C2_PARAMKEY_COMPONENT_THREAD_COUNT)
+                .withDefault(new C2ComponentThreadCountInfo(1u))
+                .withFields({C2F(mThreadCount, value).any()})
+                .withSetter(Setter<decltype(*mThreadCount)>::NonStrictValueWithNoDeps)
+                .build());
+
         // TODO: output latency and reordering
 
         addParameter(
@@ -306,6 +313,7 @@ private:
     std::shared_ptr<C2StreamColorAspectsTuning::output> mDefaultColorAspects;
     std::shared_ptr<C2StreamColorAspectsInfo::output> mColorAspects;
     std::shared_ptr<C2StreamPixelFormatInfo::output> mPixelFormat;
+    std::shared_ptr<C2ComponentThreadCountInfo> mThreadCount;
 };
 
 static size_t getCpuCoreCount() {
@@ -321,6 +329,13 @@ static size_t getCpuCoreCount() {
     return (size_t)cpuCoreCount;
 }
 
+static size_t getNumCoresForSize(uint32_t width, uint32_t height) {
+    (void) width;
+    (void) height;
+    // libavc does not use more threads for larger pictures.
+    return MIN(getCpuCoreCount(), MAX_NUM_CORES);
+}
+
 static void *ivd_aligned_malloc(void *ctxt, WORD32 alignment, WORD32 size) {
     (void) ctxt;
     return memalign(alignment, size);
@@ -510,11 +525,16 @@ void C2SoftAvcDec::getVersion() {
 
 status_t C2SoftAvcDec::initDecoder() {
     if (OK != createDecoder()) return UNKNOWN_ERROR;
-    mNumCores = MIN(getCpuCoreCount(), MAX_NUM_CORES);
+    mNumCores = getNumCoresForSize(mWidth, mHeight);
     mStride = ALIGN128(mWidth);
     mSignalledError = false;
     resetPlugin();
     (void) setNumCores();
+    {
+        C2ComponentThreadCountInfo threadCount(mNumCores);
+        std::vector<std::unique_ptr<C2SettingResult>> failures;
+        (void) mIntf->config({&threadCount}, C2_MAY_BLOCK, &failures);
+    }
     if (OK != setParams(mStride, IVD_DECODE_FRAME)) return UNKNOWN_ERROR;
     (void) getVersion();
 
@@ -935,11 +955,19 @@ void C2SoftAvcDec::process(
                 CHECK_EQ(0u, ps_decode_op->u4_output_present);
 
                 C2StreamPictureSizeInfo::output size(0u, mWidth, mHeight);
+                size_t numCores = getNumCoresForSize(mWidth, mHeight);
+                if (numCores != mNumCores) {
+                    mNumCores = numCores;
+                    (void) setNumCores();
+                }
+                C2ComponentThreadCountInfo threadCount(mNumCores);
                 std::vector<std::unique_ptr<C2SettingResult>> failures;
-                c2_status_t err = mIntf->config({&size}, C2_MAY_BLOCK, &failures);
+                c2_status_t err = mIntf->config({&size, &threadCount}, C2_MAY_BLOCK, &failures);
                 if (err == OK) {
                     work->worklets.front()->output.configUpdate.push_back(
                         C2Param::Copy(size));
+                    work->worklets.front()->output.configUpdate.push_back(
+                        C2Param::Copy(threadCount));
                 } else {
                     ALOGE("Cannot set width and height");
                     mSignalledError = true;
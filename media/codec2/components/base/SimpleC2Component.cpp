@@ -24,6 +24,14 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <utils/AndroidThreads.h>
+
 #include <C2Config.h>
 #include <C2Debug.h>
 #include <C2PlatformSupport.h>
@@ -35,16 +43,30 @@ namespace android {
 constexpr uint8_t kNeutralUVBitDepth8 = 128;
 constexpr uint16_t kNeutralUVBitDepth10 = 512;
 
+// Copies |rows| rows of |width| bytes. The rows are copied in one go when the strides match,
+// which is the case when the decoder output is laid out like the graphic block.
+static void copyPlane8(uint8_t *dst, size_t dstStride, const uint8_t *src, size_t srcStride,
+                       size_t width, size_t rows) {
+    if (rows == 0) {
+        return;
+    }
+    if (dstStride == srcStride) {
+        memcpy(dst, src, srcStride * (rows - 1) + width);
+        return;
+    }
+    for (size_t i = 0; i < rows; ++i) {
+        memcpy(dst, src, width);
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
 void convertYUV420Planar8ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, const uint8_t *srcY,
                                 const uint8_t *srcU, const uint8_t *srcV, size_t srcYStride,
                                 size_t srcUStride, size_t srcVStride, size_t dstYStride,
                                 size_t dstUVStride, uint32_t width, uint32_t height,
                                 bool isMonochrome) {
-    for (size_t i = 0; i < height; ++i) {
-        memcpy(dstY, srcY, width);
-        srcY += srcYStride;
-        dstY += dstYStride;
-    }
+    copyPlane8(dstY, dstYStride, srcY, srcYStride, width, height);
 
     if (isMonochrome) {
         // Fill with neutral U/V values.
@@ -57,17 +79,8 @@ void convertYUV420Planar8ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, con
         return;
     }
 
-    for (size_t i = 0; i < (height + 1) / 2; ++i) {
-        memcpy(dstV, srcV, (width + 1) / 2);
-        srcV += srcVStride;
-        dstV += dstUVStride;
-    }
-
-    for (size_t i = 0; i < (height + 1) / 2; ++i) {
-        memcpy(dstU, srcU, (width + 1) / 2);
-        srcU += srcUStride;
-        dstU += dstUVStride;
-    }
+    copyPlane8(dstV, dstUVStride, srcV, srcVStride, (width + 1) / 2, (height + 1) / 2);
+    copyPlane8(dstU, dstUVStride, srcU, srcUStride, (width + 1) / 2, (height + 1) / 2);
 }
 
 void convertYUV420Planar16ToY410(uint32_t *dst, const uint16_t *srcY, const uint16_t *srcU,
@@ -493,12 +506,14 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
             break;
         }
         case kWhatStop: {
+            thiz->waitForPipelineIdle();
             int32_t err = thiz->onStop();
             thiz->mOutputBlockPool.reset();
             Reply(msg, &err);
             break;
         }
         case kWhatReset: {
+            thiz->waitForPipelineIdle();
             thiz->onReset();
             thiz->mOutputBlockPool.reset();
             mRunning = false;
@@ -506,6 +521,7 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
             break;
         }
         case kWhatRelease: {
+            thiz->mPipeline.reset();
             thiz->onRelease();
             thiz->mOutputBlockPool.reset();
             mRunning = false;
@@ -569,6 +585,106 @@ private:
     std::shared_ptr<C2BlockPool> mBase;
 };
 
+/**
+ * Runs process() for up to |depth| works at the same time on worker threads and
+ * completes the works in the order they were dispatched.
+ */
+class SimpleC2Component::Pipeline {
+public:
+    Pipeline(SimpleC2Component *thiz, uint32_t depth) : mThiz(thiz), mDepth(depth) {
+        for (uint32_t i = 0; i < depth; ++i) {
+            mThreads.emplace_back(&Pipeline::threadLoop, this);
+        }
+    }
+
+    ~Pipeline() {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mExit = true;
+        }
+        mCondition.notify_all();
+        for (std::thread &thread : mThreads) {
+            thread.join();
+        }
+    }
+
+    /**
+     * Hand |work| to a worker thread. Blocks while |depth| works are in flight.
+     */
+    void dispatch(std::unique_ptr<C2Work> work, uint64_t generation) {
+        std::unique_lock<std::mutex> lock(mLock);
+        mCondition.wait(lock, [this] { return mInFlight.size() < mDepth; });
+        mInFlight.push_back({ std::move(work), generation, QUEUED });
+        mCondition.notify_all();
+    }
+
+    /**
+     * Block until all dispatched works have been completed.
+     */
+    void waitForIdle() {
+        std::unique_lock<std::mutex> lock(mLock);
+        mCondition.wait(lock, [this] { return mInFlight.empty() && !mCompleting; });
+    }
+
+private:
+    enum State {
+        QUEUED,
+        PROCESSING,
+        PROCESSED,
+    };
+
+    struct Entry {
+        std::unique_ptr<C2Work> work;
+        uint64_t generation;
+        State state;
+    };
+
+    void threadLoop() {
+        androidSetThreadPriority(0, ANDROID_PRIORITY_VIDEO);
+        std::unique_lock<std::mutex> lock(mLock);
+        while (true) {
+            auto it = std::find_if(mInFlight.begin(), mInFlight.end(),
+                                   [](const Entry &entry) { return entry.state == QUEUED; });
+            if (it == mInFlight.end()) {
+                if (mExit) {
+                    return;
+                }
+                mCondition.wait(lock);
+                continue;
+            }
+            it->state = PROCESSING;
+            lock.unlock();
+            ALOGV("start processing frame #%" PRIu64, it->work->input.ordinal.frameIndex.peeku());
+            mThiz->process(it->work, mThiz->mOutputBlockPool);
+            ALOGV("processed frame #%" PRIu64, it->work->input.ordinal.frameIndex.peeku());
+            lock.lock();
+            it->state = PROCESSED;
+            // Only one thread completes works at a time so that they are returned in order.
+            while (!mCompleting && !mInFlight.empty() && mInFlight.front().state == PROCESSED) {
+                Entry entry = std::move(mInFlight.front());
+                mInFlight.pop_front();
+                mCompleting = true;
+                lock.unlock();
+                mThiz->completeWork(std::move(entry.work), entry.generation);
+                lock.lock();
+                mCompleting = false;
+            }
+            mCondition.notify_all();
+        }
+    }
+
+    SimpleC2Component *const mThiz;
+    const uint32_t mDepth;
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    // works in the order they were dispatched
+    std::list<Entry> mInFlight;
+    bool mCompleting = false;
+    bool mExit = false;
+    std::vector<std::thread> mThreads;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace {
@@ -584,7 +700,8 @@ SimpleC2Component::SimpleC2Component(
     : mDummyReadView(DummyReadView()),
       mIntf(intf),
       mLooper(new ALooper),
-      mHandler(new WorkHandler) {
+      mHandler(new WorkHandler),
+      mPipelineDepth(1u) {
     mLooper->setName(intf->getName().c_str());
     (void)mLooper->registerHandler(mHandler);
     mLooper->start(false, false, ANDROID_PRIORITY_VIDEO);
@@ -593,6 +710,17 @@ SimpleC2Component::SimpleC2Component(
 SimpleC2Component::~SimpleC2Component() {
     mLooper->unregisterHandler(mHandler->id());
     (void)mLooper->stop();
+    mPipeline.reset();
+}
+
+void SimpleC2Component::setPipelineDepth(uint32_t depth) {
+    mPipelineDepth = std::max(depth, 1u);
+}
+
+void SimpleC2Component::waitForPipelineIdle() {
+    if (mPipeline) {
+        mPipeline->waitForIdle();
+    }
 }
 
 c2_status_t SimpleC2Component::setListener_vb(
@@ -839,6 +967,13 @@ bool SimpleC2Component::processQueue() {
         work = queue->pop_front();
         hasQueuedWork = !queue->empty();
     }
+    if (mPipelineDepth > 1 && !mPipeline) {
+        mPipeline = std::make_unique<Pipeline>(this, mPipelineDepth);
+    }
+    if (isFlushPending || !work || !work->input.configUpdate.empty()) {
+        // Flush, drain and configuration updates apply after all earlier works.
+        waitForPipelineIdle();
+    }
     if (isFlushPending) {
         ALOGV("processing pending flush");
         c2_status_t err = onFlush_sm();
@@ -920,7 +1055,6 @@ bool SimpleC2Component::processQueue() {
         }
     }
 
-    ALOGV("start processing frame #%" PRIu64, work->input.ordinal.frameIndex.peeku());
     // If input buffer list is not empty, it means we have some input to process on.
     // However, input could be a null buffer. In such case, clear the buffer list
     // before making call to process().
@@ -928,8 +1062,18 @@ bool SimpleC2Component::processQueue() {
         ALOGD("Encountered null input buffer. Clearing the input buffer");
         work->input.buffers.clear();
     }
+    if (mPipeline) {
+        mPipeline->dispatch(std::move(work), generation);
+        return hasQueuedWork;
+    }
+    ALOGV("start processing frame #%" PRIu64, work->input.ordinal.frameIndex.peeku());
     process(work, mOutputBlockPool);
     ALOGV("processed frame #%" PRIu64, work->input.ordinal.frameIndex.peeku());
+    completeWork(std::move(work), generation);
+    return hasQueuedWork;
+}
+
+void SimpleC2Component::completeWork(std::unique_ptr<C2Work> work, uint64_t generation) {
     Mutexed<WorkQueue>::Locked queue(mWorkQueue);
     if (queue->generation() != generation) {
         ALOGD("work form old generation: was %" PRIu64 " now %" PRIu64,
@@ -941,7 +1085,7 @@ bool SimpleC2Component::processQueue() {
         std::shared_ptr<C2Component::Listener> listener = state->mListener;
         state.unlock();
         listener->onWorkDone_nb(shared_from_this(), vec(work));
-        return hasQueuedWork;
+        return;
     }
     if (work->workletsProcessed != 0u) {
         queue.unlock();
@@ -972,7 +1116,6 @@ bool SimpleC2Component::processQueue() {
             listener->onWorkDone_nb(shared_from_this(), vec(unexpected));
         }
     }
-    return hasQueuedWork;
 }
 
 int SimpleC2Component::getHalPixelFormatForBitDepth10(bool allowRGBA1010102) {
@@ -1006,6 +1149,42 @@ int SimpleC2Component::getHalPixelFormatForBitDepth10(bool allowRGBA1010102) {
     // Return the first entry from supported formats
     return mBitDepth10HalPixelFormats[0];
 }
+// static
+bool SimpleC2Component::GetAccessUnitSizes(
+        const std::unique_ptr<C2Work> &work, size_t inSize, uint32_t maxCount,
+        std::vector<size_t> *sizes) {
+    sizes->clear();
+    std::shared_ptr<const C2StreamAccessUnitSizesInfo::input> info;
+    if (!work->input.buffers.empty() && work->input.buffers[0]) {
+        info = std::static_pointer_cast<const C2StreamAccessUnitSizesInfo::input>(
+                work->input.buffers[0]->getInfo(C2StreamAccessUnitSizesInfo::input::PARAM_TYPE));
+    }
+    if (!info) {
+        sizes->push_back(inSize);
+        return true;
+    }
+    size_t count = info->flexCount();
+    if (count == 0 || count > maxCount) {
+        ALOGE("%zu access units in one input buffer, supporting up to %u", count, maxCount);
+        return false;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t size = info->m.values[i];
+        if (size == 0 || size > inSize - total) {
+            ALOGE("access unit #%zu of %zu bytes overruns the %zu byte input", i, size, inSize);
+            return false;
+        }
+        total += size;
+        sizes->push_back(size);
+    }
+    if (total != inSize) {
+        ALOGE("access units add up to %zu bytes out of %zu", total, inSize);
+        return false;
+    }
+    return true;
+}
+
 std::shared_ptr<C2Buffer> SimpleC2Component::createLinearBuffer(
         const std::shared_ptr<C2LinearBlock> &block, size_t offset, size_t size) {
     return C2Buffer::CreateLinearBuffer(block->share(offset, size, ::C2Fence()));
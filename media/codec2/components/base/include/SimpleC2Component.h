@@ -18,7 +18,9 @@
 #define SIMPLE_C2_COMPONENT_H_
 
 #include <list>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <C2Component.h>
 
@@ -113,6 +115,10 @@ protected:
     /**
      * Process the given work and finish pending work using finish().
      *
+     * If the component set a pipeline depth greater than one, this method is
+     * called from several threads at once, each with a different work, and must
+     * be safe to run concurrently.
+     *
      * \param[in,out]   work    the work to process
      * \param[in]       pool    the pool to use for allocating output blocks.
      */
@@ -166,6 +172,43 @@ protected:
             std::function<void(const std::unique_ptr<C2Work> &)> fillWork);
 
 
+    /**
+     * Set the number of works that may be processed at the same time.
+     *
+     * With a depth of one (the default) process() is called for one work at a
+     * time on the component's looper thread. With a larger depth up to |depth|
+     * works are handed to process() concurrently on worker threads, and works
+     * that process() completes are still returned to the client in queue
+     * order. Drain, flush and works carrying configuration updates wait for
+     * all works in process() to complete first. A work only becomes pending,
+     * and thus known to finish() and cloneAndSend(), once it and all works
+     * queued before it have returned from process().
+     *
+     * This method must be called before the component is started, typically
+     * from the constructor of the derived class.
+     *
+     * \param[in]   depth   the maximum number of works in process() at once.
+     */
+    void setPipelineDepth(uint32_t depth);
+
+    /**
+     * Get the sizes of the access units in the input buffer of a work.
+     *
+     * The sizes come from the C2StreamAccessUnitSizesInfo attached to the
+     * buffer. Without it the buffer holds one access unit of |inSize| bytes.
+     *
+     * \param[in]   work        the work to inspect
+     * \param[in]   inSize      the size of the input buffer in bytes
+     * \param[in]   maxCount    the maximum number of access units supported
+     * \param[out]  sizes       the access unit sizes, in stream order
+     *
+     * \return false if the sizes do not add up to |inSize|, if one of them is
+     *         zero, or if there are more than |maxCount| of them.
+     */
+    static bool GetAccessUnitSizes(
+            const std::unique_ptr<C2Work> &work, size_t inSize, uint32_t maxCount,
+            std::vector<size_t> *sizes);
+
     std::shared_ptr<C2Buffer> createLinearBuffer(
             const std::shared_ptr<C2LinearBlock> &block, size_t offset, size_t size);
 
@@ -260,6 +303,17 @@ private:
     class BlockingBlockPool;
     std::shared_ptr<BlockingBlockPool> mOutputBlockPool;
 
+    class Pipeline;
+    uint32_t mPipelineDepth;
+    std::unique_ptr<Pipeline> mPipeline;
+
+    /**
+     * Return a work that went through process() to the client, or keep it as
+     * pending work if no worklet was processed.
+     */
+    void completeWork(std::unique_ptr<C2Work> work, uint64_t generation);
+    void waitForPipelineIdle();
+
     std::vector<int> mBitDepth10HalPixelFormats;
     SimpleC2Component() = delete;
 };
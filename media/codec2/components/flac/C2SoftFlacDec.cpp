@@ -18,11 +18,16 @@
 #define LOG_TAG "C2SoftFlacDec"
 #include <log/log.h>
 
+#include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/MediaDefs.h>
 
 #include <C2PlatformSupport.h>
 #include <SimpleC2Interface.h>
 
+#include <algorithm>
+#include <string>
+#include <unistd.h>
+
 #include "C2SoftFlacDec.h"
 
 namespace android {
@@ -91,9 +96,23 @@ public:
                 })
                 .withSetter((Setter<decltype(*mPcmEncodingInfo)>::StrictValueWithNoDeps))
                 .build());
+
+        addParameter(
+                DefineParam(mMaxAccessUnitCount, C2_PARAMKEY_INPUT_MAX_ACCESS_UNIT_COUNT)
+                .withConstValue(new C2PortMaxAccessUnitCountInfo::input(kMaxAccessUnitsPerBuffer))
+                .build());
+
+        addParameter(
+                DefineParam(mPriority, C2_PARAMKEY_PRIORITY)
+                .withDefault(new C2RealTimePriorityTuning(0))
+                .withFields({C2F(mPriority, value).any()})
+                .withSetter(Setter<decltype(*mPriority)>::NonStrictValueWithNoDeps)
+                .build());
     }
 
     int32_t getPcmEncodingInfo() const { return mPcmEncodingInfo->value; }
+    // Negative priorities ask for best effort operation, e.g. offline transcoding.
+    bool isRealTime() const { return mPriority->value >= 0; }
 
 private:
     std::shared_ptr<C2StreamSampleRateInfo::output> mSampleRate;
@@ -101,15 +120,48 @@ private:
     std::shared_ptr<C2StreamBitrateInfo::input> mBitrate;
     std::shared_ptr<C2StreamMaxBufferSizeInfo::input> mInputMaxBufSize;
     std::shared_ptr<C2StreamPcmEncodingInfo::output> mPcmEncodingInfo;
+    std::shared_ptr<C2PortMaxAccessUnitCountInfo::input> mMaxAccessUnitCount;
+    std::shared_ptr<C2RealTimePriorityTuning> mPriority;
 };
 
+C2SoftFlacDec::DecoderThread::DecoderThread(
+        const std::shared_ptr<Mutexed<DecodeQueue>> &queue,
+        std::unique_ptr<FLACDecoder> decoder)
+    : Thread(false), mQueue(queue), mDecoder(std::move(decoder)) {}
+
+bool C2SoftFlacDec::DecoderThread::threadLoop() {
+    Mutexed<DecodeQueue>::Locked queue(*mQueue);
+    if (queue->entries.empty()) {
+        queue.waitForCondition(queue->cond);
+        if (queue->entries.empty()) {
+            return true;
+        }
+    }
+    std::function<void(FLACDecoder *)> decode = queue->entries.front();
+    queue->entries.pop_front();
+    if (!queue->entries.empty()) {
+        queue->cond.signal();
+    }
+    queue.unlock();
+
+    decode(mDecoder.get());
+
+    queue.lock();
+    if (--queue->numPending == 0u) {
+        queue->cond.broadcast();
+    }
+    return true;
+}
+
 C2SoftFlacDec::C2SoftFlacDec(
         const char *name,
         c2_node_id_t id,
         const std::shared_ptr<IntfImpl> &intfImpl)
     : SimpleC2Component(std::make_shared<SimpleInterface<IntfImpl>>(name, id, intfImpl)),
       mIntf(intfImpl),
-      mFLACDecoder(nullptr) {
+      mFLACDecoder(nullptr),
+      mQueue(new Mutexed<DecodeQueue>),
+      mDecoderThreadsConfigured(false) {
 }
 
 C2SoftFlacDec::~C2SoftFlacDec() {
@@ -123,6 +175,8 @@ c2_status_t C2SoftFlacDec::onInit() {
 
 c2_status_t C2SoftFlacDec::onStop() {
     if (mFLACDecoder) mFLACDecoder->flush();
+    mCodecConfig.clear();
+    mDecoderThreadsConfigured = false;
     memset(&mStreamInfo, 0, sizeof(mStreamInfo));
     mHasStreamInfo = false;
     mSignalledError = false;
@@ -137,6 +191,7 @@ void C2SoftFlacDec::onReset() {
 
 void C2SoftFlacDec::onRelease() {
     mInputBufferCount = 0;
+    stopDecoderThreads();
     if (mFLACDecoder) delete mFLACDecoder;
     mFLACDecoder = nullptr;
 }
@@ -161,7 +216,135 @@ status_t C2SoftFlacDec::initDecoder() {
     mSignalledError = false;
     mSignalledOutputEos = false;
     mInputBufferCount = 0;
+    mCodecConfig.clear();
+    mDecoderThreadsConfigured = false;
+
+    return OK;
+}
+
+static int GetCPUCoreCount() {
+    int cpuCoreCount = 1;
+#if defined(_SC_NPROCESSORS_ONLN)
+    cpuCoreCount = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    // _SC_NPROC_ONLN must be defined...
+    cpuCoreCount = sysconf(_SC_NPROC_ONLN);
+#endif
+    CHECK(cpuCoreCount >= 1);
+    ALOGV("Number of CPU cores: %d", cpuCoreCount);
+    return cpuCoreCount;
+}
+
+// Starts the decoder threads if needed and hands them the metadata of the stream. Returns
+// false if the frames have to be decoded on the component thread.
+bool C2SoftFlacDec::configureDecoderThreads() {
+    if (mDecoderThreadsConfigured) {
+        return true;
+    }
+    if (!mHasStreamInfo || mCodecConfig.empty()) {
+        return false;
+    }
+    if (mDecoderThreads.empty()) {
+        using namespace std::string_literals;
+        const int threadCount = std::min(GetCPUCoreCount(), (int)kMaxDecoderThreads);
+        for (int i = 0; threadCount > 1 && i < threadCount; ++i) {
+            std::unique_ptr<FLACDecoder> decoder(FLACDecoder::Create());
+            if (!decoder) {
+                ALOGW("failed to create FLACDecoder for decoder thread #%d", i);
+                break;
+            }
+            sp<DecoderThread> thread(new DecoderThread(mQueue, std::move(decoder)));
+            if (thread->run(("flacdec #"s + std::to_string(i)).c_str(),
+                            ANDROID_PRIORITY_AUDIO) != OK) {
+                ALOGW("failed to start decoder thread #%d", i);
+                break;
+            }
+            mDecoderThreads.push_back(thread);
+        }
+        if (mDecoderThreads.size() < 2) {
+            stopDecoderThreads();
+            return false;
+        }
+    }
+    // The decoder threads are idle between works, so their decoders can be used here.
+    for (const sp<DecoderThread> &thread : mDecoderThreads) {
+        thread->decoder()->flush();
+        if (thread->decoder()->parseMetadata(mCodecConfig.data(), mCodecConfig.size()) != OK) {
+            ALOGW("decoder thread failed to parse the stream metadata");
+            return false;
+        }
+    }
+    mDecoderThreadsConfigured = true;
+    return true;
+}
+
+void C2SoftFlacDec::stopDecoderThreads() {
+    bool running = true;
+    for (const sp<DecoderThread> &thread : mDecoderThreads) {
+        thread->requestExit();
+    }
+    while (running) {
+        mQueue->lock()->cond.broadcast();
+        running = false;
+        for (const sp<DecoderThread> &thread : mDecoderThreads) {
+            if (thread->isRunning()) {
+                running = true;
+                break;
+            }
+        }
+    }
+    mDecoderThreads.clear();
+    mDecoderThreadsConfigured = false;
+}
+
+// Decodes each access unit into its own |frameCapacity| bytes of |output| and stores the
+// decoded sizes in |frameSizes|. FLAC frames do not depend on each other once the metadata
+// is known, so several access units are decoded in parallel when the client asked for best
+// effort operation.
+status_t C2SoftFlacDec::decodeFrames(
+        const uint8_t *input, const std::vector<size_t> &accessUnitSizes,
+        uint8_t *output, size_t frameCapacity, std::vector<size_t> *frameSizes,
+        bool outputFloat) {
+    const size_t count = accessUnitSizes.size();
+    frameSizes->assign(count, frameCapacity);
+    if (count == 1 || mIntf->isRealTime() || !configureDecoderThreads()) {
+        for (size_t i = 0; i < count; ++i) {
+            status_t err = mFLACDecoder->decodeOneFrame(
+                    input, accessUnitSizes[i], output + i * frameCapacity,
+                    &(*frameSizes)[i], outputFloat);
+            if (err != OK) {
+                return err;
+            }
+            input += accessUnitSizes[i];
+        }
+        return OK;
+    }
 
+    std::vector<status_t> results(count, OK);
+    Mutexed<DecodeQueue>::Locked queue(*mQueue);
+    for (size_t i = 0; i < count; ++i) {
+        queue->entries.push_back(
+                [input, size = accessUnitSizes[i], out = output + i * frameCapacity,
+                 outSize = &(*frameSizes)[i], result = &results[i], outputFloat]
+                (FLACDecoder *decoder) {
+                    *result = decoder->decodeOneFrame(input, size, out, outSize, outputFloat);
+                });
+        input += accessUnitSizes[i];
+    }
+    CHECK_EQ(0u, queue->numPending);
+    queue->numPending = queue->entries.size();
+    while (queue->numPending > 0) {
+        queue->cond.signal();
+        queue.waitForCondition(queue->cond);
+    }
+    queue.unlock();
+    for (status_t err : results) {
+        if (err != OK) {
+            // a failed decoder may hold a partial frame, start the next work afresh
+            mDecoderThreadsConfigured = false;
+            return err;
+        }
+    }
     return OK;
 }
 
@@ -172,7 +355,6 @@ static void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
     work->workletsProcessed = 1u;
 }
 
-// (TODO) add multiframe support, in plugin and FLACDecoder.cpp
 void C2SoftFlacDec::process(
         const std::unique_ptr<C2Work> &work,
         const std::shared_ptr<C2BlockPool> &pool) {
@@ -226,6 +408,7 @@ void C2SoftFlacDec::process(
             fillEmptyWork(work);
             return;
         }
+        mCodecConfig.insert(mCodecConfig.end(), input, input + inSize);
         status_t decoderErr = mFLACDecoder->parseMetadata(input, inSize);
         if (decoderErr != OK && decoderErr != WOULD_BLOCK) {
             ALOGE("process: FLACDecoder parseMetaData returns error %d", decoderErr);
@@ -275,15 +458,23 @@ void C2SoftFlacDec::process(
         return;
     }
 
+    std::vector<size_t> accessUnitSizes;
+    if (!GetAccessUnitSizes(work, inSize, kMaxAccessUnitsPerBuffer, &accessUnitSizes)) {
+        mSignalledError = true;
+        work->result = C2_BAD_VALUE;
+        return;
+    }
+
     const bool outputFloat = mIntf->getPcmEncodingInfo() == C2Config::PCM_FLOAT;
     const size_t sampleSize = outputFloat ? sizeof(float) : sizeof(short);
-    size_t outSize = mHasStreamInfo ?
+    const size_t frameCapacity = mHasStreamInfo ?
             mStreamInfo.max_blocksize * mStreamInfo.channels * sampleSize
           : kMaxBlockSize * FLACDecoder::kMaxChannels * sampleSize;
 
     std::shared_ptr<C2LinearBlock> block;
     C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
-    c2_status_t err = pool->fetchLinearBlock(outSize, usage, &block);
+    c2_status_t err = pool->fetchLinearBlock(
+            frameCapacity * accessUnitSizes.size(), usage, &block);
     if (err != C2_OK) {
         ALOGE("fetchLinearBlock for Output failed with status %d", err);
         work->result = C2_NO_MEMORY;
@@ -296,14 +487,23 @@ void C2SoftFlacDec::process(
         return;
     }
 
-    status_t decoderErr = mFLACDecoder->decodeOneFrame(
-                            input, inSize, wView.data(), &outSize, outputFloat);
+    std::vector<size_t> frameSizes;
+    status_t decoderErr = decodeFrames(
+            input, accessUnitSizes, wView.data(), frameCapacity, &frameSizes, outputFloat);
     if (decoderErr != OK) {
         ALOGE("process: FLACDecoder decodeOneFrame returns error %d", decoderErr);
         mSignalledError = true;
         work->result = C2_CORRUPTED;
         return;
     }
+    // Frames shorter than the maximum block size leave gaps between the decoded frames.
+    size_t outSize = 0;
+    for (size_t i = 0; i < frameSizes.size(); ++i) {
+        if (outSize != i * frameCapacity) {
+            memmove(wView.data() + outSize, wView.data() + i * frameCapacity, frameSizes[i]);
+        }
+        outSize += frameSizes[i];
+    }
 
     mInputBufferCount++;
     ALOGV("out buffer attr. size %zu", outSize);
@@ -19,6 +19,8 @@
 
 #include <SimpleC2Component.h>
 
+#include <memory>
+
 #include "FLACDecoder.h"
 
 namespace android {
@@ -45,7 +47,28 @@ struct C2SoftFlacDec : public SimpleC2Component {
 
 private:
     enum {
-        kMaxBlockSize   = 4096
+        kMaxBlockSize   = 4096,
+        kMaxAccessUnitsPerBuffer = 16,
+        kMaxDecoderThreads = 4,
+    };
+
+    struct DecodeQueue;
+
+    // Decodes frames handed over through the queue on a decoder of its own.
+    class DecoderThread : public Thread {
+    public:
+        DecoderThread(
+                const std::shared_ptr<Mutexed<DecodeQueue>> &queue,
+                std::unique_ptr<FLACDecoder> decoder);
+        ~DecoderThread() override = default;
+        bool threadLoop() override;
+
+        // Only to be used while the queue is empty.
+        FLACDecoder *decoder() const { return mDecoder.get(); }
+
+    private:
+        std::shared_ptr<Mutexed<DecodeQueue>> mQueue;
+        std::unique_ptr<FLACDecoder> mDecoder;
     };
 
     std::shared_ptr<IntfImpl> mIntf;
@@ -56,7 +79,24 @@ private:
     bool mHasStreamInfo;
     size_t mInputBufferCount;
 
+    // metadata blocks of the stream, replayed to the decoders of the decoder threads
+    std::vector<uint8_t> mCodecConfig;
+    struct DecodeQueue {
+        std::list<std::function<void(FLACDecoder *)>> entries;
+        Condition cond;
+        size_t numPending{0u};
+    };
+    std::shared_ptr<Mutexed<DecodeQueue>> mQueue;
+    std::vector<sp<DecoderThread>> mDecoderThreads;
+    bool mDecoderThreadsConfigured;
+
     status_t initDecoder();
+    bool configureDecoderThreads();
+    void stopDecoderThreads();
+    status_t decodeFrames(
+            const uint8_t *input, const std::vector<size_t> &accessUnitSizes,
+            uint8_t *output, size_t frameCapacity, std::vector<size_t> *frameSizes,
+            bool outputFloat);
 
     C2_DO_NOT_COPY(C2SoftFlacDec);
 };
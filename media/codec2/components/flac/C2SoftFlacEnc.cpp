@@ -19,11 +19,15 @@
 #include <log/log.h>
 
 #include <audio_utils/primitives.h>
+#include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/MediaDefs.h>
 
 #include <C2PlatformSupport.h>
 #include <SimpleC2Interface.h>
 
+#include <algorithm>
+#include <unistd.h>
+
 #include "C2SoftFlacEnc.h"
 
 namespace android {
@@ -96,6 +100,13 @@ public:
                 })
                 .withSetter((Setter<decltype(*mPcmEncodingInfo)>::StrictValueWithNoDeps))
                 .build());
+
+        addParameter(
+                DefineParam(mPriority, C2_PARAMKEY_PRIORITY)
+                .withDefault(new C2RealTimePriorityTuning(0))
+                .withFields({C2F(mPriority, value).any()})
+                .withSetter(Setter<decltype(*mPriority)>::NonStrictValueWithNoDeps)
+                .build());
     }
 
     uint32_t getSampleRate() const { return mSampleRate->value; }
@@ -103,6 +114,8 @@ public:
     uint32_t getBitrate() const { return mBitrate->value; }
     uint32_t getComplexity() const { return mComplexity->value; }
     int32_t getPcmEncodingInfo() const { return mPcmEncodingInfo->value; }
+    // Negative priorities ask for best effort operation, e.g. offline transcoding.
+    bool isRealTime() const { return mPriority->value >= 0; }
 
 private:
     std::shared_ptr<C2StreamSampleRateInfo::input> mSampleRate;
@@ -111,6 +124,7 @@ private:
     std::shared_ptr<C2StreamComplexityTuning::output> mComplexity;
     std::shared_ptr<C2StreamMaxBufferSizeInfo::input> mInputMaxBufSize;
     std::shared_ptr<C2StreamPcmEncodingInfo::input> mPcmEncodingInfo;
+    std::shared_ptr<C2RealTimePriorityTuning> mPriority;
 };
 
 C2SoftFlacEnc::C2SoftFlacEnc(
@@ -120,7 +134,8 @@ C2SoftFlacEnc::C2SoftFlacEnc(
     : SimpleC2Component(std::make_shared<SimpleInterface<IntfImpl>>(name, id, intfImpl)),
       mIntf(intfImpl),
       mFlacStreamEncoder(nullptr),
-      mInputBufferPcm32(nullptr) {
+      mInputBufferPcm32(nullptr),
+      mNumThreads(1u) {
 }
 
 C2SoftFlacEnc::~C2SoftFlacEnc() {
@@ -252,8 +267,9 @@ void C2SoftFlacEnc::process(
     const unsigned frameSize = channelCount * sampleSize;
     const uint64_t outTimeStamp = mProcessedSamples * 1000000ll / sampleRate;
 
+    // With several encoder threads the frames of earlier works may be output with this one.
     size_t outCapacity = inSize;
-    outCapacity += mBlockSize * frameSize;
+    outCapacity += mNumThreads * mBlockSize * frameSize;
 
     C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
     c2_status_t err = pool->fetchLinearBlock(outCapacity, usage, &mOutputBlock);
@@ -363,6 +379,20 @@ FLAC__StreamEncoderWriteStatus C2SoftFlacEnc::onEncodedFlacAvailable(
     return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
 }
 
+#if defined(FLAC_API_VERSION_CURRENT) && FLAC_API_VERSION_CURRENT >= 14
+static int GetCPUCoreCount() {
+    int cpuCoreCount = 1;
+#if defined(_SC_NPROCESSORS_ONLN)
+    cpuCoreCount = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    // _SC_NPROC_ONLN must be defined...
+    cpuCoreCount = sysconf(_SC_NPROC_ONLN);
+#endif
+    CHECK(cpuCoreCount >= 1);
+    ALOGV("Number of CPU cores: %d", cpuCoreCount);
+    return cpuCoreCount;
+}
+#endif
 
 status_t C2SoftFlacEnc::configureEncoder() {
     ALOGV("%s numChannel=%d, sampleRate=%d", __func__, mIntf->getChannelCount(), mIntf->getSampleRate());
@@ -386,6 +416,22 @@ status_t C2SoftFlacEnc::configureEncoder() {
         return UNKNOWN_ERROR;
     }
 
+    mNumThreads = 1u;
+#if defined(FLAC_API_VERSION_CURRENT) && FLAC_API_VERSION_CURRENT >= 14
+    // libFLAC 1.5 can encode several frames in parallel. Frames are then output up to
+    // mNumThreads frames late, so this is only done for best effort operation.
+    const uint32_t numThreads = mIntf->isRealTime() ? 1u :
+            std::min((uint32_t)GetCPUCoreCount(), (uint32_t)kMaxNumThreads);
+    if (FLAC__stream_encoder_set_num_threads(mFlacStreamEncoder, numThreads)
+            == FLAC__STREAM_ENCODER_SET_NUM_THREADS_OK) {
+        mNumThreads = numThreads;
+    } else {
+        ALOGW("failed to use %u encoder threads", numThreads);
+        (void)FLAC__stream_encoder_set_num_threads(mFlacStreamEncoder, 1u);
+    }
+    ALOGV("encoding with %u threads", mNumThreads);
+#endif
+
     ok &= FLAC__STREAM_ENCODER_INIT_STATUS_OK ==
             FLAC__stream_encoder_init_stream(mFlacStreamEncoder,
                     flacEncoderWriteCallback    /*write_callback*/,
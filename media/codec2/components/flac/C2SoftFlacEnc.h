@@ -64,12 +64,15 @@ private:
     std::shared_ptr<IntfImpl> mIntf;
     const unsigned int kInBlockSize = 1152;
     const unsigned int kMaxNumChannels = 2;
+    const unsigned int kMaxNumThreads = 4;
     FLAC__StreamEncoder* mFlacStreamEncoder;
     FLAC__int32* mInputBufferPcm32;
     std::shared_ptr<C2LinearBlock> mOutputBlock;
     bool mSignalledError;
     bool mSignalledOutputEos;
     uint32_t mBlockSize;
+    // frames libFLAC encodes at once, each may be output one process() call late
+    uint32_t mNumThreads;
     bool mIsFirstFrame;
     uint64_t mAnchorTimeStamp;
     uint64_t mProcessedSamples;
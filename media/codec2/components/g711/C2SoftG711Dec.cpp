@@ -35,6 +35,8 @@ constexpr char COMPONENT_NAME[] = "c2.android.g711.alaw.decoder";
 constexpr char COMPONENT_NAME[] = "c2.android.g711.mlaw.decoder";
 #endif
 
+constexpr uint32_t kMaxAccessUnitsPerBuffer = 64;
+
 }  // namespace
 
 class C2SoftG711Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
@@ -89,6 +91,11 @@ public:
                 DefineParam(mInputMaxBufSize, C2_PARAMKEY_INPUT_MAX_BUFFER_SIZE)
                 .withConstValue(new C2StreamMaxBufferSizeInfo::input(0u, 8192))
                 .build());
+
+        addParameter(
+                DefineParam(mMaxAccessUnitCount, C2_PARAMKEY_INPUT_MAX_ACCESS_UNIT_COUNT)
+                .withConstValue(new C2PortMaxAccessUnitCountInfo::input(kMaxAccessUnitsPerBuffer))
+                .build());
     }
 
 private:
@@ -96,6 +103,7 @@ private:
     std::shared_ptr<C2StreamChannelCountInfo::output> mChannelCount;
     std::shared_ptr<C2StreamBitrateInfo::input> mBitrate;
     std::shared_ptr<C2StreamMaxBufferSizeInfo::input> mInputMaxBufSize;
+    std::shared_ptr<C2PortMaxAccessUnitCountInfo::input> mMaxAccessUnitCount;
 };
 
 C2SoftG711Dec::C2SoftG711Dec(
@@ -173,6 +181,14 @@ void C2SoftG711Dec::process(
         return;
     }
 
+    // G.711 samples are decoded independently, so the access units of a buffer are decoded in
+    // one go; their sizes are only checked.
+    std::vector<size_t> accessUnitSizes;
+    if (!GetAccessUnitSizes(work, inSize, kMaxAccessUnitsPerBuffer, &accessUnitSizes)) {
+        work->result = C2_BAD_VALUE;
+        return;
+    }
+
     uint8_t *inputptr = const_cast<uint8_t *>(rView.data() + inOffset);
 
     std::shared_ptr<C2LinearBlock> block;
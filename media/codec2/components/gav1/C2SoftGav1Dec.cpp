@@ -24,10 +24,14 @@
 #include <Codec2CommonUtils.h>
 #include <Codec2Mapper.h>
 #include <SimpleC2Interface.h>
+#include <cutils/properties.h>
 #include <log/log.h>
 #include <media/stagefright/foundation/AUtils.h>
 #include <media/stagefright/foundation/MediaDefs.h>
 
+#include <algorithm>
+#include <unistd.h>
+
 namespace android {
 
 // codecname set and passed in as a compile flag from Android.bp
@@ -35,6 +39,10 @@ constexpr char COMPONENT_NAME[] = CODECNAME;
 
 constexpr size_t kMinInputBufferSize = 2 * 1024 * 1024;
 
+// How long to wait between polls for frames that are still being decoded in frame parallel
+// mode while draining.
+constexpr useconds_t kFrameParallelDrainPollUs = 1000;
+
 class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
  public:
   explicit IntfImpl(const std::shared_ptr<C2ReflectorHelper> &helper)
@@ -330,6 +338,7 @@ class C2SoftGav1Dec::IntfImpl : public SimpleInterface<void>::BaseParams {
 
   // unsafe getters
   std::shared_ptr<C2StreamPixelFormatInfo::output> getPixelFormat_l() const { return mPixelFormat; }
+  std::shared_ptr<C2StreamPictureSizeInfo::output> getSize_l() const { return mSize; }
 
  private:
   std::shared_ptr<C2StreamProfileLevelInfo::input> mProfileLevel;
@@ -386,6 +395,7 @@ c2_status_t C2SoftGav1Dec::onFlush_sm() {
     ALOGE("Failed to flush av1 decoder. status: %d.", status);
     return C2_CORRUPTED;
   }
+  mEnqueueTimes.clear();
 
   // Dequeue frame (if any) that was enqueued previously.
   const libgav1::DecoderBuffer *buffer;
@@ -415,14 +425,36 @@ static int GetCPUCoreCount() {
   return cpuCoreCount;
 }
 
+// Small frames have few tiles and superblock rows to spread over threads, so more threads than
+// this only add synchronization overhead.
+static int GetThreadCount(uint32_t width, uint32_t height) {
+  const uint32_t pixels = width * height;
+  int maxThreads;
+  if (pixels <= 640 * 480) {
+    maxThreads = 2;
+  } else if (pixels <= 1280 * 720) {
+    maxThreads = 4;
+  } else {
+    maxThreads = 8;
+  }
+  return std::min(GetCPUCoreCount(), maxThreads);
+}
+
 bool C2SoftGav1Dec::initDecoder() {
   mSignalledError = false;
   mSignalledOutputEos = false;
   mHalPixelFormat = HAL_PIXEL_FORMAT_YV12;
+  uint32_t width, height;
   {
       IntfImpl::Lock lock = mIntf->lock();
       mPixelFormatInfo = mIntf->getPixelFormat_l();
+      width = mIntf->getSize_l()->width;
+      height = mIntf->getSize_l()->height;
   }
+  mEnqueueTimes.clear();
+  mDecodedFrames = 0;
+  mTotalDecodeTimeNs = 0;
+  mMaxDecodeTimeNs = 0;
   mCodecCtx.reset(new libgav1::Decoder());
 
   if (mCodecCtx == nullptr) {
@@ -431,9 +463,15 @@ bool C2SoftGav1Dec::initDecoder() {
   }
 
   libgav1::DecoderSettings settings = {};
-  settings.threads = GetCPUCoreCount();
-
-  ALOGV("Using libgav1 AV1 software decoder.");
+  settings.threads = GetThreadCount(width, height);
+  // Frame parallel decoding keeps several frames in flight, which raises throughput at the
+  // expense of output latency; libgav1 only uses it with more than one thread.
+  mFrameParallel = settings.threads > 1
+      && property_get_bool("debug.c2.gav1.frame_parallel", false);
+  settings.frame_parallel = mFrameParallel;
+
+  ALOGV("Using libgav1 AV1 software decoder with %d threads%s.", settings.threads,
+        mFrameParallel ? " in frame parallel mode" : "");
   Libgav1StatusCode status = mCodecCtx->Init(&settings);
   if (status != kLibgav1StatusOk) {
     ALOGE("av1 decoder failed to initialize. status: %d.", status);
@@ -443,7 +481,14 @@ bool C2SoftGav1Dec::initDecoder() {
   return true;
 }
 
-void C2SoftGav1Dec::destroyDecoder() { mCodecCtx = nullptr; }
+void C2SoftGav1Dec::destroyDecoder() {
+  if (mDecodedFrames > 0) {
+    ALOGD("decoded %" PRIu64 " frames, decode time avg %" PRId64 "us max %" PRId64 "us",
+          mDecodedFrames, mTotalDecodeTimeNs / (int64_t)mDecodedFrames / 1000,
+          mMaxDecodeTimeNs / 1000);
+  }
+  mCodecCtx = nullptr;
+}
 
 void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
   uint32_t flags = 0;
@@ -529,10 +574,23 @@ void C2SoftGav1Dec::process(const std::unique_ptr<C2Work> &work,
 
     mTimeStart = systemTime();
     nsecs_t delay = mTimeStart - mTimeEnd;
+    mEnqueueTimes.emplace(frameIndex, mTimeStart);
 
-    const Libgav1StatusCode status =
+    Libgav1StatusCode status =
         mCodecCtx->EnqueueFrame(bitstream, inSize, frameIndex,
                                 /*buffer_private_data=*/nullptr);
+    // In frame parallel mode the decoder only holds a limited number of frames; output what
+    // is ready to make room.
+    while (status == kLibgav1StatusTryAgain && !mSignalledError) {
+      if (!outputBuffer(pool, work)) {
+        if (mDequeueStatus != kLibgav1StatusTryAgain) {
+          break;
+        }
+        usleep(kFrameParallelDrainPollUs);
+      }
+      status = mCodecCtx->EnqueueFrame(bitstream, inSize, frameIndex,
+                                       /*buffer_private_data=*/nullptr);
+    }
 
     mTimeEnd = systemTime();
     nsecs_t decodeTime = mTimeEnd - mTimeStart;
@@ -548,7 +606,8 @@ void C2SoftGav1Dec::process(const std::unique_ptr<C2Work> &work,
 
   }
 
-  (void)outputBuffer(pool, work);
+  while (outputBuffer(pool, work) && mFrameParallel) {
+  }
 
   if (eos) {
     drainInternal(DRAIN_COMPONENT_WITH_EOS, pool, work);
@@ -594,10 +653,12 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
                                  const std::unique_ptr<C2Work> &work) {
   if (!(work && pool)) return false;
 
-  const libgav1::DecoderBuffer *buffer;
+  const libgav1::DecoderBuffer *buffer = nullptr;
   const Libgav1StatusCode status = mCodecCtx->DequeueFrame(&buffer);
+  mDequeueStatus = status;
 
-  if (status != kLibgav1StatusOk && status != kLibgav1StatusNothingToDequeue) {
+  if (status != kLibgav1StatusOk && status != kLibgav1StatusNothingToDequeue
+      && status != kLibgav1StatusTryAgain) {
     ALOGE("av1 decoder DequeueFrame failed. status: %d.", status);
     return false;
   }
@@ -607,10 +668,24 @@ bool C2SoftGav1Dec::outputBuffer(const std::shared_ptr<C2BlockPool> &pool,
   // of two things:
   //  - The EnqueueFrame() call was either a flush (called with nullptr).
   //  - The enqueued frame did not have any displayable frames.
+  // In frame parallel mode kLibgav1StatusTryAgain means the oldest frame is
+  // still being decoded.
   if (!buffer) {
     return false;
   }
 
+  // Decode time is measured from enqueue to dequeue so that it also covers
+  // frames decoded in parallel. Frames without displayable output are dropped
+  // from the map as later frames come out.
+  auto enqueued = mEnqueueTimes.find(buffer->user_private_data);
+  if (enqueued != mEnqueueTimes.end()) {
+    const nsecs_t decodeTimeNs = systemTime() - enqueued->second;
+    ++mDecodedFrames;
+    mTotalDecodeTimeNs += decodeTimeNs;
+    mMaxDecodeTimeNs = std::max(mMaxDecodeTimeNs, decodeTimeNs);
+    mEnqueueTimes.erase(mEnqueueTimes.begin(), ++enqueued);
+  }
+
   const int width = buffer->displayed_width[0];
   const int height = buffer->displayed_height[0];
   if (width != mWidth || height != mHeight) {
@@ -765,11 +840,26 @@ c2_status_t C2SoftGav1Dec::drainInternal(
     return C2_OMITTED;
   }
 
+  if (mFrameParallel) {
+    // SignalEOS() discards frames that are still in flight in frame parallel
+    // mode, so wait for them to be output first.
+    while (!mSignalledError) {
+      if (outputBuffer(pool, work)) {
+        continue;
+      }
+      if (mDequeueStatus != kLibgav1StatusTryAgain) {
+        break;
+      }
+      usleep(kFrameParallelDrainPollUs);
+    }
+  }
+
   const Libgav1StatusCode status = mCodecCtx->SignalEOS();
   if (status != kLibgav1StatusOk) {
     ALOGE("Failed to flush av1 decoder. status: %d.", status);
     return C2_CORRUPTED;
   }
+  mEnqueueTimes.clear();
 
   while (outputBuffer(pool, work)) {
   }
@@ -19,6 +19,8 @@
 
 #include <inttypes.h>
 
+#include <map>
+
 #include <media/stagefright/foundation/ColorUtils.h>
 
 #include <SimpleC2Component.h>
@@ -60,6 +62,8 @@ struct C2SoftGav1Dec : public SimpleC2Component {
   uint32_t mHeight;
   bool mSignalledOutputEos;
   bool mSignalledError;
+  bool mFrameParallel = false;
+  Libgav1StatusCode mDequeueStatus = kLibgav1StatusOk;  // status of the last DequeueFrame()
 
   // Color aspects. These are ISO values and are meant to detect changes in aspects to avoid
   // converting them to C2 values for each frame
@@ -85,6 +89,12 @@ struct C2SoftGav1Dec : public SimpleC2Component {
   nsecs_t mTimeStart = 0;  // Time at the start of decode()
   nsecs_t mTimeEnd = 0;    // Time at the end of decode()
 
+  // Decode time statistics, measured from EnqueueFrame() to DequeueFrame().
+  std::map<uint64_t, nsecs_t> mEnqueueTimes;  // frame index -> enqueue time
+  uint64_t mDecodedFrames = 0;
+  nsecs_t mTotalDecodeTimeNs = 0;
+  nsecs_t mMaxDecodeTimeNs = 0;
+
   bool initDecoder();
   void getVuiParams(const libgav1::DecoderBuffer *buffer);
   void destroyDecoder();
@@ -18,6 +18,8 @@
 #define LOG_TAG "C2SoftOpusDec"
 #include <log/log.h>
 
+#include <inttypes.h>
+
 #include <media/stagefright/foundation/MediaDefs.h>
 #include <media/stagefright/foundation/OpusHeader.h>
 #include <C2PlatformSupport.h>
@@ -84,6 +86,18 @@ public:
                 DefineParam(mInputMaxBufSize, C2_PARAMKEY_INPUT_MAX_BUFFER_SIZE)
                 .withConstValue(new C2StreamMaxBufferSizeInfo::input(0u, 960 * 6))
                 .build());
+
+        addParameter(
+                DefineParam(mMaxAccessUnitCount, C2_PARAMKEY_INPUT_MAX_ACCESS_UNIT_COUNT)
+                .withConstValue(new C2PortMaxAccessUnitCountInfo::input(kMaxAccessUnitsPerBuffer))
+                .build());
+
+        addParameter(
+                DefineParam(mFrameDecodeTime, C2_PARAMKEY_COMPONENT_FRAME_DECODE_TIME)
+                .withDefault(new C2ComponentFrameDecodeTimeInfo(0u))
+                .withFields({C2F(mFrameDecodeTime, value).any()})
+                .withSetter(Setter<decltype(*mFrameDecodeTime)>::NonStrictValueWithNoDeps)
+                .build());
     }
 
 private:
@@ -91,6 +105,8 @@ private:
     std::shared_ptr<C2StreamChannelCountInfo::output> mChannelCount;
     std::shared_ptr<C2StreamBitrateInfo::input> mBitrate;
     std::shared_ptr<C2StreamMaxBufferSizeInfo::input> mInputMaxBufSize;
+    std::shared_ptr<C2PortMaxAccessUnitCountInfo::input> mMaxAccessUnitCount;
+    std::shared_ptr<C2ComponentFrameDecodeTimeInfo> mFrameDecodeTime;
 };
 
 C2SoftOpusDec::C2SoftOpusDec(const char *name, c2_node_id_t id,
@@ -122,6 +138,9 @@ c2_status_t C2SoftOpusDec::onStop() {
     mInputBufferCount = 0;
     mSignalledError = false;
     mSignalledOutputEos = false;
+    mDecodeTimeNs = 0;
+    mDecodedFrames = 0;
+    mNextDecodeTimeReport = kDecodeTimeReportInterval;
 
     return C2_OK;
 }
@@ -137,6 +156,20 @@ void C2SoftOpusDec::onRelease() {
     }
 }
 
+void C2SoftOpusDec::updateDecodeTime(nsecs_t decodeTimeNs, size_t numFrames) {
+    mDecodeTimeNs += decodeTimeNs;
+    mDecodedFrames += numFrames;
+    if (mDecodedFrames < mNextDecodeTimeReport) {
+        return;
+    }
+    mNextDecodeTimeReport = mDecodedFrames + kDecodeTimeReportInterval;
+    C2ComponentFrameDecodeTimeInfo frameDecodeTime(ns2us(mDecodeTimeNs / mDecodedFrames));
+    std::vector<std::unique_ptr<C2SettingResult>> failures;
+    (void) mIntf->config({&frameDecodeTime}, C2_MAY_BLOCK, &failures);
+    ALOGV("decoded %" PRIu64 " frames in %" PRId64 " us each", mDecodedFrames,
+          ns2us(mDecodeTimeNs / mDecodedFrames));
+}
+
 status_t C2SoftOpusDec::initDecoder() {
     memset(&mHeader, 0, sizeof(mHeader));
     mCodecDelay = 0;
@@ -145,6 +178,9 @@ status_t C2SoftOpusDec::initDecoder() {
     mInputBufferCount = 0;
     mSignalledError = false;
     mSignalledOutputEos = false;
+    mDecodeTimeNs = 0;
+    mDecodedFrames = 0;
+    mNextDecodeTimeReport = kDecodeTimeReportInterval;
 
     return OK;
 }
@@ -374,11 +410,32 @@ void C2SoftOpusDec::process(
     // other timestamp).
     if (work->input.ordinal.timestamp.peeku() == 0) mSamplesToDiscard = mCodecDelay;
 
+    std::vector<size_t> accessUnitSizes;
+    if (!GetAccessUnitSizes(work, inSize, kMaxAccessUnitsPerBuffer, &accessUnitSizes)) {
+        mSignalledError = true;
+        work->result = C2_BAD_VALUE;
+        return;
+    }
+
+    // The access units of a work are decoded back to back into one output block. The block is
+    // sized for the channels of the stream and the duration of each packet as given by its TOC.
+    const size_t bytesPerSample = sizeof(int16_t) * mHeader.channels;
+    std::vector<int> accessUnitMaxSamples;
+    size_t maxSamples = 0;
+    const uint8_t *packet = data;
+    for (size_t accessUnitSize : accessUnitSizes) {
+        int samples = opus_packet_get_nb_samples(packet, accessUnitSize, kRate);
+        if (samples <= 0 || samples > kMaxOpusOutputPacketSizeSamples) {
+            samples = kMaxOpusOutputPacketSizeSamples;
+        }
+        accessUnitMaxSamples.push_back(samples);
+        maxSamples += samples;
+        packet += accessUnitSize;
+    }
+
     std::shared_ptr<C2LinearBlock> block;
     C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
-    c2_status_t err = pool->fetchLinearBlock(
-                          kMaxNumSamplesPerBuffer * kMaxChannels * sizeof(int16_t),
-                          usage, &block);
+    c2_status_t err = pool->fetchLinearBlock(maxSamples * bytesPerSample, usage, &block);
     if (err != C2_OK) {
         ALOGE("fetchLinearBlock for Output failed with status %d", err);
         work->result = C2_NO_MEMORY;
@@ -391,34 +448,45 @@ void C2SoftOpusDec::process(
         return;
     }
 
-    int numSamples = opus_multistream_decode(mDecoder,
-                                             data,
-                                             inSize,
-                                             reinterpret_cast<int16_t *> (wView.data()),
-                                             kMaxOpusOutputPacketSizeSamples,
-                                             0);
-    if (numSamples < 0) {
-        ALOGE("opus_multistream_decode returned numSamples %d", numSamples);
-        numSamples = 0;
-        mSignalledError = true;
-        work->result = C2_CORRUPTED;
-        return;
-    }
-
     int outOffset = 0;
-    if (mSamplesToDiscard > 0) {
-        if (mSamplesToDiscard > numSamples) {
-            mSamplesToDiscard -= numSamples;
-            numSamples = 0;
-        } else {
-            numSamples -= mSamplesToDiscard;
-            outOffset = mSamplesToDiscard * sizeof(int16_t) * mHeader.channels;
-            mSamplesToDiscard = 0;
+    int numSamples = 0;
+    nsecs_t decodeStart = systemTime();
+    for (size_t i = 0; i < accessUnitSizes.size(); ++i) {
+        size_t accessUnitSize = accessUnitSizes[i];
+        int16_t *out = reinterpret_cast<int16_t *>(
+                wView.data() + outOffset + numSamples * bytesPerSample);
+        int decodedSamples = opus_multistream_decode(mDecoder,
+                                                     data,
+                                                     accessUnitSize,
+                                                     out,
+                                                     accessUnitMaxSamples[i],
+                                                     0);
+        if (decodedSamples < 0) {
+            ALOGE("opus_multistream_decode returned numSamples %d", decodedSamples);
+            mSignalledError = true;
+            work->result = C2_CORRUPTED;
+            return;
+        }
+        data += accessUnitSize;
+
+        // Samples are only discarded at the start of the output, so the next access unit
+        // is decoded right after the samples that are kept.
+        if (mSamplesToDiscard > 0) {
+            if (mSamplesToDiscard > decodedSamples) {
+                mSamplesToDiscard -= decodedSamples;
+                decodedSamples = 0;
+            } else {
+                decodedSamples -= mSamplesToDiscard;
+                outOffset += mSamplesToDiscard * bytesPerSample;
+                mSamplesToDiscard = 0;
+            }
         }
+        numSamples += decodedSamples;
     }
+    updateDecodeTime(systemTime() - decodeStart, accessUnitSizes.size());
 
     if (numSamples) {
-        int outSize = numSamples * sizeof(int16_t) * mHeader.channels;
+        int outSize = numSamples * bytesPerSample;
         ALOGV("out buffer attr. offset %d size %d ", outOffset, outSize);
 
         work->worklets.front()->output.flags = work->input.flags;
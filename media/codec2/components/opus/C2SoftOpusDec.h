@@ -18,6 +18,7 @@
 #define ANDROID_C2_SOFT_OPUS_DEC_H_
 
 #include <SimpleC2Component.h>
+#include <utils/Timers.h>
 
 
 struct OpusMSDecoder;
@@ -45,7 +46,10 @@ struct C2SoftOpusDec : public SimpleC2Component {
             const std::shared_ptr<C2BlockPool> &pool) override;
 private:
     enum {
-        kMaxNumSamplesPerBuffer = 960 * 6
+        kMaxNumSamplesPerBuffer = 960 * 6,
+        kMaxAccessUnitsPerBuffer = 16,
+        // access units between updates of the reported decode time
+        kDecodeTimeReportInterval = 500,
     };
 
     std::shared_ptr<IntfImpl> mIntf;
@@ -59,7 +63,12 @@ private:
     bool mSignalledError;
     bool mSignalledOutputEos;
 
+    nsecs_t mDecodeTimeNs;
+    uint64_t mDecodedFrames;
+    uint64_t mNextDecodeTimeReport;
+
     status_t initDecoder();
+    void updateDecodeTime(nsecs_t decodeTimeNs, size_t numFrames);
 
     C2_DO_NOT_COPY(C2SoftOpusDec);
 };
@@ -662,6 +662,29 @@ void C2SoftVpxDec::process(
     }
 }
 
+void C2SoftVpxDec::convertInSlices(const std::function<void(size_t, size_t)> &convertSlice) {
+    // Slices are an even number of rows so that each starts on a chroma row.
+    constexpr size_t kSliceHeight = 64;
+    constexpr uint32_t kMinParallelHeight = 720;
+    if (mConverterThreads.empty() || mHeight < kMinParallelHeight) {
+        convertSlice(0, mHeight);
+        return;
+    }
+    Mutexed<ConversionQueue>::Locked queue(*mQueue);
+    for (size_t row = 0; row < mHeight; row += kSliceHeight) {
+        queue->entries.push_back(
+                [convertSlice, row, height = std::min(mHeight - row, kSliceHeight)] {
+                    convertSlice(row, height);
+                });
+    }
+    CHECK_EQ(0u, queue->numPending);
+    queue->numPending = queue->entries.size();
+    while (queue->numPending > 0) {
+        queue->cond.signal();
+        queue.waitForCondition(queue->cond);
+    }
+}
+
 status_t C2SoftVpxDec::outputBuffer(
         const std::shared_ptr<C2BlockPool> &pool,
         const std::unique_ptr<C2Work> &work)
@@ -769,49 +792,57 @@ status_t C2SoftVpxDec::outputBuffer(
         const uint16_t *srcV = (const uint16_t *)img->planes[VPX_PLANE_V];
 
         if (format == HAL_PIXEL_FORMAT_RGBA_1010102) {
-            Mutexed<ConversionQueue>::Locked queue(*mQueue);
-            size_t i = 0;
-            constexpr size_t kHeight = 64;
-            for (; i < mHeight; i += kHeight) {
-                queue->entries.push_back(
-                        [dstY, srcY, srcU, srcV,
-                         srcYStride, srcUStride, srcVStride, dstYStride,
-                         width = mWidth, height = std::min(mHeight - i, kHeight),
-                         defaultColorAspects] {
-                            convertYUV420Planar16ToY410OrRGBA1010102(
-                                    (uint32_t *)dstY, srcY, srcU, srcV, srcYStride / 2,
-                                    srcUStride / 2, srcVStride / 2, dstYStride / sizeof(uint32_t),
-                                    width, height,
-                                    std::static_pointer_cast<const C2ColorAspectsStruct>(
-                                            defaultColorAspects));
-                        });
-                srcY += srcYStride / 2 * kHeight;
-                srcU += srcUStride / 2 * (kHeight / 2);
-                srcV += srcVStride / 2 * (kHeight / 2);
-                dstY += dstYStride * kHeight;
-            }
-            CHECK_EQ(0u, queue->numPending);
-            queue->numPending = queue->entries.size();
-            while (queue->numPending > 0) {
-                queue->cond.signal();
-                queue.waitForCondition(queue->cond);
-            }
+            convertInSlices([=, width = mWidth](size_t row, size_t height) {
+                convertYUV420Planar16ToY410OrRGBA1010102(
+                        (uint32_t *)(dstY + dstYStride * row),
+                        srcY + srcYStride / 2 * row,
+                        srcU + srcUStride / 2 * (row / 2),
+                        srcV + srcVStride / 2 * (row / 2),
+                        srcYStride / 2, srcUStride / 2, srcVStride / 2,
+                        dstYStride / sizeof(uint32_t), width, height,
+                        std::static_pointer_cast<const C2ColorAspectsStruct>(
+                                defaultColorAspects));
+            });
         } else if (format == HAL_PIXEL_FORMAT_YCBCR_P010) {
-            convertYUV420Planar16ToP010((uint16_t *)dstY, (uint16_t *)dstU, srcY, srcU, srcV,
-                                        srcYStride / 2, srcUStride / 2, srcVStride / 2,
-                                        dstYStride / 2, dstUVStride / 2, mWidth, mHeight);
+            convertInSlices([=, width = mWidth](size_t row, size_t height) {
+                convertYUV420Planar16ToP010(
+                        (uint16_t *)(dstY + dstYStride * row),
+                        (uint16_t *)(dstU + dstUVStride * (row / 2)),
+                        srcY + srcYStride / 2 * row,
+                        srcU + srcUStride / 2 * (row / 2),
+                        srcV + srcVStride / 2 * (row / 2),
+                        srcYStride / 2, srcUStride / 2, srcVStride / 2,
+                        dstYStride / 2, dstUVStride / 2, width, height);
+            });
         } else {
-            convertYUV420Planar16ToYV12(dstY, dstU, dstV, srcY, srcU, srcV, srcYStride / 2,
-                                        srcUStride / 2, srcVStride / 2, dstYStride, dstUVStride,
-                                        mWidth, mHeight);
+            convertInSlices([=, width = mWidth](size_t row, size_t height) {
+                convertYUV420Planar16ToYV12(
+                        dstY + dstYStride * row,
+                        dstU + dstUVStride * (row / 2),
+                        dstV + dstUVStride * (row / 2),
+                        srcY + srcYStride / 2 * row,
+                        srcU + srcUStride / 2 * (row / 2),
+                        srcV + srcVStride / 2 * (row / 2),
+                        srcYStride / 2, srcUStride / 2, srcVStride / 2,
+                        dstYStride, dstUVStride, width, height);
+            });
         }
     } else {
         const uint8_t *srcY = (const uint8_t *)img->planes[VPX_PLANE_Y];
         const uint8_t *srcU = (const uint8_t *)img->planes[VPX_PLANE_U];
         const uint8_t *srcV = (const uint8_t *)img->planes[VPX_PLANE_V];
 
-        convertYUV420Planar8ToYV12(dstY, dstU, dstV, srcY, srcU, srcV, srcYStride, srcUStride,
-                                   srcVStride, dstYStride, dstUVStride, mWidth, mHeight);
+        convertInSlices([=, width = mWidth](size_t row, size_t height) {
+            convertYUV420Planar8ToYV12(
+                    dstY + dstYStride * row,
+                    dstU + dstUVStride * (row / 2),
+                    dstV + dstUVStride * (row / 2),
+                    srcY + srcYStride * row,
+                    srcU + srcUStride * (row / 2),
+                    srcV + srcVStride * (row / 2),
+                    srcYStride, srcUStride, srcVStride,
+                    dstYStride, dstUVStride, width, height);
+        });
     }
     finishWork(((c2_cntr64_t *)img->user_priv)->peekull(), work, std::move(block));
     return OK;
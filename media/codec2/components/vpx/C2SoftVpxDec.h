@@ -93,6 +93,9 @@ struct C2SoftVpxDec : public SimpleC2Component {
     status_t outputBuffer(
             const std::shared_ptr<C2BlockPool> &pool,
             const std::unique_ptr<C2Work> &work);
+    // Runs |convertSlice(firstRow, numRows)| over the whole output frame, split across the
+    // converter threads for large frames.
+    void convertInSlices(const std::function<void(size_t, size_t)> &convertSlice);
     c2_status_t drainInternal(
             uint32_t drainMode,
             const std::shared_ptr<C2BlockPool> &pool,
@@ -284,6 +284,16 @@ enum C2ParamIndexKind : C2Param::type_index_t {
 
     // allow tunnel peek behavior to be unspecified for app compatibility
     kParamIndexTunnelPeekMode, // tunnel mode, enum
+
+    // number of threads used by the component
+    kParamIndexThreadCount, // uint32
+
+    // multiple access units in one input buffer
+    kParamIndexAccessUnitSizes, // input-buffer info, uint32[]
+    kParamIndexMaxAccessUnitCount, // uint32
+
+    // average decode time of a frame
+    kParamIndexFrameDecodeTime, // uint32
 };
 
 }
@@ -888,6 +898,53 @@ typedef C2GlobalParam<C2Tuning, C2EasyBoolValue, kParamIndexLowLatencyMode>
         C2GlobalLowLatencyModeTuning;
 constexpr char C2_PARAMKEY_LOW_LATENCY_MODE[] = "algo.low-latency";
 
+/**
+ * Number of threads the component uses for processing.
+ *
+ * Software components that run their codec library on several threads report the number of
+ * threads they configured it with. This may change when the stream configuration (e.g. the
+ * picture size) changes.
+ */
+typedef C2GlobalParam<C2Info, C2Uint32Value, kParamIndexThreadCount>
+        C2ComponentThreadCountInfo;
+constexpr char C2_PARAMKEY_COMPONENT_THREAD_COUNT[] = "algo.thread-count";
+
+/**
+ * Access unit sizes of an input buffer.
+ *
+ * Attached to an input C2Buffer that carries several consecutive access units, e.g. a number of
+ * short audio frames, to describe where each access unit ends. The sizes are in bytes and in
+ * stream order, and they add up to the size of the buffer. The access units share the timestamp
+ * and the flags of the work; the component returns their decoded output in one buffer.
+ *
+ * A buffer without this info holds a single access unit (unless the format is self-delimiting).
+ */
+typedef C2StreamParam<C2Info, C2Uint32Array, kParamIndexAccessUnitSizes>
+        C2StreamAccessUnitSizesInfo;
+constexpr char C2_PARAMKEY_INPUT_ACCESS_UNIT_SIZES[] = "input.access-unit-sizes";
+
+/**
+ * Maximum number of access units the component accepts in one input buffer.
+ *
+ * Components that support C2StreamAccessUnitSizesInfo report this for their input port. A value
+ * of 1 (or the absence of this parameter) means one access unit per input buffer.
+ */
+// read-only
+typedef C2PortParam<C2Info, C2Uint32Value, kParamIndexMaxAccessUnitCount>
+        C2PortMaxAccessUnitCountInfo;
+constexpr char C2_PARAMKEY_INPUT_MAX_ACCESS_UNIT_COUNT[] = "input.buffers.max-access-units";
+
+/**
+ * Average time in microseconds the component spent decoding one access unit.
+ *
+ * Software decoders may report this as a measure of their decoding cost. It is averaged since
+ * the component was started and updated periodically.
+ */
+// read-only
+typedef C2GlobalParam<C2Info, C2Uint32Value, kParamIndexFrameDecodeTime>
+        C2ComponentFrameDecodeTimeInfo;
+constexpr char C2_PARAMKEY_COMPONENT_FRAME_DECODE_TIME[] = "algo.frame-decode-time-us";
+
 /**
  * Reference characteristics.
  *
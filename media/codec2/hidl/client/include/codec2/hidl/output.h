@@ -17,6 +17,7 @@
 #ifndef CODEC2_HIDL_V1_0_UTILS_OUTPUT_BUFFER_QUEUE
 #define CODEC2_HIDL_V1_0_UTILS_OUTPUT_BUFFER_QUEUE
 
+#include <android/hardware/graphics/bufferqueue/2.0/IGraphicBufferProducer.h>
 #include <gui/IGraphicBufferProducer.h>
 #include <codec2/hidl/1.0/types.h>
 #include <codec2/hidl/1.2/types.h>
@@ -77,6 +78,8 @@ private:
 
     std::mutex mMutex;
     sp<IGraphicBufferProducer> mIgbp;
+    // HAL interface of mIgbp, handed to every block held from the surface.
+    sp<::android::hardware::graphics::bufferqueue::V2_0::IGraphicBufferProducer> mHgbp;
     uint32_t mGeneration;
     uint64_t mBqId;
     int32_t mMaxDequeueBufferCount;
@@ -87,7 +90,9 @@ private:
     std::shared_ptr<C2SurfaceSyncMemory> mSyncMem;
     bool mStopped;
 
-    bool registerBuffer(const C2ConstGraphicBlock& block);
+    // Takes the ownership of a block from the current surface. Called with
+    // mMutex held.
+    bool registerBuffer_l(const C2ConstGraphicBlock& block);
 };
 
 }  // namespace c2
@@ -252,6 +252,7 @@ bool OutputBufferQueue::configure(const sp<IGraphicBufferProducer>& igbp,
         C2SyncVariables *newSync = mSyncMem ? mSyncMem->mem() : nullptr;
 
         mIgbp = igbp;
+        mHgbp = igbp ? getHgbp(igbp) : nullptr;
         mGeneration = generation;
         mBqId = bqId;
         mOwner = std::make_shared<int>(0);
@@ -294,7 +295,7 @@ bool OutputBufferQueue::configure(const sp<IGraphicBufferProducer>& igbp,
             }
             bool attach =
                     _C2BlockFactory::EndAttachBlockToBufferQueue(
-                            data, mOwner, getHgbp(mIgbp), mSyncMem,
+                            data, mOwner, mHgbp, mSyncMem,
                             generation, bqId, bqSlot);
             if (!attach) {
                 igbp->cancelBuffer(bqSlot, Fence::NO_FENCE);
@@ -325,17 +326,12 @@ void OutputBufferQueue::stop() {
     mOwner.reset(); // destructor of the block will not triger IGBP::cancel()
 }
 
-bool OutputBufferQueue::registerBuffer(const C2ConstGraphicBlock& block) {
+bool OutputBufferQueue::registerBuffer_l(const C2ConstGraphicBlock& block) {
     std::shared_ptr<_C2BlockPoolData> data =
             _C2BlockFactory::GetGraphicBlockPoolData(block);
     if (!data) {
         return false;
     }
-    std::scoped_lock<std::mutex> l(mMutex);
-
-    if (!mIgbp || mStopped) {
-        return false;
-    }
 
     uint32_t oldGeneration;
     uint64_t oldId;
@@ -352,7 +348,7 @@ bool OutputBufferQueue::registerBuffer(const C2ConstGraphicBlock& block) {
                      << ", bqSlot " << oldSlot
                      << ", generation " << mGeneration
                      << ".";
-        _C2BlockFactory::HoldBlockFromBufferQueue(data, mOwner, getHgbp(mIgbp), mSyncMem);
+        _C2BlockFactory::HoldBlockFromBufferQueue(data, mOwner, mHgbp, mSyncMem);
         mPoolDatas[oldSlot] = data;
         mBuffers[oldSlot] = createGraphicBuffer(block);
         mBuffers[oldSlot]->setGenerationNumber(mGeneration);
@@ -478,8 +474,13 @@ status_t OutputBufferQueue::outputBuffer(
 
 void OutputBufferQueue::holdBufferQueueBlocks(
         const std::list<std::unique_ptr<C2Work>>& workList) {
+    // All blocks of the work list are registered under a single lock.
+    std::scoped_lock<std::mutex> l(mMutex);
+    if (!mIgbp || mStopped) {
+        return;
+    }
     forEachBlock(workList,
-                 std::bind(&OutputBufferQueue::registerBuffer,
+                 std::bind(&OutputBufferQueue::registerBuffer_l,
                            this, std::placeholders::_1));
 }
 
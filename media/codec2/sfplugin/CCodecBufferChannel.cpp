@@ -76,6 +76,9 @@ using DrmBufferType = hardware::drm::V1_0::BufferType;
 namespace {
 
 constexpr size_t kSmoothnessFactor = 4;
+// Used instead of kSmoothnessFactor for the pipeline room of a component in low
+// latency mode, so that it is fed no more work than its delays require.
+constexpr size_t kLowLatencySmoothnessFactor = 1;
 constexpr size_t kRenderingDepth = 3;
 
 // This is for keeping IGBP's buffer dropping logic in legacy mode other
@@ -157,7 +160,8 @@ CCodecBufferChannel::CCodecBufferChannel(
       mInputMetEos(false),
       mLastInputBufferAvailableTs(0u),
       mIsHWDecoder(false),
-      mSendEncryptedInfoBuffer(false) {
+      mSendEncryptedInfoBuffer(false),
+      mLowLatency(false) {
     mOutputSurface.lock()->maxDequeueBuffers = kSmoothnessFactor + kRenderingDepth;
     {
         Mutexed<Input>::Locked input(mInput);
@@ -258,7 +262,13 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
         }
         // TODO: we want to delay copying buffers.
         if (input->extraBuffers.numComponentBuffers() < input->numExtraSlots) {
-            copy = input->buffers->cloneAndReleaseBuffer(buffer);
+            // Block-backed buffers may be handed over as-is; otherwise copy.
+            copy = input->buffers->handOffAndReleaseBuffer(buffer);
+            if (copy != nullptr) {
+                ALOGV("[%s] queueInputBuffer: buffer handed off without copy", mName);
+            } else {
+                copy = input->buffers->cloneAndReleaseBuffer(buffer);
+            }
             if (copy != nullptr) {
                 (void)input->extraBuffers.assignSlot(copy);
                 if (!input->extraBuffers.releaseSlot(copy, &c2buffer, false)) {
@@ -287,6 +297,17 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
                 uint64_t frameIndex = work->input.ordinal.frameIndex.peeku();
                 output->rotation[frameIndex] = rotation;
             }
+            sp<ABuffer> accessUnitSizes;
+            if (c2buffer && buffer->meta()->findBuffer("au-sizes", &accessUnitSizes)
+                    && accessUnitSizes != nullptr) {
+                // Several access units in one buffer; the client checked that they add up
+                // to the buffer size.
+                size_t count = accessUnitSizes->size() / sizeof(uint32_t);
+                std::shared_ptr<C2StreamAccessUnitSizesInfo::input> info =
+                        C2StreamAccessUnitSizesInfo::input::AllocShared(count, 0u);
+                memcpy(info->m.values, accessUnitSizes->data(), count * sizeof(uint32_t));
+                c2buffer->setInfo(info);
+            }
             work->input.buffers.push_back(c2buffer);
             if (encryptedBlock) {
                 work->input.infoBuffers.emplace_back(C2InfoBuffer::CreateLinearBuffer(
@@ -1112,6 +1133,7 @@ status_t CCodecBufferChannel::start(
     C2PortActualDelayTuning::output outputDelay(0);
     C2ActualPipelineDelayTuning pipelineDelay(0);
     C2SecureModeTuning secureMode(C2Config::SM_UNPROTECTED);
+    C2GlobalLowLatencyModeTuning lowLatencyMode(C2_FALSE);
 
     c2_status_t err = mComponent->query(
             {
@@ -1124,6 +1146,7 @@ status_t CCodecBufferChannel::start(
                 &pipelineDelay,
                 &outputDelay,
                 &secureMode,
+                &lowLatencyMode,
             },
             {},
             C2_DONT_BLOCK,
@@ -1140,6 +1163,16 @@ status_t CCodecBufferChannel::start(
     uint32_t pipelineDelayValue = pipelineDelay ? pipelineDelay.value : 0;
     uint32_t outputDelayValue = outputDelay ? outputDelay.value : 0;
 
+    // In low latency mode the outputs are expected in decoding order, so they
+    // are not held back for reordering, and the pipeline is kept shallow.
+    mLowLatency = lowLatencyMode && lowLatencyMode.value == C2_TRUE;
+    if (mLowLatency) {
+        ALOGD("[%s] start: low latency mode", mName);
+        if (reorderDepth) {
+            reorderDepth.value = 0;
+        }
+    }
+
     size_t numInputSlots = inputDelayValue + pipelineDelayValue + kSmoothnessFactor;
     size_t numOutputSlots = outputDelayValue + kSmoothnessFactor;
 
@@ -1302,7 +1335,10 @@ status_t CCodecBufferChannel::start(
                         numInputSlots, mName));
                 forceArrayMode = true;
             } else {
-                input->buffers.reset(new LinearInputBuffers(mName));
+                LinearInputBuffers *buffers = new LinearInputBuffers(mName);
+                buffers->setZeroCopyHandOff(property_get_bool(
+                        "debug.stagefright.ccodec_zero_copy_input", false));
+                input->buffers.reset(buffers);
             }
         }
         input->buffers->setFormat(inputFormat);
@@ -1541,7 +1577,7 @@ status_t CCodecBufferChannel::start(
         watcher->inputDelay(inputDelayValue)
                 .pipelineDelay(pipelineDelayValue)
                 .outputDelay(outputDelayValue)
-                .smoothnessFactor(kSmoothnessFactor);
+                .smoothnessFactor(mLowLatency ? kLowLatencySmoothnessFactor : kSmoothnessFactor);
         watcher->flush();
     }
 
@@ -1766,12 +1802,16 @@ void CCodecBufferChannel::flush(const std::list<std::unique_ptr<C2Work>> &flushe
 
 void CCodecBufferChannel::onWorkDone(
         std::unique_ptr<C2Work> work, const sp<AMessage> &outputFormat,
-        const C2StreamInitDataInfo::output *initData) {
-    if (handleWork(std::move(work), outputFormat, initData)) {
+        const C2StreamInitDataInfo::output *initData, bool deferOutput) {
+    if (handleWork(std::move(work), outputFormat, initData, deferOutput)) {
         feedInputBufferIfAvailable();
     }
 }
 
+void CCodecBufferChannel::onWorkDoneBatchEnd() {
+    sendOutputBuffers();
+}
+
 void CCodecBufferChannel::onInputBufferDone(
         uint64_t frameIndex, size_t arrayIndex) {
     if (mInputSurface) {
@@ -1801,7 +1841,8 @@ void CCodecBufferChannel::onInputBufferDone(
 bool CCodecBufferChannel::handleWork(
         std::unique_ptr<C2Work> work,
         const sp<AMessage> &outputFormat,
-        const C2StreamInitDataInfo::output *initData) {
+        const C2StreamInitDataInfo::output *initData,
+        bool deferOutput) {
     {
         Mutexed<Output>::Locked output(mOutput);
         if (!output->buffers) {
@@ -1882,14 +1923,17 @@ bool CCodecBufferChannel::handleWork(
         switch (param->coreIndex().coreIndex()) {
             case C2PortReorderBufferDepthTuning::CORE_INDEX: {
                 C2PortReorderBufferDepthTuning::output reorderDepth;
-                if (reorderDepth.updateFrom(*param)) {
+                if (!reorderDepth.updateFrom(*param)) {
+                    ALOGD("[%s] onWorkDone: failed to read reorder depth",
+                          mName);
+                } else if (mLowLatency) {
+                    ALOGV("[%s] onWorkDone: ignored reorder depth %u in low latency mode",
+                          mName, reorderDepth.value);
+                } else {
                     ALOGV("[%s] onWorkDone: updated reorder depth to %u",
                           mName, reorderDepth.value);
                     newReorderDepth = reorderDepth.value;
                     needMaxDequeueBufferCountUpdate = true;
-                } else {
-                    ALOGD("[%s] onWorkDone: failed to read reorder depth",
-                          mName);
                 }
                 break;
             }
@@ -2065,6 +2109,10 @@ bool CCodecBufferChannel::handleWork(
 
     // csd cannot be re-ordered and will always arrive first.
     if (initData != nullptr) {
+        if (deferOutput) {
+            // do not let csd overtake the outputs deferred so far
+            sendOutputBuffers();
+        }
         Mutexed<Output>::Locked output(mOutput);
         if (output->buffers && outputFormat) {
             output->buffers->updateSkipCutBuffer(outputFormat);
@@ -2140,7 +2188,9 @@ bool CCodecBufferChannel::handleWork(
                 (initData == nullptr ? outputFormat : nullptr),
                 worklet->output.ordinal);
     }
-    sendOutputBuffers();
+    if (!deferOutput) {
+        sendOutputBuffers();
+    }
     return true;
 }
 
@@ -2153,9 +2203,20 @@ void CCodecBufferChannel::sendOutputBuffers() {
     constexpr int kMaxReallocTry = 5;
     int reallocTryNum = 0;
 
+    // Buffers registered in one pass are reported to the client together.
+    std::vector<std::pair<size_t, sp<MediaCodecBuffer>>> outBuffers;
+    auto notifyClient = [this, &outBuffers] {
+        if (!outBuffers.empty()) {
+            mCallback->onOutputBuffersAvailable(outBuffers);
+            outBuffers.clear();
+        }
+    };
+
     while (true) {
         Mutexed<Output>::Locked output(mOutput);
         if (!output->buffers) {
+            output.unlock();
+            notifyClient();
             return;
         }
         action = output->buffers->popFromStashAndRegister(
@@ -2165,16 +2226,18 @@ void CCodecBufferChannel::sendOutputBuffers() {
         }
         switch (action) {
         case OutputBuffers::SKIP:
+            output.unlock();
+            notifyClient();
             return;
         case OutputBuffers::DISCARD:
             break;
         case OutputBuffers::NOTIFY_CLIENT:
-            output.unlock();
-            mCallback->onOutputBufferAvailable(index, outBuffer);
+            outBuffers.emplace_back(index, outBuffer);
             break;
         case OutputBuffers::REALLOCATE:
             if (++reallocTryNum > kMaxReallocTry) {
                 output.unlock();
+                notifyClient();
                 ALOGE("[%s] sendOutputBuffers: tried %d realloc and failed",
                           mName, kMaxReallocTry);
                 mCCodecCallback->onError(UNKNOWN_ERROR, ACTION_CODE_FATAL);
@@ -2187,9 +2250,12 @@ void CCodecBufferChannel::sendOutputBuffers() {
             static_cast<OutputBuffersArray*>(output->buffers.get())->
                     realloc(c2Buffer);
             output.unlock();
+            notifyClient();
             mCCodecCallback->onOutputBuffersChanged();
             break;
         case OutputBuffers::RETRY:
+            output.unlock();
+            notifyClient();
             ALOGV("[%s] sendOutputBuffers: unable to register output buffer",
                   mName);
             return;
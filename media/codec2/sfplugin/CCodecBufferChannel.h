@@ -181,10 +181,18 @@ public:
      * @param workItems   finished work item.
      * @param outputFormat new output format if it has changed, otherwise nullptr
      * @param initData    new init data (CSD) if it has changed, otherwise nullptr
+     * @param deferOutput if true, keep the output buffers stashed until
+     *                    onWorkDoneBatchEnd() so that the outputs of a batch of
+     *                    works are sent to the client at once
      */
     void onWorkDone(
             std::unique_ptr<C2Work> work, const sp<AMessage> &outputFormat,
-            const C2StreamInitDataInfo::output *initData);
+            const C2StreamInitDataInfo::output *initData, bool deferOutput = false);
+
+    /**
+     * Send the output buffers deferred by onWorkDone() to the client.
+     */
+    void onWorkDoneBatchEnd();
 
     /**
      * Make an input buffer available for the client as it is no longer needed
@@ -269,7 +277,7 @@ private:
                                       size_t blockSize = 0);
     bool handleWork(
             std::unique_ptr<C2Work> work, const sp<AMessage> &outputFormat,
-            const C2StreamInitDataInfo::output *initData);
+            const C2StreamInitDataInfo::output *initData, bool deferOutput);
     void sendOutputBuffers();
     void ensureDecryptDestination(size_t size);
     int32_t getHeapSeqNum(const sp<hardware::HidlMemory> &memory);
@@ -354,6 +362,7 @@ private:
     std::atomic_bool mSendEncryptedInfoBuffer;
 
     std::atomic_bool mTunneled;
+    std::atomic_bool mLowLatency;
 };
 
 // Conversion of a c2_status_t value to a status_t value may depend on the
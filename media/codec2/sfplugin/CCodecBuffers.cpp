@@ -878,6 +878,20 @@ size_t LinearInputBuffers::numActiveSlots() const {
     return mImpl.numActiveSlots();
 }
 
+sp<Codec2Buffer> LinearInputBuffers::handOffAndReleaseBuffer(
+        const sp<MediaCodecBuffer> &buffer) {
+    if (!mZeroCopyHandOff) {
+        return nullptr;
+    }
+    // The client buffers are LinearBlockBuffers that write directly into the
+    // pooled block, so the component can read the block as-is. Releasing the
+    // slot here lets the next requestNewBuffer() fetch a fresh block instead.
+    if (!mImpl.releaseSlot(buffer, nullptr, true)) {
+        return nullptr;
+    }
+    return static_cast<Codec2Buffer *>(buffer.get());
+}
+
 size_t LinearInputBuffers::numClientBuffers() const {
     return mImpl.numClientBuffers();
 }
@@ -151,6 +151,19 @@ public:
      */
     sp<Codec2Buffer> cloneAndReleaseBuffer(const sp<MediaCodecBuffer> &buffer);
 
+    /**
+     * Release the buffer obtained from requestNewBuffer() from its slot and
+     * return the buffer itself, so that the caller can keep tracking it while
+     * the component holds the associated C2Buffer. Unlike
+     * cloneAndReleaseBuffer(), the content is not copied.
+     *
+     * \return  the released buffer; nullptr if the buffers cannot be handed
+     *          off without a copy.
+     */
+    virtual sp<Codec2Buffer> handOffAndReleaseBuffer(const sp<MediaCodecBuffer> &) {
+        return nullptr;
+    }
+
     /**
      * Return number of buffers are given to client but have not yet queued back.
      */
@@ -842,9 +855,16 @@ class LinearInputBuffers : public InputBuffers {
 public:
     LinearInputBuffers(const char *componentName, const char *name = "1D-Input")
         : InputBuffers(componentName, name),
-          mImpl(mName) { }
+          mImpl(mName),
+          mZeroCopyHandOff(false) { }
     ~LinearInputBuffers() override = default;
 
+    /**
+     * Let handOffAndReleaseBuffer() hand the block-backed client buffers over
+     * without copying them. Off by default.
+     */
+    void setZeroCopyHandOff(bool enabled) { mZeroCopyHandOff = enabled; }
+
     bool requestNewBuffer(size_t *index, sp<MediaCodecBuffer> *buffer) override;
 
     bool releaseBuffer(
@@ -859,6 +879,8 @@ public:
 
     std::unique_ptr<InputBuffers> toArrayMode(size_t size) override;
 
+    sp<Codec2Buffer> handOffAndReleaseBuffer(const sp<MediaCodecBuffer> &buffer) override;
+
     size_t numActiveSlots() const final;
 
     size_t numClientBuffers() const final;
@@ -871,6 +893,8 @@ protected:
 private:
     static sp<Codec2Buffer> Alloc(
             const std::shared_ptr<C2BlockPool> &pool, const sp<AMessage> &format);
+
+    bool mZeroCopyHandOff;
 };
 
 class EncryptedLinearInputBuffers : public LinearInputBuffers {
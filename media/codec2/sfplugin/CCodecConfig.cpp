@@ -326,7 +326,9 @@ const std::vector<ConfigMapper> StandardParams::NO_MAPPERS;
 
 
 CCodecConfig::CCodecConfig()
-    : mInputFormat(new AMessage),
+    : mSubscribedIndicesSize(0),
+      mConfigUpdatesSubscribed(false),
+      mInputFormat(new AMessage),
       mOutputFormat(new AMessage),
       mUsingSurface(false),
       mTunneled(false),
@@ -972,6 +974,15 @@ void CCodecConfig::initializeStandardParams() {
 
     add(ConfigMapper(C2_PARAMKEY_INPUT_TIME_STRETCH, C2_PARAMKEY_INPUT_TIME_STRETCH, "value"));
 
+    add(ConfigMapper("thread-count", C2_PARAMKEY_COMPONENT_THREAD_COUNT, "value")
+        .limitTo(D::DECODER & D::OUTPUT & D::READ));
+
+    add(ConfigMapper("max-input-access-units", C2_PARAMKEY_INPUT_MAX_ACCESS_UNIT_COUNT, "value")
+        .limitTo(D::AUDIO & D::DECODER & D::INPUT & D::READ));
+
+    add(ConfigMapper("frame-decode-time-us", C2_PARAMKEY_COMPONENT_FRAME_DECODE_TIME, "value")
+        .limitTo(D::DECODER & D::OUTPUT & D::READ));
+
     add(ConfigMapper(KEY_LOW_LATENCY, C2_PARAMKEY_LOW_LATENCY_MODE, "value")
         .limitTo(D::DECODER & (D::CONFIG | D::PARAM))
         .withMapper([](C2Value v) -> C2Value {
@@ -1207,6 +1218,7 @@ status_t CCodecConfig::subscribeToConfigUpdate(
             ALOGD("Failed to subscribe to parameters => %s", asString(c2Err));
             // TODO: error
         }
+        mConfigUpdatesSubscribed = (c2Err == C2_OK);
         ALOGV("Subscribed to %zu params", mSubscribedIndices.size());
         mSubscribedIndicesSize = mSubscribedIndices.size();
     }
@@ -1949,7 +1961,15 @@ status_t CCodecConfig::getConfigUpdateFromSdkParams(
     std::vector<C2Param::Index> supportedIndices;
     for (C2Param::Index ix : indices) {
         if (mSupportedIndices.count(ix)) {
-            supportedIndices.push_back(ix);
+            // The component reports changes to subscribed parameters with each work, so the
+            // current configuration is up to date for those and need not be queried.
+            auto it = mCurrentConfig.find(ix);
+            if (mConfigUpdatesSubscribed && mSubscribedIndices.count(ix)
+                    && it != mCurrentConfig.end()) {
+                configUpdate->emplace_back(C2Param::Copy(*it->second));
+            } else {
+                supportedIndices.push_back(ix);
+            }
         } else if (mLocalParams.count(ix)) {
             // query local parameter here
             auto it = mCurrentConfig.find(ix);
@@ -1959,9 +1979,12 @@ status_t CCodecConfig::getConfigUpdateFromSdkParams(
         }
     }
 
-    c2_status_t err = configurable->query({ }, supportedIndices, blocking, configUpdate);
-    if (err != C2_OK) {
-        ALOGD("query failed after returning %zu params => %s", configUpdate->size(), asString(err));
+    if (!supportedIndices.empty()) {
+        c2_status_t err = configurable->query({ }, supportedIndices, blocking, configUpdate);
+        if (err != C2_OK) {
+            ALOGD("query failed after returning %zu params => %s",
+                    configUpdate->size(), asString(err));
+        }
     }
 
     if (configUpdate->size()) {
@@ -2027,12 +2050,25 @@ status_t CCodecConfig::setParameters(
         }
     }
 
-    // Re-query parameter values in case config could not update them and update the current
-    // configuration.
-    configUpdate.clear();
-    err = configurable->query({}, indices, blocking, &configUpdate);
-    if (err != C2_OK) {
-        ALOGD("query failed after returning %zu params => %s", configUpdate.size(), asString(err));
+    if (err == C2_OK && failures.empty()) {
+        // config() returns the values the component settled on in place, so there is no need
+        // to query them again. Drop local parameters as those have been handled above.
+        std::vector<std::unique_ptr<C2Param>> componentParams;
+        for (std::unique_ptr<C2Param> &param : configUpdate) {
+            if (mSupportedIndices.count(param->index())) {
+                componentParams.push_back(std::move(param));
+            }
+        }
+        configUpdate = std::move(componentParams);
+    } else {
+        // Re-query parameter values in case config could not update them and update the
+        // current configuration.
+        configUpdate.clear();
+        err = configurable->query({}, indices, blocking, &configUpdate);
+        if (err != C2_OK) {
+            ALOGD("query failed after returning %zu params => %s",
+                    configUpdate.size(), asString(err));
+        }
     }
     (void)updateConfiguration(configUpdate, ALL);
 
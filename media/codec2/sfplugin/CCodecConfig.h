@@ -116,6 +116,7 @@ struct CCodecConfig {
     std::set<C2Param::Index> mSupportedIndices; ///< indices supported by the component
     std::set<C2Param::Index> mSubscribedIndices; ///< indices to subscribe to
     size_t mSubscribedIndicesSize; ///< count of currently subscribed indices
+    bool mConfigUpdatesSubscribed; ///< whether the component accepted the subscription
 
     sp<AMessage> mInputFormat;
     sp<AMessage> mOutputFormat;
@@ -17,6 +17,8 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "FrameReassembler"
 
+#include <algorithm>
+
 #include <log/log.h>
 
 #include <media/stagefright/foundation/AMessage.h>
@@ -26,13 +28,18 @@
 namespace android {
 
 static constexpr uint64_t kToleranceUs = 1000;  // 1ms
+// Frames are packed into blocks of up to this many frames and bytes, so that a block does not
+// need to be fetched and mapped for every frame.
+static constexpr size_t kMaxFramesPerBlock = 4;
+static constexpr size_t kMaxBlockSize = 32768;
 
 FrameReassembler::FrameReassembler()
     : mUsage{0, 0},
       mSampleRate(0u),
       mChannelCount(0u),
       mEncoding(C2Config::PCM_16),
-      mCurrentOrdinal({0, 0, 0}) {
+      mCurrentOrdinal({0, 0, 0}),
+      mFrameOffset(0u) {
 }
 
 void FrameReassembler::init(
@@ -51,22 +58,26 @@ void FrameReassembler::init(
 }
 
 void FrameReassembler::updateFrameSize(uint32_t frameSize) {
-    finishCurrentBlock(&mPendingWork);
+    finishCurrentFrame(&mPendingWork);
+    releaseBlock();
     mFrameSize = frameSize;
 }
 
 void FrameReassembler::updateSampleRate(uint32_t sampleRate) {
-    finishCurrentBlock(&mPendingWork);
+    finishCurrentFrame(&mPendingWork);
+    releaseBlock();
     mSampleRate = sampleRate;
 }
 
 void FrameReassembler::updateChannelCount(uint32_t channelCount) {
-    finishCurrentBlock(&mPendingWork);
+    finishCurrentFrame(&mPendingWork);
+    releaseBlock();
     mChannelCount = channelCount;
 }
 
 void FrameReassembler::updatePcmEncoding(C2Config::pcm_encoding_t encoding) {
-    finishCurrentBlock(&mPendingWork);
+    finishCurrentFrame(&mPendingWork);
+    releaseBlock();
     mEncoding = encoding;
 }
 
@@ -94,11 +105,13 @@ c2_status_t FrameReassembler::process(
 
     items->splice(items->end(), mPendingWork);
 
-    // Fill mCurrentBlock
-    if (mCurrentBlock) {
+    const size_t frameBytes = frameSizeBytes();
+
+    // Fill the current frame
+    if (currentFrameBytes() > 0) {
         // First check the timestamp
         c2_cntr64_t endTimestampUs = mCurrentOrdinal.timestamp;
-        endTimestampUs += bytesToSamples(mWriteView->size()) * 1000000 / mSampleRate;
+        endTimestampUs += bytesToSamples(currentFrameBytes()) * 1000000 / mSampleRate;
         if (timeUs < endTimestampUs.peek()) {
             uint64_t diffUs = (endTimestampUs - timeUs).peeku();
             if (diffUs > kToleranceUs) {
@@ -113,29 +126,26 @@ c2_status_t FrameReassembler::process(
                 // The timestamp is going forward; add silence as necessary.
                 size_t gapSamples = usToSamples(diffUs);
                 size_t remainingSamples =
-                    (mWriteView->capacity() - mWriteView->size())
-                    / mChannelCount / bytesPerSample();
+                    (frameBytes - currentFrameBytes()) / mChannelCount / bytesPerSample();
                 if (gapSamples < remainingSamples) {
                     size_t gapBytes = gapSamples * mChannelCount * bytesPerSample();
                     memset(mWriteView->base() + mWriteView->size(), 0u, gapBytes);
                     mWriteView->setSize(mWriteView->size() + gapBytes);
                 } else {
-                    finishCurrentBlock(items);
+                    finishCurrentFrame(items);
                 }
             }
         }
     }
 
-    if (mCurrentBlock) {
-        // Append the data at the end of the current block
-        size_t copySize = std::min(
-                buffer->size(),
-                size_t(mWriteView->capacity() - mWriteView->size()));
+    if (currentFrameBytes() > 0) {
+        // Append the data at the end of the current frame
+        size_t copySize = std::min(buffer->size(), frameBytes - currentFrameBytes());
         memcpy(mWriteView->base() + mWriteView->size(), buffer->data(), copySize);
         buffer->setRange(buffer->offset() + copySize, buffer->size() - copySize);
         mWriteView->setSize(mWriteView->size() + copySize);
-        if (mWriteView->size() == mWriteView->capacity()) {
-            finishCurrentBlock(items);
+        if (currentFrameBytes() == frameBytes) {
+            finishCurrentFrame(items);
         }
         timeUs += bytesToSamples(copySize) * 1000000 / mSampleRate;
     }
@@ -145,35 +155,31 @@ c2_status_t FrameReassembler::process(
         mCurrentOrdinal.customOrdinal = timeUs;
     }
 
-    size_t frameSizeBytes = mFrameSize.value() * mChannelCount * bytesPerSample();
     while (buffer->size() > 0) {
         LOG_ALWAYS_FATAL_IF(
-                mCurrentBlock,
-                "There's remaining data but the pending block is not filled & finished");
-        std::unique_ptr<C2Work> work(new C2Work);
-        c2_status_t err = mBlockPool->fetchLinearBlock(frameSizeBytes, mUsage, &mCurrentBlock);
-        if (err != C2_OK) {
-            return err;
-        }
-        size_t copySize = std::min(buffer->size(), frameSizeBytes);
-        mWriteView = mCurrentBlock->map().get();
-        if (mWriteView->error() != C2_OK) {
-            return mWriteView->error();
+                currentFrameBytes() > 0,
+                "There's remaining data but the pending frame is not filled & finished");
+        if (!mCurrentBlock) {
+            c2_status_t err = fetchBlock();
+            if (err != C2_OK) {
+                return err;
+            }
         }
-        ALOGV("buffer={offset=%zu size=%zu} copySize=%zu",
-                buffer->offset(), buffer->size(), copySize);
-        memcpy(mWriteView->base(), buffer->data(), copySize);
-        mWriteView->setOffset(0u);
-        mWriteView->setSize(copySize);
+        size_t copySize = std::min(buffer->size(), frameBytes);
+        ALOGV("buffer={offset=%zu size=%zu} copySize=%zu frameOffset=%zu",
+                buffer->offset(), buffer->size(), copySize, mFrameOffset);
+        memcpy(mWriteView->base() + mFrameOffset, buffer->data(), copySize);
+        mWriteView->setSize(mFrameOffset + copySize);
         buffer->setRange(buffer->offset() + copySize, buffer->size() - copySize);
-        if (copySize == frameSizeBytes) {
-            finishCurrentBlock(items);
+        if (copySize == frameBytes) {
+            finishCurrentFrame(items);
         }
     }
 
     int32_t eos = 0;
     if (buffer->meta()->findInt32("eos", &eos) && eos) {
-        finishCurrentBlock(items);
+        finishCurrentFrame(items);
+        releaseBlock();
     }
 
     return C2_OK;
@@ -181,8 +187,7 @@ c2_status_t FrameReassembler::process(
 
 void FrameReassembler::flush() {
     mPendingWork.clear();
-    mWriteView.reset();
-    mCurrentBlock.reset();
+    releaseBlock();
 }
 
 uint64_t FrameReassembler::bytesToSamples(size_t numBytes) const {
@@ -199,20 +204,54 @@ uint32_t FrameReassembler::bytesPerSample() const {
          : (mEncoding == C2Config::PCM_FLOAT) ? 4 : 0;
 }
 
-void FrameReassembler::finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *items) {
-    if (!mCurrentBlock) {
+size_t FrameReassembler::frameSizeBytes() const {
+    return mFrameSize.value() * mChannelCount * bytesPerSample();
+}
+
+size_t FrameReassembler::currentFrameBytes() const {
+    return mCurrentBlock ? mWriteView->size() - mFrameOffset : 0u;
+}
+
+c2_status_t FrameReassembler::fetchBlock() {
+    const size_t frameBytes = frameSizeBytes();
+    size_t framesPerBlock = std::clamp(kMaxBlockSize / frameBytes, size_t(1), kMaxFramesPerBlock);
+    c2_status_t err = mBlockPool->fetchLinearBlock(
+            frameBytes * framesPerBlock, mUsage, &mCurrentBlock);
+    if (err != C2_OK) {
+        return err;
+    }
+    mWriteView = mCurrentBlock->map().get();
+    if (mWriteView->error() != C2_OK) {
+        err = mWriteView->error();
+        releaseBlock();
+        return err;
+    }
+    mWriteView->setOffset(0u);
+    mWriteView->setSize(0u);
+    mFrameOffset = 0u;
+    return C2_OK;
+}
+
+void FrameReassembler::releaseBlock() {
+    mWriteView.reset();
+    mCurrentBlock.reset();
+    mFrameOffset = 0u;
+}
+
+void FrameReassembler::finishCurrentFrame(std::list<std::unique_ptr<C2Work>> *items) {
+    if (currentFrameBytes() == 0) {
         // No-op
         return;
     }
-    if (mWriteView->size() < mWriteView->capacity()) {
-        memset(mWriteView->base() + mWriteView->size(), 0u,
-                mWriteView->capacity() - mWriteView->size());
-        mWriteView->setSize(mWriteView->capacity());
+    const size_t frameBytes = frameSizeBytes();
+    if (currentFrameBytes() < frameBytes) {
+        memset(mWriteView->base() + mWriteView->size(), 0u, frameBytes - currentFrameBytes());
+        mWriteView->setSize(mFrameOffset + frameBytes);
     }
     std::unique_ptr<C2Work> work{std::make_unique<C2Work>()};
     work->input.ordinal = mCurrentOrdinal;
     work->input.buffers.push_back(C2Buffer::CreateLinearBuffer(
-            mCurrentBlock->share(0, mCurrentBlock->capacity(), C2Fence())));
+            mCurrentBlock->share(mFrameOffset, frameBytes, C2Fence())));
     work->worklets.clear();
     work->worklets.emplace_back(new C2Worklet);
     items->push_back(std::move(work));
@@ -220,8 +259,12 @@ void FrameReassembler::finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *it
     ++mCurrentOrdinal.frameIndex;
     mCurrentOrdinal.timestamp += mFrameSize.value() * 1000000 / mSampleRate;
     mCurrentOrdinal.customOrdinal = mCurrentOrdinal.timestamp;
-    mCurrentBlock.reset();
-    mWriteView.reset();
+
+    // Keep the block for the next frame if it has room for one.
+    mFrameOffset += frameBytes;
+    if (mFrameOffset + frameBytes > mWriteView->capacity()) {
+        releaseBlock();
+    }
 }
 
 }  // namespace android
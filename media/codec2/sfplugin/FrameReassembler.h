@@ -60,14 +60,24 @@ private:
     C2Config::pcm_encoding_t mEncoding;
     std::list<std::unique_ptr<C2Work>> mPendingWork;
     C2WorkOrdinalStruct mCurrentOrdinal;
+    // Block holding several frames. Finished frames are shared with the encoder as separate
+    // ranges of the block, and the current frame starts at mFrameOffset.
     std::shared_ptr<C2LinearBlock> mCurrentBlock;
     std::optional<C2WriteView> mWriteView;
+    size_t mFrameOffset;
 
     uint64_t bytesToSamples(size_t numBytes) const;
     size_t usToSamples(uint64_t us) const;
     uint32_t bytesPerSample() const;
+    size_t frameSizeBytes() const;
 
-    void finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *items);
+    // Returns the number of bytes in the current, unfinished frame.
+    size_t currentFrameBytes() const;
+    c2_status_t fetchBlock();
+    void releaseBlock();
+
+    // Pads the current frame if necessary and queues it as a work.
+    void finishCurrentFrame(std::list<std::unique_ptr<C2Work>> *items);
 };
 
 }  // namespace android
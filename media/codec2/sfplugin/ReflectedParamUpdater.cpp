@@ -256,16 +256,12 @@ void ReflectedParamUpdater::getParamIndicesForKeys(
     vec->clear();
     std::set<C2Param::Index> indices;
 
-    std::set<std::string> keyMap(keys.begin(), keys.end());
-
     ALOGV("in getParamIndicesForKeys with %zu keys and map of %zu entries",
-            keyMap.size(), mMap.size());
-    for (const std::pair<const std::string, FieldDesc> &kv : mMap) {
-        const std::string &name = kv.first;
-        const FieldDesc &desc = kv.second;
-        ALOGV("count of %s is %zu", name.c_str(), keyMap.count(name));
-        if (keyMap.count(name) > 0) {
-            indices.insert(desc.paramDesc->index());
+            keys.size(), mMap.size());
+    for (const std::string &key : keys) {
+        auto it = mMap.find(key);
+        if (it != mMap.end()) {
+            indices.insert(it->second.paramDesc->index());
         }
     }
 
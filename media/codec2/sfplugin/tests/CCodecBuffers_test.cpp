@@ -914,4 +914,43 @@ TEST(LinearOutputBuffersTest, PcmConvertFormat) {
     ASSERT_TRUE(buffers->releaseBuffer(clientBuffer, &c2Buffer));
 }
 
+TEST(LinearInputBuffersTest, ZeroCopyHandOff) {
+    std::shared_ptr<LinearInputBuffers> buffers =
+        std::make_shared<LinearInputBuffers>("test");
+    sp<AMessage> format{new AMessage};
+    format->setInt32(KEY_MAX_INPUT_SIZE, 1024);
+    buffers->setFormat(format);
+
+    std::shared_ptr<C2BlockPool> pool;
+    ASSERT_EQ(OK, GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool));
+    buffers->setPool(pool);
+
+    size_t index;
+    sp<MediaCodecBuffer> clientBuffer;
+    ASSERT_TRUE(buffers->requestNewBuffer(&index, &clientBuffer));
+    ASSERT_NE(nullptr, clientBuffer);
+    memset(clientBuffer->base(), 0xa5, 16);
+    clientBuffer->setRange(0, 16);
+
+    // Disabled by default; the caller falls back to cloneAndReleaseBuffer().
+    EXPECT_EQ(nullptr, buffers->handOffAndReleaseBuffer(clientBuffer));
+
+    buffers->setZeroCopyHandOff(true);
+    std::shared_ptr<C2Buffer> c2Buffer;
+    ASSERT_TRUE(buffers->releaseBuffer(clientBuffer, &c2Buffer, false));
+    sp<Codec2Buffer> handedOff = buffers->handOffAndReleaseBuffer(clientBuffer);
+    ASSERT_EQ(clientBuffer.get(), handedOff.get());
+    EXPECT_EQ(0u, buffers->numClientBuffers());
+
+    // The component reads the block the client wrote into.
+    ASSERT_EQ(1u, c2Buffer->data().linearBlocks().size());
+    C2ReadView view = c2Buffer->data().linearBlocks().front().map().get();
+    ASSERT_EQ(C2_OK, view.error());
+    ASSERT_EQ(16u, view.capacity());
+    EXPECT_EQ(0, memcmp(clientBuffer->base(), view.data(), 16));
+
+    // The buffer is no longer on file.
+    EXPECT_EQ(nullptr, buffers->handOffAndReleaseBuffer(clientBuffer));
+}
+
 } // namespace android
@@ -18,6 +18,9 @@
 #define LOG_TAG "C2Buffer"
 #include <utils/Log.h>
 
+#include <cutils/properties.h>
+
+#include <algorithm>
 #include <list>
 #include <map>
 #include <mutex>
@@ -662,12 +665,40 @@ c2_status_t _C2BufferPoolAllocator::priorGraphicAllocation(
     return mAllocator->priorGraphicAllocation(handle, c2Allocation);
 }
 
+namespace {
+
+// Linear allocations up to this size may be rounded up to a size class.
+constexpr uint32_t kMaxLinearSizeClass = 16 * 1024 * 1024;
+constexpr uint32_t kMinLinearSizeClass = 4096;
+
+/**
+ * Rounds |capacity| up to a size class so that linear blocks of varying sizes can be recycled.
+ * Each power of two range is divided into |stepsPerPowerOfTwo| classes, so 1 selects pure
+ * power of two classes. Capacities above kMaxLinearSizeClass are not rounded.
+ */
+uint32_t getLinearSizeClass(uint32_t capacity, uint32_t stepsPerPowerOfTwo) {
+    if (stepsPerPowerOfTwo == 0 || capacity > kMaxLinearSizeClass) {
+        return capacity;
+    }
+    if (capacity <= kMinLinearSizeClass) {
+        return kMinLinearSizeClass;
+    }
+    // upper / 2 < capacity <= upper
+    const uint32_t upper = 1u << (32 - __builtin_clz(capacity - 1));
+    const uint32_t step = std::max(upper / 2 / stepsPerPowerOfTwo, 1u);
+    return (capacity + step - 1) / step * step;
+}
+
+}  // namespace
+
 class C2PooledBlockPool::Impl {
 public:
     Impl(const std::shared_ptr<C2Allocator> &allocator)
             : mInit(C2_OK),
               mBufferPoolManager(ClientManager::getInstance()),
-              mAllocator(std::make_shared<_C2BufferPoolAllocator>(allocator)) {
+              mAllocator(std::make_shared<_C2BufferPoolAllocator>(allocator)),
+              mLinearSizeClassSteps(
+                      std::max(property_get_int32("debug.c2.pooled_linear_size_classes", 0), 0)) {
         if (mAllocator && mBufferPoolManager) {
             if (mBufferPoolManager->create(
                     mAllocator, &mConnectionId) == ResultStatus::OK) {
@@ -691,7 +722,9 @@ public:
             return mInit;
         }
         std::vector<uint8_t> params;
-        mAllocator->getLinearParams(capacity, usage, &params);
+        // The block keeps the requested capacity even when the allocation is larger.
+        mAllocator->getLinearParams(
+                getLinearSizeClass(capacity, mLinearSizeClassSteps), usage, &params);
         std::shared_ptr<BufferPoolData> bufferPoolData;
         native_handle_t *cHandle = nullptr;
         ResultStatus status = mBufferPoolManager->allocate(
@@ -759,6 +792,8 @@ private:
     const android::sp<ClientManager> mBufferPoolManager;
     ConnectionId mConnectionId; // locally
     const std::shared_ptr<_C2BufferPoolAllocator> mAllocator;
+    // size classes per power of two for linear allocations, or 0 for exact sizes
+    const uint32_t mLinearSizeClassSteps;
 };
 
 C2PooledBlockPool::C2PooledBlockPool(
@@ -23,12 +23,18 @@
 #include <C2DmaBufAllocator.h>
 #include <C2ErrnoUtils.h>
 
+#include <linux/dma-buf.h>
 #include <linux/ion.h>
+#include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>  // getpagesize, size_t, close, dup
 #include <utils/Log.h>
 
 #include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 
 #include <android-base/properties.h>
 #include <media/stagefright/foundation/Mutexed.h>
@@ -99,6 +105,103 @@ bool C2HandleBuf::IsValid(const C2Handle* const o) {
     return other->mInts.mMagic == kMagic;
 }
 
+/* =========================== MAPPING CACHE =========================== */
+/**
+ * CPU mappings of a whole dmabuf that stay alive while any allocation of the buffer exists.
+ *
+ * Buffer pools keep the original allocation of a recycled buffer and hand out new allocations
+ * wrapping its handle, so the allocations of a dmabuf share one cache, found by the inode of the
+ * dmabuf. This saves a mmap/munmap pair per map() of a recycled buffer. CPU access is bracketed
+ * with DMA_BUF_IOCTL_SYNC by the allocations instead.
+ */
+class C2DmaBufMappingCache {
+   public:
+    /**
+     * Returns the cache of the dmabuf, or nullptr if the dmabuf cannot be identified.
+     */
+    static std::shared_ptr<C2DmaBufMappingCache> Get(int fd);
+
+    ~C2DmaBufMappingCache();
+
+    /**
+     * Returns a mapping of the whole dmabuf with |prot|, creating it if needed.
+     */
+    void* map(int fd, int prot);
+
+    size_t size() const { return mSize; }
+
+   private:
+    C2DmaBufMappingCache(ino_t ino, size_t size) : mIno(ino), mSize(size) {}
+
+    const ino_t mIno;
+    const size_t mSize;
+    std::mutex mLock;
+    std::map<int, void*> mMappings;  // prot => base
+
+    static std::mutex sLock;
+    static std::map<ino_t, std::weak_ptr<C2DmaBufMappingCache>> sCaches;
+};
+
+std::mutex C2DmaBufMappingCache::sLock;
+std::map<ino_t, std::weak_ptr<C2DmaBufMappingCache>> C2DmaBufMappingCache::sCaches;
+
+// static
+std::shared_ptr<C2DmaBufMappingCache> C2DmaBufMappingCache::Get(int fd) {
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(sLock);
+    std::weak_ptr<C2DmaBufMappingCache>& entry = sCaches[st.st_ino];
+    std::shared_ptr<C2DmaBufMappingCache> cache = entry.lock();
+    if (!cache) {
+        cache.reset(new C2DmaBufMappingCache(st.st_ino, st.st_size));
+        entry = cache;
+    }
+    return cache;
+}
+
+C2DmaBufMappingCache::~C2DmaBufMappingCache() {
+    for (const auto& [prot, base] : mMappings) {
+        if (munmap(base, mSize)) ALOGD("munmap failed");
+    }
+    std::lock_guard<std::mutex> lock(sLock);
+    auto it = sCaches.find(mIno);
+    // the entry may already belong to a new cache of a reused inode
+    if (it != sCaches.end() && it->second.expired()) {
+        sCaches.erase(it);
+    }
+}
+
+void* C2DmaBufMappingCache::map(int fd, int prot) {
+    std::lock_guard<std::mutex> lock(mLock);
+    auto it = mMappings.find(prot);
+    if (it != mMappings.end()) {
+        return it->second;
+    }
+    void* base = mmap(nullptr, mSize, prot, MAP_SHARED, fd, 0);
+    ALOGV("cached mmap(size = %zu, prot = %d, mapFd = %d) returned (%d)", mSize, prot, fd, errno);
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+    mMappings.emplace(prot, base);
+    return base;
+}
+
+static void syncDmaBuf(int fd, int prot, uint64_t startOrEnd) {
+    struct dma_buf_sync sync = {.flags = startOrEnd};
+    if (prot & PROT_READ) sync.flags |= DMA_BUF_SYNC_READ;
+    if (prot & PROT_WRITE) sync.flags |= DMA_BUF_SYNC_WRITE;
+    if (ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync)) {
+        ALOGV("DMA_BUF_IOCTL_SYNC failed (%d)", errno);
+    }
+}
+
+static bool useMappingCache() {
+    static bool sUseMappingCache = base::GetBoolProperty("media.c2.dmabuf.mapping_cache", false);
+    return sUseMappingCache;
+}
+
 /* =========================== DMABUF ALLOCATION =========================== */
 class C2DmaBufAllocation : public C2LinearAllocation {
    public:
@@ -161,8 +264,11 @@ class C2DmaBufAllocation : public C2LinearAllocation {
         void* addr;
         size_t alignmentBytes;
         size_t size;
+        int prot;
+        bool cached;  // part of mMappingCache, only synced on unmap
     };
     Mutexed<std::list<Mapping>> mMappings;
+    std::shared_ptr<C2DmaBufMappingCache> mMappingCache;
 
     // TODO: we could make this encapsulate shared_ptr and copiable
     C2_DO_NOT_COPY(C2DmaBufAllocation);
@@ -192,10 +298,21 @@ c2_status_t C2DmaBufAllocation::map(size_t offset, size_t size, C2MemoryUsage us
         prot |= PROT_WRITE;
     }
 
+    if (mMappingCache && offset <= mMappingCache->size() &&
+            size <= mMappingCache->size() - offset) {
+        void* base = mMappingCache->map(mHandle.bufferFd(), prot);
+        if (base) {
+            syncDmaBuf(mHandle.bufferFd(), prot, DMA_BUF_SYNC_START);
+            *addr = (uint8_t*)base + offset;
+            mMappings.lock()->push_back({*addr, 0, size, prot, true});
+            return C2_OK;
+        }
+    }
+
     size_t alignmentBytes = offset % PAGE_SIZE;
     size_t mapOffset = offset - alignmentBytes;
     size_t mapSize = size + alignmentBytes;
-    Mapping map = {nullptr, alignmentBytes, mapSize};
+    Mapping map = {nullptr, alignmentBytes, mapSize, prot, false};
 
     c2_status_t err =
             mapInternal(mapSize, mapOffset, alignmentBytes, prot, flags, &(map.addr), addr);
@@ -216,8 +333,9 @@ c2_status_t C2DmaBufAllocation::unmap(void* addr, size_t size, C2Fence* fence) {
             size + it->alignmentBytes != it->size) {
             continue;
         }
-        int err = munmap(it->addr, it->size);
-        if (err != 0) {
+        if (it->cached) {
+            syncDmaBuf(mHandle.bufferFd(), it->prot, DMA_BUF_SYNC_END);
+        } else if (munmap(it->addr, it->size) != 0) {
             ALOGD("munmap failed");
             return c2_map_errno<EINVAL>(errno);
         }
@@ -259,6 +377,10 @@ C2DmaBufAllocation::~C2DmaBufAllocation() {
     if (!mappings->empty()) {
         ALOGD("Dangling mappings!");
         for (const Mapping& map : *mappings) {
+            if (map.cached) {
+                syncDmaBuf(mHandle.bufferFd(), map.prot, DMA_BUF_SYNC_END);
+                continue;
+            }
             int err = munmap(map.addr, map.size);
             if (err) ALOGD("munmap failed");
         }
@@ -283,6 +405,9 @@ C2DmaBufAllocation::C2DmaBufAllocation(BufferAllocator& alloc, size_t allocSize,
     mHandle = C2HandleBuf(bufferFd, capacity);
     mId = id;
     mInit = c2_status_t(c2_map_errno<ENOMEM, EACCES, EINVAL>(ret));
+    if (mInit == C2_OK && useMappingCache()) {
+        mMappingCache = C2DmaBufMappingCache::Get(bufferFd);
+    }
 }
 
 C2DmaBufAllocation::C2DmaBufAllocation(size_t size, int shareFd, C2Allocator::id_t id)
@@ -290,6 +415,9 @@ C2DmaBufAllocation::C2DmaBufAllocation(size_t size, int shareFd, C2Allocator::id
     mHandle = C2HandleBuf(shareFd, size);
     mId = id;
     mInit = c2_status_t(c2_map_errno<ENOMEM, EACCES, EINVAL>(0));
+    if (useMappingCache()) {
+        mMappingCache = C2DmaBufMappingCache::Get(shareFd);
+    }
 }
 
 /* =========================== DMABUF ALLOCATOR =========================== */
@@ -34,9 +34,14 @@
 #include <dlfcn.h>
 #include <unistd.h> // getpagesize
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <thread>
 
 #ifdef __ANDROID_APEX__
 #include <android-base/properties.h>
@@ -742,6 +747,8 @@ private:
          * \note Only used by ComponentLoader.
          *
          * \param libPath[in] library path
+         * \param traits[in]  traits from an earlier load of the same library, if any. When set,
+         *                    no interface is created to discover the traits.
          *
          * \retval C2_OK        the component module has been successfully loaded
          * \retval C2_NO_MEMORY not enough memory to loading the component module
@@ -750,7 +757,8 @@ private:
          * \retval C2_REFUSED   permission denied to load the component module (unexpected)
          * \retval C2_TIMED_OUT could not load the module within the time limit (unexpected)
          */
-        c2_status_t init(std::string libPath);
+        c2_status_t init(std::string libPath,
+                         const std::shared_ptr<C2Component::Traits> &traits = nullptr);
 
         virtual ~ComponentModule() override;
 
@@ -799,9 +807,13 @@ private:
                 } else {
                     localModule = std::make_shared<ComponentModule>();
                 }
-                res = localModule->init(mLibPath);
+                res = localModule->init(mLibPath, mTraits);
                 if (res == C2_OK) {
                     mModule = localModule;
+                    // Modules are unloaded when the last reference goes away; keep the traits
+                    // so that reloading does not need to create an interface again.
+                    mTraits = std::const_pointer_cast<C2Component::Traits>(
+                            localModule->getTraits());
                 }
             }
             *module = localModule;
@@ -825,6 +837,7 @@ private:
     private:
         std::mutex mMutex; ///< mutex guarding the module
         std::weak_ptr<ComponentModule> mModule; ///< weak reference to the loaded module
+        std::shared_ptr<C2Component::Traits> mTraits; ///< traits of the last loaded module
         std::string mLibPath; ///< library path
 
         // For testing only
@@ -937,6 +950,53 @@ private:
      */
     void visitComponents();
 
+    /**
+     * A small pool of freshly created components that have never been used.
+     *
+     * Creating a software component can take a noticeable amount of time (e.g. allocating the
+     * codec library's internal state), which directly adds to the codec start up latency. The
+     * pool keeps one ready-to-use component for each recently requested component name, and
+     * replaces it on a background thread after it has been handed out.
+     *
+     * Components are never returned to the pool after use, so a pooled component is always in
+     * the same state as one created on demand.
+     */
+    class ComponentPool {
+    public:
+        /**
+         * \param maxSize[in] maximum number of component names to keep a component for. The
+         *                    least recently requested name is evicted first. 0 disables the pool.
+         */
+        explicit ComponentPool(size_t maxSize);
+        ~ComponentPool();
+
+        /**
+         * Takes the pooled component for |name| if there is one, and schedules a new one to be
+         * created for the next request.
+         *
+         * \returns the pooled component, or nullptr if none is available.
+         */
+        std::shared_ptr<C2Component> take(
+                const C2String &name, const std::shared_ptr<ComponentModule> &module);
+
+    private:
+        struct Entry {
+            C2String name;
+            std::shared_ptr<ComponentModule> module;
+            std::shared_ptr<C2Component> component;
+            bool refill;
+        };
+
+        void refillLoop();
+
+        const size_t mMaxSize;
+        std::mutex mLock;
+        std::condition_variable mCondition;
+        std::list<Entry> mEntries; ///< most recently requested first
+        std::thread mThread;
+        bool mStopped;
+    };
+
     std::mutex mMutex; ///< mutex guarding the component lists during construction
     bool mVisited; ///< component modules visited
     std::map<C2String, ComponentLoader> mComponents; ///< path -> component module
@@ -950,10 +1010,13 @@ private:
     std::vector<std::tuple<C2String,
                           C2ComponentFactory::CreateCodec2FactoryFunc,
                           C2ComponentFactory::DestroyCodec2FactoryFunc>> mCodec2FactoryFuncs;
+
+    // Declared last so that pending refills finish before the modules are released.
+    ComponentPool mComponentPool;
 };
 
 c2_status_t C2PlatformComponentStore::ComponentModule::init(
-        std::string libPath) {
+        std::string libPath, const std::shared_ptr<C2Component::Traits> &cachedTraits) {
     ALOGV("in %s", __func__);
     ALOGV("loading dll");
 
@@ -985,6 +1048,11 @@ c2_status_t C2PlatformComponentStore::ComponentModule::init(
         return mInit;
     }
 
+    if (cachedTraits) {
+        mTraits = cachedTraits;
+        return mInit;
+    }
+
     std::shared_ptr<C2ComponentInterface> intf;
     c2_status_t res = createInterface(0, &intf);
     if (res != C2_OK) {
@@ -1063,10 +1131,96 @@ std::shared_ptr<const C2Component::Traits> C2PlatformComponentStore::ComponentMo
     return mTraits;
 }
 
+C2PlatformComponentStore::ComponentPool::ComponentPool(size_t maxSize)
+    : mMaxSize(maxSize),
+      mStopped(false) {
+}
+
+C2PlatformComponentStore::ComponentPool::~ComponentPool() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mStopped = true;
+    }
+    mCondition.notify_all();
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+std::shared_ptr<C2Component> C2PlatformComponentStore::ComponentPool::take(
+        const C2String &name, const std::shared_ptr<ComponentModule> &module) {
+    if (mMaxSize == 0) {
+        return nullptr;
+    }
+    std::shared_ptr<C2Component> component;
+    std::list<Entry> evicted; // destroyed outside of the lock
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = std::find_if(mEntries.begin(), mEntries.end(),
+                               [&name](const Entry &entry) { return entry.name == name; });
+        if (it == mEntries.end()) {
+            mEntries.push_front({name, module, nullptr, true});
+            while (mEntries.size() > mMaxSize) {
+                evicted.splice(evicted.end(), mEntries, std::prev(mEntries.end()));
+            }
+        } else {
+            component = std::move(it->component);
+            it->component.reset();
+            it->refill = true;
+            mEntries.splice(mEntries.begin(), mEntries, it);
+        }
+        if (!mThread.joinable()) {
+            mThread = std::thread(&ComponentPool::refillLoop, this);
+        }
+    }
+    mCondition.notify_one();
+    if (component) {
+        ALOGV("using pooled component %s", name.c_str());
+    }
+    return component;
+}
+
+void C2PlatformComponentStore::ComponentPool::refillLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+    while (!mStopped) {
+        auto it = std::find_if(mEntries.begin(), mEntries.end(),
+                               [](const Entry &entry) { return entry.refill; });
+        if (it == mEntries.end()) {
+            mCondition.wait(lock);
+            continue;
+        }
+        it->refill = false;
+        C2String name = it->name;
+        std::shared_ptr<ComponentModule> module = it->module;
+        lock.unlock();
+        std::shared_ptr<C2Component> component;
+        c2_status_t res = module->createComponent(0, &component);
+        lock.lock();
+        // The entry may have been evicted or taken again while the component was created.
+        it = std::find_if(mEntries.begin(), mEntries.end(),
+                          [&name](const Entry &entry) { return entry.name == name; });
+        if (res != C2_OK || !component) {
+            ALOGD("could not create pooled component %s: %d", name.c_str(), res);
+            if (it != mEntries.end() && !it->component) {
+                mEntries.erase(it);
+            }
+        } else if (it != mEntries.end() && !it->component) {
+            it->component = std::move(component);
+        }
+        if (component) {
+            // not needed anymore; destroy it outside of the lock
+            lock.unlock();
+            component.reset();
+            lock.lock();
+        }
+    }
+}
+
 C2PlatformComponentStore::C2PlatformComponentStore()
     : mVisited(false),
       mReflector(std::make_shared<C2ReflectorHelper>()),
-      mInterface(mReflector) {
+      mInterface(mReflector),
+      mComponentPool(std::max(property_get_int32("media.c2.component_pool_size", 2), 0)) {
 
     auto emplace = [this](const char *libPath) {
         mComponents.emplace(libPath, libPath);
@@ -1115,7 +1269,8 @@ C2PlatformComponentStore::C2PlatformComponentStore(
     : mVisited(false),
       mReflector(std::make_shared<C2ReflectorHelper>()),
       mInterface(mReflector),
-      mCodec2FactoryFuncs(funcs) {
+      mCodec2FactoryFuncs(funcs),
+      mComponentPool(0) {
 
     for(auto const& func: mCodec2FactoryFuncs) {
         mComponents.emplace(std::get<0>(func), func);
@@ -1147,11 +1302,37 @@ void C2PlatformComponentStore::visitComponents() {
     if (mVisited) {
         return;
     }
+
+    // Loading a module and creating its interface is independent for each library, so do it
+    // on a few threads. The list is still assembled in path order below.
+    std::vector<ComponentLoader *> loaders;
+    for (auto &pathAndLoader : mComponents) {
+        loaders.push_back(&pathAndLoader.second);
+    }
+    std::vector<std::shared_ptr<ComponentModule>> modules(loaders.size());
+    std::vector<c2_status_t> results(loaders.size(), C2_NO_INIT);
+    std::atomic_size_t next = 0;
+    auto fetch = [&loaders, &modules, &results, &next] {
+        for (size_t i = next++; i < loaders.size(); i = next++) {
+            results[i] = loaders[i]->fetchModule(&modules[i]);
+        }
+    };
+    size_t numThreads = std::min<size_t>(
+            loaders.size(), std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; ++i) {
+        threads.emplace_back(fetch);
+    }
+    fetch();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    size_t ix = 0;
     for (auto &pathAndLoader : mComponents) {
         const C2String &path = pathAndLoader.first;
-        ComponentLoader &loader = pathAndLoader.second;
-        std::shared_ptr<ComponentModule> module;
-        if (loader.fetchModule(&module) == C2_OK) {
+        const std::shared_ptr<ComponentModule> &module = modules[ix];
+        if (results[ix++] == C2_OK) {
             std::shared_ptr<const C2Component::Traits> traits = module->getTraits();
             if (traits) {
                 mComponentList.push_back(traits);
@@ -1190,6 +1371,10 @@ c2_status_t C2PlatformComponentStore::createComponent(
     std::shared_ptr<ComponentModule> module;
     c2_status_t res = findComponent(name, &module);
     if (res == C2_OK) {
+        *component = mComponentPool.take(name, module);
+        if (*component) {
+            return C2_OK;
+        }
         // TODO: get a unique node ID
         res = module->createComponent(0, component);
     }
@@ -574,6 +574,12 @@ void InitHTFM(VideoEncData *video, HTFM_Stat *htfm_stat, double *newvar, Int *co
         video->functionPointer->SAD_MB_HalfPel[1] = &SAD_MB_HP_HTFMxh;
         video->functionPointer->SAD_MB_HalfPel[2] = &SAD_MB_HP_HTFMyh;
         video->functionPointer->SAD_MB_HalfPel[3] = &SAD_MB_HP_HTFMxhyh;
+#if defined(__aarch64__)
+        video->functionPointer->SAD_Macroblock = &SAD_MB_HTFM_NEON;
+        video->functionPointer->SAD_MB_HalfPel[1] = &SAD_MB_HP_HTFM_NEONxh;
+        video->functionPointer->SAD_MB_HalfPel[2] = &SAD_MB_HP_HTFM_NEONyh;
+        video->functionPointer->SAD_MB_HalfPel[3] = &SAD_MB_HP_HTFM_NEONxhyh;
+#endif
         video->sad_extra_info = (void*)(video->nrmlz_th);
         offset = video->nrmlz_th + 16;
         offset2 = video->nrmlz_th + 32;
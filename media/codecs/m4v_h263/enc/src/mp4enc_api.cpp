@@ -1090,6 +1090,14 @@ OSCL_EXPORT_REF Bool    PVInitVideoEncoder(VideoEncControls *encoderControl, Vid
     video->functionPointer->ChooseMode = &ChooseMode_C;
     video->functionPointer->GetHalfPelMBRegion = &GetHalfPelMBRegion_C;
 //  video->functionPointer->SAD_MB_PADDING = &SAD_MB_PADDING; /* 4/21/01 */
+#if defined(__aarch64__)
+    /* NEON is part of the arm64 baseline, see sad_neon.cpp */
+    video->functionPointer->ComputeMBSum = &ComputeMBSum_NEON;
+    video->functionPointer->SAD_MB_HalfPel[1] = &SAD_MB_HalfPel_NEONxh;
+    video->functionPointer->SAD_MB_HalfPel[2] = &SAD_MB_HalfPel_NEONyh;
+    video->functionPointer->SAD_MB_HalfPel[3] = &SAD_MB_HalfPel_NEONxhyh;
+    video->functionPointer->SAD_Macroblock = &SAD_Macroblock_NEON;
+#endif
 
 
     encoderControl->videoEncoderInit = 1;  /* init done! */
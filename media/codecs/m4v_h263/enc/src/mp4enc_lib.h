@@ -130,6 +130,7 @@ extern "C"
     void ComputeMBSum_C(UChar *cur, Int lx, MOT *mot_mb);
     void ComputeMBSum_MMX(UChar *cur, Int lx, MOT *mot_mb);
     void ComputeMBSum_SSE(UChar *cur, Int lx, MOT *mot_mb);
+    void ComputeMBSum_NEON(UChar *cur, Int lx, MOT *mot_mb);
     void GetHalfPelMBRegionPadding(UChar *ncand, UChar *hmem, Int lx, Int *reptl);
     void GetHalfPelBlkRegionPadding(UChar *ncand, UChar *hmem, Int lx, Int *reptl);
 
@@ -166,6 +167,18 @@ extern "C"
     Int SAD_MB_HTFM_Collect(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
     Int SAD_MB_HTFM(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
 #endif
+
+    /* defined in sad_neon.cpp, arm64 only */
+    Int SAD_MB_HalfPel_NEONxhyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info);
+    Int SAD_MB_HalfPel_NEONyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info);
+    Int SAD_MB_HalfPel_NEONxh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info);
+    Int SAD_Macroblock_NEON(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+#ifdef HTFM
+    Int SAD_MB_HP_HTFM_NEONxhyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info);
+    Int SAD_MB_HP_HTFM_NEONyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info);
+    Int SAD_MB_HP_HTFM_NEONxh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info);
+    Int SAD_MB_HTFM_NEON(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+#endif
     /* on-the-fly padding */
     Int SAD_Blk_PADDING(UChar *ref, UChar *cur, Int dmin, Int lx, void *extra_info);
     Int SAD_MB_PADDING(UChar *ref, UChar *cur, Int dmin, Int lx, void *extra_info);
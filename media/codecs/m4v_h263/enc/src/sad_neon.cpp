@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * arm64 NEON versions of the motion estimation SAD functions in sad.cpp and
+ * sad_halfpel.cpp and of ComputeMBSum_C. They are installed in the FuncPtr
+ * table instead of the C versions on arm64 and give the same results,
+ * including the partial SAD returned on early termination.
+ */
+
+#include <arm_neon.h>
+
+#include "mp4def.h"
+#include "mp4enc_lib.h"
+#include "mp4lib_int.h"
+
+/*
+ * One HTFM stage covers the pixels at columns {c, c + 4, c + 8, c + 12} of
+ * rows {r, r + 4, r + 8, r + 12}, where offsetRef[i] = r * lx + c, in the
+ * order of the reordered current macroblock. kHtfmIndex[c] gathers those
+ * from the four rows of the macroblock, each loaded from column 0.
+ */
+static const uint8 kHtfmIndex[4][16] =
+{
+    {  0,  4,  8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60 },
+    {  1,  5,  9, 13, 17, 21, 25, 29, 33, 37, 41, 45, 49, 53, 57, 61 },
+    {  2,  6, 10, 14, 18, 22, 26, 30, 34, 38, 42, 46, 50, 54, 58, 62 },
+    {  3,  7, 11, 15, 19, 23, 27, 31, 35, 39, 43, 47, 51, 55, 59, 63 },
+};
+
+static inline uint8x16x4_t LoadRows4(const UChar *p, Int stride)
+{
+    uint8x16x4_t rows;
+    rows.val[0] = vld1q_u8(p);
+    rows.val[1] = vld1q_u8(p + stride);
+    rows.val[2] = vld1q_u8(p + 2 * stride);
+    rows.val[3] = vld1q_u8(p + 3 * stride);
+    return rows;
+}
+
+static inline Int SadRow(uint8x16_t pred, const UChar *blk)
+{
+    return vaddlvq_u8(vabdq_u8(pred, vld1q_u8(blk)));
+}
+
+/* (a + b + c + d + 2) >> 2 per byte */
+static inline uint8x16_t Avg4(uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d)
+{
+    uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(a), vget_low_u8(b)),
+                              vaddl_u8(vget_low_u8(c), vget_low_u8(d)));
+    uint16x8_t hi = vaddq_u16(vaddl_high_u8(a, b), vaddl_high_u8(c, d));
+    return vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2));
+}
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    Int SAD_Macroblock_NEON(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info)
+    {
+        Int dmin = (ULong)dmin_lx >> 16;
+        Int lx = dmin_lx & 0xFFFF;
+        Int sad = 0;
+
+        OSCL_UNUSED_ARG(extra_info);
+
+        for (Int i = 0; i < 16; i++)
+        {
+            sad += SadRow(vld1q_u8(ref), blk);
+            if (sad > dmin)
+                return sad;
+            ref += lx;
+            blk += 16;
+        }
+        return sad;
+    }
+
+    Int SAD_MB_HalfPel_NEONxhyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        Int dmin = (Int)((ULong)dmin_rx >> 16);
+        Int rx = dmin_rx & 0xFFFF;
+        Int sad = 0;
+
+        OSCL_UNUSED_ARG(extra_info);
+
+        uint8x16_t top = vld1q_u8(ref);
+        uint8x16_t top1 = vld1q_u8(ref + 1);
+        for (Int i = 0; i < 16; i++)
+        {
+            ref += rx;
+            uint8x16_t bottom = vld1q_u8(ref);
+            uint8x16_t bottom1 = vld1q_u8(ref + 1);
+            sad += SadRow(Avg4(top, top1, bottom, bottom1), blk);
+            if (sad > dmin)
+                return sad;
+            top = bottom;
+            top1 = bottom1;
+            blk += 16;
+        }
+        return sad;
+    }
+
+    Int SAD_MB_HalfPel_NEONyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        Int dmin = (Int)((ULong)dmin_rx >> 16);
+        Int rx = dmin_rx & 0xFFFF;
+        Int sad = 0;
+
+        OSCL_UNUSED_ARG(extra_info);
+
+        uint8x16_t top = vld1q_u8(ref);
+        for (Int i = 0; i < 16; i++)
+        {
+            ref += rx;
+            uint8x16_t bottom = vld1q_u8(ref);
+            sad += SadRow(vrhaddq_u8(top, bottom), blk);
+            if (sad > dmin)
+                return sad;
+            top = bottom;
+            blk += 16;
+        }
+        return sad;
+    }
+
+    Int SAD_MB_HalfPel_NEONxh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        Int dmin = (Int)((ULong)dmin_rx >> 16);
+        Int rx = dmin_rx & 0xFFFF;
+        Int sad = 0;
+
+        OSCL_UNUSED_ARG(extra_info);
+
+        for (Int i = 0; i < 16; i++)
+        {
+            sad += SadRow(vrhaddq_u8(vld1q_u8(ref), vld1q_u8(ref + 1)), blk);
+            if (sad > dmin)
+                return sad;
+            ref += rx;
+            blk += 16;
+        }
+        return sad;
+    }
+
+#ifdef HTFM
+    /* The thresholds are checked after each stage as in SAD_MB_HTFM. */
+    Int SAD_MB_HTFM_NEON(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info)
+    {
+        Int sad = 0;
+        Int lx = dmin_lx & 0xFFFF;
+        Int lx4 = lx << 2;
+        Int sadstar = 0, madstar;
+        Int *nrmlz_th = (Int*) extra_info;
+        Int *offsetRef = (Int*) extra_info + 32;
+
+        if (lx & 3)
+        {
+            /* the gather below relies on the stage offsets keeping their column */
+            return SAD_MB_HTFM(ref, blk, dmin_lx, extra_info);
+        }
+
+        madstar = (ULong)dmin_lx >> 20;
+
+        for (Int i = 0; i < 16; i++)
+        {
+            Int col = offsetRef[i] & 3;
+            const UChar *p1 = ref + offsetRef[i] - col;
+            uint8x16_t pred = vqtbl4q_u8(LoadRows4(p1, lx4), vld1q_u8(kHtfmIndex[col]));
+
+            sad += SadRow(pred, blk);
+            blk += 16;
+
+            sadstar += madstar;
+            if (((ULong)sad <= ((ULong)dmin_lx >> 16)) && (sad <= (sadstar - *nrmlz_th++)))
+                ;
+            else
+                return 65536;
+        }
+
+        return sad;
+    }
+
+    Int SAD_MB_HP_HTFM_NEONxhyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        Int sad = 0;
+        Int rx = dmin_rx & 0xFFFF;
+        Int refwx4 = rx << 2;
+        Int sadstar = 0, madstar;
+        Int *nrmlz_th = (Int*) extra_info;
+        Int *offsetRef = nrmlz_th + 32;
+
+        if (rx & 3)
+        {
+            return SAD_MB_HP_HTFMxhyh(ref, blk, dmin_rx, extra_info);
+        }
+
+        madstar = (ULong)dmin_rx >> 20;
+
+        for (Int i = 0; i < 16; i++) /* 16 stages */
+        {
+            Int col = offsetRef[i] & 3;
+            const UChar *p1 = ref + offsetRef[i] - col;
+            const UChar *p2 = p1 + rx;
+            uint8x16_t index = vld1q_u8(kHtfmIndex[col]);
+            uint8x16_t pred = Avg4(vqtbl4q_u8(LoadRows4(p1, refwx4), index),
+                                   vqtbl4q_u8(LoadRows4(p1 + 1, refwx4), index),
+                                   vqtbl4q_u8(LoadRows4(p2, refwx4), index),
+                                   vqtbl4q_u8(LoadRows4(p2 + 1, refwx4), index));
+
+            sad += SadRow(pred, blk);
+            blk += 16;
+
+            sadstar += madstar;
+            if (sad > sadstar - nrmlz_th[i] || sad > (Int)((ULong)dmin_rx >> 16))
+            {
+                return 65536;
+            }
+        }
+
+        return sad;
+    }
+
+    Int SAD_MB_HP_HTFM_NEONyh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        Int sad = 0;
+        Int rx = dmin_rx & 0xFFFF;
+        Int refwx4 = rx << 2;
+        Int sadstar = 0, madstar;
+        Int *nrmlz_th = (Int*) extra_info;
+        Int *offsetRef = nrmlz_th + 32;
+
+        if (rx & 3)
+        {
+            return SAD_MB_HP_HTFMyh(ref, blk, dmin_rx, extra_info);
+        }
+
+        madstar = (ULong)dmin_rx >> 20;
+
+        for (Int i = 0; i < 16; i++) /* 16 stages */
+        {
+            Int col = offsetRef[i] & 3;
+            const UChar *p1 = ref + offsetRef[i] - col;
+            uint8x16_t index = vld1q_u8(kHtfmIndex[col]);
+            uint8x16_t pred = vrhaddq_u8(vqtbl4q_u8(LoadRows4(p1, refwx4), index),
+                                         vqtbl4q_u8(LoadRows4(p1 + rx, refwx4), index));
+
+            sad += SadRow(pred, blk);
+            blk += 16;
+
+            sadstar += madstar;
+            if (sad > sadstar - nrmlz_th[i] || sad > (Int)((ULong)dmin_rx >> 16))
+            {
+                return 65536;
+            }
+        }
+
+        return sad;
+    }
+
+    Int SAD_MB_HP_HTFM_NEONxh(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        Int sad = 0;
+        Int rx = dmin_rx & 0xFFFF;
+        Int refwx4 = rx << 2;
+        Int sadstar = 0, madstar;
+        Int *nrmlz_th = (Int*) extra_info;
+        Int *offsetRef = nrmlz_th + 32;
+
+        if (rx & 3)
+        {
+            return SAD_MB_HP_HTFMxh(ref, blk, dmin_rx, extra_info);
+        }
+
+        madstar = (ULong)dmin_rx >> 20;
+
+        for (Int i = 0; i < 16; i++) /* 16 stages */
+        {
+            Int col = offsetRef[i] & 3;
+            const UChar *p1 = ref + offsetRef[i] - col;
+            uint8x16_t index = vld1q_u8(kHtfmIndex[col]);
+            uint8x16_t pred = vrhaddq_u8(vqtbl4q_u8(LoadRows4(p1, refwx4), index),
+                                         vqtbl4q_u8(LoadRows4(p1 + 1, refwx4), index));
+
+            sad += SadRow(pred, blk);
+            blk += 16;
+
+            sadstar += madstar;
+            if (sad > sadstar - nrmlz_th[i] || sad > (Int)((ULong)dmin_rx >> 16))
+            {
+                return 65536;
+            }
+        }
+
+        return sad;
+    }
+#endif /* HTFM */
+
+    void ComputeMBSum_NEON(UChar *cur, Int lx, MOT *mot_mb)
+    {
+        uint16x8_t top = vdupq_n_u16(0);
+        uint16x8_t bottom = vdupq_n_u16(0);
+
+        for (Int j = 0; j < 8; j++)
+        {
+            top = vpadalq_u8(top, vld1q_u8(cur));
+            bottom = vpadalq_u8(bottom, vld1q_u8(cur + (lx << 3)));
+            cur += lx;
+        }
+
+        /* lanes 0..3 sum the left 8x8 block and lanes 4..7 the right one */
+        uint32x4_t top4 = vpaddlq_u16(top);
+        uint32x4_t bottom4 = vpaddlq_u16(bottom);
+        Int sad1 = vgetq_lane_u32(top4, 0) + vgetq_lane_u32(top4, 1);
+        Int sad2 = vgetq_lane_u32(top4, 2) + vgetq_lane_u32(top4, 3);
+        Int sad3 = vgetq_lane_u32(bottom4, 0) + vgetq_lane_u32(bottom4, 1);
+        Int sad4 = vgetq_lane_u32(bottom4, 2) + vgetq_lane_u32(bottom4, 3);
+
+        mot_mb[1].sad = sad1;
+        mot_mb[2].sad = sad2;
+        mot_mb[3].sad = sad3;
+        mot_mb[4].sad = sad4;
+        mot_mb[0].sad = sad1 + sad2 + sad3 + sad4;
+    }
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PV_MP3DEC_FXD_OP_NEON_H
+#define PV_MP3DEC_FXD_OP_NEON_H
+
+#include <arm_neon.h>
+
+/*
+ * Four lane versions of the fixed point multiplies in
+ * pv_mp3dec_fxd_op_c_equivalent.h, used by the arm64 kernels.
+ *
+ * Every lane keeps the full 64 bit product and truncates it exactly like the
+ * scalar version, so the arm64 kernels are bit exact with the C reference.
+ * Accumulation is done by the caller with plain (wrapping) vector adds.
+ */
+
+static inline int32x4_t fxp_mul32x4_Q32(int32x4_t a, int32x4_t b)
+{
+    return vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(a), vget_low_s32(b)), 32),
+                        vshrn_n_s64(vmull_high_s32(a, b), 32));
+}
+
+static inline int32x4_t fxp_mul32x4_Q28(int32x4_t a, int32x4_t b)
+{
+    return vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(a), vget_low_s32(b)), 28),
+                        vshrn_n_s64(vmull_high_s32(a, b), 28));
+}
+
+static inline int32x4_t fxp_mul32x4_Q27(int32x4_t a, int32x4_t b)
+{
+    return vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(a), vget_low_s32(b)), 27),
+                        vshrn_n_s64(vmull_high_s32(a, b), 27));
+}
+
+/* {a0, a1, a2, a3} -> {a3, a2, a1, a0} */
+static inline int32x4_t vreverse_s32(int32x4_t a)
+{
+    a = vrev64q_s32(a);
+    return vextq_s32(a, a, 2);
+}
+
+#endif  /* PV_MP3DEC_FXD_OP_NEON_H */
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * arm64 NEON version of pvmp3_mdct_18.cpp, used instead of it on arm64 (see
+ * Android.bp). The results are bit exact with the C version.
+ *
+ * The input twiddle, the first part of the overlap and add and the windowing
+ * of the next overlap are done four lanes at a time. The reordering after the
+ * two dct_9 and the rest of the overlap and add are the same as in the C
+ * version.
+ */
+
+#include "pv_mp3dec_fxd_op.h"
+#include "pv_mp3dec_fxd_op_neon.h"
+#include "pvmp3_mdct_18.h"
+
+/* same tables as pvmp3_mdct_18.cpp, which isn't built on arm64 */
+const int32 cosTerms_dct18[9] =
+{
+    Qfmt(0.50190991877167f),   Qfmt(0.51763809020504f),   Qfmt(0.55168895948125f),
+    Qfmt(0.61038729438073f),   Qfmt(0.70710678118655f),   Qfmt(0.87172339781055f),
+    Qfmt(1.18310079157625f),   Qfmt(1.93185165257814f),   Qfmt(5.73685662283493f)
+};
+
+
+const int32 cosTerms_1_ov_cos_phi[18] =
+{
+
+    Qfmt1(0.50047634258166f),  Qfmt1(0.50431448029008f),  Qfmt1(0.51213975715725f),
+    Qfmt1(0.52426456257041f),  Qfmt1(0.54119610014620f),  Qfmt1(0.56369097343317f),
+    Qfmt1(0.59284452371708f),  Qfmt1(0.63023620700513f),  Qfmt1(0.67817085245463f),
+
+    Qfmt2(0.74009361646113f),  Qfmt2(0.82133981585229f),  Qfmt2(0.93057949835179f),
+    Qfmt2(1.08284028510010f),  Qfmt2(1.30656296487638f),  Qfmt2(1.66275476171152f),
+    Qfmt2(2.31011315767265f),  Qfmt2(3.83064878777019f),  Qfmt2(11.46279281302667f)
+};
+
+__attribute__((no_sanitize("integer")))
+void pvmp3_mdct_18(int32 vec[], int32 *history, const int32 *window)
+{
+    int32 i;
+    int32 tmp;
+    int32 tmp1;
+    int32 tmp2;
+    int32 tmp3;
+    int32 tmp4;
+
+    const int32 *pt_cos_split = cosTerms_dct18;
+    const int32 *pt_cos       = cosTerms_1_ov_cos_phi;
+
+    /*
+     *  vec[i] and vec[17 - i] for i = 0..7, the lanes of the upper half
+     *  are reversed to line up with the lower half.
+     */
+    for (i = 0; i < 8; i += 4)
+    {
+        int32x4_t lo = vld1q_s32(&vec[i]);
+        int32x4_t hi = vreverse_s32(vld1q_s32(&vec[14 - i]));
+        lo = fxp_mul32x4_Q32(vshlq_n_s32(lo, 1), vld1q_s32(&pt_cos[i]));
+        hi = fxp_mul32x4_Q27(hi, vreverse_s32(vld1q_s32(&pt_cos[14 - i])));
+        vst1q_s32(&vec[i], vaddq_s32(lo, hi));
+        vst1q_s32(&vec[14 - i], vreverse_s32(
+                fxp_mul32x4_Q28(vsubq_s32(lo, hi), vld1q_s32(&pt_cos_split[i]))));
+    }
+    tmp  = fxp_mul32_Q32(vec[8] << 1, pt_cos[8]);
+    tmp1 = fxp_mul32_Q27(vec[9], pt_cos[9]);
+    vec[8] = tmp + tmp1;
+    vec[9] = fxp_mul32_Q28((tmp - tmp1), pt_cos_split[8]);
+
+
+    pvmp3_dct_9(vec);         // Even terms
+    pvmp3_dct_9(&vec[9]);     // Odd  terms
+
+
+    tmp3     = vec[16];  //
+    vec[16]  = vec[ 8];
+    tmp4     = vec[14];  //
+    vec[14]  = vec[ 7];
+    tmp      = vec[12];
+    vec[12]  = vec[ 6];
+    tmp2     = vec[10];  // vec[10]
+    vec[10]  = vec[ 5];
+    vec[ 8]  = vec[ 4];
+    vec[ 6]  = vec[ 3];
+    vec[ 4]  = vec[ 2];
+    vec[ 2]  = vec[ 1];
+    vec[ 1]  = vec[ 9] - tmp2; //  vec[9] +  vec[10]
+    vec[ 3]  = vec[11] - tmp2;
+    vec[ 5]  = vec[11] - tmp;
+    vec[ 7]  = vec[13] - tmp;
+    vec[ 9]  = vec[13] - tmp4;
+    vec[11]  = vec[15] - tmp4;
+    vec[13]  = vec[15] - tmp3;
+    vec[15]  = vec[17] - tmp3;
+
+
+    /* overlap and add */
+
+    /*
+     *  vec[i + 10] = vec[i + 9] + vec[i + 10], vec[i] = history[i] + window,
+     *  history[i] = -(vec[i] + vec[i + 1]) on the values before this loop.
+     */
+    {
+        int32x4_t v0  = vld1q_s32(&vec[ 0]);
+        int32x4_t v1  = vld1q_s32(&vec[ 1]);
+        int32x4_t v9  = vld1q_s32(&vec[ 9]);
+        int32x4_t v10 = vld1q_s32(&vec[10]);
+        int32x4_t sum = vaddq_s32(v9, v10);
+
+        tmp2 = vgetq_lane_s32(v1, 3);     // vec[4]
+        tmp3 = vgetq_lane_s32(v10, 3);    // vec[13]
+
+        vst1q_s32(&vec[10], sum);
+        vst1q_s32(&vec[ 0], vaddq_s32(vld1q_s32(history),
+                                      fxp_mul32x4_Q32(sum, vld1q_s32(window))));
+        vst1q_s32(history, vnegq_s32(vaddq_s32(v0, v1)));
+    }
+
+    for (i = 4; i < 6; i++)
+    {
+        tmp  = history[ i];
+        tmp4 = vec[i+10];
+        vec[i+10] = tmp3 + tmp4;
+        tmp1 = vec[i+1];
+        vec[ i] =  fxp_mac32_Q32(tmp, (vec[i+10]), window[ i]);
+        tmp3 = tmp4;
+        history[i  ] = -(tmp2 + tmp1);
+        tmp2 = tmp1;
+    }
+
+    tmp  = history[ 6];
+    tmp4 = vec[16];
+    vec[16] = tmp3 + tmp4;
+    tmp1 = vec[7];
+    vec[ 6] =  fxp_mac32_Q32(tmp, vec[16] << 1, window[ i]);
+    tmp  = history[ 7];
+    history[6] = -(tmp2 + tmp1);
+    history[7] = -(tmp1 + vec[8]);
+
+    tmp1  = history[ 8];
+    tmp4    = vec[17] + tmp4;
+    vec[ 7] =  fxp_mac32_Q32(tmp, tmp4 << 1, window[ 7]);
+    history[8] = -(vec[8] + vec[9]);
+    vec[ 8] =  fxp_mac32_Q32(tmp1, vec[17] << 1, window[ 8]);
+
+    tmp  = history[9];
+    tmp1 = history[17];
+    tmp2 = history[16];
+    vec[ 9] =  fxp_mac32_Q32(tmp,  vec[17] << 1, window[ 9]);
+
+    vec[17] =  fxp_mac32_Q32(tmp1, vec[10] << 1, window[17]);
+    vec[10] = -vec[ 16];
+    vec[16] =  fxp_mac32_Q32(tmp2, vec[11] << 1, window[16]);
+    tmp1 = history[15];
+    tmp2 = history[14];
+    vec[11] = -vec[ 15];
+    vec[15] =  fxp_mac32_Q32(tmp1, vec[12] << 1, window[15]);
+    vec[12] = -vec[ 14];
+    vec[14] =  fxp_mac32_Q32(tmp2, vec[13] << 1, window[14]);
+
+    tmp  = history[13];
+    tmp1 = history[12];
+    tmp2 = history[11];
+    tmp3 = history[10];
+    vec[13] =  fxp_mac32_Q32(tmp,  vec[12] << 1, window[13]);
+    vec[12] =  fxp_mac32_Q32(tmp1, vec[11] << 1, window[12]);
+    vec[11] =  fxp_mac32_Q32(tmp2, vec[10] << 1, window[11]);
+    vec[10] =  fxp_mac32_Q32(tmp3,    tmp4 << 1, window[10]);
+
+
+    /* next iteration overlap */
+
+    /*
+     *  history[n]      = (history[8 - n] << 1) * window[18 + n]
+     *  history[17 - n] = (history[8 - n] << 1) * window[35 - n]
+     *  for n = 0..8, on the values before this step.
+     */
+    {
+        int32x4_t h0 = vshlq_n_s32(vld1q_s32(&history[0]), 1);
+        int32x4_t h4 = vshlq_n_s32(vld1q_s32(&history[4]), 1);
+        int32x4_t h5 = vshlq_n_s32(vld1q_s32(&history[5]), 1);
+        int32x4_t h1 = vshlq_n_s32(vld1q_s32(&history[1]), 1);
+        tmp  = history[0] << 1;
+        tmp1 = history[8] << 1;
+
+        vst1q_s32(&history[ 0], fxp_mul32x4_Q32(vreverse_s32(h5), vld1q_s32(&window[18])));
+        vst1q_s32(&history[ 4], fxp_mul32x4_Q32(vreverse_s32(h1), vld1q_s32(&window[22])));
+        history[ 8] = fxp_mul32_Q32(tmp, window[26]);
+        vst1q_s32(&history[ 9], fxp_mul32x4_Q32(h0, vld1q_s32(&window[27])));
+        vst1q_s32(&history[13], fxp_mul32x4_Q32(h4, vld1q_s32(&window[31])));
+        history[17] = fxp_mul32_Q32(tmp1, window[35]);
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * arm64 NEON version of pvmp3_polyphase_filter_window.cpp, used instead of it
+ * on arm64 (see Android.bp). The results are bit exact with the C version.
+ *
+ * For each output pair the C version accumulates 16 window products into
+ * sum1 and 16 into sum2, in four groups of four. Here a group is one vector
+ * of the four synthesis samples {temp1, temp3, temp2, temp4} multiplied by
+ * the four window coefficients; sum2 uses the same samples with the pairs
+ * swapped. The products are truncated before the signs of the fxp_msb32_Q32
+ * terms are applied, as in the C version.
+ */
+
+#include "pvmp3_polyphase_filter_window.h"
+#include "pv_mp3dec_fxd_op.h"
+#include "pv_mp3dec_fxd_op_neon.h"
+#include "pvmp3_dec_defs.h"
+#include "pvmp3_tables.h"
+
+__attribute__((no_sanitize("integer")))
+void pvmp3_polyphase_filter_window(int32 *synth_buffer,
+                                   int16 *outPcm,
+                                   int32 numChannels)
+{
+    static const int32 kSigns1[4] = {1, -1, 1, 1};
+    static const int32 kSigns2[4] = {1, 1, -1, 1};
+    const int32x4_t signs1 = vld1q_s32(kSigns1);
+    const int32x4_t signs2 = vld1q_s32(kSigns2);
+
+    int32 sum1;
+    int32 sum2;
+    const int32 *winPtr = pqmfSynthWin;
+    int32 i;
+
+    for (int16 j = 1; j < SUBBANDS_NUMBER / 2; j++)
+    {
+        const int32 *pt_1 = &synth_buffer[(SUBBANDS_NUMBER >> 1) + j];
+        const int32 *pt_2 = &synth_buffer[(SUBBANDS_NUMBER >> 1) - j];
+        int32x4_t acc1 = vdupq_n_s32(0);
+        int32x4_t acc2 = vdupq_n_s32(0);
+
+        for (int32 g = 0; g < 4; g++)
+        {
+            int32x4_t samples = vdupq_n_s32(pt_1[SUBBANDS_NUMBER * (2 * g)]);
+            samples = vsetq_lane_s32(pt_2[SUBBANDS_NUMBER * (15 - 2 * g)], samples, 1);
+            samples = vsetq_lane_s32(pt_2[SUBBANDS_NUMBER * (2 * g + 1)], samples, 2);
+            samples = vsetq_lane_s32(pt_1[SUBBANDS_NUMBER * (14 - 2 * g)], samples, 3);
+
+            const int32x4_t win = vld1q_s32(&winPtr[4 * g]);
+            acc1 = vmlaq_s32(acc1, fxp_mul32x4_Q32(samples, win), signs1);
+            acc2 = vmlaq_s32(acc2, fxp_mul32x4_Q32(vrev64q_s32(samples), win), signs2);
+        }
+        winPtr += 16;
+
+        sum1 = 0x00000020 + vaddvq_s32(acc1);
+        sum2 = 0x00000020 + vaddvq_s32(acc2);
+
+        int32 k = j << (numChannels - 1);
+        outPcm[k] = saturate16(sum1 >> 6);
+        outPcm[(numChannels<<5) - k] = saturate16(sum2 >> 6);
+    }
+
+    sum1 = 0x00000020;
+    sum2 = 0x00000020;
+
+    for (i = 16; i < HAN_SIZE + 16; i += (SUBBANDS_NUMBER << 2))
+    {
+        int32 *pt_synth = &synth_buffer[i];
+        int32 temp1 = pt_synth[ 0                ];
+        int32 temp2 = pt_synth[ SUBBANDS_NUMBER  ];
+        int32 temp3 = pt_synth[ SUBBANDS_NUMBER/2];
+
+        sum1 = fxp_mac32_Q32(sum1, temp1, winPtr[0]) ;
+        sum1 = fxp_mac32_Q32(sum1, temp2, winPtr[1]) ;
+        sum2 = fxp_mac32_Q32(sum2, temp3, winPtr[2]) ;
+
+        temp1 = pt_synth[ SUBBANDS_NUMBER<<1 ];
+        temp2 = pt_synth[ 3*SUBBANDS_NUMBER  ];
+        temp3 = pt_synth[ SUBBANDS_NUMBER*5/2];
+
+        sum1 = fxp_mac32_Q32(sum1, temp1, winPtr[3]) ;
+        sum1 = fxp_mac32_Q32(sum1, temp2, winPtr[4]) ;
+        sum2 = fxp_mac32_Q32(sum2, temp3, winPtr[5]) ;
+
+        winPtr += 6;
+    }
+
+    outPcm[0] = saturate16(sum1 >> 6);
+    outPcm[(SUBBANDS_NUMBER/2)<<(numChannels-1)] = saturate16(sum2 >> 6);
+}
@@ -20,6 +20,8 @@
 
 #include "MidiExtractor.h"
 
+#include <algorithm>
+
 #include <media/MidiIoWrapper.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/MediaBufferGroup.h>
@@ -30,8 +32,14 @@
 
 namespace android {
 
-// how many Sonivox output buffers to aggregate into one MediaBuffer
-static const int NUM_COMBINE_BUFFERS = 4;
+// How much audio to render into one MediaBuffer. Each MediaBuffer aggregates as many
+// Sonivox output buffers as fit, which amortizes the per buffer cost (watchdog timer,
+// metadata, acquire and release) over several mix buffers.
+static const int kBufferDurationMs = 50;
+
+// How many MediaBuffers to pool, so the next block can be rendered while the consumer
+// still holds the previous ones.
+static const int kNumBuffers = 4;
 
 class MidiSource : public MediaTrackHelper {
 
@@ -150,7 +158,8 @@ MidiEngine::MidiEngine(CDataSource *dataSource,
             mEasData(NULL),
             mEasHandle(NULL),
             mEasConfig(NULL),
-            mIsInitialized(false) {
+            mIsInitialized(false),
+            mCombineBuffers(1) {
     Watchdog watchdog(kTimeout);
 
     mIoWrapper = new MidiIoWrapper(dataSource);
@@ -187,6 +196,12 @@ MidiEngine::MidiEngine(CDataSource *dataSource,
                 trackMetadata, AMEDIAFORMAT_KEY_CHANNEL_COUNT, mEasConfig->numChannels);
         AMediaFormat_setInt32(
                 trackMetadata, AMEDIAFORMAT_KEY_PCM_ENCODING, kAudioEncodingPcm16bit);
+        mCombineBuffers = std::max<EAS_I32>(1, mEasConfig->sampleRate * kBufferDurationMs
+                / 1000 / mEasConfig->mixBufferSize);
+        // Lets the consumer size its buffers to ours.
+        AMediaFormat_setInt32(trackMetadata, AMEDIAFORMAT_KEY_MAX_INPUT_SIZE,
+                sizeof(EAS_PCM) * mEasConfig->mixBufferSize * mEasConfig->numChannels
+                        * mCombineBuffers);
     }
     mIsInitialized = true;
 }
@@ -213,10 +228,12 @@ status_t MidiEngine::allocateBuffers(MediaBufferGroupHelper *group) {
     EAS_SetParameter(mEasData, EAS_MODULE_REVERB, EAS_PARAM_REVERB_BYPASS, EAS_FALSE);
 
     int bufsize = sizeof(EAS_PCM)
-            * mEasConfig->mixBufferSize * mEasConfig->numChannels * NUM_COMBINE_BUFFERS;
-    ALOGV("using %d byte buffer", bufsize);
+            * mEasConfig->mixBufferSize * mEasConfig->numChannels * mCombineBuffers;
+    ALOGV("using %d byte buffers", bufsize);
     mGroup = group;
-    mGroup->add_buffer(bufsize);
+    for (int i = 0; i < kNumBuffers; i++) {
+        mGroup->add_buffer(bufsize);
+    }
     return OK;
 }
 
@@ -255,7 +272,7 @@ MediaBufferHelper* MidiEngine::readBuffer() {
 
     EAS_PCM* p = (EAS_PCM*) buffer->data();
     int numBytesOutput = 0;
-    for (int i = 0; i < NUM_COMBINE_BUFFERS; i++) {
+    for (int i = 0; i < mCombineBuffers; i++) {
         EAS_I32 numRendered;
         EAS_RESULT result = EAS_Render(mEasData, p, mEasConfig->mixBufferSize, &numRendered);
         if (result != EAS_SUCCESS) {
@@ -265,6 +282,11 @@ MediaBufferHelper* MidiEngine::readBuffer() {
         }
         p += numRendered * mEasConfig->numChannels;
         numBytesOutput += numRendered * mEasConfig->numChannels * sizeof(EAS_PCM);
+        // Larger blocks would otherwise render silence past the end of the file.
+        EAS_State(mEasData, mEasHandle, &state);
+        if ((state == EAS_STATE_STOPPED) || (state == EAS_STATE_ERROR)) {
+            break;
+        }
     }
     buffer->set_range(0, numBytesOutput);
     ALOGV("readBuffer: returning %zd in buffer %p", buffer->range_length(), buffer);
@@ -48,6 +48,7 @@ private:
     EAS_HANDLE mEasHandle;
     const S_EAS_LIB_CONFIG* mEasConfig;
     bool mIsInitialized;
+    int mCombineBuffers;  // Sonivox output buffers rendered into one MediaBuffer
 };
 
 class MidiExtractor : public MediaExtractorPluginHelper {
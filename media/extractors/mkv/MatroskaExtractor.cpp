@@ -584,7 +584,25 @@ int64_t BlockIterator::blockTimeUs() const {
 }
 
 void BlockIterator::seekwithoutcue_l(int64_t seekTimeUs, int64_t *actualFrameTimeUs) {
-    mCluster = mExtractor->mSegment->FindCluster(seekTimeUs * 1000ll);
+    mkvparser::Segment* const pSegment = mExtractor->mSegment;
+
+    // The loaded clusters serve as the seek index. Extend it by loading cluster
+    // headers until it covers the seek target, the index is kept for later seeks.
+    const long long seekTimeNs = seekTimeUs * 1000ll;
+    for (;;) {
+        const mkvparser::Cluster *last = pSegment->GetLast();
+        if (last != NULL && !last->EOS() && last->GetTime() > seekTimeNs) {
+            break;
+        }
+        long long pos;
+        long len;
+        if (pSegment->LoadCluster(pos, len) != 0) {
+            // no more clusters, or an error
+            break;
+        }
+    }
+
+    mCluster = pSegment->FindCluster(seekTimeNs);
     const long status = mCluster->GetFirst(mBlockEntry);
     if (status < 0) {  // error
         ALOGE("get last blockenry failed!");
@@ -1395,13 +1413,16 @@ MatroskaExtractor::MatroskaExtractor(DataSourceHelper *source)
                 }
             }
 
+            // Only the first cluster is loaded here. Without Cue data the
+            // remaining clusters are indexed on demand when seeking, see
+            // BlockIterator::seekwithoutcue_l().
+            long len;
+            long long status = mSegment->LoadCluster(pos, len);
             if (mCues) {
-                long len;
-                ret = mSegment->LoadCluster(pos, len);
+                ret = status;
                 ALOGV("has Cue data, Cluster num=%ld", mSegment->GetCount());
-            } else  {
-                long status_Load = mSegment->Load();
-                ALOGW("no Cue data,Segment Load status:%ld",status_Load);
+            } else {
+                ALOGW("no Cue data, LoadCluster status:%lld", status);
             }
         } else if (ret > 0) {
             ret = mkvparser::E_BUFFER_NOT_FULL;
@@ -2353,7 +2374,7 @@ ExtractorDef GETEXTRACTORDEF() {
                         return [](
                                 CDataSource *source,
                                 void *) -> CMediaExtractor* {
-                            return wrap(new MatroskaExtractor(new DataSourceHelper(source)));};
+                            return wrap(new MatroskaExtractor(new BufferedDataSourceHelper(source)));};
                     }
                     return NULL;
                 },
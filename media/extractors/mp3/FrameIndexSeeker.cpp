@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FrameIndexSeeker"
+#include <utils/Log.h>
+
+#include "FrameIndexSeeker.h"
+
+#include <media/stagefright/foundation/avc_utils.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+#include <media/MediaExtractorPluginApi.h>
+#include <media/MediaExtractorPluginHelper.h>
+
+#include <algorithm>
+
+namespace android {
+
+// Same as in MP3Extractor: everything must match except for protection,
+// bitrate, padding, private bits, mode, mode extension, copyright bit,
+// original bit and emphasis.
+static const uint32_t kMask = 0xfffe0c00;
+
+FrameIndexSeeker::FrameIndexSeeker(
+        DataSourceHelper *source, off64_t first_frame_pos,
+        uint32_t fixed_header, bool canScan)
+    : mDataSource(source),
+      mFixedHeader(fixed_header),
+      mCanScan(canScan),
+      mEndPos(first_frame_pos) {
+    size_t frameSize;
+    GetMPEGAudioFrameSize(fixed_header, &frameSize, &mSampleRate);
+}
+
+bool FrameIndexSeeker::getDuration(int64_t *durationUs) {
+    Mutex::Autolock autoLock(mLock);
+    if (!mComplete || mSampleRate <= 0) {
+        return false;
+    }
+    *durationUs = mEndSampleCount * 1000000LL / mSampleRate;
+    return true;
+}
+
+bool FrameIndexSeeker::getOffsetForTime(int64_t *timeUs, off64_t *pos) {
+    Mutex::Autolock autoLock(mLock);
+    if (mSampleRate <= 0) {
+        return false;
+    }
+    int64_t targetSampleCount = std::max((int64_t)0, *timeUs) * mSampleRate / 1000000LL;
+    if (targetSampleCount >= mEndSampleCount && !mComplete) {
+        if (!mCanScan) {
+            return false;
+        }
+        scanTo_l(targetSampleCount);
+        if (targetSampleCount >= mEndSampleCount && !mComplete) {
+            // lost sync while scanning, leave it to the bitrate estimate
+            return false;
+        }
+    }
+    if (mEntries.empty()) {
+        return false;
+    }
+
+    // Last entry at or before the target, then walk the frames after it.
+    auto it = std::upper_bound(mEntries.begin(), mEntries.end(), targetSampleCount,
+            [](int64_t sampleCount, const Entry &entry) {
+                return sampleCount < entry.sampleCount;
+            });
+    if (it != mEntries.begin()) {
+        --it;
+    }
+    off64_t framePos = it->pos;
+    int64_t sampleCount = it->sampleCount;
+    for (size_t i = 1; i < kFramesPerEntry && framePos < mEndPos; ++i) {
+        size_t frameSize;
+        int numSamples;
+        if (!readFrame_l(framePos, &frameSize, &numSamples)
+                || sampleCount + numSamples > targetSampleCount) {
+            break;
+        }
+        framePos += frameSize;
+        sampleCount += numSamples;
+    }
+
+    *pos = framePos;
+    *timeUs = sampleCount * 1000000LL / mSampleRate;
+    ALOGV("seek to %lld us at offset %lld", (long long)*timeUs, (long long)*pos);
+    return true;
+}
+
+void FrameIndexSeeker::addFrame(off64_t pos, size_t frameSize, int numSamples) {
+    Mutex::Autolock autoLock(mLock);
+    addFrame_l(pos, frameSize, numSamples);
+}
+
+void FrameIndexSeeker::addFrame_l(off64_t pos, size_t frameSize, int numSamples) {
+    if (pos != mEndPos || mComplete) {
+        // not contiguous with the indexed part, the sample count is unknown
+        return;
+    }
+    if (mEndFrameCount % kFramesPerEntry == 0) {
+        mEntries.push_back({pos, mEndSampleCount});
+    }
+    mEndPos += frameSize;
+    mEndSampleCount += numSamples;
+    ++mEndFrameCount;
+}
+
+bool FrameIndexSeeker::readFrame_l(off64_t pos, size_t *frameSize, int *numSamples) {
+    uint8_t buffer[4];
+    if (mDataSource->readAt(pos, buffer, sizeof(buffer)) < (ssize_t)sizeof(buffer)) {
+        return false;
+    }
+    uint32_t header = U32_AT(buffer);
+    int sampleRate;
+    int bitrate;
+    return (header & kMask) == (mFixedHeader & kMask)
+            && GetMPEGAudioFrameSize(
+                    header, frameSize, &sampleRate, NULL, &bitrate, numSamples);
+}
+
+void FrameIndexSeeker::scanTo_l(int64_t targetSampleCount) {
+    ALOGV("scanning from %lld to sample %lld",
+            (long long)mEndPos, (long long)targetSampleCount);
+    while (mEndSampleCount <= targetSampleCount) {
+        size_t frameSize;
+        int numSamples;
+        if (!readFrame_l(mEndPos, &frameSize, &numSamples)) {
+            off64_t size;
+            if (mDataSource->getSize(&size) == OK && mEndPos + 4 > size) {
+                mComplete = true;
+            } else {
+                ALOGW("lost sync at %lld while indexing", (long long)mEndPos);
+            }
+            return;
+        }
+        addFrame_l(mEndPos, frameSize, numSamples);
+    }
+}
+
+}  // namespace android
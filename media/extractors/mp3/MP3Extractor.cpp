@@ -20,6 +20,7 @@
 
 #include "MP3Extractor.h"
 
+#include "FrameIndexSeeker.h"
 #include "ID3.h"
 #include "VBRISeeker.h"
 #include "XINGSeeker.h"
@@ -28,6 +29,7 @@
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/avc_utils.h>
 #include <media/stagefright/foundation/ByteUtils.h>
+#include <media/stagefright/DataSourceBase.h>
 #include <media/stagefright/MediaBufferBase.h>
 #include <media/stagefright/MediaBufferGroup.h>
 #include <media/stagefright/MediaDefs.h>
@@ -212,7 +214,7 @@ public:
     MP3Source(
             AMediaFormat *meta, DataSourceHelper *source,
             off64_t first_frame_pos, uint32_t fixed_header,
-            MP3Seeker *seeker);
+            MP3Seeker *seeker, FrameIndexSeeker *frameIndex);
 
     virtual media_status_t start();
     virtual media_status_t stop();
@@ -235,6 +237,7 @@ private:
     int64_t mCurrentTimeUs = 0;
     bool mStarted = false;
     MP3Seeker *mSeeker = NULL;
+    FrameIndexSeeker *mFrameIndex = NULL;  // same as mSeeker if set
 
     int64_t mBasisTimeUs = 0;
     int64_t mSamplesRead = 0;
@@ -310,6 +313,14 @@ MP3Extractor::MP3Extractor(
         }
         mFirstFramePos = pos;
         mFixedHeader = header;
+    } else {
+        // Without a XING/VBRI table of contents, index the frames to seek exactly.
+        // Scanning ahead of playback would download the stream from caching sources.
+        bool canScan = (mDataSource->flags()
+                & (DataSourceBase::kWantsPrefetching
+                    | DataSourceBase::kIsCachingDataSource)) == 0;
+        mFrameIndex = new FrameIndexSeeker(mDataSource, mFirstFramePos, mFixedHeader, canScan);
+        mSeeker = mFrameIndex;
     }
 
     size_t frame_size;
@@ -366,9 +377,9 @@ MP3Extractor::MP3Extractor(
 
     // Get iTunes-style gapless info if present.
     // When getting the id3 tag, skip the V1 tags to prevent the source cache
-    // from being iterated to the end of the file.
+    // from being iterated to the end of the file. The album art is not needed here.
     DataSourceHelper helper(mDataSource);
-    ID3 id3(&helper, true);
+    ID3 id3(&helper, true, 0 /* offset */, true /* deferAlbumArt */);
     if (id3.isValid()) {
         ID3::Iterator *com = new ID3::Iterator(id3, "COM");
         if (com->done()) {
@@ -416,7 +427,7 @@ MediaTrackHelper *MP3Extractor::getTrack(size_t index) {
 
     return new MP3Source(
             mMeta, mDataSource, mFirstFramePos, mFixedHeader,
-            mSeeker);
+            mSeeker, mFrameIndex);
 }
 
 media_status_t MP3Extractor::getTrackMetaData(
@@ -441,12 +452,13 @@ const size_t MP3Source::kMaxFrameSize = (1 << 12); /* 4096 bytes */
 MP3Source::MP3Source(
         AMediaFormat *meta, DataSourceHelper *source,
         off64_t first_frame_pos, uint32_t fixed_header,
-        MP3Seeker *seeker)
+        MP3Seeker *seeker, FrameIndexSeeker *frameIndex)
     : mMeta(meta),
       mDataSource(source),
       mFirstFramePos(first_frame_pos),
       mFixedHeader(fixed_header),
-      mSeeker(seeker) {
+      mSeeker(seeker),
+      mFrameIndex(frameIndex) {
 }
 
 MP3Source::~MP3Source() {
@@ -592,6 +604,9 @@ media_status_t MP3Source::read(
     AMediaFormat_setInt64(meta, AMEDIAFORMAT_KEY_TIME_US, mCurrentTimeUs);
     AMediaFormat_setInt32(meta, AMEDIAFORMAT_KEY_IS_SYNC_FRAME, 1);
 
+    if (mFrameIndex != NULL) {
+        mFrameIndex->addFrame(mCurrentPos, frame_size, num_samples);
+    }
     mCurrentPos += frame_size;
 
     mSamplesRead += num_samples;
@@ -610,7 +625,7 @@ media_status_t MP3Extractor::getMetaData(AMediaFormat *meta) {
     AMediaFormat_setString(meta, AMEDIAFORMAT_KEY_MIME, MEDIA_MIMETYPE_AUDIO_MPEG);
 
     DataSourceHelper helper(mDataSource);
-    ID3 id3(&helper);
+    ID3 id3(&helper, false /* ignoreV1 */, 0 /* offset */, true /* deferAlbumArt */);
 
     if (!id3.isValid()) {
         return AMEDIA_OK;
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAME_INDEX_SEEKER_H_
+
+#define FRAME_INDEX_SEEKER_H_
+
+#include "MP3Seeker.h"
+
+#include <utils/Mutex.h>
+
+#include <vector>
+
+namespace android {
+
+class DataSourceHelper;
+
+// Seeker for streams without a XING or VBRI header. It indexes the position of
+// every kFramesPerEntry-th frame, from the frames read during playback and, on
+// seeks past the indexed part, by scanning the frame headers ahead of it.
+// Seeks are then exact in VBR streams too, rather than estimated from the
+// bitrate of the first frame.
+struct FrameIndexSeeker : public MP3Seeker {
+    // canScan is false for sources that would have to download the frames to
+    // scan them, those only seek exactly within what playback has indexed.
+    FrameIndexSeeker(
+            DataSourceHelper *source, off64_t first_frame_pos,
+            uint32_t fixed_header, bool canScan);
+
+    // Only known once the whole stream is indexed.
+    virtual bool getDuration(int64_t *durationUs);
+    virtual bool getOffsetForTime(int64_t *timeUs, off64_t *pos);
+
+    // Called for each frame read by the source. Extends the index if the frame
+    // follows the indexed part of the stream.
+    void addFrame(off64_t pos, size_t frameSize, int numSamples);
+
+private:
+    // Frames between index entries, a trade-off between the size of the index
+    // and the number of headers read to find the exact frame after a lookup.
+    static const size_t kFramesPerEntry = 32;
+
+    struct Entry {
+        off64_t pos;
+        int64_t sampleCount;  // samples before the frame
+    };
+
+    DataSourceHelper *mDataSource;
+    const uint32_t mFixedHeader;
+    const bool mCanScan;
+    int mSampleRate = 0;
+
+    Mutex mLock;
+    std::vector<Entry> mEntries;
+    // End of the indexed part of the stream.
+    off64_t mEndPos;
+    int64_t mEndSampleCount = 0;
+    size_t mEndFrameCount = 0;
+    bool mComplete = false;  // no more frames after mEndPos
+
+    void addFrame_l(off64_t pos, size_t frameSize, int numSamples);
+
+    // Reads the header of the frame at pos. Returns false at the end of the
+    // stream or if the frame does not match the stream.
+    bool readFrame_l(off64_t pos, size_t *frameSize, int *numSamples);
+
+    // Scans frame headers until the index covers targetSampleCount.
+    void scanTo_l(int64_t targetSampleCount);
+
+    DISALLOW_EVIL_CONSTRUCTORS(FrameIndexSeeker);
+};
+
+}  // namespace android
+
+#endif  // FRAME_INDEX_SEEKER_H_
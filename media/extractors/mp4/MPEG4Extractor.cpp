@@ -81,8 +81,18 @@ enum {
     // maximum size of an atom. Some atoms can be bigger according to the spec,
     // but we only allow up to this size.
     kMaxAtomSize = 64 * 1024 * 1024,
+
+    // a moov box up to this size is read in a single request and its child
+    // boxes, including the sample tables, are parsed from memory.
+    kMaxCachedMoovSize = 4 * 1024 * 1024,
+
+    // a moof box up to this size is read in a single request before its
+    // track fragment boxes are parsed.
+    kMaxCachedMoofSize = 1024 * 1024,
 };
 
+class CachedRangedDataSource;
+
 class MPEG4Source : public MediaTrackHelper {
 static const size_t  kMaxPcmFrameSize = 8192;
 public:
@@ -116,6 +126,9 @@ private:
 
     AMediaFormat *mFormat;
     DataSourceHelper *mDataSource;
+    // For fragmented files, wraps the caller's data source and holds the
+    // moof box currently being parsed.
+    CachedRangedDataSource *mMoofSource;
     int32_t mTimescale;
     sp<SampleTable> mSampleTable;
     uint32_t mCurrentSampleIndex;
@@ -430,6 +443,7 @@ MPEG4Extractor::MPEG4Extractor(DataSourceHelper *source, const char *mime)
       mIsQT(false),
       mIsHeif(false),
       mHasMoovBox(false),
+      mMoovCached(false),
       mPreferHeif(mime != NULL && !strcasecmp(mime, MEDIA_MIMETYPE_CONTAINER_HEIF)),
       mIsAvif(false),
       mFirstTrack(NULL),
@@ -982,6 +996,20 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
                 return ERROR_MALFORMED;
             }
 
+            if (chunk_type == FOURCC("moov") && chunk_size <= kMaxCachedMoovSize) {
+                CachedRangedDataSource *cachedSource =
+                    new CachedRangedDataSource(mDataSource);
+
+                if (cachedSource->setCachedRange(
+                        *offset, chunk_size,
+                        true /* assume ownership on success */) == OK) {
+                    mDataSource = cachedSource;
+                    mMoovCached = true;
+                } else {
+                    delete cachedSource;
+                }
+            }
+
             if (chunk_type == FOURCC("moof") && !mMoofFound) {
                 // store the offset of the first segment
                 mMoofFound = true;
@@ -991,7 +1019,7 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
             if (chunk_type == FOURCC("stbl")) {
                 ALOGV("sampleTable chunk is %" PRIu64 " bytes long.", chunk_size);
 
-                if (mDataSource->flags()
+                if (!mMoovCached && mDataSource->flags()
                         & (DataSourceBase::kWantsPrefetching
                             | DataSourceBase::kIsCachingDataSource)) {
                     CachedRangedDataSource *cachedSource =
@@ -5063,6 +5091,7 @@ MPEG4Source::MPEG4Source(
         uint64_t elstInitialEmptyEditTicks)
     : mFormat(format),
       mDataSource(dataSource),
+      mMoofSource(NULL),
       mTimescale(timeScale),
       mSampleTable(sampleTable),
       mCurrentSampleIndex(0),
@@ -5221,6 +5250,11 @@ MPEG4Source::MPEG4Source(
     }
 
     CHECK(AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_TRACK_ID, &mTrackId));
+
+    if (mFirstMoofOffset != 0) {
+        mMoofSource = new CachedRangedDataSource(mDataSource);
+        mDataSource = mMoofSource;
+    }
 }
 
 status_t MPEG4Source::init() {
@@ -5237,6 +5271,7 @@ MPEG4Source::~MPEG4Source() {
     }
     free(mCurrentSampleInfoSizes);
     free(mCurrentSampleInfoOffsets);
+    delete mMoofSource;
 }
 
 media_status_t MPEG4Source::start() {
@@ -5333,6 +5368,13 @@ status_t MPEG4Source::parseChunk(off64_t *offset) {
         case FOURCC("traf"):
         case FOURCC("moof"): {
             off64_t stop_offset = *offset + chunk_size;
+            if (chunk_type == FOURCC("moof") && mMoofSource != NULL
+                    && chunk_size <= kMaxCachedMoofSize) {
+                // The track fragment boxes are parsed with many small reads,
+                // serve them from a single read of the whole moof.
+                mMoofSource->setCachedRange(
+                        *offset, chunk_size, false /* assume ownership on success */);
+            }
             *offset = data_offset;
             if (chunk_type == FOURCC("moof")) {
                 mCurrentMoofSize = chunk_data_size;
@@ -21,6 +21,7 @@
 #include "SampleIterator.h"
 
 #include <arpa/inet.h>
+#include <string.h>
 
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/ByteUtils.h>
@@ -37,6 +38,10 @@ SampleIterator::SampleIterator(SampleTable *table)
       mTTSSampleTime(0),
       mTTSCount(0),
       mTTSDuration(0) {
+    mChunkOffsetCache.mOffset = -1;
+    mChunkOffsetCache.mLength = 0;
+    mSampleSizeCache.mOffset = -1;
+    mSampleSizeCache.mLength = 0;
     reset();
 }
 
@@ -209,10 +214,11 @@ status_t SampleIterator::getChunkOffset(uint32_t chunk, off64_t *offset) {
     if (mTable->mChunkOffsetType == SampleTable::kChunkOffsetType32) {
         uint32_t offset32;
 
-        if (mTable->mDataSource->readAt(
-                    mTable->mChunkOffsetOffset + 8 + 4 * chunk,
+        if (readCached(&mChunkOffsetCache,
+                    mTable->mChunkOffsetOffset + 8 + 4 * (off64_t)chunk,
+                    mTable->mChunkOffsetOffset + 8 + 4 * (off64_t)mTable->mNumChunkOffsets,
                     &offset32,
-                    sizeof(offset32)) < (ssize_t)sizeof(offset32)) {
+                    sizeof(offset32)) != OK) {
             return ERROR_IO;
         }
 
@@ -221,10 +227,11 @@ status_t SampleIterator::getChunkOffset(uint32_t chunk, off64_t *offset) {
         CHECK_EQ(mTable->mChunkOffsetType, SampleTable::kChunkOffsetType64);
 
         uint64_t offset64;
-        if (mTable->mDataSource->readAt(
-                    mTable->mChunkOffsetOffset + 8 + 8 * chunk,
+        if (readCached(&mChunkOffsetCache,
+                    mTable->mChunkOffsetOffset + 8 + 8 * (off64_t)chunk,
+                    mTable->mChunkOffsetOffset + 8 + 8 * (off64_t)mTable->mNumChunkOffsets,
                     &offset64,
-                    sizeof(offset64)) < (ssize_t)sizeof(offset64)) {
+                    sizeof(offset64)) != OK) {
             return ERROR_IO;
         }
 
@@ -247,13 +254,16 @@ status_t SampleIterator::getSampleSizeDirect(
         return OK;
     }
 
+    const off64_t sizesEnd = mTable->mSampleSizeOffset + 12
+            + ((off64_t)mTable->mNumSampleSizes * mTable->mSampleSizeFieldSize + 7) / 8;
+
     switch (mTable->mSampleSizeFieldSize) {
         case 32:
         {
             uint32_t x;
-            if (mTable->mDataSource->readAt(
-                        mTable->mSampleSizeOffset + 12 + 4 * sampleIndex,
-                        &x, sizeof(x)) < (ssize_t)sizeof(x)) {
+            if (readCached(&mSampleSizeCache,
+                        mTable->mSampleSizeOffset + 12 + 4 * (off64_t)sampleIndex,
+                        sizesEnd, &x, sizeof(x)) != OK) {
                 return ERROR_IO;
             }
 
@@ -264,9 +274,9 @@ status_t SampleIterator::getSampleSizeDirect(
         case 16:
         {
             uint16_t x;
-            if (mTable->mDataSource->readAt(
-                        mTable->mSampleSizeOffset + 12 + 2 * sampleIndex,
-                        &x, sizeof(x)) < (ssize_t)sizeof(x)) {
+            if (readCached(&mSampleSizeCache,
+                        mTable->mSampleSizeOffset + 12 + 2 * (off64_t)sampleIndex,
+                        sizesEnd, &x, sizeof(x)) != OK) {
                 return ERROR_IO;
             }
 
@@ -277,9 +287,9 @@ status_t SampleIterator::getSampleSizeDirect(
         case 8:
         {
             uint8_t x;
-            if (mTable->mDataSource->readAt(
+            if (readCached(&mSampleSizeCache,
                         mTable->mSampleSizeOffset + 12 + sampleIndex,
-                        &x, sizeof(x)) < (ssize_t)sizeof(x)) {
+                        sizesEnd, &x, sizeof(x)) != OK) {
                 return ERROR_IO;
             }
 
@@ -292,9 +302,9 @@ status_t SampleIterator::getSampleSizeDirect(
             CHECK_EQ(mTable->mSampleSizeFieldSize, 4u);
 
             uint8_t x;
-            if (mTable->mDataSource->readAt(
+            if (readCached(&mSampleSizeCache,
                         mTable->mSampleSizeOffset + 12 + sampleIndex / 2,
-                        &x, sizeof(x)) < (ssize_t)sizeof(x)) {
+                        sizesEnd, &x, sizeof(x)) != OK) {
                 return ERROR_IO;
             }
 
@@ -362,5 +372,31 @@ status_t SampleIterator::findSampleTimeAndDuration(
     return OK;
 }
 
+status_t SampleIterator::readCached(
+        ReadCache *cache, off64_t offset, off64_t end, void *data, size_t size) {
+    if (cache->mOffset < 0 || offset < cache->mOffset
+            || offset + (off64_t)size > cache->mOffset + (off64_t)cache->mLength) {
+        size_t length = kReadCacheSize;
+        if (end - offset < (off64_t)length) {
+            length = end > offset ? (size_t)(end - offset) : 0;
+        }
+        if (length < size) {
+            length = size;
+        }
+
+        ssize_t n = mTable->mDataSource->readAt(offset, cache->mData, length);
+        if (n < (ssize_t)size) {
+            cache->mOffset = -1;
+            cache->mLength = 0;
+            return ERROR_IO;
+        }
+        cache->mOffset = offset;
+        cache->mLength = n;
+    }
+
+    memcpy(data, cache->mData + (offset - cache->mOffset), size);
+    return OK;
+}
+
 }  // namespace android
 
@@ -129,6 +129,8 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mTimeToSampleCount(0),
       mTimeToSample(NULL),
       mSampleTimeEntries(NULL),
+      mTimeToSampleStarts(NULL),
+      mNumTimeToSampleStarts(0),
       mCompositionTimeDeltaEntries(NULL),
       mNumCompositionTimeDeltaEntries(0),
       mCompositionDeltaLookup(new CompositionDeltaLookup),
@@ -160,6 +162,9 @@ SampleTable::~SampleTable() {
     delete[] mSampleTimeEntries;
     mSampleTimeEntries = NULL;
 
+    delete[] mTimeToSampleStarts;
+    mTimeToSampleStarts = NULL;
+
     delete mSampleIterator;
     mSampleIterator = NULL;
 }
@@ -629,16 +634,94 @@ int SampleTable::CompareIncreasingTime(const void *_a, const void *_b) {
     return 0;
 }
 
+bool SampleTable::buildTimeToSampleStarts_l() {
+    if (mNumCompositionTimeDeltaEntries != 0) {
+        return false;
+    }
+
+    uint64_t allocSize = (uint64_t)mTimeToSampleCount * sizeof(TimeToSampleStart);
+    if (mTotalSize + allocSize > kMaxTotalSize) {
+        return false;
+    }
+
+    TimeToSampleStart *starts = new (std::nothrow) TimeToSampleStart[mTimeToSampleCount];
+    if (!starts) {
+        return false;
+    }
+
+    uint32_t numStarts = 0;
+    uint64_t sampleIndex = 0;
+    uint64_t sampleTime = 0;
+
+    for (uint32_t i = 0; i < mTimeToSampleCount && sampleIndex < mNumSampleSizes; ++i) {
+        uint32_t n = mTimeToSample[2 * i];
+        uint32_t delta = mTimeToSample[2 * i + 1];
+        if (n == 0) {
+            continue;
+        }
+
+        starts[numStarts].mSampleIndex = (uint32_t)sampleIndex;
+        starts[numStarts].mSampleDelta = delta;
+        starts[numStarts].mSampleTime = sampleTime;
+        ++numStarts;
+
+        sampleIndex += n;
+        uint64_t runDuration;
+        if (__builtin_mul_overflow((uint64_t)n, (uint64_t)delta, &runDuration)
+                || __builtin_add_overflow(sampleTime, runDuration, &sampleTime)) {
+            sampleTime = UINT64_MAX;
+        }
+    }
+
+    if (sampleIndex < mNumSampleSizes) {
+        // The time-to-sample table does not cover every sample, keep the
+        // behavior of the sorted table for such malformed content.
+        delete[] starts;
+        return false;
+    }
+
+    mTotalSize += allocSize;
+    mTimeToSampleStarts = starts;
+    mNumTimeToSampleStarts = numStarts;
+    return true;
+}
+
+uint64_t SampleTable::getDecodeTime(uint32_t sampleIndex) const {
+    uint32_t left = 0;
+    uint32_t right_plus_one = mNumTimeToSampleStarts;
+    while (right_plus_one - left > 1) {
+        uint32_t center = left + (right_plus_one - left) / 2;
+        if (sampleIndex < mTimeToSampleStarts[center].mSampleIndex) {
+            right_plus_one = center;
+        } else {
+            left = center;
+        }
+    }
+
+    const TimeToSampleStart &start = mTimeToSampleStarts[left];
+    uint64_t time;
+    if (__builtin_mul_overflow(
+                (uint64_t)(sampleIndex - start.mSampleIndex), (uint64_t)start.mSampleDelta, &time)
+            || __builtin_add_overflow(start.mSampleTime, time, &time)) {
+        return UINT64_MAX;
+    }
+    return time;
+}
+
 void SampleTable::buildSampleEntriesTable() {
     Mutex::Autolock autoLock(mLock);
 
-    if (mSampleTimeEntries != NULL || mNumSampleSizes == 0) {
+    if (mSampleTimeEntries != NULL || mTimeToSampleStarts != NULL || mNumSampleSizes == 0) {
         if (mNumSampleSizes == 0) {
             ALOGE("b/23247055, mNumSampleSizes(%u)", mNumSampleSizes);
         }
         return;
     }
 
+    if (buildTimeToSampleStarts_l()) {
+        return;
+    }
+
     mTotalSize += (uint64_t)mNumSampleSizes * sizeof(SampleTimeEntry);
     if (mTotalSize > kMaxTotalSize) {
         ALOGE("Sample entry table size would make sample table too large.\n"
@@ -719,7 +802,7 @@ status_t SampleTable::findSampleAtTime(
         uint32_t *sample_index, uint32_t flags) {
     buildSampleEntriesTable();
 
-    if (mSampleTimeEntries == NULL) {
+    if (mSampleTimeEntries == NULL && mTimeToSampleStarts == NULL) {
         return ERROR_OUT_OF_RANGE;
     }
 
@@ -727,7 +810,7 @@ status_t SampleTable::findSampleAtTime(
         if (req_time >= mNumSampleSizes) {
             return ERROR_OUT_OF_RANGE;
         }
-        *sample_index = mSampleTimeEntries[req_time].mSampleIndex;
+        *sample_index = getSampleIndexInTimeOrder(req_time);
         return OK;
     }
 
@@ -743,7 +826,7 @@ status_t SampleTable::findSampleAtTime(
         } else if (req_time > centerTime) {
             left = center + 1;
         } else {
-            *sample_index = mSampleTimeEntries[center].mSampleIndex;
+            *sample_index = getSampleIndexInTimeOrder(center);
             return OK;
         }
     }
@@ -792,7 +875,7 @@ status_t SampleTable::findSampleAtTime(
         }
     }
 
-    *sample_index = mSampleTimeEntries[closestIndex].mSampleIndex;
+    *sample_index = getSampleIndexInTimeOrder(closestIndex);
     return OK;
 }
 
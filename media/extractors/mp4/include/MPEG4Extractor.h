@@ -143,6 +143,7 @@ private:
     bool mIsQT;
     bool mIsHeif;
     bool mHasMoovBox;
+    bool mMoovCached;
     bool mPreferHeif;
     bool mIsAvif;
 
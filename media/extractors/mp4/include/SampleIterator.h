@@ -45,6 +45,16 @@ struct SampleIterator {
             uint32_t sampleIndex, size_t *size);
 
 private:
+    // Chunk offsets and sample sizes are read from the stco and stsz boxes in
+    // windows of this many bytes, rather than one entry at a time.
+    static const size_t kReadCacheSize = 4096;
+
+    struct ReadCache {
+        off64_t mOffset;
+        size_t mLength;
+        uint8_t mData[kReadCacheSize];
+    };
+
     SampleTable *mTable;
 
     bool mInitialized;
@@ -73,10 +83,15 @@ private:
     uint64_t mCurrentSampleTime;
     uint64_t mCurrentSampleDuration;
 
+    ReadCache mChunkOffsetCache;
+    ReadCache mSampleSizeCache;
+
     void reset();
     status_t findChunkRange(uint32_t sampleIndex);
     status_t getChunkOffset(uint32_t chunk, off64_t *offset);
     status_t findSampleTimeAndDuration(uint32_t sampleIndex, uint64_t *time, uint64_t *duration);
+    status_t readCached(
+            ReadCache *cache, off64_t offset, off64_t end, void *data, size_t size);
 
     SampleIterator(const SampleIterator &);
     SampleIterator &operator=(const SampleIterator &);
@@ -132,6 +132,17 @@ private:
     };
     SampleTimeEntry *mSampleTimeEntries;
 
+    // Without composition time offsets samples are stored in presentation
+    // order, so seeking only needs the first sample and its decode time for
+    // every time-to-sample run instead of a sorted entry per sample.
+    struct TimeToSampleStart {
+        uint32_t mSampleIndex;
+        uint32_t mSampleDelta;
+        uint64_t mSampleTime;
+    };
+    TimeToSampleStart *mTimeToSampleStarts;
+    uint32_t mNumTimeToSampleStarts;
+
     int32_t *mCompositionTimeDeltaEntries;
     size_t mNumCompositionTimeDeltaEntries;
     CompositionDeltaLookup *mCompositionDeltaLookup;
@@ -158,17 +169,30 @@ private:
     // normally we don't round
     inline uint64_t getSampleTime(
             size_t sample_index, uint64_t scale_num, uint64_t scale_den) const {
-        return (sample_index < (size_t)mNumSampleSizes && mSampleTimeEntries != NULL
-                && scale_den != 0)
+        if (sample_index >= (size_t)mNumSampleSizes || scale_den == 0) {
+            return 0;
+        }
+        if (mTimeToSampleStarts != NULL) {
+            return (getDecodeTime(sample_index) * scale_num) / scale_den;
+        }
+        return mSampleTimeEntries != NULL
                 ? (mSampleTimeEntries[sample_index].mCompositionTime * scale_num) / scale_den : 0;
     }
 
+    // Maps the index of a sample in presentation order to its sample index.
+    inline uint32_t getSampleIndexInTimeOrder(uint32_t index) const {
+        return mTimeToSampleStarts != NULL ? index : mSampleTimeEntries[index].mSampleIndex;
+    }
+
+    uint64_t getDecodeTime(uint32_t sampleIndex) const;
+
     status_t getSampleSize_l(uint32_t sample_index, size_t *sample_size);
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
 
     static int CompareIncreasingTime(const void *, const void *);
 
     void buildSampleEntriesTable();
+    bool buildTimeToSampleStarts_l();
 
     SampleTable(const SampleTable &);
     SampleTable &operator=(const SampleTable &);
@@ -34,6 +34,9 @@
 #include <system/audio.h>
 #include <utils/String8.h>
 
+#include <algorithm>
+#include <map>
+
 extern "C" {
     #include <Tremolo/codec_internal.h>
 
@@ -108,8 +111,28 @@ protected:
     struct TOCEntry {
         off64_t mPageOffset;
         int64_t mTimeUs;
+        // Granule position of the page before, so that seeking to the entry
+        // does not need to look for it.
+        uint64_t mPrevGranulePosition;
     };
 
+    // A page seen while reading or seeking a stream without a table of contents.
+    struct IndexedPage {
+        size_t mSize;
+        uint64_t mGranulePosition;
+    };
+
+    // Granule position of pages that do not end a packet.
+    static constexpr uint64_t kNoGranulePosition = ~0ull;
+    // Pages may be up to 27 + 255 + 255 * 255 bytes long.
+    static constexpr off64_t kMaxPageSize = 65307;
+    // Bisection over the page index stops when the page boundaries found are closer
+    // than this, the rest is scanned forward in a few sequential reads.
+    static constexpr off64_t kSeekScanWindow = 64 * 1024;
+    static constexpr size_t kMaxSeekProbes = 16;
+    // Bounds the memory spent on the page index.
+    static constexpr size_t kMaxIndexedPages = 4096;
+
     MediaBufferGroupHelper *mBufferGroup;
     DataSourceHelper *mSource;
     off64_t mOffset;
@@ -135,11 +158,26 @@ protected:
 
     Vector<TOCEntry> mTableOfContents;
 
+    // Pages by offset, built lazily from the pages read when there is no table
+    // of contents, and reused by later seeks.
+    std::map<off64_t, IndexedPage> mPageIndex;
+
     int32_t mHapticChannelCount;
 
     ssize_t readPage(off64_t offset, Page *page);
     status_t findNextPage(off64_t startOffset, off64_t *pageOffset);
 
+    // Reads the page at offset and adds it to the page index.
+    ssize_t readAndIndexPage(off64_t offset, Page *page);
+    void indexPage(off64_t offset, size_t size, uint64_t granulePos);
+
+    // Seeks to the page that contains timeUs by bisecting the stream between
+    // indexed pages, for streams without a table of contents.
+    status_t bisectToTime(int64_t timeUs);
+
+    // Positions the extractor at the start of the page at pageOffset.
+    void setPage(off64_t pageOffset, uint64_t prevGranulePos);
+
     virtual int64_t getTimeUsOfGranule(uint64_t granulePos) const = 0;
 
     // Extract codec format, metadata tags, and various codec specific data;
@@ -383,11 +421,24 @@ status_t MyOggExtractor::findPrevGranulePosition(
         off64_t pageOffset, uint64_t *granulePos) {
     *granulePos = 0;
 
+    // The page index may already know the page ending where this one starts.
+    auto it = mPageIndex.lower_bound(pageOffset);
+    if (it != mPageIndex.begin()) {
+        --it;
+        if (it->first + (off64_t)it->second.mSize == pageOffset
+                && it->second.mGranulePosition != kNoGranulePosition) {
+            *granulePos = it->second.mGranulePosition;
+            return OK;
+        }
+    }
+
+    // A page is never longer than kMaxPageSize, so backing up that far finds
+    // the previous page in one step.
     off64_t prevPageOffset = 0;
     off64_t prevGuess = pageOffset;
     for (;;) {
-        if (prevGuess >= 5000) {
-            prevGuess -= 5000;
+        if (prevGuess >= kMaxPageSize) {
+            prevGuess -= kMaxPageSize;
         } else {
             prevGuess = 0;
         }
@@ -397,7 +448,7 @@ status_t MyOggExtractor::findPrevGranulePosition(
         status_t err = findNextPage(prevGuess, &prevPageOffset);
         if (err == ERROR_END_OF_STREAM) {
             // We are at the last page and didn't back off enough;
-            // back off 5000 bytes more and try again.
+            // back off more and try again.
             continue;
         } else if (err != OK) {
             return err;
@@ -418,7 +469,7 @@ status_t MyOggExtractor::findPrevGranulePosition(
     uint8_t flag = 0;
     for (;;) {
         Page prevPage;
-        ssize_t n = readPage(prevPageOffset, &prevPage);
+        ssize_t n = readAndIndexPage(prevPageOffset, &prevPage);
 
         if (n <= 0) {
             return (flag & 0x4) ? OK : (status_t)n;
@@ -439,16 +490,7 @@ status_t MyOggExtractor::seekToTime(int64_t timeUs) {
     }
 
     if (mTableOfContents.isEmpty()) {
-        // Perform approximate seeking based on avg. bitrate.
-        uint64_t bps = approxBitrate();
-        if (bps <= 0) {
-            return INVALID_OPERATION;
-        }
-
-        off64_t pos = timeUs * bps / 8000000ll;
-
-        ALOGV("seeking to offset %lld", (long long)pos);
-        return seekToOffset(pos);
+        return bisectToTime(timeUs);
     }
 
     size_t left = 0;
@@ -477,7 +519,130 @@ status_t MyOggExtractor::seekToTime(int64_t timeUs) {
     ALOGV("seeking to entry %zu / %zu at offset %lld",
          left, mTableOfContents.size(), (long long)entry.mPageOffset);
 
-    return seekToOffset(entry.mPageOffset);
+    setPage(entry.mPageOffset, entry.mPrevGranulePosition);
+    return OK;
+}
+
+status_t MyOggExtractor::bisectToTime(int64_t timeUs) {
+    // The target page lies in [low, high): low is the end of a page that ends
+    // before timeUs, high the start of a page that ends at or after it.
+    // The times at low and high, if known, to interpolate the next probe.
+    off64_t low = mFirstDataOffset >= 0 ? mFirstDataOffset : 0;
+    int64_t lowTimeUs = 0;
+    off64_t high = -1;
+    int64_t highTimeUs = -1;
+    off64_t size;
+    if (mSource->getSize(&size) == OK) {
+        high = size;
+    }
+    for (auto it = mPageIndex.lower_bound(low); it != mPageIndex.end(); ++it) {
+        const auto &entry = *it;
+        if (entry.second.mGranulePosition == kNoGranulePosition) {
+            continue;
+        }
+        int64_t entryTimeUs = getTimeUsOfGranule(entry.second.mGranulePosition);
+        if (entryTimeUs < timeUs) {
+            low = entry.first + (off64_t)entry.second.mSize;
+            lowTimeUs = entryTimeUs;
+        } else {
+            // pages are in time order, the first one at or after timeUs is the bound
+            high = entry.first;
+            highTimeUs = entryTimeUs;
+            break;
+        }
+    }
+
+    uint64_t bps = approxBitrate();
+    if (high < 0 && bps <= 0) {
+        return INVALID_OPERATION;
+    }
+
+    Page page;
+    for (size_t probes = 0; probes < kMaxSeekProbes
+            && (high < 0 || high - low > kSeekScanWindow); ++probes) {
+        off64_t probe;
+        if (probes == 0 && bps > 0) {
+            // Start where the average bitrate puts the target.
+            probe = (off64_t)(timeUs * bps / 8000000ll);
+            probe = std::max(probe, low);
+            if (high >= 0) {
+                probe = std::min(probe, high - 1);
+            }
+        } else if (high >= 0 && highTimeUs > lowTimeUs) {
+            // Interpolate, but keep clear of the bounds so each probe narrows them.
+            off64_t margin = std::min(kSeekScanWindow / 2, (high - low) / 4);
+            probe = low + (off64_t)((double)(high - low)
+                    * (timeUs - lowTimeUs) / (highTimeUs - lowTimeUs));
+            probe = std::clamp(probe, low + margin, high - margin);
+        } else if (high >= 0) {
+            probe = low + (high - low) / 2;
+        } else {
+            probe = low + std::max(low - (mFirstDataOffset >= 0 ? mFirstDataOffset : 0),
+                    kSeekScanWindow);
+        }
+
+        // Use the first page after the probe that ends a packet.
+        off64_t pageOffset;
+        ssize_t n = 0;
+        status_t err = findNextPage(probe, &pageOffset);
+        while (err == OK && (high < 0 || pageOffset < high)) {
+            n = readAndIndexPage(pageOffset, &page);
+            if (n == AMEDIA_ERROR_MALFORMED) {
+                // "OggS" inside packet data, keep looking
+                err = findNextPage(pageOffset + 1, &pageOffset);
+                continue;
+            }
+            if (n <= 0 || page.mGranulePosition != kNoGranulePosition) {
+                break;
+            }
+            pageOffset += n;
+        }
+        if (err != OK || n <= 0 || (high >= 0 && pageOffset >= high)) {
+            // nothing usable between the probe and high
+            high = probe;
+            continue;
+        }
+        int64_t pageTimeUs = getTimeUsOfGranule(page.mGranulePosition);
+        ALOGV("probe at %lld: page at %lld ends at %lld us", (long long)probe,
+                (long long)pageOffset, (long long)pageTimeUs);
+        if (pageTimeUs < timeUs) {
+            low = pageOffset + n;
+            lowTimeUs = pageTimeUs;
+        } else {
+            high = pageOffset;
+            highTimeUs = pageTimeUs;
+        }
+    }
+
+    // Scan forward from low to the first page that ends at or after timeUs.
+    off64_t pageOffset;
+    status_t err = findNextPage(low, &pageOffset);
+    if (err != OK) {
+        return err;
+    }
+    uint64_t prevGranulePos = kNoGranulePosition;
+    for (;;) {
+        ssize_t n = readAndIndexPage(pageOffset, &page);
+        if (n <= 0) {
+            // past the last page, play from the last one found
+            break;
+        }
+        if (page.mGranulePosition != kNoGranulePosition
+                && getTimeUsOfGranule(page.mGranulePosition) >= timeUs) {
+            break;
+        }
+        if (page.mGranulePosition != kNoGranulePosition) {
+            prevGranulePos = page.mGranulePosition;
+        }
+        pageOffset += n;
+    }
+
+    ALOGV("seeking to page at offset %lld", (long long)pageOffset);
+    if (prevGranulePos == kNoGranulePosition) {
+        return seekToOffset(pageOffset);
+    }
+    setPage(pageOffset, prevGranulePos);
+    return OK;
 }
 
 status_t MyOggExtractor::seekToOffset(off64_t offset) {
@@ -497,7 +662,15 @@ status_t MyOggExtractor::seekToOffset(off64_t offset) {
     // We found the page we wanted to seek to, but we'll also need
     // the page preceding it to determine how many valid samples are on
     // this page.
-    findPrevGranulePosition(pageOffset, &mPrevGranulePosition);
+    uint64_t prevGranulePos;
+    findPrevGranulePosition(pageOffset, &prevGranulePos);
+    setPage(pageOffset, prevGranulePos);
+
+    return OK;
+}
+
+void MyOggExtractor::setPage(off64_t pageOffset, uint64_t prevGranulePos) {
+    mPrevGranulePosition = prevGranulePos;
 
     mOffset = pageOffset;
 
@@ -509,8 +682,22 @@ status_t MyOggExtractor::seekToOffset(off64_t offset) {
     mNextLaceIndex = 0;
 
     // XXX what if new page continues packet from last???
+}
 
-    return OK;
+ssize_t MyOggExtractor::readAndIndexPage(off64_t offset, Page *page) {
+    ssize_t n = readPage(offset, page);
+    if (n > 0) {
+        indexPage(offset, n, page->mGranulePosition);
+    }
+    return n;
+}
+
+void MyOggExtractor::indexPage(off64_t offset, size_t size, uint64_t granulePos) {
+    // The table of contents already covers every page.
+    if (!mTableOfContents.isEmpty() || mPageIndex.size() >= kMaxIndexedPages) {
+        return;
+    }
+    mPageIndex.emplace(offset, IndexedPage{size, granulePos});
 }
 
 ssize_t MyOggExtractor::readPage(off64_t offset, Page *page) {
@@ -870,7 +1057,7 @@ media_status_t MyOggExtractor::_readNextPacket(MediaBufferHelper **out, bool cal
 
         mOffset += mCurrentPageSize;
         uint8_t flag = mCurrentPage.mFlags;
-        ssize_t n = readPage(mOffset, &mCurrentPage);
+        ssize_t n = readAndIndexPage(mOffset, &mCurrentPage);
 
         if (n <= 0) {
             if (buffer) {
@@ -965,6 +1152,8 @@ status_t MyOggExtractor::init() {
 
 void MyOggExtractor::buildTableOfContents() {
     off64_t offset = mFirstDataOffset;
+    // The last header page read by init() precedes the first data page.
+    uint64_t prevGranulePos = mPrevGranulePosition;
     Page page;
     ssize_t pageSize;
     while ((pageSize = readPage(offset, &page)) > 0) {
@@ -975,15 +1164,20 @@ void MyOggExtractor::buildTableOfContents() {
 
         entry.mPageOffset = offset;
         entry.mTimeUs = getTimeUsOfGranule(page.mGranulePosition);
+        entry.mPrevGranulePosition = prevGranulePos;
+        prevGranulePos = page.mGranulePosition;
 
         offset += (size_t)pageSize;
     }
 
+    // The page index is only needed without a table of contents.
+    mPageIndex.clear();
+
     // Limit the maximum amount of RAM we spend on the table of contents,
     // if necessary thin out the table evenly to trim it down to maximum
     // size.
 
-    static const size_t kMaxTOCSize = 8192;
+    static const size_t kMaxTOCSize = 12288;
     static const size_t kMaxNumTOCEntries = kMaxTOCSize / sizeof(TOCEntry);
 
     size_t numerator = mTableOfContents.size();
@@ -1378,7 +1572,7 @@ media_status_t OggExtractor::getMetaData(AMediaFormat *meta) {
 static CMediaExtractor* CreateExtractor(
         CDataSource *source,
         void *) {
-    return wrap(new OggExtractor(new DataSourceHelper(source)));
+    return wrap(new OggExtractor(new BufferedDataSourceHelper(source)));
 }
 
 static CreatorFunc Sniff(
@@ -57,6 +57,41 @@ enum {
     WAVE_FORMAT_EXTENSIBLE = 0xFFFE
 };
 
+// With media.extractor.wav.native_pcm set, MediaServer also gets PCM in the
+// encoding of the file, so that no conversion happens in the extractor; the
+// raw decoder and the audio sink take 24 and 32 bit PCM as well.
+static int32_t getExtractorOutputEncoding(uint16_t waveFormat, int bitsPerSample)
+{
+    if (shouldExtractorOutputFloat(bitsPerSample)
+            && android::base::GetBoolProperty("media.extractor.wav.native_pcm", false)) {
+        if (waveFormat == WAVE_FORMAT_PCM) {
+            switch (bitsPerSample) {
+            case 24:
+                return kAudioEncodingPcm24bitPacked;
+            case 32:
+                return kAudioEncodingPcm32bit;
+            }
+        } else if (waveFormat == WAVE_FORMAT_IEEE_FLOAT) {
+            return kAudioEncodingPcmFloat;
+        }
+    }
+    return shouldExtractorOutputFloat(bitsPerSample)
+            ? kAudioEncodingPcmFloat : kAudioEncodingPcm16bit;
+}
+
+static size_t getBytesPerSample(int32_t encoding)
+{
+    switch (encoding) {
+    case kAudioEncodingPcm24bitPacked:
+        return 3;
+    case kAudioEncodingPcm32bit:
+    case kAudioEncodingPcmFloat:
+        return 4;
+    default:
+        return 2;
+    }
+}
+
 static const char* WAVEEXT_SUBFORMAT = "\x00\x00\x00\x00\x10\x00\x80\x00\x00\xAA\x00\x38\x9B\x71";
 static const char* AMBISONIC_SUBFORMAT = "\x00\x00\x21\x07\xD3\x11\x86\x44\xC8\xC1\xCA\x00\x00\x00";
 
@@ -73,7 +108,7 @@ struct WAVSource : public MediaTrackHelper {
             DataSourceHelper *dataSource,
             AMediaFormat *meta,
             uint16_t waveFormat,
-            bool outputFloat,
+            int32_t outputEncoding,
             off64_t offset, size_t size);
 
     virtual media_status_t start();
@@ -89,12 +124,18 @@ protected:
     virtual ~WAVSource();
 
 private:
+    // Smallest buffer, used as is for low rate streams.
     static const size_t kMaxFrameSize;
+    // Buffers hold this much audio, so high resolution streams read in larger chunks.
+    static const int64_t kBufferDurationUs = 20000;
+    static const size_t kMaxBufferSize = 1024 * 1024;
 
     DataSourceHelper *mDataSource;
     AMediaFormat *mMeta;
     uint16_t mWaveFormat;
+    const int32_t mOutputEncoding;
     const bool mOutputFloat;
+    size_t mBufferSize;
     uint32_t mSampleRate;
     uint32_t mNumChannels;
     uint32_t mBitsPerSample;
@@ -140,7 +181,8 @@ MediaTrackHelper *WAVExtractor::getTrack(size_t index) {
 
     return new WAVSource(
             mDataSource, mTrackMeta,
-            mWaveFormat, shouldExtractorOutputFloat(mBitsPerSample), mDataOffset, mDataSize);
+            mWaveFormat, getExtractorOutputEncoding(mWaveFormat, mBitsPerSample),
+            mDataOffset, mDataSize);
 }
 
 media_status_t WAVExtractor::getTrackMetaData(
@@ -153,8 +195,7 @@ media_status_t WAVExtractor::getTrackMetaData(
     const media_status_t status = AMediaFormat_copy(meta, mTrackMeta);
     if (status == OK) {
         AMediaFormat_setInt32(meta, AMEDIAFORMAT_KEY_PCM_ENCODING,
-                shouldExtractorOutputFloat(mBitsPerSample)
-                        ? kAudioEncodingPcmFloat : kAudioEncodingPcm16bit);
+                getExtractorOutputEncoding(mWaveFormat, mBitsPerSample));
     }
     return status;
 }
@@ -370,18 +411,30 @@ WAVSource::WAVSource(
         DataSourceHelper *dataSource,
         AMediaFormat *meta,
         uint16_t waveFormat,
-        bool outputFloat,
+        int32_t outputEncoding,
         off64_t offset, size_t size)
     : mDataSource(dataSource),
       mMeta(meta),
       mWaveFormat(waveFormat),
-      mOutputFloat(outputFloat),
+      mOutputEncoding(outputEncoding),
+      mOutputFloat(outputEncoding == kAudioEncodingPcmFloat),
       mOffset(offset),
       mSize(size),
       mStarted(false) {
     CHECK(AMediaFormat_getInt32(mMeta, AMEDIAFORMAT_KEY_SAMPLE_RATE, (int32_t*) &mSampleRate));
     CHECK(AMediaFormat_getInt32(mMeta, AMEDIAFORMAT_KEY_CHANNEL_COUNT, (int32_t*) &mNumChannels));
     CHECK(AMediaFormat_getInt32(mMeta, AMEDIAFORMAT_KEY_BITS_PER_SAMPLE, (int32_t*) &mBitsPerSample));
+
+    // media.extractor.wav.buffer_size overrides the buffer size, in bytes.
+    mBufferSize = android::base::GetUintProperty<size_t>(
+            "media.extractor.wav.buffer_size", 0, kMaxBufferSize);
+    if (mBufferSize == 0) {
+        const uint64_t bytesPerSecond = (uint64_t)mSampleRate * mNumChannels
+                * getBytesPerSample(mOutputEncoding);
+        mBufferSize = std::min((uint64_t)kMaxBufferSize,
+                bytesPerSecond * kBufferDurationUs / 1000000);
+    }
+    mBufferSize = std::max(mBufferSize, kMaxFrameSize);
 }
 
 WAVSource::~WAVSource() {
@@ -396,7 +449,7 @@ media_status_t WAVSource::start() {
     CHECK(!mStarted);
 
     // some WAV files may have large audio buffers that use shared memory transfer.
-    if (!mBufferGroup->init(4 /* buffers */, kMaxFrameSize)) {
+    if (!mBufferGroup->init(4 /* buffers */, mBufferSize)) {
         return AMEDIA_ERROR_UNKNOWN;
     }
 
@@ -422,9 +475,8 @@ media_status_t WAVSource::getFormat(AMediaFormat *meta) {
 
     const media_status_t status = AMediaFormat_copy(meta, mMeta);
     if (status == OK) {
-        AMediaFormat_setInt32(meta, AMEDIAFORMAT_KEY_MAX_INPUT_SIZE, kMaxFrameSize);
-        AMediaFormat_setInt32(meta, AMEDIAFORMAT_KEY_PCM_ENCODING,
-                mOutputFloat ? kAudioEncodingPcmFloat : kAudioEncodingPcm16bit);
+        AMediaFormat_setInt32(meta, AMEDIAFORMAT_KEY_MAX_INPUT_SIZE, mBufferSize);
+        AMediaFormat_setInt32(meta, AMEDIAFORMAT_KEY_PCM_ENCODING, mOutputEncoding);
     }
     return status;
 }
@@ -466,12 +518,14 @@ media_status_t WAVSource::read(
     }
 
     // maxBytesToRead may be reduced so that in-place data conversion will fit in buffer size.
-    const size_t bufferSize = std::min(buffer->size(), kMaxFrameSize);
+    const size_t bufferSize = std::min(buffer->size(), mBufferSize);
+    const size_t outputBytesPerSample = getBytesPerSample(mOutputEncoding);
     size_t maxBytesToRead;
-    if (mOutputFloat) { // destination is float at 4 bytes per sample, source may be less.
-        maxBytesToRead = (mBitsPerSample / 8) * (bufferSize / 4);
-    } else { // destination is int16_t at 2 bytes per sample, only source of 8 bits is less.
-        maxBytesToRead = mBitsPerSample == 8 ? bufferSize / 2 : bufferSize;
+    if (mBitsPerSample >= 8 && outputBytesPerSample > mBitsPerSample / 8u) {
+        // destination samples are larger than the source
+        maxBytesToRead = (mBitsPerSample / 8) * (bufferSize / outputBytesPerSample);
+    } else {
+        maxBytesToRead = bufferSize;
     }
 
     const size_t maxBytesAvailable =
@@ -508,8 +562,10 @@ media_status_t WAVSource::read(
 
     buffer->set_range(0, n);
 
-    // TODO: add capability to return data as float PCM instead of 16 bit PCM.
-    if (mWaveFormat == WAVE_FORMAT_PCM) {
+    if (mWaveFormat == WAVE_FORMAT_PCM
+            && outputBytesPerSample == mBitsPerSample / 8u && !mOutputFloat) {
+        // native encoding, no conversion needed
+    } else if (mWaveFormat == WAVE_FORMAT_PCM) {
         const size_t bytesPerFrame = (mBitsPerSample >> 3) * mNumChannels;
         const size_t numFrames = n / bytesPerFrame;
         const size_t numSamples = numFrames * mNumChannels;
@@ -133,31 +133,23 @@ inline status_t EndianOutput::writeHelper(const T* buf, size_t offset, size_t co
     assert(offset <= count);
     status_t res = OK;
     size_t size = sizeof(T);
-    switch(mEndian) {
-        case BIG: {
-            for (size_t i = offset; i < count; ++i) {
-                T tmp = convertToBigEndian<T>(buf[offset + i]);
-                if ((res = mOutput->write(reinterpret_cast<uint8_t*>(&tmp), 0, size))
-                        != OK) {
-                    return res;
-                }
-                mOffset += size;
-            }
-            break;
-        }
-        case LITTLE: {
-            for (size_t i = offset; i < count; ++i) {
-                T tmp = convertToLittleEndian<T>(buf[offset + i]);
-                if ((res = mOutput->write(reinterpret_cast<uint8_t*>(&tmp), 0, size))
-                        != OK) {
-                    return res;
-                }
-                mOffset += size;
+    if (mEndian != BIG && mEndian != LITTLE) {
+        return BAD_VALUE;
+    }
+    // Convert into a small chunk so that the wrapped output sees few large writes.
+    const size_t chunkCount = 64;
+    T chunk[chunkCount];
+    size_t pending = 0;
+    for (size_t i = offset; i < count; ++i) {
+        chunk[pending++] = (mEndian == BIG) ? convertToBigEndian<T>(buf[offset + i])
+                                            : convertToLittleEndian<T>(buf[offset + i]);
+        if (pending == chunkCount || i + 1 == count) {
+            if ((res = mOutput->write(reinterpret_cast<uint8_t*>(chunk), 0, pending * size))
+                    != OK) {
+                return res;
             }
-            break;
-        }
-        default: {
-            return BAD_VALUE;
+            mOffset += pending * size;
+            pending = 0;
         }
     }
     return res;
@@ -256,6 +256,9 @@ class ANDROID_API TiffWriter : public LightRefBase<TiffWriter> {
         };
 
         sp<TiffIfd> findLastIfd();
+        status_t writeWithStrips(Output* out, StripSource** sources, size_t sourcesCount,
+                Endianness end);
+        status_t writeHeader(Output* out, Endianness end);
         status_t writeFileHeader(EndianOutput& out);
         const TagDefinition_t* lookupDefinition(uint16_t tag) const;
         status_t calculateOffsets();
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BufferedOutput"
+
+#include <img_utils/BufferedOutput.h>
+
+#include <utils/Log.h>
+
+#include <string.h>
+
+namespace android {
+namespace img_utils {
+
+BufferedOutput::BufferedOutput(Output* out, size_t bufferSize)
+        : mOutput(out), mBuffer(bufferSize), mBufferedCount(0) {}
+
+BufferedOutput::~BufferedOutput() {
+    if (mBufferedCount > 0) {
+        ALOGW("%s: Destructor called with %zu bytes not flushed.", __FUNCTION__,
+                mBufferedCount);
+    }
+}
+
+status_t BufferedOutput::open() {
+    mBufferedCount = 0;
+    return mOutput->open();
+}
+
+status_t BufferedOutput::write(const uint8_t* buf, size_t offset, size_t count) {
+    if (count <= mBuffer.size() - mBufferedCount) {
+        memcpy(mBuffer.data() + mBufferedCount, buf + offset, count);
+        mBufferedCount += count;
+        return OK;
+    }
+
+    status_t res = OK;
+    if ((res = flush()) != OK) {
+        return res;
+    }
+    if (count >= mBuffer.size()) {
+        return mOutput->write(buf, offset, count);
+    }
+    memcpy(mBuffer.data(), buf + offset, count);
+    mBufferedCount = count;
+    return OK;
+}
+
+status_t BufferedOutput::flush() {
+    if (mBufferedCount == 0) {
+        return OK;
+    }
+    status_t res = mOutput->write(mBuffer.data(), 0, mBufferedCount);
+    mBufferedCount = 0;
+    if (res != OK) {
+        ALOGE("%s: Could not write buffered bytes, received %d.", __FUNCTION__, res);
+    }
+    return res;
+}
+
+status_t BufferedOutput::close() {
+    status_t res = flush();
+    status_t closeRes = mOutput->close();
+    return res != OK ? res : closeRes;
+}
+
+} /*namespace img_utils*/
+} /*namespace android*/
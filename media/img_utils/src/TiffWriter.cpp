@@ -16,6 +16,7 @@
 
 #define LOG_TAG "TiffWriter"
 
+#include <img_utils/BufferedOutput.h>
 #include <img_utils/TiffHelpers.h>
 #include <img_utils/TiffWriter.h>
 #include <img_utils/TagDefinitions.h>
@@ -58,6 +59,16 @@ TiffWriter::~TiffWriter() {}
 
 status_t TiffWriter::write(Output* out, StripSource** sources, size_t sourcesCount,
         Endianness end) {
+    // Entries and strip rows arrive in many small writes, collect them before they
+    // reach the output.
+    BufferedOutput bufOut(out);
+    status_t ret = writeWithStrips(&bufOut, sources, sourcesCount, end);
+    status_t flushRet = bufOut.flush();
+    return ret != OK ? ret : flushRet;
+}
+
+status_t TiffWriter::writeWithStrips(Output* out, StripSource** sources, size_t sourcesCount,
+        Endianness end) {
     status_t ret = OK;
     EndianOutput endOut(out, end);
 
@@ -130,6 +141,13 @@ status_t TiffWriter::write(Output* out, StripSource** sources, size_t sourcesCou
 }
 
 status_t TiffWriter::write(Output* out, Endianness end) {
+    BufferedOutput bufOut(out);
+    status_t ret = writeHeader(&bufOut, end);
+    status_t flushRet = bufOut.flush();
+    return ret != OK ? ret : flushRet;
+}
+
+status_t TiffWriter::writeHeader(Output* out, Endianness end) {
     status_t ret = OK;
     EndianOutput endOut(out, end);
 
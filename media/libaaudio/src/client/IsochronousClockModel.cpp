@@ -20,6 +20,7 @@
 
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
+#include <math.h>
 #include <stdint.h>
 #include <algorithm>
 
@@ -61,6 +62,7 @@ void IsochronousClockModel::start(int64_t nanoTime) {
     ALOGV("start(nanos = %lld)\n", (long long) nanoTime);
     mMarkerNanoTime = nanoTime;
     mState = STATE_STARTING;
+    mDriftEstimator.reset();
     if (mHistogramMicros) {
         mHistogramMicros->clear();
     }
@@ -129,6 +131,7 @@ void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nano
         if (mHistogramMicros) {
             mHistogramMicros->add(latenessNanos / AAUDIO_NANOS_PER_MICROSECOND);
         }
+        updateDriftEstimate(framePosition, nanoTime);
         // Modify estimated position based on lateness.
         // This affects the "early" side of the window, which controls output glitches.
         if (latenessNanos < 0) {
@@ -151,7 +154,17 @@ void IsochronousClockModel::processTimestamp(int64_t framePosition, int64_t nano
             // by the code in the earlier branch.
             // The two opposing forces should allow the model to track the real clock
             // over a long time.
-            int64_t driftingTime = mMarkerNanoTime + expectedNanosDelta + kDriftNanos;
+            // Once the rate of a slow clock is known, drift by as much as it predicts,
+            // so the model does not lag behind it, but never past the timestamp.
+            int64_t driftNanos = kDriftNanos;
+            if (isDriftConfident()) {
+                const double nominalSlope = (double) AAUDIO_NANOS_PER_SECOND / mSampleRate;
+                const double predictedNanos =
+                        (mDriftEstimator.getSlope() - nominalSlope) * framesDelta;
+                driftNanos = std::max((int64_t) kDriftNanos,
+                        std::min((int64_t) predictedNanos, latenessNanos));
+            }
+            int64_t driftingTime = mMarkerNanoTime + expectedNanosDelta + driftNanos;
             setPositionAndTime(framePosition,  driftingTime);
 #if ICM_LOG_DRIFT
             ALOGD("%s() - STATE_RUNNING - #%d, DRIFT, lateness = %d micros",
@@ -202,6 +215,89 @@ void IsochronousClockModel::setFramesPerBurst(int32_t framesPerBurst) {
 // Update expected lateness based on sampleRate and framesPerBurst
 void IsochronousClockModel::update() {
     mBurstPeriodNanos = convertDeltaPositionToTime(mFramesPerBurst); // uses mSampleRate
+    mDriftEstimator.reset();
+}
+
+void IsochronousClockModel::updateDriftEstimate(int64_t framePosition, int64_t nanoTime) {
+    if (mDriftEstimator.getCount() >= kMinTimestampsForConfidence) {
+        const double glitchNanos = kGlitchJitters
+                * std::max(mDriftEstimator.getJitterNanos(), (double) mBurstPeriodNanos);
+        const double residualNanos = mDriftEstimator.getResidualNanos(framePosition, nanoTime);
+        if (fabs(residualNanos) > glitchNanos) {
+            ALOGD("%s() - #%d, glitch of %d micros, restart drift estimate",
+                  __func__, mTimestampCount, (int) (residualNanos / 1000));
+            mDriftEstimator.reset();
+        }
+    }
+    mDriftEstimator.add(framePosition, nanoTime);
+}
+
+bool IsochronousClockModel::isDriftConfident() const {
+    if (mDriftEstimator.getCount() < kMinTimestampsForConfidence
+            || mDriftEstimator.getPositionDeviationFrames() <
+                    kMinBurstsForConfidence * mFramesPerBurst) {
+        return false;
+    }
+    const double nominalSlope = (double) AAUDIO_NANOS_PER_SECOND / mSampleRate;
+    return mDriftEstimator.getSlopeDeviation() / nominalSlope * 1e6 < kMaxDriftErrorPpm;
+}
+
+double IsochronousClockModel::getDriftPpm() const {
+    if (mDriftEstimator.getCount() < 2) {
+        return 0.0;
+    }
+    const double nominalSlope = (double) AAUDIO_NANOS_PER_SECOND / mSampleRate;
+    return (mDriftEstimator.getSlope() - nominalSlope) / nominalSlope * 1e6;
+}
+
+void IsochronousClockModel::DriftEstimator::reset() {
+    *this = DriftEstimator();
+}
+
+// Exponentially weighted means and covariances, updated incrementally so that
+// large positions and times do not lose precision.
+void IsochronousClockModel::DriftEstimator::add(int64_t framePosition, int64_t nanoTime) {
+    mCount++;
+    mWeight = mWeight * kForgetFactor + 1.0;
+    const double alpha = 1.0 / mWeight;
+    const double positionDelta = framePosition - mMeanPosition;
+    const double timeDelta = nanoTime - mMeanTime;
+    mMeanPosition += alpha * positionDelta;
+    mMeanTime += alpha * timeDelta;
+    mCovPositionPosition = (1.0 - alpha)
+            * (mCovPositionPosition + alpha * positionDelta * positionDelta);
+    mCovPositionTime = (1.0 - alpha) * (mCovPositionTime + alpha * positionDelta * timeDelta);
+    mCovTimeTime = (1.0 - alpha) * (mCovTimeTime + alpha * timeDelta * timeDelta);
+}
+
+double IsochronousClockModel::DriftEstimator::getPositionDeviationFrames() const {
+    return sqrt(mCovPositionPosition);
+}
+
+double IsochronousClockModel::DriftEstimator::getSlope() const {
+    return (mCovPositionPosition > 0.0) ? mCovPositionTime / mCovPositionPosition : 0.0;
+}
+
+double IsochronousClockModel::DriftEstimator::getSlopeDeviation() const {
+    if (mCovPositionPosition <= 0.0 || mWeight <= 2.0) {
+        return INFINITY;
+    }
+    return getJitterNanos() / sqrt(mCovPositionPosition * (mWeight - 2.0));
+}
+
+double IsochronousClockModel::DriftEstimator::getJitterNanos() const {
+    if (mCovPositionPosition <= 0.0) {
+        return 0.0;
+    }
+    const double residualVariance = mCovTimeTime
+            - mCovPositionTime * mCovPositionTime / mCovPositionPosition;
+    return sqrt(std::max(0.0, residualVariance));
+}
+
+double IsochronousClockModel::DriftEstimator::getResidualNanos(int64_t framePosition,
+                                                                int64_t nanoTime) const {
+    const double predictedTime = mMeanTime + getSlope() * (framePosition - mMeanPosition);
+    return nanoTime - predictedTime;
 }
 
 int64_t IsochronousClockModel::convertDeltaPositionToTime(int64_t framesDelta) const {
@@ -245,7 +341,14 @@ int64_t IsochronousClockModel::convertTimeToPosition(int64_t nanoTime) const {
 }
 
 int32_t IsochronousClockModel::getLateTimeOffsetNanos() const {
-    return mMaxMeasuredLatenessNanos + kExtraLatenessNanos;
+    int32_t extraLatenessNanos = kExtraLatenessNanos;
+    if (isDriftConfident()) {
+        // The measured jitter tells how far past the latest lateness seen a timestamp may be.
+        extraLatenessNanos = std::clamp(
+                (int32_t) (kExtraLatenessJitters * mDriftEstimator.getJitterNanos()),
+                kMinExtraLatenessNanos, kExtraLatenessNanos);
+    }
+    return mMaxMeasuredLatenessNanos + extraLatenessNanos;
 }
 
 int64_t IsochronousClockModel::convertPositionToLatestTime(int64_t framePosition) const {
@@ -263,6 +366,9 @@ void IsochronousClockModel::dump() const {
     ALOGD("mFramesPerBurst      = %6d", mFramesPerBurst);
     ALOGD("mMaxMeasuredLatenessNanos = %6d", mMaxMeasuredLatenessNanos);
     ALOGD("mState               = %6d", mState);
+    ALOGD("drift                = %8.1f ppm, jitter = %d micros, %s",
+          getDriftPpm(), (int) (mDriftEstimator.getJitterNanos() / 1000),
+          isDriftConfident() ? "confident" : "not confident");
 }
 
 void IsochronousClockModel::dumpHistogram() const {
@@ -123,6 +123,17 @@ public:
      */
     int64_t convertDeltaTimeToPosition(int64_t nanosDelta) const;
 
+    /**
+     * @return true if enough consistent timestamps were received to trust the drift estimate
+     */
+    bool isDriftConfident() const;
+
+    /**
+     * @return estimated rate error of the hardware clock in parts per million,
+     *         positive if the hardware is slower than the nominal sample rate
+     */
+    double getDriftPpm() const;
+
     void dump() const;
 
     void dumpHistogram() const;
@@ -132,6 +143,43 @@ private:
     int32_t getLateTimeOffsetNanos() const;
     void update();
 
+    /**
+     * Fits the time of the timestamps as a linear function of their position,
+     * weighting recent timestamps more, to estimate the actual rate of the hardware clock
+     * and the jitter of the timestamps around it.
+     */
+    class DriftEstimator {
+    public:
+        void reset();
+        void add(int64_t framePosition, int64_t nanoTime);
+        int32_t getCount() const { return mCount; }
+        // Spread of the positions of the recent timestamps.
+        double getPositionDeviationFrames() const;
+        // Measured nanoseconds per frame.
+        double getSlope() const;
+        // Standard error of getSlope().
+        double getSlopeDeviation() const;
+        // Deviation of the timestamps from the fitted line.
+        double getJitterNanos() const;
+        // Distance of a timestamp from the fitted line.
+        double getResidualNanos(int64_t framePosition, int64_t nanoTime) const;
+
+    private:
+        // Each timestamp decays the weight of the earlier ones by this factor.
+        static constexpr double kForgetFactor = 0.99;
+
+        int32_t mCount = 0;
+        double  mWeight = 0.0;
+        double  mMeanPosition = 0.0;
+        double  mMeanTime = 0.0;
+        double  mCovPositionPosition = 0.0;
+        double  mCovPositionTime = 0.0;
+        double  mCovTimeTime = 0.0;
+    };
+
+    // Called for every timestamp while running.
+    void updateDriftEstimate(int64_t framePosition, int64_t nanoTime);
+
     enum clock_model_state_t {
         STATE_STOPPED,
         STATE_STARTING,
@@ -145,6 +193,20 @@ private:
     static constexpr int32_t   kExtraLatenessNanos = 100 * 1000;
     // Initial small threshold for causing a drift later in time.
     static constexpr int32_t   kInitialLatenessForDriftNanos = 10 * 1000;
+    // Smallest safety margin used once the timestamp jitter is known.
+    static constexpr int32_t   kMinExtraLatenessNanos = 20 * 1000;
+    // Safety margin in units of the timestamp jitter, once the jitter is known.
+    static constexpr int32_t   kExtraLatenessJitters = 2;
+
+    // Timestamps needed before the drift estimate is trusted.
+    static constexpr int32_t   kMinTimestampsForConfidence = 32;
+    // The positions of the timestamps must span at least this many bursts.
+    static constexpr int32_t   kMinBurstsForConfidence = 4;
+    // Maximum uncertainty of the estimated rate when it is trusted.
+    static constexpr double    kMaxDriftErrorPpm = 200.0;
+    // A timestamp this many times the jitter (or burst period) off the fit is a glitch,
+    // for example after an underrun in the DSP, and restarts the estimate.
+    static constexpr int32_t   kGlitchJitters = 8;
 
     static constexpr int32_t   kHistogramBinWidthMicros = 50;
     static constexpr int32_t   kHistogramBinCount = 128;
@@ -162,6 +224,8 @@ private:
 
     int32_t             mTimestampCount = 0;  // For logging.
 
+    DriftEstimator      mDriftEstimator;
+
     // distribution of timestamps relative to earliest
     std::unique_ptr<android::audio_utils::Histogram>   mHistogramMicros;
 
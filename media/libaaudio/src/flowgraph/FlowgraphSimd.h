@@ -0,0 +1,236 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOWGRAPH_SIMD_H
+#define FLOWGRAPH_SIMD_H
+
+#include <algorithm>
+#include <stdint.h>
+
+#include "FlowGraphNode.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FLOWGRAPH_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FLOWGRAPH_USE_SSE2 1
+#endif
+
+namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph::simd {
+
+/**
+ * Vector kernels for the per-sample loops in the flowgraph nodes.
+ *
+ * Each kernel processes four floats at a time with NEON or SSE2 when the target
+ * supports it and finishes the remainder with the same scalar loop that the node
+ * used before, so the result of the scalar fallback is identical on every target.
+ * The selection is made at compile time because both instruction sets are part of
+ * the baseline ABI of the architectures they are enabled for.
+ *
+ * Input and output may be the same buffer but must not partially overlap.
+ */
+
+inline void clipToRange(float *output, const float *input, int32_t numSamples,
+                        float minimum, float maximum) {
+    int32_t i = 0;
+#if FLOWGRAPH_USE_NEON
+    const float32x4_t vmin = vdupq_n_f32(minimum);
+    const float32x4_t vmax = vdupq_n_f32(maximum);
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f32(output + i, vminq_f32(vmax, vmaxq_f32(vmin, vld1q_f32(input + i))));
+    }
+#elif FLOWGRAPH_USE_SSE2
+    const __m128 vmin = _mm_set1_ps(minimum);
+    const __m128 vmax = _mm_set1_ps(maximum);
+    for (; i + 4 <= numSamples; i += 4) {
+        _mm_storeu_ps(output + i, _mm_min_ps(vmax, _mm_max_ps(vmin, _mm_loadu_ps(input + i))));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        output[i] = std::min(maximum, std::max(minimum, input[i]));
+    }
+}
+
+inline void multiplyByConstant(float *output, const float *input, int32_t numSamples,
+                               float gain) {
+    int32_t i = 0;
+#if FLOWGRAPH_USE_NEON
+    const float32x4_t vgain = vdupq_n_f32(gain);
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f32(output + i, vmulq_f32(vld1q_f32(input + i), vgain));
+    }
+#elif FLOWGRAPH_USE_SSE2
+    const __m128 vgain = _mm_set1_ps(gain);
+    for (; i + 4 <= numSamples; i += 4) {
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_loadu_ps(input + i), vgain));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        output[i] = input[i] * gain;
+    }
+}
+
+/**
+ * Apply a linear ramp of numFrames frames.
+ * The gain of a frame is (levelTo - remaining * scaler), where remaining counts down
+ * by one per frame starting at the given value. This matches RampLinear::interpolateCurrent().
+ */
+inline void rampLinear(float *output, const float *input, int32_t numFrames,
+                       int32_t channelCount, float levelTo, int32_t remaining, float scaler) {
+    int32_t frame = 0;
+#if FLOWGRAPH_USE_NEON || FLOWGRAPH_USE_SSE2
+    // Four lanes hold four mono frames, two stereo frames or one quad frame.
+    if (channelCount == 1 || channelCount == 2 || channelCount == 4) {
+        const int32_t framesPerVector = 4 / channelCount;
+        float steps[4];
+        for (int32_t lane = 0; lane < 4; lane++) {
+            steps[lane] = (float) (lane / channelCount);
+        }
+#if FLOWGRAPH_USE_NEON
+        const float32x4_t vsteps = vld1q_f32(steps);
+        const float32x4_t vlevelTo = vdupq_n_f32(levelTo);
+        const float32x4_t vscaler = vdupq_n_f32(scaler);
+        for (; frame + framesPerVector <= numFrames; frame += framesPerVector) {
+            const float32x4_t vremaining =
+                    vsubq_f32(vdupq_n_f32((float) (remaining - frame)), vsteps);
+            const float32x4_t vgain = vsubq_f32(vlevelTo, vmulq_f32(vremaining, vscaler));
+            const int32_t offset = frame * channelCount;
+            vst1q_f32(output + offset, vmulq_f32(vld1q_f32(input + offset), vgain));
+        }
+#else
+        const __m128 vsteps = _mm_loadu_ps(steps);
+        const __m128 vlevelTo = _mm_set1_ps(levelTo);
+        const __m128 vscaler = _mm_set1_ps(scaler);
+        for (; frame + framesPerVector <= numFrames; frame += framesPerVector) {
+            const __m128 vremaining =
+                    _mm_sub_ps(_mm_set1_ps((float) (remaining - frame)), vsteps);
+            const __m128 vgain = _mm_sub_ps(vlevelTo, _mm_mul_ps(vremaining, vscaler));
+            const int32_t offset = frame * channelCount;
+            _mm_storeu_ps(output + offset, _mm_mul_ps(_mm_loadu_ps(input + offset), vgain));
+        }
+#endif
+    }
+#endif
+    for (; frame < numFrames; frame++) {
+        const float currentLevel = levelTo - (remaining - frame) * scaler;
+        const int32_t offset = frame * channelCount;
+        for (int32_t ch = 0; ch < channelCount; ch++) {
+            output[offset + ch] = input[offset + ch] * currentLevel;
+        }
+    }
+}
+
+inline void monoToMulti(float *output, const float *input, int32_t numFrames,
+                        int32_t channelCount) {
+    int32_t frame = 0;
+#if FLOWGRAPH_USE_NEON
+    if (channelCount == 2) {
+        for (; frame + 4 <= numFrames; frame += 4) {
+            const float32x4_t mono = vld1q_f32(input + frame);
+            vst2q_f32(output + frame * 2, (float32x4x2_t{{mono, mono}}));
+        }
+    } else if (channelCount == 4) {
+        for (; frame < numFrames; frame++) {
+            vst1q_f32(output + frame * 4, vdupq_n_f32(input[frame]));
+        }
+    }
+#elif FLOWGRAPH_USE_SSE2
+    if (channelCount == 2) {
+        for (; frame + 4 <= numFrames; frame += 4) {
+            const __m128 mono = _mm_loadu_ps(input + frame);
+            _mm_storeu_ps(output + frame * 2, _mm_unpacklo_ps(mono, mono));
+            _mm_storeu_ps(output + frame * 2 + 4, _mm_unpackhi_ps(mono, mono));
+        }
+    } else if (channelCount == 4) {
+        for (; frame < numFrames; frame++) {
+            _mm_storeu_ps(output + frame * 4, _mm_set1_ps(input[frame]));
+        }
+    }
+#endif
+    for (; frame < numFrames; frame++) {
+        const float sample = input[frame];
+        for (int32_t channel = 0; channel < channelCount; channel++) {
+            output[frame * channelCount + channel] = sample;
+        }
+    }
+}
+
+/**
+ * Convert int16_t to float in the range [-1.0, 1.0).
+ */
+inline void convertI16ToFloat(float *output, const int16_t *input, int32_t numSamples) {
+    int32_t i = 0;
+#if FLOWGRAPH_USE_NEON
+    const float32x4_t vscale = vdupq_n_f32(1.0f / 32768);
+    for (; i + 8 <= numSamples; i += 8) {
+        const int16x8_t shorts = vld1q_s16(input + i);
+        vst1q_f32(output + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(shorts))), vscale));
+        vst1q_f32(output + i + 4,
+                  vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(shorts))), vscale));
+    }
+#elif FLOWGRAPH_USE_SSE2
+    const __m128 vscale = _mm_set1_ps(1.0f / 32768);
+    for (; i + 8 <= numSamples; i += 8) {
+        const __m128i shorts = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+        // Sign extend by placing each sample in the upper half of a 32-bit lane.
+        const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(shorts, shorts), 16);
+        const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(shorts, shorts), 16);
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(low), vscale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), vscale));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        output[i] = input[i] * (1.0f / 32768);
+    }
+}
+
+/**
+ * Convert float to int16_t by truncation, clipping to the int16_t range.
+ */
+inline void convertFloatToI16(int16_t *output, const float *input, int32_t numSamples) {
+    int32_t i = 0;
+#if FLOWGRAPH_USE_NEON
+    const float32x4_t vscale = vdupq_n_f32(32768.0f);
+    for (; i + 8 <= numSamples; i += 8) {
+        // vcvtq truncates toward zero and saturates, vqmovn saturates to 16 bits.
+        const int32x4_t low = vcvtq_s32_f32(vmulq_f32(vld1q_f32(input + i), vscale));
+        const int32x4_t high = vcvtq_s32_f32(vmulq_f32(vld1q_f32(input + i + 4), vscale));
+        vst1q_s16(output + i, vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    }
+#elif FLOWGRAPH_USE_SSE2
+    const __m128 vscale = _mm_set1_ps(32768.0f);
+    // Limit in float first because cvttps returns INT32_MIN for any overflow.
+    const __m128 vmax = _mm_set1_ps(32767.0f);
+    const __m128 vmin = _mm_set1_ps(-32768.0f);
+    for (; i + 8 <= numSamples; i += 8) {
+        const __m128 low = _mm_min_ps(vmax, _mm_max_ps(vmin,
+                _mm_mul_ps(_mm_loadu_ps(input + i), vscale)));
+        const __m128 high = _mm_min_ps(vmax, _mm_max_ps(vmin,
+                _mm_mul_ps(_mm_loadu_ps(input + i + 4), vscale)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i),
+                _mm_packs_epi32(_mm_cvttps_epi32(low), _mm_cvttps_epi32(high)));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        int32_t n = (int32_t) (input[i] * 32768.0f);
+        output[i] = std::min(INT16_MAX, std::max(INT16_MIN, n)); // clip
+    }
+}
+
+} // namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph::simd
+
+#endif // FLOWGRAPH_SIMD_H
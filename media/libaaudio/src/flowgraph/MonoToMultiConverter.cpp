@@ -17,6 +17,7 @@
 #include <unistd.h>
 #include "FlowGraphNode.h"
 #include "MonoToMultiConverter.h"
+#include "FlowgraphSimd.h"
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
 
@@ -29,13 +30,8 @@ int32_t MonoToMultiConverter::onProcess(int32_t numFrames) {
     const float *inputBuffer = input.getBuffer();
     float *outputBuffer = output.getBuffer();
     int32_t channelCount = output.getSamplesPerFrame();
-    for (int i = 0; i < numFrames; i++) {
-        // read one, write many
-        float sample = *inputBuffer++;
-        for (int channel = 0; channel < channelCount; channel++) {
-            *outputBuffer++ = sample;
-        }
-    }
+    // read one, write many
+    simd::monoToMulti(outputBuffer, inputBuffer, numFrames, channelCount);
     return numFrames;
 }
 
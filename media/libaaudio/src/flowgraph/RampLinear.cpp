@@ -18,6 +18,7 @@
 #include <unistd.h>
 #include "FlowGraphNode.h"
 #include "RampLinear.h"
+#include "FlowgraphSimd.h"
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
 
@@ -61,21 +62,17 @@ int32_t RampLinear::onProcess(int32_t numFrames) {
     if (mRemaining > 0) { // Ramping? This doesn't happen very often.
         int32_t framesToRamp = std::min(framesLeft, mRemaining);
         framesLeft -= framesToRamp;
-        while (framesToRamp > 0) {
-            float currentLevel = interpolateCurrent();
-            for (int ch = 0; ch < channelCount; ch++) {
-                *outputBuffer++ = *inputBuffer++ * currentLevel;
-            }
-            mRemaining--;
-            framesToRamp--;
-        }
+        simd::rampLinear(outputBuffer, inputBuffer, framesToRamp, channelCount,
+                         mLevelTo, mRemaining, mScaler);
+        mRemaining -= framesToRamp;
+        int32_t samplesRamped = framesToRamp * channelCount;
+        inputBuffer += samplesRamped;
+        outputBuffer += samplesRamped;
     }
 
     // Process any frames after the ramp.
     int32_t samplesLeft = framesLeft * channelCount;
-    for (int i = 0; i < samplesLeft; i++) {
-        *outputBuffer++ = *inputBuffer++ * mLevelTo;
-    }
+    simd::multiplyByConstant(outputBuffer, inputBuffer, samplesLeft, mLevelTo);
 
     return numFrames;
 }
@@ -21,6 +21,8 @@
 
 #if FLOWGRAPH_ANDROID_INTERNAL
 #include <audio_utils/primitives.h>
+#else
+#include "FlowgraphSimd.h"
 #endif
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
@@ -46,10 +48,8 @@ int32_t SinkI16::read(void *data, int32_t numFrames) {
         shortData += numSamples;
         signal += numSamples;
 #else
-        for (int i = 0; i < numSamples; i++) {
-            int32_t n = (int32_t) (*signal++ * 32768.0f);
-            *shortData++ = std::min(INT16_MAX, std::max(INT16_MIN, n)); // clip
-        }
+        simd::convertFloatToI16(shortData, signal, numSamples);
+        shortData += numSamples;
 #endif
         framesLeft -= framesRead;
     }
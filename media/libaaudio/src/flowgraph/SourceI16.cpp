@@ -22,6 +22,8 @@
 
 #if FLOWGRAPH_ANDROID_INTERNAL
 #include <audio_utils/primitives.h>
+#else
+#include "FlowgraphSimd.h"
 #endif
 
 using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
@@ -44,9 +46,7 @@ int32_t SourceI16::onProcess(int32_t numFrames) {
 #if FLOWGRAPH_ANDROID_INTERNAL
     memcpy_to_float_from_i16(floatData, shortData, numSamples);
 #else
-    for (int i = 0; i < numSamples; i++) {
-        *floatData++ = *shortData++ * (1.0f / 32768);
-    }
+    simd::convertI16ToFloat(floatData, shortData, numSamples);
 #endif
 
     mFrameIndex += framesToProcess;
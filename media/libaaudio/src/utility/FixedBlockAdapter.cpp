@@ -21,14 +21,21 @@
 int32_t FixedBlockAdapter::open(int32_t bytesPerFixedBlock)
 {
     mSize = bytesPerFixedBlock;
-    mStorage = std::make_unique<uint8_t[]>(bytesPerFixedBlock);
+    // Streams are reopened with the same callback size, so keep the storage if it fits.
+    if (mStorage == nullptr || mCapacity < bytesPerFixedBlock) {
+        mStorage = std::make_unique<uint8_t[]>(bytesPerFixedBlock);
+        mCapacity = bytesPerFixedBlock;
+    }
     mPosition = 0;
+    mBytesProcessed = 0;
+    mBytesCopied = 0;
     return 0;
 }
 
 int32_t FixedBlockAdapter::close()
 {
     mStorage.reset();
+    mCapacity = 0;
     mSize = 0;
     mPosition = 0;
     return 0;
@@ -62,11 +62,27 @@ public:
      */
     int32_t close();
 
+    /**
+     * @return number of bytes passed to processVariableBlock() since open()
+     */
+    int64_t getBytesProcessed() const { return mBytesProcessed; }
+
+    /**
+     * Whole fixed-size blocks are passed through without a copy; only the parts of a
+     * variable-sized block that straddle a fixed block boundary go through storage.
+     *
+     * @return number of bytes copied through storage since open()
+     */
+    int64_t getBytesCopied() const { return mBytesCopied; }
+
 protected:
     FixedBlockProcessor  &mFixedBlockProcessor;
     std::unique_ptr<uint8_t[]> mStorage;         // Store data here while assembling buffers.
+    int32_t               mCapacity = 0;         // Size in bytes of mStorage.
     int32_t               mSize = 0;             // Size in bytes of the fixed size buffer.
     int32_t               mPosition = 0;         // Offset of the last byte read or written.
+    int64_t               mBytesProcessed = 0;
+    int64_t               mBytesCopied = 0;
 };
 
 #endif /* AAUDIO_FIXED_BLOCK_ADAPTER_H */
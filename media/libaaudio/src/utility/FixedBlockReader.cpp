@@ -41,12 +41,14 @@ int32_t FixedBlockReader::readFromStorage(uint8_t *buffer, int32_t numBytes) {
     }
     memcpy(buffer, &mStorage[mPosition], bytesToRead);
     mPosition += bytesToRead;
+    mBytesCopied += bytesToRead;
     return bytesToRead;
 }
 
 int32_t FixedBlockReader::processVariableBlock(uint8_t *buffer, int32_t numBytes) {
     int32_t result = 0;
     int32_t bytesLeft = numBytes;
+    mBytesProcessed += numBytes;
     while(bytesLeft > 0 && result == 0) {
         if (mPosition < mSize) {
             // Use up bytes currently in storage.
@@ -32,12 +32,14 @@ int32_t FixedBlockWriter::writeToStorage(uint8_t *buffer, int32_t numBytes) {
     }
     memcpy(&mStorage[mPosition], buffer, bytesToStore);
     mPosition += bytesToStore;
+    mBytesCopied += bytesToStore;
     return bytesToStore;
 }
 
 int32_t FixedBlockWriter::processVariableBlock(uint8_t *buffer, int32_t numBytes) {
     int32_t result = 0;
     int32_t bytesLeft = numBytes;
+    mBytesProcessed += numBytes;
 
     // If we already have data in storage then add to it.
     if (mPosition > 0) {
@@ -52,7 +54,8 @@ int32_t FixedBlockWriter::processVariableBlock(uint8_t *buffer, int32_t numBytes
     }
 
     // Write through if enough for a complete block.
-    while(bytesLeft > mSize && result == 0) {
+    // An exactly complete block is written through too, rather than held back in storage.
+    while(bytesLeft >= mSize && result == 0) {
         result = mFixedBlockProcessor.onProcessFixedBlock(buffer, mSize);
         buffer += mSize;
         bytesLeft -= mSize;
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmark the flowgraph nodes that run once per callback on the AAudio data path.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "flowgraph/ClipToRange.h"
+#include "flowgraph/MonoToMultiConverter.h"
+#include "flowgraph/RampLinear.h"
+#include "flowgraph/SinkFloat.h"
+#include "flowgraph/SinkI16.h"
+#include "flowgraph/SourceFloat.h"
+#include "flowgraph/SourceI16.h"
+
+using namespace FLOWGRAPH_OUTER_NAMESPACE::flowgraph;
+
+static constexpr int32_t kFramesPerBurst = 192; // typical 4 msec burst at 48000 Hz
+
+// Source and sink are rewound on every iteration so that only the node is measured.
+template <typename Node>
+static void runFilter(benchmark::State& state, Node& node, int32_t channelCount,
+                      int32_t inputChannelCount) {
+    std::vector<float> input(kFramesPerBurst * inputChannelCount);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = (i % 64) / 32.0f - 1.0f;
+    }
+    std::vector<float> output(kFramesPerBurst * channelCount);
+    SourceFloat source{inputChannelCount};
+    SinkFloat sink{channelCount};
+    source.output.connect(&node.input);
+    node.output.connect(&sink.input);
+
+    for (auto _ : state) {
+        source.setData(input.data(), kFramesPerBurst);
+        benchmark::DoNotOptimize(sink.read(output.data(), kFramesPerBurst));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFramesPerBurst);
+}
+
+static void BM_ClipToRange(benchmark::State& state) {
+    const int32_t channelCount = state.range(0);
+    ClipToRange clipper{channelCount};
+    runFilter(state, clipper, channelCount, channelCount);
+}
+
+static void BM_RampLinear(benchmark::State& state) {
+    const int32_t channelCount = state.range(0);
+    RampLinear ramp{channelCount};
+    // Keep ramping on every burst by alternating the target.
+    ramp.setLengthInFrames(kFramesPerBurst);
+    float target = 0.5f;
+    ramp.setTarget(target);
+    std::vector<float> input(kFramesPerBurst * channelCount, 0.25f);
+    std::vector<float> output(kFramesPerBurst * channelCount);
+    SourceFloat source{channelCount};
+    SinkFloat sink{channelCount};
+    source.output.connect(&ramp.input);
+    ramp.output.connect(&sink.input);
+
+    for (auto _ : state) {
+        target = 1.0f - target;
+        ramp.setTarget(target);
+        source.setData(input.data(), kFramesPerBurst);
+        benchmark::DoNotOptimize(sink.read(output.data(), kFramesPerBurst));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFramesPerBurst);
+}
+
+static void BM_MonoToMulti(benchmark::State& state) {
+    const int32_t channelCount = state.range(0);
+    MonoToMultiConverter converter{channelCount};
+    runFilter(state, converter, channelCount, 1 /* inputChannelCount */);
+}
+
+static void BM_SourceI16(benchmark::State& state) {
+    const int32_t channelCount = state.range(0);
+    std::vector<int16_t> input(kFramesPerBurst * channelCount);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = (int16_t) (i * 997);
+    }
+    std::vector<float> output(kFramesPerBurst * channelCount);
+    SourceI16 source{channelCount};
+    SinkFloat sink{channelCount};
+    source.output.connect(&sink.input);
+
+    for (auto _ : state) {
+        source.setData(input.data(), kFramesPerBurst);
+        benchmark::DoNotOptimize(sink.read(output.data(), kFramesPerBurst));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFramesPerBurst);
+}
+
+static void BM_SinkI16(benchmark::State& state) {
+    const int32_t channelCount = state.range(0);
+    std::vector<float> input(kFramesPerBurst * channelCount);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = (i % 64) / 16.0f - 2.0f; // includes values that need clipping
+    }
+    std::vector<int16_t> output(kFramesPerBurst * channelCount);
+    SourceFloat source{channelCount};
+    SinkI16 sink{channelCount};
+    source.output.connect(&sink.input);
+
+    for (auto _ : state) {
+        source.setData(input.data(), kFramesPerBurst);
+        benchmark::DoNotOptimize(sink.read(output.data(), kFramesPerBurst));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kFramesPerBurst);
+}
+
+static void ChannelArgs(benchmark::internal::Benchmark* b) {
+    for (int channelCount : {1, 2, 4, 8}) {
+        b->Arg(channelCount);
+    }
+}
+
+BENCHMARK(BM_ClipToRange)->Apply(ChannelArgs);
+BENCHMARK(BM_RampLinear)->Apply(ChannelArgs);
+BENCHMARK(BM_MonoToMulti)->Apply(ChannelArgs);
+BENCHMARK(BM_SourceI16)->Apply(ChannelArgs);
+BENCHMARK(BM_SinkI16)->Apply(ChannelArgs);
+
+BENCHMARK_MAIN();
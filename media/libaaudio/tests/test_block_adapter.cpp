@@ -83,6 +83,8 @@ public:
         return mFixedBlockWriter.processVariableBlock((uint8_t *) mTestBuffer, sizeBytes);
     }
 
+    const FixedBlockAdapter &getAdapter() const { return mFixedBlockWriter; }
+
 private:
     FixedBlockWriter mFixedBlockWriter;
 };
@@ -114,6 +116,8 @@ public:
         return result;
     }
 
+    const FixedBlockAdapter &getAdapter() const { return mFixedBlockReader; }
+
 private:
     FixedBlockReader   mFixedBlockReader;
 };
@@ -149,3 +153,21 @@ TEST(test_block_adapter, block_adapter_read) {
     ASSERT_EQ(0, result);
 };
 
+// Whole blocks are passed through without copying them.
+TEST(test_block_adapter, block_adapter_write_aligned) {
+    TestBlockWriter tester;
+    ASSERT_EQ(0, tester.testInputWrite(FIXED_BLOCK_SIZE));
+    ASSERT_EQ(0, tester.testInputWrite(2 * FIXED_BLOCK_SIZE));
+    EXPECT_EQ(0, tester.getAdapter().getBytesCopied());
+    EXPECT_EQ((int64_t) (3 * FIXED_BLOCK_SIZE * sizeof(int32_t)),
+              tester.getAdapter().getBytesProcessed());
+    // The blocks were not held back.
+    EXPECT_EQ(3 * FIXED_BLOCK_SIZE, tester.mTestIndex);
+}
+
+TEST(test_block_adapter, block_adapter_read_aligned) {
+    TestBlockReader tester;
+    ASSERT_EQ(0, tester.testOutputRead(FIXED_BLOCK_SIZE));
+    ASSERT_EQ(0, tester.testOutputRead(2 * FIXED_BLOCK_SIZE));
+    EXPECT_EQ(0, tester.getAdapter().getBytesCopied());
+}
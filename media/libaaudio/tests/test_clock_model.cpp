@@ -84,6 +84,21 @@ public:
         }
     }
 
+    // Feed timestamps at burst boundaries of a hardware clock running at the specified rate,
+    // each one late by a random jitter of up to maxJitterNanos.
+    // Returns the time of the last burst boundary.
+    int64_t feedJitteryClock(double hardwareFramesPerSecond, int64_t maxJitterNanos,
+                             int firstTimestamp, int lastTimestamp, int64_t startTimeNanos) {
+        int64_t nanoTime = startTimeNanos;
+        for (int i = firstTimestamp; i <= lastTimestamp; i++) {
+            const int64_t position = (int64_t) i * 4 * HW_FRAMES_PER_BURST;
+            nanoTime = startTimeNanos + (int64_t) (position * NANOS_PER_SECOND
+                    / hardwareFramesPerSecond);
+            model.processTimestamp(position, nanoTime + (int64_t) (drand48() * maxJitterNanos));
+        }
+        return nanoTime;
+    }
+
     IsochronousClockModel model;
 };
 
@@ -163,4 +178,41 @@ TEST_F(ClockModelTestFixture, clock_slow_drift) {
 
 TEST_F(ClockModelTestFixture, clock_fast_drift) {
     checkDriftingClock(1.002 * SAMPLE_RATE, NUM_LOOPS_DRIFT);
-}
\ No newline at end of file
+}
+// The drift of a slightly slow hardware clock is measured once enough timestamps arrived.
+TEST_F(ClockModelTestFixture, clock_drift_estimate) {
+    const int64_t startTimeNanos = 500000000; // arbitrary
+    model.start(startTimeNanos);
+    feedJitteryClock(0.9999 * SAMPLE_RATE, 20 * NANOS_PER_MICROSECOND, 1, 8, startTimeNanos);
+    EXPECT_FALSE(model.isDriftConfident());
+
+    feedJitteryClock(0.9999 * SAMPLE_RATE, 20 * NANOS_PER_MICROSECOND, 9, 1000, startTimeNanos);
+    EXPECT_TRUE(model.isDriftConfident());
+    EXPECT_NEAR(100.0, model.getDriftPpm(), 20.0);
+}
+
+// Low timestamp jitter tightens the late edge of the window.
+TEST_F(ClockModelTestFixture, clock_jitter_margin) {
+    const int64_t startTimeNanos = 500000000; // arbitrary
+    model.start(startTimeNanos);
+    const int64_t lastTime = feedJitteryClock(SAMPLE_RATE, 10 * NANOS_PER_MICROSECOND, 1, 1000,
+                                              startTimeNanos);
+    ASSERT_TRUE(model.isDriftConfident());
+    const int64_t position = model.convertTimeToPosition(lastTime);
+    const int64_t lateMarginNanos =
+            model.convertPositionToLatestTime(position) - model.convertPositionToTime(position);
+    EXPECT_LT(lateMarginNanos, 100 * NANOS_PER_MICROSECOND);
+}
+
+// A timestamp far off the estimated clock restarts the estimate.
+TEST_F(ClockModelTestFixture, clock_drift_glitch) {
+    const int64_t startTimeNanos = 500000000; // arbitrary
+    model.start(startTimeNanos);
+    const int64_t lastTime = feedJitteryClock(SAMPLE_RATE, 20 * NANOS_PER_MICROSECOND, 1, 1000,
+                                              startTimeNanos);
+    ASSERT_TRUE(model.isDriftConfident());
+
+    // The hardware stalls for 100 bursts.
+    model.processTimestamp(1001 * 4 * HW_FRAMES_PER_BURST, lastTime + 104 * NANOS_PER_BURST);
+    EXPECT_FALSE(model.isDriftConfident());
+}
@@ -26,6 +26,7 @@
 #include <gtest/gtest.h>
 
 #include "flowgraph/ClipToRange.h"
+#include "flowgraph/FlowgraphSimd.h"
 #include "flowgraph/MonoBlend.h"
 #include "flowgraph/MonoToMultiConverter.h"
 #include "flowgraph/SourceFloat.h"
@@ -319,3 +320,61 @@ TEST(test_flowgraph, module_mono_blend) {
     }
 }
 
+
+// The vector kernels must match the scalar loops for every length, including the tails.
+TEST(test_flowgraph, simd_kernels_match_scalar) {
+    constexpr int kMaxFrames = 37;
+    constexpr int kMaxChannels = 4;
+    constexpr float tolerance = 0.000001f; // arbitrary
+    float input[kMaxFrames * kMaxChannels];
+    float output[kMaxFrames * kMaxChannels];
+    int16_t shorts[kMaxFrames * kMaxChannels];
+    int16_t shortOutput[kMaxFrames * kMaxChannels];
+    for (int i = 0; i < kMaxFrames * kMaxChannels; i++) {
+        input[i] = ((i * 7919) % 401 - 200) * 0.0123f; // spans beyond [-1.0, 1.0]
+        shorts[i] = (int16_t) ((i * 7919) % 65536 - 32768);
+    }
+
+    for (int channelCount = 1; channelCount <= kMaxChannels; channelCount++) {
+        for (int numFrames = 0; numFrames <= kMaxFrames; numFrames++) {
+            const int numSamples = numFrames * channelCount;
+
+            simd::clipToRange(output, input, numSamples, -1.0f, 0.75f);
+            for (int i = 0; i < numSamples; i++) {
+                EXPECT_EQ(std::min(0.75f, std::max(-1.0f, input[i])), output[i]);
+            }
+
+            simd::multiplyByConstant(output, input, numSamples, 0.3f);
+            for (int i = 0; i < numSamples; i++) {
+                EXPECT_EQ(input[i] * 0.3f, output[i]);
+            }
+
+            constexpr float levelTo = 0.8f;
+            constexpr float scaler = 0.01f;
+            simd::rampLinear(output, input, numFrames, channelCount, levelTo, numFrames, scaler);
+            for (int frame = 0; frame < numFrames; frame++) {
+                const float level = levelTo - (numFrames - frame) * scaler;
+                for (int ch = 0; ch < channelCount; ch++) {
+                    const int i = frame * channelCount + ch;
+                    EXPECT_NEAR(input[i] * level, output[i], tolerance);
+                }
+            }
+
+            simd::monoToMulti(output, input, numFrames, channelCount);
+            for (int i = 0; i < numSamples; i++) {
+                EXPECT_EQ(input[i / channelCount], output[i]);
+            }
+
+            simd::convertI16ToFloat(output, shorts, numSamples);
+            for (int i = 0; i < numSamples; i++) {
+                EXPECT_EQ(shorts[i] * (1.0f / 32768), output[i]);
+            }
+
+            simd::convertFloatToI16(shortOutput, input, numSamples);
+            for (int i = 0; i < numSamples; i++) {
+                int32_t n = (int32_t) (input[i] * 32768.0f);
+                EXPECT_EQ(std::min(INT16_MAX, std::max(INT16_MIN, n)), shortOutput[i]);
+            }
+        }
+    }
+}
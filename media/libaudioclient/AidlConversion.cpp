@@ -2865,60 +2865,86 @@ status_t legacy2aidl_AudioPortExt(
     LOG_ALWAYS_FATAL("Shouldn't get here"); // with -Werror,-Wswitch may compile-time fail
 }
 
-ConversionResult<audio_profile>
-aidl2legacy_AudioProfile_audio_profile(const AudioProfile& aidl, bool isInput) {
-    audio_profile legacy;
-    legacy.format = VALUE_OR_RETURN(aidl2legacy_AudioFormatDescription_audio_format_t(aidl.format));
+namespace {
 
-    if (aidl.sampleRates.size() > std::size(legacy.sample_rates)) {
-        return unexpected(BAD_VALUE);
+// The profile and port conversions below fill an existing object instead of returning a new
+// one. An audio_port_v7 holds fixed arrays of profiles and is large, converting it in place
+// avoids copying it around, and when converting lists it avoids a temporary per element.
+
+status_t aidl2legacy_AudioProfile_audio_profile_inplace(
+        const AudioProfile& aidl, bool isInput, audio_profile* legacy) {
+    legacy->format = VALUE_OR_RETURN_STATUS(
+            aidl2legacy_AudioFormatDescription_audio_format_t(aidl.format));
+
+    if (aidl.sampleRates.size() > std::size(legacy->sample_rates)) {
+        return BAD_VALUE;
     }
-    RETURN_IF_ERROR(
-            convertRange(aidl.sampleRates.begin(), aidl.sampleRates.end(), legacy.sample_rates,
+    RETURN_STATUS_IF_ERROR(
+            convertRange(aidl.sampleRates.begin(), aidl.sampleRates.end(), legacy->sample_rates,
                          convertIntegral<int32_t, unsigned int>));
-    legacy.num_sample_rates = aidl.sampleRates.size();
+    legacy->num_sample_rates = aidl.sampleRates.size();
 
-    if (aidl.channelMasks.size() > std::size(legacy.channel_masks)) {
-        return unexpected(BAD_VALUE);
+    if (aidl.channelMasks.size() > std::size(legacy->channel_masks)) {
+        return BAD_VALUE;
     }
-    RETURN_IF_ERROR(
-            convertRange(aidl.channelMasks.begin(), aidl.channelMasks.end(), legacy.channel_masks,
+    RETURN_STATUS_IF_ERROR(
+            convertRange(aidl.channelMasks.begin(), aidl.channelMasks.end(), legacy->channel_masks,
                     [isInput](const AudioChannelLayout& l) {
                         return aidl2legacy_AudioChannelLayout_audio_channel_mask_t(l, isInput);
                     }));
-    legacy.num_channel_masks = aidl.channelMasks.size();
+    legacy->num_channel_masks = aidl.channelMasks.size();
 
-    legacy.encapsulation_type = VALUE_OR_RETURN(
+    legacy->encapsulation_type = VALUE_OR_RETURN_STATUS(
             aidl2legacy_AudioEncapsulationType_audio_encapsulation_type_t(aidl.encapsulationType));
-    return legacy;
+    return OK;
 }
 
-ConversionResult<AudioProfile>
-legacy2aidl_audio_profile_AudioProfile(const audio_profile& legacy, bool isInput) {
-    AudioProfile aidl;
-    aidl.format = VALUE_OR_RETURN(legacy2aidl_audio_format_t_AudioFormatDescription(legacy.format));
+status_t legacy2aidl_audio_profile_AudioProfile_inplace(
+        const audio_profile& legacy, bool isInput, AudioProfile* aidl) {
+    aidl->format = VALUE_OR_RETURN_STATUS(
+            legacy2aidl_audio_format_t_AudioFormatDescription(legacy.format));
 
     if (legacy.num_sample_rates > std::size(legacy.sample_rates)) {
-        return unexpected(BAD_VALUE);
+        return BAD_VALUE;
     }
-    RETURN_IF_ERROR(
+    aidl->sampleRates.clear();
+    aidl->sampleRates.reserve(legacy.num_sample_rates);
+    RETURN_STATUS_IF_ERROR(
             convertRange(legacy.sample_rates, legacy.sample_rates + legacy.num_sample_rates,
-                         std::back_inserter(aidl.sampleRates),
+                         std::back_inserter(aidl->sampleRates),
                          convertIntegral<unsigned int, int32_t>));
 
     if (legacy.num_channel_masks > std::size(legacy.channel_masks)) {
-        return unexpected(BAD_VALUE);
+        return BAD_VALUE;
     }
-    RETURN_IF_ERROR(
+    aidl->channelMasks.clear();
+    aidl->channelMasks.reserve(legacy.num_channel_masks);
+    RETURN_STATUS_IF_ERROR(
             convertRange(legacy.channel_masks, legacy.channel_masks + legacy.num_channel_masks,
-                         std::back_inserter(aidl.channelMasks),
+                         std::back_inserter(aidl->channelMasks),
                     [isInput](audio_channel_mask_t m) {
                         return legacy2aidl_audio_channel_mask_t_AudioChannelLayout(m, isInput);
                     }));
 
-    aidl.encapsulationType = VALUE_OR_RETURN(
+    aidl->encapsulationType = VALUE_OR_RETURN_STATUS(
             legacy2aidl_audio_encapsulation_type_t_AudioEncapsulationType(
                     legacy.encapsulation_type));
+    return OK;
+}
+
+}  // namespace
+
+ConversionResult<audio_profile>
+aidl2legacy_AudioProfile_audio_profile(const AudioProfile& aidl, bool isInput) {
+    audio_profile legacy;
+    RETURN_IF_ERROR(aidl2legacy_AudioProfile_audio_profile_inplace(aidl, isInput, &legacy));
+    return legacy;
+}
+
+ConversionResult<AudioProfile>
+legacy2aidl_audio_profile_AudioProfile(const audio_profile& legacy, bool isInput) {
+    AudioProfile aidl;
+    RETURN_IF_ERROR(legacy2aidl_audio_profile_AudioProfile_inplace(legacy, isInput, &aidl));
     return aidl;
 }
 
@@ -2952,100 +2978,142 @@ legacy2aidl_audio_gain_AudioGain(const audio_gain& legacy, bool isInput) {
     return aidl;
 }
 
-ConversionResult<audio_port_v7>
-aidl2legacy_AudioPort_audio_port_v7(const media::AudioPort& aidl) {
-    audio_port_v7 legacy;
-    legacy.id = VALUE_OR_RETURN(aidl2legacy_int32_t_audio_port_handle_t(aidl.hal.id));
-    legacy.role = VALUE_OR_RETURN(aidl2legacy_AudioPortRole_audio_port_role_t(aidl.sys.role));
-    legacy.type = VALUE_OR_RETURN(aidl2legacy_AudioPortType_audio_port_type_t(aidl.sys.type));
-    RETURN_IF_ERROR(aidl2legacy_string(aidl.hal.name, legacy.name, sizeof(legacy.name)));
+namespace {
 
-    if (aidl.hal.profiles.size() > std::size(legacy.audio_profiles)) {
-        return unexpected(BAD_VALUE);
+status_t aidl2legacy_AudioPort_audio_port_v7_inplace(
+        const media::AudioPort& aidl, audio_port_v7* legacy) {
+    legacy->id = VALUE_OR_RETURN_STATUS(aidl2legacy_int32_t_audio_port_handle_t(aidl.hal.id));
+    legacy->role = VALUE_OR_RETURN_STATUS(
+            aidl2legacy_AudioPortRole_audio_port_role_t(aidl.sys.role));
+    legacy->type = VALUE_OR_RETURN_STATUS(
+            aidl2legacy_AudioPortType_audio_port_type_t(aidl.sys.type));
+    RETURN_STATUS_IF_ERROR(aidl2legacy_string(aidl.hal.name, legacy->name, sizeof(legacy->name)));
+
+    if (aidl.hal.profiles.size() > std::size(legacy->audio_profiles)) {
+        return BAD_VALUE;
     }
     const bool isInput =
-            VALUE_OR_RETURN(direction(aidl.sys.role, aidl.sys.type)) == Direction::INPUT;
-    RETURN_IF_ERROR(convertRange(
-                    aidl.hal.profiles.begin(), aidl.hal.profiles.end(), legacy.audio_profiles,
-                    [isInput](const AudioProfile& p) {
-                        return aidl2legacy_AudioProfile_audio_profile(p, isInput);
-                    }));
-    legacy.num_audio_profiles = aidl.hal.profiles.size();
+            VALUE_OR_RETURN_STATUS(direction(aidl.sys.role, aidl.sys.type)) == Direction::INPUT;
+    for (size_t i = 0; i < aidl.hal.profiles.size(); ++i) {
+        RETURN_STATUS_IF_ERROR(aidl2legacy_AudioProfile_audio_profile_inplace(
+                        aidl.hal.profiles[i], isInput, &legacy->audio_profiles[i]));
+    }
+    legacy->num_audio_profiles = aidl.hal.profiles.size();
 
-    if (aidl.hal.extraAudioDescriptors.size() > std::size(legacy.extra_audio_descriptors)) {
-        return unexpected(BAD_VALUE);
+    if (aidl.hal.extraAudioDescriptors.size() > std::size(legacy->extra_audio_descriptors)) {
+        return BAD_VALUE;
     }
-    RETURN_IF_ERROR(
+    RETURN_STATUS_IF_ERROR(
             convertRange(
                     aidl.hal.extraAudioDescriptors.begin(), aidl.hal.extraAudioDescriptors.end(),
-                    legacy.extra_audio_descriptors,
+                    legacy->extra_audio_descriptors,
                     aidl2legacy_ExtraAudioDescriptor_audio_extra_audio_descriptor));
-    legacy.num_extra_audio_descriptors = aidl.hal.extraAudioDescriptors.size();
+    legacy->num_extra_audio_descriptors = aidl.hal.extraAudioDescriptors.size();
 
-    if (aidl.hal.gains.size() > std::size(legacy.gains)) {
-        return unexpected(BAD_VALUE);
+    if (aidl.hal.gains.size() > std::size(legacy->gains)) {
+        return BAD_VALUE;
     }
-    RETURN_IF_ERROR(convertRange(aidl.hal.gains.begin(), aidl.hal.gains.end(), legacy.gains,
-                                 [isInput](const AudioGain& g) {
-                                     return aidl2legacy_AudioGain_audio_gain(g, isInput);
-                                 }));
-    legacy.num_gains = aidl.hal.gains.size();
+    RETURN_STATUS_IF_ERROR(convertRange(aidl.hal.gains.begin(), aidl.hal.gains.end(),
+                                        legacy->gains,
+                                        [isInput](const AudioGain& g) {
+                                            return aidl2legacy_AudioGain_audio_gain(g, isInput);
+                                        }));
+    legacy->num_gains = aidl.hal.gains.size();
 
-    legacy.active_config = VALUE_OR_RETURN(
+    legacy->active_config = VALUE_OR_RETURN_STATUS(
             aidl2legacy_AudioPortConfig_audio_port_config(aidl.sys.activeConfig));
-    legacy.ext = VALUE_OR_RETURN(
+    legacy->ext = VALUE_OR_RETURN_STATUS(
             aidl2legacy_AudioPortExt_audio_port_v7_ext(aidl.hal.ext, aidl.sys.type, aidl.sys.ext));
-    return legacy;
+    return OK;
 }
 
-ConversionResult<media::AudioPort>
-legacy2aidl_audio_port_v7_AudioPort(const audio_port_v7& legacy) {
-    media::AudioPort aidl;
-    aidl.hal.id = VALUE_OR_RETURN(legacy2aidl_audio_port_handle_t_int32_t(legacy.id));
-    aidl.sys.role = VALUE_OR_RETURN(legacy2aidl_audio_port_role_t_AudioPortRole(legacy.role));
-    aidl.sys.type = VALUE_OR_RETURN(legacy2aidl_audio_port_type_t_AudioPortType(legacy.type));
-    aidl.hal.name = VALUE_OR_RETURN(legacy2aidl_string(legacy.name, sizeof(legacy.name)));
+status_t legacy2aidl_audio_port_v7_AudioPort_inplace(
+        const audio_port_v7& legacy, media::AudioPort* aidl) {
+    aidl->hal.id = VALUE_OR_RETURN_STATUS(legacy2aidl_audio_port_handle_t_int32_t(legacy.id));
+    aidl->sys.role = VALUE_OR_RETURN_STATUS(
+            legacy2aidl_audio_port_role_t_AudioPortRole(legacy.role));
+    aidl->sys.type = VALUE_OR_RETURN_STATUS(
+            legacy2aidl_audio_port_type_t_AudioPortType(legacy.type));
+    aidl->hal.name = VALUE_OR_RETURN_STATUS(legacy2aidl_string(legacy.name, sizeof(legacy.name)));
 
     if (legacy.num_audio_profiles > std::size(legacy.audio_profiles)) {
-        return unexpected(BAD_VALUE);
+        return BAD_VALUE;
+    }
+    const bool isInput =
+            VALUE_OR_RETURN_STATUS(direction(legacy.role, legacy.type)) == Direction::INPUT;
+    aidl->hal.profiles.resize(legacy.num_audio_profiles);
+    for (size_t i = 0; i < legacy.num_audio_profiles; ++i) {
+        RETURN_STATUS_IF_ERROR(legacy2aidl_audio_profile_AudioProfile_inplace(
+                        legacy.audio_profiles[i], isInput, &aidl->hal.profiles[i]));
     }
-    const bool isInput = VALUE_OR_RETURN(direction(legacy.role, legacy.type)) == Direction::INPUT;
-    RETURN_IF_ERROR(
-            convertRange(legacy.audio_profiles, legacy.audio_profiles + legacy.num_audio_profiles,
-                         std::back_inserter(aidl.hal.profiles),
-                         [isInput](const audio_profile& p) {
-                             return legacy2aidl_audio_profile_AudioProfile(p, isInput);
-                         }));
 
     if (legacy.num_extra_audio_descriptors > std::size(legacy.extra_audio_descriptors)) {
-        return unexpected(BAD_VALUE);
+        return BAD_VALUE;
     }
-    aidl.sys.profiles.resize(legacy.num_audio_profiles);
-    RETURN_IF_ERROR(
+    aidl->sys.profiles.resize(legacy.num_audio_profiles);
+    aidl->hal.extraAudioDescriptors.clear();
+    aidl->hal.extraAudioDescriptors.reserve(legacy.num_extra_audio_descriptors);
+    RETURN_STATUS_IF_ERROR(
             convertRange(legacy.extra_audio_descriptors,
                     legacy.extra_audio_descriptors + legacy.num_extra_audio_descriptors,
-                    std::back_inserter(aidl.hal.extraAudioDescriptors),
+                    std::back_inserter(aidl->hal.extraAudioDescriptors),
                     legacy2aidl_audio_extra_audio_descriptor_ExtraAudioDescriptor));
 
     if (legacy.num_gains > std::size(legacy.gains)) {
-        return unexpected(BAD_VALUE);
+        return BAD_VALUE;
     }
-    RETURN_IF_ERROR(
+    aidl->hal.gains.clear();
+    aidl->hal.gains.reserve(legacy.num_gains);
+    RETURN_STATUS_IF_ERROR(
             convertRange(legacy.gains, legacy.gains + legacy.num_gains,
-                         std::back_inserter(aidl.hal.gains),
+                         std::back_inserter(aidl->hal.gains),
                          [isInput](const audio_gain& g) {
                              return legacy2aidl_audio_gain_AudioGain(g, isInput);
                          }));
-    aidl.sys.gains.resize(legacy.num_gains);
+    aidl->sys.gains.resize(legacy.num_gains);
 
-    aidl.sys.activeConfig = VALUE_OR_RETURN(
+    aidl->sys.activeConfig = VALUE_OR_RETURN_STATUS(
             legacy2aidl_audio_port_config_AudioPortConfig(legacy.active_config));
-    aidl.sys.activeConfig.hal.portId = aidl.hal.id;
-    RETURN_IF_ERROR(
-            legacy2aidl_AudioPortExt(legacy.ext, legacy.type, &aidl.hal.ext, &aidl.sys.ext));
+    aidl->sys.activeConfig.hal.portId = aidl->hal.id;
+    RETURN_STATUS_IF_ERROR(
+            legacy2aidl_AudioPortExt(legacy.ext, legacy.type, &aidl->hal.ext, &aidl->sys.ext));
+    return OK;
+}
+
+}  // namespace
+
+ConversionResult<audio_port_v7>
+aidl2legacy_AudioPort_audio_port_v7(const media::AudioPort& aidl) {
+    audio_port_v7 legacy;
+    RETURN_IF_ERROR(aidl2legacy_AudioPort_audio_port_v7_inplace(aidl, &legacy));
+    return legacy;
+}
+
+ConversionResult<media::AudioPort>
+legacy2aidl_audio_port_v7_AudioPort(const audio_port_v7& legacy) {
+    media::AudioPort aidl;
+    RETURN_IF_ERROR(legacy2aidl_audio_port_v7_AudioPort_inplace(legacy, &aidl));
     return aidl;
 }
 
+status_t aidl2legacy_AudioPorts_audio_port_v7s(
+        const std::vector<media::AudioPort>& aidl, audio_port_v7* legacy, size_t maxCount) {
+    const size_t count = std::min(aidl.size(), maxCount);
+    for (size_t i = 0; i < count; ++i) {
+        RETURN_STATUS_IF_ERROR(aidl2legacy_AudioPort_audio_port_v7_inplace(aidl[i], &legacy[i]));
+    }
+    return OK;
+}
+
+status_t legacy2aidl_audio_port_v7s_AudioPorts(
+        const audio_port_v7* legacy, size_t count, std::vector<media::AudioPort>* aidl) {
+    aidl->resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        RETURN_STATUS_IF_ERROR(legacy2aidl_audio_port_v7_AudioPort_inplace(legacy[i], &(*aidl)[i]));
+    }
+    return OK;
+}
+
 ConversionResult<audio_mode_t>
 aidl2legacy_AudioMode_audio_mode_t(AudioMode aidl) {
     switch (aidl) {
@@ -19,11 +19,17 @@
 
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <optional>
+
 #include <android/media/IAudioPolicyService.h>
 #include <android/media/BnCaptureStateListener.h>
 #include <binder/IServiceManager.h>
 #include <binder/ProcessState.h>
 #include <binder/IPCThreadState.h>
+#include <cutils/properties.h>
 #include <media/AidlConversion.h>
 #include <media/AudioResamplerPublic.h>
 #include <media/AudioSystem.h>
@@ -31,6 +37,7 @@
 #include <media/PolicyAidlConversion.h>
 #include <media/TypeConverter.h>
 #include <math.h>
+#include <utils/Timers.h>
 
 #include <system/audio.h>
 #include <android/media/GetInputForAttrResponse.h>
@@ -60,6 +67,114 @@ using media::audio::common::AudioStreamType;
 using media::audio::common::AudioUsage;
 using media::audio::common::Int;
 
+namespace {
+
+/**
+ * Client side cache of the routing queries that are issued repeatedly with the same arguments,
+ * e.g. getOutput() behind getOutputSamplingRate() and friends, and getDevicesForAttributes().
+ *
+ * Entries are dropped whenever this process learns that routing may have changed: io
+ * configuration events from AudioFlinger, port and patch list updates and routing updates from
+ * AudioPolicyService, death of either service, and routing changes requested through this
+ * process. Changes made by other processes that do not produce any of these notifications are
+ * bounded by the maximum age of an entry.
+ *
+ * Disabled unless "audio.client.query_cache_max_age_ms" is set to a positive value.
+ */
+class RoutingQueryCache {
+public:
+    static RoutingQueryCache& getInstance() {
+        static RoutingQueryCache instance;
+        return instance;
+    }
+
+    bool isEnabled() const { return mMaxAgeNs > 0; }
+
+    // Returns the generation to pass to the matching put method.
+    uint64_t getGeneration() const {
+        std::lock_guard _l(mMutex);
+        return mGeneration;
+    }
+
+    void invalidate() {
+        if (!isEnabled()) return;
+        std::lock_guard _l(mMutex);
+        ++mGeneration;
+        mOutputs.clear();
+        mDevices.clear();
+    }
+
+    std::optional<audio_io_handle_t> getOutput(audio_stream_type_t stream) const {
+        if (!isEnabled()) return std::nullopt;
+        std::lock_guard _l(mMutex);
+        return get_l(mOutputs, stream);
+    }
+
+    void putOutput(uint64_t generation, audio_stream_type_t stream, audio_io_handle_t output) {
+        if (!isEnabled()) return;
+        std::lock_guard _l(mMutex);
+        put_l(mOutputs, generation, stream, output);
+    }
+
+    std::optional<AudioDeviceTypeAddrVector> getDevices(const std::string& key) const {
+        if (!isEnabled()) return std::nullopt;
+        std::lock_guard _l(mMutex);
+        return get_l(mDevices, key);
+    }
+
+    void putDevices(uint64_t generation, const std::string& key,
+                    const AudioDeviceTypeAddrVector& devices) {
+        if (!isEnabled()) return;
+        std::lock_guard _l(mMutex);
+        put_l(mDevices, generation, key, devices);
+    }
+
+private:
+    template <typename V>
+    struct Entry {
+        V value;
+        nsecs_t timestampNs;
+    };
+
+    RoutingQueryCache()
+        : mMaxAgeNs(milliseconds_to_nanoseconds(
+                std::max(0, property_get_int32("audio.client.query_cache_max_age_ms", 0)))) {}
+
+    template <typename K, typename V>
+    std::optional<V> get_l(const std::map<K, Entry<V>>& map, const K& key) const {
+        const auto it = map.find(key);
+        if (it == map.end() || systemTime() - it->second.timestampNs > mMaxAgeNs) {
+            return std::nullopt;
+        }
+        return it->second.value;
+    }
+
+    template <typename K, typename V>
+    void put_l(std::map<K, Entry<V>>& map, uint64_t generation, const K& key, const V& value) {
+        // A result fetched before an invalidation may already be stale.
+        if (generation != mGeneration) return;
+        map[key] = Entry<V>{value, systemTime()};
+    }
+
+    const nsecs_t mMaxAgeNs;
+    mutable std::mutex mMutex;
+    uint64_t mGeneration = 0;  // GUARDED_BY(mMutex)
+    std::map<audio_stream_type_t, Entry<audio_io_handle_t>> mOutputs;  // GUARDED_BY(mMutex)
+    std::map<std::string, Entry<AudioDeviceTypeAddrVector>> mDevices;  // GUARDED_BY(mMutex)
+};
+
+void invalidateRoutingQueryCache() {
+    RoutingQueryCache::getInstance().invalidate();
+}
+
+// Invalidates the cache once a routing change requested by this process has been applied.
+status_t invalidateRoutingQueryCacheAfter(status_t status) {
+    invalidateRoutingQueryCache();
+    return status;
+}
+
+} // namespace
+
 // client singleton for AudioFlinger binder interface
 Mutex AudioSystem::gLock;
 Mutex AudioSystem::gLockErrorCallbacks;
@@ -523,6 +638,7 @@ void AudioSystem::AudioFlingerClient::clearIoCache() {
     mInSamplingRate = 0;
     mInFormat = AUDIO_FORMAT_DEFAULT;
     mInChannelMask = AUDIO_CHANNEL_NONE;
+    invalidateRoutingQueryCache();
 }
 
 void AudioSystem::AudioFlingerClient::binderDied(const wp<IBinder>& who __unused) {
@@ -552,6 +668,10 @@ Status AudioSystem::AudioFlingerClient::ioConfigChanged(
 
     if (ioDesc->getIoHandle() == AUDIO_IO_HANDLE_NONE) return Status::ok();
 
+    if (event != AUDIO_CLIENT_STARTED) {
+        invalidateRoutingQueryCache();
+    }
+
     audio_port_handle_t deviceId = AUDIO_PORT_HANDLE_NONE;
     std::vector<sp<AudioDeviceCallback>> callbacksToCall;
     {
@@ -873,7 +993,9 @@ const sp<IAudioPolicyService> AudioSystem::get_audio_policy_service() {
     if (apc != 0) {
         int64_t token = IPCThreadState::self()->clearCallingIdentity();
         ap->registerClient(apc);
-        ap->setAudioPortCallbacksEnabled(apc->isAudioPortCbEnabled());
+        // Port and patch updates are also needed to invalidate the routing query cache.
+        ap->setAudioPortCallbacksEnabled(
+                apc->isAudioPortCbEnabled() || RoutingQueryCache::getInstance().isEnabled());
         ap->setAudioVolumeGroupCallbacksEnabled(apc->isAudioVolumeGroupCbEnabled());
         IPCThreadState::self()->restoreCallingIdentity(token);
     }
@@ -882,8 +1004,11 @@ const sp<IAudioPolicyService> AudioSystem::get_audio_policy_service() {
 }
 
 void AudioSystem::clearAudioPolicyService() {
-    Mutex::Autolock _l(gLockAPS);
-    gAudioPolicyService.clear();
+    {
+        Mutex::Autolock _l(gLockAPS);
+        gAudioPolicyService.clear();
+    }
+    invalidateRoutingQueryCache();
 }
 
 // ---------------------------------------------------------------------------
@@ -901,13 +1026,13 @@ status_t AudioSystem::setDeviceConnectionState(audio_policy_dev_state_t state,
 
     if (aps == 0) return PERMISSION_DENIED;
 
-    return statusTFromBinderStatus(
+    return invalidateRoutingQueryCacheAfter(statusTFromBinderStatus(
             aps->setDeviceConnectionState(
                     VALUE_OR_RETURN_STATUS(
                             legacy2aidl_audio_policy_dev_state_t_AudioPolicyDeviceState(state)),
                     port,
                     VALUE_OR_RETURN_STATUS(
-                            legacy2aidl_audio_format_t_AudioFormatDescription(encodedFormat))));
+                            legacy2aidl_audio_format_t_AudioFormatDescription(encodedFormat)))));
 }
 
 audio_policy_dev_state_t AudioSystem::getDeviceConnectionState(audio_devices_t device,
@@ -948,9 +1073,9 @@ status_t AudioSystem::handleDeviceConfigChange(audio_devices_t device,
     AudioDevice deviceAidl = VALUE_OR_RETURN_STATUS(
             legacy2aidl_audio_device_AudioDevice(device, address));
 
-    return statusTFromBinderStatus(
+    return invalidateRoutingQueryCacheAfter(statusTFromBinderStatus(
             aps->handleDeviceConfigChange(deviceAidl, name, VALUE_OR_RETURN_STATUS(
-                    legacy2aidl_audio_format_t_AudioFormatDescription(encodedFormat))));
+                    legacy2aidl_audio_format_t_AudioFormatDescription(encodedFormat)))));
 }
 
 status_t AudioSystem::setPhoneState(audio_mode_t state, uid_t uid) {
@@ -958,9 +1083,9 @@ status_t AudioSystem::setPhoneState(audio_mode_t state, uid_t uid) {
     const sp<IAudioPolicyService>& aps = AudioSystem::get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
 
-    return statusTFromBinderStatus(aps->setPhoneState(
+    return invalidateRoutingQueryCacheAfter(statusTFromBinderStatus(aps->setPhoneState(
             VALUE_OR_RETURN_STATUS(legacy2aidl_audio_mode_t_AudioMode(state)),
-            VALUE_OR_RETURN_STATUS(legacy2aidl_uid_t_int32_t(uid))));
+            VALUE_OR_RETURN_STATUS(legacy2aidl_uid_t_int32_t(uid)))));
 }
 
 status_t
@@ -968,13 +1093,13 @@ AudioSystem::setForceUse(audio_policy_force_use_t usage, audio_policy_forced_cfg
     const sp<IAudioPolicyService>& aps = AudioSystem::get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
 
-    return statusTFromBinderStatus(
+    return invalidateRoutingQueryCacheAfter(statusTFromBinderStatus(
             aps->setForceUse(
                     VALUE_OR_RETURN_STATUS(
                             legacy2aidl_audio_policy_force_use_t_AudioPolicyForceUse(usage)),
                     VALUE_OR_RETURN_STATUS(
                             legacy2aidl_audio_policy_forced_cfg_t_AudioPolicyForcedConfig(
-                                    config))));
+                                    config)))));
 }
 
 audio_policy_forced_cfg_t AudioSystem::getForceUse(audio_policy_force_use_t usage) {
@@ -995,6 +1120,12 @@ audio_policy_forced_cfg_t AudioSystem::getForceUse(audio_policy_force_use_t usag
 
 
 audio_io_handle_t AudioSystem::getOutput(audio_stream_type_t stream) {
+    RoutingQueryCache& cache = RoutingQueryCache::getInstance();
+    if (const auto cached = cache.getOutput(stream); cached.has_value()) {
+        return *cached;
+    }
+    const uint64_t generation = cache.getGeneration();
+
     const sp<IAudioPolicyService>& aps = AudioSystem::get_audio_policy_service();
     if (aps == 0) return AUDIO_IO_HANDLE_NONE;
 
@@ -1007,6 +1138,9 @@ audio_io_handle_t AudioSystem::getOutput(audio_stream_type_t stream) {
         return aidl2legacy_int32_t_audio_io_handle_t(outputAidl);
     }();
 
+    if (result.ok() && result.value() != AUDIO_IO_HANDLE_NONE) {
+        cache.putOutput(generation, stream, result.value());
+    }
     return result.value_or(AUDIO_IO_HANDLE_NONE);
 }
 
@@ -1328,11 +1462,23 @@ status_t AudioSystem::getDevicesForAttributes(const AudioAttributes& aa,
     if (devices == nullptr) {
         return BAD_VALUE;
     }
+    media::AudioAttributesEx aaAidl = VALUE_OR_RETURN_STATUS(
+            legacy2aidl_AudioAttributes_AudioAttributesEx(aa));
+
+    RoutingQueryCache& cache = RoutingQueryCache::getInstance();
+    std::string key;
+    if (cache.isEnabled()) {
+        key = aaAidl.toString() + (forVolume ? "|volume" : "");
+        if (auto cached = cache.getDevices(key); cached.has_value()) {
+            *devices = std::move(*cached);
+            return OK;
+        }
+    }
+    const uint64_t generation = cache.getGeneration();
+
     const sp<IAudioPolicyService>& aps = AudioSystem::get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
 
-    media::AudioAttributesEx aaAidl = VALUE_OR_RETURN_STATUS(
-            legacy2aidl_AudioAttributes_AudioAttributesEx(aa));
     std::vector<AudioDevice> retAidl;
     RETURN_STATUS_IF_ERROR(
             statusTFromBinderStatus(aps->getDevicesForAttributes(aaAidl, forVolume, &retAidl)));
@@ -1340,6 +1486,9 @@ status_t AudioSystem::getDevicesForAttributes(const AudioAttributes& aa,
             convertContainer<AudioDeviceTypeAddrVector>(
                     retAidl,
                     aidl2legacy_AudioDeviceTypeAddress));
+    if (cache.isEnabled()) {
+        cache.putDevices(generation, key, *devices);
+    }
     return OK;
 }
 
@@ -1534,13 +1683,13 @@ status_t AudioSystem::listAudioPorts(audio_port_role_t role,
     numPortsAidl.value = VALUE_OR_RETURN_STATUS(convertIntegral<int32_t>(*num_ports));
     std::vector<media::AudioPort> portsAidl;
     int32_t generationAidl;
+    const size_t maxPorts = *num_ports;
 
     RETURN_STATUS_IF_ERROR(statusTFromBinderStatus(
             aps->listAudioPorts(roleAidl, typeAidl, &numPortsAidl, &portsAidl, &generationAidl)));
     *num_ports = VALUE_OR_RETURN_STATUS(convertIntegral<unsigned int>(numPortsAidl.value));
     *generation = VALUE_OR_RETURN_STATUS(convertIntegral<unsigned int>(generationAidl));
-    RETURN_STATUS_IF_ERROR(convertRange(portsAidl.begin(), portsAidl.end(), ports,
-                                        aidl2legacy_AudioPort_audio_port_v7));
+    RETURN_STATUS_IF_ERROR(aidl2legacy_AudioPorts_audio_port_v7s(portsAidl, ports, maxPorts));
     return OK;
 }
 
@@ -1648,7 +1797,7 @@ status_t AudioSystem::removeAudioPortCallback(const sp<AudioPortCallback>& callb
         return NO_INIT;
     }
     int ret = gAudioPolicyServiceClient->removeAudioPortCallback(callback);
-    if (ret == 0) {
+    if (ret == 0 && !RoutingQueryCache::getInstance().isEnabled()) {
         aps->setAudioPortCallbacksEnabled(false);
     }
     return (ret < 0) ? INVALID_OPERATION : NO_ERROR;
@@ -1788,7 +1937,8 @@ status_t AudioSystem::registerPolicyMixes(const Vector<AudioMix>& mixes, bool re
     RETURN_STATUS_IF_ERROR(
             convertRange(mixes.begin(), mixes.begin() + mixesSize, std::back_inserter(mixesAidl),
                          legacy2aidl_AudioMix));
-    return statusTFromBinderStatus(aps->registerPolicyMixes(mixesAidl, registration));
+    return invalidateRoutingQueryCacheAfter(
+            statusTFromBinderStatus(aps->registerPolicyMixes(mixesAidl, registration)));
 }
 
 status_t AudioSystem::setUidDeviceAffinities(uid_t uid, const AudioDeviceTypeAddrVector& devices) {
@@ -1799,7 +1949,8 @@ status_t AudioSystem::setUidDeviceAffinities(uid_t uid, const AudioDeviceTypeAdd
     std::vector<AudioDevice> devicesAidl = VALUE_OR_RETURN_STATUS(
             convertContainer<std::vector<AudioDevice>>(devices,
                                                               legacy2aidl_AudioDeviceTypeAddress));
-    return statusTFromBinderStatus(aps->setUidDeviceAffinities(uidAidl, devicesAidl));
+    return invalidateRoutingQueryCacheAfter(
+            statusTFromBinderStatus(aps->setUidDeviceAffinities(uidAidl, devicesAidl)));
 }
 
 status_t AudioSystem::removeUidDeviceAffinities(uid_t uid) {
@@ -1807,7 +1958,8 @@ status_t AudioSystem::removeUidDeviceAffinities(uid_t uid) {
     if (aps == 0) return PERMISSION_DENIED;
 
     int32_t uidAidl = VALUE_OR_RETURN_STATUS(legacy2aidl_uid_t_int32_t(uid));
-    return statusTFromBinderStatus(aps->removeUidDeviceAffinities(uidAidl));
+    return invalidateRoutingQueryCacheAfter(
+            statusTFromBinderStatus(aps->removeUidDeviceAffinities(uidAidl)));
 }
 
 status_t AudioSystem::setUserIdDeviceAffinities(int userId,
@@ -1819,15 +1971,16 @@ status_t AudioSystem::setUserIdDeviceAffinities(int userId,
     std::vector<AudioDevice> devicesAidl = VALUE_OR_RETURN_STATUS(
             convertContainer<std::vector<AudioDevice>>(devices,
                                                        legacy2aidl_AudioDeviceTypeAddress));
-    return statusTFromBinderStatus(
-            aps->setUserIdDeviceAffinities(userIdAidl, devicesAidl));
+    return invalidateRoutingQueryCacheAfter(statusTFromBinderStatus(
+            aps->setUserIdDeviceAffinities(userIdAidl, devicesAidl)));
 }
 
 status_t AudioSystem::removeUserIdDeviceAffinities(int userId) {
     const sp<IAudioPolicyService>& aps = AudioSystem::get_audio_policy_service();
     if (aps == 0) return PERMISSION_DENIED;
     int32_t userIdAidl = VALUE_OR_RETURN_STATUS(convertReinterpret<int32_t>(userId));
-    return statusTFromBinderStatus(aps->removeUserIdDeviceAffinities(userIdAidl));
+    return invalidateRoutingQueryCacheAfter(
+            statusTFromBinderStatus(aps->removeUserIdDeviceAffinities(userIdAidl)));
 }
 
 status_t AudioSystem::startAudioSource(const struct audio_port_config* source,
@@ -2200,8 +2353,8 @@ status_t AudioSystem::setDevicesRoleForStrategy(product_strategy_t strategy,
     std::vector<AudioDevice> devicesAidl = VALUE_OR_RETURN_STATUS(
             convertContainer<std::vector<AudioDevice>>(devices,
                                                        legacy2aidl_AudioDeviceTypeAddress));
-    return statusTFromBinderStatus(
-            aps->setDevicesRoleForStrategy(strategyAidl, roleAidl, devicesAidl));
+    return invalidateRoutingQueryCacheAfter(statusTFromBinderStatus(
+            aps->setDevicesRoleForStrategy(strategyAidl, roleAidl, devicesAidl)));
 }
 
 status_t
@@ -2212,8 +2365,8 @@ AudioSystem::removeDevicesRoleForStrategy(product_strategy_t strategy, device_ro
     }
     int32_t strategyAidl = VALUE_OR_RETURN_STATUS(legacy2aidl_product_strategy_t_int32_t(strategy));
     media::DeviceRole roleAidl = VALUE_OR_RETURN_STATUS(legacy2aidl_device_role_t_DeviceRole(role));
-    return statusTFromBinderStatus(
-            aps->removeDevicesRoleForStrategy(strategyAidl, roleAidl));
+    return invalidateRoutingQueryCacheAfter(statusTFromBinderStatus(
+            aps->removeDevicesRoleForStrategy(strategyAidl, roleAidl)));
 }
 
 status_t AudioSystem::getDevicesForRoleAndStrategy(product_strategy_t strategy,
@@ -2248,8 +2401,8 @@ status_t AudioSystem::setDevicesRoleForCapturePreset(audio_source_t audioSource,
     std::vector<AudioDevice> devicesAidl = VALUE_OR_RETURN_STATUS(
             convertContainer<std::vector<AudioDevice>>(devices,
                                                        legacy2aidl_AudioDeviceTypeAddress));
-    return statusTFromBinderStatus(
-            aps->setDevicesRoleForCapturePreset(audioSourceAidl, roleAidl, devicesAidl));
+    return invalidateRoutingQueryCacheAfter(statusTFromBinderStatus(
+            aps->setDevicesRoleForCapturePreset(audioSourceAidl, roleAidl, devicesAidl)));
 }
 
 status_t AudioSystem::addDevicesRoleForCapturePreset(audio_source_t audioSource,
@@ -2265,8 +2418,8 @@ status_t AudioSystem::addDevicesRoleForCapturePreset(audio_source_t audioSource,
     std::vector<AudioDevice> devicesAidl = VALUE_OR_RETURN_STATUS(
             convertContainer<std::vector<AudioDevice>>(devices,
                                                        legacy2aidl_AudioDeviceTypeAddress));
-    return statusTFromBinderStatus(
-            aps->addDevicesRoleForCapturePreset(audioSourceAidl, roleAidl, devicesAidl));
+    return invalidateRoutingQueryCacheAfter(statusTFromBinderStatus(
+            aps->addDevicesRoleForCapturePreset(audioSourceAidl, roleAidl, devicesAidl)));
 }
 
 status_t AudioSystem::removeDevicesRoleForCapturePreset(
@@ -2281,8 +2434,8 @@ status_t AudioSystem::removeDevicesRoleForCapturePreset(
     std::vector<AudioDevice> devicesAidl = VALUE_OR_RETURN_STATUS(
             convertContainer<std::vector<AudioDevice>>(devices,
                                                        legacy2aidl_AudioDeviceTypeAddress));
-    return statusTFromBinderStatus(
-            aps->removeDevicesRoleForCapturePreset(audioSourceAidl, roleAidl, devicesAidl));
+    return invalidateRoutingQueryCacheAfter(statusTFromBinderStatus(
+            aps->removeDevicesRoleForCapturePreset(audioSourceAidl, roleAidl, devicesAidl)));
 }
 
 status_t AudioSystem::clearDevicesRoleForCapturePreset(audio_source_t audioSource,
@@ -2294,8 +2447,8 @@ status_t AudioSystem::clearDevicesRoleForCapturePreset(audio_source_t audioSourc
     AudioSource audioSourceAidl = VALUE_OR_RETURN_STATUS(
             legacy2aidl_audio_source_t_AudioSource(audioSource));
     media::DeviceRole roleAidl = VALUE_OR_RETURN_STATUS(legacy2aidl_device_role_t_DeviceRole(role));
-    return statusTFromBinderStatus(
-            aps->clearDevicesRoleForCapturePreset(audioSourceAidl, roleAidl));
+    return invalidateRoutingQueryCacheAfter(statusTFromBinderStatus(
+            aps->clearDevicesRoleForCapturePreset(audioSourceAidl, roleAidl)));
 }
 
 status_t AudioSystem::getDevicesForRoleAndCapturePreset(audio_source_t audioSource,
@@ -2544,6 +2697,7 @@ int AudioSystem::AudioPolicyServiceClient::removeAudioPortCallback(
 
 
 Status AudioSystem::AudioPolicyServiceClient::onAudioPortListUpdate() {
+    invalidateRoutingQueryCache();
     Mutex::Autolock _l(mLock);
     for (size_t i = 0; i < mAudioPortCallbacks.size(); i++) {
         mAudioPortCallbacks[i]->onAudioPortListUpdate();
@@ -2552,6 +2706,7 @@ Status AudioSystem::AudioPolicyServiceClient::onAudioPortListUpdate() {
 }
 
 Status AudioSystem::AudioPolicyServiceClient::onAudioPatchListUpdate() {
+    invalidateRoutingQueryCache();
     Mutex::Autolock _l(mLock);
     for (size_t i = 0; i < mAudioPortCallbacks.size(); i++) {
         mAudioPortCallbacks[i]->onAudioPatchListUpdate();
@@ -2662,6 +2817,7 @@ Status AudioSystem::AudioPolicyServiceClient::onRecordingConfigurationUpdate(
 }
 
 Status AudioSystem::AudioPolicyServiceClient::onRoutingUpdated() {
+    invalidateRoutingQueryCache();
     routing_callback cb = NULL;
     {
         Mutex::Autolock _l(AudioSystem::gLock);
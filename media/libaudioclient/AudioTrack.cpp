@@ -1096,6 +1096,15 @@ void AudioTrack::stop()
 {
     const int64_t beginNs = systemTime();
 
+    // Let the staged data play out, unless a write is in progress (and possibly blocked).
+    if (mWriteCoalescing && mStagingLock.tryLock() == NO_ERROR) {
+        if (mDiscardStaged.exchange(false)) {
+            mStagedBytes = 0;
+        }
+        (void) commitStaged(false /* blocking */);
+        mStagingLock.unlock();
+    }
+
     AutoMutex lock(mLock);
     mediametrics::Defer defer([&]() {
         mediametrics::LogItem(mMetricsId)
@@ -1175,6 +1184,15 @@ void AudioTrack::flush()
     if (mState == STATE_ACTIVE) {
         return;
     }
+    if (mWriteCoalescing) {
+        // Don't wait for a write in progress, which discards the staged data when it resumes.
+        if (mStagingLock.tryLock() == NO_ERROR) {
+            mStagedBytes = 0;
+            mStagingLock.unlock();
+        } else {
+            mDiscardStaged = true;
+        }
+    }
     flush_l();
 }
 
@@ -2508,6 +2526,17 @@ ssize_t AudioTrack::write(const void* buffer, size_t userSize, bool blocking)
         return BAD_VALUE;
     }
 
+    if (mWriteCoalescing) {
+        Mutex::Autolock _l(mStagingLock);
+        if (mWriteCoalescing) {
+            return writeCoalesced(buffer, userSize, blocking);
+        }
+    }
+    return writeToBuffer(buffer, userSize, blocking);
+}
+
+ssize_t AudioTrack::writeToBuffer(const void* buffer, size_t userSize, bool blocking)
+{
     size_t written = 0;
     Buffer audioBuffer;
 
@@ -2551,6 +2580,103 @@ ssize_t AudioTrack::write(const void* buffer, size_t userSize, bool blocking)
     return written;
 }
 
+ssize_t AudioTrack::writeCoalesced(const void* buffer, size_t userSize, bool blocking)
+{
+    if (mDiscardStaged.exchange(false)) {
+        mStagedBytes = 0;
+    }
+    userSize -= userSize % mFrameSize;
+    const size_t periodBytes = mStaging.size();
+
+    if (userSize >= periodBytes) {
+        // Commit the staged data first to preserve the order, then write directly.
+        if (mStagedBytes > 0) {
+            const ssize_t committed = commitStaged(blocking);
+            if (mStagedBytes > 0) {
+                return committed < 0 ? committed : WOULD_BLOCK;
+            }
+        }
+        return writeToBuffer(buffer, userSize, blocking);
+    }
+
+    // Complete the period, commit it, and stage the rest.
+    size_t accepted = std::min(userSize, periodBytes - mStagedBytes);
+    memcpy(mStaging.data() + mStagedBytes, buffer, accepted);
+    mStagedBytes += accepted;
+    if (mStagedBytes == periodBytes) {
+        // On error the data remains staged, and the error is reported by the next write.
+        (void) commitStaged(blocking);
+        const size_t remaining = std::min(userSize - accepted, periodBytes - mStagedBytes);
+        memcpy(mStaging.data() + mStagedBytes, (const char *) buffer + accepted, remaining);
+        mStagedBytes += remaining;
+        accepted += remaining;
+    }
+    return accepted;
+}
+
+ssize_t AudioTrack::commitStaged(bool blocking)
+{
+    if (mStagedBytes == 0) {
+        return 0;
+    }
+    const ssize_t written = writeToBuffer(mStaging.data(), mStagedBytes, blocking);
+    if (written > 0) {
+        mStagedBytes -= written;
+        memmove(mStaging.data(), mStaging.data() + written, mStagedBytes);
+    }
+    return written;
+}
+
+status_t AudioTrack::setWriteCoalescing(bool enabled)
+{
+    if (mTransfer != TRANSFER_SYNC && mTransfer != TRANSFER_SYNC_NOTIF_CALLBACK) {
+        return INVALID_OPERATION;
+    }
+    Mutex::Autolock _sl(mStagingLock);
+    if (enabled == mWriteCoalescing) {
+        return NO_ERROR;
+    }
+    if (!enabled) {
+        if (mDiscardStaged.exchange(false)) {
+            mStagedBytes = 0;
+        }
+        const ssize_t committed = commitStaged(true /* blocking */);
+        if (committed < 0) {
+            return committed;
+        }
+        mWriteCoalescing = false;
+        mStaging.clear();
+        mStagedBytes = 0;
+        return NO_ERROR;
+    }
+
+    size_t periodFrames;
+    {
+        AutoMutex lock(mLock);
+        if (isOffloadedOrDirect_l()) {
+            return INVALID_OPERATION;
+        }
+        // The period at which the server consumes data, but leave room for double buffering.
+        periodFrames = std::max(std::min((size_t) mNotificationFramesAct, mFrameCount / 2),
+                (size_t) 1);
+    }
+    ALOGV("%s(%d): staging %zu frames", __func__, mPortId, periodFrames);
+    mStaging.resize(periodFrames * mFrameSize);
+    mStagedBytes = 0;
+    mDiscardStaged = false;
+    mWriteCoalescing = true;
+    return NO_ERROR;
+}
+
+ssize_t AudioTrack::commitStagedWrites(bool blocking)
+{
+    Mutex::Autolock _l(mStagingLock);
+    if (mDiscardStaged.exchange(false)) {
+        mStagedBytes = 0;
+    }
+    return commitStaged(blocking);
+}
+
 // -------------------------------------------------------------------------
 
 nsecs_t AudioTrack::processAudioBuffer()
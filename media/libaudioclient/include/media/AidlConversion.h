@@ -385,6 +385,14 @@ aidl2legacy_AudioPort_audio_port_v7(const media::AudioPort& aidl);
 ConversionResult<media::AudioPort>
 legacy2aidl_audio_port_v7_AudioPort(const audio_port_v7& legacy);
 
+// Bulk conversions of port lists, converting each port in place in the destination.
+// At most maxCount ports are converted into legacy, which must have room for them.
+status_t aidl2legacy_AudioPorts_audio_port_v7s(
+        const std::vector<media::AudioPort>& aidl, audio_port_v7* legacy, size_t maxCount);
+// aidl is resized to count.
+status_t legacy2aidl_audio_port_v7s_AudioPorts(
+        const audio_port_v7* legacy, size_t count, std::vector<media::AudioPort>* aidl);
+
 ConversionResult<audio_mode_t>
 aidl2legacy_AudioMode_audio_mode_t(media::audio::common::AudioMode aidl);
 ConversionResult<media::audio::common::AudioMode>
@@ -28,8 +28,10 @@
 #include <utils/threads.h>
 #include <android/content/AttributionSourceState.h>
 
+#include <atomic>
 #include <chrono>
 #include <string>
+#include <vector>
 
 #include "android/media/BnAudioTrackCallback.h"
 #include "android/media/IAudioTrack.h"
@@ -1013,6 +1015,31 @@ public:
      */
             ssize_t     write(const void* buffer, size_t size, bool blocking = true);
 
+    /* Enables or disables coalescing of small writes, for TRANSFER_SYNC PCM tracks only.
+     * When enabled, write() accumulates data smaller than a notification period in a client
+     * side staging buffer, and only commits it to the shared buffer once a period is complete.
+     * This saves the control block update and server wakeup of each small write.
+     * Writes of a period or more first commit the staged data, and are then written as usual.
+     * Staged data is reported as written by write(), but is not visible to AudioFlinger and does
+     * not count in getFramesWritten() until it is committed.
+     * The staged data is committed by commitStagedWrites(), by stop() if no write is in progress,
+     * and when coalescing is disabled. It is discarded by flush().
+     *
+     * Returned status (from utils/Errors.h) can be:
+     *  - NO_ERROR: successful operation
+     *  - INVALID_OPERATION: the track does not use TRANSFER_SYNC or is offloaded or direct
+     *  - or the error of committing staged data when disabling
+     */
+            status_t    setWriteCoalescing(bool enabled);
+            bool        getWriteCoalescing() const { return mWriteCoalescing; }
+
+    /* Commits the data staged by write coalescing to the shared buffer, for callers that need the
+     * data to be played without waiting for the period to complete.
+     * Returns the number of bytes committed >= 0, or the same negative status codes as write().
+     * 'blocking' has the same meaning as for write().
+     */
+            ssize_t     commitStagedWrites(bool blocking = true);
+
     /*
      * Dumps the state of an audio track.
      * Not a general-purpose API; intended only for use by media player service to dump its tracks.
@@ -1257,6 +1284,13 @@ public:
             static const nsecs_t NS_WHENEVER = -1, NS_INACTIVE = -2, NS_NEVER = -3;
             nsecs_t processAudioBuffer();
 
+            // transfers data to the shared buffer, implementation of write()
+            ssize_t writeToBuffer(const void* buffer, size_t userSize, bool blocking);
+
+            // write coalescing, caller must hold lock on mStagingLock but not on mLock
+            ssize_t writeCoalesced(const void* buffer, size_t userSize, bool blocking);
+            ssize_t commitStaged(bool blocking);
+
             // caller must hold lock on mLock for all _l methods
 
             void updateLatency_l(); // updates mAfLatency and mLatency from AudioSystem cache
@@ -1499,6 +1533,13 @@ public:
 
     mutable Mutex           mLock;
 
+    // Write coalescing, see setWriteCoalescing(). mStagingLock is acquired before mLock.
+    std::atomic<bool>       mWriteCoalescing{false};
+    std::atomic<bool>       mDiscardStaged{false};  // set by flush() while a write is in progress
+    Mutex                   mStagingLock;
+    std::vector<uint8_t>    mStaging;               // one period of data, protected by mStagingLock
+    size_t                  mStagedBytes = 0;       // protected by mStagingLock
+
     int                     mPreviousPriority;          // before start()
     SchedPolicy             mPreviousSchedulingGroup;
     bool                    mAwaitBoost;    // thread should wait for priority boost before running
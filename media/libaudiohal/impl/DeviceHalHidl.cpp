@@ -249,6 +249,12 @@ status_t DeviceHalHidl::openOutputStream(
     if (status_t status = CoreUtils::audioOutputFlagsFromHal(flags, &hidlFlags); status != OK) {
         return status;
     }
+    // Writes to a blocking deep buffer output may stay in flight while the mixer prepares
+    // the next buffer, their status is then collected at the start of the next write.
+    const bool pipelinedWrite = (flags & AUDIO_OUTPUT_FLAG_DEEP_BUFFER) != 0
+            && (flags & (AUDIO_OUTPUT_FLAG_DIRECT | AUDIO_OUTPUT_FLAG_NON_BLOCKING
+                    | AUDIO_OUTPUT_FLAG_COMPRESS_OFFLOAD)) == 0
+            && property_get_bool("audio.hal.pipelined_write", false /* default_value */);
     Result retval = Result::NOT_INITIALIZED;
 #if MAJOR_VERSION == 7 && MINOR_VERSION == 1
     Return<void> ret = mDevice->openOutputStream_7_1(
@@ -263,7 +269,7 @@ status_t DeviceHalHidl::openOutputStream(
                     const AudioConfig& suggestedConfig) {
                 retval = r;
                 if (retval == Result::OK) {
-                    *outStream = new StreamOutHalHidl(result);
+                    *outStream = new StreamOutHalHidl(result, pipelinedWrite);
                 }
                 HidlUtils::audioConfigToHal(suggestedConfig, config);
             });
@@ -157,7 +157,23 @@ bool EffectHalHidl::needToResetBuffers() {
     return inBufferFrameCountUpdated || outBufferFrameCountUpdated;
 }
 
+status_t EffectHalHidl::startProcess() {
+    return startProcessImpl(static_cast<uint32_t>(MessageQueueFlagBits::REQUEST_PROCESS));
+}
+
+status_t EffectHalHidl::waitProcess() {
+    return waitProcessImpl();
+}
+
 status_t EffectHalHidl::processImpl(uint32_t mqFlag) {
+    status_t status = startProcessImpl(mqFlag);
+    if (status != OK) {
+        return status;
+    }
+    return waitProcessImpl();
+}
+
+status_t EffectHalHidl::startProcessImpl(uint32_t mqFlag) {
     if (mEffect == 0 || mInBuffer == 0 || mOutBuffer == 0) return NO_INIT;
     status_t status;
     if (!mStatusMQ && (status = prepareForProcessing()) != OK) {
@@ -169,6 +185,10 @@ status_t EffectHalHidl::processImpl(uint32_t mqFlag) {
     // The data is already in the buffers, just need to flush it and wake up the server side.
     std::atomic_thread_fence(std::memory_order_release);
     mEfGroup->wake(mqFlag);
+    return OK;
+}
+
+status_t EffectHalHidl::waitProcessImpl() {
     uint32_t efState = 0;
 retry:
     status_t ret = mEfGroup->wait(
@@ -45,6 +45,10 @@ class EffectHalHidl : public EffectHalInterface, public EffectConversionHelperHi
     // Effect process function.
     virtual status_t process();
 
+    // Split form of process(), the effect processes on its HAL thread in between.
+    virtual status_t startProcess();
+    virtual status_t waitProcess();
+
     // Process reverse stream function. This function is used to pass
     // a reference stream to the effect engine.
     virtual status_t processReverse();
@@ -94,6 +98,8 @@ class EffectHalHidl : public EffectHalInterface, public EffectConversionHelperHi
     status_t prepareForProcessing();
     bool needToResetBuffers();
     status_t processImpl(uint32_t mqFlag);
+    status_t startProcessImpl(uint32_t mqFlag);
+    status_t waitProcessImpl();
     status_t setConfigImpl(
             uint32_t cmdCode, uint32_t cmdSize, void *pCmdData,
             uint32_t *replySize, void *pReplyData);
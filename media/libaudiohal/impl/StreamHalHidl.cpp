@@ -369,13 +369,15 @@ struct StreamOutCallback : public IStreamOutCallback {
 }  // namespace
 
 StreamOutHalHidl::StreamOutHalHidl(
-        const sp<::android::hardware::audio::CPP_VERSION::IStreamOut>& stream)
+        const sp<::android::hardware::audio::CPP_VERSION::IStreamOut>& stream,
+        bool pipelinedWrite)
         : StreamHalHidl("StreamOutHalHidl", stream.get())
-        , mStream(stream), mWriterClient(0), mEfGroup(nullptr) {
+        , mStream(stream), mWriterClient(0), mEfGroup(nullptr), mPipelinedWrite(pipelinedWrite) {
 }
 
 StreamOutHalHidl::~StreamOutHalHidl() {
     if (mStream != 0) {
+        completePendingWrite();
         if (mCallback.load().unsafe_get()) {
             processReturn("clearCallback", mStream->clearCallback());
         }
@@ -414,6 +416,12 @@ status_t StreamOutHalHidl::getLatency(uint32_t *latency) {
     }
 }
 
+status_t StreamOutHalHidl::standby() {
+    // The HAL must not enter standby while the writer thread still consumes a write.
+    completePendingWrite();
+    return StreamHalHidl::standby();
+}
+
 status_t StreamOutHalHidl::setVolume(float left, float right) {
     TIME_CHECK();
     if (mStream == 0) return NO_INIT;
@@ -483,23 +491,53 @@ status_t StreamOutHalHidl::write(const void *buffer, size_t bytes, size_t *writt
 status_t StreamOutHalHidl::callWriterThread(
         WriteCommand cmd, const char* cmdName,
         const uint8_t* data, size_t dataSize, StreamOutHalHidl::WriterCallback callback) {
+    std::lock_guard<std::mutex> _l(mWriterLock);
+    // The command and status queues hold a single message, so the status of a pipelined
+    // write has to be read before anything else is sent. A failure of that write is
+    // reported by the write that follows it.
+    if (status_t status = completePendingWrite_l();
+            status != OK && cmd == WriteCommand::WRITE) {
+        return status;
+    }
+    if (status_t status = sendWriterCommand_l(cmd, cmdName, data, &dataSize); status != OK) {
+        return status;
+    }
+    if (mPipelinedWrite && cmd == WriteCommand::WRITE) {
+        mWritePending = true;
+        mPendingWriteBytes = dataSize;
+        WriteStatus writeStatus;
+        writeStatus.retval = Result::OK;
+        writeStatus.replyTo = WriteCommand::WRITE;
+        writeStatus.reply.written = dataSize;
+        callback(writeStatus);
+        return OK;
+    }
+    return receiveWriterStatus_l(cmdName, callback);
+}
+
+status_t StreamOutHalHidl::sendWriterCommand_l(
+        WriteCommand cmd, const char* cmdName, const uint8_t* data, size_t* dataSize) {
     if (!mCommandMQ->write(&cmd)) {
         ALOGE("command message queue write failed for \"%s\"", cmdName);
         return -EAGAIN;
     }
     if (data != nullptr) {
         size_t availableToWrite = mDataMQ->availableToWrite();
-        if (dataSize > availableToWrite) {
+        if (*dataSize > availableToWrite) {
             ALOGW("truncating write data from %lld to %lld due to insufficient data queue space",
-                    (long long)dataSize, (long long)availableToWrite);
-            dataSize = availableToWrite;
+                    (long long)*dataSize, (long long)availableToWrite);
+            *dataSize = availableToWrite;
         }
-        if (!mDataMQ->write(data, dataSize)) {
+        if (!mDataMQ->write(data, *dataSize)) {
             ALOGE("data message queue write failed for \"%s\"", cmdName);
         }
     }
     mEfGroup->wake(static_cast<uint32_t>(MessageQueueFlagBits::NOT_EMPTY));
+    return OK;
+}
 
+status_t StreamOutHalHidl::receiveWriterStatus_l(
+        const char* cmdName, StreamOutHalHidl::WriterCallback callback) {
     // TODO: Remove manual event flag handling once blocking MQ is implemented. b/33815422
     uint32_t efState = 0;
 retry:
@@ -525,6 +563,22 @@ retry:
     return ret;
 }
 
+status_t StreamOutHalHidl::completePendingWrite() {
+    if (!mPipelinedWrite) return OK;
+    std::lock_guard<std::mutex> _l(mWriterLock);
+    return completePendingWrite_l();
+}
+
+status_t StreamOutHalHidl::completePendingWrite_l() {
+    if (!mWritePending) return OK;
+    mWritePending = false;
+    return receiveWriterStatus_l("write", [&](const WriteStatus& writeStatus) {
+        ALOGW_IF(writeStatus.reply.written != mPendingWriteBytes,
+                "hal wrote %lld of %lld bytes of a pipelined write",
+                (long long)writeStatus.reply.written, (long long)mPendingWriteBytes);
+    });
+}
+
 status_t StreamOutHalHidl::prepareForWriting(size_t bufferSize) {
     std::unique_ptr<CommandMQ> tempCommandMQ;
     std::unique_ptr<DataMQ> tempDataMQ;
@@ -639,6 +693,7 @@ status_t StreamOutHalHidl::supportsPauseAndResume(bool *supportsPause, bool *sup
 status_t StreamOutHalHidl::pause() {
     TIME_CHECK();
     if (mStream == 0) return NO_INIT;
+    completePendingWrite();
     return processReturn("pause", mStream->pause());
 }
 
@@ -657,6 +712,7 @@ status_t StreamOutHalHidl::supportsDrain(bool *supportsDrain) {
 status_t StreamOutHalHidl::drain(bool earlyNotify) {
     TIME_CHECK();
     if (mStream == 0) return NO_INIT;
+    completePendingWrite();
     return processReturn(
             "drain", mStream->drain(earlyNotify ? AudioDrain::EARLY_NOTIFY : AudioDrain::ALL));
 }
@@ -664,6 +720,7 @@ status_t StreamOutHalHidl::drain(bool earlyNotify) {
 status_t StreamOutHalHidl::flush() {
     TIME_CHECK();
     if (mStream == 0) return NO_INIT;
+    completePendingWrite();
     return processReturn("pause", mStream->flush());
 }
 
@@ -18,6 +18,7 @@
 #define ANDROID_HARDWARE_STREAM_HAL_HIDL_H
 
 #include <atomic>
+#include <mutex>
 
 #include PATH(android/hardware/audio/CORE_TYPES_FILE_VERSION/IStream.h)
 #include PATH(android/hardware/audio/CORE_TYPES_FILE_VERSION/IStreamIn.h)
@@ -125,6 +126,9 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
     // Return the audio hardware driver estimated latency in milliseconds.
     virtual status_t getLatency(uint32_t *latency);
 
+    // Put the audio hardware output into standby mode.
+    status_t standby() override;
+
     // Use this method in situations where audio mixing is done in the hardware.
     virtual status_t setVolume(float left, float right);
 
@@ -221,9 +225,16 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
     std::unique_ptr<StatusMQ> mStatusMQ;
     std::atomic<pid_t> mWriterClient;
     EventFlag* mEfGroup;
+    // When set, a write returns as soon as its command and data are queued to the HAL
+    // writer thread. Its status is collected before the next command is sent.
+    const bool mPipelinedWrite;
+    std::mutex mWriterLock;
+    bool mWritePending = false;  // guarded by mWriterLock
+    size_t mPendingWriteBytes = 0;  // guarded by mWriterLock
 
     // Can not be constructed directly by clients.
-    StreamOutHalHidl(const sp<::android::hardware::audio::CPP_VERSION::IStreamOut>& stream);
+    StreamOutHalHidl(const sp<::android::hardware::audio::CPP_VERSION::IStreamOut>& stream,
+            bool pipelinedWrite = false);
 
     virtual ~StreamOutHalHidl();
 
@@ -231,6 +242,12 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
     status_t callWriterThread(
             WriteCommand cmd, const char* cmdName,
             const uint8_t* data, size_t dataSize, WriterCallback callback);
+    status_t sendWriterCommand_l(
+            WriteCommand cmd, const char* cmdName, const uint8_t* data, size_t* dataSize);
+    status_t receiveWriterStatus_l(const char* cmdName, WriterCallback callback);
+    // Waits for the status of a pipelined write that is still in flight, if any.
+    status_t completePendingWrite();
+    status_t completePendingWrite_l();
     status_t prepareForWriting(size_t bufferSize);
 };
 
@@ -38,6 +38,15 @@ class EffectHalInterface : public RefBase
     // in output buffer descriptor.
     virtual status_t process() = 0;
 
+    // Split form of process(), so that the caller can have several effect engines
+    // processing concurrently.  startProcess() hands the buffers to the effect engine
+    // without waiting, and waitProcess() waits for completion and returns what process()
+    // would have returned.  The buffers must not be accessed in between.
+    // startProcess() returns INVALID_OPERATION if the split form is not supported,
+    // in which case process() must be used.
+    virtual status_t startProcess() { return INVALID_OPERATION; }
+    virtual status_t waitProcess() { return INVALID_OPERATION; }
+
     // Process reverse stream function. This function is used to pass
     // a reference stream to the effect engine.
     virtual status_t processReverse() = 0;
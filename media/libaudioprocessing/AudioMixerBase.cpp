@@ -28,6 +28,7 @@
 #include <utils/Log.h>
 
 #include "AudioMixerOps.h"
+#include "MixerWorkerPool.h"
 
 // The FCC_2 macro refers to the Fixed Channel Count of 2 for the legacy integer mixer.
 #ifndef FCC_2
@@ -601,6 +602,31 @@ size_t AudioMixerBase::getUnreleasedFrames(int name) const
     return 0;
 }
 
+AudioMixerBase::~AudioMixerBase()
+{
+}
+
+void AudioMixerBase::setParallelMixing(
+        size_t workerCount, size_t trackThreshold, uint64_t cpuMask)
+{
+    mWorkerPool.reset();
+    mWorkerOutputTemp.clear();
+    mWorkerResampleTemp.clear();
+    mPartitions.clear();
+    mParallelTrackThreshold = std::max(trackThreshold, (size_t)2);
+    if (workerCount > 0) {
+        mWorkerPool = std::make_unique<MixerWorkerPool>(workerCount, cpuMask);
+        for (size_t i = 0; i < workerCount; ++i) {
+            mWorkerOutputTemp.emplace_back(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+            mWorkerResampleTemp.emplace_back(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+        }
+        mPartitions.resize(workerCount + 1);
+    }
+    ALOGV("%s: workerCount:%zu trackThreshold:%zu cpuMask:%#llx",
+            __func__, workerCount, mParallelTrackThreshold, (unsigned long long)cpuMask);
+    invalidate();
+}
+
 std::string AudioMixerBase::trackNames() const
 {
     std::stringstream ss;
@@ -728,6 +754,20 @@ void AudioMixerBase::process__validate()
         }
     }
 
+    if (mWorkerPool != nullptr && mEnabled.size() >= mParallelTrackThreshold
+            && mHook != &AudioMixerBase::process__nop) {
+        if (mOutputTemp.get() == nullptr) {
+            mOutputTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+        }
+        if (mResampleTemp.get() == nullptr) {
+            mResampleTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+        }
+        for (auto &partition : mPartitions) {
+            partition.reserve(mEnabled.size());
+        }
+        mHook = &AudioMixerBase::process__parallelMixing;
+    }
+
     ALOGV("mixer configuration change: %zu "
         "all16BitsStereoNoResample=%d, resampling=%d, volumeRamp=%d",
         mEnabled.size(), all16BitsStereoNoResample, resampling, volumeRamp);
@@ -1163,6 +1203,41 @@ void AudioMixerBase::process__genericNoResampling()
     }
 }
 
+void AudioMixerBase::mixTrack(
+        TrackBase *t, int32_t *outTemp, int32_t *resampleTemp, size_t numFrames)
+{
+    int32_t *aux = NULL;
+    if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
+        aux = t->auxBuffer;
+    }
+
+    // this is a little goofy, on the resampling case we don't
+    // acquire/release the buffers because it's done by
+    // the resampler.
+    if (t->needs & NEEDS_RESAMPLE) {
+        (t->*t->hook)(outTemp, numFrames, resampleTemp, aux);
+    } else {
+
+        size_t outFrames = 0;
+
+        while (outFrames < numFrames) {
+            t->buffer.frameCount = numFrames - outFrames;
+            t->bufferProvider->getNextBuffer(&t->buffer);
+            t->mIn = t->buffer.raw;
+            // t->mIn == nullptr can happen if the track was flushed just after having
+            // been enabled for mixing.
+            if (t->mIn == nullptr) break;
+
+            (t->*t->hook)(
+                    outTemp + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
+                    resampleTemp, aux != nullptr ? aux + outFrames : nullptr);
+            outFrames += t->buffer.frameCount;
+
+            t->bufferProvider->releaseBuffer(&t->buffer);
+        }
+    }
+}
+
 // generic code with resampling
 void AudioMixerBase::process__genericResampling()
 {
@@ -1177,41 +1252,88 @@ void AudioMixerBase::process__genericResampling()
         // clear temp buffer
         memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
         for (const int name : group) {
-            const std::shared_ptr<TrackBase> &t = mTracks[name];
-            int32_t *aux = NULL;
-            if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
-                aux = t->auxBuffer;
-            }
-
-            // this is a little goofy, on the resampling case we don't
-            // acquire/release the buffers because it's done by
-            // the resampler.
-            if (t->needs & NEEDS_RESAMPLE) {
-                (t.get()->*t->hook)(outTemp, numFrames, mResampleTemp.get() /* naked ptr */, aux);
-            } else {
+            mixTrack(mTracks[name].get(), outTemp, mResampleTemp.get() /* naked ptr */,
+                    numFrames);
+        }
+        convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
+                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
+    }
+}
 
-                size_t outFrames = 0;
+void AudioMixerBase::mixPartition(size_t partition)
+{
+    int32_t *outTemp;
+    int32_t *resampleTemp;
+    if (partition == 0) {
+        outTemp = mOutputTemp.get();
+        resampleTemp = mResampleTemp.get();
+    } else {
+        outTemp = mWorkerOutputTemp[partition - 1].get();
+        resampleTemp = mWorkerResampleTemp[partition - 1].get();
+        memset(outTemp, 0, sizeof(*outTemp) * mPartitionSampleCount);
+    }
+    for (TrackBase *t : mPartitions[partition]) {
+        mixTrack(t, outTemp, resampleTemp, mFrameCount);
+    }
+}
 
-                while (outFrames < numFrames) {
-                    t->buffer.frameCount = numFrames - outFrames;
-                    t->bufferProvider->getNextBuffer(&t->buffer);
-                    t->mIn = t->buffer.raw;
-                    // t->mIn == nullptr can happen if the track was flushed just after having
-                    // been enabled for mixing.
-                    if (t->mIn == nullptr) break;
+// generic code, mixing partitions of each large group on the worker threads
+// into separate accumulation buffers, which are then summed.
+void AudioMixerBase::process__parallelMixing()
+{
+    ALOGVV("process__parallelMixing\n");
+    int32_t * const outTemp = mOutputTemp.get(); // naked ptr
+    const size_t partitions = mPartitions.size();
 
-                    (t.get()->*t->hook)(
-                            outTemp + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
-                            mResampleTemp.get() /* naked ptr */,
-                            aux != nullptr ? aux + outFrames : nullptr);
-                    outFrames += t->buffer.frameCount;
+    for (const auto &pair : mGroups) {
+        const auto &group = pair.second;
+        const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
+        const size_t sampleCount = t1->mMixerChannelCount * mFrameCount;
 
-                    t->bufferProvider->releaseBuffer(&t->buffer);
+        // clear temp buffer
+        memset(outTemp, 0, sizeof(*outTemp) * sampleCount);
+        if (group.size() < mParallelTrackThreshold) {
+            for (const int name : group) {
+                mixTrack(mTracks[name].get(), outTemp, mResampleTemp.get(), mFrameCount);
+            }
+        } else {
+            for (auto &partition : mPartitions) {
+                partition.clear();
+            }
+            size_t next = 0;
+            for (const int name : group) {
+                TrackBase *t = mTracks[name].get();
+                if (t->needs & NEEDS_AUX) {
+                    // aux buffers may be shared between tracks, so mix those on this thread.
+                    mPartitions[0].push_back(t);
+                } else {
+                    mPartitions[next].push_back(t);
+                    next = (next + 1) % partitions;
+                }
+            }
+            mPartitionSampleCount = sampleCount;
+            mWorkerPool->run([this](size_t worker) { mixPartition(worker + 1); });
+            mixPartition(0);
+            mWorkerPool->wait();
+
+            for (size_t i = 1; i < partitions; ++i) {
+                if (mPartitions[i].empty()) continue;
+                const int32_t *in = mWorkerOutputTemp[i - 1].get();
+                if (t1->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                    float *out = reinterpret_cast<float *>(outTemp);
+                    const float *fin = reinterpret_cast<const float *>(in);
+                    for (size_t j = 0; j < sampleCount; ++j) {
+                        out[j] += fin[j];
+                    }
+                } else {
+                    for (size_t j = 0; j < sampleCount; ++j) {
+                        outTemp[j] += in[j];
+                    }
                 }
             }
         }
         convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
-                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
+                outTemp, t1->mMixerInFormat, sampleCount);
     }
 }
 
@@ -1360,7 +1482,8 @@ static constexpr auto makeVMArray(std::index_sequence<Is...>)
 {
     using F = void(*)(TO*, size_t, const TI*, TA*, const TV*, TAV);
     return std::array<F, sizeof...(Is)>{
-            { &volumeMulti<MIXTYPE_MONOVOL(MIXTYPE, Is + 1), Is + 1, TO, TI, TV, TA, TAV> ... }
+            { selectVolumeMulti<MIXTYPE_MONOVOL(MIXTYPE, Is + 1), Is + 1,
+                    TO, TI, TV, TA, TAV>() ... }
         };
 }
 
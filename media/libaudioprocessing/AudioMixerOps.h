@@ -17,10 +17,20 @@
 #ifndef ANDROID_AUDIO_MIXER_OPS_H
 #define ANDROID_AUDIO_MIXER_OPS_H
 
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+
 #include <audio_utils/channels.h>
 #include <audio_utils/primitives.h>
 #include <system/audio.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace android {
 
 // Hack to make static_assert work in a constexpr
@@ -604,6 +614,171 @@ inline void volumeMulti(TO* out, size_t frameCount,
     }
 }
 
+/*
+ * Vectorized variants of volumeMulti for float input, float output and float volume
+ * without aux, which is the common case for multichannel float mixer tracks.
+ *
+ * The per-channel gain of a frame is fixed for a non-ramped volume, so we expand it
+ * once into a gain pattern which is a multiple of the 4 lane vector width, then apply
+ * the pattern with vector multiplies (or multiply-accumulates) across the frames.
+ * Only NCHAN == 2 or NCHAN a multiple of 4 (e.g. quad, 7.1, 7.1.4) are accelerated.
+ */
+namespace mixerops_simd {
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+constexpr bool kAvailable = true;
+using float4_t = float32x4_t;
+inline float4_t load4(const float *p) { return vld1q_f32(p); }
+inline void store4(float *p, float4_t v) { vst1q_f32(p, v); }
+inline float4_t mul4(float4_t a, float4_t b) { return vmulq_f32(a, b); }
+inline float4_t mla4(float4_t acc, float4_t a, float4_t b) {
+#if defined(__aarch64__)
+    return vfmaq_f32(acc, a, b);
+#else
+    return vmlaq_f32(acc, a, b);
+#endif
+}
+#elif defined(__SSE2__)
+constexpr bool kAvailable = true;
+using float4_t = __m128;
+inline float4_t load4(const float *p) { return _mm_loadu_ps(p); }
+inline void store4(float *p, float4_t v) { _mm_storeu_ps(p, v); }
+inline float4_t mul4(float4_t a, float4_t b) { return _mm_mul_ps(a, b); }
+inline float4_t mla4(float4_t acc, float4_t a, float4_t b) {
+#if defined(__FMA__)
+    return _mm_fmadd_ps(a, b, acc);
+#else
+    return _mm_add_ps(acc, _mm_mul_ps(a, b));
+#endif
+}
+#else
+constexpr bool kAvailable = false;
+#endif
+
+constexpr bool isAccumulating(int mixtype) {
+    return mixtype == MIXTYPE_MULTI
+            || mixtype == MIXTYPE_MULTI_MONOVOL
+            || mixtype == MIXTYPE_MULTI_STEREOVOL;
+}
+
+constexpr bool isStereoVolume(int mixtype) {
+    return mixtype == MIXTYPE_MULTI_STEREOVOL
+            || mixtype == MIXTYPE_MULTI_SAVEONLY_STEREOVOL;
+}
+
+// Size of the expanded gain pattern (in samples) for NCHAN channels.
+constexpr int gainPatternSize(int nchan) {
+    return nchan == 2 ? 4 : nchan;
+}
+
+} // namespace mixerops_simd
+
+// compile-time function.
+template <int MIXTYPE, int NCHAN, typename TO, typename TI, typename TV>
+constexpr bool isVolumeMultiAccelerated() {
+    using namespace mixerops_simd;
+    if constexpr (!kAvailable
+            || !std::is_same_v<TO, float>
+            || !std::is_same_v<TI, float>
+            || !std::is_same_v<std::decay_t<TV>, float>) {
+        return false;
+    } else if constexpr (NCHAN != 2 && (NCHAN <= 0 || NCHAN % 4 != 0)) {
+        return false;
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+        return NCHAN <= 2;
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL) {
+        return true;
+    } else if constexpr (isStereoVolume(MIXTYPE)) {
+        return canonicalChannelMaskFromCount(NCHAN) != AUDIO_CHANNEL_NONE;
+    } else {
+        return false;
+    }
+}
+
+/*
+ * Same contract as volumeMulti.  If aux is non-null or the configuration is not
+ * accelerated, this forwards to the scalar volumeMulti.
+ */
+template <int MIXTYPE, int NCHAN,
+        typename TO, typename TI, typename TV, typename TA, typename TAV>
+inline void volumeMultiAccelerated(TO* out, size_t frameCount,
+        const TI* in, TA* aux, const TV *vol, TAV vola)
+{
+    if constexpr (!isVolumeMultiAccelerated<MIXTYPE, NCHAN, TO, TI, TV>()) {
+        volumeMulti<MIXTYPE, NCHAN>(out, frameCount, in, aux, vol, vola);
+    } else {
+        using namespace mixerops_simd;
+        if (aux != NULL) {
+            volumeMulti<MIXTYPE, NCHAN>(out, frameCount, in, aux, vol, vola);
+            return;
+        }
+
+        // Per-channel gains for one frame.
+        float gains[NCHAN];
+        if constexpr (isStereoVolume(MIXTYPE)) {
+            float unity[NCHAN];
+            std::fill(std::begin(unity), std::end(unity), 1.f);
+            float *gainp = gains;
+            const float *unityp = unity;
+            stereoVolumeHelper<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, NCHAN>(
+                    gainp, unityp, vol, [] (const auto &a, const auto &b) {
+                return a * b;
+            });
+        } else if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+            for (int i = 0; i < NCHAN; ++i) gains[i] = vol[i];
+        } else /* constexpr MONOVOL */ {
+            for (int i = 0; i < NCHAN; ++i) gains[i] = vol[0];
+        }
+
+        constexpr int PATTERN = gainPatternSize(NCHAN); // samples per block
+        constexpr int VECTORS = PATTERN / 4;            // vectors per block
+        constexpr int FRAMES = PATTERN / NCHAN;         // frames per block
+        float4_t g[VECTORS];
+        {
+            float pattern[PATTERN];
+            for (int i = 0; i < PATTERN; ++i) pattern[i] = gains[i % NCHAN];
+            for (int i = 0; i < VECTORS; ++i) g[i] = load4(pattern + i * 4);
+        }
+
+        for (; frameCount >= FRAMES; frameCount -= FRAMES) {
+            for (int i = 0; i < VECTORS; ++i) {
+                if constexpr (isAccumulating(MIXTYPE)) {
+                    store4(out, mla4(load4(out), load4(in), g[i]));
+                } else {
+                    store4(out, mul4(load4(in), g[i]));
+                }
+                in += 4;
+                out += 4;
+            }
+        }
+        // remaining frames (only for NCHAN == 2).
+        for (; frameCount > 0; --frameCount) {
+            for (int i = 0; i < NCHAN; ++i) {
+                if constexpr (isAccumulating(MIXTYPE)) {
+                    *out++ += *in++ * gains[i];
+                } else {
+                    *out++ = *in++ * gains[i];
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Returns the volumeMulti function to use for mixing, selecting the vectorized
+ * variant when available for the configuration.
+ */
+template <int MIXTYPE, int NCHAN,
+        typename TO, typename TI, typename TV, typename TA, typename TAV>
+constexpr auto selectVolumeMulti() {
+    if constexpr (isVolumeMultiAccelerated<MIXTYPE, NCHAN, TO, TI, TV>()) {
+        return &volumeMultiAccelerated<MIXTYPE, NCHAN, TO, TI, TV, TA, TAV>;
+    } else {
+        return &volumeMulti<MIXTYPE, NCHAN, TO, TI, TV, TA, TAV>;
+    }
+}
+
 };
 
 #endif /* ANDROID_AUDIO_MIXER_OPS_H */
@@ -23,6 +23,10 @@
 #include <dlfcn.h>
 #include <math.h>
 
+#include <map>
+#include <mutex>
+#include <tuple>
+
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
 #include <utils/Log.h>
@@ -181,8 +185,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +210,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -232,6 +234,62 @@ void AudioResamplerDyn<TC, TI, TO>::setVolume(float left, float right)
     }
 }
 
+/*
+ * FilterBankCache is a process-wide cache of the generated polyphase filter banks.
+ *
+ * Generating a filter bank is costly, and many resamplers with identical parameters
+ * are typically created together (e.g. all tracks of a mixer on a device rate change).
+ * The cache is keyed by the filter design parameters, which are a function of the
+ * input and output sample rates and the quality, and holds weak references
+ * so a filter bank is freed when the last resampler using it is destroyed.
+ */
+template<typename TC>
+class FilterBankCache {
+public:
+    // phases, halfLength, stopBandAtten, fcr, attenuation
+    using Key = std::tuple<int, int, double, double, double>;
+
+    static FilterBankCache& getInstance() {
+        static FilterBankCache instance;
+        return instance;
+    }
+
+    // Returns the filter bank for key, generated by generate(coefs) if not cached.
+    template<typename F>
+    std::shared_ptr<TC> get(const Key &key, F generate) {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = mFilters.find(key);
+        if (it != mFilters.end()) {
+            std::shared_ptr<TC> coefs = it->second.lock();
+            if (coefs != nullptr) return coefs;
+        }
+        // remove expired entries, the cache is small.
+        for (auto it2 = mFilters.begin(); it2 != mFilters.end(); ) {
+            if (it2->second.expired()) {
+                it2 = mFilters.erase(it2);
+            } else {
+                ++it2;
+            }
+        }
+        const int phases = std::get<0>(key);
+        const int halfLength = std::get<1>(key);
+        TC *buffer = nullptr;
+        int ret = posix_memalign(
+                reinterpret_cast<void **>(&buffer),
+                CACHE_LINE_SIZE /* alignment */,
+                (phases + 1) * halfLength * sizeof(TC));
+        LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
+        std::shared_ptr<TC> coefs(buffer, free);
+        generate(buffer);
+        mFilters[key] = coefs;
+        return coefs;
+    }
+
+private:
+    std::mutex mLock;
+    std::map<Key, std::weak_ptr<TC>> mFilters; // guarded by mLock
+};
+
 // TODO: update to C++11
 
 template<typename T> T max(T a, T b) {return a > b ? a : b;}
@@ -263,24 +321,19 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     const int phases = c.mL;
     const int halfLength = c.mHalfNumCoefs;
 
-    // create buffer
-    TC *coefs = nullptr;
-    int ret = posix_memalign(
-            reinterpret_cast<void **>(&coefs),
-            CACHE_LINE_SIZE /* alignment */,
-            (phases + 1) * halfLength * sizeof(TC));
-    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
-
     // square the computed minimum passband value (extra safety).
     double attenuation =
             computeWindowedSincMinimumPassbandValue(stopBandAtten);
     attenuation *= attenuation;
 
-    // design filter
-    firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    // design filter, or share an identical one.
+    const typename FilterBankCache<TC>::Key key{
+            phases, halfLength, stopBandAtten, fcr, attenuation};
+    mCoefBuffer = FilterBankCache<TC>::getInstance().get(key,
+            [&](TC *coefs) {
+        firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    });
+    c.mFirCoefs = mCoefBuffer.get();
 
     // update the design criteria
     mNormalizedCutoffFrequency = fcr;
@@ -306,7 +359,7 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 
     const int32_t passSteps = 1000;
 
-    testFir(coefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
+    testFir(c.mFirCoefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
             passMin, passMax, passRipple, stopMax, stopRipple);
     ALOGD("passband(%lf, %lf): %.8lf %.8lf %.8lf\n", 0., fp, passMin, passMax, passRipple);
     ALOGD("stopband(%lf, %lf): %.8lf %.3lf\n", fs, 0.5, stopMax, stopRipple);
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MixerWorkerPool"
+//#define LOG_NDEBUG 0
+
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+
+#include <utils/Log.h>
+
+#include "MixerWorkerPool.h"
+
+namespace android {
+
+MixerWorkerPool::MixerWorkerPool(size_t workerCount, uint64_t cpuMask)
+{
+    mWorkers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        // find the i-th cpu in the mask, if any.
+        int cpu = -1;
+        for (size_t bit = 0, found = 0; bit < 64 && cpuMask != 0; ++bit) {
+            if ((cpuMask & (1ULL << bit)) != 0 && found++ == i) {
+                cpu = bit;
+                break;
+            }
+        }
+        mWorkers.emplace_back(&MixerWorkerPool::threadLoop, this, i, cpu);
+    }
+}
+
+MixerWorkerPool::~MixerWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExit = true;
+    }
+    mWorkCondition.notify_all();
+    for (auto &worker : mWorkers) {
+        worker.join();
+    }
+}
+
+void MixerWorkerPool::run(std::function<void(size_t)> job)
+{
+    if (!mSchedulingCopied) {
+        // mSchedulingCopied is only accessed by the dispatching thread.
+        mSchedulingCopied = true;
+        struct sched_param param{};
+        const int policy = sched_getscheduler(0 /* self */);
+        if (policy >= 0 && sched_getparam(0 /* self */, &param) == 0) {
+            std::lock_guard<std::mutex> lock(mLock);
+            mPolicy = policy;
+            mPriority = param.sched_priority;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        LOG_ALWAYS_FATAL_IF(mPending != 0, "%s: previous job still pending", __func__);
+        mJob = std::move(job);
+        mPending = mWorkers.size();
+        ++mGeneration;
+    }
+    mWorkCondition.notify_all();
+}
+
+void MixerWorkerPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mLock);
+    mDoneCondition.wait(lock, [this] { return mPending == 0; });
+}
+
+void MixerWorkerPool::threadLoop(size_t index, int cpu)
+{
+    const std::string name = "AudioMixWorker" + std::to_string(index);
+    pthread_setname_np(pthread_self(), name.c_str());
+    if (cpu >= 0) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu, &cpuSet);
+        if (sched_setaffinity(0 /* self */, sizeof(cpuSet), &cpuSet) != 0) {
+            ALOGW("%s: worker %zu failed to pin to cpu %d", __func__, index, cpu);
+        }
+    }
+
+    uint64_t generation = 0;
+    int policy = 0;
+    int priority = 0;
+    std::unique_lock<std::mutex> lock(mLock);
+    while (true) {
+        mWorkCondition.wait(lock, [&] { return mExit || mGeneration != generation; });
+        if (mExit) break;
+        generation = mGeneration;
+        if (mPolicy != policy || mPriority != priority) {
+            policy = mPolicy;
+            priority = mPriority;
+            struct sched_param param{ .sched_priority = priority };
+            const int ret = pthread_setschedparam(pthread_self(), policy, &param);
+            ALOGW_IF(ret != 0, "%s: worker %zu failed to set policy %d priority %d: %d",
+                    __func__, index, policy, priority, ret);
+        }
+        const std::function<void(size_t)> &job = mJob; // stable until mPending reaches 0.
+        lock.unlock();
+        job(index);
+        lock.lock();
+        if (--mPending == 0) {
+            mDoneCondition.notify_one();
+        }
+    }
+}
+
+}  // namespace android
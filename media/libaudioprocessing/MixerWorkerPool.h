@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_WORKER_POOL_H
+#define ANDROID_AUDIO_MIXER_WORKER_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+// MixerWorkerPool is a small pool of threads used by AudioMixerBase to mix
+// partitions of tracks in parallel.
+//
+// The caller dispatches a job to all workers with run(), which returns immediately,
+// does its own share of the work, then waits for the workers with wait().
+// Only one job may be outstanding at a time, and run() / wait() must be called
+// from the same (mixer) thread.
+class MixerWorkerPool {
+public:
+    // Worker i is pinned to the i-th cpu set in cpuMask, if cpuMask is nonzero.
+    MixerWorkerPool(size_t workerCount, uint64_t cpuMask);
+    ~MixerWorkerPool();
+
+    size_t workerCount() const { return mWorkers.size(); }
+
+    // Runs job(workerIndex) on each of the workers, workerIndex is in [0, workerCount).
+    void run(std::function<void(size_t)> job);
+
+    // Waits until all workers have completed the job dispatched by run().
+    void wait();
+
+private:
+    void threadLoop(size_t index, int cpu);
+
+    std::mutex mLock;
+    std::condition_variable mWorkCondition;  // signaled on new job or exit
+    std::condition_variable mDoneCondition;  // signaled when mPending reaches 0
+    std::function<void(size_t)> mJob;        // guarded by mLock
+    uint64_t mGeneration = 0;                // guarded by mLock, incremented per run()
+    size_t mPending = 0;                     // guarded by mLock, workers still running
+    bool mExit = false;                      // guarded by mLock
+
+    // Scheduling of the dispatching thread, copied to the workers on first run()
+    // since the mixer thread typically obtains its priority after the pool is created.
+    bool mSchedulingCopied = false;
+    int mPolicy = 0;                         // guarded by mLock
+    int mPriority = 0;                       // guarded by mLock
+
+    std::vector<std::thread> mWorkers;
+};
+
+}  // namespace android
+
+#endif  // ANDROID_AUDIO_MIXER_WORKER_POOL_H
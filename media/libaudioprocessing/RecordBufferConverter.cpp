@@ -25,6 +25,14 @@
 #include <media/RecordBufferConverter.h>
 #include <utils/Log.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RECORD_BUFFER_CONVERTER_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define RECORD_BUFFER_CONVERTER_USE_SSE2 1
+#endif
+
 #ifndef ARRAY_SIZE
 #define ARRAY_SIZE(x) (sizeof(x)/sizeof((x)[0]))
 #endif
@@ -37,6 +45,68 @@ static inline T max(const T& a, const T& b)
 
 namespace android {
 
+// Vectorized versions of the audio_utils legacy channel conversions, computing exactly the
+// same result. Four frames are processed at a time, the remainder with the scalar loop.
+
+// dst[i] = (src[2i] + src[2i+1]) * 0.5
+// dst may be the same as src, as the output never runs ahead of the input.
+static void downmixToMonoFloatFromStereoFloat(float *dst, const float *src, size_t frames)
+{
+    size_t i = 0;
+#if RECORD_BUFFER_CONVERTER_USE_NEON
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4x2_t stereo = vld2q_f32(src + 2 * i);
+        vst1q_f32(dst + i, vmulq_f32(vaddq_f32(stereo.val[0], stereo.val[1]), half));
+    }
+#elif RECORD_BUFFER_CONVERTER_USE_SSE2
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 a = _mm_loadu_ps(src + 2 * i);     // L0 R0 L1 R1
+        const __m128 b = _mm_loadu_ps(src + 2 * i + 4); // L2 R2 L3 R3
+        const __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+    }
+#endif
+    for (; i < frames; ++i) {
+        dst[i] = (src[2 * i] + src[2 * i + 1]) * 0.5f;
+    }
+}
+
+// dst[2i] = dst[2i+1] = src[i]
+// dst may be the same as src, as the frames are processed from the end.
+static void upmixToStereoFloatFromMonoFloat(float *dst, const float *src, size_t frames)
+{
+    size_t i = frames;
+#if RECORD_BUFFER_CONVERTER_USE_NEON || RECORD_BUFFER_CONVERTER_USE_SSE2
+    const size_t vectorFrames = frames & ~(size_t)3;
+    for (; i > vectorFrames; ) {
+        --i;
+        const float sample = src[i];
+        dst[2 * i] = sample;
+        dst[2 * i + 1] = sample;
+    }
+    for (; i > 0; ) {
+        i -= 4;
+#if RECORD_BUFFER_CONVERTER_USE_NEON
+        const float32x4_t mono = vld1q_f32(src + i);
+        vst2q_f32(dst + 2 * i, (float32x4x2_t{{mono, mono}}));
+#else
+        const __m128 mono = _mm_loadu_ps(src + i);
+        _mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(mono, mono));
+        _mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(mono, mono));
+#endif
+    }
+#endif
+    for (; i > 0; ) {
+        --i;
+        const float sample = src[i];
+        dst[2 * i] = sample;
+        dst[2 * i + 1] = sample;
+    }
+}
+
 RecordBufferConverter::RecordBufferConverter(
         audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
         uint32_t srcSampleRate,
@@ -234,10 +304,10 @@ void RecordBufferConverter::convertNoResampler(
     if (mIsLegacyUpmix || mIsLegacyDownmix) {
         void *dstBuf = mBuf != NULL ? mBuf : dst;
         if (mIsLegacyUpmix) {
-            upmix_to_stereo_float_from_mono_float((float *)dstBuf,
+            upmixToStereoFloatFromMonoFloat((float *)dstBuf,
                     (const float *)src, frames);
         } else /*mIsLegacyDownmix */ {
-            downmix_to_mono_float_from_stereo_float((float *)dstBuf,
+            downmixToMonoFloatFromStereoFloat((float *)dstBuf,
                     (const float *)src, frames);
         }
         if (mBuf != NULL) {
@@ -271,13 +341,13 @@ void RecordBufferConverter::convertResampler(
             || (mSrcChannelMask == mDstChannelMask && mSrcChannelCount == 1)) {
         // the resampler outputs stereo for mono input channel (a feature?)
         // must convert to mono
-        downmix_to_mono_float_from_stereo_float((float *)src,
+        downmixToMonoFloatFromStereoFloat((float *)src,
                 (const float *)src, frames);
     } else if (mSrcChannelMask != mDstChannelMask) {
         // convert to mono channel again for channel mask conversion (could be skipped
         // with further optimization).
         if (mSrcChannelCount == 1) {
-            downmix_to_mono_float_from_stereo_float((float *)src,
+            downmixToMonoFloatFromStereoFloat((float *)src,
                 (const float *)src, frames);
         }
         // convert to destination format (in place, OK as float is larger than other types)
@@ -36,6 +36,8 @@
 
 namespace android {
 
+class MixerWorkerPool;
+
 // ----------------------------------------------------------------------------
 
 // AudioMixerBase is functional on its own if only mixing and resampling
@@ -92,7 +94,7 @@ public:
         , mFrameCount(frameCount) {
     }
 
-    virtual ~AudioMixerBase() {}
+    virtual ~AudioMixerBase();
 
     virtual bool isValidFormat(audio_format_t format) const;
     virtual bool isValidChannelMask(audio_channel_mask_t channelMask) const;
@@ -133,6 +135,17 @@ public:
 
     size_t      getUnreleasedFrames(int name) const;
 
+    // Enable parallel mixing of tracks sharing a main buffer on workerCount worker
+    // threads, when at least trackThreshold tracks are enabled.  Below the threshold
+    // the mix is done on the calling thread as usual.
+    //
+    // \param workerCount    number of worker threads, 0 disables parallel mixing.
+    // \param trackThreshold minimum number of enabled tracks to mix in parallel,
+    //                       at least 2.
+    // \param cpuMask        if nonzero, worker i is pinned to the i-th cpu in the mask.
+    void        setParallelMixing(size_t workerCount, size_t trackThreshold,
+                        uint64_t cpuMask = 0);
+
     std::string trackNames() const;
 
   protected:
@@ -332,6 +345,12 @@ public:
     void process__genericNoResampling();
     void process__genericResampling();
     void process__oneTrack16BitsStereoNoResampling();
+    void process__parallelMixing();
+
+    // Mixes numFrames of track t into outTemp, in the mixer internal format.
+    void mixTrack(TrackBase *t, int32_t *outTemp, int32_t *resampleTemp, size_t numFrames);
+    // Mixes the tracks of mPartitions[partition] for process__parallelMixing.
+    void mixPartition(size_t partition);
 
     template <int MIXTYPE, typename TO, typename TI, typename TA>
     void process__noResampleOneTrack();
@@ -363,6 +382,16 @@ public:
 
     // track smart pointers, by name, in increasing order of name.
     std::map<int /* name */, std::shared_ptr<TrackBase>> mTracks;
+
+    // Parallel mixing, see setParallelMixing().
+    std::unique_ptr<MixerWorkerPool> mWorkerPool;
+    size_t mParallelTrackThreshold = 0;
+    // accumulation and resample temp buffers, indexed by partition - 1 (one per worker).
+    std::vector<std::unique_ptr<int32_t[]>> mWorkerOutputTemp;
+    std::vector<std::unique_ptr<int32_t[]>> mWorkerResampleTemp;
+    // tracks of the group being mixed, partition 0 is mixed on the calling thread.
+    std::vector<std::vector<TrackBase *>> mPartitions;
+    size_t mPartitionSampleCount = 0; // samples of the group being mixed.
 };
 
 }  // namespace android
@@ -78,6 +78,21 @@ public:
     // called to reset resampler buffers on record track discontinuity
     void reset();
 
+    // returns true if both converters produce the same output from the same input,
+    // given that their resampler state, if any, is the same.
+    bool isEquivalentTo(const RecordBufferConverter &other) const {
+        return initCheck() == NO_ERROR
+                && mSrcChannelMask == other.mSrcChannelMask
+                && mSrcFormat == other.mSrcFormat
+                && mSrcSampleRate == other.mSrcSampleRate
+                && mDstChannelMask == other.mDstChannelMask
+                && mDstFormat == other.mDstFormat
+                && mDstSampleRate == other.mDstSampleRate;
+    }
+
+    // returns true if the output only depends on the input of the current convert() call
+    bool isStateless() const { return mResampler == NULL; }
+
 private:
     // format conversion when not using resampler
     void convertNoResampler(void *dst, const void *src, size_t frames);
@@ -72,6 +72,34 @@ static void BM_VolumeMulti(benchmark::State& state) {
     }
 }
 
+// Compares the scalar volumeMulti with the vectorized volumeMultiAccelerated.
+// No aux buffer is used, as the vectorized variant falls back to scalar with aux.
+template <int MIXTYPE, int NCHAN, bool ACCELERATED>
+static void BM_VolumeMultiNoAux(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 1000;
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+
+    // data inialized to 0.
+    float out[SAMPLE_COUNT]{};
+    float in[SAMPLE_COUNT]{};
+    float *aux = nullptr;
+
+    // volume initialized to 0
+    float vola = 0.f;
+    float vol[2] = {0.f, 0.f};
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out);
+        benchmark::DoNotOptimize(in);
+        if constexpr (ACCELERATED) {
+            volumeMultiAccelerated<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, aux, vol, vola);
+        } else {
+            volumeMulti<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, aux, vol, vola);
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
 // MULTI mode and MULTI_SAVEONLY mode are not used by AudioMixer for channels > 2,
 // which is ensured by a static_assert (won't compile for those configurations).
 // So we benchmark MIXTYPE_MULTI_MONOVOL and MIXTYPE_MULTI_SAVEONLY_MONOVOL compared
@@ -101,4 +129,20 @@ BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
 
+// Scalar vs vectorized per channel mask: stereo, 7.1 and 7.1.4.
+BENCHMARK_TEMPLATE(BM_VolumeMultiNoAux, MIXTYPE_MULTI_STEREOVOL, 2, false);
+BENCHMARK_TEMPLATE(BM_VolumeMultiNoAux, MIXTYPE_MULTI_STEREOVOL, 2, true);
+BENCHMARK_TEMPLATE(BM_VolumeMultiNoAux, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 2, false);
+BENCHMARK_TEMPLATE(BM_VolumeMultiNoAux, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 2, true);
+
+BENCHMARK_TEMPLATE(BM_VolumeMultiNoAux, MIXTYPE_MULTI_STEREOVOL, 8, false);
+BENCHMARK_TEMPLATE(BM_VolumeMultiNoAux, MIXTYPE_MULTI_STEREOVOL, 8, true);
+BENCHMARK_TEMPLATE(BM_VolumeMultiNoAux, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8, false);
+BENCHMARK_TEMPLATE(BM_VolumeMultiNoAux, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8, true);
+
+BENCHMARK_TEMPLATE(BM_VolumeMultiNoAux, MIXTYPE_MULTI_STEREOVOL, 12, false);
+BENCHMARK_TEMPLATE(BM_VolumeMultiNoAux, MIXTYPE_MULTI_STEREOVOL, 12, true);
+BENCHMARK_TEMPLATE(BM_VolumeMultiNoAux, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 12, false);
+BENCHMARK_TEMPLATE(BM_VolumeMultiNoAux, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 12, true);
+
 BENCHMARK_MAIN();
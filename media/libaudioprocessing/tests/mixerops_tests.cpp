@@ -164,6 +164,46 @@ TEST(mixerops, stereovolume_24) {
         MixerOpsBasicTest<MIXTYPE_MULTI_STEREOVOL, 24>::testStereoVolume();
     }
 }
+// The vectorized volumeMulti must match the scalar volumeMulti.
+template <int MIXTYPE, int NCHAN>
+static void testAcceleratedEquivalence() {
+    constexpr size_t FRAME_COUNT = 1001; // odd, to exercise the stereo tail.
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+
+    float in[SAMPLE_COUNT];
+    float expected[SAMPLE_COUNT];
+    float actual[SAMPLE_COUNT];
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+        in[i] = (float)(i % 97) / 97.f - 0.5f;
+        expected[i] = actual[i] = (float)(i % 31) / 31.f - 0.5f;
+    }
+    const float vol[2] = {0.25f, 0.75f};
+    float *aux = nullptr;
+    volumeMulti<MIXTYPE, NCHAN>(expected, FRAME_COUNT, in, aux, vol, 0.f);
+    volumeMultiAccelerated<MIXTYPE, NCHAN>(actual, FRAME_COUNT, in, aux, vol, 0.f);
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+        EXPECT_FLOAT_EQ(expected[i], actual[i]) << "sample " << i;
+    }
+}
+
+TEST(mixerops, accelerated_2) {
+    testAcceleratedEquivalence<MIXTYPE_MULTI, 2>();
+    testAcceleratedEquivalence<MIXTYPE_MULTI_SAVEONLY, 2>();
+    testAcceleratedEquivalence<MIXTYPE_MULTI_STEREOVOL, 2>();
+    testAcceleratedEquivalence<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 2>();
+}
+TEST(mixerops, accelerated_8) {
+    testAcceleratedEquivalence<MIXTYPE_MULTI_MONOVOL, 8>();
+    testAcceleratedEquivalence<MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8>();
+    testAcceleratedEquivalence<MIXTYPE_MULTI_STEREOVOL, 8>();
+    testAcceleratedEquivalence<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8>();
+}
+TEST(mixerops, accelerated_12) {
+    if constexpr (FCC_LIMIT >= 12) {
+        testAcceleratedEquivalence<MIXTYPE_MULTI_STEREOVOL, 12>();
+        testAcceleratedEquivalence<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 12>();
+    }
+}
 TEST(mixerops, channel_equivalence) {
     // we must match the constexpr function with the system determined channel mask from count.
     for (size_t i = 0; i < FCC_LIMIT; ++i) {
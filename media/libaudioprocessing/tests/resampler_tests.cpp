@@ -28,6 +28,7 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <utility>
@@ -601,3 +602,37 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+// Resamplers with the same design share the filter bank, which is released
+// when the last resampler using it is destroyed.
+TEST(audioflinger_resampler, sharedfilterbank) {
+    using ResamplerType = android::AudioResamplerDyn<float, float, float>;
+    auto createResampler = [](size_t channels, int32_t inSampleRate, int32_t outSampleRate) {
+        std::unique_ptr<ResamplerType> rdyn(
+                static_cast<ResamplerType *>(
+                        android::AudioResampler::create(
+                                AUDIO_FORMAT_PCM_FLOAT,
+                                channels,
+                                outSampleRate,
+                                android::AudioResampler::DYN_HIGH_QUALITY)));
+        rdyn->setSampleRate(inSampleRate);
+        return rdyn;
+    };
+
+    auto r1 = createResampler(2 /* channels */, 44100, 48000);
+    auto r2 = createResampler(2 /* channels */, 44100, 48000);
+    auto r3 = createResampler(8 /* channels */, 44100, 48000);
+    auto r4 = createResampler(2 /* channels */, 32000, 48000);
+    EXPECT_EQ(r1->getFilterCoefs(), r2->getFilterCoefs());
+    EXPECT_EQ(r1->getFilterCoefs(), r3->getFilterCoefs()); // channel count independent
+    EXPECT_NE(r1->getFilterCoefs(), r4->getFilterCoefs());
+
+    // the filter bank remains valid for the remaining resampler.
+    const int phases = r2->getPhases();
+    const int halfLength = r2->getHalfLength();
+    std::vector<float> expected(r2->getFilterCoefs(),
+            r2->getFilterCoefs() + (phases + 1) * halfLength);
+    r1.reset();
+    r3.reset();
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), r2->getFilterCoefs()));
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "ThreadCpuAccounting"
+//#define LOG_NDEBUG 0
+
+#include <time.h>
+
+#include <utils/Log.h>
+
+#include <cpustats/ThreadCpuAccounting.h>
+
+namespace android {
+
+static int64_t readClockNs(clockid_t clock)
+{
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) {
+        return -1;
+    }
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+bool ThreadCpuAccounting::onCycle()
+{
+    const int64_t nowNs = readClockNs(CLOCK_MONOTONIC);
+    if (nowNs < 0) {
+        return false;
+    }
+    if (mStartWallNs == 0) {
+        const int64_t cpuNs = readClockNs(CLOCK_THREAD_CPUTIME_ID);
+        if (cpuNs < 0) {
+            ALOGW("clock_gettime(CLOCK_THREAD_CPUTIME_ID) failed");
+            return false;
+        }
+        mStartWallNs = nowNs;
+        mStartCpuNs = cpuNs;
+        mCycles = 0;
+        return false;
+    }
+    ++mCycles;
+    if (nowNs - mStartWallNs < mPeriodNs) {
+        return false;
+    }
+
+    const int64_t cpuNs = readClockNs(CLOCK_THREAD_CPUTIME_ID);
+    if (cpuNs < 0) {
+        return false;
+    }
+    mPeriodCpuNs = cpuNs - mStartCpuNs;
+    mPeriodWallNs = nowNs - mStartWallNs;
+    mPeriodCycles = mCycles;
+    mTotalCpuNs += mPeriodCpuNs;
+    ALOGV("period of %lld ns used %lld CPU ns in %lld cycles", (long long) mPeriodWallNs,
+            (long long) mPeriodCpuNs, (long long) mPeriodCycles);
+
+    mStartWallNs = nowNs;
+    mStartCpuNs = cpuNs;
+    mCycles = 0;
+    return true;
+}
+
+}   // namespace android
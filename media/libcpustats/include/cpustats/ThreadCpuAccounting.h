@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _THREAD_CPU_ACCOUNTING_H
+#define _THREAD_CPU_ACCOUNTING_H
+
+#include <stdint.h>
+
+namespace android {
+
+// Accounts the CPU time of a long running thread over fixed wall clock periods, so that the
+// CPU used by a media service can be attributed to the thread that used it.
+// Meant to be cheap enough to call on every loop iteration of any thread: onCycle() reads
+// the monotonic clock, and only reads the thread CPU clock once a period has elapsed.
+// Units are ns, as reported by clock_gettime(CLOCK_THREAD_CPUTIME_ID) and CLOCK_MONOTONIC.
+// The object may be constructed on any thread, but onCycle() may only be called by the
+// accounted thread, and the getters only by that thread or after it has exited.
+
+class ThreadCpuAccounting
+{
+
+public:
+    static constexpr int64_t kDefaultPeriodNs = 60'000'000'000; // 1 minute
+
+    explicit ThreadCpuAccounting(int64_t periodNs = kDefaultPeriodNs) :
+        mPeriodNs(periodNs) { }
+
+    // Call once per loop iteration of the accounted thread.  The first call starts the first
+    // period.  Returns true when a period has completed; its figures are then available from
+    // the getters below until the next period completes.
+    bool onCycle();
+
+    // CPU ns used by the thread during the last completed period.
+    int64_t getPeriodCpuNs() const      { return mPeriodCpuNs; }
+
+    // Wall clock ns of the last completed period, at least the configured period.
+    int64_t getPeriodWallNs() const     { return mPeriodWallNs; }
+
+    // Number of onCycle() calls during the last completed period.
+    int64_t getPeriodCycles() const     { return mPeriodCycles; }
+
+    // CPU use of the last completed period, in percent of one CPU.
+    double getPeriodLoadPercent() const {
+        return mPeriodWallNs > 0 ? 100. * mPeriodCpuNs / mPeriodWallNs : 0.;
+    }
+
+    // CPU ns used by the thread in all completed periods.
+    int64_t getTotalCpuNs() const       { return mTotalCpuNs; }
+
+private:
+    const int64_t mPeriodNs;
+
+    int64_t mStartWallNs = 0;       // start of the current period, 0 before the first cycle
+    int64_t mStartCpuNs = 0;        // thread CPU time at the start of the current period
+    int64_t mCycles = 0;            // onCycle() calls in the current period
+
+    int64_t mPeriodCpuNs = 0;
+    int64_t mPeriodWallNs = 0;
+    int64_t mPeriodCycles = 0;
+    int64_t mTotalCpuNs = 0;
+};
+
+}   // namespace android
+
+#endif //  _THREAD_CPU_ACCOUNTING_H
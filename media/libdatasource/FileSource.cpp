@@ -25,15 +25,26 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <errno.h>
 #include <fcntl.h>
 
 namespace android {
 
+// Reads starting at most this far past the end of the previous read count as
+// sequential, which keeps interleaved track reads from a container sequential.
+static const off64_t kMaxSequentialGap = 256 * 1024;
+// Number of sequential or random reads in a row before the advice changes.
+static const uint32_t kReadAdviceThreshold = 4;
+
 FileSource::FileSource(const char *filename)
     : mFd(-1),
       mOffset(0),
       mLength(-1),
-      mName("<null>") {
+      mName("<null>"),
+      mNextReadOffset(-1),
+      mSequentialReads(0),
+      mRandomReads(0),
+      mSequentialAdvice(false) {
 
     if (filename) {
         mName = String8::format("FileSource(%s)", filename);
@@ -52,7 +63,11 @@ FileSource::FileSource(int fd, int64_t offset, int64_t length)
     : mFd(fd),
       mOffset(offset),
       mLength(length),
-      mName("<null>") {
+      mName("<null>"),
+      mNextReadOffset(-1),
+      mSequentialReads(0),
+      mRandomReads(0),
+      mSequentialAdvice(false) {
     ALOGV("fd=%d (%s), offset=%lld, length=%lld",
             fd, nameForFd(fd).c_str(), (long long) offset, (long long) length);
 
@@ -122,13 +137,38 @@ ssize_t FileSource::readAt(off64_t offset, void *data, size_t size) {
 }
 
 ssize_t FileSource::readAt_l(off64_t offset, void *data, size_t size) {
-    off64_t result = lseek64(mFd, offset + mOffset, SEEK_SET);
-    if (result == -1) {
+    updateReadAdvice_l(offset, size);
+
+    // A single pread replaces the lseek and read pair.
+    ssize_t result = ::pread64(mFd, data, size, offset + mOffset);
+    if (result == -1 && (errno == ESPIPE || errno == EINVAL)) {
         ALOGE("seek to %lld failed", (long long)(offset + mOffset));
         return UNKNOWN_ERROR;
     }
 
-    return ::read(mFd, data, size);
+    return result;
+}
+
+// Tells the kernel to use a larger read-ahead window while the reads are
+// sequential, and to return to the default window once they turn random.
+void FileSource::updateReadAdvice_l(off64_t offset, size_t size) {
+    if (mNextReadOffset >= 0 && offset >= mNextReadOffset
+            && offset - mNextReadOffset <= kMaxSequentialGap) {
+        ++mSequentialReads;
+        mRandomReads = 0;
+    } else {
+        ++mRandomReads;
+        mSequentialReads = 0;
+    }
+    mNextReadOffset = offset + size;
+
+    if (!mSequentialAdvice && mSequentialReads >= kReadAdviceThreshold) {
+        mSequentialAdvice = true;
+        posix_fadvise(mFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    } else if (mSequentialAdvice && mRandomReads >= kReadAdviceThreshold) {
+        mSequentialAdvice = false;
+        posix_fadvise(mFd, 0, 0, POSIX_FADV_NORMAL);
+    }
 }
 
 status_t FileSource::getSize(off64_t *size) {
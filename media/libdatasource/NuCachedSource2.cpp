@@ -44,6 +44,7 @@ struct PageCache {
 
     void appendPage(Page *page);
     size_t releaseFromStart(size_t maxBytes);
+    size_t releaseFromEnd(size_t maxBytes);
 
     size_t totalSize() const {
         return mTotalSize;
@@ -136,6 +137,31 @@ size_t PageCache::releaseFromStart(size_t maxBytes) {
     return bytesReleased;
 }
 
+size_t PageCache::releaseFromEnd(size_t maxBytes) {
+    size_t bytesReleased = 0;
+
+    while (maxBytes > 0 && !mActivePages.empty()) {
+        List<Page *>::iterator it = mActivePages.end();
+        --it;
+
+        Page *page = *it;
+
+        if (maxBytes < page->mSize) {
+            break;
+        }
+
+        mActivePages.erase(it);
+
+        maxBytes -= page->mSize;
+        bytesReleased += page->mSize;
+
+        releasePage(page);
+    }
+
+    mTotalSize -= bytesReleased;
+    return bytesReleased;
+}
+
 void PageCache::copy(size_t from, void *data, size_t size) {
     ALOGV("copy from %zu size %zu", from, size);
 
@@ -188,6 +214,7 @@ NuCachedSource2::NuCachedSource2(
       mLooper(new ALooper),
       mCache(new PageCache(kPageSize)),
       mCacheOffset(0),
+      mRetainedBytes(0),
       mFinalStatus(OK),
       mLastAccessPos(0),
       mFetching(true),
@@ -234,6 +261,12 @@ NuCachedSource2::~NuCachedSource2() {
 
     delete mCache;
     mCache = NULL;
+
+    for (List<RetainedRange>::iterator it = mRetainedRanges.begin();
+            it != mRetainedRanges.end(); ++it) {
+        delete it->mCache;
+    }
+    mRetainedRanges.clear();
 }
 
 // static
@@ -537,6 +570,10 @@ ssize_t NuCachedSource2::readAt(off64_t offset, void *data, size_t size) {
         return size;
     }
 
+    if (readFromRetainedRanges_l(offset, data, size)) {
+        return size;
+    }
+
     sp<AMessage> msg = new AMessage(kWhatRead, mReflector);
     msg->setInt64("offset", offset);
     msg->setPointer("data", data);
@@ -613,6 +650,10 @@ ssize_t NuCachedSource2::readInternal(off64_t offset, void *data, size_t size) {
         return ERROR_END_OF_STREAM;
     }
 
+    if (readFromRetainedRanges_l(offset, data, size)) {
+        return size;
+    }
+
     if (!mFetching) {
         mLastAccessPos = offset;
         restartPrefetcherIfNecessary_l(
@@ -672,6 +713,8 @@ status_t NuCachedSource2::seekInternal_l(off64_t offset) {
 
     ALOGI("new range: offset= %lld", (long long)offset);
 
+    retainCache_l();
+
     mCacheOffset = offset;
 
     size_t totalSize = mCache->totalSize();
@@ -683,6 +726,52 @@ status_t NuCachedSource2::seekInternal_l(off64_t offset) {
     return OK;
 }
 
+void NuCachedSource2::retainCache_l() {
+    if (mCache->totalSize() == 0) {
+        return;
+    }
+
+    // Keep the start of the range, which is where the reads that caused the
+    // seek to it were made.
+    if (mCache->totalSize() > kMaxRetainedBytes) {
+        mCache->releaseFromEnd(mCache->totalSize() - kMaxRetainedBytes);
+    }
+
+    RetainedRange range;
+    range.mOffset = mCacheOffset;
+    range.mCache = mCache;
+    mRetainedRanges.push_front(range);
+    mRetainedBytes += mCache->totalSize();
+    mCache = new PageCache(kPageSize);
+
+    while (mRetainedRanges.size() > kMaxNumRetainedRanges
+            || mRetainedBytes > kMaxRetainedBytes) {
+        List<RetainedRange>::iterator it = mRetainedRanges.end();
+        --it;
+        mRetainedBytes -= it->mCache->totalSize();
+        delete it->mCache;
+        mRetainedRanges.erase(it);
+    }
+}
+
+bool NuCachedSource2::readFromRetainedRanges_l(off64_t offset, void *data, size_t size) {
+    for (List<RetainedRange>::iterator it = mRetainedRanges.begin();
+            it != mRetainedRanges.end(); ++it) {
+        if (offset >= it->mOffset
+                && offset + size <= it->mOffset + it->mCache->totalSize()) {
+            it->mCache->copy(offset - it->mOffset, data, size);
+
+            if (it != mRetainedRanges.begin()) {
+                RetainedRange range = *it;
+                mRetainedRanges.erase(it);
+                mRetainedRanges.push_front(range);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
 void NuCachedSource2::resumeFetchingIfNecessary() {
     Mutex::Autolock autoLock(mLock);
 
@@ -58,6 +58,14 @@ protected:
 private:
     String8 mName;
 
+    // Read-ahead hints given to the kernel, see updateReadAdvice_l().
+    off64_t mNextReadOffset;
+    uint32_t mSequentialReads;
+    uint32_t mRandomReads;
+    bool mSequentialAdvice;
+
+    void updateReadAdvice_l(off64_t offset, size_t size);
+
     FileSource(const FileSource &);
     FileSource &operator=(const FileSource &);
 };
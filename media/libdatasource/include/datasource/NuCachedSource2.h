@@ -19,6 +19,7 @@
 #define NU_CACHED_SOURCE_2_H_
 
 #include <media/DataSource.h>
+#include <utils/List.h>
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/foundation/AHandlerReflector.h>
 
@@ -91,6 +92,11 @@ private:
         // Read data after a 15 sec timeout whether we're actively
         // fetching or not.
         kDefaultKeepAliveIntervalUs     = 15000000,
+
+        // Up to this many bytes of the ranges cached before a seek are
+        // retained in up to kMaxNumRetainedRanges separate ranges.
+        kMaxRetainedBytes               = 4 * 1024 * 1024,
+        kMaxNumRetainedRanges           = 4,
     };
 
     enum {
@@ -113,6 +119,17 @@ private:
 
     PageCache *mCache;
     off64_t mCacheOffset;
+
+    // Ranges that were cached before seeking elsewhere, most recently used
+    // first, so that reads going back to them (e.g. to a moov at the end of
+    // the file) don't have to be fetched again.
+    struct RetainedRange {
+        off64_t mOffset;
+        PageCache *mCache;
+    };
+    List<RetainedRange> mRetainedRanges;
+    size_t mRetainedBytes;
+
     status_t mFinalStatus;
     off64_t mLastAccessPos;
     sp<AMessage> mAsyncResult;
@@ -137,6 +154,8 @@ private:
     void fetchInternal();
     ssize_t readInternal(off64_t offset, void *data, size_t size);
     status_t seekInternal_l(off64_t offset);
+    void retainCache_l();
+    bool readFromRetainedRanges_l(off64_t offset, void *data, size_t size);
 
     size_t approxDataRemaining_l(off64_t offset, status_t *finalStatus) const;
 
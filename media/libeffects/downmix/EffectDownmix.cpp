@@ -21,6 +21,14 @@
 #include "EffectDownmix.h"
 #include <audio_utils/ChannelMix.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DOWNMIX_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DOWNMIX_USE_SSE2 1
+#endif
+
 // Do not submit with DOWNMIX_TEST_CHANNEL_INDEX defined, strictly for testing
 //#define DOWNMIX_TEST_CHANNEL_INDEX 0
 // Do not submit with DOWNMIX_ALWAYS_USE_GENERIC_DOWNMIXER defined, strictly for testing
@@ -34,6 +42,14 @@ typedef enum {
     DOWNMIX_STATE_ACTIVE,
 } downmix_state_t;
 
+/* sparse fold matrix for the configured input channel mask, see Downmix_computeMatrix() */
+struct downmix_matrix_t {
+    bool valid;
+    size_t entries;                        // number of input channels with a nonzero gain
+    uint8_t channel[FCC_26];               // input channel index of each entry
+    alignas(16) float gains[FCC_26][4];    // {left, right, left, right} gains of each entry
+};
+
 /* parameters for each downmixer */
 struct downmix_object_t {
     downmix_state_t state;
@@ -41,6 +57,7 @@ struct downmix_object_t {
     bool apply_volume_correction;
     uint8_t input_channel_count;
     android::audio_utils::channels::ChannelMix channelMix;
+    downmix_matrix_t matrix;
 };
 
 typedef struct downmix_module_s {
@@ -183,6 +200,129 @@ void Downmix_testIndexComputation(uint32_t mask) {
 }
 #endif
 
+/*----------------------------------------------------------------------------
+ * Downmix_computeMatrix()
+ *----------------------------------------------------------------------------
+ * Purpose:
+ *  Build the sparse fold matrix for an input channel mask.
+ *  The gains are obtained by running ChannelMix on one unit impulse per input channel,
+ *  so the matrix folds exactly like ChannelMix does. Input channels that contribute to
+ *  neither output channel are left out of the matrix.
+ *
+ * Inputs:
+ *  pDownmixer   pointer to downmix context
+ *  mask         input channel mask
+ *
+ * Returns:
+ *  true if the matrix can be used for the mask
+ *----------------------------------------------------------------------------
+ */
+static bool Downmix_computeMatrix(downmix_object_t *pDownmixer, audio_channel_mask_t mask) {
+    downmix_matrix_t *pMatrix = &pDownmixer->matrix;
+    pMatrix->valid = false;
+    pMatrix->entries = 0;
+
+    const size_t channelCount = audio_channel_count_from_out_mask(mask);
+    if (channelCount == 0 || channelCount > FCC_26) {
+        return false;
+    }
+    // one frame per input channel, with a unit sample in that channel only
+    float impulses[FCC_26 * FCC_26]{};
+    float responses[FCC_26 * FCC_2];
+    for (size_t i = 0; i < channelCount; ++i) {
+        impulses[i * channelCount + i] = 1.f;
+    }
+    if (!pDownmixer->channelMix.process(
+            impulses, responses, channelCount, false /* accumulate */, mask)) {
+        return false;
+    }
+    for (size_t i = 0; i < channelCount; ++i) {
+        const float left = responses[i * FCC_2];
+        const float right = responses[i * FCC_2 + 1];
+        if (left == 0.f && right == 0.f) {
+            continue;
+        }
+        const size_t entry = pMatrix->entries++;
+        pMatrix->channel[entry] = i;
+        pMatrix->gains[entry][0] = left;
+        pMatrix->gains[entry][1] = right;
+        pMatrix->gains[entry][2] = left;
+        pMatrix->gains[entry][3] = right;
+    }
+    pMatrix->valid = true;
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+ * Downmix_foldMatrix()
+ *----------------------------------------------------------------------------
+ * Purpose:
+ *  Fold multichannel input to stereo with the sparse matrix from Downmix_computeMatrix().
+ *  Two frames are computed per vector, as {L0, R0, L1, R1} is exactly the layout
+ *  of two interleaved stereo output frames. The output is clamped to [-1, 1].
+ *
+ * Inputs:
+ *  pMatrix      fold matrix
+ *  pSrc         multichannel input
+ *  numFrames    number of frames to process
+ *  channelCount number of input channels
+ *  accumulate   true to add the result to the output instead of overwriting it
+ *
+ * Outputs:
+ *  pDst         stereo output
+ *----------------------------------------------------------------------------
+ */
+static void Downmix_foldMatrix(const downmix_matrix_t *pMatrix, const float *pSrc, float *pDst,
+        size_t numFrames, size_t channelCount, bool accumulate) {
+    const size_t entries = pMatrix->entries;
+#if DOWNMIX_USE_NEON
+    const float32x4_t vmin = vdupq_n_f32(-1.f);
+    const float32x4_t vmax = vdupq_n_f32(1.f);
+    for (; numFrames >= 2; numFrames -= 2) {
+        const float *pSrc1 = pSrc + channelCount;
+        float32x4_t acc = accumulate ? vld1q_f32(pDst) : vdupq_n_f32(0.f);
+        for (size_t k = 0; k < entries; ++k) {
+            const uint8_t channel = pMatrix->channel[k];
+            const float32x4_t samples =
+                    vcombine_f32(vdup_n_f32(pSrc[channel]), vdup_n_f32(pSrc1[channel]));
+            acc = vmlaq_f32(acc, samples, vld1q_f32(pMatrix->gains[k]));
+        }
+        vst1q_f32(pDst, vminq_f32(vmax, vmaxq_f32(vmin, acc)));
+        pSrc += 2 * channelCount;
+        pDst += 2 * FCC_2;
+    }
+#elif DOWNMIX_USE_SSE2
+    const __m128 vmin = _mm_set1_ps(-1.f);
+    const __m128 vmax = _mm_set1_ps(1.f);
+    for (; numFrames >= 2; numFrames -= 2) {
+        const float *pSrc1 = pSrc + channelCount;
+        __m128 acc = accumulate ? _mm_loadu_ps(pDst) : _mm_setzero_ps();
+        for (size_t k = 0; k < entries; ++k) {
+            const uint8_t channel = pMatrix->channel[k];
+            const __m128 samples =
+                    _mm_set_ps(pSrc1[channel], pSrc1[channel], pSrc[channel], pSrc[channel]);
+            acc = _mm_add_ps(acc, _mm_mul_ps(samples, _mm_load_ps(pMatrix->gains[k])));
+        }
+        _mm_storeu_ps(pDst, _mm_min_ps(vmax, _mm_max_ps(vmin, acc)));
+        pSrc += 2 * channelCount;
+        pDst += 2 * FCC_2;
+    }
+#endif
+    for (; numFrames > 0; --numFrames) {
+        float left = accumulate ? pDst[0] : 0.f;
+        float right = accumulate ? pDst[1] : 0.f;
+        for (size_t k = 0; k < entries; ++k) {
+            const float sample = pSrc[pMatrix->channel[k]];
+            left += sample * pMatrix->gains[k][0];
+            right += sample * pMatrix->gains[k][1];
+        }
+        pDst[0] = clamp_float(left);
+        pDst[1] = clamp_float(right);
+        pSrc += channelCount;
+        pDst += FCC_2;
+    }
+}
+
 static bool Downmix_validChannelMask(uint32_t mask)
 {
     if (!mask) {
@@ -369,7 +509,10 @@ static int32_t Downmix_Process(effect_handle_t self,
           break;
 
       case DOWNMIX_TYPE_FOLD: {
-            if (!pDownmixer->channelMix.process(
+            if (pDownmixer->matrix.valid) {
+                Downmix_foldMatrix(&pDownmixer->matrix, pSrc, pDst, numFrames,
+                        pDownmixer->input_channel_count, accumulate);
+            } else if (!pDownmixer->channelMix.process(
                     pSrc, pDst, numFrames, accumulate, downmixInputChannelMask)) {
                 ALOGE("Multichannel configuration %#x is not supported",
                       downmixInputChannelMask);
@@ -669,6 +812,12 @@ static int Downmix_Configure(downmix_module_t *pDwmModule, effect_config_t *pCon
                 audio_channel_count_from_out_mask(pConfig->inputCfg.channels);
     }
 
+    if (!Downmix_computeMatrix(
+            pDownmixer, (audio_channel_mask_t)pConfig->inputCfg.channels)) {
+        ALOGW("Downmix_Configure: no fold matrix for channel mask %#x",
+                pConfig->inputCfg.channels);
+    }
+
     Downmix_Reset(pDownmixer, init);
 
     return 0;
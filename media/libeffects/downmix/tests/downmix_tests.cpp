@@ -14,10 +14,12 @@
  * limitations under the License.
  */
 
+#include <random>
 #include <vector>
 
 #include "EffectDownmix.h"
 
+#include <audio_utils/ChannelMix.h>
 #include <audio_utils/channels.h>
 #include <audio_utils/primitives.h>
 #include <audio_utils/Statistics.h>
@@ -229,6 +231,33 @@ public:
         }
     }
 
+    // The effect folds with a precomputed matrix, check it against ChannelMix directly.
+    void testMatchesChannelMix(int sampleRate, audio_channel_mask_t channelMask) {
+        constexpr size_t frames = 301; // odd, to exercise the scalar tail.
+        constexpr unsigned outChannels = 2;
+        const unsigned inChannels = audio_channel_count_from_out_mask(channelMask);
+        std::vector<float> input(frames * inChannels);
+        std::vector<float> output(frames * outChannels);
+        std::vector<float> expected(frames * outChannels);
+
+        std::minstd_rand gen(channelMask);
+        std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+        for (auto& in : input) {
+            in = dis(gen);
+        }
+        run(sampleRate, channelMask, input, output, frames);
+
+        android::audio_utils::channels::ChannelMix channelMix;
+        ASSERT_TRUE(channelMix.process(
+                input.data(), expected.data(), frames, false /* accumulate */, channelMask));
+
+        // Only the order of summation differs.
+        const float tolerance = inChannels * std::numeric_limits<float>::epsilon() * 4;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_NEAR(expected[i], output[i], tolerance) << "sample " << i;
+        }
+    }
+
     void run(int sampleRate, audio_channel_mask_t channelMask,
             std::vector<float>& input, std::vector<float>& output, size_t frames) {
         reconfig(sampleRate, channelMask);
@@ -342,6 +371,11 @@ TEST_P(DownmixTest, basic) {
             kChannelPositionMasks[std::get<1>(GetParam())]);
 }
 
+TEST_P(DownmixTest, matchesChannelMix) {
+    testMatchesChannelMix(kSampleRates[std::get<0>(GetParam())],
+            kChannelPositionMasks[std::get<1>(GetParam())]);
+}
+
 INSTANTIATE_TEST_SUITE_P(
         DownmixTestAll, DownmixTest,
         ::testing::Combine(
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include <string.h>
+
+#include <audio_effects/effect_dynamicsprocessing.h>
+#include <benchmark/benchmark.h>
+#include <hardware/audio_effect.h>
+#include <log/log.h>
+#include <system/audio.h>
+
+extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
+
+static constexpr audio_channel_mask_t kChannelPositionMasks[] = {
+    AUDIO_CHANNEL_OUT_MONO,
+    AUDIO_CHANNEL_OUT_STEREO,
+    AUDIO_CHANNEL_OUT_5POINT1,
+    AUDIO_CHANNEL_OUT_7POINT1,
+};
+
+static constexpr effect_uuid_t dynamicsprocessing_uuid = {
+    0xe0e6539b, 0x1781, 0x7261, 0x676f, {0x6d, 0x75, 0x73, 0x69, 0x63, 0x40}};
+
+static constexpr size_t kFrameCount = 960;
+static constexpr float kPreferredFrameDurationMs = 10.0f;
+static constexpr int32_t kEqBandCount = 6;
+static constexpr int32_t kMbcBandCount = 3;
+// Band cutoff frequencies, the last band covers the rest of the spectrum.
+static constexpr float kEqCutoffsHz[kEqBandCount] = {100, 300, 1000, 3000, 10000, 24000};
+static constexpr float kMbcCutoffsHz[kMbcBandCount] = {250, 4000, 24000};
+
+/*
+$ adb shell /data/benchmarktest/dynamicsprocessing_benchmark/vendor/dynamicsprocessing_benchmark
+
+BM_DynamicsProcessing/<channel mask index>, with the pre EQ, MBC, post EQ and limiter stages
+in use and enabled on every channel.
+*/
+
+// The parameters and values of a DynamicsProcessing parameter are 32 bit integers or floats.
+union value_t {
+    int32_t i;
+    float f;
+};
+
+static int setParameter(effect_handle_t effectHandle, const std::vector<int32_t>& params,
+                        const std::vector<value_t>& values) {
+    const uint32_t psize = params.size() * sizeof(int32_t);
+    const uint32_t vsize = values.size() * sizeof(value_t);
+    std::vector<uint8_t> cmd(sizeof(effect_param_t) + psize + vsize);
+    effect_param_t* effectParam = reinterpret_cast<effect_param_t*>(cmd.data());
+    effectParam->psize = psize;
+    effectParam->vsize = vsize;
+    memcpy(effectParam->data, params.data(), psize);
+    memcpy(effectParam->data + psize, values.data(), vsize);
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (int status = (*effectHandle)
+            ->command(effectHandle, EFFECT_CMD_SET_PARAM, cmd.size(), cmd.data(),
+                    &replySize, &reply);
+        status != 0) {
+        return status;
+    }
+    return reply;
+}
+
+static int setAllStages(effect_handle_t effectHandle, int32_t channelCount) {
+    int status = setParameter(effectHandle, {DP_PARAM_ENGINE_ARCHITECTURE},
+            {{.i = VARIANT_FAVOR_FREQUENCY_RESOLUTION}, {.f = kPreferredFrameDurationMs},
+             {.i = 1}, {.i = kEqBandCount}, {.i = 1}, {.i = kMbcBandCount},
+             {.i = 1}, {.i = kEqBandCount}, {.i = 1}});
+    for (int32_t ch = 0; ch < channelCount && status == 0; ch++) {
+        for (int32_t eq : {DP_PARAM_PRE_EQ, DP_PARAM_POST_EQ}) {
+            status = setParameter(effectHandle, {eq, ch},
+                    {{.i = 1}, {.i = 1}, {.i = kEqBandCount}});
+            for (int32_t band = 0; band < kEqBandCount && status == 0; band++) {
+                status = setParameter(effectHandle,
+                        {eq == DP_PARAM_PRE_EQ ? DP_PARAM_PRE_EQ_BAND : DP_PARAM_POST_EQ_BAND,
+                         ch, band},
+                        {{.i = 1}, {.f = kEqCutoffsHz[band]}, {.f = (band % 3) - 1.0f}});
+            }
+            if (status != 0) return status;
+        }
+        status = setParameter(effectHandle, {DP_PARAM_MBC, ch},
+                {{.i = 1}, {.i = 1}, {.i = kMbcBandCount}});
+        for (int32_t band = 0; band < kMbcBandCount && status == 0; band++) {
+            // enabled, cutoff, attack, release, ratio, threshold, knee width,
+            // noise gate threshold, expander ratio, pre gain, post gain
+            status = setParameter(effectHandle, {DP_PARAM_MBC_BAND, ch, band},
+                    {{.i = 1}, {.f = kMbcCutoffsHz[band]}, {.f = 3}, {.f = 80}, {.f = 2},
+                     {.f = -30}, {.f = 6}, {.f = -80}, {.f = 1}, {.f = 0}, {.f = 0}});
+        }
+        if (status != 0) return status;
+        // in use, enabled, link group, attack, release, ratio, threshold, post gain
+        status = setParameter(effectHandle, {DP_PARAM_LIMITER, ch},
+                {{.i = 1}, {.i = 1}, {.i = 0}, {.f = 1}, {.f = 60}, {.f = 10}, {.f = -2},
+                 {.f = 0}});
+    }
+    return status;
+}
+
+static void BM_DynamicsProcessing(benchmark::State& state) {
+    const audio_channel_mask_t channelMask = kChannelPositionMasks[state.range(0)];
+    const size_t channelCount = audio_channel_count_from_out_mask(channelMask);
+    const int sampleRate = 48000;
+
+    // Initialize input buffer with deterministic pseudo-random values
+    std::minstd_rand gen(channelMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFrameCount * channelCount);
+    std::vector<float> output(kFrameCount * channelCount);
+    for (auto& in : input) {
+        in = dis(gen);
+    }
+    effect_handle_t effectHandle = nullptr;
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(
+            &dynamicsprocessing_uuid, 1, 1, &effectHandle);
+        status != 0) {
+        ALOGE("create_effect returned an error = %d\n", status);
+        return;
+    }
+
+    effect_config_t config{};
+    config.inputCfg.accessMode = EFFECT_BUFFER_ACCESS_READ;
+    config.inputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+    config.inputCfg.bufferProvider.getBuffer = nullptr;
+    config.inputCfg.bufferProvider.releaseBuffer = nullptr;
+    config.inputCfg.bufferProvider.cookie = nullptr;
+    config.inputCfg.mask = EFFECT_CONFIG_ALL;
+
+    config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_WRITE;
+    config.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+    config.outputCfg.bufferProvider.getBuffer = nullptr;
+    config.outputCfg.bufferProvider.releaseBuffer = nullptr;
+    config.outputCfg.bufferProvider.cookie = nullptr;
+    config.outputCfg.mask = EFFECT_CONFIG_ALL;
+
+    config.inputCfg.samplingRate = sampleRate;
+    config.inputCfg.channels = channelMask;
+
+    config.outputCfg.samplingRate = sampleRate;
+    config.outputCfg.channels = channelMask;
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (int status = (*effectHandle)
+            ->command(effectHandle, EFFECT_CMD_SET_CONFIG, sizeof(effect_config_t),
+                    &config, &replySize, &reply);
+        status != 0) {
+        ALOGE("command returned an error = %d\n", status);
+        return;
+    }
+
+    if (int status = setAllStages(effectHandle, channelCount); status != 0) {
+        ALOGE("setting the processing stages returned an error = %d\n", status);
+        return;
+    }
+
+    if (int status = (*effectHandle)
+            ->command(effectHandle, EFFECT_CMD_ENABLE, 0, nullptr, &replySize, &reply);
+        status != 0) {
+        ALOGE("Command enable call returned error %d\n", reply);
+        return;
+    }
+
+    // Run the test
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+
+        audio_buffer_t inBuffer = {.frameCount = kFrameCount, .f32 = input.data()};
+        audio_buffer_t outBuffer = {.frameCount = kFrameCount, .f32 = output.data()};
+        (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetComplexityN(channelCount);
+    state.SetLabel(audio_channel_out_mask_to_string(channelMask));
+
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
+        ALOGE("release_effect returned an error = %d\n", status);
+        return;
+    }
+}
+
+static void DynamicsProcessingArgs(benchmark::internal::Benchmark* b) {
+    for (int i = 0; i < (int)std::size(kChannelPositionMasks); i++) {
+        b->Args({i});
+    }
+}
+
+BENCHMARK(BM_DynamicsProcessing)->Apply(DynamicsProcessingArgs);
+
+BENCHMARK_MAIN();
@@ -164,6 +164,7 @@ void DPFrequency::configure(size_t blockSize, size_t overlapSize,
     mBlocksPerSecond = (float)mSamplingRate / (mBlockSize - mOverlapSize);
 
     fill_window(mVWindow, RDSP_WINDOW_HANNING_FLAT_TOP, mBlockSize, mOverlapSize);
+    mWindowedInput.resize(mBlockSize);
 
     //split window into analysis and synthesis. Both are the sqrt() of original
     //window
@@ -386,10 +387,9 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
        }
 
        //**separate into channels
-       for (size_t k = 0; k < samples; k += channelCount) {
-           for (int ch = 0; ch < channelCount; ch++) {
-               mChannelBuffers[ch].cBInput.write(*pIn++);
-           }
+       const size_t frames = samples / channelCount;
+       for (int ch = 0; ch < channelCount; ch++) {
+           mChannelBuffers[ch].cBInput.write(pIn + ch, frames, channelCount);
        }
 
        //**process all channelBuffers
@@ -413,10 +413,8 @@ size_t DPFrequency::processSamples(const float *in, float *out, size_t samples)
        }
 
        //**interleave channels
-       for (size_t k = 0; k < available; k++) {
-           for (int ch = 0; ch < channelCount; ch++) {
-               *pOut++ = mChannelBuffers[ch].cBOutput.read();
-           }
+       for (int ch = 0; ch < channelCount; ch++) {
+           mChannelBuffers[ch].cBOutput.read(pOut + ch, available, channelCount);
        }
 
        return samples;
@@ -442,9 +440,7 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
                     pCb->input.begin());
 
             //read new available data
-            for (unsigned int k = 0; k < processFrames; k++) {
-                pCb->input[mOverlapSize + k] = pCb->cBInput.read();
-            }
+            pCb->cBInput.read(&pCb->input[mOverlapSize], processFrames);
             //first stages: fft, preEq, mbc, postEq and start of Limiter
             processedSamples += processFirstStages(*pCb);
         }
@@ -466,9 +462,7 @@ size_t DPFrequency::processChannelBuffers(CBufferVector &channelBuffers) {
             }
 
             //output data
-            for (unsigned int k = 0; k < processFrames; k++) {
-                pCb->cBOutput.write(pCb->output[k]);
-            }
+            pCb->cBOutput.write(&pCb->output[0], processFrames);
         }
         available -= processFrames;
     }
@@ -480,35 +474,36 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
     Eigen::Map<Eigen::VectorXf> eWindow(&mVWindow[0], mVWindow.size());
     Eigen::Map<Eigen::VectorXf> eInput(&cb.input[0], cb.input.size());
 
-    Eigen::VectorXf eWin = eInput.cwiseProduct(eWindow); //apply window
+    mWindowedInput = eInput.cwiseProduct(eWindow); //apply window
 
     //##fft
     //Note: we are using eigen with the default scaling, which ensures that
     //  IFFT( FFT(x) ) = x.
     // TODO: optimize by using the noscale option, and compensate with dB scale offsets
-    mFftServer.fwd(cb.complexTemp, eWin);
+    mFftServer.fwd(cb.complexTemp, mWindowedInput);
 
     size_t cSize = cb.complexTemp.size();
     size_t maxBin = std::min(cSize/2, mHalfFFTSize);
 
+    // The per bin stages below use Eigen array expressions so that they are vectorized.
+    auto spectrum = cb.complexTemp.head(maxBin).array();
+
     //== EqPre (always runs)
-    for (size_t k = 0; k < maxBin; k++) {
-        cb.complexTemp[k] *= cb.mPreEqFactorVector[k];
-    }
+    spectrum *= Eigen::Map<Eigen::ArrayXf>(&cb.mPreEqFactorVector[0], maxBin);
 
     //== MBC
     if (cb.mMbcInUse && cb.mMbcEnabled) {
         for (size_t band = 0; band < cb.mMbcBands.size(); band++) {
             ChannelBuffer::MbcBandParams *pMbcBandParams = &cb.mMbcBands[band];
-            float fEnergySum = 0;
+            const size_t binCount = getBandBinCount(*pMbcBandParams, cSize);
+            auto bandBins = cb.complexTemp.segment(
+                    std::min(pMbcBandParams->binStart, cSize), binCount);
 
             //apply pre gain.
             float preGainFactor = dBtoLinear(pMbcBandParams->gainPreDb);
             float preGainSquared = preGainFactor * preGainFactor;
 
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                fEnergySum += std::norm(cb.complexTemp[k]) * preGainSquared; //mag squared
-            }
+            float fEnergySum = bandBins.squaredNorm() * preGainSquared; //mag squared
 
             //Eigen FFT is full spectrum, even if the source was real data.
             // Each half spectrum has half the energy. This is taken into account with the * 2
@@ -567,9 +562,7 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
             newFactor *= dBtoLinear(pMbcBandParams->gainPostDb);
 
             //apply to this band
-            for (size_t k = pMbcBandParams->binStart; k <= pMbcBandParams->binStop; k++) {
-                cb.complexTemp[k] *= newFactor;
-            }
+            bandBins *= newFactor;
 
         } //end per band process
 
@@ -577,17 +570,12 @@ size_t DPFrequency::processFirstStages(ChannelBuffer &cb) {
 
     //== EqPost
     if (cb.mPostEqInUse && cb.mPostEqEnabled) {
-        for (size_t k = 0; k < maxBin; k++) {
-            cb.complexTemp[k] *= cb.mPostEqFactorVector[k];
-        }
+        spectrum *= Eigen::Map<Eigen::ArrayXf>(&cb.mPostEqFactorVector[0], maxBin);
     }
 
     //== Limiter. First Pass
     if (cb.mLimiterInUse && cb.mLimiterEnabled) {
-        float fEnergySum = 0;
-        for (size_t k = 0; k < maxBin; k++) {
-            fEnergySum += std::norm(cb.complexTemp[k]);
-        }
+        float fEnergySum = cb.complexTemp.head(maxBin).squaredNorm();
 
         //see explanation above for energy computation logic
         fEnergySum = sqrt(fEnergySum * 2) / (mBlockSize * mWindowRms);
@@ -658,9 +646,7 @@ size_t DPFrequency::processLastStages(ChannelBuffer &cb) {
     if (!compareEquality(outputGainFactor, 1.0f)) {
         size_t cSize = cb.complexTemp.size();
         size_t maxBin = std::min(cSize/2, mHalfFFTSize);
-        for (size_t k = 0; k < maxBin; k++) {
-            cb.complexTemp[k] *= outputGainFactor;
-        }
+        cb.complexTemp.head(maxBin) *= outputGainFactor;
     }
 
     //##ifft directly to output.
@@ -669,9 +655,17 @@ size_t DPFrequency::processLastStages(ChannelBuffer &cb) {
 
     //apply rest of window for resynthesis
     Eigen::Map<Eigen::VectorXf> eWindow(&mVWindow[0], mVWindow.size());
-    eOutput = eOutput.cwiseProduct(eWindow);
+    eOutput.array() *= eWindow.array();
 
     return mBlockSize;
 }
 
+size_t DPFrequency::getBandBinCount(const ChannelBuffer::BandParams &bp, size_t binCount) {
+    //bands whose cutoff is below the previous band's cutoff have no bins.
+    if (bp.binStart >= binCount || bp.binStop < bp.binStart) {
+        return 0;
+    }
+    return std::min(bp.binStop, binCount - 1) - bp.binStart + 1;
+}
+
 } //namespace dp_fx
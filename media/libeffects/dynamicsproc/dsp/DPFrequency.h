@@ -137,6 +137,7 @@ private:
     size_t processFirstStages(ChannelBuffer &cb);
     size_t processLastStages(ChannelBuffer &cb);
     void processLinkedLimiters(CBufferVector &channelBuffers);
+    static size_t getBandBinCount(const ChannelBuffer::BandParams &bp, size_t binCount);
 
     size_t mBlockSize;
     size_t mHalfFFTSize;
@@ -151,6 +152,7 @@ private:
 
     //dsp
     FloatVec mVWindow;  //window class.
+    Eigen::VectorXf mWindowedInput; //temp vector for the windowed input of one channel
     float mWindowRms;
     Eigen::FFT<float> mFftServer;
 };
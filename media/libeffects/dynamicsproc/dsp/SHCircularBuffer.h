@@ -18,6 +18,7 @@
 #define SHCIRCULARBUFFER_H
 
 #include <log/log.h>
+#include <algorithm>
 #include <vector>
 
 template <class T>
@@ -60,6 +61,42 @@ public:
         }
         return value;
     }
+    // Write count values, taking one every stride elements of values.
+    // The values are copied in at most two contiguous runs instead of one call per value.
+    inline void write(const T *values, size_t count, size_t stride = 1) {
+        if (count > availableToWrite()) {
+            ALOGE("Error: SHCircularBuffer no space to write %zu values. allocated size %zu ",
+                    count, getSize());
+            count = availableToWrite();
+        }
+        if (count == 0) {
+            return;
+        }
+        const size_t first = std::min(count, getSize() - mWriteIndex);
+        copy(mBuffer.data() + mWriteIndex, 1, values, stride, first);
+        copy(mBuffer.data(), 1, values + first * stride, stride, count - first);
+        mWriteIndex = (mWriteIndex + count) % getSize();
+        mReadAvailable += count;
+    }
+    // Read count values, storing one every stride elements of values.
+    // Values that are not available are returned as the default value.
+    inline void read(T *values, size_t count, size_t stride = 1) {
+        size_t readCount = count;
+        if (readCount > availableToRead()) {
+            ALOGW("Warning: SHCircularBuffer no data available to read. Default value returned");
+            readCount = availableToRead();
+        }
+        const size_t first = std::min(readCount, getSize() - mReadIndex);
+        copy(values, stride, mBuffer.data() + mReadIndex, 1, first);
+        copy(values + first * stride, stride, mBuffer.data(), 1, readCount - first);
+        for (size_t i = readCount; i < count; i++) {
+            values[i * stride] = T();
+        }
+        if (readCount > 0) {
+            mReadIndex = (mReadIndex + readCount) % getSize();
+        }
+        mReadAvailable -= readCount;
+    }
     inline size_t availableToRead() const {
         return mReadAvailable;
     }
@@ -71,6 +108,17 @@ public:
     }
 
 private:
+    static inline void copy(T *dst, size_t dstStride, const T *src, size_t srcStride,
+            size_t count) {
+        if (dstStride == 1 && srcStride == 1) {
+            std::copy(src, src + count, dst);
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            dst[i * dstStride] = src[i * srcStride];
+        }
+    }
+
     std::vector<T> mBuffer;
     size_t mReadIndex;
     size_t mWriteIndex;
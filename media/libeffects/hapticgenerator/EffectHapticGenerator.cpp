@@ -117,6 +117,7 @@ int HapticGenerator_Init(struct HapticGeneratorContext *context) {
     memset(context->param.hapticChannelSource, 0, sizeof(context->param.hapticChannelSource));
     context->param.hapticChannelCount = 0;
     context->param.audioChannelCount = 0;
+    context->param.processingChannelCount = 0;
     context->param.maxHapticIntensity = os::HapticScale::MUTE;
 
     context->param.resonantFrequency = DEFAULT_RESONANT_FREQUENCY;
@@ -154,13 +155,13 @@ void addBiquadFilter(
  * \param processingChain
  * \param processorsRecord a structure to cache all the shared pointers for processors
  * \param sampleRate the audio sampling rate. Use a float here as it may be used to create filters
- * \param channelCount haptic channel count
+ * \param param the processing chain is built for param->processingChannelCount channels
  */
 void HapticGenerator_buildProcessingChain(
         std::vector<std::function<void(float*, const float*, size_t)>>& processingChain,
         struct HapticGeneratorProcessorsRecord& processorsRecord, float sampleRate,
         const struct HapticGeneratorParam* param) {
-    const size_t channelCount = param->hapticChannelCount;
+    const size_t channelCount = param->processingChannelCount;
     float highPassCornerFrequency = 50.0f;
     auto hpf = createHPF2(highPassCornerFrequency, sampleRate, channelCount);
     addBiquadFilter(processingChain, processorsRecord, hpf);
@@ -256,6 +257,17 @@ int HapticGenerator_Configure(struct HapticGeneratorContext *context, effect_con
             // By default, use the first audio channel to generate haptic channels.
             context->param.hapticChannelSource[i] = 0;
         }
+        // Haptic channels generated from the same audio channel would run identical
+        // processing on identical input, so only process that audio channel once.
+        context->param.processingChannelCount =
+                std::all_of(context->param.hapticChannelSource,
+                            context->param.hapticChannelSource
+                                    + context->param.hapticChannelCount,
+                            [&](uint32_t source) {
+                                return source == context->param.hapticChannelSource[0];
+                            })
+                ? std::min(context->param.hapticChannelCount, 1u)
+                : context->param.hapticChannelCount;
 
         HapticGenerator_buildProcessingChain(context->processingChain,
                                              context->processorsRecord,
@@ -454,9 +466,10 @@ int32_t HapticGenerator_Process(effect_handle_t self,
     }
 
     // Construct input buffer according to haptic channel source
+    const size_t processingChannelCount = context->param.processingChannelCount;
     for (size_t i = 0; i < inBuffer->frameCount; ++i) {
-        for (size_t j = 0; j < context->param.hapticChannelCount; ++j) {
-            context->inputBuffer[i * context->param.hapticChannelCount + j] =
+        for (size_t j = 0; j < processingChannelCount; ++j) {
+            context->inputBuffer[i * processingChannelCount + j] =
                     inBuffer->f32[i * context->param.audioChannelCount
                             + context->param.hapticChannelSource[j]];
         }
@@ -465,8 +478,21 @@ int32_t HapticGenerator_Process(effect_handle_t self,
     float* hapticOutBuffer = HapticGenerator_runProcessingChain(
             context->processingChain, context->inputBuffer.data(),
             context->outputBuffer.data(), inBuffer->frameCount);
-    os::scaleHapticData(hapticOutBuffer, hapticSampleCount, context->param.maxHapticIntensity,
-                        context->param.maxHapticAmplitude);
+    os::scaleHapticData(hapticOutBuffer, inBuffer->frameCount * processingChannelCount,
+                        context->param.maxHapticIntensity, context->param.maxHapticAmplitude);
+
+    if (processingChannelCount < context->param.hapticChannelCount) {
+        // All haptic channels share the processed channel, copy it to each of them
+        // using the buffer that does not hold the processed data.
+        float* hapticData = hapticOutBuffer == context->inputBuffer.data()
+                ? context->outputBuffer.data() : context->inputBuffer.data();
+        for (size_t i = 0; i < inBuffer->frameCount; ++i) {
+            for (size_t j = 0; j < context->param.hapticChannelCount; ++j) {
+                hapticData[i * context->param.hapticChannelCount + j] = hapticOutBuffer[i];
+            }
+        }
+        hapticOutBuffer = hapticData;
+    }
 
     // For haptic data, the haptic playback thread will copy the data from effect input buffer,
     // which contains haptic data at the end of the buffer, directly to sink buffer.
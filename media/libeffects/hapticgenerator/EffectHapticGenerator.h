@@ -47,6 +47,10 @@ struct HapticGeneratorParam {
                                      // The value will be offset of audio channel
     uint32_t audioChannelCount;
     uint32_t hapticChannelCount;
+    uint32_t processingChannelCount; // Channels run through the processing chain. When all the
+                                     // haptic channels use the same audio channel as source,
+                                     // the haptic data is generated once and copied to each
+                                     // haptic channel.
 
     // A map from track id to haptic intensity.
     std::map<int, os::HapticScale> id2Intensity;
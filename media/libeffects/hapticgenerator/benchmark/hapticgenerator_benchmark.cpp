@@ -0,0 +1,188 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <string.h>
+
+#include <audio_effects/effect_hapticgenerator.h>
+#include <benchmark/benchmark.h>
+#include <log/log.h>
+#include <system/audio.h>
+#include <vibrator/ExternalVibrationUtils.h>
+
+#include "EffectHapticGenerator.h"
+
+extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
+
+static constexpr audio_channel_mask_t kAudioChannelMasks[] = {
+    AUDIO_CHANNEL_OUT_MONO,
+    AUDIO_CHANNEL_OUT_STEREO,
+    AUDIO_CHANNEL_OUT_5POINT1,
+};
+
+static constexpr audio_channel_mask_t kHapticChannelMasks[] = {
+    AUDIO_CHANNEL_OUT_HAPTIC_A,
+    audio_channel_mask_t(AUDIO_CHANNEL_OUT_HAPTIC_A | AUDIO_CHANNEL_OUT_HAPTIC_B),
+};
+
+static constexpr effect_uuid_t hapticgenerator_uuid = {
+    0x97c4acd1, 0x8b82, 0x4f2f, 0x832e, {0xc2, 0xfe, 0x5d, 0x7a, 0x99, 0x31}};
+
+static constexpr size_t kFrameCount = 1000;
+
+/*
+$ adb shell /data/benchmarktest/hapticgenerator_benchmark/vendor/hapticgenerator_benchmark
+
+BM_HapticGenerator/<audio mask index>/<haptic mask index>
+*/
+
+static int setParameter(effect_handle_t effectHandle, int32_t param,
+                        const void* value, uint32_t valueSize) {
+    std::vector<uint8_t> cmd(sizeof(effect_param_t) + sizeof(param) + valueSize);
+    effect_param_t* effectParam = reinterpret_cast<effect_param_t*>(cmd.data());
+    effectParam->psize = sizeof(param);
+    effectParam->vsize = valueSize;
+    memcpy(effectParam->data, &param, sizeof(param));
+    memcpy(effectParam->data + sizeof(param), value, valueSize);
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (int status = (*effectHandle)
+            ->command(effectHandle, EFFECT_CMD_SET_PARAM, cmd.size(), cmd.data(),
+                    &replySize, &reply);
+        status != 0) {
+        return status;
+    }
+    return reply;
+}
+
+static void BM_HapticGenerator(benchmark::State& state) {
+    const audio_channel_mask_t audioChannelMask = kAudioChannelMasks[state.range(0)];
+    const audio_channel_mask_t hapticChannelMask = kHapticChannelMasks[state.range(1)];
+    const audio_channel_mask_t channelMask =
+            audio_channel_mask_t(audioChannelMask | hapticChannelMask);
+    const size_t audioChannelCount = audio_channel_count_from_out_mask(audioChannelMask);
+    const size_t hapticChannelCount = audio_channel_count_from_out_mask(hapticChannelMask);
+    const int sampleRate = 48000;
+
+    // Initialize input buffer with deterministic pseudo-random values.
+    // The haptic data is written after the audio data, so leave room for it.
+    std::minstd_rand gen(channelMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<float> input(kFrameCount * (audioChannelCount + hapticChannelCount));
+    std::vector<float> output(kFrameCount * (audioChannelCount + hapticChannelCount));
+    for (size_t i = 0; i < kFrameCount * audioChannelCount; ++i) {
+        input[i] = dis(gen);
+    }
+    effect_handle_t effectHandle = nullptr;
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(
+            &hapticgenerator_uuid, 1, 1, &effectHandle);
+        status != 0) {
+        ALOGE("create_effect returned an error = %d\n", status);
+        return;
+    }
+
+    effect_config_t config{};
+    config.inputCfg.accessMode = EFFECT_BUFFER_ACCESS_READ;
+    config.inputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+    config.inputCfg.bufferProvider.getBuffer = nullptr;
+    config.inputCfg.bufferProvider.releaseBuffer = nullptr;
+    config.inputCfg.bufferProvider.cookie = nullptr;
+    config.inputCfg.mask = EFFECT_CONFIG_ALL;
+
+    config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_WRITE;
+    config.outputCfg.format = AUDIO_FORMAT_PCM_FLOAT;
+    config.outputCfg.bufferProvider.getBuffer = nullptr;
+    config.outputCfg.bufferProvider.releaseBuffer = nullptr;
+    config.outputCfg.bufferProvider.cookie = nullptr;
+    config.outputCfg.mask = EFFECT_CONFIG_ALL;
+
+    config.inputCfg.samplingRate = sampleRate;
+    config.inputCfg.channels = channelMask;
+
+    config.outputCfg.samplingRate = sampleRate;
+    config.outputCfg.channels = channelMask;
+
+    int reply = 0;
+    uint32_t replySize = sizeof(reply);
+    if (int status = (*effectHandle)
+            ->command(effectHandle, EFFECT_CMD_SET_CONFIG, sizeof(effect_config_t),
+                    &config, &replySize, &reply);
+        status != 0) {
+        ALOGE("command returned an error = %d\n", status);
+        return;
+    }
+
+    // Haptic data is only generated when a track requests a non muted intensity.
+    const int intensity[2] = {1 /* id */, static_cast<int>(android::os::HapticScale::NONE)};
+    if (int status = setParameter(effectHandle, HG_PARAM_HAPTIC_INTENSITY,
+                                  intensity, sizeof(intensity));
+        status != 0) {
+        ALOGE("set haptic intensity returned an error = %d\n", status);
+        return;
+    }
+    const float vibratorInfo[3] = {150.0f /* resonantFrequency */, 8.0f /* qFactor */,
+                                   1.0f /* maxAmplitude */};
+    if (int status = setParameter(effectHandle, HG_PARAM_VIBRATOR_INFO,
+                                  vibratorInfo, sizeof(vibratorInfo));
+        status != 0) {
+        ALOGE("set vibrator info returned an error = %d\n", status);
+        return;
+    }
+
+    if (int status = (*effectHandle)
+            ->command(effectHandle, EFFECT_CMD_ENABLE, 0, nullptr, &replySize, &reply);
+        status != 0) {
+        ALOGE("Command enable call returned error %d\n", reply);
+        return;
+    }
+
+    // Run the test
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+
+        audio_buffer_t inBuffer = {.frameCount = kFrameCount, .f32 = input.data()};
+        audio_buffer_t outBuffer = {.frameCount = kFrameCount, .f32 = output.data()};
+        (*effectHandle)->process(effectHandle, &inBuffer, &outBuffer);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetComplexityN(hapticChannelCount);
+    state.SetLabel(std::string(audio_channel_out_mask_to_string(audioChannelMask))
+            + (hapticChannelCount == 1 ? " HAPTIC_A" : " HAPTIC_AB"));
+
+    if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
+        ALOGE("release_effect returned an error = %d\n", status);
+        return;
+    }
+}
+
+static void HapticGeneratorArgs(benchmark::internal::Benchmark* b) {
+    for (int i = 0; i < (int)std::size(kAudioChannelMasks); i++) {
+        for (int j = 0; j < (int)std::size(kHapticChannelMasks); j++) {
+            b->Args({i, j});
+        }
+    }
+}
+
+BENCHMARK(BM_HapticGenerator)->Apply(HapticGeneratorArgs);
+
+BENCHMARK_MAIN();
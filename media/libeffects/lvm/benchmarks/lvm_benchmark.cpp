@@ -18,12 +18,15 @@
 #include <climits>
 #include <cstdlib>
 #include <random>
+#include <string>
 #include <vector>
 #include <log/log.h>
 #include <benchmark/benchmark.h>
 #include <hardware/audio_effect.h>
 #include <system/audio.h>
 
+#include "VectorArithmetic.h"
+
 extern audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
 constexpr effect_uuid_t kEffectUuids[] = {
         // NXP SW BassBoost
@@ -36,6 +39,15 @@ constexpr effect_uuid_t kEffectUuids[] = {
         {0x119341a0, 0x8469, 0x11df, 0x81f9, {0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b}},
 };
 
+constexpr const char* kEffectNames[] = {
+        "BassBoost",
+        "Virtualizer",
+        "Equalizer",
+        "Volume",
+};
+
+static_assert(std::size(kEffectNames) == std::size(kEffectUuids));
+
 constexpr size_t kNumEffectUuids = std::size(kEffectUuids);
 
 constexpr size_t kFrameCount = 2048;
@@ -59,6 +71,11 @@ constexpr int kSampleRate = 44100;
  * The first parameter indicates the number of channels.
  * The second parameter indicates the effect.
  * 0: Bass Boost, 1: Virtualizer, 2: Equalizer, 3: Volume
+ * The third parameter selects the implementation of the vector primitives
+ * used by the effect (see LVM_SetVectorOps()), 0: scalar, 1: SIMD. It was added
+ * after these results were collected. Each result is labeled with the effect, and
+ * reports the processing time per frame, so that effects and implementations can
+ * be compared directly.
  * -----------------------------------------------------
  * Benchmark           Time             CPU   Iterations
  * -----------------------------------------------------
@@ -164,6 +181,14 @@ static void BM_LVM(benchmark::State& state) {
     const size_t chMask = kChMasks[state.range(0) - 1];
     const effect_uuid_t uuid = kEffectUuids[state.range(1)];
     const size_t channelCount = audio_channel_count_from_out_mask(chMask);
+    const auto vectorOps = (LVM_VectorOps_en)state.range(2);
+
+    // Select before the effect is created, creating it keeps an explicit selection.
+    LVM_SetVectorOps(vectorOps);
+    if (LVM_GetVectorOps() != vectorOps) {
+        state.SkipWithError("vector implementation not supported");
+        return;
+    }
 
     // Initialize input buffer with deterministic pseudo-random values
     std::minstd_rand gen(chMask);
@@ -218,6 +243,11 @@ static void BM_LVM(benchmark::State& state) {
     }
 
     state.SetComplexityN(state.range(0));
+    state.SetLabel(std::string(kEffectNames[state.range(1)]) +
+                   (vectorOps == LVM_VECTOROPS_SIMD ? " simd" : " scalar"));
+    state.counters["time/frame"] = benchmark::Counter(
+            kFrameCount, benchmark::Counter::kIsIterationInvariantRate |
+                                 benchmark::Counter::kInvert);
 
     if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
         ALOGE("release_effect returned an error = %d\n", status);
@@ -228,7 +258,9 @@ static void BM_LVM(benchmark::State& state) {
 static void LVMArgs(benchmark::internal::Benchmark* b) {
     for (int i = FCC_1; i <= kNumChMasks; i++) {
         for (int j = 0; j < kNumEffectUuids; ++j) {
-            b->Args({i, j});
+            for (int k = LVM_VECTOROPS_SCALAR; k <= LVM_VECTOROPS_SIMD; ++k) {
+                b->Args({i, j, k});
+            }
         }
     }
 }
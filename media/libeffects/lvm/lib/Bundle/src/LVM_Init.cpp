@@ -89,6 +89,11 @@ LVM_ReturnStatus_en LVM_GetInstanceHandle(LVM_Handle_t* phInstance, LVM_InstPara
         return (LVM_OUTOFRANGE);
     }
 
+    /*
+     * Select the implementation of the vector primitives
+     */
+    LVM_InitVectorOps();
+
     /*
      * Create the instance handle
      */
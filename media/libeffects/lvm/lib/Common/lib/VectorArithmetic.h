@@ -57,6 +57,25 @@ void MSTo2i_Sat_Float(const LVM_FLOAT* srcM, const LVM_FLOAT* srcS, LVM_FLOAT* d
 void From2iToMS_Float(const LVM_FLOAT* src, LVM_FLOAT* dstM, LVM_FLOAT* dstS, LVM_INT16 n);
 void JoinTo2i_Float(const LVM_FLOAT* srcL, const LVM_FLOAT* srcR, LVM_FLOAT* dst, LVM_INT16 n);
 
+/**********************************************************************************
+    IMPLEMENTATION SELECTION
+***********************************************************************************/
+/*
+ * The saturating add, multiply-accumulate, scale and hard mix primitives have a NEON
+ * (or SSE2) implementation next to the scalar one. LVM_InitVectorOps() selects the
+ * SIMD implementation when the CPU supports it, and is called when an instance is
+ * created. LVM_SetVectorOps() forces a selection, which is meant for comparing both
+ * implementations in tests and benchmarks.
+ */
+typedef enum {
+    LVM_VECTOROPS_SCALAR = 0,
+    LVM_VECTOROPS_SIMD = 1,
+} LVM_VectorOps_en;
+
+void LVM_InitVectorOps(void);
+void LVM_SetVectorOps(LVM_VectorOps_en ops);
+LVM_VectorOps_en LVM_GetVectorOps(void);
+
 /**********************************************************************************/
 
 #endif /* _VECTOR_ARITHMETIC_H_ */
@@ -20,10 +20,21 @@
 ***********************************************************************************/
 #include "ScalarArithmetic.h"
 #include "VectorArithmetic.h"
+#include "LVM_Simd.h"
 
 void Add2_Sat_Float(const LVM_FLOAT* src, LVM_FLOAT* dst, LVM_INT16 n) {
     LVM_FLOAT Temp;
     LVM_INT16 ii;
+#if defined(LVM_SIMD_NEON) || defined(LVM_SIMD_SSE2)
+    if (LVM_UseSimd()) {
+        for (; n >= 4; n -= 4) {
+            LVM_Vec4_Store(dst,
+                           LVM_Vec4_Clamp(LVM_Vec4_Add(LVM_Vec4_Load(src), LVM_Vec4_Load(dst))));
+            src += 4;
+            dst += 4;
+        }
+    }
+#endif
     for (ii = n; ii != 0; ii--) {
         Temp = *src++ + *dst;
         *dst++ = LVM_Clamp(Temp);
@@ -20,6 +20,7 @@
 ***********************************************************************************/
 #include "LVC_Mixer_Private.h"
 #include "ScalarArithmetic.h"
+#include "LVM_Simd.h"
 
 /**********************************************************************************
    FUNCTION LVCore_MIXHARD_2ST_D16C31_SAT
@@ -37,6 +38,20 @@ void LVC_Core_MixHard_2St_D16C31_SAT(LVMixer3_FLOAT_st* ptrInstance1,
     Current1 = pInstance1->Current;
     Current2 = pInstance2->Current;
 
+#if defined(LVM_SIMD_NEON) || defined(LVM_SIMD_SSE2)
+    if (LVM_UseSimd()) {
+        const LVM_Vec4 vCurrent1 = LVM_Vec4_Dup(Current1);
+        const LVM_Vec4 vCurrent2 = LVM_Vec4_Dup(Current2);
+        for (; n >= 4; n -= 4) {
+            LVM_Vec4_Store(dst, LVM_Vec4_Clamp(
+                                        LVM_Vec4_Add(LVM_Vec4_Mul(LVM_Vec4_Load(src1), vCurrent1),
+                                                     LVM_Vec4_Mul(LVM_Vec4_Load(src2), vCurrent2))));
+            src1 += 4;
+            src2 += 4;
+            dst += 4;
+        }
+    }
+#endif
     for (ii = n; ii != 0; ii--) {
         Temp =  *src1++ * Current1 + *src2++ * Current2;
         *dst++ = LVM_Clamp(Temp);
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LVM_SIMD_H__
+#define __LVM_SIMD_H__
+
+/**********************************************************************************
+   INCLUDE FILES
+***********************************************************************************/
+#include <atomic>
+
+#include "LVM_Types.h"
+#include "VectorArithmetic.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LVM_SIMD_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define LVM_SIMD_SSE2 1
+#endif
+
+/**********************************************************************************
+   SELECTION
+***********************************************************************************/
+extern std::atomic<int> gLVM_VectorOps;
+
+/* True if the SIMD implementation of the primitives was selected */
+static inline bool LVM_UseSimd() {
+#if defined(LVM_SIMD_NEON) || defined(LVM_SIMD_SSE2)
+    return gLVM_VectorOps.load(std::memory_order_relaxed) == LVM_VECTOROPS_SIMD;
+#else
+    return false;
+#endif
+}
+
+/**********************************************************************************
+   FOUR SAMPLE VECTOR
+***********************************************************************************/
+/*
+ * LVM_Vec4 wraps the target vector type so that each primitive has one SIMD loop.
+ * LVM_Vec4_Clamp() matches LVM_Clamp(), including returning -1 for a NaN input.
+ */
+#if defined(LVM_SIMD_NEON)
+typedef float32x4_t LVM_Vec4;
+static inline LVM_Vec4 LVM_Vec4_Load(const LVM_FLOAT* p) { return vld1q_f32(p); }
+static inline void LVM_Vec4_Store(LVM_FLOAT* p, LVM_Vec4 v) { vst1q_f32(p, v); }
+static inline LVM_Vec4 LVM_Vec4_Dup(LVM_FLOAT f) { return vdupq_n_f32(f); }
+static inline LVM_Vec4 LVM_Vec4_Add(LVM_Vec4 a, LVM_Vec4 b) { return vaddq_f32(a, b); }
+static inline LVM_Vec4 LVM_Vec4_Mul(LVM_Vec4 a, LVM_Vec4 b) { return vmulq_f32(a, b); }
+static inline LVM_Vec4 LVM_Vec4_Clamp(LVM_Vec4 v) {
+#if defined(__aarch64__)
+    return vminnmq_f32(vmaxnmq_f32(v, vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+#else
+    return vminq_f32(vmaxq_f32(v, vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+#endif
+}
+#elif defined(LVM_SIMD_SSE2)
+typedef __m128 LVM_Vec4;
+static inline LVM_Vec4 LVM_Vec4_Load(const LVM_FLOAT* p) { return _mm_loadu_ps(p); }
+static inline void LVM_Vec4_Store(LVM_FLOAT* p, LVM_Vec4 v) { _mm_storeu_ps(p, v); }
+static inline LVM_Vec4 LVM_Vec4_Dup(LVM_FLOAT f) { return _mm_set1_ps(f); }
+static inline LVM_Vec4 LVM_Vec4_Add(LVM_Vec4 a, LVM_Vec4 b) { return _mm_add_ps(a, b); }
+static inline LVM_Vec4 LVM_Vec4_Mul(LVM_Vec4 a, LVM_Vec4 b) { return _mm_mul_ps(a, b); }
+static inline LVM_Vec4 LVM_Vec4_Clamp(LVM_Vec4 v) {
+    /* maxps returns the second operand when either is NaN */
+    return _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+}
+#endif
+
+#endif /* __LVM_SIMD_H__ */
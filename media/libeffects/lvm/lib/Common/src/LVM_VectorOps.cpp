@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**********************************************************************************
+   INCLUDE FILES
+***********************************************************************************/
+#if defined(__arm__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+#include "LVM_Simd.h"
+
+/* -1 until LVM_InitVectorOps() or LVM_SetVectorOps() is called */
+std::atomic<int> gLVM_VectorOps{-1};
+
+static LVM_VectorOps_en LVM_DetectVectorOps() {
+#if defined(LVM_SIMD_NEON) && defined(__arm__)
+    /* NEON is optional on 32-bit ARM */
+    return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0 ? LVM_VECTOROPS_SIMD : LVM_VECTOROPS_SCALAR;
+#elif defined(LVM_SIMD_NEON) || defined(LVM_SIMD_SSE2)
+    /* part of the baseline of aarch64 and x86_64 */
+    return LVM_VECTOROPS_SIMD;
+#else
+    return LVM_VECTOROPS_SCALAR;
+#endif
+}
+
+void LVM_InitVectorOps(void) {
+    /* An explicit selection from LVM_SetVectorOps() is kept */
+    int unset = -1;
+    gLVM_VectorOps.compare_exchange_strong(unset, LVM_DetectVectorOps());
+}
+
+void LVM_SetVectorOps(LVM_VectorOps_en ops) {
+    if (ops == LVM_VECTOROPS_SIMD && LVM_DetectVectorOps() != LVM_VECTOROPS_SIMD) {
+        ops = LVM_VECTOROPS_SCALAR;
+    }
+    gLVM_VectorOps.store(ops);
+}
+
+LVM_VectorOps_en LVM_GetVectorOps(void) {
+    return LVM_UseSimd() ? LVM_VECTOROPS_SIMD : LVM_VECTOROPS_SCALAR;
+}
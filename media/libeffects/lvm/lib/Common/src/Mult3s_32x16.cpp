@@ -21,11 +21,23 @@
 
 #include "VectorArithmetic.h"
 #include "LVM_Macros.h"
+#include "LVM_Simd.h"
 
 void Mult3s_Float(const LVM_FLOAT* src, const LVM_FLOAT val, LVM_FLOAT* dst, LVM_INT16 n) {
     LVM_INT16 ii;
     LVM_FLOAT temp;
 
+#if defined(LVM_SIMD_NEON) || defined(LVM_SIMD_SSE2)
+    if (LVM_UseSimd()) {
+        const LVM_Vec4 vVal = LVM_Vec4_Dup(val);
+        for (; n >= 4; n -= 4) {
+            LVM_Vec4_Store(dst, LVM_Vec4_Mul(LVM_Vec4_Load(src), vVal));
+            src += 4;
+            dst += 4;
+        }
+    }
+#endif
+
     for (ii = n; ii != 0; ii--) {
         temp = (*src) * val;
         src++;
@@ -71,6 +71,11 @@ LVREV_ReturnStatus_en LVREV_GetInstanceHandle(LVREV_Handle_t* phInstance,
         return LVREV_OUTOFRANGE;
     }
 
+    /*
+     * Select the implementation of the vector primitives
+     */
+    LVM_InitVectorOps();
+
     /*
      * Set the instance handle if not already initialised
      */
@@ -126,6 +126,7 @@
 #include <audio_effects/effect_aec.h>
 #include <audio_effects/effect_agc.h>
 #include <array>
+#include <cerrno>
 #include <climits>
 #include <cstdlib>
 #include <random>
@@ -317,6 +318,111 @@ static void preprocessingArgs(benchmark::internal::Benchmark* b) {
     }
 }
 
+// Effects of a typical voice communication capture, in the order they are applied.
+constexpr PreProcId kVoiceCommunicationEffects[] = {PREPROC_AEC, PREPROC_NS, PREPROC_AGC};
+
+/*
+ * Measures AEC, NS and AGC enabled together on the same session. The effects of a session
+ * share one webrtc AudioProcessing instance: the first effects of the chain only mark
+ * themselves as processed and the last one runs all the enabled modules in one pass.
+ * The first parameter indicates the channel mask index.
+ */
+static void BM_PREPROCESSING_COMBINED(benchmark::State& state) {
+    const size_t chMask = kChMasks[state.range(0) - 1];
+    const size_t channelCount = audio_channel_count_from_in_mask(chMask);
+
+    int32_t sessionId = 1;
+    int32_t ioId = 1;
+    effect_handle_t effectHandles[std::size(kVoiceCommunicationEffects)] = {};
+    effect_config_t config{};
+    config.inputCfg.samplingRate = config.outputCfg.samplingRate = kSampleRate;
+    config.inputCfg.channels = config.outputCfg.channels = chMask;
+    config.inputCfg.format = config.outputCfg.format = AUDIO_FORMAT_PCM_16_BIT;
+
+    for (size_t i = 0; i < std::size(kVoiceCommunicationEffects); ++i) {
+        if (int status = preProcCreateEffect(&effectHandles[i], kVoiceCommunicationEffects[i],
+                                             &config, sessionId, ioId);
+            status != 0) {
+            ALOGE("Create effect call returned error %i", status);
+            return;
+        }
+        int reply = 0;
+        uint32_t replySize = sizeof(reply);
+        if (int status = (*effectHandles[i])
+                                 ->command(effectHandles[i], EFFECT_CMD_ENABLE, 0, nullptr,
+                                           &replySize, &reply);
+            status != 0) {
+            ALOGE("Command enable call returned error %d\n", reply);
+            return;
+        }
+    }
+    effect_handle_t aecHandle = effectHandles[0];
+
+    // Initialize input buffer with deterministic pseudo-random values
+    const int frameLength = (int)(kSampleRate * kTenMilliSecVal);
+    std::minstd_rand gen(chMask);
+    std::uniform_real_distribution<> dis(-1.0f, 1.0f);
+    std::vector<short> in(frameLength * channelCount);
+    for (auto& i : in) {
+        i = preProcGetShortVal(dis(gen));
+    }
+    std::vector<short> farIn(frameLength * channelCount);
+    for (auto& i : farIn) {
+        i = preProcGetShortVal(dis(gen));
+    }
+    std::vector<short> out(frameLength * channelCount);
+
+    // Run the test
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(in.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::DoNotOptimize(farIn.data());
+
+        audio_buffer_t inBuffer = {.frameCount = (size_t)frameLength, .s16 = in.data()};
+        audio_buffer_t outBuffer = {.frameCount = (size_t)frameLength, .s16 = out.data()};
+        audio_buffer_t farInBuffer = {.frameCount = (size_t)frameLength, .s16 = farIn.data()};
+
+        if (int status = preProcSetConfigParam(aecHandle, AEC_PARAM_ECHO_DELAY, kStreamDelayMs);
+            status != 0) {
+            ALOGE("preProcSetConfigParam returned Error %d\n", status);
+            return;
+        }
+        for (size_t i = 0; i < std::size(kVoiceCommunicationEffects); ++i) {
+            // All but the last effect of the session return -ENODATA, deferring the processing.
+            const int status = (*effectHandles[i])->process(effectHandles[i], &inBuffer,
+                                                            &outBuffer);
+            if (status != 0 && !(status == -ENODATA
+                                 && i + 1 < std::size(kVoiceCommunicationEffects))) {
+                ALOGE("\nError: Process i = %zu returned with error %d\n", i, status);
+                return;
+            }
+        }
+        if (int status = (*aecHandle)->process_reverse(aecHandle, &farInBuffer, &outBuffer);
+            status != 0) {
+            ALOGE("\nError: Process reverse returned with error %d\n", status);
+            return;
+        }
+    }
+    benchmark::ClobberMemory();
+
+    state.SetComplexityN(state.range(0));
+
+    for (effect_handle_t effectHandle : effectHandles) {
+        if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle);
+            status != 0) {
+            ALOGE("release_effect returned an error = %d\n", status);
+            return;
+        }
+    }
+}
+
+static void preprocessingCombinedArgs(benchmark::internal::Benchmark* b) {
+    for (int i = 1; i <= (int)kNumChMasks; i++) {
+        b->Args({i});
+    }
+}
+
 BENCHMARK(BM_PREPROCESSING)->Apply(preprocessingArgs);
+BENCHMARK(BM_PREPROCESSING_COMBINED)->Apply(preprocessingCombinedArgs);
 
 BENCHMARK_MAIN();
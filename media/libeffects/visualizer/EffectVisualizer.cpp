@@ -25,7 +25,9 @@
 #include <time.h>
 
 #include <algorithm> // max
+#include <atomic>
 #include <new>
+#include <vector>
 
 #include <log/log.h>
 
@@ -88,7 +90,8 @@ struct BufferStats {
 struct VisualizerContext {
     const struct effect_interface_s *mItfe;
     effect_config_t mConfig;
-    uint32_t mCaptureIdx;
+    // Written by process() and read by VISUALIZER_CMD_CAPTURE, which run on different threads.
+    std::atomic<uint32_t> mCaptureIdx;
     uint32_t mCaptureSize;
     uint32_t mScalingMode;
     uint8_t mState;
@@ -96,6 +99,9 @@ struct VisualizerContext {
     uint32_t mLatency;
     struct timespec mBufferUpdateTime;
     uint8_t mCaptureBuf[CAPTURE_BUF_SIZE];
+#ifdef BUILD_FLOAT
+    std::vector<float> mCaptureSums; // sum of the channels of each frame of the current buffer
+#endif // BUILD_FLOAT
     // for measurements
     uint8_t mChannelCount; // to avoid recomputing it every time a buffer is processed
     uint32_t mMeasurementMode;
@@ -166,6 +172,10 @@ int Visualizer_setConfig(VisualizerContext *pContext, effect_config_t *pConfig)
     if (pConfig->inputCfg.format != kProcessFormat) return -EINVAL;
 
     pContext->mConfig = *pConfig;
+#ifdef BUILD_FLOAT
+    // size the capture scratch buffer here rather than on the first process() call
+    pContext->mCaptureSums.resize(pConfig->inputCfg.buffer.frameCount);
+#endif // BUILD_FLOAT
 
     Visualizer_reset(pContext);
 
@@ -245,6 +255,118 @@ int Visualizer_init(VisualizerContext *pContext)
     return 0;
 }
 
+//----------------------------------------------------------------------------
+// Visualizer_capture()
+//----------------------------------------------------------------------------
+// Purpose: Append the 8 bit mono capture of a buffer to the capture buffer.
+//
+// Inputs:
+//  pContext:   effect engine context
+//  inBuffer:   buffer to capture
+//
+// Outputs:
+//
+//----------------------------------------------------------------------------
+
+void Visualizer_capture(VisualizerContext *pContext, const audio_buffer_t *inBuffer)
+{
+    const size_t frameCount = inBuffer->frameCount;
+    uint8_t *buf = pContext->mCaptureBuf;
+    uint32_t captIdx = pContext->mCaptureIdx.load(std::memory_order_relaxed);
+
+#ifdef BUILD_FLOAT
+    // Sum the channels of each frame once, the scaling and the conversion to 8 bit
+    // then only need to go through the mono sums.
+    if (pContext->mCaptureSums.size() < frameCount) {
+        pContext->mCaptureSums.resize(frameCount);
+    }
+    float *sums = pContext->mCaptureSums.data();
+    const float *in = inBuffer->f32;
+    float maxSample = 0.f;
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        // we reconstruct the actual summed value to ensure proper normalization
+        // for multichannel outputs (channels > 2 may often be 0).
+        float smp = 0.f;
+        for (uint32_t i = 0; i < pContext->mChannelCount; ++i) {
+            smp += *in++;
+        }
+        sums[frame] = smp;
+        maxSample = fmax(maxSample, fabs(smp));
+    }
+
+    float fscale; // multiplicative scale
+    if (pContext->mScalingMode == VISUALIZER_SCALING_MODE_NORMALIZED) {
+        // derive capture scaling factor from peak value in current buffer
+        // this gives more interesting captures for display.
+        if (maxSample > 0.f) {
+            fscale = 0.99f / maxSample;
+            int exp; // unused
+            const float significand = frexp(fscale, &exp);
+            if (significand == 0.5f) {
+                fscale *= 255.f / 256.f; // avoid returning unaltered PCM signal
+            }
+        } else {
+            // scale doesn't matter, the values are all 0.
+            fscale = 1.f;
+        }
+    } else {
+        assert(pContext->mScalingMode == VISUALIZER_SCALING_MODE_AS_PLAYED);
+        // Note: if channels are uncorrelated, 1/sqrt(N) could be used at the risk of clipping.
+        fscale = 1.f / pContext->mChannelCount;  // account for summing all the channels together.
+    }
+
+    for (size_t frame = 0; frame < frameCount; ) {
+        // convert up to the end of the capture buffer, then wrap
+        const size_t count = std::min(frameCount - frame, size_t(CAPTURE_BUF_SIZE - captIdx));
+        for (size_t i = 0; i < count; ++i) {
+            buf[captIdx + i] = clamp8_from_float(sums[frame + i] * fscale);
+        }
+        frame += count;
+        captIdx += count;
+        if (captIdx >= CAPTURE_BUF_SIZE) captIdx = 0; // wrap
+    }
+#else
+    const size_t sampleLen = frameCount * pContext->mChannelCount;
+    int32_t shift;
+
+    if (pContext->mScalingMode == VISUALIZER_SCALING_MODE_NORMALIZED) {
+        // derive capture scaling factor from peak value in current buffer
+        // this gives more interesting captures for display.
+        int32_t orAccum = 0;
+        for (size_t i = 0; i < sampleLen; ++i) {
+            int32_t smp = inBuffer->s16[i];
+            if (smp < 0) smp = -smp - 1; // take care to keep the max negative in range
+            orAccum |= smp;
+        }
+
+        // A maximum amplitude signal will have 17 leading zeros, which we want to
+        // translate to a shift of 8 (for converting 16 bit to 8 bit)
+        shift = 25 - __builtin_clz(orAccum);
+
+        // Never scale by less than 8 to avoid returning unaltered PCM signal.
+        if (shift < 3) {
+            shift = 3;
+        }
+        // add one to combine the division by 2 needed after summing left and right channels below
+        shift++;
+    } else {
+        assert(pContext->mScalingMode == VISUALIZER_SCALING_MODE_AS_PLAYED);
+        shift = 9;
+    }
+
+    for (uint32_t inIdx = 0; inIdx < sampleLen; captIdx++) {
+        if (captIdx >= CAPTURE_BUF_SIZE) captIdx = 0; // wrap
+
+        const int32_t smp = (inBuffer->s16[inIdx] + inBuffer->s16[inIdx + 1]) >> shift;
+        inIdx += FCC_2;  // integer supports stereo only.
+        buf[captIdx] = ((uint8_t)smp)^0x80;
+    }
+#endif // BUILD_FLOAT
+
+    // publish the new samples to VISUALIZER_CMD_CAPTURE
+    pContext->mCaptureIdx.store(captIdx, std::memory_order_release);
+}
+
 //
 //--- Effect Library Interface Implementation
 //
@@ -366,94 +488,16 @@ int Visualizer_process(
         }
     }
 
-#ifdef BUILD_FLOAT
-    float fscale; // multiplicative scale
-#else
-    int32_t shift;
-#endif // BUILD_FLOAT
-
-    if (pContext->mScalingMode == VISUALIZER_SCALING_MODE_NORMALIZED) {
-        // derive capture scaling factor from peak value in current buffer
-        // this gives more interesting captures for display.
-
-#ifdef BUILD_FLOAT
-        float maxSample = 0.f;
-        for (size_t inIdx = 0; inIdx < sampleLen; ) {
-            // we reconstruct the actual summed value to ensure proper normalization
-            // for multichannel outputs (channels > 2 may often be 0).
-            float smp = 0.f;
-            for (int i = 0; i < pContext->mChannelCount; ++i) {
-                smp += inBuffer->f32[inIdx++];
-            }
-            maxSample = fmax(maxSample, fabs(smp));
-        }
-        if (maxSample > 0.f) {
-            fscale = 0.99f / maxSample;
-            int exp; // unused
-            const float significand = frexp(fscale, &exp);
-            if (significand == 0.5f) {
-                fscale *= 255.f / 256.f; // avoid returning unaltered PCM signal
-            }
-        } else {
-            // scale doesn't matter, the values are all 0.
-            fscale = 1.f;
-        }
-#else
-        int32_t orAccum = 0;
-        for (size_t i = 0; i < sampleLen; ++i) {
-            int32_t smp = inBuffer->s16[i];
-            if (smp < 0) smp = -smp - 1; // take care to keep the max negative in range
-            orAccum |= smp;
-        }
-
-        // A maximum amplitude signal will have 17 leading zeros, which we want to
-        // translate to a shift of 8 (for converting 16 bit to 8 bit)
-        shift = 25 - __builtin_clz(orAccum);
-
-        // Never scale by less than 8 to avoid returning unaltered PCM signal.
-        if (shift < 3) {
-            shift = 3;
-        }
-        // add one to combine the division by 2 needed after summing left and right channels below
-        shift++;
-#endif // BUILD_FLOAT
-    } else {
-        assert(pContext->mScalingMode == VISUALIZER_SCALING_MODE_AS_PLAYED);
-#ifdef BUILD_FLOAT
-        // Note: if channels are uncorrelated, 1/sqrt(N) could be used at the risk of clipping.
-        fscale = 1.f / pContext->mChannelCount;  // account for summing all the channels together.
-#else
-        shift = 9;
-#endif // BUILD_FLOAT
+    // The capture buffer is only read while the effect is enabled, see VISUALIZER_CMD_CAPTURE.
+    if (pContext->mState == VISUALIZER_STATE_ACTIVE) {
+        Visualizer_capture(pContext, inBuffer);
     }
-
-    uint32_t captIdx;
-    uint32_t inIdx;
-    uint8_t *buf = pContext->mCaptureBuf;
-    for (inIdx = 0, captIdx = pContext->mCaptureIdx;
-         inIdx < sampleLen;
-         captIdx++) {
-        if (captIdx >= CAPTURE_BUF_SIZE) captIdx = 0; // wrap
-
-#ifdef BUILD_FLOAT
-        float smp = 0.f;
-        for (uint32_t i = 0; i < pContext->mChannelCount; ++i) {
-            smp += inBuffer->f32[inIdx++];
+    if (pContext->mState == VISUALIZER_STATE_ACTIVE
+            || (pContext->mMeasurementMode & MEASUREMENT_MODE_PEAK_RMS)) {
+        // update last buffer update time stamp
+        if (clock_gettime(CLOCK_MONOTONIC, &pContext->mBufferUpdateTime) < 0) {
+            pContext->mBufferUpdateTime.tv_sec = 0;
         }
-        buf[captIdx] = clamp8_from_float(smp * fscale);
-#else
-        const int32_t smp = (inBuffer->s16[inIdx] + inBuffer->s16[inIdx + 1]) >> shift;
-        inIdx += FCC_2;  // integer supports stereo only.
-        buf[captIdx] = ((uint8_t)smp)^0x80;
-#endif // BUILD_FLOAT
-    }
-
-    // XXX the following two should really be atomic, though it probably doesn't
-    // matter much for visualization purposes
-    pContext->mCaptureIdx = captIdx;
-    // update last buffer update time stamp
-    if (clock_gettime(CLOCK_MONOTONIC, &pContext->mBufferUpdateTime) < 0) {
-        pContext->mBufferUpdateTime.tv_sec = 0;
     }
 
     if (inBuffer->raw != outBuffer->raw) {
@@ -636,10 +680,11 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
         }
         if (pContext->mState == VISUALIZER_STATE_ACTIVE) {
             const uint32_t deltaMs = Visualizer_getDeltaTimeMsFromUpdatedTime(pContext);
+            const uint32_t captureIdx = pContext->mCaptureIdx.load(std::memory_order_acquire);
 
             // if audio framework has stopped playing audio although the effect is still
             // active we must clear the capture buffer to return silence
-            if ((pContext->mLastCaptureIdx == pContext->mCaptureIdx) &&
+            if ((pContext->mLastCaptureIdx == captureIdx) &&
                     (pContext->mBufferUpdateTime.tv_sec != 0) &&
                     (deltaMs > MAX_STALL_TIME_MS)) {
                     ALOGV("capture going to idle");
@@ -662,8 +707,8 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
                 }
 
                 int32_t capturePoint;
-                //capturePoint = (int32_t)pContext->mCaptureIdx - deltaSmpl;
-                __builtin_sub_overflow((int32_t)pContext->mCaptureIdx, deltaSmpl, &capturePoint);
+                //capturePoint = (int32_t)captureIdx - deltaSmpl;
+                __builtin_sub_overflow((int32_t)captureIdx, deltaSmpl, &capturePoint);
                 // a negative capturePoint means we wrap the buffer.
                 if (capturePoint < 0) {
                     uint32_t size = -capturePoint;
@@ -682,7 +727,7 @@ int Visualizer_command(effect_handle_t self, uint32_t cmdCode, uint32_t cmdSize,
                        captureSize);
             }
 
-            pContext->mLastCaptureIdx = pContext->mCaptureIdx;
+            pContext->mLastCaptureIdx = captureIdx;
         } else {
             memset(pReplyData, 0x80, captureSize);
         }
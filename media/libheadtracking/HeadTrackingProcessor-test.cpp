@@ -141,6 +141,71 @@ TEST(HeadTrackingProcessor, SmoothModeSwitch) {
     EXPECT_EQ(processor->getHeadToStagePose(), Pose3f());
 }
 
+TEST(HeadTrackingProcessor, IncrementalRecalculation) {
+    std::unique_ptr<HeadTrackingProcessor> processor = createHeadTrackingProcessor(
+            Options{.stillRecalculationPeriod = 10, .stillTranslationalThreshold = 0.1},
+            HeadTrackingMode::WORLD_RELATIVE);
+
+    processor->setWorldToHeadPose(0, Pose3f(), Twist3f());
+    processor->setWorldToScreenPose(0, Pose3f());
+    processor->calculate(0);
+    ASSERT_EQ(HeadTrackingMode::WORLD_RELATIVE, processor->getActualMode());
+    EXPECT_TRUE(processor->hasOutputChanged());
+    EXPECT_EQ(processor->getHeadToStagePose(), Pose3f());
+
+    // A movement within the still threshold doesn't trigger a recalculation before the period.
+    processor->setWorldToHeadPose(1, Pose3f({0.05, 0, 0}), Twist3f());
+    processor->calculate(1);
+    EXPECT_FALSE(processor->hasOutputChanged());
+    EXPECT_EQ(processor->getHeadToStagePose(), Pose3f());
+
+    // But it is picked up once the period has elapsed.
+    processor->calculate(10);
+    EXPECT_TRUE(processor->hasOutputChanged());
+    EXPECT_EQ(processor->getHeadToStagePose(), Pose3f({-0.05, 0, 0}));
+
+    // A movement beyond the still threshold is processed right away.
+    processor->setWorldToHeadPose(11, Pose3f({1, 0, 0}), Twist3f());
+    processor->calculate(11);
+    EXPECT_TRUE(processor->hasOutputChanged());
+    EXPECT_EQ(processor->getHeadToStagePose(), Pose3f({-1, 0, 0}));
+
+    // So is any other input.
+    const Pose3f screenToStage{{1, 2, 3}, Quaternionf::UnitRandom()};
+    processor->setScreenToStagePose(screenToStage);
+    processor->calculate(12);
+    EXPECT_TRUE(processor->hasOutputChanged());
+    EXPECT_EQ(processor->getHeadToStagePose(), Pose3f({-1, 0, 0}) * screenToStage);
+}
+
+TEST(HeadTrackingProcessor, OutputChangeThreshold) {
+    std::unique_ptr<HeadTrackingProcessor> processor = createHeadTrackingProcessor(
+            Options{.outputTranslationalThreshold = 0.1}, HeadTrackingMode::WORLD_RELATIVE);
+
+    processor->setWorldToHeadPose(0, Pose3f(), Twist3f());
+    processor->setWorldToScreenPose(0, Pose3f());
+    processor->calculate(0);
+    ASSERT_EQ(HeadTrackingMode::WORLD_RELATIVE, processor->getActualMode());
+    EXPECT_TRUE(processor->hasOutputChanged());
+
+    // Small changes are still calculated, but not reported.
+    processor->setWorldToHeadPose(1, Pose3f({0.05, 0, 0}), Twist3f());
+    processor->calculate(1);
+    EXPECT_FALSE(processor->hasOutputChanged());
+    EXPECT_EQ(processor->getHeadToStagePose(), Pose3f({-0.05, 0, 0}));
+
+    // Changes accumulate relative to the last reported output.
+    processor->setWorldToHeadPose(2, Pose3f({0.15, 0, 0}), Twist3f());
+    processor->calculate(2);
+    EXPECT_TRUE(processor->hasOutputChanged());
+
+    // A mode change is always reported.
+    processor->setDesiredMode(HeadTrackingMode::STATIC);
+    processor->calculate(3);
+    ASSERT_EQ(HeadTrackingMode::STATIC, processor->getActualMode());
+    EXPECT_TRUE(processor->hasOutputChanged());
+}
+
 }  // namespace
 }  // namespace media
 }  // namespace android
@@ -15,6 +15,8 @@
  */
 #include <inttypes.h>
 
+#include <cmath>
+
 #include <android-base/stringprintf.h>
 #include <audio_utils/SimpleLog.h>
 #include "media/HeadTrackingProcessor.h"
@@ -34,10 +36,20 @@ using android::base::StringAppendF;
 using Eigen::Quaternionf;
 using Eigen::Vector3f;
 
+// Same approximate metric as StillnessDetector: L1 norm of the translation and the cosine of half
+// the rotation angle, with quaternions being equivalent under sign inversion.
+bool areNear(const Pose3f& pose1, const Pose3f& pose2, float translationalThreshold,
+             float cosHalfRotationalThreshold) {
+    return (pose1.translation() - pose2.translation()).lpNorm<1>() <= translationalThreshold &&
+           std::abs(pose1.rotation().dot(pose2.rotation())) >= cosHalfRotationalThreshold;
+}
+
 class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
   public:
     HeadTrackingProcessorImpl(const Options& options, HeadTrackingMode initialMode)
         : mOptions(options),
+          mCosHalfStillRotationalThreshold(std::cos(options.stillRotationalThreshold / 2)),
+          mCosHalfOutputRotationalThreshold(std::cos(options.outputRotationalThreshold / 2)),
           mHeadStillnessDetector(StillnessDetector::Options{
                   .defaultValue = false,
                   .windowDuration = options.autoRecenterWindowDuration,
@@ -56,7 +68,10 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
                   .maxTranslationalVelocity = options.maxTranslationalVelocity,
                   .maxRotationalVelocity = options.maxRotationalVelocity}) {}
 
-    void setDesiredMode(HeadTrackingMode mode) override { mModeSelector.setDesiredMode(mode); }
+    void setDesiredMode(HeadTrackingMode mode) override {
+        mModeSelector.setDesiredMode(mode);
+        mInputChanged = true;
+    }
 
     void setWorldToHeadPose(int64_t timestamp, const Pose3f& worldToHead,
                             const Twist3f& headTwist) override {
@@ -65,6 +80,10 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
         mHeadPoseBias.setInput(predictedWorldToHead);
         mHeadStillnessDetector.setInput(timestamp, predictedWorldToHead);
         mWorldToHeadTimestamp = timestamp;
+        if (isIncremental()) {
+            mInputChanged |= !isNearReference(predictedWorldToHead, mHeadReference);
+            mHeadInput = predictedWorldToHead;
+        }
     }
 
     void setWorldToScreenPose(int64_t timestamp, const Pose3f& worldToScreen) override {
@@ -72,16 +91,22 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
             // We're introducing an artificial discontinuity. Enable the rate limiter.
             mRateLimiter.enable();
             mPhysicalToLogicalAngle = mPendingPhysicalToLogicalAngle;
+            mInputChanged = true;
         }
 
         Pose3f worldToLogicalScreen = worldToScreen * Pose3f(rotateY(-mPhysicalToLogicalAngle));
         mScreenPoseBias.setInput(worldToLogicalScreen);
         mScreenStillnessDetector.setInput(timestamp, worldToLogicalScreen);
         mWorldToScreenTimestamp = timestamp;
+        if (isIncremental()) {
+            mInputChanged |= !isNearReference(worldToLogicalScreen, mScreenReference);
+            mScreenInput = worldToLogicalScreen;
+        }
     }
 
     void setScreenToStagePose(const Pose3f& screenToStage) override {
         mModeSelector.setScreenToStagePose(screenToStage);
+        mInputChanged = true;
     }
 
     void setDisplayOrientation(float physicalToLogicalAngle) override {
@@ -89,6 +114,15 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
     }
 
     void calculate(int64_t timestamp) override {
+        // In incremental mode, keep the previous output while the inputs are still, but recompute
+        // periodically so that staleness and auto-recentering are still detected.
+        if (isIncremental() && !mInputChanged && !mRateLimiter.isLimiting() &&
+            mLastCalculationTimestamp.has_value() &&
+            timestamp - mLastCalculationTimestamp.value() < mOptions.stillRecalculationPeriod) {
+            mOutputChanged = false;
+            return;
+        }
+
         bool screenStable = true;
 
         // Handle the screen first, since it might: trigger a recentering of the head.
@@ -134,12 +168,29 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
         }
         mRateLimiter.setTarget(mModeSelector.getHeadToStagePose());
         mHeadToStagePose = mRateLimiter.calculatePose(timestamp);
+
+        const HeadTrackingMode mode = mModeSelector.getActualMode();
+        mOutputChanged = !mReportedHeadToStagePose.has_value() || mode != mReportedMode ||
+                         !areNear(mHeadToStagePose, mReportedHeadToStagePose.value(),
+                                  mOptions.outputTranslationalThreshold,
+                                  mCosHalfOutputRotationalThreshold);
+        if (mOutputChanged) {
+            mReportedHeadToStagePose = mHeadToStagePose;
+            mReportedMode = mode;
+        }
+
+        mLastCalculationTimestamp = timestamp;
+        mHeadReference = mHeadInput;
+        mScreenReference = mScreenInput;
+        mInputChanged = false;
     }
 
     Pose3f getHeadToStagePose() const override { return mHeadToStagePose; }
 
     HeadTrackingMode getActualMode() const override { return mModeSelector.getActualMode(); }
 
+    bool hasOutputChanged() const override { return mOutputChanged; }
+
     void recenter(bool recenterHead, bool recenterScreen, std::string source) override {
         if (recenterHead) {
             mHeadPoseBias.recenter();
@@ -160,10 +211,12 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
             (recenterScreen && mode == HeadTrackingMode::SCREEN_RELATIVE)) {
             mRateLimiter.enable();
         }
+        mInputChanged = true;
     }
 
     void setPosePredictorType(PosePredictorType type) override {
         mPosePredictor.setPosePredictorType(type);
+        mInputChanged = true;
     }
 
     std::string toString_l(unsigned level) const override {
@@ -189,6 +242,18 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
                       prefixSpace.c_str(), mOptions.screenStillnessTranslationalThreshold);
         StringAppendF(&ss, "%s screenStillnessRotationalThreshold: %f radians\n",
                       prefixSpace.c_str(), mOptions.screenStillnessRotationalThreshold);
+        StringAppendF(&ss, "%s stillRecalculationPeriod: %0.4f ms\n", prefixSpace.c_str(),
+                      media::nsToFloatMs(mOptions.stillRecalculationPeriod));
+        if (isIncremental()) {
+            StringAppendF(&ss, "%s stillTranslationalThreshold: %f meter\n", prefixSpace.c_str(),
+                          mOptions.stillTranslationalThreshold);
+            StringAppendF(&ss, "%s stillRotationalThreshold: %f radians\n", prefixSpace.c_str(),
+                          mOptions.stillRotationalThreshold);
+        }
+        StringAppendF(&ss, "%s outputTranslationalThreshold: %f meter\n", prefixSpace.c_str(),
+                      mOptions.outputTranslationalThreshold);
+        StringAppendF(&ss, "%s outputRotationalThreshold: %f radians\n", prefixSpace.c_str(),
+                      mOptions.outputRotationalThreshold);
         ss += mModeSelector.toString(level + 1);
         ss += mRateLimiter.toString(level + 1);
         ss += mPosePredictor.toString(level + 1);
@@ -198,7 +263,18 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
     }
 
   private:
+    bool isIncremental() const { return mOptions.stillRecalculationPeriod > 0; }
+
+    bool isNearReference(const Pose3f& input, const std::optional<Pose3f>& reference) const {
+        return reference.has_value() &&
+               areNear(input, reference.value(), mOptions.stillTranslationalThreshold,
+                       mCosHalfStillRotationalThreshold);
+    }
+
     const Options mOptions;
+    // Precalculated cos(threshold / 2) for the still and output rotational thresholds.
+    const float mCosHalfStillRotationalThreshold;
+    const float mCosHalfOutputRotationalThreshold;
     float mPhysicalToLogicalAngle = 0;
     // We store the physical to logical angle as "pending" until the next world-to-screen sample it
     // applies to arrives.
@@ -206,6 +282,17 @@ class HeadTrackingProcessorImpl : public HeadTrackingProcessor {
     std::optional<int64_t> mWorldToHeadTimestamp;
     std::optional<int64_t> mWorldToScreenTimestamp;
     Pose3f mHeadToStagePose;
+    // Incremental mode state. The references are the inputs used by the last full calculation.
+    bool mInputChanged = true;
+    std::optional<int64_t> mLastCalculationTimestamp;
+    std::optional<Pose3f> mHeadInput;
+    std::optional<Pose3f> mHeadReference;
+    std::optional<Pose3f> mScreenInput;
+    std::optional<Pose3f> mScreenReference;
+    // Output change tracking, see hasOutputChanged().
+    bool mOutputChanged = false;
+    std::optional<Pose3f> mReportedHeadToStagePose;
+    HeadTrackingMode mReportedMode = HeadTrackingMode::STATIC;
     PoseBias mHeadPoseBias;
     PoseBias mScreenPoseBias;
     StillnessDetector mHeadStillnessDetector;
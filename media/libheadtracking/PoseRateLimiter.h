@@ -77,6 +77,9 @@ class PoseRateLimiter {
 
     Pose3f calculatePose(int64_t timestamp);
 
+    /** Whether the output is still catching up with the target. */
+    bool isLimiting() const { return mLimiting; }
+
     std::string toString(unsigned level) const;
 
   private:
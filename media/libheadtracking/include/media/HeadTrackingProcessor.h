@@ -47,6 +47,22 @@ class HeadTrackingProcessor {
         int64_t screenStillnessWindowDuration = 0;
         float screenStillnessTranslationalThreshold = std::numeric_limits<float>::infinity();
         float screenStillnessRotationalThreshold = std::numeric_limits<float>::infinity();
+        /**
+         * Incremental mode: while no input has moved beyond the still thresholds below since the
+         * last full calculation and no rate limiting is in progress, calculate() only recomputes
+         * the pose graph once per this many ticks and otherwise keeps the previous output.
+         * Should be well below freshnessTimeout, since staleness is only detected on a full
+         * calculation. The special value of 0 disables incremental mode.
+         */
+        int64_t stillRecalculationPeriod = 0;
+        float stillTranslationalThreshold = 0;
+        float stillRotationalThreshold = 0;
+        /**
+         * The output is reported as changed by hasOutputChanged() only if it moved by more than
+         * these since the last time it was reported as changed.
+         */
+        float outputTranslationalThreshold = 0;
+        float outputRotationalThreshold = 0;
     };
 
     /** Sets the desired head-tracking mode. */
@@ -93,6 +109,13 @@ class HeadTrackingProcessor {
      */
     virtual HeadTrackingMode getActualMode() const = 0;
 
+    /**
+     * Whether the last calculate() changed the actual mode, or moved the head-to-stage pose by more
+     * than the output thresholds since the last output that was reported as changed.
+     * Callers may use this to avoid propagating updates that would not be noticeable.
+     */
+    virtual bool hasOutputChanged() const = 0;
+
     /**
      * This causes the current poses for both the head and/or screen to be considered "center".
      */
@@ -305,6 +305,26 @@ bool HeifDecoderImpl::DecodeThread::threadLoop() {
 
 /////////////////////////////////////////////////////////////////////////
 
+struct HeifDecoderImpl::PrefetchThread : public Thread {
+    explicit PrefetchThread(HeifDecoderImpl *decoder) : mDecoder(decoder) {}
+
+private:
+    HeifDecoderImpl* mDecoder;
+
+    bool threadLoop();
+
+    DISALLOW_EVIL_CONSTRUCTORS(PrefetchThread);
+};
+
+bool HeifDecoderImpl::PrefetchThread::threadLoop() {
+    return mDecoder->prefetchNextFrame();
+}
+
+// Number of sequence frames decoded ahead of the client.
+static const size_t kMaxPrefetchedFrames = 2;
+
+/////////////////////////////////////////////////////////////////////////
+
 HeifDecoderImpl::HeifDecoderImpl() :
     // output color format should always be set via setOutputColor(), in case
     // it's not, default to HAL_PIXEL_FORMAT_RGB_565.
@@ -315,13 +335,24 @@ HeifDecoderImpl::HeifDecoderImpl() :
     mHasImage(false),
     mHasVideo(false),
     mSequenceLength(0),
+    mTileWidth(0),
+    mRegion{0, 0, 0, 0},
+    mSampleSize(0),
+    mRegionWidth(0),
     mAvailableLines(0),
     mNumSlices(1),
     mSliceHeight(0),
-    mAsyncDecodeDone(false) {
+    mAsyncDecodeDone(false),
+    mPrefetchStartIndex(0),
+    mNextPrefetchIndex(0),
+    mLastSequenceIndex(-1),
+    mStopPrefetch(false),
+    mPrefetchDone(false),
+    mFrameIsPrefetched(false) {
 }
 
 HeifDecoderImpl::~HeifDecoderImpl() {
+    stopPrefetch();
     if (mThread != nullptr) {
         mThread->join();
     }
@@ -341,6 +372,7 @@ bool HeifDecoderImpl::init(HeifStream* stream, HeifFrameInfo* frameInfo) {
 }
 
 bool HeifDecoderImpl::reinit(HeifFrameInfo* frameInfo) {
+    stopPrefetch();
     mFrameDecoded = false;
     mFrameMemory.clear();
 
@@ -388,6 +420,7 @@ bool HeifDecoderImpl::reinit(HeifFrameInfo* frameInfo) {
                 videoFrame->mBitDepth);
 
         initFrameInfo(&mImageInfo, videoFrame);
+        mTileWidth = videoFrame->mTileWidth;
 
         if (videoFrame->mTileHeight >= 512) {
             // Try decoding in slices only if the image has tiles and is big enough.
@@ -478,6 +511,9 @@ bool HeifDecoderImpl::setOutputColor(HeifColorFormat heifColor) {
         return true;
     }
 
+    // Prefetched frames are in the old color format.
+    stopPrefetch();
+
     switch(heifColor) {
         case kHeifColorFormat_RGB565:
         {
@@ -549,6 +585,14 @@ bool HeifDecoderImpl::decode(HeifFrameInfo* frameInfo) {
         return true;
     }
 
+    stopPrefetch();
+
+    // A region decode releases the retriever without keeping the frame.
+    if (mRetriever == nullptr && !reinit(nullptr)) {
+        return false;
+    }
+    mSampleSize = 0;
+
     // See if we want to decode in slices to allow client to start
     // scanline processing in parallel with decode. If this fails
     // we fallback to decoding the full frame.
@@ -653,12 +697,29 @@ bool HeifDecoderImpl::decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) {
         return false;
     }
 
+    if (mRetriever == nullptr && !reinit(nullptr)) {
+        return false;
+    }
+
     mCurScanline = 0;
+    mSampleSize = 0;
 
     // set total scanline to sequence height now
     mTotalScanline = mSequenceInfo.mHeight;
 
-    mFrameMemory = mRetriever->getFrameAtIndex(frameIndex, mOutputColor);
+    sp<IMemory> frameMemory = takePrefetchedFrame(frameIndex);
+    bool prefetched = (frameMemory != nullptr);
+    if (!prefetched) {
+        frameMemory = mRetriever->getFrameAtIndex(frameIndex, mOutputColor);
+    }
+
+    // The previous frame can hold the next prefetched frame once it's replaced.
+    if (mFrameIsPrefetched) {
+        Mutex::Autolock autolock(mPrefetchLock);
+        mFreeFrames.push_back(mFrameMemory);
+    }
+    mFrameMemory = frameMemory;
+    mFrameIsPrefetched = prefetched;
     if (mFrameMemory == nullptr || mFrameMemory->unsecurePointer() == nullptr) {
         ALOGE("decode: videoFrame is a nullptr");
         return false;
@@ -687,6 +748,237 @@ bool HeifDecoderImpl::decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) {
     if (frameInfo != nullptr) {
         initFrameInfo(frameInfo, videoFrame);
     }
+
+    // Once the client reads two frames in a row it's likely playing the
+    // sequence, start decoding the next frames ahead of it.
+    if (mPrefetchThread == nullptr && mLastSequenceIndex >= 0
+            && frameIndex == mLastSequenceIndex + 1
+            && (size_t)frameIndex + 1 < mSequenceLength) {
+        startPrefetch(frameIndex + 1);
+    }
+    mLastSequenceIndex = frameIndex;
+    return true;
+}
+
+bool HeifDecoderImpl::prefetchNextFrame() {
+    int frameIndex;
+    sp<IMemory> buffer;
+    {
+        Mutex::Autolock autolock(mPrefetchLock);
+        while (!mStopPrefetch && mPrefetchedFrames.size() >= kMaxPrefetchedFrames) {
+            mPrefetchCond.wait(mPrefetchLock);
+        }
+        if (mStopPrefetch || (size_t)mNextPrefetchIndex >= mSequenceLength) {
+            mPrefetchDone = true;
+            mPrefetchCond.broadcast();
+            return false;
+        }
+        frameIndex = mNextPrefetchIndex;
+        if (!mFreeFrames.empty()) {
+            buffer = mFreeFrames.back();
+            mFreeFrames.pop_back();
+        }
+    }
+
+    // The retriever keeps its decoder between consecutive frame indices, so
+    // this continues the codec session instead of seeking.
+    sp<IMemory> frameMemory = mRetriever->getFrameAtIndex(frameIndex, mOutputColor);
+    VideoFrame* videoFrame = nullptr;
+    if (frameMemory != nullptr && frameMemory->unsecurePointer() != nullptr) {
+        videoFrame = static_cast<VideoFrame*>(frameMemory->unsecurePointer());
+        if (videoFrame->mSize == 0 ||
+                frameMemory->size() < videoFrame->getFlattenedSize()) {
+            videoFrame = nullptr;
+        }
+    }
+    if (videoFrame != nullptr) {
+        // The retriever reuses its frame memory for the next frame, so keep a copy.
+        size_t size = videoFrame->getFlattenedSize();
+        if (buffer == nullptr || buffer->size() < size) {
+            sp<MemoryDealer> memoryDealer = new MemoryDealer(size, "HeifSequenceFrame");
+            buffer = memoryDealer->allocate(size);
+        }
+        if (buffer != nullptr && buffer->unsecurePointer() != nullptr) {
+            memcpy(buffer->unsecurePointer(), videoFrame, size);
+        } else {
+            videoFrame = nullptr;
+        }
+    }
+
+    Mutex::Autolock autolock(mPrefetchLock);
+    if (videoFrame == nullptr) {
+        ALOGW("failed to prefetch frame %d", frameIndex);
+        mPrefetchDone = true;
+        mPrefetchCond.broadcast();
+        return false;
+    }
+    ALOGV("prefetched frame %d", frameIndex);
+    mPrefetchedFrames.push_back(buffer);
+    mNextPrefetchIndex++;
+    mPrefetchCond.broadcast();
+    return true;
+}
+
+void HeifDecoderImpl::startPrefetch(int frameIndex) {
+    {
+        Mutex::Autolock autolock(mPrefetchLock);
+        mPrefetchedFrames.clear();
+        mPrefetchStartIndex = mNextPrefetchIndex = frameIndex;
+        mStopPrefetch = false;
+        mPrefetchDone = false;
+    }
+    mPrefetchThread = new PrefetchThread(this);
+    if (mPrefetchThread->run("HeifPrefetch", ANDROID_PRIORITY_FOREGROUND) != OK) {
+        mPrefetchThread.clear();
+    }
+}
+
+void HeifDecoderImpl::stopPrefetch() {
+    if (mPrefetchThread == nullptr) {
+        return;
+    }
+    {
+        Mutex::Autolock autolock(mPrefetchLock);
+        mStopPrefetch = true;
+        mPrefetchCond.broadcast();
+    }
+    mPrefetchThread->requestExitAndWait();
+    mPrefetchThread.clear();
+
+    Mutex::Autolock autolock(mPrefetchLock);
+    mPrefetchedFrames.clear();
+    mFreeFrames.clear();
+    mFrameIsPrefetched = false;
+}
+
+sp<IMemory> HeifDecoderImpl::takePrefetchedFrame(int frameIndex) {
+    if (mPrefetchThread == nullptr) {
+        return nullptr;
+    }
+    {
+        Mutex::Autolock autolock(mPrefetchLock);
+        if (frameIndex >= mPrefetchStartIndex && frameIndex <= mNextPrefetchIndex) {
+            // Drop the frames the client skipped.
+            while (!mPrefetchedFrames.empty() && mPrefetchStartIndex < frameIndex) {
+                mFreeFrames.push_back(mPrefetchedFrames.front());
+                mPrefetchedFrames.pop_front();
+                mPrefetchStartIndex++;
+                mPrefetchCond.broadcast();
+            }
+            while (mPrefetchedFrames.empty() && !mPrefetchDone) {
+                mPrefetchCond.wait(mPrefetchLock);
+            }
+            if (!mPrefetchedFrames.empty()) {
+                sp<IMemory> frameMemory = mPrefetchedFrames.front();
+                mPrefetchedFrames.pop_front();
+                mPrefetchStartIndex++;
+                mPrefetchCond.broadcast();
+                return frameMemory;
+            }
+        }
+    }
+    // Not a frame ahead of the client, decode it directly after the
+    // prefetch stopped using the retriever.
+    stopPrefetch();
+    return nullptr;
+}
+
+bool HeifDecoderImpl::decodeRegion(
+        const HeifRect& region, uint32_t sampleSize, HeifFrameInfo* frameInfo) {
+    ALOGV("%s: region {%d, %d, %d, %d}, sample size %u", __FUNCTION__,
+            region.mLeft, region.mTop, region.mRight, region.mBottom, sampleSize);
+    if (!mHasImage) {
+        return false;
+    }
+
+    if (sampleSize == 0 || region.mLeft < 0 || region.mTop < 0
+            || region.mLeft >= region.mRight || region.mTop >= region.mBottom
+            || (uint32_t)region.mRight > mImageInfo.mWidth
+            || (uint32_t)region.mBottom > mImageInfo.mHeight) {
+        ALOGE("invalid region {%d, %d, %d, %d} or sample size %u",
+                region.mLeft, region.mTop, region.mRight, region.mBottom, sampleSize);
+        return false;
+    }
+
+    // Wait for a slice decode or a prefetch that may still be using the retriever.
+    stopPrefetch();
+    if (mThread != nullptr) {
+        mThread->join();
+        mThread.clear();
+    }
+    mNumSlices = 1;
+    mAvailableLines = 0;
+    mAsyncDecodeDone = false;
+
+    // The retriever is released after a decode, and a retriever that decoded
+    // slices can't go back to the tiles of the region.
+    if ((mFrameDecoded || mRetriever == nullptr) && !reinit(nullptr)) {
+        return false;
+    }
+
+    sp<IMemory> frameMemory;
+    if (sampleSize > 1) {
+        // Use the thumbnail if it has at least one pixel for every
+        // |sampleSize| pixels of the primary picture.
+        sp<IMemory> thumbnailMeta = mRetriever->getImageAtIndex(
+                -1, mOutputColor, true /*metaOnly*/, true /*thumbnail*/);
+        if (thumbnailMeta != nullptr && thumbnailMeta->unsecurePointer() != nullptr) {
+            VideoFrame* thumbnail = static_cast<VideoFrame*>(thumbnailMeta->unsecurePointer());
+            if ((uint64_t)thumbnail->mWidth * sampleSize >= mImageInfo.mWidth
+                    && (uint64_t)thumbnail->mHeight * sampleSize >= mImageInfo.mHeight) {
+                ALOGV("decodeRegion: using %ux%u thumbnail",
+                        thumbnail->mWidth, thumbnail->mHeight);
+                frameMemory = mRetriever->getImageAtIndex(
+                        -1, mOutputColor, false /*metaOnly*/, true /*thumbnail*/);
+            }
+        }
+    }
+    if (frameMemory == nullptr) {
+        if (mTileWidth > 0) {
+            // Only the tiles intersecting the region are decoded.
+            frameMemory = mRetriever->getImageRectAtIndex(-1, mOutputColor,
+                    region.mLeft, region.mTop, region.mRight, region.mBottom);
+        } else {
+            frameMemory = mRetriever->getImageAtIndex(-1, mOutputColor);
+        }
+    }
+
+    if (frameMemory == nullptr || frameMemory->unsecurePointer() == nullptr) {
+        ALOGE("decodeRegion: videoFrame is a nullptr");
+        return false;
+    }
+
+    // TODO: Using unsecurePointer() has some associated security pitfalls
+    //       (see declaration for details).
+    //       Either document why it is safe in this case or address the
+    //       issue (e.g. by copying).
+    VideoFrame* videoFrame = static_cast<VideoFrame*>(frameMemory->unsecurePointer());
+    if (videoFrame->mSize == 0 ||
+            frameMemory->size() < videoFrame->getFlattenedSize()) {
+        ALOGE("decodeRegion: videoFrame size is invalid");
+        return false;
+    }
+
+    const uint32_t width = (region.mRight - region.mLeft + sampleSize - 1) / sampleSize;
+    const uint32_t height = (region.mBottom - region.mTop + sampleSize - 1) / sampleSize;
+    ALOGV("Decoded dimension %dx%d, output %ux%u",
+            videoFrame->mWidth, videoFrame->mHeight, width, height);
+
+    if (frameInfo != nullptr) {
+        initFrameInfo(frameInfo, videoFrame);
+        frameInfo->mWidth = width;
+        frameInfo->mHeight = height;
+    }
+    mFrameMemory = frameMemory;
+    mRegion = region;
+    mSampleSize = sampleSize;
+    mRegionWidth = width;
+    mCurScanline = 0;
+    mTotalScanline = height;
+
+    // The frame only covers the region, so a following decode() starts over.
+    mFrameDecoded = false;
+    mRetriever.clear();
     return true;
 }
 
@@ -699,6 +991,24 @@ bool HeifDecoderImpl::getScanlineInner(uint8_t* dst) {
     //       Either document why it is safe in this case or address the
     //       issue (e.g. by copying).
     VideoFrame* videoFrame = static_cast<VideoFrame*>(mFrameMemory->unsecurePointer());
+    if (mSampleSize > 0) {
+        // The frame is either the primary picture or the thumbnail, map the
+        // sampled region onto it.
+        const uint32_t bpp = videoFrame->mBytesPerPixel;
+        const uint64_t y = (uint64_t)(mRegion.mTop + mCurScanline++ * mSampleSize)
+                * videoFrame->mHeight / mImageInfo.mHeight;
+        const uint8_t* src = videoFrame->getFlattenedData() + videoFrame->mRowBytes * y;
+        if (mSampleSize == 1) {
+            memcpy(dst, src + mRegion.mLeft * bpp, mRegionWidth * bpp);
+            return true;
+        }
+        for (uint32_t x = 0; x < mRegionWidth; x++) {
+            const uint64_t srcX = (uint64_t)(mRegion.mLeft + x * mSampleSize)
+                    * videoFrame->mWidth / mImageInfo.mWidth;
+            memcpy(dst + x * bpp, src + srcX * bpp, bpp);
+        }
+        return true;
+    }
     uint8_t* src = videoFrame->getFlattenedData() + videoFrame->mRowBytes * mCurScanline++;
     memcpy(dst, src, videoFrame->mBytesPerPixel * videoFrame->mWidth);
     return true;
@@ -18,6 +18,8 @@
 #define _HEIF_DECODER_IMPL_
 
 #include "include/HeifDecoderAPI.h"
+#include <deque>
+#include <vector>
 #include <system/graphics.h>
 #include <utils/Condition.h>
 #include <utils/Mutex.h>
@@ -50,6 +52,9 @@ public:
 
     bool decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) override;
 
+    bool decodeRegion(const HeifRect& region, uint32_t sampleSize,
+            HeifFrameInfo* frameInfo) override;
+
     bool getScanline(uint8_t* dst) override;
 
     size_t skipScanlines(size_t count) override;
@@ -58,6 +63,7 @@ public:
 
 private:
     struct DecodeThread;
+    struct PrefetchThread;
 
     sp<IDataSource> mDataSource;
     sp<MediaMetadataRetriever> mRetriever;
@@ -71,6 +77,12 @@ private:
     bool mHasImage;
     bool mHasVideo;
     size_t mSequenceLength;
+    uint32_t mTileWidth;
+
+    // Region decoding only, mSampleSize is 0 otherwise
+    HeifRect mRegion;
+    uint32_t mSampleSize;
+    uint32_t mRegionWidth;
 
     // Slice decoding only
     Mutex mLock;
@@ -81,7 +93,24 @@ private:
     uint32_t mSliceHeight;
     bool mAsyncDecodeDone;
 
+    // Sequence prefetching only
+    Mutex mPrefetchLock;
+    Condition mPrefetchCond;
+    sp<PrefetchThread> mPrefetchThread;
+    std::deque<sp<IMemory>> mPrefetchedFrames;
+    std::vector<sp<IMemory>> mFreeFrames;
+    int mPrefetchStartIndex;
+    int mNextPrefetchIndex;
+    int mLastSequenceIndex;
+    bool mStopPrefetch;
+    bool mPrefetchDone;
+    bool mFrameIsPrefetched;
+
     bool decodeAsync();
+    bool prefetchNextFrame();
+    void startPrefetch(int frameIndex);
+    void stopPrefetch();
+    sp<IMemory> takePrefetchedFrame(int frameIndex);
     bool getScanlineInner(uint8_t* dst);
     bool reinit(HeifFrameInfo* frameInfo);
 };
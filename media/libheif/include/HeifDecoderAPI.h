@@ -51,6 +51,17 @@ struct HeifFrameInfo {
     std::vector<uint8_t> mIccData;     // ICC data array
 };
 
+/*
+ * A region of the picture in pixels, before rotation. |right| and |bottom|
+ * are exclusive.
+ */
+struct HeifRect {
+    int32_t mLeft;
+    int32_t mTop;
+    int32_t mRight;
+    int32_t mBottom;
+};
+
 /*
  * Abstract interface to provide data to HeifDecoder.
  */
@@ -151,6 +162,21 @@ struct HeifDecoder {
      */
     virtual bool decodeSequence(int frameIndex, HeifFrameInfo* frameInfo) = 0;
 
+    /*
+     * Decode the part of the primary picture inside |region|, keeping one in
+     * every |sampleSize| pixels in both directions, returning whether it
+     * succeeded. |frameInfo| will be filled with information of the output,
+     * which is |region| divided by |sampleSize| and rounded up, upon success
+     * and unmodified upon failure.
+     *
+     * After this succeeded, getScanline can be called to read the scanlines
+     * of the output.
+     */
+    virtual bool decodeRegion(const HeifRect& /*region*/, uint32_t /*sampleSize*/,
+            HeifFrameInfo* /*frameInfo*/) {
+        return false;
+    }
+
     /*
      * Read the next scanline (in top-down order), returns true upon success
      * and false otherwise.
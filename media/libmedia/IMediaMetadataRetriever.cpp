@@ -74,8 +74,12 @@ enum {
     GET_FRAME_AT_INDEX,
     EXTRACT_ALBUM_ART,
     EXTRACT_METADATA,
+    GET_FRAMES_AT_TIME,
 };
 
+// Upper bound for the number of frames extracted by one getFramesAtTime() call.
+static const size_t kMaxFramesPerBatch = 256;
+
 class BpMediaMetadataRetriever: public BpInterface<IMediaMetadataRetriever>
 {
 public:
@@ -234,6 +238,46 @@ public:
         return interface_cast<IMemory>(reply.readStrongBinder());
     }
 
+    status_t getFramesAtTime(
+            const std::vector<int64_t>& timesUs, int option, int colorFormat,
+            int32_t width, int32_t height, std::vector<sp<IMemory>>* frames)
+    {
+        ALOGV("getFramesAtTime: %zu times, option(%d), colorFormat(%d) size(%dx%d)",
+                timesUs.size(), option, colorFormat, width, height);
+        Parcel data, reply;
+        data.writeInterfaceToken(IMediaMetadataRetriever::getInterfaceDescriptor());
+        data.writeInt64Vector(timesUs);
+        data.writeInt32(option);
+        data.writeInt32(colorFormat);
+        data.writeInt32(width);
+        data.writeInt32(height);
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+        sendSchedPolicy(data);
+#endif
+        frames->clear();
+        status_t ret = remote()->transact(GET_FRAMES_AT_TIME, data, &reply);
+        if (ret != NO_ERROR) {
+            return ret;
+        }
+        ret = reply.readInt32();
+        if (ret != NO_ERROR) {
+            return ret;
+        }
+        int32_t count = reply.readInt32();
+        if (count < 0 || (size_t)count != timesUs.size()) {
+            return BAD_VALUE;
+        }
+        for (int32_t i = 0; i < count; ++i) {
+            sp<IMemory> frame = interface_cast<IMemory>(reply.readStrongBinder());
+            if (frame == nullptr) {
+                frames->clear();
+                return BAD_VALUE;
+            }
+            frames->push_back(frame);
+        }
+        return NO_ERROR;
+    }
+
     sp<IMemory> extractAlbumArt()
     {
         Parcel data, reply;
@@ -451,6 +495,39 @@ status_t BnMediaMetadataRetriever::onTransact(
             }
 #ifndef DISABLE_GROUP_SCHEDULE_HACK
             restoreSchedPolicy();
+#endif
+            return NO_ERROR;
+        } break;
+        case GET_FRAMES_AT_TIME: {
+            CHECK_INTERFACE(IMediaMetadataRetriever, data, reply);
+            std::vector<int64_t> timesUs;
+            if (data.readInt64Vector(&timesUs) != NO_ERROR
+                    || timesUs.size() > kMaxFramesPerBatch) {
+                reply->writeInt32(BAD_VALUE);
+                return NO_ERROR;
+            }
+            int option = data.readInt32();
+            int colorFormat = data.readInt32();
+            int32_t width = data.readInt32();
+            int32_t height = data.readInt32();
+            ALOGV("getFramesAtTime: %zu times, option(%d), colorFormat(%d) size(%dx%d)",
+                    timesUs.size(), option, colorFormat, width, height);
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+            setSchedPolicy(data);
+#endif
+            std::vector<sp<IMemory>> frames;
+            status_t ret = getFramesAtTime(timesUs, option, colorFormat, width, height, &frames);
+            if (ret == NO_ERROR && frames.size() == timesUs.size()) {
+                reply->writeInt32(NO_ERROR);
+                reply->writeInt32(frames.size());
+                for (const sp<IMemory>& frame : frames) {
+                    reply->writeStrongBinder(IInterface::asBinder(frame));
+                }
+            } else {
+                reply->writeInt32(ret != NO_ERROR ? ret : UNKNOWN_ERROR);
+            }
+#ifndef DISABLE_GROUP_SCHEDULE_HACK
+            restoreSchedPolicy();
 #endif
             return NO_ERROR;
         } break;
@@ -364,13 +364,23 @@ status_t BnMediaSource::onTransact(
                 MediaBuffer *transferBuf = nullptr;
                 const size_t length = buf->range_length();
                 size_t offset = buf->range_offset();
+                //
+                // A source without nonblocking read support may block in read() while the
+                // client holds its buffers, so its own shared buffer can only be handed out
+                // as the last one of a batch. Earlier buffers of the batch are copied into
+                // our shared group instead, which releases the source buffer right away and
+                // lets the whole batch go out in a single transaction.
+                const bool batchContinues = bufferCount + 1 < maxNumBuffers;
                 if (length >= (supportNonblockingRead() && buf->mMemory != nullptr ?
                         kTransferSharedAsSharedThreshold : kTransferInlineAsSharedThreshold)) {
-                    if (buf->mMemory != nullptr) {
+                    if (buf->mMemory != nullptr
+                            && (supportNonblockingRead() || !batchContinues
+                                    || !mGroup->has_buffers())) {
                         ALOGV("Use shared memory: %zu", length);
                         transferBuf = buf;
                     } else {
-                        ALOGV("Large buffer %zu without IMemory!", length);
+                        ALOGV("Large buffer %zu %s", length, buf->mMemory != nullptr
+                                ? "copied to continue batch" : "without IMemory!");
                         ret = mGroup->acquire_buffer(
                                 (MediaBufferBase **)&transferBuf, false /* nonBlocking */, length);
                         if (ret != OK
@@ -19,7 +19,9 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "MediaProfiles"
 
+#include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 #include <utils/misc.h>
 #include <utils/Log.h>
 #include <utils/Vector.h>
@@ -29,7 +31,10 @@
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/MediaCodecConstants.h>
 #include <OMX_Video.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <array>
 #include <string>
@@ -78,6 +83,62 @@ std::array<char const*, 5> const& getXmlPaths() {
     return cPaths;
 }
 
+// Binary cache of a parsed media_profiles XML file. The cache records the size and
+// modification time of the file it was made from, and is ignored once either changes.
+// The payload is a flat sequence of int32_t, see MediaProfiles::encodeCache().
+constexpr uint32_t kCacheMagic = 0x4d505243;  // 'MPRC'
+constexpr uint32_t kCacheVersion = 1;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    int64_t xmlSize;
+    int64_t xmlMtimeSec;
+    int64_t xmlMtimeNsec;
+    uint32_t words;     // payload size in int32_t
+    uint32_t checksum;  // of the payload
+};
+
+uint32_t getCacheChecksum(const int32_t *words, size_t nWords) {
+    // FNV-1a
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(words);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < nWords * sizeof(int32_t); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Returns the cache file for the xml file, or an empty string if caching is disabled.
+// The cache directory is set per device, as it must be readable by every process that
+// uses MediaProfiles; those that cannot read it parse the xml file as before.
+std::string getCacheFilePath(const char *xml) {
+    char dir[PROPERTY_VALUE_MAX];
+    property_get("media.settings.xml.cache_dir", dir, "");
+    if (dir[0] == '\0') {
+        return "";
+    }
+    std::string name = xml;
+    for (char &c : name) {
+        if (c == '/') c = '_';
+    }
+    return std::string(dir) + "/" + name + ".cache";
+}
+
+// Fills in the header fields that identify the xml file.
+bool getCacheHeaderForXml(const char *xml, CacheHeader *header) {
+    struct stat xmlStat;
+    if (stat(xml, &xmlStat) != 0) {
+        return false;
+    }
+    header->magic = kCacheMagic;
+    header->version = kCacheVersion;
+    header->xmlSize = xmlStat.st_size;
+    header->xmlMtimeSec = xmlStat.st_mtim.tv_sec;
+    header->xmlMtimeNsec = xmlStat.st_mtim.tv_nsec;
+    return true;
+}
+
 } // unnamed namespace
 
 Mutex MediaProfiles::sLock;
@@ -1266,6 +1327,19 @@ bool MediaProfiles::checkXmlFile(const char* xmlFile) {
 
 /*static*/ MediaProfiles*
 MediaProfiles::createInstanceFromXmlFile(const char *xml)
+{
+    MediaProfiles *profiles = createInstanceFromCacheFile(xml);
+    if (profiles == NULL) {
+        profiles = parseXmlFile(xml);
+        if (profiles != NULL) {
+            profiles->writeCacheFile(xml);
+        }
+    }
+    return profiles;
+}
+
+/*static*/ MediaProfiles*
+MediaProfiles::parseXmlFile(const char *xml)
 {
     FILE *fp = NULL;
     CHECK((fp = fopen(xml, "r")));
@@ -1317,6 +1391,281 @@ exit:
     return profiles;
 }
 
+void MediaProfiles::encodeCache(std::vector<int32_t> *words) const
+{
+    words->push_back(mCamcorderProfiles.size());
+    for (size_t i = 0; i < mCamcorderProfiles.size(); ++i) {
+        const CamcorderProfile *profile = mCamcorderProfiles[i];
+        words->insert(words->end(), {profile->mCameraId, profile->mFileFormat,
+                                     profile->mQuality, profile->mDuration});
+        words->push_back(profile->mVideoCodecs.size());
+        for (const VideoCodec &vc : profile->mVideoCodecs) {
+            words->insert(words->end(), {vc.mCodec, vc.mBitRate, vc.mFrameWidth,
+                                         vc.mFrameHeight, vc.mFrameRate, vc.mProfile,
+                                         vc.mChromaSubsampling, vc.mBitDepth, vc.mHdrFormat});
+        }
+        words->push_back(profile->mAudioCodecs.size());
+        for (const AudioCodec &ac : profile->mAudioCodecs) {
+            words->insert(words->end(), {ac.mCodec, ac.mBitRate, ac.mSampleRate,
+                                         ac.mChannels, ac.mProfile});
+        }
+    }
+
+    words->push_back(mVideoEncoders.size());
+    for (size_t i = 0; i < mVideoEncoders.size(); ++i) {
+        const VideoEncoderCap *cap = mVideoEncoders[i];
+        words->insert(words->end(), {cap->mCodec, cap->mMinBitRate, cap->mMaxBitRate,
+                                     cap->mMinFrameWidth, cap->mMaxFrameWidth,
+                                     cap->mMinFrameHeight, cap->mMaxFrameHeight,
+                                     cap->mMinFrameRate, cap->mMaxFrameRate});
+    }
+    words->push_back(mAudioEncoders.size());
+    for (size_t i = 0; i < mAudioEncoders.size(); ++i) {
+        const AudioEncoderCap *cap = mAudioEncoders[i];
+        words->insert(words->end(), {cap->mCodec, cap->mMinBitRate, cap->mMaxBitRate,
+                                     cap->mMinSampleRate, cap->mMaxSampleRate,
+                                     cap->mMinChannels, cap->mMaxChannels});
+    }
+    words->push_back(mVideoDecoders.size());
+    for (size_t i = 0; i < mVideoDecoders.size(); ++i) {
+        words->push_back(mVideoDecoders[i]->mCodec);
+    }
+    words->push_back(mAudioDecoders.size());
+    for (size_t i = 0; i < mAudioDecoders.size(); ++i) {
+        words->push_back(mAudioDecoders[i]->mCodec);
+    }
+    words->push_back(mEncoderOutputFileFormats.size());
+    for (size_t i = 0; i < mEncoderOutputFileFormats.size(); ++i) {
+        words->push_back(mEncoderOutputFileFormats[i]);
+    }
+
+    words->push_back(mImageEncodingQualityLevels.size());
+    for (size_t i = 0; i < mImageEncodingQualityLevels.size(); ++i) {
+        const ImageEncodingQualityLevels *levels = mImageEncodingQualityLevels[i];
+        words->push_back(levels->mCameraId);
+        words->push_back(levels->mLevels.size());
+        for (size_t j = 0; j < levels->mLevels.size(); ++j) {
+            words->push_back(levels->mLevels[j]);
+        }
+    }
+    words->push_back(mStartTimeOffsets.size());
+    for (size_t i = 0; i < mStartTimeOffsets.size(); ++i) {
+        words->push_back(mStartTimeOffsets.keyAt(i));
+        words->push_back(mStartTimeOffsets.valueAt(i));
+    }
+    words->push_back(mCameraIds.size());
+    for (size_t i = 0; i < mCameraIds.size(); ++i) {
+        words->push_back(mCameraIds[i]);
+    }
+}
+
+/*static*/ bool
+MediaProfiles::decodeCache(const int32_t *words, size_t nWords, MediaProfiles *profiles)
+{
+    size_t pos = 0;
+    // reads the next n words into v
+    auto next = [&](int32_t *v, size_t n) -> bool {
+        if (n > nWords - pos) {
+            return false;
+        }
+        memcpy(v, &words[pos], n * sizeof(int32_t));
+        pos += n;
+        return true;
+    };
+    // reads a count of items that each take at least minWords
+    auto nextCount = [&](int32_t *count, size_t minWords) -> bool {
+        return next(count, 1) && *count >= 0
+                && (size_t)*count * minWords <= nWords - pos;
+    };
+
+    int32_t n, m;
+    int32_t v[9];
+    if (!nextCount(&n, 6)) return false;
+    for (int32_t i = 0; i < n; ++i) {
+        if (!next(v, 4)) return false;
+        CamcorderProfile *profile = NULL;
+        if (profiles != NULL) {
+            profile = new CamcorderProfile;
+            profile->mCameraId = v[0];
+            profile->mFileFormat = static_cast<output_format>(v[1]);
+            profile->mQuality = static_cast<camcorder_quality>(v[2]);
+            profile->mDuration = v[3];
+            profiles->mCamcorderProfiles.add(profile);
+        }
+        if (!nextCount(&m, 9)) return false;
+        for (int32_t j = 0; j < m; ++j) {
+            if (!next(v, 9)) return false;
+            if (profile != NULL) {
+                profile->mVideoCodecs.emplace_back(
+                        static_cast<video_encoder>(v[0]), v[1], v[2], v[3], v[4], v[5],
+                        static_cast<chroma_subsampling>(v[6]), v[7],
+                        static_cast<hdr_format>(v[8]));
+            }
+        }
+        if (!nextCount(&m, 5)) return false;
+        for (int32_t j = 0; j < m; ++j) {
+            if (!next(v, 5)) return false;
+            if (profile != NULL) {
+                profile->mAudioCodecs.emplace_back(
+                        static_cast<audio_encoder>(v[0]), v[1], v[2], v[3], v[4]);
+            }
+        }
+    }
+
+    if (!nextCount(&n, 9)) return false;
+    for (int32_t i = 0; i < n; ++i) {
+        if (!next(v, 9)) return false;
+        if (profiles != NULL) {
+            profiles->mVideoEncoders.add(new VideoEncoderCap(
+                    static_cast<video_encoder>(v[0]), v[1], v[2], v[3], v[4], v[5], v[6],
+                    v[7], v[8]));
+        }
+    }
+    if (!nextCount(&n, 7)) return false;
+    for (int32_t i = 0; i < n; ++i) {
+        if (!next(v, 7)) return false;
+        if (profiles != NULL) {
+            profiles->mAudioEncoders.add(new AudioEncoderCap(
+                    static_cast<audio_encoder>(v[0]), v[1], v[2], v[3], v[4], v[5], v[6]));
+        }
+    }
+    if (!nextCount(&n, 1)) return false;
+    for (int32_t i = 0; i < n; ++i) {
+        if (!next(v, 1)) return false;
+        if (profiles != NULL) {
+            profiles->mVideoDecoders.add(
+                    new VideoDecoderCap(static_cast<video_decoder>(v[0])));
+        }
+    }
+    if (!nextCount(&n, 1)) return false;
+    for (int32_t i = 0; i < n; ++i) {
+        if (!next(v, 1)) return false;
+        if (profiles != NULL) {
+            profiles->mAudioDecoders.add(
+                    new AudioDecoderCap(static_cast<audio_decoder>(v[0])));
+        }
+    }
+    if (!nextCount(&n, 1)) return false;
+    for (int32_t i = 0; i < n; ++i) {
+        if (!next(v, 1)) return false;
+        if (profiles != NULL) {
+            profiles->mEncoderOutputFileFormats.add(static_cast<output_format>(v[0]));
+        }
+    }
+
+    if (!nextCount(&n, 2)) return false;
+    for (int32_t i = 0; i < n; ++i) {
+        if (!next(v, 1) || !nextCount(&m, 1)) return false;
+        ImageEncodingQualityLevels *levels = NULL;
+        if (profiles != NULL) {
+            levels = new ImageEncodingQualityLevels();
+            levels->mCameraId = v[0];
+            profiles->mImageEncodingQualityLevels.add(levels);
+        }
+        for (int32_t j = 0; j < m; ++j) {
+            if (!next(v, 1)) return false;
+            if (levels != NULL) {
+                levels->mLevels.add(v[0]);
+            }
+        }
+    }
+    if (!nextCount(&n, 2)) return false;
+    for (int32_t i = 0; i < n; ++i) {
+        if (!next(v, 2)) return false;
+        if (profiles != NULL) {
+            profiles->mStartTimeOffsets.replaceValueFor(v[0], v[1]);
+        }
+    }
+    if (!nextCount(&n, 1)) return false;
+    for (int32_t i = 0; i < n; ++i) {
+        if (!next(v, 1)) return false;
+        if (profiles != NULL) {
+            profiles->mCameraIds.add(v[0]);
+        }
+    }
+
+    return pos == nWords;
+}
+
+/*static*/ MediaProfiles*
+MediaProfiles::createInstanceFromCacheFile(const char *xml)
+{
+    std::string cache = getCacheFilePath(xml);
+    CacheHeader expected;
+    if (cache.empty() || !getCacheHeaderForXml(xml, &expected)) {
+        return NULL;
+    }
+
+    int fd = open(cache.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ALOGV("no cache %s for %s", cache.c_str(), xml);
+        return NULL;
+    }
+    struct stat cacheStat;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &cacheStat) == 0 && cacheStat.st_size >= (off_t)sizeof(CacheHeader)) {
+        data = mmap(NULL, cacheStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+
+    MediaProfiles *profiles = NULL;
+    const CacheHeader *header = static_cast<const CacheHeader *>(data);
+    const int32_t *words = reinterpret_cast<const int32_t *>(header + 1);
+    size_t nWords = (cacheStat.st_size - sizeof(CacheHeader)) / sizeof(int32_t);
+    if (header->magic != expected.magic || header->version != expected.version
+            || header->xmlSize != expected.xmlSize
+            || header->xmlMtimeSec != expected.xmlMtimeSec
+            || header->xmlMtimeNsec != expected.xmlMtimeNsec) {
+        ALOGI("cache %s is out of date for %s", cache.c_str(), xml);
+    } else if (header->words != nWords
+            || header->checksum != getCacheChecksum(words, nWords)
+            || !decodeCache(words, nWords, NULL /* profiles */)) {
+        ALOGW("cache %s is corrupt", cache.c_str());
+    } else {
+        // checked above, so this cannot fail part way through
+        profiles = new MediaProfiles();
+        CHECK(decodeCache(words, nWords, profiles));
+        ALOGV("loaded %s from cache %s", xml, cache.c_str());
+    }
+    munmap(data, cacheStat.st_size);
+    return profiles;
+}
+
+void MediaProfiles::writeCacheFile(const char *xml) const
+{
+    std::string cache = getCacheFilePath(xml);
+    CacheHeader header;
+    if (cache.empty() || !getCacheHeaderForXml(xml, &header)) {
+        return;
+    }
+
+    std::vector<int32_t> words;
+    encodeCache(&words);
+    header.words = words.size();
+    header.checksum = getCacheChecksum(words.data(), words.size());
+
+    // write it aside and rename into place, so readers never see a partial cache
+    std::string temp = cache + "." + std::to_string(getpid());
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ALOGV("cannot create cache %s: %s", temp.c_str(), strerror(errno));
+        return;
+    }
+    size_t bytes = words.size() * sizeof(int32_t);
+    bool ok = write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header)
+            && write(fd, words.data(), bytes) == (ssize_t)bytes;
+    close(fd);
+    if (!ok || rename(temp.c_str(), cache.c_str()) != 0) {
+        ALOGW("failed to write cache %s: %s", cache.c_str(), strerror(errno));
+        unlink(temp.c_str());
+        return;
+    }
+    ALOGV("wrote cache %s for %s", cache.c_str(), xml);
+}
+
 Vector<output_format> MediaProfiles::getOutputFileFormats() const
 {
     return mEncoderOutputFileFormats;  // copy out
@@ -51,6 +51,11 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom) = 0;
     virtual sp<IMemory> getFrameAtIndex(
             int frameIndex, int colorFormat, bool metaOnly) = 0;
+    virtual status_t getFramesAtTime(
+            const std::vector<int64_t>& /*timesUs*/, int /*option*/, int /*colorFormat*/,
+            int32_t /*width*/, int32_t /*height*/, std::vector<sp<IMemory>>* /*frames*/) {
+        return ERROR_UNSUPPORTED;
+    }
     virtual MediaAlbumArt* extractAlbumArt() = 0;
     virtual const char* extractMetadata(int keyCode) = 0;
 };
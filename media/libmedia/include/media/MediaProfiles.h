@@ -510,8 +510,17 @@ private:
     static bool checkXmlFile(const char* xmlFile);
 
     // If the xml configuration file does exist, use the settings
-    // from the xml
+    // from the xml, or from its binary cache if that is still current
     static MediaProfiles* createInstanceFromXmlFile(const char *xml);
+    static MediaProfiles* parseXmlFile(const char *xml);
+
+    // Binary cache of the parsed xml file, so that other processes can skip the parse.
+    // Returns NULL if there is no cache for xml or it is out of date.
+    static MediaProfiles* createInstanceFromCacheFile(const char *xml);
+    void writeCacheFile(const char *xml) const;
+    void encodeCache(std::vector<int32_t> *words) const;
+    // Decodes words into profiles; with a NULL profiles, only checks that words decode.
+    static bool decodeCache(const int32_t *words, size_t nWords, MediaProfiles *profiles);
     static output_format createEncoderOutputFileFormat(const char **atts, size_t natts);
     static void createVideoCodec(const char **atts, size_t natts, MediaProfiles *profiles);
     static void createAudioCodec(const char **atts, size_t natts, MediaProfiles *profiles);
@@ -103,6 +103,12 @@ public:
             int index, int colorFormat, int left, int top, int right, int bottom);
     sp<IMemory>  getFrameAtIndex(
             int index, int colorFormat = HAL_PIXEL_FORMAT_RGB_565, bool metaOnly = false);
+    // Extracts the frames at the ascending |timesUs| with one decoder, each
+    // scaled to |width| x |height| unless either is 0. With option
+    // SEEK_FRAME_INDEX the times are frame indices.
+    status_t getFramesAtTime(const std::vector<int64_t>& timesUs, int option,
+            int colorFormat, int32_t width, int32_t height,
+            std::vector<sp<IMemory>>* frames);
     sp<IMemory> extractAlbumArt();
     const char* extractMetadata(int keyCode);
 
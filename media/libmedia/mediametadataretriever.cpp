@@ -191,6 +191,19 @@ sp<IMemory>  MediaMetadataRetriever::getFrameAtIndex(
     return mRetriever->getFrameAtIndex(index, colorFormat, metaOnly);
 }
 
+status_t MediaMetadataRetriever::getFramesAtTime(
+        const std::vector<int64_t>& timesUs, int option, int colorFormat,
+        int32_t width, int32_t height, std::vector<sp<IMemory>>* frames) {
+    ALOGV("getFramesAtTime: %zu times, option(%d), colorFormat(%d) size(%dx%d)",
+            timesUs.size(), option, colorFormat, width, height);
+    Mutex::Autolock _l(mLock);
+    if (mRetriever == 0) {
+        ALOGE("retriever is not initialized");
+        return INVALID_OPERATION;
+    }
+    return mRetriever->getFramesAtTime(timesUs, option, colorFormat, width, height, frames);
+}
+
 const char* MediaMetadataRetriever::extractMetadata(int keyCode)
 {
     ALOGV("extractMetadata(%d)", keyCode);
@@ -68,6 +68,24 @@ int shapeFormat(shaperHandle_t shaper, AMediaFormat* inFormat, int flags) {
     return 0;
 }
 
+int shapeFeedback(shaperHandle_t shaper, AMediaFormat* shapedFormat, AMediaFormat* stats,
+                  AMediaFormat* updates, int flags) {
+    CodecProperties *codec = (CodecProperties*) shaper;
+    if (codec == nullptr) {
+        return -1;
+    }
+    if (!codec->isRegistered()) {
+        return -1;
+    }
+
+    std::string mediaType = codec->getMediaType();
+    if (strncmp(mediaType.c_str(), "video/", 6) == 0) {
+        (void) videoShaperFeedback(codec, shapedFormat, stats, updates, flags);
+    }
+
+    return 0;
+}
+
 int setMap(shaperHandle_t shaper,  const char *kind, const char *key, const char *value) {
     ALOGV("setMap: kind %s key %s -> value %s", kind, key, value);
     CodecProperties *codec = (CodecProperties*) shaper;
@@ -183,7 +201,7 @@ const char **getReverseMappings(shaperHandle_t shaper, const char *kind) {
 // the system grabs this structure
 __attribute__ ((visibility ("default")))
 extern "C" FormatShaperOps_t shaper_ops = {
-    .version = SHAPER_VERSION_V1,
+    .version = SHAPER_VERSION_V2,
 
     .findShaper = findShaper,
     .createShaper = createShaper,
@@ -196,6 +214,8 @@ extern "C" FormatShaperOps_t shaper_ops = {
     .getReverseMappings = getReverseMappings,
 
     .setTuning = setTuning,
+
+    .shapeFeedback = shapeFeedback,
 };
 
 }  // namespace mediaformatshaper
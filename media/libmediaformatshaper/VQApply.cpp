@@ -43,11 +43,25 @@ namespace mediaformatshaper {
 #define	AMEDIAFORMAT_VIDEO_QP_I_MIN	"video-qp-i-min"
 #define	AMEDIAFORMAT_VIDEO_QP_P_MAX	"video-qp-p-max"
 #define	AMEDIAFORMAT_VIDEO_QP_P_MIN	"video-qp-p-min"
+#define	AMEDIAFORMAT_VIDEO_QP_AVERAGE	"video-qp-average"
+// a parameter for the running codec, rather than a format key
+#define	AMEDIACODEC_VIDEO_BITRATE	"video-bitrate"
+
+// our own state, kept in the shaped format between feedback rounds
+#define	VQ_FEEDBACK_BITRATE_LIMIT	"android._vq-feedback.bitrate-limit"
 
 // defined in the SDK, but not in the NDK
 //
 static const int BITRATE_MODE_VBR = 1;
 
+// closed-loop tuning
+// each round moves the bitrate by these fractions of its current value
+static const double kFeedbackBitrateStepDown = 0.10;
+static const double kFeedbackBitrateStepUp = 0.20;
+// only step down if the encoder spent most of its budget; otherwise the
+// bitrate is not what holds the QP down
+static const double kFeedbackMinBudgetUsed = 0.80;
+
 
 //
 // Caller retains ownership of and responsibility for inFormat
@@ -213,6 +227,114 @@ int VQApply(CodecProperties *codec, vqOps_t *info, AMediaFormat* inFormat, int f
     return 0;
 }
 
+//
+// Caller retains ownership of and responsibility for all formats
+//
+// While the encoder's average QP stays comfortably below the QP that VQApply() considers
+// the quality target, the same quality is available for fewer bits: step the bitrate down,
+// never below the bits-per-pixel floor. Once the QP reaches the target we step back up,
+// never above the bitrate that VQApply() chose at configure time.
+//
+int VQFeedback(CodecProperties *codec, vqOps_t *info, AMediaFormat* shapedFormat,
+               AMediaFormat* stats, AMediaFormat* updates, int flags) {
+    ALOGV("codecName %s shapedFormat %p flags x%x", codec->getName().c_str(), shapedFormat, flags);
+
+    int32_t bitRateMode = -1;
+    if (AMediaFormat_getInt32(shapedFormat, AMEDIAFORMAT_KEY_BITRATE_MODE, &bitRateMode)
+        && bitRateMode != BITRATE_MODE_VBR) {
+        return 0;
+    }
+
+    // we only steer encodings where we enforce the minimum quality ourselves
+    int32_t qualityLevel = -1;
+    if (!AMediaFormat_getInt32(shapedFormat, "android._encoding-quality-level", &qualityLevel)
+        || qualityLevel != 0) {
+        return 0;
+    }
+    int32_t isVQEligible = 0;
+    (void) codec->getFeatureValue("_vq_eligible.device", &isVQEligible);
+    if (!isVQEligible || codec->supportedMinimumQuality() > 0) {
+        return 0;
+    }
+
+    int32_t qpAverage = 0;
+    if (!AMediaFormat_getInt32(stats, AMEDIAFORMAT_VIDEO_QP_AVERAGE, &qpAverage)) {
+        ALOGV("feedback: no average QP from the encoder");
+        return 0;
+    }
+    int64_t bytes = 0;
+    int64_t durationUs = 0;
+    (void) AMediaFormat_getInt64(stats, "bytes", &bytes);
+    (void) AMediaFormat_getInt64(stats, "duration-us", &durationUs);
+    if (bytes <= 0 || durationUs <= 0) {
+        return 0;
+    }
+
+    int32_t width = 0;
+    (void) AMediaFormat_getInt32(shapedFormat, AMEDIAFORMAT_KEY_WIDTH, &width);
+    int32_t height = 0;
+    (void) AMediaFormat_getInt32(shapedFormat, AMEDIAFORMAT_KEY_HEIGHT, &height);
+    int64_t pixels = ((int64_t)width) * height;
+    if (pixels <= 320 * 240 || pixels > 1920 * 1088) {
+        return 0;
+    }
+
+    // the QP we judge quality against: ours, or whatever bound is in the format
+    int32_t qpTarget = codec->targetQpMax(width, height);
+    if (qpTarget == INT32_MAX) {
+        (void) AMediaFormat_getInt32(shapedFormat, AMEDIAFORMAT_VIDEO_QP_MAX, &qpTarget);
+    }
+    if (qpTarget == INT32_MAX) {
+        ALOGV("feedback: no QP target for %dx%d", width, height);
+        return 0;
+    }
+
+    int32_t bitrateTmp = 0;
+    if (!AMediaFormat_getInt32(shapedFormat, AMEDIAFORMAT_KEY_BIT_RATE, &bitrateTmp)
+        || bitrateTmp <= 0) {
+        return 0;
+    }
+    int64_t bitrateCurrent = bitrateTmp;
+
+    int32_t bitrateLimitTmp = 0;
+    if (!AMediaFormat_getInt32(shapedFormat, VQ_FEEDBACK_BITRATE_LIMIT, &bitrateLimitTmp)) {
+        // first round: what we run with now is what configure settled on
+        bitrateLimitTmp = bitrateTmp;
+        AMediaFormat_setInt32(shapedFormat, VQ_FEEDBACK_BITRATE_LIMIT, bitrateLimitTmp);
+    }
+    int64_t bitrateLimit = bitrateLimitTmp;
+
+    int64_t bitrateFloor = pixels * codec->getBpp(width, height);
+    if (bitrateFloor > bitrateLimit) bitrateFloor = bitrateLimit;
+
+    int64_t bitrateMeasured = bytes * 8 * 1000000 / durationUs;
+    int64_t bitrateChosen = bitrateCurrent;
+
+    ALOGV("feedback: qp avg %d target %d, bitrate measured %" PRId64 " current %" PRId64
+          " floor %" PRId64 " limit %" PRId64,
+          qpAverage, qpTarget, bitrateMeasured, bitrateCurrent, bitrateFloor, bitrateLimit);
+
+    if (qpAverage >= qpTarget) {
+        // at (or past) the quality target, give the bits back
+        bitrateChosen = bitrateCurrent + bitrateCurrent * kFeedbackBitrateStepUp;
+        if (bitrateChosen > bitrateLimit) bitrateChosen = bitrateLimit;
+    } else if (qpAverage + info->qpDelta <= qpTarget
+               && bitrateMeasured >= bitrateCurrent * kFeedbackMinBudgetUsed) {
+        // quality to spare and the rate control is using the bits: take some away
+        bitrateChosen = bitrateCurrent - bitrateCurrent * kFeedbackBitrateStepDown;
+        if (bitrateChosen < bitrateFloor) bitrateChosen = bitrateFloor;
+    }
+
+    if (bitrateChosen != bitrateCurrent) {
+        ALOGD("minquality/feedback: qp avg %d vs target %d, bitrate %" PRId64 " -> %" PRId64,
+              qpAverage, qpTarget, bitrateCurrent, bitrateChosen);
+        AMediaFormat_setInt32(shapedFormat, AMEDIAFORMAT_KEY_BIT_RATE, (int32_t)bitrateChosen);
+        AMediaFormat_setInt32(updates, AMEDIACODEC_VIDEO_BITRATE, (int32_t)bitrateChosen);
+    }
+
+    return 0;
+}
+
 
 bool hasQpMaxPerFrameType(AMediaFormat *format) {
     int32_t value;
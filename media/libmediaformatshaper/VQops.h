@@ -35,6 +35,10 @@ typedef struct {
 
 int VQApply(CodecProperties *codec, vqOps_t *info, AMediaFormat* inFormat, int flags);
 
+// adjust the shaped bitrate of a running encoding from its output statistics
+int VQFeedback(CodecProperties *codec, vqOps_t *info, AMediaFormat* shapedFormat,
+               AMediaFormat* stats, AMediaFormat* updates, int flags);
+
 // spread the overall QP setting to any un-set per-frame-type settings
 void qpSpreadPerFrameType(AMediaFormat *format, int delta, int qplow, int qphigh, bool override);
 void qpSpreadMaxPerFrameType(AMediaFormat *format, int delta, int qphigh, bool override);
@@ -54,16 +54,7 @@ vqOps_t mediaInfo[] = {
 };
 int nMediaInfos = sizeof(mediaInfo) / sizeof(mediaInfo[0]);
 
-//
-// Caller retains ownership of and responsibility for inFormat
-//
-
-int videoShaper(CodecProperties *codec, AMediaFormat* inFormat, int flags) {
-    if (codec == nullptr) {
-        return -1;
-    }
-    ALOGV("codec %s inFormat %p flags x%x", codec->getName().c_str(), inFormat, flags);
-
+static vqOps_t *findMediaInfo(CodecProperties *codec) {
     int ix;
 
     std::string mediaType = codec->getMediaType();
@@ -78,7 +69,20 @@ int videoShaper(CodecProperties *codec, AMediaFormat* inFormat, int flags) {
         // shouldn't happen, but if it does .....
     }
 
-    vqOps_t *info = &mediaInfo[ix];
+    return &mediaInfo[ix];
+}
+
+//
+// Caller retains ownership of and responsibility for inFormat
+//
+
+int videoShaper(CodecProperties *codec, AMediaFormat* inFormat, int flags) {
+    if (codec == nullptr) {
+        return -1;
+    }
+    ALOGV("codec %s inFormat %p flags x%x", codec->getName().c_str(), inFormat, flags);
+
+    vqOps_t *info = findMediaInfo(codec);
 
     // apply any quality transforms in here..
     (void) VQApply(codec, info, inFormat, flags);
@@ -93,6 +97,23 @@ int videoShaper(CodecProperties *codec, AMediaFormat* inFormat, int flags) {
 
 }
 
+//
+// Caller retains ownership of and responsibility for all formats
+//
+
+int videoShaperFeedback(CodecProperties *codec, AMediaFormat* shapedFormat,
+                        AMediaFormat* stats, AMediaFormat* updates, int flags) {
+    if (codec == nullptr) {
+        return -1;
+    }
+    ALOGV("codec %s shapedFormat %p flags x%x", codec->getName().c_str(), shapedFormat, flags);
+
+    vqOps_t *info = findMediaInfo(codec);
+
+    // only the bitrate moves with feedback; the QP bounds set by videoShaper() stay in force
+    return VQFeedback(codec, info, shapedFormat, stats, updates, flags);
+}
+
 }  // namespace mediaformatshaper
 }  // namespace android
 
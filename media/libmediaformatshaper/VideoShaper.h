@@ -26,6 +26,13 @@ namespace mediaformatshaper {
  */
 int videoShaper(CodecProperties *codec,  AMediaFormat* inFormat, int flags);
 
+/*
+ * revisits the video-specific shaping of shapedFormat using the encoder statistics in stats.
+ * any parameters to apply to the running encoder are placed in updates.
+ */
+int videoShaperFeedback(CodecProperties *codec, AMediaFormat* shapedFormat,
+                        AMediaFormat* stats, AMediaFormat* updates, int flags);
+
 }  // namespace mediaformatshaper
 }  // namespace android
 
@@ -39,6 +39,19 @@ typedef void (*shaperHandle_t);
 typedef int (*shapeFormat_t)(shaperHandle_t shaperHandle,
                              AMediaFormat* inFormat, int flags);
 
+/*
+ * shapeFeedback revisits earlier shaping decisions while an encoding runs.
+ * shapedFormat is the format as shaped by shapeFormat(); the client keeps it for the
+ * life of the encoding and the shaper may record its own state in it between calls.
+ * stats describes the output of the encoder since the previous call:
+ *   "frames", "bytes" and "duration-us" (int64), and "video-qp-average" (int32) when
+ *   the encoder reports it.
+ * Any parameters the client should apply to the running encoder are returned in
+ * updates, which is empty when nothing is to change.
+ */
+typedef int (*shapeFeedback_t)(shaperHandle_t shaperHandle, AMediaFormat* shapedFormat,
+                               AMediaFormat* stats, AMediaFormat* updates, int flags);
+
 /*
  * getMapping returns any mappings from standard keys to codec-specific keys.
  * The return is a vector of const char* which are set up in pairs
@@ -127,12 +140,16 @@ typedef struct FormatShaperOps {
 
     setTuning_t setTuning;
 
+    // SHAPER_VERSION_V2
+    shapeFeedback_t shapeFeedback;
+
     // additions happen at the end of the structure
 } FormatShaperOps_t;
 
 // versioninf information
 const uint32_t SHAPER_VERSION_UNKNOWN = 0;
 const uint32_t SHAPER_VERSION_V1 = 1;
+const uint32_t SHAPER_VERSION_V2 = 2;      // adds shapeFeedback
 
 }  // namespace mediaformatshaper
 }  // namespace android
@@ -21,9 +21,13 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
 #include <set>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <binder/Parcel.h>
 #include <cutils/multiuser.h>
@@ -382,17 +386,9 @@ void BaseItem::dropInstance() {
     sMediaMetricsService = nullptr;
 }
 
-// static
-status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
-    ALOGD_IF(DEBUG_API, "%s: delivering %zu bytes", __func__, size);
-
-    // Validate size
-    if (size > std::numeric_limits<int32_t>::max()) return BAD_VALUE;
-
-    // Do we have the service available?
-    sp<media::IMediaMetricsService> svc = getService();
-    if (svc == nullptr)  return NO_INIT;
-
+// Sends a buffer of one or more items to the service in a single one-way transaction.
+static status_t transactBuffer(
+        const sp<media::IMediaMetricsService>& svc, const char *buffer, size_t size) {
     ::android::status_t status = NO_ERROR;
     if constexpr (/* DISABLES CODE */ (false)) {
         // THIS PATH IS FOR REFERENCE ONLY.
@@ -442,6 +438,84 @@ status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
     return status;
 }
 
+// Coalesces the buffers submitted within a short window into a single one-way
+// transaction, as hot clients submit many small items.  The service accepts a
+// buffer of concatenated items, since every item starts with its total size.
+class SubmitBatcher {
+public:
+    // A buffer at least this large is sent at once.
+    static constexpr size_t kMaxBatchBytes = 8192;
+    // The longest time a buffer waits to be sent.
+    static constexpr std::chrono::milliseconds kBatchWindow{10};
+
+    status_t submit(const sp<media::IMediaMetricsService>& svc, const char *buffer, size_t size) {
+        if (size == 0) return NO_ERROR;
+        std::lock_guard l(mLock);
+        if (mBatch.size() + size > kMaxBatchBytes) {
+            (void)flush_l();
+        }
+        if (size >= kMaxBatchBytes) {
+            return transactBuffer(svc, buffer, size);
+        }
+        if (mBatch.empty()) {
+            startThreadIfNeeded_l();
+            mCondition.notify_one(); // starts the window.
+        }
+        mBatch.insert(mBatch.end(), buffer, buffer + size);
+        return NO_ERROR;
+    }
+
+private:
+    status_t flush_l() {
+        if (mBatch.empty()) return NO_ERROR;
+        // If the service went away, the items are dropped like unbatched items would be.
+        const sp<media::IMediaMetricsService> svc = BaseItem::getService();
+        const status_t status = svc == nullptr
+                ? NO_INIT : transactBuffer(svc, mBatch.data(), mBatch.size());
+        mBatch.clear();
+        return status;
+    }
+
+    void startThreadIfNeeded_l() {
+        // a forked child does not inherit the thread of its parent.
+        const pid_t pid = getpid();
+        if (mThreadPid == pid) return;
+        mThreadPid = pid;
+        std::thread([this] { threadLoop(); }).detach();
+    }
+
+    void threadLoop() {
+        std::unique_lock l(mLock);
+        while (true) {
+            mCondition.wait(l, [this] { return !mBatch.empty(); });
+            // the batch may have been sent before the window ended as it was full.
+            mCondition.wait_for(l, kBatchWindow, [this] { return mBatch.empty(); });
+            (void)flush_l();
+        }
+    }
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::vector<char> mBatch;
+    pid_t mThreadPid = 0;
+};
+
+// static
+status_t BaseItem::submitBuffer(const char *buffer, size_t size) {
+    ALOGD_IF(DEBUG_API, "%s: delivering %zu bytes", __func__, size);
+
+    // Validate size
+    if (size > std::numeric_limits<int32_t>::max()) return BAD_VALUE;
+
+    // Do we have the service available?
+    sp<media::IMediaMetricsService> svc = getService();
+    if (svc == nullptr)  return NO_INIT;
+
+    // never destroyed, as its thread is detached.
+    static SubmitBatcher * const sBatcher = new SubmitBatcher();
+    return sBatcher->submit(svc, buffer, size);
+}
+
 //static
 sp<media::IMediaMetricsService> BaseItem::getService() {
     static const char *servicename = "media.metrics";
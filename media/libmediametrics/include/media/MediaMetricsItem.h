@@ -274,6 +274,7 @@ public:
     // returns the MediaMetrics service if active.
     static sp<media::IMediaMetricsService> getService();
     // submits a raw buffer directly to the MediaMetrics service - this is highly optimized.
+    // Buffers submitted within a few milliseconds are sent together in one transaction.
     static status_t submitBuffer(const char *buffer, size_t len);
 
 protected:
@@ -602,7 +602,8 @@ status_t MediaPlayerService::Client::dump(int fd, const Vector<String16>& args)
 
 /**
  * The only arguments this understands right now are -c, -von and -voff,
- * which are parsed by ALooperRoster::dump()
+ * which are parsed by ALooperRoster::dump(). -von also collects message
+ * handling time and queue delay histograms for every handler.
  */
 status_t MediaPlayerService::dump(int fd, const Vector<String16>& args)
 {
@@ -265,6 +265,26 @@ sp<IMemory> MetadataRetrieverClient::getFrameAtIndex(
     return frame;
 }
 
+status_t MetadataRetrieverClient::getFramesAtTime(
+        const std::vector<int64_t>& timesUs, int option, int colorFormat,
+        int32_t width, int32_t height, std::vector<sp<IMemory>>* frames) {
+    ALOGV("getFramesAtTime: %zu times, option(%d), colorFormat(%d) size(%dx%d)",
+            timesUs.size(), option, colorFormat, width, height);
+    Mutex::Autolock lock(mLock);
+    Mutex::Autolock glock(sLock);
+    if (mRetriever == NULL) {
+        ALOGE("retriever is not initialized");
+        return INVALID_OPERATION;
+    }
+
+    status_t err = mRetriever->getFramesAtTime(
+            timesUs, option, colorFormat, width, height, frames);
+    if (err != OK) {
+        ALOGE("failed to extract %zu frames (err %d)", timesUs.size(), err);
+    }
+    return err;
+}
+
 sp<IMemory> MetadataRetrieverClient::extractAlbumArt()
 {
     ALOGV("extractAlbumArt");
@@ -19,6 +19,8 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+
 #include <utils/Log.h>
 #include <cutils/properties.h>
 
@@ -331,8 +333,55 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameAtIndex(
             MediaSource::ReadOptions::SEEK_FRAME_INDEX, colorFormat, metaOnly);
 }
 
+status_t StagefrightMetadataRetriever::getFramesAtTime(
+        const std::vector<int64_t>& timesUs, int option, int colorFormat,
+        int32_t width, int32_t height, std::vector<sp<IMemory>>* frames) {
+    ALOGV("getFramesAtTime: %zu times, option: %d colorFormat: %d, size: %dx%d",
+            timesUs.size(), option, colorFormat, width, height);
+    frames->clear();
+    if (timesUs.empty() || !std::is_sorted(timesUs.begin(), timesUs.end())) {
+        ALOGE("times must be non-empty and in ascending order");
+        return BAD_VALUE;
+    }
+
+    // The first frame sets up the decoder, the others reuse it. The decoder
+    // reuses its frame memory, so each frame is copied at the requested size.
+    // When the decoder captures from a surface it already scales the frames,
+    // and scaleFrame() only copies them.
+    status_t err = OK;
+    for (size_t i = 0; i < timesUs.size() && err == OK; ++i) {
+        sp<IMemory> frame;
+        if (i == 0) {
+            frame = getFrameInternal(timesUs[i], option, colorFormat,
+                    false /*metaOnly*/, true /*keepDecoder*/, width, height);
+        } else if (mDecoder == nullptr) {
+            frame = nullptr;
+        } else if (option == MediaSource::ReadOptions::SEEK_FRAME_INDEX
+                && timesUs[i] == timesUs[i - 1] + 1) {
+            frame = mDecoder->extractFrame();
+        } else {
+            frame = mDecoder->extractFrameAtTime(timesUs[i]);
+        }
+        sp<IMemory> scaled = FrameDecoder::scaleFrame(frame, width, height);
+        if (scaled == nullptr) {
+            ALOGE("failed to extract frame at %" PRId64, timesUs[i]);
+            err = UNKNOWN_ERROR;
+        } else {
+            frames->push_back(scaled);
+        }
+    }
+
+    mDecoder.clear();
+    mLastDecodedIndex = -1;
+    if (err != OK) {
+        frames->clear();
+    }
+    return err;
+}
+
 sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
-        int64_t timeUs, int option, int colorFormat, bool metaOnly) {
+        int64_t timeUs, int option, int colorFormat, bool metaOnly, bool keepDecoder,
+        int32_t targetWidth, int32_t targetHeight) {
     mDecoder.clear();
     mLastDecodedIndex = -1;
 
@@ -423,11 +472,12 @@ sp<IMemory> StagefrightMetadataRetriever::getFrameInternal(
     for (size_t i = 0; i < matchingCodecs.size(); ++i) {
         const AString &componentName = matchingCodecs[i];
         sp<VideoFrameDecoder> decoder = new VideoFrameDecoder(componentName, trackMeta, source);
+        decoder->setTargetSize(targetWidth, targetHeight);
         if (decoder->init(timeUs, option, colorFormat) == OK) {
             sp<IMemory> frame = decoder->extractFrame();
             if (frame != nullptr) {
                 // keep the decoder if seeking by frame index
-                if (option == MediaSource::ReadOptions::SEEK_FRAME_INDEX) {
+                if (option == MediaSource::ReadOptions::SEEK_FRAME_INDEX || keepDecoder) {
                     mDecoder = decoder;
                     mLastDecodedIndex = timeUs;
                 }
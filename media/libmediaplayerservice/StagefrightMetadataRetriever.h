@@ -49,6 +49,9 @@ struct StagefrightMetadataRetriever : public MediaMetadataRetrieverBase {
             int index, int colorFormat, int left, int top, int right, int bottom);
     virtual sp<IMemory> getFrameAtIndex(
             int index, int colorFormat, bool metaOnly);
+    virtual status_t getFramesAtTime(
+            const std::vector<int64_t>& timesUs, int option, int colorFormat,
+            int32_t width, int32_t height, std::vector<sp<IMemory>>* frames);
 
     virtual MediaAlbumArt *extractAlbumArt();
     virtual const char *extractMetadata(int keyCode);
@@ -69,7 +72,8 @@ private:
     void clearMetadata();
 
     sp<IMemory> getFrameInternal(
-            int64_t timeUs, int option, int colorFormat, bool metaOnly);
+            int64_t timeUs, int option, int colorFormat, bool metaOnly,
+            bool keepDecoder = false, int32_t targetWidth = 0, int32_t targetHeight = 0);
 
     sp<IMemory> getImageInternal(
             int index, int colorFormat, bool metaOnly, bool thumbnail, FrameRect* rect);
@@ -59,6 +59,9 @@ namespace android {
    #Set size of buffers for pcm audio sink in msec (example: 1000 msec)
    adb shell setprop media.stagefright.audio.sink 1000
 
+   #Batch PCM writes to the audio sink for audio-only playback, to reduce wakeups
+   adb shell setprop media.stagefright.audio.batch 1
+
  * These configurations take effect for the next track played (not the current track).
  */
 
@@ -66,6 +69,10 @@ static inline bool getUseAudioCallbackSetting() {
     return property_get_bool("media.stagefright.audio.cbk", false /* default_value */);
 }
 
+static inline bool getBatchAudioWritesSetting() {
+    return property_get_bool("media.stagefright.audio.batch", false /* default_value */);
+}
+
 static inline int32_t getAudioSinkPcmMsSetting() {
     return property_get_int32(
             "media.stagefright.audio.sink", 500 /* default_value */);
@@ -164,6 +171,7 @@ NuPlayer::Renderer::Renderer(
       mTotalBuffersQueued(0),
       mLastAudioBufferDrained(0),
       mUseAudioCallback(false),
+      mBatchAudioWrites(false),
       mWakeLock(new AWakeLock()),
       mNeedVideoClearAnchor(false),
       mIsSeekonPause(false),
@@ -1253,6 +1261,29 @@ int64_t NuPlayer::Renderer::getDurationUsIfPlayedAtSampleRate(uint32_t numFrames
     return (int64_t)(numFrames * 1000000LL / sampleRate);
 }
 
+// In batch mode, returns how long a newly queued audio buffer can wait before the audio queue is
+// drained, so that it is written to the sink together with the buffers queued after it. The queue
+// is drained once the sink is down to a quarter of its buffer, which leaves enough margin for the
+// decoder to refill the queue. The audio clock is updated from the sink position as before, so
+// holding back writes doesn't affect AV sync.
+int64_t NuPlayer::Renderer::getAudioBatchDelayUs() {
+    if (!mBatchAudioWrites || mPaused || mAudioSink == NULL) {
+        return 0;
+    }
+
+    const int64_t lowWatermarkUs = mAudioSink->getBufferDurationInUs() / 4;
+    const int64_t pendingUs = getPendingAudioPlayoutDurationUs(ALooper::GetNowUs());
+    if (pendingUs <= lowWatermarkUs) {
+        return 0;
+    }
+
+    int64_t delayUs = pendingUs - lowWatermarkUs;
+    if (mPlaybackRate > 1.0f) {
+        delayUs /= mPlaybackRate;
+    }
+    return delayUs;
+}
+
 // Calculate duration of pending samples if played at normal rate (i.e., 1.0).
 int64_t NuPlayer::Renderer::getPendingAudioPlayoutDurationUs(int64_t nowUs) {
     int64_t writtenAudioDurationUs = getDurationUsIfPlayedAtSampleRate(mNumFramesWritten);
@@ -1643,9 +1674,10 @@ void NuPlayer::Renderer::onQueueBuffer(const sp<AMessage> &msg) {
     entry.mBufferOrdinal = ++mTotalBuffersQueued;
 
     if (audio) {
+        const int64_t delayUs = getAudioBatchDelayUs();
         Mutex::Autolock autoLock(mLock);
         mAudioQueue.push_back(entry);
-        postDrainAudioQueue_l();
+        postDrainAudioQueue_l(delayUs);
     } else {
         mVideoQueue.push_back(entry);
         postDrainVideoQueue();
@@ -2221,6 +2253,7 @@ status_t NuPlayer::Renderer::onOpenAudioSink(
                 }
             } else {
                 mUseAudioCallback = true;  // offload mode transfers data through callback
+                mBatchAudioWrites = false;
                 ++mAudioDrainGeneration;  // discard pending kWhatDrainAudioQueue message.
             }
         }
@@ -2252,6 +2285,10 @@ status_t NuPlayer::Renderer::onOpenAudioSink(
         if (mUseAudioCallback) {
             ++mAudioDrainGeneration;  // discard pending kWhatDrainAudioQueue message.
         }
+        // Batching is meant for audio-only playback. With video, the media clock's max media
+        // time only advances as audio is written, so held back audio would delay video frames.
+        mBatchAudioWrites = !hasVideo && !mUseAudioCallback && getBatchAudioWritesSetting();
+        ALOGV_IF(mBatchAudioWrites, "openAudioSink: batching audio writes");
 
         // Compute the desired buffer size.
         // For callback mode, the amount of time before wakeup is about half the buffer size.
@@ -224,6 +224,8 @@ protected:
     int32_t mTotalBuffersQueued;
     int32_t mLastAudioBufferDrained;
     bool mUseAudioCallback;
+    // Whether queued PCM buffers are held back and written to the sink in batches.
+    bool mBatchAudioWrites;
 
     sp<AWakeLock> mWakeLock;
 
@@ -245,6 +247,7 @@ protected:
     bool onDrainAudioQueue();
     void drainAudioQueueUntilLastEOS();
     int64_t getPendingAudioPlayoutDurationUs(int64_t nowUs);
+    int64_t getAudioBatchDelayUs();
     void postDrainAudioQueue_l(int64_t delayUs = 0);
 
     void clearAnchorTime();
@@ -121,13 +121,17 @@ std::string TranscoderWrapper::toString(const Event& event) {
     case Event::Abandon:
         typeStr = "Abandon";
         break;
+    case Event::SpeedLimit:
+        typeStr = "SpeedLimit";
+        break;
     default:
         return "(unknown)";
     }
     std::string result;
     result = "session {" + std::to_string(event.clientId) + "," + std::to_string(event.sessionId) +
              "}: " + typeStr;
-    if (event.type == Event::Error || event.type == Event::Progress) {
+    if (event.type == Event::Error || event.type == Event::Progress ||
+        event.type == Event::SpeedLimit) {
         result += " " + std::to_string(event.arg);
     }
     return result;
@@ -300,6 +304,21 @@ void TranscoderWrapper::stop(ClientIdType clientId, SessionIdType sessionId, boo
     }
 }
 
+void TranscoderWrapper::setSpeedLimit(ClientIdType clientId, SessionIdType sessionId,
+                                      int32_t speedLimitPercent) {
+    queueEvent(
+            Event::SpeedLimit, clientId, sessionId,
+            [=] {
+                // Only the running session has codecs to limit. The controller sets the limit
+                // again when a session is started or resumed.
+                if (mTranscoder != nullptr && clientId == mCurrentClientId &&
+                    sessionId == mCurrentSessionId) {
+                    mTranscoder->setSpeedLimit(speedLimitPercent);
+                }
+            },
+            speedLimitPercent);
+}
+
 void TranscoderWrapper::onFinish(ClientIdType clientId, SessionIdType sessionId) {
     queueEvent(Event::Finish, clientId, sessionId, [=] {
         if (mTranscoder != nullptr && clientId == mCurrentClientId &&
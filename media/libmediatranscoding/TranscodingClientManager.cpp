@@ -177,6 +177,8 @@ Status TranscodingClientManager::ClientImpl::submitRequest(
         // TODO(chz): is some of this coming from SessionController?
         *(TranscodingRequest*)&out_session->request = in_request;
         out_session->awaitNumberOfSessions = 0;
+        owner->mSessionController->getEstimatedRemainingTime(
+                mClientId, in_sessionId, &out_session->estimatedRemainingTimeUs);
     }
 
     return Status::ok();
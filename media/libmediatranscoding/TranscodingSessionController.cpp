@@ -26,6 +26,7 @@
 #include <utils/AndroidThreads.h>
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <thread>
 #include <utility>
 
@@ -35,6 +36,8 @@ static_assert((SessionIdType)-1 < 0, "SessionIdType should be signed");
 
 constexpr static uid_t OFFLINE_UID = -1;
 constexpr static size_t kSessionHistoryMax = 100;
+// Weight of the previous progress rate when smoothing the measured progress rate.
+constexpr static float kProgressRateSmoothing = 0.7f;
 
 //static
 String8 TranscodingSessionController::sessionToString(const SessionKeyType& sessionKey) {
@@ -343,6 +346,7 @@ TranscodingSessionController::TranscodingSessionController(
     mSessionQueues.emplace(OFFLINE_UID, SessionQueueType());
     mUidPackageNames[OFFLINE_UID] = "(offline)";
     mThermalThrottling = thermalPolicy->getThrottlingStatus();
+    mSpeedLimitPercent = thermalPolicy->getSpeedLimitPercent();
     if (config != nullptr) {
         mConfig = *config;
     }
@@ -369,6 +373,13 @@ void TranscodingSessionController::dumpSession_l(const Session& session, String8
     snprintf(buffer, SIZE, "        dst: %s\n", request.destinationFilePath.c_str());
     result.append(buffer);
 
+    if (!closedSession && session.progressRatePerSec > 0.0f) {
+        snprintf(buffer, SIZE, "        progress rate: %.2f%%/s, remaining: %.1fs\n",
+                 session.progressRatePerSec,
+                 (100 - session.lastProgress) / session.progressRatePerSec);
+        result.append(buffer);
+    }
+
     if (closedSession) {
         snprintf(buffer, SIZE,
                  "        waiting: %.1fs, running: %.1fs, paused: %.1fs, paused count: %d\n",
@@ -389,6 +400,8 @@ void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16
     result.append(buffer);
     snprintf(buffer, SIZE, "  Total num of Sessions: %zu\n", mSessionMap.size());
     result.append(buffer);
+    snprintf(buffer, SIZE, "  Speed limit: %d%%\n", mSpeedLimitPercent);
+    result.append(buffer);
 
     std::vector<int32_t> uids(mUidSortedList.begin(), mUidSortedList.end());
 
@@ -501,6 +514,14 @@ void TranscodingSessionController::Session::setState(Session::State newState) {
     state = newState;
 }
 
+std::chrono::microseconds TranscodingSessionController::Session::getRunningTime() const {
+    if (state != RUNNING) {
+        return runningTime;
+    }
+    return runningTime + std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::steady_clock::now() - stateEnterTime);
+}
+
 void TranscodingSessionController::updateCurrentSession_l() {
     Session* curSession = mCurrentSession;
     Session* topSession = nullptr;
@@ -564,6 +585,10 @@ void TranscodingSessionController::updateCurrentSession_l() {
                                 topSession->callingUid, topSession->callback.lock());
             setSessionState_l(topSession, Session::RUNNING);
         }
+        if (mSpeedLimitPercent < 100) {
+            mTranscoder->setSpeedLimit(topSession->key.first, topSession->key.second,
+                                       mSpeedLimitPercent);
+        }
         break;
     }
     mCurrentSession = topSession;
@@ -881,6 +906,33 @@ bool TranscodingSessionController::getSession(ClientIdType clientId, SessionIdTy
     return true;
 }
 
+bool TranscodingSessionController::getEstimatedRemainingTime(ClientIdType clientId,
+                                                             SessionIdType sessionId,
+                                                             int64_t* remainingTimeUs) {
+    SessionKeyType sessionKey = std::make_pair(clientId, sessionId);
+
+    std::scoped_lock lock{mLock};
+
+    if (mSessionMap.count(sessionKey) == 0) {
+        ALOGE("session %s doesn't exist", sessionToString(sessionKey).c_str());
+        return false;
+    }
+
+    const Session& session = mSessionMap[sessionKey];
+    if (session.progressRatePerSec <= 0.0f) {
+        *remainingTimeUs = -1;
+        return true;
+    }
+
+    // Don't count the running time that already passed since the last progress update.
+    const std::chrono::microseconds sinceLastProgress =
+            session.getRunningTime() - session.lastProgressRunningTime;
+    const int64_t estimateUs =
+            (int64_t)((100 - session.lastProgress) / session.progressRatePerSec * 1000000.0f);
+    *remainingTimeUs = std::max<int64_t>(0, estimateUs - sinceLastProgress.count());
+    return true;
+}
+
 void TranscodingSessionController::notifyClient(ClientIdType clientId, SessionIdType sessionId,
                                                 const char* reason,
                                                 std::function<void(const SessionKeyType&)> func) {
@@ -991,7 +1043,22 @@ void TranscodingSessionController::onProgressUpdate(ClientIdType clientId, Sessi
         if (callback != nullptr) {
             callback->onProgressUpdate(sessionId, progress);
         }
-        mSessionMap[sessionKey].lastProgress = progress;
+
+        // Track the progress rate over running time only, so that time spent paused or waiting
+        // doesn't skew the remaining time estimate.
+        Session& session = mSessionMap[sessionKey];
+        const std::chrono::microseconds runningTime = session.getRunningTime();
+        const std::chrono::microseconds elapsed = runningTime - session.lastProgressRunningTime;
+        if (progress > session.lastProgress && elapsed.count() > 0) {
+            const float rate = (progress - session.lastProgress) * 1000000.0f / elapsed.count();
+            session.progressRatePerSec =
+                    session.progressRatePerSec > 0.0f
+                            ? kProgressRateSmoothing * session.progressRatePerSec +
+                                      (1.0f - kProgressRateSmoothing) * rate
+                            : rate;
+        }
+        session.lastProgress = progress;
+        session.lastProgressRunningTime = runningTime;
     });
 }
 
@@ -1154,6 +1221,26 @@ void TranscodingSessionController::onThrottlingStopped() {
     validateState_l();
 }
 
+void TranscodingSessionController::onSpeedLimitChanged(int32_t speedLimitPercent) {
+    std::scoped_lock lock{mLock};
+
+    if (mSpeedLimitPercent == speedLimitPercent) {
+        return;
+    }
+
+    ALOGI("%s: %d%% -> %d%%", __FUNCTION__, mSpeedLimitPercent, speedLimitPercent);
+
+    if (mCurrentSession != nullptr && mCurrentSession->getState() == Session::RUNNING) {
+        // The measured progress rate no longer applies, scale it to the new limit.
+        mCurrentSession->progressRatePerSec *= (float)speedLimitPercent / mSpeedLimitPercent;
+        mTranscoder->setSpeedLimit(mCurrentSession->key.first, mCurrentSession->key.second,
+                                   speedLimitPercent);
+    }
+    mSpeedLimitPercent = speedLimitPercent;
+
+    validateState_l();
+}
+
 void TranscodingSessionController::validateState_l() {
 #ifdef VALIDATE_STATE
     LOG_ALWAYS_FATAL_IF(mSessionQueues.count(OFFLINE_UID) != 1,
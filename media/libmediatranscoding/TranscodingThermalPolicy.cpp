@@ -22,12 +22,48 @@
 #include <media/TranscodingUidPolicy.h>
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace android {
 
+// Sessions run at full speed while the thermal headroom is at or below this value. A headroom of
+// 1.0 means the device is expected to reach ATHERMAL_STATUS_SEVERE, where sessions are paused.
+static constexpr float kFullSpeedHeadroom = 0.6f;
+// The speed limit is lowered in steps between full speed and the minimum speed, so that small
+// headroom changes don't keep reconfiguring the codecs.
+static constexpr int32_t kMinSpeedLimitPercent = 25;
+static constexpr int32_t kSpeedLimitStepPercent = 25;
+// How far ahead the headroom is forecast, and how often it is polled.
+static constexpr int kHeadroomForecastSeconds = 10;
+static constexpr std::chrono::seconds kHeadroomPollInterval{10};
+
 static bool needThrottling(AThermalStatus status) {
     return (status >= ATHERMAL_STATUS_SEVERE);
 }
 
+static int32_t getSpeedLimit(float headroom, AThermalStatus status) {
+    if (std::isnan(headroom)) {
+        // Headroom is not supported by the device, fall back to the thermal status.
+        switch (status) {
+        case ATHERMAL_STATUS_LIGHT:
+            return 75;
+        case ATHERMAL_STATUS_MODERATE:
+            return 50;
+        default:
+            return 100;
+        }
+    }
+
+    if (headroom <= kFullSpeedHeadroom) {
+        return 100;
+    }
+    const float fraction = (1.0f - headroom) / (1.0f - kFullSpeedHeadroom);
+    int32_t percent = kMinSpeedLimitPercent + fraction * (100 - kMinSpeedLimitPercent);
+    percent = percent / kSpeedLimitStepPercent * kSpeedLimitStepPercent;
+    return std::clamp(percent, kMinSpeedLimitPercent, 100);
+}
+
 //static
 void TranscodingThermalPolicy::onStatusChange(void* data, AThermalStatus status) {
     TranscodingThermalPolicy* policy = static_cast<TranscodingThermalPolicy*>(data);
@@ -35,7 +71,10 @@ void TranscodingThermalPolicy::onStatusChange(void* data, AThermalStatus status)
 }
 
 TranscodingThermalPolicy::TranscodingThermalPolicy()
-      : mRegistered(false), mThermalManager(nullptr), mIsThrottling(false) {
+      : mRegistered(false),
+        mThermalManager(nullptr),
+        mIsThrottling(false),
+        mSpeedLimitPercent(100) {
     registerSelf();
 }
 
@@ -66,22 +105,39 @@ void TranscodingThermalPolicy::registerSelf() {
             return;
         }
 
-        mIsThrottling = needThrottling(AThermal_getCurrentThermalStatus(thermalManager));
+        const AThermalStatus status = AThermal_getCurrentThermalStatus(thermalManager);
+        mIsThrottling = needThrottling(status);
+        mSpeedLimitPercent = getSpeedLimit(
+                AThermal_getThermalHeadroom(thermalManager, kHeadroomForecastSeconds), status);
         mThermalManager = thermalManager;
     }
 
     mRegistered = true;
+
+    if (mThermalManager != nullptr) {
+        mHeadroomThread = std::thread(&TranscodingThermalPolicy::headroomThreadLoop, this);
+    }
 }
 
 void TranscodingThermalPolicy::unregisterSelf() {
     ALOGI("TranscodingThermalPolicy: unregisterSelf");
 
-    std::scoped_lock lock{mRegisteredLock};
+    {
+        std::scoped_lock lock{mRegisteredLock};
+        if (!mRegistered) {
+            return;
+        }
+        mRegistered = false;
+        mHeadroomCondition.notify_all();
+    }
 
-    if (!mRegistered) {
-        return;
+    // Join outside of the lock, as the thread needs it to exit.
+    if (mHeadroomThread.joinable()) {
+        mHeadroomThread.join();
     }
 
+    std::scoped_lock lock{mRegisteredLock};
+
     if (__builtin_available(android __TRANSCODING_MIN_API__, *)) {
         if (mThermalManager != nullptr) {
             // Unregister listener
@@ -94,8 +150,6 @@ void TranscodingThermalPolicy::unregisterSelf() {
             mThermalManager = nullptr;
         }
     }
-
-    mRegistered = false;
 }
 
 void TranscodingThermalPolicy::setCallback(
@@ -109,7 +163,58 @@ bool TranscodingThermalPolicy::getThrottlingStatus() {
     return mIsThrottling;
 }
 
+int32_t TranscodingThermalPolicy::getSpeedLimitPercent() {
+    std::scoped_lock lock{mRegisteredLock};
+    return mSpeedLimitPercent;
+}
+
+void TranscodingThermalPolicy::updateSpeedLimit() {
+    int32_t speedLimitPercent = 100;
+
+    {
+        std::scoped_lock lock{mRegisteredLock};
+        if (mThermalManager == nullptr) {
+            return;
+        }
+
+        if (__builtin_available(android __TRANSCODING_MIN_API__, *)) {
+            speedLimitPercent = getSpeedLimit(
+                    AThermal_getThermalHeadroom(mThermalManager, kHeadroomForecastSeconds),
+                    AThermal_getCurrentThermalStatus(mThermalManager));
+        }
+
+        if (speedLimitPercent == mSpeedLimitPercent) {
+            return;
+        }
+        ALOGI("Transcoding thermal speed limit changed: %d%%", speedLimitPercent);
+        mSpeedLimitPercent = speedLimitPercent;
+    }
+
+    std::scoped_lock lock{mCallbackLock};
+    std::shared_ptr<ThermalPolicyCallbackInterface> cb;
+    if ((cb = mThermalPolicyCallback.lock()) != nullptr) {
+        cb->onSpeedLimitChanged(speedLimitPercent);
+    }
+}
+
+void TranscodingThermalPolicy::headroomThreadLoop() NO_THREAD_SAFETY_ANALYSIS {
+    std::unique_lock lock{mRegisteredLock};
+    while (mRegistered) {
+        mHeadroomCondition.wait_for(lock, kHeadroomPollInterval);
+        if (!mRegistered) {
+            break;
+        }
+
+        lock.unlock();
+        updateSpeedLimit();
+        lock.lock();
+    }
+}
+
 void TranscodingThermalPolicy::onStatusChange(AThermalStatus status) {
+    // The headroom usually moves with the status, so don't wait for the next poll.
+    updateSpeedLimit();
+
     bool isThrottling = needThrottling(status);
 
     {
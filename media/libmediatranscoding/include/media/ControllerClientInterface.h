@@ -83,6 +83,16 @@ public:
     virtual bool getClientUids(ClientIdType clientId, SessionIdType sessionId,
                                std::vector<int32_t>* out_clientUids) = 0;
 
+    /**
+     * Estimates the remaining running time of the session identified by <clientId, sessionId>,
+     * based on the progress rate measured while the session was running. remainingTimeUs is set
+     * to -1 if the session has not made enough progress for an estimate.
+     *
+     * Returns false if the session doesn't exist. Returns true otherwise.
+     */
+    virtual bool getEstimatedRemainingTime(ClientIdType clientId, SessionIdType sessionId,
+                                           int64_t* remainingTimeUs) = 0;
+
 protected:
     virtual ~ControllerClientInterface() = default;
 };
@@ -33,6 +33,10 @@ public:
     // false otherwise.
     virtual bool getThrottlingStatus() = 0;
 
+    // Get the current speed limit, in percent of full speed, that sessions should run at
+    // while throttling is not on. Returns 100 if transcoding can run at full speed.
+    virtual int32_t getSpeedLimitPercent() = 0;
+
 protected:
     virtual ~ThermalPolicyInterface() = default;
 };
@@ -44,6 +48,9 @@ public:
     virtual void onThrottlingStarted() = 0;
     virtual void onThrottlingStopped() = 0;
 
+    // Called when the speed limit for running sessions changes as the thermal headroom changes.
+    virtual void onSpeedLimitChanged(int32_t speedLimitPercent) = 0;
+
 protected:
     virtual ~ThermalPolicyCallbackInterface() = default;
 };
@@ -42,6 +42,10 @@ public:
     // Stop the specified session. If abandon is true, the transcoder wrapper will be discarded
     // after the session stops.
     virtual void stop(ClientIdType clientId, SessionIdType sessionId, bool abandon = false) = 0;
+    // Limit the speed of the specified running session to a percentage of its full speed, for
+    // example to reduce heat. Transcoders that cannot limit their speed ignore this.
+    virtual void setSpeedLimit(ClientIdType /*clientId*/, SessionIdType /*sessionId*/,
+                               int32_t /*speedLimitPercent*/) {}
 
 protected:
     virtual ~TranscoderInterface() = default;
@@ -53,6 +53,8 @@ public:
                 const TranscodingRequestParcel& request, uid_t callingUid,
                 const std::shared_ptr<ITranscodingClientCallback>& clientCallback) override;
     void stop(ClientIdType clientId, SessionIdType sessionId, bool abandon = false) override;
+    void setSpeedLimit(ClientIdType clientId, SessionIdType sessionId,
+                       int32_t speedLimitPercent) override;
     // ~TranscoderInterface
 
 private:
@@ -68,7 +70,8 @@ private:
             Error,
             Progress,
             HeartBeat,
-            Abandon
+            Abandon,
+            SpeedLimit
         } type;
         ClientIdType clientId;
         SessionIdType sessionId;
@@ -57,6 +57,8 @@ public:
     bool addClientUid(ClientIdType clientId, SessionIdType sessionId, uid_t clientUid) override;
     bool getClientUids(ClientIdType clientId, SessionIdType sessionId,
                        std::vector<int32_t>* out_clientUids) override;
+    bool getEstimatedRemainingTime(ClientIdType clientId, SessionIdType sessionId,
+                                   int64_t* remainingTimeUs) override;
     // ~ControllerClientInterface
 
     // TranscoderCallbackInterface
@@ -83,7 +85,8 @@ public:
     // ThermalPolicyCallbackInterface
     void onThrottlingStarted() override;
     void onThrottlingStopped() override;
-    // ~ResourcePolicyCallbackInterface
+    void onSpeedLimitChanged(int32_t speedLimitPercent) override;
+    // ~ThermalPolicyCallbackInterface
 
     /**
      * Dump all the session information to the fd.
@@ -132,6 +135,10 @@ private:
         std::chrono::microseconds waitingTime{0};
         std::chrono::microseconds runningTime{0};
         std::chrono::microseconds pausedTime{0};
+        // Running time at the last progress update, and the smoothed progress rate in percent
+        // per second of running time (0 until measured).
+        std::chrono::microseconds lastProgressRunningTime{0};
+        float progressRatePerSec = 0.0f;
 
         TranscodingRequest request;
         std::weak_ptr<ITranscodingClientCallback> callback;
@@ -140,6 +147,8 @@ private:
         void setState(Session::State state);
         State getState() const { return state; }
         bool isRunning() { return state == RUNNING; }
+        // Returns the running time including the current running period.
+        std::chrono::microseconds getRunningTime() const;
 
     private:
         State state = INVALID;
@@ -174,6 +183,7 @@ private:
     Session* mCurrentSession;
     bool mResourceLost;
     bool mThermalThrottling;
+    int32_t mSpeedLimitPercent;
     std::list<Session> mSessionHistory;
     std::shared_ptr<Watchdog> mWatchdog;
     std::shared_ptr<Pacer> mPacer;
@@ -21,7 +21,9 @@
 #include <media/ThermalPolicyInterface.h>
 #include <utils/Condition.h>
 
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 
 namespace android {
 
@@ -32,6 +34,7 @@ public:
 
     void setCallback(const std::shared_ptr<ThermalPolicyCallbackInterface>& cb) override;
     bool getThrottlingStatus() override;
+    int32_t getSpeedLimitPercent() override;
 
 private:
     mutable std::mutex mRegisteredLock;
@@ -42,9 +45,16 @@ private:
 
     AThermalManager* mThermalManager;
     bool mIsThrottling;
+    int32_t mSpeedLimitPercent GUARDED_BY(mRegisteredLock);
+
+    // Polls the thermal headroom, which has no change notification, while registered.
+    std::thread mHeadroomThread;
+    std::condition_variable mHeadroomCondition;
 
     static void onStatusChange(void* data, AThermalStatus status);
     void onStatusChange(AThermalStatus status);
+    void updateSpeedLimit();
+    void headroomThreadLoop();
     void registerSelf();
     void unregisterSelf();
 };
@@ -191,6 +191,17 @@ struct TestController : public ControllerClientInterface {
         return true;
     }
 
+    bool getEstimatedRemainingTime(ClientIdType clientId, SessionIdType sessionId,
+                                   int64_t* remainingTimeUs) override {
+        SessionKeyType sessionKey = std::make_pair(clientId, sessionId);
+
+        if (mSessions.count(sessionKey) == 0) {
+            return false;
+        }
+        *remainingTimeUs = -1;
+        return true;
+    }
+
     bool cancel(ClientIdType clientId, SessionIdType sessionId) override {
         SessionKeyType sessionKey = std::make_pair(clientId, sessionId);
 
@@ -111,6 +111,7 @@ public:
     // ThermalPolicyInterface
     void setCallback(const std::shared_ptr<ThermalPolicyCallbackInterface>& /*cb*/) override {}
     bool getThrottlingStatus() { return false; }
+    int32_t getSpeedLimitPercent() override { return 100; }
     // ~ThermalPolicyInterface
 
 private:
@@ -138,6 +139,14 @@ public:
     void stop(ClientIdType clientId, SessionIdType sessionId, bool abandon) override {
         append(abandon ? Abandon(clientId, sessionId) : Stop(clientId, sessionId));
     }
+    void setSpeedLimit(ClientIdType clientId, SessionIdType sessionId,
+                       int32_t speedLimitPercent) override {
+        {
+            std::scoped_lock lock{mLock};
+            mLastSpeedLimit = speedLimitPercent;
+        }
+        append(SpeedLimit(clientId, sessionId));
+    }
 
     void onFinished(ClientIdType clientId, SessionIdType sessionId) {
         append(Finished(clientId, sessionId));
@@ -153,7 +162,7 @@ public:
     }
 
     struct Event {
-        enum { NoEvent, Start, Pause, Resume, Stop, Finished, Failed, Abandon } type;
+        enum { NoEvent, Start, Pause, Resume, Stop, Finished, Failed, Abandon, SpeedLimit } type;
         ClientIdType clientId;
         SessionIdType sessionId;
     };
@@ -172,6 +181,7 @@ public:
     DECLARE_EVENT(Finished);
     DECLARE_EVENT(Failed);
     DECLARE_EVENT(Abandon);
+    DECLARE_EVENT(SpeedLimit);
 
     // Push 1 event to back.
     void append(const Event& event,
@@ -220,6 +230,11 @@ public:
         return mGeneration;
     }
 
+    int32_t getLastSpeedLimit() {
+        std::scoped_lock lock{mLock};
+        return mLastSpeedLimit;
+    }
+
 private:
     std::mutex mLock;
     std::condition_variable mCondition;
@@ -227,6 +242,7 @@ private:
     std::list<Event> mEventQueue;
     std::list<TranscodingErrorCode> mLastErrorQueue;
     int32_t mGeneration;
+    int32_t mLastSpeedLimit = 100;
 };
 
 bool operator==(const TestTranscoder::Event& lhs, const TestTranscoder::Event& rhs) {
@@ -1182,6 +1198,38 @@ TEST_F(TranscodingSessionControllerTest, TestThermalCallback) {
     EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(3), SESSION(0)));
 }
 
+TEST_F(TranscodingSessionControllerTest, TestSpeedLimitCallback) {
+    ALOGD("TestSpeedLimitCallback");
+
+    // Speed limit changes without a running session are only remembered.
+    mController->onSpeedLimitChanged(50);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // A new session should start with the current speed limit.
+    mRealtimeRequest.clientPid = PID(0);
+    mController->submit(CLIENT(0), SESSION(0), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::SpeedLimit(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->getLastSpeedLimit(), 50);
+
+    // Changes are sent to the running session, repeated values are ignored.
+    mController->onSpeedLimitChanged(100);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::SpeedLimit(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->getLastSpeedLimit(), 100);
+    mController->onSpeedLimitChanged(100);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // No estimate is available before the session makes progress.
+    int64_t remainingTimeUs = 0;
+    EXPECT_TRUE(mController->getEstimatedRemainingTime(CLIENT(0), SESSION(0), &remainingTimeUs));
+    EXPECT_EQ(remainingTimeUs, -1);
+    usleep(100000);
+    mController->onProgressUpdate(CLIENT(0), SESSION(0), 10);
+    EXPECT_TRUE(mController->getEstimatedRemainingTime(CLIENT(0), SESSION(0), &remainingTimeUs));
+    EXPECT_GT(remainingTimeUs, 0);
+    EXPECT_FALSE(mController->getEstimatedRemainingTime(CLIENT(1), SESSION(0), &remainingTimeUs));
+}
+
 /* Test resource lost and thermal throttling happening simultaneously */
 TEST_F(TranscodingSessionControllerTest, TestResourceLostAndThermalCallback) {
     ALOGD("TestResourceLostAndThermalCallback");
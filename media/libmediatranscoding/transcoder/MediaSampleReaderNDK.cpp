@@ -22,9 +22,16 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 namespace android {
 
+// Read-ahead budgets for sequential access. Video samples are large and decoding them is slow, so
+// video gets enough room for roughly a GOP of high bitrate content while audio and other tracks
+// only need a few hundred milliseconds to keep the writer interleaving.
+static constexpr size_t kVideoReadAheadBytes = 4 * 1024 * 1024;
+static constexpr size_t kOtherReadAheadBytes = 512 * 1024;
+
 // Check that the extractor sample flags have the expected NDK meaning.
 static_assert(SAMPLE_FLAG_SYNC_SAMPLE == AMEDIAEXTRACTOR_SAMPLE_FLAG_SYNC,
               "Sample flag mismatch: SYNC_SAMPLE");
@@ -53,6 +60,7 @@ MediaSampleReaderNDK::MediaSampleReaderNDK(AMediaExtractor* extractor)
       : mExtractor(extractor), mTrackCount(AMediaExtractor_getTrackCount(mExtractor)) {
     if (mTrackCount > 0) {
         mTrackCursors.resize(mTrackCount);
+        mReadAheadQueues.resize(mTrackCount);
     }
 }
 
@@ -98,15 +106,23 @@ bool MediaSampleReaderNDK::advanceExtractor_l() {
         mTrackCursors[mExtractorTrackIndex].next.reset();
     }
 
+    // The extractor stays on the first sample past the segment so that the segment end is sticky.
+    if (mSegmentEndReached) {
+        setEosReached_l();
+        return false;
+    }
+
     // Update the extractor's sample index even if this track reaches EOS, so that the other tracks
     // are not given an incorrect extractor position.
     mExtractorSampleIndex++;
     if (!AMediaExtractor_advance(mExtractor)) {
         LOG(DEBUG) << "  EOS in advanceExtractor_l";
-        mEosReached = true;
-        for (auto it = mTrackSignals.begin(); it != mTrackSignals.end(); ++it) {
-            it->second.notify_all();
-        }
+        setEosReached_l();
+        return false;
+    } else if (isPastSegmentEnd_l()) {
+        LOG(DEBUG) << "  End of segment in advanceExtractor_l";
+        mSegmentEndReached = true;
+        setEosReached_l();
         return false;
     }
 
@@ -124,6 +140,28 @@ bool MediaSampleReaderNDK::advanceExtractor_l() {
     return true;
 }
 
+void MediaSampleReaderNDK::setEosReached_l() {
+    mEosReached = true;
+    for (auto it = mTrackSignals.begin(); it != mTrackSignals.end(); ++it) {
+        it->second.notify_all();
+    }
+}
+
+bool MediaSampleReaderNDK::isPastSegmentEnd_l() {
+    return mSegmentEndTimeUs >= 0 &&
+           (AMediaExtractor_getSampleFlags(mExtractor) & AMEDIAEXTRACTOR_SAMPLE_FLAG_SYNC) != 0 &&
+           AMediaExtractor_getSampleTime(mExtractor) >= mSegmentEndTimeUs;
+}
+
+media_status_t MediaSampleReaderNDK::resetExtractor_l() {
+    media_status_t status = AMediaExtractor_seekTo(mExtractor, mSegmentStartTimeUs,
+                                                   AMEDIAEXTRACTOR_SEEK_PREVIOUS_SYNC);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to reset extractor: " << status;
+    }
+    return status;
+}
+
 media_status_t MediaSampleReaderNDK::seekExtractorBackwards_l(int64_t targetTimeUs,
                                                               int targetTrackIndex,
                                                               uint64_t targetSampleIndex) {
@@ -142,6 +180,7 @@ media_status_t MediaSampleReaderNDK::seekExtractorBackwards_l(int64_t targetTime
     }
 
     mEosReached = false;
+    mSegmentEndReached = false;
     mExtractorTrackIndex = AMediaExtractor_getSampleTrackIndex(mExtractor);
     int64_t sampleTimeUs = AMediaExtractor_getSampleTime(mExtractor);
 
@@ -177,13 +216,60 @@ media_status_t MediaSampleReaderNDK::moveToTrack_l(int trackIndex) {
     return moveToSample_l(mTrackCursors[trackIndex].current, trackIndex);
 }
 
+bool MediaSampleReaderNDK::readAheadExtractorSample_l() {
+    const int trackIndex = mExtractorTrackIndex;
+    ReadAheadQueue& queue = mReadAheadQueues[trackIndex];
+
+    ssize_t sampleSize = AMediaExtractor_getSampleSize(mExtractor);
+    if (sampleSize < 0 || queue.maxSizeBytes == 0) {
+        return false;
+    } else if (!queue.samples.empty() && queue.sizeBytes + sampleSize > queue.maxSizeBytes) {
+        return false;
+    }
+
+    ReadAheadSample& sample = queue.samples.emplace_back();
+    sample.info.presentationTimeUs = AMediaExtractor_getSampleTime(mExtractor);
+    sample.info.flags = AMediaExtractor_getSampleFlags(mExtractor);
+    sample.info.size = sampleSize;
+    sample.data.resize(sampleSize);
+
+    ssize_t bytesRead = AMediaExtractor_readSampleData(mExtractor, sample.data.data(), sampleSize);
+    if (bytesRead < sampleSize) {
+        LOG(ERROR) << "Unable to read ahead full sample, " << bytesRead << " vs " << sampleSize;
+        queue.samples.pop_back();
+        return false;
+    }
+    queue.sizeBytes += sampleSize;
+
+    advanceTrack_l(trackIndex);
+    mTrackSignals[trackIndex].notify_all();
+    return true;
+}
+
+void MediaSampleReaderNDK::popReadAheadSample_l(int trackIndex) {
+    ReadAheadQueue& queue = mReadAheadQueues[trackIndex];
+    queue.sizeBytes -= queue.samples.front().info.size;
+    queue.samples.pop_front();
+
+    // Threads waiting for other tracks may be able to read ahead again.
+    for (auto it = mTrackSignals.begin(); it != mTrackSignals.end(); ++it) {
+        it->second.notify_all();
+    }
+}
+
 media_status_t MediaSampleReaderNDK::waitForTrack_l(int trackIndex,
                                                     std::unique_lock<std::mutex>& lockHeld) {
-    while (trackIndex != mExtractorTrackIndex && !mEosReached && mEnforceSequentialAccess) {
-        mTrackSignals[trackIndex].wait(lockHeld);
+    const ReadAheadQueue& queue = mReadAheadQueues[trackIndex];
+    while (trackIndex != mExtractorTrackIndex && !mEosReached && mEnforceSequentialAccess &&
+           queue.samples.empty()) {
+        if (!readAheadExtractorSample_l()) {
+            mTrackSignals[trackIndex].wait(lockHeld);
+        }
     }
 
-    if (mEosReached) {
+    if (!queue.samples.empty()) {
+        return AMEDIA_OK;
+    } else if (mEosReached) {
         return AMEDIA_ERROR_END_OF_STREAM;
     }
 
@@ -234,6 +320,14 @@ media_status_t MediaSampleReaderNDK::selectTrack(int trackIndex) {
 
     mTrackSignals.emplace(std::piecewise_construct, std::forward_as_tuple(trackIndex),
                           std::forward_as_tuple());
+
+    const char* mime = nullptr;
+    AMediaFormat* trackFormat = AMediaExtractor_getTrackFormat(mExtractor, trackIndex);
+    const bool isVideo = AMediaFormat_getString(trackFormat, AMEDIAFORMAT_KEY_MIME, &mime) &&
+                         strncmp(mime, "video/", 6) == 0;
+    AMediaFormat_delete(trackFormat);
+    mReadAheadQueues[trackIndex].maxSizeBytes =
+            isVideo ? kVideoReadAheadBytes : kOtherReadAheadBytes;
     return AMEDIA_OK;
 }
 
@@ -254,6 +348,7 @@ media_status_t MediaSampleReaderNDK::unselectTrack(int trackIndex) {
         return AMEDIA_ERROR_INVALID_PARAMETER;
     }
     mTrackSignals.erase(it);
+    mReadAheadQueues[trackIndex].maxSizeBytes = 0;
 
     media_status_t status = AMediaExtractor_unselectTrack(mExtractor, trackIndex);
     if (status != AMEDIA_OK) {
@@ -353,9 +448,8 @@ media_status_t MediaSampleReaderNDK::getEstimatedBitrateForTrack(int trackIndex,
              AMediaExtractor_advance(mExtractor));
 
     // Reset the extractor to the beginning.
-    status = AMediaExtractor_seekTo(mExtractor, 0, AMEDIAEXTRACTOR_SEEK_PREVIOUS_SYNC);
+    status = resetExtractor_l();
     if (status != AMEDIA_OK) {
-        LOG(ERROR) << "Unable to reset extractor: " << status;
         return status;
     }
 
@@ -388,6 +482,57 @@ media_status_t MediaSampleReaderNDK::getEstimatedBitrateForTrack(int trackIndex,
     return AMEDIA_OK;
 }
 
+media_status_t MediaSampleReaderNDK::getNextSyncSampleTime(int trackIndex, int64_t timeUs,
+                                                           int64_t* syncTimeUs) {
+    std::scoped_lock lock(mExtractorMutex);
+
+    if (mTrackSignals.find(trackIndex) == mTrackSignals.end()) {
+        LOG(ERROR) << "Track is not selected.";
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    } else if (syncTimeUs == nullptr) {
+        LOG(ERROR) << "syncTimeUs pointer is NULL.";
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    } else if (mExtractorTrackIndex >= 0) {
+        LOG(ERROR) << "getNextSyncSampleTime must be called before sample reading begins.";
+        return AMEDIA_ERROR_UNSUPPORTED;
+    }
+
+    media_status_t status = AMediaExtractor_seekTo(mExtractor, std::max(timeUs, (int64_t)0),
+                                                   AMEDIAEXTRACTOR_SEEK_NEXT_SYNC);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to seek to next sync sample after " << timeUs << ": " << status;
+        return status;
+    }
+
+    // Skip samples of other selected tracks that the extractor may be interleaving.
+    *syncTimeUs = -1;
+    do {
+        if (AMediaExtractor_getSampleTrackIndex(mExtractor) == trackIndex &&
+            (AMediaExtractor_getSampleFlags(mExtractor) & AMEDIAEXTRACTOR_SAMPLE_FLAG_SYNC) != 0) {
+            *syncTimeUs = AMediaExtractor_getSampleTime(mExtractor);
+            break;
+        }
+    } while (AMediaExtractor_advance(mExtractor));
+
+    return resetExtractor_l();
+}
+
+media_status_t MediaSampleReaderNDK::seekToSegment(int64_t startTimeUs, int64_t endTimeUs) {
+    std::scoped_lock lock(mExtractorMutex);
+
+    if (mExtractorTrackIndex >= 0) {
+        LOG(ERROR) << "seekToSegment must be called before sample reading begins.";
+        return AMEDIA_ERROR_UNSUPPORTED;
+    } else if (startTimeUs < 0 || (endTimeUs >= 0 && endTimeUs <= startTimeUs)) {
+        LOG(ERROR) << "Invalid segment " << startTimeUs << " - " << endTimeUs;
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+
+    mSegmentStartTimeUs = startTimeUs;
+    mSegmentEndTimeUs = endTimeUs;
+    return resetExtractor_l();
+}
+
 media_status_t MediaSampleReaderNDK::getSampleInfoForTrack(int trackIndex, MediaSampleInfo* info) {
     std::unique_lock<std::mutex> lock(mExtractorMutex);
 
@@ -399,8 +544,12 @@ media_status_t MediaSampleReaderNDK::getSampleInfoForTrack(int trackIndex, Media
         return AMEDIA_ERROR_INVALID_PARAMETER;
     }
 
-    media_status_t status = primeExtractorForTrack_l(trackIndex, lock);
-    if (status == AMEDIA_OK) {
+    const ReadAheadQueue& queue = mReadAheadQueues[trackIndex];
+    media_status_t status =
+            queue.samples.empty() ? primeExtractorForTrack_l(trackIndex, lock) : AMEDIA_OK;
+    if (status == AMEDIA_OK && !queue.samples.empty()) {
+        *info = queue.samples.front().info;
+    } else if (status == AMEDIA_OK) {
         info->presentationTimeUs = AMediaExtractor_getSampleTime(mExtractor);
         info->flags = AMediaExtractor_getSampleFlags(mExtractor);
         info->size = AMediaExtractor_getSampleSize(mExtractor);
@@ -428,11 +577,25 @@ media_status_t MediaSampleReaderNDK::readSampleDataForTrack(int trackIndex, uint
         return AMEDIA_ERROR_INVALID_PARAMETER;
     }
 
-    media_status_t status = primeExtractorForTrack_l(trackIndex, lock);
+    const ReadAheadQueue& queue = mReadAheadQueues[trackIndex];
+    media_status_t status =
+            queue.samples.empty() ? primeExtractorForTrack_l(trackIndex, lock) : AMEDIA_OK;
     if (status != AMEDIA_OK) {
         return status;
     }
 
+    if (!queue.samples.empty()) {
+        const ReadAheadSample& sample = queue.samples.front();
+        if (bufferSize < sample.info.size) {
+            LOG(ERROR) << "Buffer is too small for sample, " << bufferSize << " vs "
+                       << sample.info.size;
+            return AMEDIA_ERROR_INVALID_PARAMETER;
+        }
+        memcpy(buffer, sample.data.data(), sample.info.size);
+        popReadAheadSample_l(trackIndex);
+        return AMEDIA_OK;
+    }
+
     ssize_t sampleSize = AMediaExtractor_getSampleSize(mExtractor);
     if (bufferSize < sampleSize) {
         LOG(ERROR) << "Buffer is too small for sample, " << bufferSize << " vs " << sampleSize;
@@ -453,10 +616,12 @@ media_status_t MediaSampleReaderNDK::readSampleDataForTrack(int trackIndex, uint
 void MediaSampleReaderNDK::advanceTrack(int trackIndex) {
     std::scoped_lock lock(mExtractorMutex);
 
-    if (mTrackSignals.find(trackIndex) != mTrackSignals.end()) {
-        advanceTrack_l(trackIndex);
-    } else {
+    if (mTrackSignals.find(trackIndex) == mTrackSignals.end()) {
         LOG(ERROR) << "Trying to advance a track that is not selected (#" << trackIndex << ")";
+    } else if (!mReadAheadQueues[trackIndex].samples.empty()) {
+        popReadAheadSample_l(trackIndex);
+    } else {
+        advanceTrack_l(trackIndex);
     }
 }
 
@@ -18,18 +18,25 @@
 #define LOG_TAG "MediaTranscoder"
 
 #include <android-base/logging.h>
+#include <android-base/properties.h>
 #include <fcntl.h>
 #include <media/MediaSampleReaderNDK.h>
 #include <media/MediaSampleWriter.h>
 #include <media/MediaTranscoder.h>
 #include <media/NdkCommon.h>
 #include <media/PassthroughTrackTranscoder.h>
+#include <media/SegmentedVideoTrackTranscoder.h>
 #include <media/VideoTrackTranscoder.h>
 #include <sys/prctl.h>
 #include <unistd.h>
 
 namespace android {
 
+// Number of segments of a long video track that are transcoded in parallel, each with its own
+// codec instances. Values above 1 enable segmented transcoding.
+static const int32_t kMaxParallelSegments =
+        base::GetIntProperty("debug.media.transcoding.max_parallel_segments", /*default*/ 1);
+
 static std::shared_ptr<AMediaFormat> createVideoTrackFormat(AMediaFormat* srcFormat,
                                                             AMediaFormat* options) {
     if (srcFormat == nullptr || options == nullptr) {
@@ -267,6 +274,12 @@ media_status_t MediaTranscoder::configureSource(int fd) {
         return AMEDIA_ERROR_UNSUPPORTED;
     }
 
+    // Keep a reference to the source so that segmented transcoding can open more readers.
+    if (kMaxParallelSegments > 1) {
+        mSourceFd = std::make_shared<ndk::ScopedFileDescriptor>(dup(fd));
+        mSourceFileSize = fileSize;
+    }
+
     const size_t trackCount = mSampleReader->getTrackCount();
     for (size_t trackIndex = 0; trackIndex < trackCount; ++trackIndex) {
         AMediaFormat* trackFormat = mSampleReader->getTrackFormat(static_cast<int>(trackIndex));
@@ -305,6 +318,7 @@ media_status_t MediaTranscoder::configureTrackFormat(size_t trackIndex,
 
     std::shared_ptr<MediaTrackTranscoder> transcoder;
     std::shared_ptr<AMediaFormat> trackFormat;
+    bool selectTrack = true;
 
     if (destinationOptions == nullptr) {
         transcoder = std::make_shared<PassthroughTrackTranscoder>(shared_from_this());
@@ -333,7 +347,22 @@ media_status_t MediaTranscoder::configureTrackFormat(size_t trackIndex,
             }
         }
 
-        transcoder = VideoTrackTranscoder::create(shared_from_this(), mPid, mUid);
+        int64_t durationUs = 0;
+        if (mSourceFd != nullptr && mSourceFd->get() >= 0 &&
+            AMediaFormat_getInt64(srcTrackFormat, AMEDIAFORMAT_KEY_DURATION, &durationUs) &&
+            durationUs >= 2 * SegmentedVideoTrackTranscoder::kMinSegmentDurationUs) {
+            // Segments read the source through their own readers, so the track is not selected
+            // on the shared reader.
+            auto sampleReaderFactory = [sourceFd = mSourceFd, fileSize = mSourceFileSize] {
+                return MediaSampleReaderNDK::createFromFd(sourceFd->get(), 0 /* offset */,
+                                                          fileSize);
+            };
+            transcoder = SegmentedVideoTrackTranscoder::create(
+                    shared_from_this(), sampleReaderFactory, kMaxParallelSegments, mPid, mUid);
+            selectTrack = false;
+        } else {
+            transcoder = VideoTrackTranscoder::create(shared_from_this(), mPid, mUid);
+        }
 
         trackFormat = createVideoTrackFormat(srcTrackFormat, destinationOptions);
         if (trackFormat == nullptr) {
@@ -342,17 +371,22 @@ media_status_t MediaTranscoder::configureTrackFormat(size_t trackIndex,
         }
     }
 
-    media_status_t status = mSampleReader->selectTrack(trackIndex);
-    if (status != AMEDIA_OK) {
-        LOG(ERROR) << "Unable to select track " << trackIndex;
-        return status;
+    media_status_t status = AMEDIA_OK;
+    if (selectTrack) {
+        status = mSampleReader->selectTrack(trackIndex);
+        if (status != AMEDIA_OK) {
+            LOG(ERROR) << "Unable to select track " << trackIndex;
+            return status;
+        }
     }
 
     status = transcoder->configure(mSampleReader, trackIndex, trackFormat);
     if (status != AMEDIA_OK) {
         LOG(ERROR) << "Configure track transcoder for track #" << trackIndex << " returned error "
                    << status;
-        mSampleReader->unselectTrack(trackIndex);
+        if (selectTrack) {
+            mSampleReader->unselectTrack(trackIndex);
+        }
         return status;
     }
 
@@ -469,6 +503,23 @@ media_status_t MediaTranscoder::cancel() {
     return AMEDIA_OK;
 }
 
+media_status_t MediaTranscoder::setSpeedLimit(int32_t speedLimitPercent) {
+    if (speedLimitPercent <= 0 || speedLimitPercent > 100) {
+        LOG(ERROR) << "Invalid speed limit " << speedLimitPercent;
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+
+    std::scoped_lock lock{mThreadStateMutex};
+    if (mCancelled) {
+        return AMEDIA_ERROR_INVALID_OPERATION;
+    }
+
+    for (auto& transcoder : mTrackTranscoders) {
+        transcoder->setSpeedLimit(speedLimitPercent);
+    }
+    return AMEDIA_OK;
+}
+
 media_status_t MediaTranscoder::resume() {
     // TODO: restore internal states from parcel.
     return start();
@@ -0,0 +1,412 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "SegmentedVideoTrackTranscoder"
+
+#include <android-base/logging.h>
+#include <media/SegmentedVideoTrackTranscoder.h>
+#include <media/VideoTrackTranscoder.h>
+#include <sys/prctl.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace android {
+
+// Maximum number of output bytes buffered for a segment that is waiting for earlier segments to
+// finish. A segment that reaches the limit stalls, so this bounds the memory use of the transcoder
+// to roughly the limit times the number of parallel segments.
+static constexpr size_t kMaxBufferedBytesPerSegment = 32 * 1024 * 1024;
+
+// Bitrate used for planning segments if the destination format does not have one.
+static constexpr int32_t kDefaultBitrate = 10 * 1000 * 1000;
+
+// static
+std::shared_ptr<SegmentedVideoTrackTranscoder> SegmentedVideoTrackTranscoder::create(
+        const std::weak_ptr<MediaTrackTranscoderCallback>& transcoderCallback,
+        const SampleReaderFactory& sampleReaderFactory, int maxParallelSegments, pid_t pid,
+        uid_t uid) {
+    if (sampleReaderFactory == nullptr || maxParallelSegments < 1) {
+        LOG(ERROR) << "Invalid reader factory or parallel segment count " << maxParallelSegments;
+        return nullptr;
+    }
+
+    return std::shared_ptr<SegmentedVideoTrackTranscoder>(new SegmentedVideoTrackTranscoder(
+            transcoderCallback, sampleReaderFactory, maxParallelSegments, pid, uid));
+}
+
+media_status_t SegmentedVideoTrackTranscoder::createSegments(
+        const std::shared_ptr<MediaSampleReader>& reader) {
+    mSegments.clear();
+    mSegments.emplace_back();
+
+    int64_t durationUs = 0;
+    if (!AMediaFormat_getInt64(mSourceFormat.get(), AMEDIAFORMAT_KEY_DURATION, &durationUs) ||
+        durationUs < 2 * kMinSegmentDurationUs || mMaxParallelSegments < 2) {
+        return AMEDIA_OK;
+    }
+
+    int32_t bitrate = kDefaultBitrate;
+    if (!AMediaFormat_getInt32(mDestinationFormat.get(), AMEDIAFORMAT_KEY_BIT_RATE, &bitrate) ||
+        bitrate <= 0) {
+        bitrate = kDefaultBitrate;
+    }
+
+    // Aim for one segment per parallel transcoder, but keep segments short enough that a waiting
+    // segment rarely fills its buffer, and long enough to amortize the codec setup.
+    const int64_t bufferedDurationUs =
+            (int64_t)kMaxBufferedBytesPerSegment * 8 * 1000 * 1000 / bitrate;
+    const int64_t segmentDurationUs =
+            std::max(kMinSegmentDurationUs,
+                     std::min(durationUs / mMaxParallelSegments, bufferedDurationUs));
+
+    int64_t searchTimeUs = segmentDurationUs;
+    while (searchTimeUs < durationUs) {
+        int64_t syncTimeUs = -1;
+        media_status_t status = reader->getNextSyncSampleTime(mTrackIndex, searchTimeUs,
+                                                              &syncTimeUs);
+        if (status != AMEDIA_OK) {
+            if (status == AMEDIA_ERROR_UNSUPPORTED) {
+                LOG(WARNING) << "Source does not support segments, using a single segment";
+                mSegments.resize(1);
+                return AMEDIA_OK;
+            }
+            LOG(ERROR) << "Unable to find sync sample after " << searchTimeUs << ": " << status;
+            return status;
+        }
+
+        // Merge a short tail into the previous segment.
+        if (syncTimeUs < 0 || durationUs - syncTimeUs < kMinSegmentDurationUs / 2) {
+            break;
+        } else if (syncTimeUs <= mSegments.back().startTimeUs) {
+            searchTimeUs += segmentDurationUs;
+            continue;
+        }
+
+        mSegments.back().endTimeUs = syncTimeUs;
+        mSegments.emplace_back().startTimeUs = syncTimeUs;
+        searchTimeUs = syncTimeUs + segmentDurationUs;
+    }
+
+    LOG(INFO) << "Split track #" << mTrackIndex << " into " << mSegments.size() << " segments";
+    return AMEDIA_OK;
+}
+
+media_status_t SegmentedVideoTrackTranscoder::configureSegment(size_t segmentIndex) {
+    Segment& segment = mSegments[segmentIndex];
+    media_status_t status = AMEDIA_OK;
+
+    if (segment.reader == nullptr) {
+        segment.reader = mSampleReaderFactory();
+        if (segment.reader == nullptr) {
+            LOG(ERROR) << "Unable to create sample reader for segment " << segmentIndex;
+            return AMEDIA_ERROR_UNKNOWN;
+        }
+
+        status = segment.reader->selectTrack(mTrackIndex);
+        if (status != AMEDIA_OK) {
+            LOG(ERROR) << "Unable to select track for segment " << segmentIndex;
+            return status;
+        }
+    }
+
+    if (mSegments.size() > 1) {
+        status = segment.reader->seekToSegment(segment.startTimeUs, segment.endTimeUs);
+        if (status != AMEDIA_OK) {
+            LOG(ERROR) << "Unable to seek to segment " << segmentIndex << ": " << status;
+            return status;
+        }
+    }
+
+    auto transcoder = VideoTrackTranscoder::create(shared_from_this(), mPid, mUid);
+    status = transcoder->configure(segment.reader, mTrackIndex, mDestinationFormat);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to configure transcoder for segment " << segmentIndex << ": "
+                   << status;
+        return status;
+    }
+
+    segment.transcoder = std::move(transcoder);
+    return AMEDIA_OK;
+}
+
+media_status_t SegmentedVideoTrackTranscoder::configureDestinationFormat(
+        const std::shared_ptr<AMediaFormat>& destinationFormat) {
+    if (destinationFormat == nullptr) {
+        LOG(ERROR) << "Destination format is null, use passthrough transcoder";
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+
+    AMediaFormat* format = AMediaFormat_new();
+    if (!format || AMediaFormat_copy(format, destinationFormat.get()) != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to copy destination format";
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+    mDestinationFormat = std::shared_ptr<AMediaFormat>(format, &AMediaFormat_delete);
+
+    // The first segment's reader is used to plan the segments before it starts reading.
+    std::shared_ptr<MediaSampleReader> reader = mSampleReaderFactory();
+    if (reader == nullptr) {
+        LOG(ERROR) << "Unable to create sample reader";
+        return AMEDIA_ERROR_UNKNOWN;
+    }
+
+    media_status_t status = reader->selectTrack(mTrackIndex);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to select track #" << mTrackIndex;
+        return status;
+    }
+
+    // Estimate the bitrate once so that all segments are encoded at the same rate.
+    int32_t bitrate;
+    if (!AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_BIT_RATE, &bitrate) &&
+        reader->getEstimatedBitrateForTrack(mTrackIndex, &bitrate) == AMEDIA_OK) {
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_BIT_RATE, bitrate);
+    }
+
+    status = createSegments(reader);
+    if (status != AMEDIA_OK) {
+        return status;
+    }
+    mSegments[0].reader = reader;
+
+    // Configure the first segment up front so that any configuration error is reported now.
+    return configureSegment(0);
+}
+
+std::shared_ptr<AMediaFormat> SegmentedVideoTrackTranscoder::getOutputFormat() const {
+    // All segments share the encoder configuration, so the first segment's format describes the
+    // whole track.
+    if (mSegments.empty() || mSegments[0].transcoder == nullptr) {
+        return nullptr;
+    }
+    return mSegments[0].transcoder->getOutputFormat();
+}
+
+media_status_t SegmentedVideoTrackTranscoder::startSegment_l(size_t segmentIndex) {
+    Segment& segment = mSegments[segmentIndex];
+
+    std::weak_ptr<SegmentedVideoTrackTranscoder> weakThis = shared_from_this();
+    segment.transcoder->setSampleConsumer(
+            [weakThis, segmentIndex](const std::shared_ptr<MediaSample>& sample) {
+                if (auto transcoder = weakThis.lock()) {
+                    transcoder->onSegmentSample(segmentIndex, sample);
+                }
+            });
+
+    if (mSpeedLimitPercent < 100) {
+        segment.transcoder->setSpeedLimit(mSpeedLimitPercent);
+    }
+
+    if (!segment.transcoder->start()) {
+        LOG(ERROR) << "Unable to start segment " << segmentIndex;
+        return AMEDIA_ERROR_UNKNOWN;
+    }
+
+    segment.state = Segment::RUNNING;
+    ++mRunningSegments;
+    return AMEDIA_OK;
+}
+
+void SegmentedVideoTrackTranscoder::setSpeedLimit(int32_t speedLimitPercent) {
+    std::scoped_lock lock(mMutex);
+    mSpeedLimitPercent = speedLimitPercent;
+    for (Segment& segment : mSegments) {
+        if (segment.state == Segment::RUNNING) {
+            segment.transcoder->setSpeedLimit(speedLimitPercent);
+        }
+    }
+}
+
+media_status_t SegmentedVideoTrackTranscoder::runTranscodeLoop(bool* stopped)
+        NO_THREAD_SAFETY_ANALYSIS {
+    prctl(PR_SET_NAME, (unsigned long)"SegmentsThread", 0, 0, 0);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    size_t nextSegment = 0;
+    bool segmentsStopped = false;
+
+    while (true) {
+        // Start segments while there are free transcoder slots.
+        while (!mAborted && mStatus == AMEDIA_OK && nextSegment < mSegments.size() &&
+               mRunningSegments < mMaxParallelSegments) {
+            media_status_t status = AMEDIA_OK;
+            if (mSegments[nextSegment].transcoder == nullptr) {
+                // Codec setup is slow, so don't hold up the running segments while it happens.
+                lock.unlock();
+                status = configureSegment(nextSegment);
+                lock.lock();
+            }
+            if (status == AMEDIA_OK) {
+                status = startSegment_l(nextSegment);
+            }
+
+            if (status == AMEDIA_OK) {
+                ++nextSegment;
+            } else if (mRunningSegments > 0) {
+                // Most likely out of codec instances. Retry once a running segment is done.
+                LOG(WARNING) << "Unable to start segment " << nextSegment << " (" << status
+                             << "), limiting parallel segments to " << mRunningSegments;
+                mMaxParallelSegments = mRunningSegments;
+                mSegments[nextSegment].transcoder.reset();
+            } else {
+                mStatus = status;
+            }
+        }
+
+        // Stop the running segments once if transcoding should end early.
+        if ((mAborted || mStatus != AMEDIA_OK) && !segmentsStopped) {
+            for (size_t i = 0; i < mSegments.size(); ++i) {
+                if (mSegments[i].state == Segment::RUNNING) {
+                    // The first segment can stop on a sync sample since its output is already
+                    // forwarded. Any output of later segments would be discarded.
+                    mSegments[i].transcoder->stop(i == mHeadSegment &&
+                                                  mStopRequest == STOP_ON_SYNC);
+                }
+            }
+            segmentsStopped = true;
+        }
+
+        const bool allStarted = nextSegment == mSegments.size() || segmentsStopped;
+        if (mRunningSegments == 0 && allStarted) {
+            break;
+        }
+        mCondition.wait(lock);
+    }
+
+    *stopped = mAborted && mStatus == AMEDIA_OK;
+    return mStatus;
+}
+
+void SegmentedVideoTrackTranscoder::abortTranscodeLoop() {
+    std::scoped_lock lock(mMutex);
+    mAborted = true;
+    mCondition.notify_all();
+}
+
+void SegmentedVideoTrackTranscoder::onSegmentSample(size_t segmentIndex,
+                                                    const std::shared_ptr<MediaSample>& sample)
+        NO_THREAD_SAFETY_ANALYSIS {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    // Only the first segment's codec config is used. Samples from segments after the first
+    // unfinished one are dropped once stopped since they can never be written in order.
+    if ((sample->info.flags & SAMPLE_FLAG_CODEC_CONFIG) && segmentIndex > 0) {
+        return;
+    } else if ((mAborted || mStatus != AMEDIA_OK) && segmentIndex != mHeadSegment) {
+        return;
+    }
+
+    // Only the last segment ends the stream. If this transcoder was stopped the stream is ended by
+    // MediaTrackTranscoder instead.
+    const bool endsStream = segmentIndex == mSegments.size() - 1 && !mAborted;
+    if ((sample->info.flags & SAMPLE_FLAG_END_OF_STREAM) && !endsStream) {
+        if (sample->info.size == 0) {
+            return;
+        }
+        sample->info.flags &= ~SAMPLE_FLAG_END_OF_STREAM;
+    }
+
+    if (segmentIndex == mHeadSegment) {
+        onOutputSampleAvailable(sample);
+        return;
+    }
+
+    // Copy the sample so that the encoder buffer is returned while the segment waits its turn.
+    uint8_t* buffer = new (std::nothrow) uint8_t[std::max(sample->info.size, (size_t)1)];
+    if (buffer == nullptr) {
+        LOG(ERROR) << "Unable to allocate " << sample->info.size << " bytes for segment sample";
+        mStatus = AMEDIA_ERROR_IO;
+        mCondition.notify_all();
+        return;
+    }
+    memcpy(buffer, sample->buffer + sample->dataOffset, sample->info.size);
+
+    std::shared_ptr<MediaSample> outputSample = MediaSample::createWithReleaseCallback(
+            buffer, 0 /* offset */, 0 /* bufferId */,
+            [](MediaSample* sample) { delete[] sample->buffer; });
+    outputSample->info = sample->info;
+
+    Segment& segment = mSegments[segmentIndex];
+    segment.bufferedSamples.push_back(outputSample);
+    segment.bufferedBytes += outputSample->info.size;
+
+    // Stall the segment's transcoder while its buffer is full and it is still waiting its turn.
+    while (segment.bufferedBytes > kMaxBufferedBytesPerSegment && segmentIndex != mHeadSegment &&
+           !mAborted && mStatus == AMEDIA_OK) {
+        mCondition.wait(lock);
+    }
+}
+
+void SegmentedVideoTrackTranscoder::onSegmentDone(const MediaTrackTranscoder* transcoder,
+                                                  media_status_t status) {
+    std::scoped_lock lock(mMutex);
+
+    auto it = std::find_if(mSegments.begin(), mSegments.end(), [transcoder](const Segment& s) {
+        return s.transcoder.get() == transcoder;
+    });
+    if (it == mSegments.end()) {
+        LOG(WARNING) << "Ignoring unknown segment transcoder " << transcoder;
+        return;
+    }
+
+    it->state = Segment::DONE;
+    --mRunningSegments;
+    if (status != AMEDIA_OK && mStatus == AMEDIA_OK) {
+        mStatus = status;
+    }
+
+    // Forward the output of the following segments in order, up to the first one still running.
+    while (!mAborted && mStatus == AMEDIA_OK && mHeadSegment < mSegments.size() &&
+           mSegments[mHeadSegment].state == Segment::DONE) {
+        if (++mHeadSegment == mSegments.size()) {
+            break;
+        }
+
+        Segment& head = mSegments[mHeadSegment];
+        for (const auto& sample : head.bufferedSamples) {
+            onOutputSampleAvailable(sample);
+        }
+        head.bufferedSamples.clear();
+        head.bufferedBytes = 0;
+    }
+
+    mCondition.notify_all();
+}
+
+void SegmentedVideoTrackTranscoder::onTrackFormatAvailable(
+        const MediaTrackTranscoder* transcoder) {
+    if (!mSegments.empty() && transcoder == mSegments[0].transcoder.get()) {
+        notifyTrackFormatAvailable();
+    }
+}
+
+void SegmentedVideoTrackTranscoder::onTrackFinished(const MediaTrackTranscoder* transcoder) {
+    onSegmentDone(transcoder, AMEDIA_OK);
+}
+
+void SegmentedVideoTrackTranscoder::onTrackStopped(const MediaTrackTranscoder* transcoder) {
+    onSegmentDone(transcoder, AMEDIA_OK);
+}
+
+void SegmentedVideoTrackTranscoder::onTrackError(const MediaTrackTranscoder* transcoder,
+                                                 media_status_t status) {
+    LOG(ERROR) << "Segment transcoder " << transcoder << " returned error " << status;
+    onSegmentDone(transcoder, status);
+}
+
+}  // namespace android
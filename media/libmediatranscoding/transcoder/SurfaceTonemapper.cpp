@@ -0,0 +1,562 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "SurfaceTonemapper"
+
+#include <android-base/logging.h>
+#include <android/hardware_buffer.h>
+#include <media/NdkCommon.h>
+#include <media/SurfaceTonemapper.h>
+#include <sys/prctl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+namespace android {
+
+// Number of decoded frames that can be in flight between the decoder and the render thread.
+static constexpr int32_t kMaxImages = 4;
+// Max time to wait for the render thread to catch up with the decoder.
+static constexpr std::chrono::seconds kRenderTimeout(2);
+// Luminance of SDR white, same as the default used for HDR frame capture.
+static constexpr float kSdrMaxLuminance = 500.0f;
+// Max content luminance assumed when the source does not carry HDR static info.
+static constexpr float kDefaultMaxInputLuminance = 1000.0f;
+
+static const char* kVertexShader = R"__SHADER__(
+attribute vec2 aPosition;
+uniform vec4 uCrop;
+varying vec2 vTexCoord;
+
+void main() {
+    gl_Position = vec4(aPosition, 0.0, 1.0);
+    // The first row of the image is at the top of the output.
+    vTexCoord = uCrop.xy + (aPosition * vec2(0.5, -0.5) + 0.5) * uCrop.zw;
+}
+)__SHADER__";
+
+// The EOTF, luminance scaling, tone mapping and normalization steps mirror the HDR to SDR path of
+// renderfright's ProgramCache.
+static const char* kFragmentShader = R"__SHADER__(
+uniform samplerExternalOES uTexture;
+varying vec2 vTexCoord;
+
+// D65 conversions for the BT.2020 and BT.709 primaries.
+const highp mat3 kBt2020ToXyz = mat3(
+        0.6369580, 0.2627002, 0.0000000,
+        0.1446169, 0.6779981, 0.0280727,
+        0.1688810, 0.0593017, 1.0609851);
+const highp mat3 kXyzToBt709 = mat3(
+        3.2409699, -0.9692436, 0.0556301,
+        -1.5373832, 1.8759675, -0.2039770,
+        -0.4986108, 0.0415551, 1.0569715);
+
+#ifdef TRANSFER_ST2084
+highp vec3 EOTF(const highp vec3 color) {
+    const highp float m1 = (2610.0 / 4096.0) / 4.0;
+    const highp float m2 = (2523.0 / 4096.0) * 128.0;
+    const highp float c1 = (3424.0 / 4096.0);
+    const highp float c2 = (2413.0 / 4096.0) * 32.0;
+    const highp float c3 = (2392.0 / 4096.0) * 32.0;
+
+    highp vec3 tmp = pow(clamp(color, 0.0, 1.0), 1.0 / vec3(m2));
+    tmp = max(tmp - c1, 0.0) / (c2 - c3 * tmp);
+    return pow(tmp, 1.0 / vec3(m1));
+}
+
+highp vec3 ScaleLuminance(highp vec3 color) {
+    return color * 10000.0;
+}
+
+highp vec3 ToneMap(highp vec3 color) {
+    float maxInLumi = MAX_INPUT_LUMINANCE;
+    float maxOutLumi = MAX_OUTPUT_LUMINANCE;
+
+    float nits = clamp(color.y, 0.0, maxInLumi);
+
+    // scale [0.0, maxInLumi] to [0.0, maxOutLumi]
+    if (maxInLumi <= maxOutLumi) {
+        return color * (maxOutLumi / maxInLumi);
+    }
+
+    // three control points
+    const float x0 = 10.0;
+    const float y0 = 17.0;
+    float x1 = maxOutLumi * 0.75;
+    float y1 = x1;
+    float x2 = x1 + (maxInLumi - x1) / 2.0;
+    float y2 = y1 + (maxOutLumi - y1) * 0.75;
+
+    // horizontal distances between the last three control points
+    float h12 = x2 - x1;
+    float h23 = maxInLumi - x2;
+    // tangents at the last three control points
+    float m1 = (y2 - y1) / h12;
+    float m3 = (maxOutLumi - y2) / h23;
+    float m2 = (m1 + m3) / 2.0;
+
+    if (nits < x0) {
+        // scale [0.0, x0] to [0.0, y0] linearly
+        return color * (y0 / x0);
+    } else if (nits < x1) {
+        // scale [x0, x1] to [y0, y1] linearly
+        nits = y0 + (nits - x0) * (y1 - y0) / (x1 - x0);
+    } else if (nits < x2) {
+        // scale [x1, x2] to [y1, y2] using Hermite interp
+        float t = (nits - x1) / h12;
+        nits = (y1 * (1.0 + 2.0 * t) + h12 * m1 * t) * (1.0 - t) * (1.0 - t) +
+                (y2 * (3.0 - 2.0 * t) + h12 * m2 * (t - 1.0)) * t * t;
+    } else {
+        // scale [x2, maxInLumi] to [y2, maxOutLumi] using Hermite interp
+        float t = (nits - x2) / h23;
+        nits = (y2 * (1.0 + 2.0 * t) + h23 * m2 * t) * (1.0 - t) * (1.0 - t) +
+                (maxOutLumi * (3.0 - 2.0 * t) + h23 * m3 * (t - 1.0)) * t * t;
+    }
+
+    // color.y is greater than x0 and is thus non-zero
+    return color * (nits / color.y);
+}
+#else  // HLG
+highp float EOTF_channel(const highp float channel) {
+    const highp float a = 0.17883277;
+    const highp float b = 0.28466892;
+    const highp float c = 0.55991073;
+    return channel <= 0.5 ? channel * channel / 3.0 : (exp((channel - c) / a) + b) / 12.0;
+}
+
+highp vec3 EOTF(const highp vec3 color) {
+    return vec3(EOTF_channel(color.r), EOTF_channel(color.g), EOTF_channel(color.b));
+}
+
+highp vec3 ScaleLuminance(highp vec3 color) {
+    // The HLG OOTF with a system gamma of 1.2.
+    return color * MAX_OUTPUT_LUMINANCE * pow(color.y, 0.2);
+}
+
+highp vec3 ToneMap(highp vec3 color) {
+    return color;
+}
+#endif
+
+highp vec3 NormalizeLuminance(highp vec3 color) {
+    return color / MAX_OUTPUT_LUMINANCE;
+}
+
+highp float OETF_channel(const highp float channel) {
+    return channel < 0.018 ? channel * 4.5 : 1.099 * pow(channel, 0.45) - 0.099;
+}
+
+highp vec3 OETF(const highp vec3 linear) {
+    return vec3(OETF_channel(linear.r), OETF_channel(linear.g), OETF_channel(linear.b));
+}
+
+void main() {
+    highp vec3 color = kBt2020ToXyz * EOTF(texture2D(uTexture, vTexCoord).rgb);
+    color = NormalizeLuminance(ToneMap(ScaleLuminance(color)));
+    color = clamp(kXyzToBt709 * color, 0.0, 1.0);
+    gl_FragColor = vec4(OETF(color), 1.0);
+}
+)__SHADER__";
+
+// Full screen quad as a triangle strip.
+static const GLfloat kVertices[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+
+// Reads the max luminance of the content from HDR static info (see HDRStaticInfo in ColorUtils),
+// i.e. the lower of the mastering display max luminance and the max content light level.
+static float GetMaxInputLuminance(AMediaFormat* format) {
+    void* data = nullptr;
+    size_t size = 0;
+    if (!AMediaFormat_getBuffer(format, AMEDIAFORMAT_KEY_HDR_STATIC_INFO, &data, &size) ||
+        size < 25) {
+        return kDefaultMaxInputLuminance;
+    }
+
+    const uint8_t* info = static_cast<const uint8_t*>(data);
+    auto readU16 = [info](size_t offset) { return info[offset] | (info[offset + 1] << 8); };
+    const float maxDisplayLuminance = readU16(17);
+    const float maxContentLightLevel = readU16(21);
+
+    float maxLuminance = kDefaultMaxInputLuminance;
+    if (maxDisplayLuminance > 0 && maxContentLightLevel > 0) {
+        maxLuminance = std::min(maxDisplayLuminance, maxContentLightLevel);
+    } else if (maxDisplayLuminance > 0 || maxContentLightLevel > 0) {
+        maxLuminance = std::max(maxDisplayLuminance, maxContentLightLevel);
+    }
+    return maxLuminance;
+}
+
+static GLuint CompileShader(GLenum type, const std::string& source) {
+    GLuint shader = glCreateShader(type);
+    const char* sourcePtr = source.c_str();
+    glShaderSource(shader, 1, &sourcePtr, nullptr);
+    glCompileShader(shader);
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        char log[512] = {};
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        LOG(ERROR) << "Unable to compile shader: " << log;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// static
+std::shared_ptr<SurfaceTonemapper> SurfaceTonemapper::create(AMediaFormat* sourceFormat,
+                                                             ANativeWindow* outputSurface) {
+    if (sourceFormat == nullptr || outputSurface == nullptr) {
+        LOG(ERROR) << "Source format and output surface are required";
+        return nullptr;
+    }
+
+    int32_t width, height;
+    if (!AMediaFormat_getInt32(sourceFormat, AMEDIAFORMAT_KEY_WIDTH, &width) ||
+        !AMediaFormat_getInt32(sourceFormat, AMEDIAFORMAT_KEY_HEIGHT, &height) || width <= 0 ||
+        height <= 0) {
+        LOG(ERROR) << "Source format does not have a valid size";
+        return nullptr;
+    }
+
+    // HDR static info without a transfer function is assumed to be HDR10.
+    int32_t transfer = COLOR_TRANSFER_ST2084;
+    AMediaFormat_getInt32(sourceFormat, AMEDIAFORMAT_KEY_COLOR_TRANSFER, &transfer);
+    if (transfer != COLOR_TRANSFER_ST2084 && transfer != COLOR_TRANSFER_HLG) {
+        LOG(ERROR) << "Unsupported transfer function for tonemapping: " << transfer;
+        return nullptr;
+    }
+
+    auto tonemapper = std::shared_ptr<SurfaceTonemapper>(
+            new SurfaceTonemapper(transfer, GetMaxInputLuminance(sourceFormat)));
+    if (tonemapper->init(width, height, outputSurface) != AMEDIA_OK) {
+        return nullptr;
+    }
+    return tonemapper;
+}
+
+SurfaceTonemapper::~SurfaceTonemapper() {
+    if (mImageReader != nullptr) {
+        AImageReader_setImageListener(mImageReader, nullptr);
+    }
+
+    {
+        std::scoped_lock lock(mMutex);
+        mStopping = true;
+    }
+    mCondition.notify_all();
+    if (mRenderThread.joinable()) {
+        mRenderThread.join();
+    }
+
+    if (mImageReader != nullptr) {
+        AImageReader_delete(mImageReader);
+    }
+}
+
+// static
+void SurfaceTonemapper::onImageAvailable(void* context, AImageReader* reader __unused) {
+    SurfaceTonemapper* tonemapper = static_cast<SurfaceTonemapper*>(context);
+    {
+        std::scoped_lock lock(tonemapper->mMutex);
+        ++tonemapper->mAvailableImages;
+    }
+    tonemapper->mCondition.notify_all();
+}
+
+media_status_t SurfaceTonemapper::init(int32_t width, int32_t height,
+                                       ANativeWindow* outputSurface) {
+    media_status_t status =
+            AImageReader_newWithUsage(width, height, AIMAGE_FORMAT_PRIVATE,
+                                      AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE, kMaxImages,
+                                      &mImageReader);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to create image reader: " << status;
+        return status;
+    }
+
+    AImageReader_ImageListener listener{.context = this,
+                                        .onImageAvailable = &SurfaceTonemapper::onImageAvailable};
+    status = AImageReader_setImageListener(mImageReader, &listener);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to set image listener: " << status;
+        return status;
+    }
+
+    status = AImageReader_getWindow(mImageReader, &mInputSurface);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to get image reader window: " << status;
+        return status;
+    }
+
+    mRenderThread = std::thread(&SurfaceTonemapper::renderLoop, this, outputSurface);
+
+    std::unique_lock lock(mMutex);
+    mCondition.wait(lock, [this] { return mInitDone; });
+    return mInitOk ? AMEDIA_OK : AMEDIA_ERROR_UNSUPPORTED;
+}
+
+bool SurfaceTonemapper::waitForRenderedFrames(uint64_t frameCount) {
+    std::unique_lock lock(mMutex);
+    mCondition.wait_for(lock, kRenderTimeout,
+                        [this, frameCount] { return mRenderedFrames >= frameCount || mRenderError; });
+    return mRenderedFrames >= frameCount;
+}
+
+void SurfaceTonemapper::renderLoop(ANativeWindow* outputSurface) {
+    prctl(PR_SET_NAME, (unsigned long)"TonemapRender", 0, 0, 0);
+
+    const bool initOk = initGl(outputSurface);
+    {
+        std::scoped_lock lock(mMutex);
+        mInitDone = true;
+        mInitOk = initOk;
+    }
+    mCondition.notify_all();
+
+    while (initOk) {
+        {
+            std::unique_lock lock(mMutex);
+            mCondition.wait(lock, [this] { return mStopping || mAvailableImages > 0; });
+            if (mStopping) break;
+            --mAvailableImages;
+        }
+
+        AImage* image = nullptr;
+        media_status_t status = AImageReader_acquireNextImage(mImageReader, &image);
+        if (status == AMEDIA_IMGREADER_NO_BUFFER_AVAILABLE) continue;
+        const bool rendered = status == AMEDIA_OK && renderImage(image);
+
+        {
+            std::scoped_lock lock(mMutex);
+            if (rendered) {
+                ++mRenderedFrames;
+            } else {
+                LOG(ERROR) << "Unable to render frame: " << status;
+                mRenderError = true;
+            }
+        }
+        mCondition.notify_all();
+    }
+
+    releaseGl();
+}
+
+bool SurfaceTonemapper::initGl(ANativeWindow* outputSurface) {
+    mDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (mDisplay == EGL_NO_DISPLAY || !eglInitialize(mDisplay, nullptr, nullptr)) {
+        LOG(ERROR) << "Unable to initialize EGL display";
+        return false;
+    }
+
+    const EGLint configAttribs[] = {EGL_RED_SIZE,
+                                    8,
+                                    EGL_GREEN_SIZE,
+                                    8,
+                                    EGL_BLUE_SIZE,
+                                    8,
+                                    EGL_ALPHA_SIZE,
+                                    8,
+                                    EGL_RENDERABLE_TYPE,
+                                    EGL_OPENGL_ES2_BIT,
+                                    EGL_SURFACE_TYPE,
+                                    EGL_WINDOW_BIT,
+                                    EGL_RECORDABLE_ANDROID,
+                                    EGL_TRUE,
+                                    EGL_NONE};
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(mDisplay, configAttribs, &config, 1, &configCount) || configCount < 1) {
+        LOG(ERROR) << "No recordable EGL config";
+        return false;
+    }
+
+    const EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+    mContext = eglCreateContext(mDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+    if (mContext == EGL_NO_CONTEXT) {
+        LOG(ERROR) << "Unable to create EGL context: " << eglGetError();
+        return false;
+    }
+
+    const EGLint surfaceAttribs[] = {EGL_NONE};
+    mEglSurface = eglCreateWindowSurface(mDisplay, config, outputSurface, surfaceAttribs);
+    if (mEglSurface == EGL_NO_SURFACE) {
+        LOG(ERROR) << "Unable to create EGL window surface: " << eglGetError();
+        return false;
+    }
+
+    if (!eglMakeCurrent(mDisplay, mEglSurface, mEglSurface, mContext)) {
+        LOG(ERROR) << "Unable to make EGL context current: " << eglGetError();
+        return false;
+    }
+
+    mGetNativeClientBuffer = reinterpret_cast<PFNEGLGETNATIVECLIENTBUFFERANDROIDPROC>(
+            eglGetProcAddress("eglGetNativeClientBufferANDROID"));
+    mCreateImage =
+            reinterpret_cast<PFNEGLCREATEIMAGEKHRPROC>(eglGetProcAddress("eglCreateImageKHR"));
+    mDestroyImage =
+            reinterpret_cast<PFNEGLDESTROYIMAGEKHRPROC>(eglGetProcAddress("eglDestroyImageKHR"));
+    mPresentationTime = reinterpret_cast<PFNEGLPRESENTATIONTIMEANDROIDPROC>(
+            eglGetProcAddress("eglPresentationTimeANDROID"));
+    mImageTargetTexture = reinterpret_cast<PFNGLEGLIMAGETARGETTEXTURE2DOESPROC>(
+            eglGetProcAddress("glEGLImageTargetTexture2DOES"));
+    if (mGetNativeClientBuffer == nullptr || mCreateImage == nullptr ||
+        mDestroyImage == nullptr || mPresentationTime == nullptr ||
+        mImageTargetTexture == nullptr) {
+        LOG(ERROR) << "Required EGL extensions are not available";
+        return false;
+    }
+
+    // Native fences let the decoder reuse a buffer as soon as the GPU is done with it, without
+    // stalling the render thread. Fall back to glFinish without them.
+    mCreateSync = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(eglGetProcAddress("eglCreateSyncKHR"));
+    mDestroySync =
+            reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(eglGetProcAddress("eglDestroySyncKHR"));
+    mDupNativeFenceFd = reinterpret_cast<PFNEGLDUPNATIVEFENCEFDANDROIDPROC>(
+            eglGetProcAddress("eglDupNativeFenceFDANDROID"));
+
+    std::string fragmentSource = "#extension GL_OES_EGL_image_external : require\n";
+    fragmentSource += "precision highp float;\n";
+    if (mTransfer == COLOR_TRANSFER_ST2084) {
+        fragmentSource += "#define TRANSFER_ST2084\n";
+    }
+    fragmentSource += "#define MAX_INPUT_LUMINANCE " + std::to_string(mMaxInputLuminance) + "\n";
+    fragmentSource += "#define MAX_OUTPUT_LUMINANCE " + std::to_string(kSdrMaxLuminance) + "\n";
+    fragmentSource += kFragmentShader;
+
+    GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, kVertexShader);
+    GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    if (vertexShader == 0 || fragmentShader == 0) {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return false;
+    }
+
+    mProgram = glCreateProgram();
+    glAttachShader(mProgram, vertexShader);
+    glAttachShader(mProgram, fragmentShader);
+    glBindAttribLocation(mProgram, 0, "aPosition");
+    glLinkProgram(mProgram);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(mProgram, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        LOG(ERROR) << "Unable to link tonemapping program";
+        return false;
+    }
+    glUseProgram(mProgram);
+    glUniform1i(glGetUniformLocation(mProgram, "uTexture"), 0);
+    mCropLocation = glGetUniformLocation(mProgram, "uCrop");
+
+    glGenTextures(1, &mTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, mTexture);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, kVertices);
+    glEnableVertexAttribArray(0);
+
+    // The encoder may scale, so render to whatever size its surface has.
+    EGLint surfaceWidth = 0, surfaceHeight = 0;
+    eglQuerySurface(mDisplay, mEglSurface, EGL_WIDTH, &surfaceWidth);
+    eglQuerySurface(mDisplay, mEglSurface, EGL_HEIGHT, &surfaceHeight);
+    glViewport(0, 0, surfaceWidth, surfaceHeight);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+void SurfaceTonemapper::releaseGl() {
+    if (mDisplay == EGL_NO_DISPLAY) return;
+
+    if (mContext != EGL_NO_CONTEXT) {
+        if (mProgram != 0) glDeleteProgram(mProgram);
+        if (mTexture != 0) glDeleteTextures(1, &mTexture);
+    }
+    eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (mEglSurface != EGL_NO_SURFACE) eglDestroySurface(mDisplay, mEglSurface);
+    if (mContext != EGL_NO_CONTEXT) eglDestroyContext(mDisplay, mContext);
+    eglReleaseThread();
+    eglTerminate(mDisplay);
+
+    mEglSurface = EGL_NO_SURFACE;
+    mContext = EGL_NO_CONTEXT;
+    mDisplay = EGL_NO_DISPLAY;
+}
+
+bool SurfaceTonemapper::renderImage(AImage* image) {
+    AHardwareBuffer* buffer = nullptr;
+    int64_t timestampNs = 0;
+    AImageCropRect crop;
+    if (AImage_getHardwareBuffer(image, &buffer) != AMEDIA_OK ||
+        AImage_getTimestamp(image, &timestampNs) != AMEDIA_OK ||
+        AImage_getCropRect(image, &crop) != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to get image buffer";
+        AImage_delete(image);
+        return false;
+    }
+
+    const EGLint imageAttribs[] = {EGL_IMAGE_PRESERVED_KHR, EGL_TRUE, EGL_NONE};
+    EGLImageKHR eglImage = mCreateImage(mDisplay, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_ANDROID,
+                                        mGetNativeClientBuffer(buffer), imageAttribs);
+    if (eglImage == EGL_NO_IMAGE_KHR) {
+        LOG(ERROR) << "Unable to create EGL image: " << eglGetError();
+        AImage_delete(image);
+        return false;
+    }
+
+    AHardwareBuffer_Desc desc;
+    AHardwareBuffer_describe(buffer, &desc);
+
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, mTexture);
+    mImageTargetTexture(GL_TEXTURE_EXTERNAL_OES, static_cast<GLeglImageOES>(eglImage));
+    glUniform4f(mCropLocation, (float)crop.left / desc.width, (float)crop.top / desc.height,
+                (float)(crop.right - crop.left) / desc.width,
+                (float)(crop.bottom - crop.top) / desc.height);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    mPresentationTime(mDisplay, mEglSurface, timestampNs);
+    const bool swapped = eglSwapBuffers(mDisplay, mEglSurface);
+    if (!swapped) {
+        LOG(ERROR) << "Unable to swap buffers: " << eglGetError();
+    }
+
+    // Return the decoded buffer once the GPU has finished reading from it.
+    int releaseFenceFd = -1;
+    if (mCreateSync != nullptr && mDestroySync != nullptr && mDupNativeFenceFd != nullptr) {
+        EGLSyncKHR sync = mCreateSync(mDisplay, EGL_SYNC_NATIVE_FENCE_ANDROID, nullptr);
+        if (sync != EGL_NO_SYNC_KHR) {
+            glFlush();
+            releaseFenceFd = mDupNativeFenceFd(mDisplay, sync);
+            mDestroySync(mDisplay, sync);
+        }
+    }
+    if (releaseFenceFd < 0) {
+        glFinish();
+    }
+
+    mDestroyImage(mDisplay, eglImage);
+    AImage_deleteAsync(image, releaseFenceFd);
+    return swapped;
+}
+
+}  // namespace android
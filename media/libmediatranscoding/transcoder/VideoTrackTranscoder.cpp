@@ -23,6 +23,8 @@
 #include <media/VideoTrackTranscoder.h>
 #include <sys/prctl.h>
 
+#include <algorithm>
+
 using namespace AMediaFormatUtils;
 
 namespace android {
@@ -52,6 +54,12 @@ static constexpr int32_t kDefaultBitrateMbps = 10 * 1000 * 1000;
 static constexpr int32_t kDefaultFrameRate = 30;
 // Default codec complexity
 static constexpr int32_t kDefaultCodecComplexity = 1;
+// Operating rate that requests the codecs to run as fast as possible.
+// (See MediaFormat#KEY_OPERATING_RATE.)
+static constexpr float kMaxOperatingRate = 32767.0f;
+// Whether HDR to SDR conversion falls back to the GPU when the decoder does not support it.
+static const bool kGpuTonemappingEnabled =
+        base::GetBoolProperty("debug.media.transcoding.gpu_tonemapping", /*default*/ true);
 
 template <typename T>
 void VideoTrackTranscoder::BlockingQueue<T>::push(T const& value, bool front) {
@@ -107,6 +115,7 @@ public:
     AMediaCodec* getCodec() { return mCodec; }
     std::shared_ptr<VideoTrackTranscoder> getTranscoder() const { return mTranscoder.lock(); };
     void setStarted() { mCodecStarted = true; }
+    bool isStarted() const { return mCodecStarted; }
 
 private:
     AMediaCodec* mCodec;
@@ -365,7 +374,11 @@ media_status_t VideoTrackTranscoder::configureDestinationFormat(
             AMediaFormat_delete(inputFormat);
         }
 
-        if (!supported) {
+        if (!supported && kGpuTonemappingEnabled) {
+            LOG(INFO) << "HDR to SDR conversion unsupported by the codec, tonemapping on the GPU";
+            status = configureTonemapper(decoderFormat.get());
+            if (status != AMEDIA_OK) return status;
+        } else if (!supported) {
             LOG(ERROR) << "HDR to SDR conversion unsupported by the codec";
             return AMEDIA_ERROR_UNSUPPORTED;
         }
@@ -397,6 +410,42 @@ media_status_t VideoTrackTranscoder::configureDestinationFormat(
     return AMEDIA_OK;
 }
 
+media_status_t VideoTrackTranscoder::configureTonemapper(AMediaFormat* decoderFormat) {
+    mTonemapper = SurfaceTonemapper::create(mSourceFormat.get(), mSurface);
+    if (mTonemapper == nullptr) {
+        LOG(ERROR) << "HDR to SDR conversion unsupported by the GPU";
+        return AMEDIA_ERROR_UNSUPPORTED;
+    }
+
+    // Reconfigure the decoder to render its HDR output to the tonemapper instead of the encoder.
+    media_status_t status = AMediaCodec_stop(mDecoder);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to reset video decoder: " << status;
+        return status;
+    }
+
+    status = AMediaCodec_configure(mDecoder, decoderFormat, mTonemapper->getInputSurface(),
+                                   NULL /* crypto */, 0 /* flags */);
+    if (status != AMEDIA_OK) {
+        LOG(ERROR) << "Unable to configure video decoder for tonemapping: " << status;
+        return status;
+    }
+
+    // The encoder input is SDR regardless of the color information the decoder reports.
+    AMediaFormat* params = AMediaFormat_new();
+    if (params != nullptr) {
+        AMediaFormat_setInt32(params, AMEDIAFORMAT_KEY_COLOR_STANDARD, COLOR_STANDARD_BT709);
+        AMediaFormat_setInt32(params, AMEDIAFORMAT_KEY_COLOR_TRANSFER, COLOR_TRANSFER_SDR_VIDEO);
+        AMediaFormat_setInt32(params, AMEDIAFORMAT_KEY_COLOR_RANGE, COLOR_RANGE_LIMITED);
+        if (AMediaCodec_setParameters(mEncoder->getCodec(), params) != AMEDIA_OK) {
+            LOG(WARNING) << "Unable to update encoder with SDR color information";
+        }
+        AMediaFormat_delete(params);
+    }
+
+    return AMEDIA_OK;
+}
+
 void VideoTrackTranscoder::enqueueInputSample(int32_t bufferIndex) {
     media_status_t status = AMEDIA_OK;
 
@@ -454,10 +503,17 @@ void VideoTrackTranscoder::transferBuffer(int32_t bufferIndex, AMediaCodecBuffer
     if (bufferIndex >= 0) {
         bool needsRender = bufferInfo.size > 0;
         AMediaCodec_releaseOutputBuffer(mDecoder, bufferIndex, needsRender);
+        if (needsRender && mTonemapper != nullptr) {
+            ++mTonemapperFrameCount;
+        }
     }
 
     if (bufferInfo.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) {
         LOG(DEBUG) << "EOS from decoder.";
+        // Let the tonemapper finish rendering to the encoder before signaling EOS to it.
+        if (mTonemapper != nullptr && !mTonemapper->waitForRenderedFrames(mTonemapperFrameCount)) {
+            LOG(WARNING) << "Tonemapper did not render all frames before EOS";
+        }
         media_status_t status = AMediaCodec_signalEndOfInputStream(mEncoder->getCodec());
         if (status != AMEDIA_OK) {
             LOG(ERROR) << "SignalEOS on encoder returned error: " << status;
@@ -509,7 +565,10 @@ void VideoTrackTranscoder::dequeueOutputSample(int32_t bufferIndex,
 }
 
 void VideoTrackTranscoder::updateTrackFormat(AMediaFormat* outputFormat, bool fromDecoder) {
-    if (fromDecoder) {
+    if (fromDecoder && mTonemapper != nullptr) {
+        // The decoder reports HDR color information but the encoder is fed SDR by the tonemapper.
+        return;
+    } else if (fromDecoder) {
         static const std::vector<AMediaFormatUtils::EntryCopier> kValuesToCopy{
                 ENTRY_COPIER(AMEDIAFORMAT_KEY_COLOR_RANGE, Int32),
                 ENTRY_COPIER(AMEDIAFORMAT_KEY_COLOR_STANDARD, Int32),
@@ -615,6 +674,10 @@ media_status_t VideoTrackTranscoder::runTranscodeLoop(bool* stopped) {
             mStatus = status;
         }
         mEncoder->setStarted();
+
+        if (mSpeedLimitPercent < 100) {
+            applySpeedLimit(mSpeedLimitPercent);
+        }
     });
 
     // Process codec events until EOS is reached, transcoding is stopped or an error occurs.
@@ -645,6 +708,60 @@ void VideoTrackTranscoder::abortTranscodeLoop() {
     }
 }
 
+void VideoTrackTranscoder::setSpeedLimit(int32_t speedLimitPercent) {
+    mSpeedLimitPercent = std::clamp(speedLimitPercent, 1, 100);
+
+    // Update the codecs on the transcoder thread. If the codecs are not started yet the limit is
+    // applied when they are.
+    std::weak_ptr<VideoTrackTranscoder> weakThis = shared_from_this();
+    mCodecMessageQueue.push([weakThis] {
+        auto transcoder = weakThis.lock();
+        if (transcoder != nullptr && transcoder->mEncoder != nullptr &&
+            transcoder->mEncoder->isStarted()) {
+            transcoder->applySpeedLimit(transcoder->mSpeedLimitPercent);
+        }
+    });
+}
+
+void VideoTrackTranscoder::applySpeedLimit(int32_t speedLimitPercent) {
+    // Scale the operating rate the codecs were configured with. If none was configured, the codecs
+    // run as fast as possible when unlimited and are limited relative to the frame rate.
+    float operatingRate;
+    int32_t operatingRateInt;
+    bool hasOperatingRate = true;
+    if (AMediaFormat_getInt32(mDestinationFormat.get(), AMEDIAFORMAT_KEY_OPERATING_RATE,
+                              &operatingRateInt)) {
+        operatingRate = operatingRateInt;
+    } else if (!AMediaFormat_getFloat(mDestinationFormat.get(), AMEDIAFORMAT_KEY_OPERATING_RATE,
+                                      &operatingRate)) {
+        int32_t frameRate = kDefaultFrameRate;
+        AMediaFormat_getInt32(mDestinationFormat.get(), AMEDIAFORMAT_KEY_FRAME_RATE, &frameRate);
+        operatingRate = frameRate;
+        hasOperatingRate = false;
+    }
+
+    if (speedLimitPercent >= 100) {
+        operatingRate = hasOperatingRate ? operatingRate : kMaxOperatingRate;
+    } else {
+        operatingRate = std::max(1.0f, operatingRate * speedLimitPercent / 100.0f);
+    }
+
+    AMediaFormat* params = AMediaFormat_new();
+    if (params == nullptr) {
+        return;
+    }
+    AMediaFormat_setFloat(params, AMEDIAFORMAT_KEY_OPERATING_RATE, operatingRate);
+
+    LOG(DEBUG) << "Speed limit " << speedLimitPercent << "%, operating rate " << operatingRate;
+    if (AMediaCodec_setParameters(mEncoder->getCodec(), params) != AMEDIA_OK) {
+        LOG(WARNING) << "Unable to update encoder operating rate";
+    }
+    if (AMediaCodec_setParameters(mDecoder, params) != AMEDIA_OK) {
+        LOG(WARNING) << "Unable to update decoder operating rate";
+    }
+    AMediaFormat_delete(params);
+}
+
 std::shared_ptr<AMediaFormat> VideoTrackTranscoder::getOutputFormat() const {
     return mActualOutputFormat;
 }
@@ -40,6 +40,7 @@
 using namespace android;
 
 const std::string PARAM_VIDEO_FRAME_RATE = "VideoFrameRate";
+const std::string PARAM_REALTIME_FACTOR = "RealtimeFactor";
 
 class TranscoderCallbacks : public MediaTranscoder::CallbackInterface {
 public:
@@ -168,11 +169,25 @@ static void TranscodeMediaFile(benchmark::State& state, const std::string& srcFi
             }
 
             if (strncmp(mime, "video/", 6) == 0) {
-                int32_t frameCount;
-                if (AMediaFormat_getInt32(srcFormat, AMEDIAFORMAT_KEY_FRAME_COUNT, &frameCount)) {
+                AMediaFormat_getInt64(srcFormat, AMEDIAFORMAT_KEY_DURATION, &trackDurationUs);
+
+                // End-to-end frame rate, i.e. source frames per second of wall time including
+                // extraction, decoding, encoding and muxing. Not every extractor reports a frame
+                // count so fall back to estimating it from the duration and frame rate.
+                int32_t frameCount = 0;
+                int32_t frameRate = 0;
+                if (!AMediaFormat_getInt32(srcFormat, AMEDIAFORMAT_KEY_FRAME_COUNT, &frameCount) &&
+                    AMediaFormat_getInt32(srcFormat, AMEDIAFORMAT_KEY_FRAME_RATE, &frameRate)) {
+                    frameCount = trackDurationUs * frameRate / 1000000;
+                }
+                if (frameCount > 0) {
                     state.counters[PARAM_VIDEO_FRAME_RATE] = benchmark::Counter(
                             frameCount, benchmark::Counter::kIsIterationInvariantRate);
                 }
+                if (trackDurationUs > 0) {
+                    state.counters[PARAM_REALTIME_FACTOR] = benchmark::Counter(
+                            trackDurationUs / 1E6, benchmark::Counter::kIsIterationInvariantRate);
+                }
                 if (!AMediaFormat_getInt32(srcFormat, AMEDIAFORMAT_KEY_WIDTH, &width)) {
                     state.SkipWithError("Video source track format does not have width");
                     goto exit;
@@ -181,7 +196,6 @@ static void TranscodeMediaFile(benchmark::State& state, const std::string& srcFi
                     state.SkipWithError("Video source track format does not have height");
                     goto exit;
                 }
-                AMediaFormat_getInt64(srcFormat, AMEDIAFORMAT_KEY_DURATION, &trackDurationUs);
                 sourceMime = mime;
             }
 
@@ -94,6 +94,33 @@ public:
      */
     virtual media_status_t getEstimatedBitrateForTrack(int trackIndex, int32_t* bitrate);
 
+    /**
+     * Finds the first sync sample of a selected track at or after the specified time. This method
+     * has to be called before sample reading begins, and before seekToSegment.
+     * @param trackIndex The source track index.
+     * @param timeUs The time to search from.
+     * @param syncTimeUs Output param for the sync sample time, or -1 if there are no sync samples
+     *                   at or after timeUs.
+     * @return AMEDIA_OK on success, AMEDIA_ERROR_UNSUPPORTED if the reader cannot seek.
+     */
+    virtual media_status_t getNextSyncSampleTime(int trackIndex __unused, int64_t timeUs __unused,
+                                                 int64_t* syncTimeUs __unused) {
+        return AMEDIA_ERROR_UNSUPPORTED;
+    }
+
+    /**
+     * Limits sample reading to a segment of the container. Reading starts at the last sync sample
+     * at or before startTimeUs, and the selected tracks reach end of stream at the first sync
+     * sample at or after endTimeUs. This method has to be called after tracks are selected and
+     * before sample reading begins.
+     * @param startTimeUs The segment start time.
+     * @param endTimeUs The segment end time, or -1 to read until the end of the container.
+     * @return AMEDIA_OK on success, AMEDIA_ERROR_UNSUPPORTED if the reader cannot seek.
+     */
+    virtual media_status_t seekToSegment(int64_t startTimeUs __unused, int64_t endTimeUs __unused) {
+        return AMEDIA_ERROR_UNSUPPORTED;
+    }
+
     /**
      * Returns the sample information for the current sample in the specified track. Note that this
      * method will block until the reader advances to a sample belonging to the requested track if
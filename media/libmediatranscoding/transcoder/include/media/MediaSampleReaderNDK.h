@@ -20,6 +20,7 @@
 #include <media/MediaSampleReader.h>
 #include <media/NdkMediaExtractor.h>
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -51,6 +52,9 @@ public:
     media_status_t unselectTrack(int trackIndex) override;
     media_status_t setEnforceSequentialAccess(bool enforce) override;
     media_status_t getEstimatedBitrateForTrack(int trackIndex, int32_t* bitrate) override;
+    media_status_t getNextSyncSampleTime(int trackIndex, int64_t timeUs,
+                                         int64_t* syncTimeUs) override;
+    media_status_t seekToSegment(int64_t startTimeUs, int64_t endTimeUs) override;
     media_status_t getSampleInfoForTrack(int trackIndex, MediaSampleInfo* info) override;
     media_status_t readSampleDataForTrack(int trackIndex, uint8_t* buffer,
                                           size_t bufferSize) override;
@@ -89,6 +93,24 @@ private:
         SamplePosition next;
     };
 
+    /** A sample that was read ahead of its track's consumer in sequential mode. */
+    struct ReadAheadSample {
+        MediaSampleInfo info;
+        std::vector<uint8_t> data;
+    };
+
+    /**
+     * ReadAheadQueue holds the samples of one track that the extractor has already passed over in
+     * sequential mode, so that threads waiting for other tracks are not blocked by a slow consumer.
+     * The queue is bounded by size in bytes, but it always accepts a sample while it is empty so
+     * any track with a small budget still makes progress.
+     */
+    struct ReadAheadQueue {
+        std::deque<ReadAheadSample> samples;
+        size_t sizeBytes = 0;
+        size_t maxSizeBytes = 0;
+    };
+
     /**
      * Creates a new MediaSampleReaderNDK object from an AMediaExtractor. The extractor needs to be
      * initialized with a valid data source before attempting to create a MediaSampleReaderNDK.
@@ -102,6 +124,15 @@ private:
     /** Advances the extractor to next sample. */
     bool advanceExtractor_l();
 
+    /** Marks the end of stream and wakes up all waiting tracks. */
+    void setEosReached_l();
+
+    /** Returns true if the extractor's current sample is past the end of the segment. */
+    bool isPastSegmentEnd_l();
+
+    /** Moves the extractor back to the beginning of the segment after sampling the file. */
+    media_status_t resetExtractor_l();
+
     /** Moves the extractor backwards to the specified sample. */
     media_status_t seekExtractorBackwards_l(int64_t targetTimeUs, int targetTrackIndex,
                                             uint64_t targetSampleIndex);
@@ -112,7 +143,20 @@ private:
     /** Moves the extractor to the next sample of the specified track. */
     media_status_t moveToTrack_l(int trackIndex);
 
-    /** In sequential mode, waits for the extractor to reach the next sample for the track. */
+    /**
+     * In sequential mode, reads the extractor's current sample into its track's read-ahead queue
+     * and advances that track, if the queue has room.
+     * @return True if a sample was read ahead.
+     */
+    bool readAheadExtractorSample_l();
+
+    /** Removes the first read-ahead sample of the track. */
+    void popReadAheadSample_l(int trackIndex);
+
+    /**
+     * In sequential mode, waits for the extractor to reach the next sample for the track, or for a
+     * sample to be read ahead for it. While waiting, the samples of other tracks are read ahead.
+     */
     media_status_t waitForTrack_l(int trackIndex, std::unique_lock<std::mutex>& lockHeld);
 
     /**
@@ -130,11 +174,19 @@ private:
     bool mEosReached = false;
     bool mEnforceSequentialAccess = false;
 
+    // Segment limits set by seekToSegment. A negative end time means no end.
+    int64_t mSegmentStartTimeUs = 0;
+    int64_t mSegmentEndTimeUs = -1;
+    bool mSegmentEndReached = false;
+
     // Maps selected track indices to condition variables for sequential sample access control.
     std::map<int, std::condition_variable> mTrackSignals;
 
     // Samples cursor for each track in the file.
     std::vector<SampleCursor> mTrackCursors;
+
+    // Read-ahead queue for each track in the file, only filled in sequential mode.
+    std::vector<ReadAheadQueue> mReadAheadQueues;
 };
 
 }  // namespace android
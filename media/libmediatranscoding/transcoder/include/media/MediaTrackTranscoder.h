@@ -94,6 +94,14 @@ public:
       */
     virtual std::shared_ptr<AMediaFormat> getOutputFormat() const = 0;
 
+    /**
+     * Limits the speed at which the track is transcoded, for example when the device is warm. The
+     * limit is a hint and the default implementation ignores it, so passthrough tracks are never
+     * limited.
+     * @param speedLimitPercent The speed limit in percent of full speed, 100 for no limit.
+     */
+    virtual void setSpeedLimit(int32_t speedLimitPercent __unused) {}
+
     virtual ~MediaTrackTranscoder() = default;
 
 protected:
@@ -120,6 +120,14 @@ public:
      */
     media_status_t cancel();
 
+    /**
+     * Limits the transcoding speed, for example to reduce the load on a warm device. The limit is
+     * forwarded to the track transcoders as a hint and can be changed at any time while the
+     * transcoder is running.
+     * @param speedLimitPercent The speed limit in percent of full speed, 100 for no limit.
+     */
+    media_status_t setSpeedLimit(int32_t speedLimitPercent);
+
     virtual ~MediaTranscoder() = default;
 
 private:
@@ -147,6 +155,8 @@ private:
 
     std::shared_ptr<CallbackInterface> mCallbacks;
     std::shared_ptr<MediaSampleReader> mSampleReader;
+    std::shared_ptr<ndk::ScopedFileDescriptor> mSourceFd;
+    size_t mSourceFileSize = 0;
     std::shared_ptr<MediaSampleWriter> mSampleWriter;
     std::vector<std::shared_ptr<AMediaFormat>> mSourceTrackFormats;
     std::vector<std::shared_ptr<MediaTrackTranscoder>> mTrackTranscoders;
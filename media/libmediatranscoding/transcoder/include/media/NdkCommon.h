@@ -53,6 +53,10 @@ static constexpr int32_t COLOR_TRANSFER_LINEAR = 1;
 static constexpr int32_t COLOR_TRANSFER_SDR_VIDEO = 3;
 static constexpr int32_t COLOR_TRANSFER_ST2084 = 6;
 
+// Color standards and ranges defined by MediaCodecConstants.h but not in NDK
+static constexpr int32_t COLOR_STANDARD_BT709 = 1;
+static constexpr int32_t COLOR_RANGE_LIMITED = 2;
+
 // constants not defined in NDK
 extern const char* TBD_AMEDIACODEC_PARAMETER_KEY_ALLOW_FRAME_DROP;
 extern const char* TBD_AMEDIACODEC_PARAMETER_KEY_REQUEST_SYNC_FRAME;
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SEGMENTED_VIDEO_TRACK_TRANSCODER_H
+#define ANDROID_SEGMENTED_VIDEO_TRACK_TRANSCODER_H
+
+#include <media/MediaTrackTranscoder.h>
+#include <media/MediaTrackTranscoderCallback.h>
+#include <media/NdkMediaCodecPlatform.h>
+#include <media/NdkMediaFormat.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace android {
+
+/**
+ * Track transcoder for long video tracks that splits the track at sync samples into segments and
+ * transcodes several segments at once, each with its own VideoTrackTranscoder and therefore its
+ * own decoder and encoder instance. Every segment reads the source through a separate
+ * MediaSampleReader limited to the segment with MediaSampleReader::seekToSegment.
+ *
+ * Output samples are stitched back together in segment order. The samples of the first unfinished
+ * segment are forwarded as they are produced, and the samples of later segments are copied and
+ * buffered until all segments before them have finished. A segment that runs out of buffer budget
+ * stalls until it becomes the first unfinished segment, which bounds memory use.
+ *
+ * All segments use the same encoder configuration, and the codec specific data of the first
+ * segment is used for the whole track. Each segment starts with a sync frame, so the output has a
+ * sync frame at every segment boundary.
+ */
+class SegmentedVideoTrackTranscoder
+      : public std::enable_shared_from_this<SegmentedVideoTrackTranscoder>,
+        public MediaTrackTranscoder,
+        public MediaTrackTranscoderCallback {
+public:
+    /** Function that creates a new MediaSampleReader for the same source as the track's reader. */
+    using SampleReaderFactory = std::function<std::shared_ptr<MediaSampleReader>()>;
+
+    /** The shortest segment a track is split into. Shorter tracks are transcoded in one segment. */
+    static constexpr int64_t kMinSegmentDurationUs = 10 * 1000 * 1000;
+
+    /**
+     * Creates a new segmented video track transcoder.
+     * @param transcoderCallback The callback to notify about the whole track.
+     * @param sampleReaderFactory Function that opens a new reader for every segment.
+     * @param maxParallelSegments The maximum number of segments to transcode at once.
+     * @param pid The pid of the client, used for codec resource management.
+     * @param uid The uid of the client, used for codec resource management.
+     */
+    static std::shared_ptr<SegmentedVideoTrackTranscoder> create(
+            const std::weak_ptr<MediaTrackTranscoderCallback>& transcoderCallback,
+            const SampleReaderFactory& sampleReaderFactory, int maxParallelSegments,
+            pid_t pid = AMEDIACODEC_CALLING_PID, uid_t uid = AMEDIACODEC_CALLING_UID);
+
+    // MediaTrackTranscoder
+    void setSpeedLimit(int32_t speedLimitPercent) override;
+    // ~MediaTrackTranscoder
+
+    virtual ~SegmentedVideoTrackTranscoder() override = default;
+
+private:
+    /** State of a single segment and its transcoder. */
+    struct Segment {
+        int64_t startTimeUs = 0;
+        int64_t endTimeUs = -1;  // -1 for the last segment.
+        std::shared_ptr<MediaSampleReader> reader;
+        std::shared_ptr<MediaTrackTranscoder> transcoder;
+
+        // Output samples waiting for all earlier segments to finish.
+        std::deque<std::shared_ptr<MediaSample>> bufferedSamples;
+        size_t bufferedBytes = 0;
+
+        enum {
+            PENDING = 0,  // Not yet started.
+            RUNNING,      // Currently running.
+            DONE,         // Done running (can be finished, stopped or error).
+        } state = PENDING;
+    };
+
+    SegmentedVideoTrackTranscoder(
+            const std::weak_ptr<MediaTrackTranscoderCallback>& transcoderCallback,
+            const SampleReaderFactory& sampleReaderFactory, int maxParallelSegments, pid_t pid,
+            uid_t uid)
+          : MediaTrackTranscoder(transcoderCallback),
+            mSampleReaderFactory(sampleReaderFactory),
+            mMaxParallelSegments(maxParallelSegments),
+            mPid(pid),
+            mUid(uid){};
+
+    // MediaTrackTranscoder
+    media_status_t runTranscodeLoop(bool* stopped) override;
+    void abortTranscodeLoop() override;
+    media_status_t configureDestinationFormat(
+            const std::shared_ptr<AMediaFormat>& destinationFormat) override;
+    std::shared_ptr<AMediaFormat> getOutputFormat() const override;
+    // ~MediaTrackTranscoder
+
+    // MediaTrackTranscoderCallback
+    void onTrackFormatAvailable(const MediaTrackTranscoder* transcoder) override;
+    void onTrackFinished(const MediaTrackTranscoder* transcoder) override;
+    void onTrackStopped(const MediaTrackTranscoder* transcoder) override;
+    void onTrackError(const MediaTrackTranscoder* transcoder, media_status_t status) override;
+    // ~MediaTrackTranscoderCallback
+
+    // Splits the track into segments starting at sync samples.
+    media_status_t createSegments(const std::shared_ptr<MediaSampleReader>& reader);
+
+    // Opens a reader for the segment and configures its transcoder.
+    media_status_t configureSegment(size_t segmentIndex);
+
+    // Configures and starts the segment. Called with mMutex held.
+    media_status_t startSegment_l(size_t segmentIndex) NO_THREAD_SAFETY_ANALYSIS;
+
+    // Receives an output sample from a segment transcoder.
+    void onSegmentSample(size_t segmentIndex, const std::shared_ptr<MediaSample>& sample);
+
+    // Marks a segment as done and forwards the buffered samples of following segments.
+    void onSegmentDone(const MediaTrackTranscoder* transcoder, media_status_t status);
+
+    const SampleReaderFactory mSampleReaderFactory;
+    int mMaxParallelSegments;
+    const pid_t mPid;
+    const uid_t mUid;
+
+    std::shared_ptr<AMediaFormat> mDestinationFormat;
+    std::vector<Segment> mSegments;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    size_t mHeadSegment GUARDED_BY(mMutex) = 0;
+    size_t mRunningSegments GUARDED_BY(mMutex) = 0;
+    media_status_t mStatus GUARDED_BY(mMutex) = AMEDIA_OK;
+    bool mAborted GUARDED_BY(mMutex) = false;
+    int32_t mSpeedLimitPercent GUARDED_BY(mMutex) = 100;
+};
+
+}  // namespace android
+#endif  // ANDROID_SEGMENTED_VIDEO_TRACK_TRANSCODER_H
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SURFACE_TONEMAPPER_H
+#define ANDROID_SURFACE_TONEMAPPER_H
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <android/native_window.h>
+#include <media/NdkImageReader.h>
+#include <media/NdkMediaFormat.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace android {
+
+/**
+ * SurfaceTonemapper converts HDR video frames to SDR on the GPU, between a decoder's output surface
+ * and an encoder's input surface. The decoder renders into the tonemapper's input surface, and
+ * each frame is drawn into the output surface through a tone mapping shader, with its presentation
+ * time preserved. Frames stay in graphics buffers the whole way, so no pixel data is copied on the
+ * CPU. All GL work runs on a render thread owned by the tonemapper.
+ *
+ * The tone mapping operator is the one used by renderfright for HDR to SDR composition.
+ */
+class SurfaceTonemapper {
+public:
+    /**
+     * Creates a tonemapper for an HDR video track.
+     * @param sourceFormat The format of the HDR source track. The size, transfer function and HDR
+     *                     static info of the track are read from it.
+     * @param outputSurface The surface that SDR frames are rendered to, usually an encoder's input
+     *                      surface. The tonemapper holds its own reference to the surface.
+     * @return A new tonemapper, or nullptr if the source is not supported or the GPU could not be
+     *         set up.
+     */
+    static std::shared_ptr<SurfaceTonemapper> create(AMediaFormat* sourceFormat,
+                                                     ANativeWindow* outputSurface);
+
+    /** Returns the surface a decoder should render HDR frames to. */
+    ANativeWindow* getInputSurface() const { return mInputSurface; }
+
+    /**
+     * Waits until the specified number of frames have been rendered to the output surface.
+     * @param frameCount The number of frames that were rendered to the input surface.
+     * @return True if the frames were rendered, false on timeout or error.
+     */
+    bool waitForRenderedFrames(uint64_t frameCount);
+
+    ~SurfaceTonemapper();
+
+private:
+    SurfaceTonemapper(int32_t transfer, float maxInputLuminance)
+          : mTransfer(transfer), mMaxInputLuminance(maxInputLuminance) {}
+
+    static void onImageAvailable(void* context, AImageReader* reader);
+
+    media_status_t init(int32_t width, int32_t height, ANativeWindow* outputSurface);
+    void renderLoop(ANativeWindow* outputSurface);
+
+    // Called on the render thread only.
+    bool initGl(ANativeWindow* outputSurface);
+    void releaseGl();
+    bool renderImage(AImage* image);
+
+    const int32_t mTransfer;
+    const float mMaxInputLuminance;
+
+    AImageReader* mImageReader = nullptr;
+    ANativeWindow* mInputSurface = nullptr;
+    std::thread mRenderThread;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mInitDone = false;
+    bool mInitOk = false;
+    bool mStopping = false;
+    bool mRenderError = false;
+    uint64_t mAvailableImages = 0;
+    uint64_t mRenderedFrames = 0;
+
+    // Owned by the render thread.
+    EGLDisplay mDisplay = EGL_NO_DISPLAY;
+    EGLContext mContext = EGL_NO_CONTEXT;
+    EGLSurface mEglSurface = EGL_NO_SURFACE;
+    GLuint mProgram = 0;
+    GLuint mTexture = 0;
+    GLint mCropLocation = -1;
+    PFNEGLGETNATIVECLIENTBUFFERANDROIDPROC mGetNativeClientBuffer = nullptr;
+    PFNEGLCREATEIMAGEKHRPROC mCreateImage = nullptr;
+    PFNEGLDESTROYIMAGEKHRPROC mDestroyImage = nullptr;
+    PFNEGLPRESENTATIONTIMEANDROIDPROC mPresentationTime = nullptr;
+    PFNEGLCREATESYNCKHRPROC mCreateSync = nullptr;
+    PFNEGLDESTROYSYNCKHRPROC mDestroySync = nullptr;
+    PFNEGLDUPNATIVEFENCEFDANDROIDPROC mDupNativeFenceFd = nullptr;
+    PFNGLEGLIMAGETARGETTEXTURE2DOESPROC mImageTargetTexture = nullptr;
+};
+
+}  // namespace android
+#endif  // ANDROID_SURFACE_TONEMAPPER_H
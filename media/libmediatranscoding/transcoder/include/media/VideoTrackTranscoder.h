@@ -21,7 +21,9 @@
 #include <media/MediaTrackTranscoder.h>
 #include <media/NdkMediaCodecPlatform.h>
 #include <media/NdkMediaFormat.h>
+#include <media/SurfaceTonemapper.h>
 
+#include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <mutex>
@@ -32,7 +34,9 @@ namespace android {
  * Track transcoder for video tracks. VideoTrackTranscoder uses AMediaCodec from the Media NDK
  * internally. The two media codecs are run in asynchronous mode and shares uncompressed buffers
  * using a native surface (ANativeWindow). Codec callback events are placed on a message queue and
- * serviced in order on the transcoding thread managed by MediaTrackTranscoder.
+ * serviced in order on the transcoding thread managed by MediaTrackTranscoder. HDR sources are
+ * converted to SDR by the decoder when it supports it, and otherwise by a SurfaceTonemapper placed
+ * between the decoder and encoder surfaces.
  */
 class VideoTrackTranscoder : public std::enable_shared_from_this<VideoTrackTranscoder>,
                              public MediaTrackTranscoder {
@@ -41,6 +45,10 @@ public:
             const std::weak_ptr<MediaTrackTranscoderCallback>& transcoderCallback,
             pid_t pid = AMEDIACODEC_CALLING_PID, uid_t uid = AMEDIACODEC_CALLING_UID);
 
+    // MediaTrackTranscoder
+    void setSpeedLimit(int32_t speedLimitPercent) override;
+    // ~MediaTrackTranscoder
+
     virtual ~VideoTrackTranscoder() override;
 
 private:
@@ -75,6 +83,9 @@ private:
     std::shared_ptr<AMediaFormat> getOutputFormat() const override;
     // ~MediaTrackTranscoder
 
+    // Redirects the decoder output through a GPU tonemapper for HDR to SDR conversion.
+    media_status_t configureTonemapper(AMediaFormat* decoderFormat);
+
     // Enqueues an input sample with the decoder.
     void enqueueInputSample(int32_t bufferIndex);
 
@@ -87,9 +98,14 @@ private:
     // Updates the video track's actual format based on encoder and decoder output format.
     void updateTrackFormat(AMediaFormat* outputFormat, bool fromDecoder);
 
+    // Scales the codecs' operating rate to the speed limit.
+    void applySpeedLimit(int32_t speedLimitPercent);
+
     AMediaCodec* mDecoder = nullptr;
     std::shared_ptr<CodecWrapper> mEncoder;
     ANativeWindow* mSurface = nullptr;
+    std::shared_ptr<SurfaceTonemapper> mTonemapper;
+    uint64_t mTonemapperFrameCount = 0;
     bool mEosFromSource = false;
     bool mEosFromEncoder = false;
     bool mLastSampleWasSync = false;
@@ -103,6 +119,7 @@ private:
     uint64_t mInputFrameCount = 0;
     uint64_t mOutputFrameCount = 0;
     int32_t mConfiguredBitrate = 0;
+    std::atomic_int32_t mSpeedLimitPercent = 100;
 };
 
 }  // namespace android
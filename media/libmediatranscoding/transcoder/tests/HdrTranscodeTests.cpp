@@ -35,9 +35,6 @@ namespace android {
 // Debug property to load the sample HDR plugin.
 static const std::string kLoadSamplePluginProperty{"debug.codec2.force-sample-plugin"};
 
-// SDR color standard, from MediaFormat.
-static constexpr int COLOR_STANDARD_BT709 = 1;
-
 class HdrTranscodeTests : public ::testing::Test {
 public:
     HdrTranscodeTests() { LOG(DEBUG) << "HdrTranscodeTests created"; }
@@ -165,8 +162,9 @@ TEST_F(HdrTranscodeTests, TestHdrSamplePluginTranscode) {
         EXPECT_EQ(transcode(hdrFile, dstFile, AMEDIA_MIMETYPE_VIDEO_AVC), AMEDIA_OK);
         EXPECT_EQ(validateOutput(dstFile), AMEDIA_OK);
     } else {
-        LOG(INFO) << "HDR -> SDR *not* supported";
-        EXPECT_EQ(transcode(hdrFile, dstFile, AMEDIA_MIMETYPE_VIDEO_AVC), AMEDIA_ERROR_UNSUPPORTED);
+        LOG(INFO) << "HDR -> SDR *not* supported by the codec, validating GPU tonemapped output..";
+        EXPECT_EQ(transcode(hdrFile, dstFile, AMEDIA_MIMETYPE_VIDEO_AVC), AMEDIA_OK);
+        EXPECT_EQ(validateOutput(dstFile), AMEDIA_OK);
     }
 
     EXPECT_TRUE(android::base::SetProperty(kLoadSamplePluginProperty, "false"));
@@ -315,6 +315,27 @@ TEST_F(MediaSampleReaderNDKTests, TestSequentialSampleAccess) {
     compareSamples(tester.getSamples());
 }
 
+/**
+ * Reads a few samples from one track alone in sequential mode, which requires the samples of the
+ * other tracks to be read ahead, before reading the rest of the samples from all tracks.
+ */
+TEST_F(MediaSampleReaderNDKTests, TestSequentialReadAhead) {
+    LOG(DEBUG) << "TestSequentialReadAhead Starts";
+    static constexpr int kSampleCount = 10;
+
+    for (int trackIndToTest = 0; trackIndToTest < mTrackCount; ++trackIndToTest) {
+        SampleAccessTester tester{mSourceFd, mFileSize};
+        tester.setEnforceSequentialAccess(true);
+
+        tester.readSamplesAsync(trackIndToTest, kSampleCount);
+        tester.waitForTrack(trackIndToTest);
+
+        tester.readSamplesAsync(SAMPLE_COUNT_ALL);
+        tester.waitForTracks();
+        compareSamples(tester.getSamples());
+    }
+}
+
 /** Reads all samples from one track in parallel mode before switching to sequential mode. */
 TEST_F(MediaSampleReaderNDKTests, TestMixedSampleAccessTrackEOS) {
     LOG(DEBUG) << "TestMixedSampleAccessTrackEOS Starts";
@@ -404,6 +425,50 @@ TEST_F(MediaSampleReaderNDKTests, TestEstimatedBitrateAccuracy) {
     }
 }
 
+TEST_F(MediaSampleReaderNDKTests, TestSegmentedSampleAccess) {
+    initExtractorSamples();
+
+    for (int trackIndex = 0; trackIndex < mTrackCount; ++trackIndex) {
+        auto sampleReader = MediaSampleReaderNDK::createFromFd(mSourceFd, 0, mFileSize);
+        ASSERT_TRUE(sampleReader);
+        EXPECT_EQ(sampleReader->selectTrack(trackIndex), AMEDIA_OK);
+
+        int64_t splitTimeUs;
+        EXPECT_EQ(sampleReader->getNextSyncSampleTime(trackIndex, 1, &splitTimeUs), AMEDIA_OK);
+        if (splitTimeUs <= 0) {
+            continue;
+        }
+
+        // Reading the two segments one after the other should give the samples of the full track.
+        std::vector<Sample> samples;
+        const std::pair<int64_t, int64_t> segments[] = {{0, splitTimeUs}, {splitTimeUs, -1}};
+        for (const auto& segment : segments) {
+            if (sampleReader == nullptr) {
+                sampleReader = MediaSampleReaderNDK::createFromFd(mSourceFd, 0, mFileSize);
+                ASSERT_TRUE(sampleReader);
+                EXPECT_EQ(sampleReader->selectTrack(trackIndex), AMEDIA_OK);
+            }
+            EXPECT_EQ(sampleReader->seekToSegment(segment.first, segment.second), AMEDIA_OK);
+
+            MediaSampleInfo info;
+            while (sampleReader->getSampleInfoForTrack(trackIndex, &info) == AMEDIA_OK) {
+                auto buffer = std::make_unique<uint8_t[]>(info.size);
+                EXPECT_EQ(sampleReader->readSampleDataForTrack(trackIndex, buffer.get(),
+                                                               info.size),
+                          AMEDIA_OK);
+                samples.emplace_back(info.flags, info.presentationTimeUs, info.size,
+                                     buffer.get());
+            }
+            sampleReader.reset();
+        }
+
+        EXPECT_EQ(samples.size(), mExtractorSamples[trackIndex].size());
+        for (size_t sampleIndex = 0; sampleIndex < samples.size(); sampleIndex++) {
+            EXPECT_EQ(samples[sampleIndex], mExtractorSamples[trackIndex][sampleIndex]);
+        }
+    }
+}
+
 TEST_F(MediaSampleReaderNDKTests, TestInvalidFd) {
     std::shared_ptr<MediaSampleReader> sampleReader =
             MediaSampleReaderNDK::createFromFd(0, 0, mFileSize);
@@ -76,6 +76,56 @@ ssize_t PipeReader::read(void *buffer, size_t count)
     return actual;
 }
 
+ssize_t PipeReader::readVia(readVia_t via, size_t total, void *user, size_t block)
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    const size_t frameSize = Format_frameSize(mFormat);
+    size_t accumulator = 0;
+    while (accumulator < total) {
+        size_t count = total - accumulator;
+        if (block != 0 && count > block) {
+            count = block;
+        }
+        audio_utils_iovec iovec[2];
+        size_t lost;
+        ssize_t ret = mFifoReader.obtain(iovec, count, NULL /*timeout*/, &lost);
+        if (ret == -EOVERFLOW || lost > 0) {
+            mFramesOverrun += lost;
+            ++mOverruns;
+            ret = OVERRUN;
+        }
+        if (ret <= 0) {
+            return accumulator > 0 ? accumulator : ret;
+        }
+        // The obtained frames may wrap around the end of the buffer.
+        const size_t obtained = ret;
+        size_t consumed = 0;
+        for (const audio_utils_iovec& part : iovec) {
+            if (part.mLength == 0) {
+                continue;
+            }
+            ret = via(user, (const char *) mPipe.mBuffer + part.mOffset * frameSize,
+                    part.mLength);
+            if (ret > 0) {
+                ALOG_ASSERT((size_t) ret <= part.mLength);
+                consumed += ret;
+            }
+            if (ret < (ssize_t) part.mLength) {
+                break;
+            }
+        }
+        mFifoReader.release(consumed);
+        mFramesRead += consumed;
+        accumulator += consumed;
+        if (consumed < obtained) {
+            return accumulator > 0 ? accumulator : ret;
+        }
+    }
+    return accumulator;
+}
+
 ssize_t PipeReader::flush()
 {
     if (CC_UNLIKELY(!mNegotiated)) {
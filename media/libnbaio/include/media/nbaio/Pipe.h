@@ -57,11 +57,15 @@ public:
     virtual ssize_t write(const void *buffer, size_t count);
     //virtual ssize_t writeVia(writeVia_t via, size_t total, void *user, size_t block);
 
+    // The shared index is polled by every reader while the writer updates its own state on
+    // each write; keep them, and the state of distinct readers, on separate cache lines.
+    static constexpr size_t kCacheLineSize = 64;
+
 private:
     const size_t    mMaxFrames;     // always a power of 2
     void * const    mBuffer;
-    audio_utils_fifo        mFifo;
-    audio_utils_fifo_writer mFifoWriter;
+    alignas(kCacheLineSize) audio_utils_fifo        mFifo;
+    alignas(kCacheLineSize) audio_utils_fifo_writer mFifoWriter;
     volatile int32_t mReaders;      // number of PipeReader clients currently attached to this Pipe
     const bool      mFreeBufferInDestructor;
 };
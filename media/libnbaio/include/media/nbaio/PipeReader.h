@@ -22,7 +22,7 @@
 namespace android {
 
 // PipeReader is safe for only a single thread
-class PipeReader : public NBAIO_Source {
+class alignas(Pipe::kCacheLineSize) PipeReader : public NBAIO_Source {
 
 public:
 
@@ -47,6 +47,10 @@ public:
 
     virtual ssize_t read(void *buffer, size_t count);
 
+    // Passes the frames to via() directly from the pipe buffer, without the intermediate copy
+    // of the default implementation, so several readers can share a capture stream cheaply.
+    virtual ssize_t readVia(readVia_t via, size_t total, void *user, size_t block = 0);
+
     virtual ssize_t flush();
 
     // NBAIO_Source end
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "NBLog"
+//#define LOG_NDEBUG 0
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <media/nblog/Archive.h>
+#include <media/nblog/Reader.h>
+#include <utils/Log.h>
+#include <utils/Timers.h>
+
+namespace android {
+namespace NBLog {
+
+static status_t writeFully(int fd, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *) data;
+    while (size > 0) {
+        const ssize_t ret = TEMP_FAILURE_RETRY(write(fd, p, size));
+        if (ret <= 0) {
+            return ret < 0 ? -errno : INVALID_OPERATION;
+        }
+        p += ret;
+        size -= ret;
+    }
+    return NO_ERROR;
+}
+
+status_t writeArchiveHeader(int fd)
+{
+    const ArchiveHeader header;
+    return writeFully(fd, &header, sizeof(header));
+}
+
+status_t writeArchiveRecord(int fd, const std::string &name, const Snapshot &snapshot)
+{
+    const uint8_t *begin = snapshot.begin();
+    const size_t dataLength = begin != nullptr ? snapshot.end() - snapshot.begin() : 0;
+    ArchiveRecordHeader header;
+    header.captureTimeNs = systemTime();
+    header.lost = snapshot.lost();
+    header.nameLength = name.size();
+    header.dataLength = dataLength;
+    status_t status = writeFully(fd, &header, sizeof(header));
+    if (status == NO_ERROR) {
+        status = writeFully(fd, name.data(), name.size());
+    }
+    if (status == NO_ERROR && dataLength > 0) {
+        status = writeFully(fd, begin, dataLength);
+    }
+    return status;
+}
+
+ArchiveReader::ArchiveReader(const char *path)
+{
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        mStatus = -errno;
+        ALOGE("%s: cannot open %s: %s", __func__, path, strerror(errno));
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        mStatus = BAD_VALUE;
+    } else {
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            mStatus = -errno;
+        } else {
+            mData = (const uint8_t *) data;
+            mSize = st.st_size;
+            mStatus = parse();
+        }
+    }
+    close(fd);
+    ALOGE_IF(mStatus != NO_ERROR, "%s: cannot read archive %s: %d", __func__, path, mStatus);
+}
+
+ArchiveReader::~ArchiveReader()
+{
+    if (mData != nullptr) {
+        munmap((void *) mData, mSize);
+    }
+}
+
+status_t ArchiveReader::parse()
+{
+    size_t offset = 0;
+    while (offset < mSize) {
+        // Concatenated archives repeat the header.
+        ArchiveHeader header;
+        if (mSize - offset >= sizeof(header)) {
+            memcpy(&header, mData + offset, sizeof(header));
+            if (header.magic == ArchiveHeader::kMagic) {
+                if (header.version != ArchiveHeader::kVersion) {
+                    return BAD_VALUE;
+                }
+                offset += sizeof(header);
+                continue;
+            }
+        }
+        if (offset == 0) {
+            return BAD_VALUE;
+        }
+        ArchiveRecordHeader record;
+        if (mSize - offset < sizeof(record)) {
+            return NOT_ENOUGH_DATA;
+        }
+        memcpy(&record, mData + offset, sizeof(record));
+        offset += sizeof(record);
+        if (mSize - offset < (size_t) record.nameLength + record.dataLength) {
+            return NOT_ENOUGH_DATA;
+        }
+        const char *name = (const char *) mData + offset;
+        offset += record.nameLength;
+        const uint8_t *entries = mData + offset;
+        offset += record.dataLength;
+        mRecords.push_back({std::string(name, record.nameLength), record.captureTimeNs,
+                (size_t) record.lost, EntryIterator(entries),
+                EntryIterator(entries + record.dataLength)});
+    }
+    return NO_ERROR;
+}
+
+}   // namespace NBLog
+}   // namespace android
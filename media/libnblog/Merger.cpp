@@ -131,10 +131,15 @@ MergeReader::MergeReader(const void *shared, size_t size, Merger &merger)
 // Takes raw content of the local merger FIFO, processes log entries, and
 // writes the data to a map of class PerformanceAnalysis, based on their thread ID.
 void MergeReader::processSnapshot(Snapshot &snapshot, int author)
+{
+    processEntries(snapshot.begin(), snapshot.end(), author);
+}
+
+void MergeReader::processEntries(EntryIterator begin, EntryIterator end, int author)
 {
     ReportPerformance::PerformanceData& data = mThreadPerformanceData[author];
     // We don't do "auto it" because it reduces readability in this case.
-    for (EntryIterator it = snapshot.begin(); it != snapshot.end(); ++it) {
+    for (EntryIterator it = begin; it != end; ++it) {
         switch (it->type) {
         case EVENT_HISTOGRAM_ENTRY_TS: {
             const HistTsEntry payload = it.payload<HistTsEntry>();
@@ -162,6 +167,10 @@ void MergeReader::processSnapshot(Snapshot &snapshot, int author)
             const double monotonicMs = monotonicNs * 1e-6;
             data.workHist.add(monotonicMs);
             data.active += monotonicNs;
+            data.addCycle(monotonicNs);
+        } break;
+        case EVENT_CPU_TIME: {
+            data.addCpuTime(it.payload<int64_t>());
         } break;
         case EVENT_WARMUP_TIME: {
             const double timeMs = it.payload<double>();
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <climits>
+#include <cstdlib>
 #include <deque>
 #include <iomanip>
 #include <math.h>
@@ -155,6 +156,35 @@ std::string Histogram::asciiArtString(size_t indent) const {
 
 //------------------------------------------------------------------------------
 
+void PerformanceData::addCycle(int64_t cycleNs)
+{
+    pendingCycleNs = cycleNs;
+    const int64_t period = periodNs();
+    if (period > 0) {
+        jitterHist.add(std::abs(cycleNs - period) * 1e-6);
+    }
+}
+
+void PerformanceData::addCpuTime(int64_t cpuNs)
+{
+    const int64_t cycleNs = pendingCycleNs;
+    pendingCycleNs = 0;
+    const int64_t period = periodNs();
+    if (cycleNs <= 0 || period <= 0 || cycleNs <= period * kLateCycleFactor) {
+        return;
+    }
+    lateCycles++;
+    const int64_t schedDelayNs = std::max((int64_t) 0, cycleNs - std::max(cpuNs, period));
+    schedDelayHist.add(schedDelayNs * 1e-6);
+    if (cpuNs - period >= schedDelayNs) {
+        computeBoundLateCycles++;
+    } else {
+        scheduleBoundLateCycles++;
+    }
+}
+
+//------------------------------------------------------------------------------
+
 // Given an audio processing wakeup timestamp, buckets the time interval
 // since the previous timestamp into a histogram, searches for
 // outliers, analyzes the outlier series for unexpectedly
@@ -51,6 +51,11 @@ static std::unique_ptr<Json::Value> dumpToJson(const PerformanceData& data)
     root["workMsHist"] = data.workHist.toString();
     root["latencyMsHist"] = data.latencyHist.toString();
     root["warmupMsHist"] = data.warmupHist.toString();
+    root["jitterMsHist"] = data.jitterHist.toString();
+    root["schedDelayMsHist"] = data.schedDelayHist.toString();
+    root["lateCycles"] = (Json::Value::Int64)data.lateCycles;
+    root["computeBoundLateCycles"] = (Json::Value::Int64)data.computeBoundLateCycles;
+    root["scheduleBoundLateCycles"] = (Json::Value::Int64)data.scheduleBoundLateCycles;
     root["underruns"] = (Json::Value::Int64)data.underruns;
     root["overruns"] = (Json::Value::Int64)data.overruns;
     root["activeMs"] = (Json::Value::Int64)ns2ms(data.active);
@@ -69,6 +74,12 @@ static std::string dumpHistogramsToString(const PerformanceData& data)
     ss << "  Thread work times in ms:\n" << data.workHist.asciiArtString(4 /*indent*/);
     ss << "  Thread latencies in ms:\n" << data.latencyHist.asciiArtString(4 /*indent*/);
     ss << "  Thread warmup times in ms:\n" << data.warmupHist.asciiArtString(4 /*indent*/);
+    ss << "  Thread wakeup jitter in ms:\n" << data.jitterHist.asciiArtString(4 /*indent*/);
+    ss << "  Scheduling delay of late cycles in ms:\n"
+            << data.schedDelayHist.asciiArtString(4 /*indent*/);
+    ss << "  Late cycles: " << data.lateCycles
+            << " (compute bound " << data.computeBoundLateCycles
+            << ", schedule bound " << data.scheduleBoundLateCycles << ")\n";
     return ss.str();
 }
 
@@ -162,6 +173,14 @@ bool sendToMediaMetrics(const PerformanceData& data)
     static constexpr char kThreadOverruns[] = "android.media.audiothread.overruns";
     static constexpr char kThreadActive[] = "android.media.audiothread.activeMs";
     static constexpr char kThreadDuration[] = "android.media.audiothread.durationMs";
+    static constexpr char kThreadJitterHist[] = "android.media.audiothread.jitterMs.hist";
+    static constexpr char kThreadSchedDelayHist[] =
+            "android.media.audiothread.schedDelayMs.hist";
+    static constexpr char kThreadLateCycles[] = "android.media.audiothread.lateCycles";
+    static constexpr char kThreadComputeBoundLateCycles[] =
+            "android.media.audiothread.lateCycles.computeBound";
+    static constexpr char kThreadScheduleBoundLateCycles[] =
+            "android.media.audiothread.lateCycles.scheduleBound";
 
     // Currently, we only allow FastMixer thread data to be sent to Media Metrics.
     if (data.threadInfo.type != NBLog::FASTMIXER) {
@@ -193,6 +212,18 @@ bool sendToMediaMetrics(const PerformanceData& data)
         item->setInt64(kThreadOverruns, data.overruns);
     }
 
+    const Histogram &jitterHist = data.jitterHist;
+    if (jitterHist.totalCount() > 0) {
+        item->setCString(kThreadJitterHist, jitterHist.toString().c_str());
+    }
+
+    if (data.lateCycles > 0) {
+        item->setCString(kThreadSchedDelayHist, data.schedDelayHist.toString().c_str());
+        item->setInt64(kThreadLateCycles, data.lateCycles);
+        item->setInt64(kThreadComputeBoundLateCycles, data.computeBoundLateCycles);
+        item->setInt64(kThreadScheduleBoundLateCycles, data.scheduleBoundLateCycles);
+    }
+
     // Send to Media Metrics if the record is not empty.
     // The thread and time info are added inside the if statement because
     // we want to send them only if there are performance metrics to send.
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_MEDIA_NBLOG_ARCHIVE_H
+#define ANDROID_MEDIA_NBLOG_ARCHIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <media/nblog/Entry.h>
+#include <utils/Errors.h>
+
+namespace android {
+namespace NBLog {
+
+class Snapshot;
+
+// An archive is a binary file of reader snapshots, so that logs can be kept and analyzed
+// offline instead of being formatted by a live dump. The layout is an ArchiveHeader followed
+// by records, each made of an ArchiveRecordHeader, the writer name and the raw entries of
+// one snapshot, from Snapshot::begin() to Snapshot::end(). Archives may be concatenated.
+struct ArchiveHeader {
+    static constexpr uint32_t kMagic = 0x474c424e;  // "NBLG"
+    static constexpr uint32_t kVersion = 1;
+
+    uint32_t magic = kMagic;
+    uint32_t version = kVersion;
+};
+
+struct ArchiveRecordHeader {
+    int64_t  captureTimeNs;     // CLOCK_MONOTONIC time at which the snapshot was taken
+    uint64_t lost;              // bytes lost by the reader before the snapshot
+    uint32_t nameLength;        // bytes of writer name following this header, not terminated
+    uint32_t dataLength;        // bytes of entries following the name
+};
+
+// Writes an ArchiveHeader to fd.
+status_t writeArchiveHeader(int fd);
+
+// Appends the entries of snapshot, taken from the writer called name, to fd as one record.
+status_t writeArchiveRecord(int fd, const std::string &name, const Snapshot &snapshot);
+
+// Maps an archive file read-only and indexes its records.
+// The EntryIterators of the records stay valid for the lifetime of the ArchiveReader.
+class ArchiveReader {
+public:
+    struct Record {
+        std::string     name;
+        int64_t         captureTimeNs;
+        size_t          lost;
+        EntryIterator   begin;
+        EntryIterator   end;
+    };
+
+    explicit ArchiveReader(const char *path);
+    ~ArchiveReader();
+
+    ArchiveReader(const ArchiveReader&) = delete;
+    ArchiveReader& operator=(const ArchiveReader&) = delete;
+
+    // Returns NO_ERROR if the file was mapped and all of its records are complete.
+    status_t initCheck() const { return mStatus; }
+
+    const std::vector<Record>& records() const { return mRecords; }
+
+private:
+    status_t parse();
+
+    status_t            mStatus = NO_INIT;
+    const uint8_t      *mData = nullptr;
+    size_t              mSize = 0;
+    std::vector<Record> mRecords;
+};
+
+}   // namespace NBLog
+}   // namespace android
+
+#endif  // ANDROID_MEDIA_NBLOG_ARCHIVE_H
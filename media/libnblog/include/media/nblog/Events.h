@@ -68,6 +68,8 @@ enum Event : uint8_t {
     EVENT_WARMUP_TIME,          // thread warmup time
     EVENT_WORK_TIME,            // the time a thread takes to do work, e.g. read, write, etc.
     EVENT_THREAD_PARAMS,        // see thread_params_t below
+    EVENT_CPU_TIME,             // CPU time of the thread during the cycle of the preceding
+                                // EVENT_WORK_TIME, in nanoseconds
 
     EVENT_UPPER_BOUND,          // to check for invalid events
 };
@@ -149,6 +151,7 @@ MAP_EVENT_TO_TYPE(EVENT_UNDERRUN, int64_t);
 MAP_EVENT_TO_TYPE(EVENT_WARMUP_TIME, double);
 MAP_EVENT_TO_TYPE(EVENT_WORK_TIME, int64_t);
 MAP_EVENT_TO_TYPE(EVENT_THREAD_PARAMS, thread_params_t);
+MAP_EVENT_TO_TYPE(EVENT_CPU_TIME, int64_t);
 
 }   // namespace NBLog
 }   // namespace android
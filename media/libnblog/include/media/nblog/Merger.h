@@ -79,6 +79,9 @@ public:
     // process a particular snapshot of the reader
     void processSnapshot(Snapshot &snap, int author);
 
+    // process the entries in [begin, end), for instance those of an archive record
+    void processEntries(EntryIterator begin, EntryIterator end, int author);
+
     // call getSnapshot of the content of the reader's buffer and process the data
     void getAndProcessSnapshot();
 
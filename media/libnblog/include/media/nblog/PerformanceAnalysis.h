@@ -152,6 +152,18 @@ struct PerformanceData {
     // bin size and lower/upper limits.
     static constexpr Histogram::Config kWarmupConfig = { 5., 10, 10.};
 
+    // Wakeup jitter is the absolute difference between a cycle time and the nominal period
+    // given by the thread params, resolved to 0.1 ms up to 5 ms.
+    static constexpr Histogram::Config kJitterConfig = { 0.1, 50, 0.};
+
+    // Scheduling delay of a late cycle is the part of the cycle that is explained neither by
+    // the nominal period nor by the CPU time of the thread, i.e. time spent runnable but
+    // not running, or blocked.
+    static constexpr Histogram::Config kSchedDelayConfig = { 0.5, 20, 0.};
+
+    // A cycle is late when it exceeds the nominal period by this factor.
+    static constexpr double kLateCycleFactor = 1.5;
+
     NBLog::thread_info_t threadInfo{};
     NBLog::thread_params_t threadParams{};
 
@@ -159,6 +171,8 @@ struct PerformanceData {
     Histogram workHist{kWorkConfig};
     Histogram latencyHist{kLatencyConfig};
     Histogram warmupHist{kWarmupConfig};
+    Histogram jitterHist{kJitterConfig};
+    Histogram schedDelayHist{kSchedDelayConfig};
     int64_t underruns = 0;
     static constexpr size_t kMaxSnapshotsToStore = 256;
     std::deque<std::pair<NBLog::Event, int64_t /*timestamp*/>> snapshots;
@@ -166,6 +180,27 @@ struct PerformanceData {
     nsecs_t active = 0;
     nsecs_t start{systemTime()};
 
+    // Late cycles by cause: compute bound when the CPU time of the thread accounts for
+    // most of the lateness, otherwise schedule bound (preempted, throttled or blocked).
+    int64_t lateCycles = 0;
+    int64_t computeBoundLateCycles = 0;
+    int64_t scheduleBoundLateCycles = 0;
+
+    // Cycle time of the last EVENT_WORK_TIME, until the matching EVENT_CPU_TIME arrives.
+    int64_t pendingCycleNs = 0;
+
+    // Nominal cycle period from the thread params, 0 if unknown.
+    int64_t periodNs() const {
+        return threadParams.sampleRate == 0 ? 0
+                : (int64_t) threadParams.frameCount * 1000000000 / threadParams.sampleRate;
+    }
+
+    // Accounts for the wakeup jitter of a cycle of cycleNs.
+    void addCycle(int64_t cycleNs);
+
+    // Classifies the last cycle given the CPU time of the thread during that cycle.
+    void addCpuTime(int64_t cpuNs);
+
     // Reset the performance data. This does not represent a thread state change.
     // Thread info is not reset here because the data is meant to be a continuation of the thread
     // that struct PerformanceData is associated with.
@@ -173,17 +208,22 @@ struct PerformanceData {
         workHist.clear();
         latencyHist.clear();
         warmupHist.clear();
+        jitterHist.clear();
+        schedDelayHist.clear();
         underruns = 0;
         overruns = 0;
         active = 0;
         start = systemTime();
+        lateCycles = 0;
+        computeBoundLateCycles = 0;
+        scheduleBoundLateCycles = 0;
     }
 
     // Return true if performance data has not been recorded yet, false otherwise.
     bool empty() const {
         return workHist.totalCount() == 0 && latencyHist.totalCount() == 0
-                && warmupHist.totalCount() == 0 && underruns == 0 && overruns == 0
-                && active == 0;
+                && warmupHist.totalCount() == 0 && jitterHist.totalCount() == 0
+                && underruns == 0 && overruns == 0 && active == 0 && lateCycles == 0;
     }
 };
 
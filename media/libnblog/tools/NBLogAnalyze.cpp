@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Offline analysis of NBLog archives exported with "dumpsys media.log -b > file".
+// Records of all archives are merged into one timeline ordered by capture time, the records
+// of a writer that appears in several archives are attributed to the same author, and the
+// merged data is run through the same performance analysis as media.log itself.
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <media/nblog/Archive.h>
+#include <media/nblog/Merger.h>
+#include <utils/String16.h>
+#include <utils/Vector.h>
+
+using namespace android;
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [--records] [--pa] [--json] [--plots] [--retro] archive...\n"
+            "  --records  list the merged records before the analysis\n"
+            "  --pa, --json, --plots, --retro  as for dumpsys media.log\n",
+            name);
+}
+
+int main(int argc, char **argv)
+{
+    bool listRecords = false;
+    Vector<String16> dumpArgs;
+    std::vector<std::unique_ptr<NBLog::ArchiveReader>> archives;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--records")) {
+            listRecords = true;
+        } else if (!strncmp(argv[i], "--", 2)) {
+            dumpArgs.add(String16(argv[i]));
+        } else {
+            auto archive = std::make_unique<NBLog::ArchiveReader>(argv[i]);
+            if (archive->initCheck() != NO_ERROR) {
+                fprintf(stderr, "%s: cannot read archive %s\n", argv[0], argv[i]);
+                return EXIT_FAILURE;
+            }
+            archives.push_back(std::move(archive));
+        }
+    }
+    if (archives.empty()) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<const NBLog::ArchiveReader::Record *> timeline;
+    for (const auto &archive : archives) {
+        for (const auto &record : archive->records()) {
+            timeline.push_back(&record);
+        }
+    }
+    std::stable_sort(timeline.begin(), timeline.end(), [](const auto *a, const auto *b) {
+        return a->captureTimeNs < b->captureTimeNs;
+    });
+
+    // Without shared memory, the merger and its reader only aggregate what they are given.
+    NBLog::Merger merger(nullptr /*shared*/, 0 /*size*/);
+    NBLog::MergeReader mergeReader(nullptr /*shared*/, 0 /*size*/, merger);
+    std::map<std::string, int> authors;
+    for (const auto *record : timeline) {
+        const auto result = authors.emplace(record->name, authors.size());
+        const int author = result.first->second;
+        if (listRecords) {
+            printf("%lld.%09lld author %d %s: %d bytes, %zu lost\n",
+                    (long long) (record->captureTimeNs / 1000000000),
+                    (long long) (record->captureTimeNs % 1000000000),
+                    author, record->name.c_str(), record->end - record->begin, record->lost);
+        }
+        mergeReader.processEntries(record->begin, record->end, author);
+    }
+
+    printf("Authors:\n");
+    for (const auto &[name, author] : authors) {
+        printf("  %d: %s\n", author, name.c_str());
+    }
+    fflush(stdout);
+    mergeReader.dump(STDOUT_FILENO, dumpArgs);
+    return EXIT_SUCCESS;
+}
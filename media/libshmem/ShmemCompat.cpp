@@ -15,12 +15,90 @@
  */
 #include "media/ShmemCompat.h"
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <tuple>
+
 #include "binder/MemoryBase.h"
 #include "binder/MemoryHeapBase.h"
 #include "media/ShmemUtil.h"
 
 namespace android {
 namespace media {
+namespace {
+
+/**
+ * Maps the heaps created from SharedFileRegions, keyed by the identity of the underlying file
+ * rather than by fd, since every transfer of the same region arrives with a new fd.
+ * A region that is converted again while a heap for it is alive reuses that heap, which saves
+ * the fd dup and the mmap of a new MemoryHeapBase.
+ * Only weak references are kept, so the cache never extends the lifetime of a heap.
+ */
+class HeapCache {
+public:
+    static HeapCache& getInstance() {
+        static HeapCache* const instance = new HeapCache();  // never destroyed.
+        return *instance;
+    }
+
+    sp<MemoryHeapBase> getHeap(int fd, size_t size, uint32_t flags, off_t offset) {
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0) {
+            return new MemoryHeapBase(fd, size, flags, offset);
+        }
+        // The cached heap holds its own fd for the file, so the inode cannot be reused
+        // while the heap is alive.
+        const Key key{fileStat.st_dev, fileStat.st_ino, offset, size, flags};
+        std::lock_guard lock(mMutex);
+        auto it = mHeaps.find(key);
+        if (it != mHeaps.end()) {
+            if (sp<MemoryHeapBase> heap = it->second.promote(); heap != nullptr) {
+                return heap;
+            }
+        }
+        const sp<MemoryHeapBase> heap = new MemoryHeapBase(fd, size, flags, offset);
+        if (heap->getHeapID() < 0) {
+            return heap;  // do not cache failures.
+        }
+        if (it != mHeaps.end()) {
+            it->second = heap;
+        } else {
+            sweepIfNeeded_l();
+            mHeaps.emplace(key, heap);
+        }
+        return heap;
+    }
+
+private:
+    // dev, inode, offset, size, flags
+    using Key = std::tuple<dev_t, ino_t, off_t, size_t, uint32_t>;
+
+    static constexpr size_t kMinSweepSize = 16;
+
+    HeapCache() = default;
+
+    // Removes the entries of released heaps once the map has doubled since the last sweep.
+    void sweepIfNeeded_l() {
+        if (mHeaps.size() < mSweepSize) return;
+        for (auto it = mHeaps.begin(); it != mHeaps.end();) {
+            if (it->second.promote() == nullptr) {
+                it = mHeaps.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        mSweepSize = std::max(kMinSweepSize, 2 * mHeaps.size());
+    }
+
+    std::mutex mMutex;
+    std::map<Key, wp<MemoryHeapBase>> mHeaps;  // guarded by mMutex
+    size_t mSweepSize = kMinSweepSize;         // guarded by mMutex
+};
+
+}  // namespace
 
 bool convertSharedFileRegionToIMemory(const SharedFileRegion& shmem,
                                       sp<IMemory>* result) {
@@ -51,8 +129,8 @@ bool convertSharedFileRegionToIMemory(const SharedFileRegion& shmem,
 
     uint32_t flags = !shmem.writeable ? IMemoryHeap::READ_ONLY : 0;
 
-    const sp<MemoryHeapBase> heap =
-            new MemoryHeapBase(shmem.fd.get(), heapSize, flags, heapStartOffset);
+    const sp<MemoryHeapBase> heap = HeapCache::getInstance().getHeap(
+            shmem.fd.get(), heapSize, flags, heapStartOffset);
     *result = sp<MemoryBase>::make(heap,
                                    shmem.offset - heapStartOffset,
                                    shmem.size);
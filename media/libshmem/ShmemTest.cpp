@@ -102,6 +102,32 @@ TEST(ShmemTest, ConversionReadOnly) {
     EXPECT_EQ(3, p[2]);
 }
 
+TEST(ShmemTest, ConversionReusesHeap) {
+    sp<IMemory> imem = makeIMemory({6, 5, 3});
+    SharedFileRegion shmem1;
+    SharedFileRegion shmem2;
+    ASSERT_TRUE(convertIMemoryToSharedFileRegion(imem, &shmem1));
+    ASSERT_TRUE(convertIMemoryToSharedFileRegion(imem, &shmem2));
+    ASSERT_NE(shmem1.fd.get(), shmem2.fd.get());
+
+    // The same region through different fds maps to the same heap while it is referenced.
+    sp<IMemory> reconstructed1;
+    sp<IMemory> reconstructed2;
+    ASSERT_TRUE(convertSharedFileRegionToIMemory(shmem1, &reconstructed1));
+    ASSERT_TRUE(convertSharedFileRegionToIMemory(shmem2, &reconstructed2));
+    EXPECT_EQ(reconstructed1->getMemory(), reconstructed2->getMemory());
+    EXPECT_EQ(reconstructed1->unsecurePointer(), reconstructed2->unsecurePointer());
+
+    // A read-only conversion of the same region gets a heap of its own.
+    shmem2.writeable = false;
+    sp<IMemory> readOnly;
+    ASSERT_TRUE(convertSharedFileRegionToIMemory(shmem2, &readOnly));
+    EXPECT_NE(reconstructed1->getMemory(), readOnly->getMemory());
+    EXPECT_NE(readOnly->getMemory()->getFlags() & IMemoryHeap::READ_ONLY, 0);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(readOnly->unsecurePointer());
+    EXPECT_EQ(6, p[0]);
+}
+
 TEST(ShmemTest, NullConversion) {
     sp<IMemory> reconstructed;
     {
@@ -30,6 +30,8 @@ namespace media {
 
 /**
  * Converts a SharedFileRegion parcelable to an IMemory instance.
+ * Converting the same region again while the heap of an earlier result is still referenced
+ * returns an IMemory on that same heap, without mapping the region again.
  * @param shmem The SharedFileRegion instance.
  * @param result The resulting IMemory instance. May not be null.
  * @return true if the conversion is successful (should always succeed under normal circumstances,
@@ -24,6 +24,8 @@
 #include <inttypes.h>
 #include <utils/Trace.h>
 
+#include <thread>
+
 #include <android/hardware/media/omx/1.0/IGraphicBufferSource.h>
 
 #include <gui/Surface.h>
@@ -82,6 +84,34 @@ namespace {
 constexpr char TUNNEL_PEEK_KEY[] = "android._trigger-tunnel-peek";
 constexpr char TUNNEL_PEEK_SET_LEGACY_KEY[] = "android._tunnel-peek-set-legacy";
 
+// metrics keys for the phases of start, in us
+constexpr char START_IDLE_COMMAND_KEY[] = "android.media.mediacodec.start.idle-command-us";
+constexpr char START_INPUT_BUFFERS_KEY[] = "android.media.mediacodec.start.input-buffers-us";
+constexpr char START_OUTPUT_BUFFERS_KEY[] = "android.media.mediacodec.start.output-buffers-us";
+constexpr char START_TO_IDLE_KEY[] = "android.media.mediacodec.start.to-idle-us";
+constexpr char START_TO_EXECUTING_KEY[] = "android.media.mediacodec.start.to-executing-us";
+
+// Allocates |count| shared memory buffers of |size| bytes with a single call to the allocator.
+status_t batchAllocate(
+        const sp<TAllocator> &allocator, size_t size, size_t count,
+        std::vector<hidl_memory> *memories) {
+    bool success = false;
+    auto transStatus = allocator->batchAllocate(
+            size, count,
+            [&success, count, memories](bool s, hardware::hidl_vec<hidl_memory> const& batch) {
+                success = s && batch.size() == count;
+                if (success) {
+                    memories->assign(batch.begin(), batch.end());
+                }
+            });
+    if (!transStatus.isOk()) {
+        ALOGE("hidl's AshmemAllocator failed at the transport: %s",
+                transStatus.description().c_str());
+        return NO_MEMORY;
+    }
+    return success ? OK : NO_MEMORY;
+}
+
 }
 
 // OMX errors are directly mapped into status_t range if
@@ -576,6 +606,7 @@ ACodec::ACodec()
       mIsLegacyVP9Decoder(false),
       mIsStreamCorruptFree(false),
       mIsLowLatency(false),
+      mStartPhaseTimeUs(0),
       mEncoderDelay(0),
       mEncoderPadding(0),
       mRotationDegrees(0),
@@ -949,6 +980,8 @@ status_t ACodec::allocateBuffersOnPort(OMX_U32 portIndex) {
                 return NO_MEMORY;
             }
 
+            std::vector<hidl_memory> hidlMemTokens;
+            std::vector<hidl_memory> conversionMemTokens;
             if (mode != IOMX::kPortModePresetSecureBuffer) {
                 mAllocator[portIndex] = TAllocator::getService("ashmem");
                 if (mAllocator[portIndex] == nullptr) {
@@ -959,12 +992,23 @@ status_t ACodec::allocateBuffersOnPort(OMX_U32 portIndex) {
                 // TODO: When Treble has MemoryHeap/MemoryDealer, we should
                 // specify the heap size to be
                 // def.nBufferCountActual * (alignedSize + alignedConvSize).
+
+                // allocate the memory for all buffers of the port in one round trip
+                err = batchAllocate(mAllocator[portIndex], bufSize,
+                        def.nBufferCountActual, &hidlMemTokens);
+                if (err == OK && mConverter[portIndex] != NULL) {
+                    CHECK_GT(conversionBufferSize, (size_t)0);
+                    err = batchAllocate(mAllocator[portIndex], conversionBufferSize,
+                            def.nBufferCountActual, &conversionMemTokens);
+                }
+                if (err != OK) {
+                    return err;
+                }
             }
 
             const sp<AMessage> &format =
                     portIndex == kPortIndexInput ? mInputFormat : mOutputFormat;
             for (OMX_U32 i = 0; i < def.nBufferCountActual && err == OK; ++i) {
-                hidl_memory hidlMemToken;
                 sp<TMemory> hidlMem;
                 sp<IMemory> mem;
 
@@ -987,31 +1031,12 @@ status_t ACodec::allocateBuffersOnPort(OMX_U32 portIndex) {
                             : new SecureBuffer(format, native_handle, bufSize);
                     info.mCodecData = info.mData;
                 } else {
-                    bool success;
-                    auto transStatus = mAllocator[portIndex]->allocate(
-                            bufSize,
-                            [&success, &hidlMemToken](
-                                    bool s,
-                                    hidl_memory const& m) {
-                                success = s;
-                                hidlMemToken = m;
-                            });
-
-                    if (!transStatus.isOk()) {
-                        ALOGE("hidl's AshmemAllocator failed at the "
-                                "transport: %s",
-                                transStatus.description().c_str());
-                        return NO_MEMORY;
-                    }
-                    if (!success) {
-                        return NO_MEMORY;
-                    }
-                    hidlMem = mapMemory(hidlMemToken);
+                    hidlMem = mapMemory(hidlMemTokens[i]);
                     if (hidlMem == nullptr) {
                         return NO_MEMORY;
                     }
                     err = mOMXNode->useBuffer(
-                            portIndex, hidlMemToken, &info.mBufferID);
+                            portIndex, hidlMemTokens[i], &info.mBufferID);
 
                     if (mode == IOMX::kPortModeDynamicANWBuffer) {
                         VideoNativeMetadata* metaData = (VideoNativeMetadata*)(
@@ -1026,20 +1051,7 @@ status_t ACodec::allocateBuffersOnPort(OMX_U32 portIndex) {
                     // if we require conversion, allocate conversion buffer for client use;
                     // otherwise, reuse codec buffer
                     if (mConverter[portIndex] != NULL) {
-                        CHECK_GT(conversionBufferSize, (size_t)0);
-                        bool success;
-                        mAllocator[portIndex]->allocate(
-                                conversionBufferSize,
-                                [&success, &hidlMemToken](
-                                        bool s,
-                                        hidl_memory const& m) {
-                                    success = s;
-                                    hidlMemToken = m;
-                                });
-                        if (!success) {
-                            return NO_MEMORY;
-                        }
-                        hidlMem = mapMemory(hidlMemToken);
+                        hidlMem = mapMemory(conversionMemTokens[i]);
                         if (hidlMem == nullptr) {
                             return NO_MEMORY;
                         }
@@ -7378,7 +7390,12 @@ void ACodec::LoadedState::onSetInputSurface(const sp<AMessage> &msg) {
 void ACodec::LoadedState::onStart() {
     ALOGV("onStart");
 
+    mCodec->mStartMetrics = new AMessage;
+    mCodec->mStartPhaseTimeUs = ALooper::GetNowUs();
     status_t err = mCodec->mOMXNode->sendCommand(OMX_CommandStateSet, OMX_StateIdle);
+    int64_t nowUs = ALooper::GetNowUs();
+    mCodec->mStartMetrics->setInt64(START_IDLE_COMMAND_KEY, nowUs - mCodec->mStartPhaseTimeUs);
+    mCodec->mStartPhaseTimeUs = nowUs;
     if (err != OK) {
         mCodec->signalError(OMX_ErrorUndefined, makeNoSideEffectStatus(err));
     } else {
@@ -7423,12 +7440,29 @@ void ACodec::LoadedToIdleState::stateEntered() {
 }
 
 status_t ACodec::LoadedToIdleState::allocateBuffers() {
-    status_t err = mCodec->allocateBuffersOnPort(kPortIndexInput);
-    if (err != OK) {
-        return err;
+    // The input and output ports do not share any state, so allocate the input buffers on a
+    // separate thread while the output buffers are allocated here. The calls into the component
+    // are still serialized by the OMX node.
+    const int64_t startUs = ALooper::GetNowUs();
+    status_t inputErr = OK;
+    int64_t inputDoneUs = startUs;
+    std::thread inputThread([this, &inputErr, &inputDoneUs] {
+        inputErr = mCodec->allocateBuffersOnPort(kPortIndexInput);
+        inputDoneUs = ALooper::GetNowUs();
+    });
+    status_t err = mCodec->allocateBuffersOnPort(kPortIndexOutput);
+    const int64_t outputDoneUs = ALooper::GetNowUs();
+    inputThread.join();
+
+    if (mCodec->mStartMetrics != NULL) {
+        mCodec->mStartMetrics->setInt64(START_INPUT_BUFFERS_KEY, inputDoneUs - startUs);
+        mCodec->mStartMetrics->setInt64(START_OUTPUT_BUFFERS_KEY, outputDoneUs - startUs);
+    }
+    mCodec->mStartPhaseTimeUs = ALooper::GetNowUs();
+
+    if (inputErr != OK) {
+        return inputErr;
     }
-
-    err = mCodec->allocateBuffersOnPort(kPortIndexOutput);
     if (err != OK) {
         return err;
     }
@@ -7491,6 +7525,12 @@ bool ACodec::LoadedToIdleState::onOMXEvent(
             }
 
             if (err == OK) {
+                if (mCodec->mStartMetrics != NULL) {
+                    int64_t nowUs = ALooper::GetNowUs();
+                    mCodec->mStartMetrics->setInt64(
+                            START_TO_IDLE_KEY, nowUs - mCodec->mStartPhaseTimeUs);
+                    mCodec->mStartPhaseTimeUs = nowUs;
+                }
                 err = mCodec->mOMXNode->sendCommand(
                     OMX_CommandStateSet, OMX_StateExecuting);
             }
@@ -7566,6 +7606,13 @@ bool ACodec::IdleToExecutingState::onOMXEvent(
                 return true;
             }
 
+            if (mCodec->mStartMetrics != NULL) {
+                mCodec->mStartMetrics->setInt64(
+                        START_TO_EXECUTING_KEY, ALooper::GetNowUs() - mCodec->mStartPhaseTimeUs);
+                mCodec->mCallback->onMetricsUpdated(mCodec->mStartMetrics);
+                mCodec->mStartMetrics.clear();
+            }
+
             mCodec->mExecutingState->resume();
             mCodec->changeState(mCodec->mExecutingState);
 
@@ -39,6 +39,7 @@ namespace android {
 
 static const size_t kMaxUDPSize = 1500;
 static const int32_t kMaxUDPRetries = 200;
+static const size_t kMaxUDPBatchSize = 32;
 
 struct ANetworkSession::NetworkThread : public Thread {
     explicit NetworkThread(ANetworkSession *session);
@@ -90,6 +91,9 @@ struct ANetworkSession::Session : public RefBase {
     status_t sendRequest(
             const void *data, ssize_t size, bool timeValid, int64_t timeUs);
 
+    status_t sendDatagram(
+            const sp<ABuffer> &datagram, bool timeValid, int64_t timeUs);
+
     void setMode(Mode mode);
 
     status_t switchToWebSocketMode();
@@ -540,24 +544,41 @@ status_t ANetworkSession::Session::writeMore() {
     if (mState == DATAGRAM) {
         CHECK(!mOutFragments.empty());
 
+        struct mmsghdr msgs[kMaxUDPBatchSize];
+        struct iovec iovs[kMaxUDPBatchSize];
+
         status_t err;
         do {
-            const Fragment &frag = *mOutFragments.begin();
-            const sp<ABuffer> &datagram = frag.mBuffer;
+            // Send as many queued datagrams as possible with one system call.
+            size_t count = 0;
+            for (List<Fragment>::iterator it = mOutFragments.begin();
+                    it != mOutFragments.end() && count < kMaxUDPBatchSize;
+                    ++it, ++count) {
+                const sp<ABuffer> &datagram = it->mBuffer;
+                iovs[count].iov_base = datagram->data();
+                iovs[count].iov_len = datagram->size();
+
+                memset(&msgs[count], 0, sizeof(msgs[count]));
+                msgs[count].msg_hdr.msg_iov = &iovs[count];
+                msgs[count].msg_hdr.msg_iovlen = 1;
+            }
 
             int n;
             do {
-                n = send(mSocket, datagram->data(), datagram->size(), 0);
+                n = sendmmsg(mSocket, msgs, count, 0);
             } while (n < 0 && errno == EINTR);
 
             err = OK;
 
             if (n > 0) {
-                if (frag.mFlags & FRAGMENT_FLAG_TIME_VALID) {
-                    dumpFragmentStats(frag);
-                }
+                for (int i = 0; i < n; ++i) {
+                    const Fragment &frag = *mOutFragments.begin();
+                    if (frag.mFlags & FRAGMENT_FLAG_TIME_VALID) {
+                        dumpFragmentStats(frag);
+                    }
 
-                mOutFragments.erase(mOutFragments.begin());
+                    mOutFragments.erase(mOutFragments.begin());
+                }
             } else if (n < 0) {
                 err = -errno;
             } else if (n == 0) {
@@ -765,6 +786,32 @@ status_t ANetworkSession::Session::sendRequest(
     return OK;
 }
 
+status_t ANetworkSession::Session::sendDatagram(
+        const sp<ABuffer> &datagram, bool timeValid, int64_t timeUs) {
+    if (mState != DATAGRAM) {
+        // Stream based sessions need framing, which requires a copy.
+        return sendRequest(datagram->data(), datagram->size(), timeValid, timeUs);
+    }
+
+    if (datagram->size() == 0) {
+        return OK;
+    }
+
+    Fragment frag;
+
+    frag.mFlags = 0;
+    if (timeValid) {
+        frag.mFlags = FRAGMENT_FLAG_TIME_VALID;
+        frag.mTimeUs = timeUs;
+    }
+
+    frag.mBuffer = datagram;
+
+    mOutFragments.push_back(frag);
+
+    return OK;
+}
+
 void ANetworkSession::Session::notifyError(
         bool send, status_t err, const char *detail) {
     sp<AMessage> msg = mNotify->dup();
@@ -1210,6 +1257,31 @@ status_t ANetworkSession::sendRequest(
     return err;
 }
 
+status_t ANetworkSession::sendDatagrams(
+        int32_t sessionID, const List<sp<ABuffer> > &datagrams,
+        bool timeValid, int64_t timeUs) {
+    Mutex::Autolock autoLock(mLock);
+
+    ssize_t index = mSessions.indexOfKey(sessionID);
+
+    if (index < 0) {
+        return -ENOENT;
+    }
+
+    const sp<Session> session = mSessions.valueAt(index);
+
+    status_t err = OK;
+    for (List<sp<ABuffer> >::const_iterator it = datagrams.begin();
+            it != datagrams.end() && err == OK; ++it) {
+        bool isLast = (it == --datagrams.end());
+        err = session->sendDatagram(*it, timeValid && isLast, timeUs);
+    }
+
+    interrupt();
+
+    return err;
+}
+
 status_t ANetworkSession::switchToWebSocketMode(int32_t sessionID) {
     Mutex::Autolock autoLock(mLock);
 
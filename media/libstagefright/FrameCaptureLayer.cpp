@@ -105,12 +105,19 @@ void FrameCaptureLayer::BufferLayer::getLayerSettings(
             ? mBufferItem.mHdrMetadata.cta8613.maxContentLightLevel
                     : kDefaultMaxContentLuminance;
 
-    // Set filtering to false since the capture itself doesn't involve
-    // any scaling, metadata retriever JNI is scaling the bitmap if
-    // display size is different from decoded size. If that scaling
-    // needs to be handled by server side, consider enable this based
-    // display size vs decoded size.
-    const bool useFiltering = false;
+    // Only filter when the capture scales the frame, which is the case when
+    // the decoder asked for a thumbnail smaller than the decoded frame. The
+    // metadata retriever JNI still scales the bitmap if the display size is
+    // different from the captured size.
+    Rect bufferCrop = mBufferItem.mCrop.isEmpty()
+            ? mBufferItem.mGraphicBuffer->getBounds() : mBufferItem.mCrop;
+    int32_t bufferWidth = bufferCrop.getWidth();
+    int32_t bufferHeight = bufferCrop.getHeight();
+    if (mBufferItem.mTransform & NATIVE_WINDOW_TRANSFORM_ROT_90) {
+        std::swap(bufferWidth, bufferHeight);
+    }
+    const bool useFiltering = sourceCrop.getWidth() != bufferWidth
+            || sourceCrop.getHeight() != bufferHeight;
     layerSettings->source.buffer.useTextureFiltering = useFiltering;
 
     float textureMatrix[16];
@@ -22,6 +22,7 @@
 #include "include/HevcUtils.h"
 #include <binder/MemoryBase.h>
 #include <binder/MemoryHeapBase.h>
+#include <cutils/properties.h>
 #include <gui/Surface.h>
 #include <inttypes.h>
 #include <mediadrm/ICrypto.h>
@@ -42,11 +43,19 @@
 #include <private/media/VideoFrame.h>
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <thread>
+
+#include <libyuv/scale.h>
+#include <libyuv/scale_argb.h>
+
 namespace android {
 
 static const int64_t kBufferTimeOutUs = 10000LL; // 10 msec
 static const size_t kRetryCount = 100; // must be >0
 static const int64_t kDefaultSampleDurationUs = 33333LL; // 33ms
+// Upper bound for the number of codec instances decoding the tiles of one image.
+static const int32_t kMaxParallelTileDecoders = 8;
 
 sp<IMemory> allocVideoFrame(const sp<MetaData>& trackMeta,
         int32_t width, int32_t height, int32_t tileWidth, int32_t tileHeight,
@@ -255,6 +264,63 @@ sp<IMemory> FrameDecoder::getMetadataOnly(
     return metaMem;
 }
 
+// static
+sp<IMemory> FrameDecoder::scaleFrame(
+        const sp<IMemory> &frameMem, int32_t width, int32_t height) {
+    if (frameMem == nullptr || frameMem->unsecurePointer() == nullptr) {
+        return NULL;
+    }
+    const VideoFrame *src = static_cast<VideoFrame*>(frameMem->unsecurePointer());
+    if (width <= 0 || height <= 0) {
+        width = src->mWidth;
+        height = src->mHeight;
+    }
+    if (src->mWidth == 0 || src->mHeight == 0
+            || (src->mBytesPerPixel != 2 && src->mBytesPerPixel != 4)) {
+        ALOGE("cannot scale %ux%u frame with %u bytes per pixel",
+                src->mWidth, src->mHeight, src->mBytesPerPixel);
+        return NULL;
+    }
+
+    VideoFrame frame(width, height,
+            (uint64_t)src->mDisplayWidth * width / src->mWidth,
+            (uint64_t)src->mDisplayHeight * height / src->mHeight,
+            0 /*tileWidth*/, 0 /*tileHeight*/, src->mRotationAngle,
+            src->mBytesPerPixel, src->mBitDepth, true /*hasData*/, src->mIccSize);
+    if (frame.mSize == 0) {
+        return NULL;
+    }
+    frame.mDurationUs = src->mDurationUs;
+
+    size_t size = frame.getFlattenedSize();
+    sp<MemoryHeapBase> heap = new MemoryHeapBase(size, 0, "MetadataRetrieverClient");
+    if (heap == NULL) {
+        ALOGE("failed to create MemoryDealer");
+        return NULL;
+    }
+    sp<IMemory> dstMem = new MemoryBase(heap, 0, size);
+    if (dstMem == NULL || dstMem->unsecurePointer() == NULL) {
+        ALOGE("not enough memory for VideoFrame size=%zu", size);
+        return NULL;
+    }
+    VideoFrame *dst = static_cast<VideoFrame*>(dstMem->unsecurePointer());
+    dst->init(frame, src->getFlattenedIccData(), src->mIccSize);
+
+    // Packed 16-bit and 10-bit pixels can't be filtered per byte, so those are
+    // point sampled.
+    if (src->mBytesPerPixel == 4) {
+        libyuv::ARGBScale(src->getFlattenedData(), src->mRowBytes, src->mWidth, src->mHeight,
+                dst->getFlattenedData(), dst->mRowBytes, dst->mWidth, dst->mHeight,
+                src->mBitDepth == 8 ? libyuv::kFilterBox : libyuv::kFilterNone);
+    } else {
+        libyuv::ScalePlane_16((const uint16_t *)src->getFlattenedData(), src->mRowBytes / 2,
+                src->mWidth, src->mHeight,
+                (uint16_t *)dst->getFlattenedData(), dst->mRowBytes / 2,
+                dst->mWidth, dst->mHeight, libyuv::kFilterNone);
+    }
+    return dstMem;
+}
+
 FrameDecoder::FrameDecoder(
         const AString &componentName,
         const sp<MetaData> &trackMeta,
@@ -505,7 +571,40 @@ VideoFrameDecoder::VideoFrameDecoder(
       mIsHevc(false),
       mSeekMode(MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC),
       mTargetTimeUs(-1LL),
-      mDefaultSampleDurationUs(0) {
+      mDefaultSampleDurationUs(0),
+      mLastSampleTimeUs(-1LL),
+      mLastSyncTimeUs(-1LL),
+      mSyncIntervalUs(0),
+      mLastOutputTimeUs(-1LL),
+      mTargetWidth(0),
+      mTargetHeight(0) {
+}
+
+sp<IMemory> VideoFrameDecoder::extractFrameAtTime(int64_t frameTimeUs) {
+    // With closest seeking a seek decodes from the previous sync frame anyway,
+    // so keep decoding forward while the target is less than one sync interval
+    // ahead of the samples queued so far.
+    if (mSeekMode == MediaSource::ReadOptions::SEEK_CLOSEST && mHaveMoreInputs
+            && frameTimeUs > mLastOutputTimeUs && mSyncIntervalUs > 0
+            && frameTimeUs - mLastSampleTimeUs < mSyncIntervalUs) {
+        ALOGV("decoding forward to %" PRId64 " us", frameTimeUs);
+        mTargetTimeUs = frameTimeUs;
+        return extractFrame();
+    }
+
+    ALOGV("seeking to %" PRId64 " us", frameTimeUs);
+    status_t err = mDecoder->flush();
+    if (err != OK) {
+        ALOGW("flush returned error %d (%s)", err, asString(err));
+        return NULL;
+    }
+    mReadOptions.setSeekTo(frameTimeUs, mSeekMode);
+    mHaveMoreInputs = true;
+    mFirstSample = true;
+    mIDRSent = false;
+    mTargetTimeUs = -1LL;
+    mSampleDurations.clear();
+    return extractFrame();
 }
 
 sp<AMessage> VideoFrameDecoder::onGetFormatAndSeekOptions(
@@ -604,6 +703,21 @@ status_t VideoFrameDecoder::onInputReceived(
         // option, in which case we need to actually decode to targetTimeUs.
         mIDRSent == false ? mIDRSent = true : *flags |= MediaCodec::BUFFER_FLAG_EOS;
     }
+    int64_t timeUs;
+    int32_t isSync;
+    if (sampleMeta.findInt64(kKeyTime, &timeUs)) {
+        mLastSampleTimeUs = timeUs;
+        if (sampleMeta.findInt32(kKeyIsSyncFrame, &isSync) && isSync) {
+            // Seeks may skip sync frames, keep the shortest interval seen.
+            if (mLastSyncTimeUs >= 0 && timeUs > mLastSyncTimeUs) {
+                int64_t intervalUs = timeUs - mLastSyncTimeUs;
+                mSyncIntervalUs = (mSyncIntervalUs > 0)
+                        ? std::min(mSyncIntervalUs, intervalUs) : intervalUs;
+            }
+            mLastSyncTimeUs = timeUs;
+        }
+    }
+
     int64_t durationUs;
     if (sampleMeta.findInt64(kKeyDuration, &durationUs)) {
         mSampleDurations.push_back(durationUs);
@@ -630,6 +744,7 @@ status_t VideoFrameDecoder::onOutputReceived(
     }
 
     *done = true;
+    mLastOutputTimeUs = timeUs;
 
     if (outputFormat == NULL) {
         return ERROR_MALFORMED;
@@ -675,10 +790,32 @@ status_t VideoFrameDecoder::onOutputReceived(
     }
 
     if (mFrame == NULL) {
+        int32_t frameWidth = crop_right - crop_left + 1;
+        int32_t frameHeight = crop_bottom - crop_top + 1;
+        int32_t allocWidth = frameWidth;
+        int32_t allocHeight = frameHeight;
+        bool swapTarget = false;
+        int32_t rotationAngle;
+        if (trackMeta()->findInt32(kKeyRotation, &rotationAngle)
+                && (rotationAngle == 90 || rotationAngle == 270)) {
+            // the target is in the rotated orientation of the captured frame
+            swapTarget = true;
+        }
+        int32_t targetWidth = swapTarget ? mTargetHeight : mTargetWidth;
+        int32_t targetHeight = swapTarget ? mTargetWidth : mTargetHeight;
+        // Let the capture scale the frame down, instead of converting it at
+        // full size and scaling it on the CPU afterwards.
+        if (mCaptureLayer != nullptr && targetWidth > 0 && targetHeight > 0
+                && (targetWidth < frameWidth || targetHeight < frameHeight)) {
+            ALOGV("capturing %dx%d frame at %dx%d",
+                    frameWidth, frameHeight, targetWidth, targetHeight);
+            allocWidth = targetWidth;
+            allocHeight = targetHeight;
+        }
         sp<IMemory> frameMem = allocVideoFrame(
                 trackMeta(),
-                (crop_right - crop_left + 1),
-                (crop_bottom - crop_top + 1),
+                allocWidth,
+                allocHeight,
                 0,
                 0,
                 dstBpp(),
@@ -689,6 +826,20 @@ status_t VideoFrameDecoder::onOutputReceived(
         }
 
         mFrame = static_cast<VideoFrame*>(frameMem->unsecurePointer());
+        int32_t sarWidth, sarHeight, displayWidth;
+        bool hasSar = trackMeta()->findInt32(kKeySARWidth, &sarWidth)
+                && trackMeta()->findInt32(kKeySARHeight, &sarHeight) && sarHeight != 0;
+        if ((allocWidth != frameWidth || allocHeight != frameHeight) && !hasSar
+                && trackMeta()->findInt32(kKeyDisplayWidth, &displayWidth) && displayWidth > 0) {
+            // A display size from the track is for the full size frame, scale
+            // it along with the frame.
+            if (swapTarget) {
+                std::swap(frameWidth, frameHeight);
+                std::swap(allocWidth, allocHeight);
+            }
+            mFrame->mDisplayWidth = (uint64_t)mFrame->mDisplayWidth * allocWidth / frameWidth;
+            mFrame->mDisplayHeight = (uint64_t)mFrame->mDisplayHeight * allocHeight / frameHeight;
+        }
 
         setFrame(frameMem);
     }
@@ -820,6 +971,13 @@ MediaImageDecoder::MediaImageDecoder(
       mTileHeight(0),
       mTilesDecoded(0),
       mTargetTiles(0),
+      mFirstRectTile(0),
+      mLastRectTile(-1),
+      mRectLeftCol(0),
+      mRectRightCol(-1),
+      mLastSkippedTile(-1),
+      mMaxTileDecoders(1),
+      mTilesRead(0),
       mThread(NULL),
       mUseMultiThread(false) {
 }
@@ -928,25 +1086,30 @@ sp<AMessage> MediaImageDecoder::onGetFormatAndSeekOptions(
     } else {
         ALOGD("Enable multi-thread for Heif");
         mUseMultiThread = true;
+        // Decoding the tiles on several codec instances is opt-in, as each
+        // instance takes its share of the codec resources of the device.
+        mMaxTileDecoders = std::clamp(
+                property_get_int32("debug.stagefright.heif.parallel-tile-decoders", 1),
+                1, std::min(kMaxParallelTileDecoders, mTargetTiles));
+        mTileFormat = videoFormat;
     }
     return videoFormat;
 }
 
 status_t MediaImageDecoder::onExtractRect(FrameRect *rect) {
-    // TODO:
     // This callback is for verifying whether we can decode the rect,
     // and if so, set up the internal variables for decoding.
-    // Currently, rect decoding is restricted to sequentially decoding one
-    // row of tiles at a time. We can't decode arbitrary rects, as the image
-    // track doesn't yet support seeking by tiles. So all we do here is to
-    // verify the rect against what we expect.
-    // When seeking by tile is supported, this code should be updated to
-    // set the seek parameters.
+    // The image track doesn't support seeking by tiles, so the tiles are
+    // always read in order. Tiles that don't intersect the rect are read
+    // but not decoded, which restricts the rect to tiles that haven't been
+    // read or that are already queued to the decoder.
     if (rect == NULL) {
-        if (mTilesDecoded > 0) {
+        if (mTilesRead > 0) {
             return ERROR_UNSUPPORTED;
         }
-        mTargetTiles = mGridRows * mGridCols;
+        mFirstRectTile = mRectLeftCol = 0;
+        mLastRectTile = mTargetTiles - 1;
+        mRectRightCol = mGridCols - 1;
         return OK;
     }
 
@@ -954,26 +1117,92 @@ status_t MediaImageDecoder::onExtractRect(FrameRect *rect) {
         return ERROR_UNSUPPORTED;
     }
 
-    int32_t row = mTilesDecoded / mGridCols;
-    int32_t expectedTop = row * mTileHeight;
-    int32_t expectedBot = (row + 1) * mTileHeight;
-    if (expectedBot > mHeight) {
-        expectedBot = mHeight;
+    if (rect->left < 0 || rect->top < 0 || rect->right > mWidth || rect->bottom > mHeight
+            || rect->left >= rect->right || rect->top >= rect->bottom) {
+        ALOGE("invalid rect {%d, %d, %d, %d}", rect->left, rect->top, rect->right, rect->bottom);
+        return ERROR_UNSUPPORTED;
     }
-    if (rect->left != 0 || rect->top != expectedTop
-            || rect->right != mWidth || rect->bottom != expectedBot) {
-        ALOGE("currently only support sequential decoding of slices");
+
+    int32_t firstRow = rect->top / mTileHeight;
+    int32_t lastRow = (rect->bottom - 1) / mTileHeight;
+    int32_t firstCol = rect->left / mTileWidth;
+    int32_t lastCol = (rect->right - 1) / mTileWidth;
+    int32_t firstTile = firstRow * mGridCols + firstCol;
+    int32_t nextOutputTile;
+    {
+        std::lock_guard<std::mutex> lock(mSourceLock);
+        nextOutputTile = mQueuedTiles.empty() ? mTilesRead : mQueuedTiles.front();
+    }
+    if (firstTile < nextOutputTile || firstTile <= mLastSkippedTile) {
+        ALOGE("tiles of rect {%d, %d, %d, %d} were already read",
+                rect->left, rect->top, rect->right, rect->bottom);
         return ERROR_UNSUPPORTED;
     }
 
-    // advance one row
-    mTargetTiles = mTilesDecoded + mGridCols;
+    mFirstRectTile = firstTile;
+    mLastRectTile = lastRow * mGridCols + lastCol;
+    mRectLeftCol = firstCol;
+    mRectRightCol = lastCol;
     return OK;
 }
 
+status_t MediaImageDecoder::readNextTile(MediaBufferBase **mediaBuffer) {
+    std::lock_guard<std::mutex> lock(mSourceLock);
+    for (;;) {
+        status_t err = mSource->read(mediaBuffer, &mReadOptions);
+        mReadOptions.clearSeekTo();
+        if (err != OK) {
+            return err;
+        }
+        // Tiles past the rect are only decoded ahead when the rect spans the
+        // full width, as the next rect is then most likely the next slice.
+        int32_t tileIndex = mTilesRead++;
+        int32_t col = tileIndex % mGridCols;
+        bool fullWidth = (mRectLeftCol == 0 && mRectRightCol == mGridCols - 1);
+        if ((tileIndex > mLastRectTile && fullWidth)
+                || (tileIndex >= mFirstRectTile && tileIndex <= mLastRectTile
+                        && col >= mRectLeftCol && col <= mRectRightCol)) {
+            mQueuedTiles.push_back(tileIndex);
+            return OK;
+        }
+        ALOGV("skipping tile %d", tileIndex);
+        mLastSkippedTile = tileIndex;
+        (*mediaBuffer)->release();
+        *mediaBuffer = NULL;
+    }
+}
+
+bool MediaImageDecoder::hasTilesToRead() {
+    std::lock_guard<std::mutex> lock(mSourceLock);
+    return mTilesRead <= mLastRectTile
+            || (mRectLeftCol == 0 && mRectRightCol == mGridCols - 1);
+}
+
 status_t MediaImageDecoder::onOutputReceived(
         const sp<MediaCodecBuffer> &videoFrameBuffer,
         const sp<AMessage> &outputFormat, int64_t /*timeUs*/, bool *done) {
+    // The tiles are intra coded, so they come out in the order they were queued.
+    int32_t tileIndex;
+    {
+        std::lock_guard<std::mutex> lock(mSourceLock);
+        if (mQueuedTiles.empty()) {
+            ALOGE("output buffer without a queued tile");
+            return ERROR_MALFORMED;
+        }
+        tileIndex = mQueuedTiles.front();
+        mQueuedTiles.pop_front();
+    }
+    status_t err = convertTile(videoFrameBuffer, outputFormat, tileIndex);
+    if (err == OK) {
+        ++mTilesDecoded;
+        *done = (tileIndex >= mLastRectTile);
+    }
+    return err;
+}
+
+status_t MediaImageDecoder::convertTile(
+        const sp<MediaCodecBuffer> &videoFrameBuffer,
+        const sp<AMessage> &outputFormat, int32_t tileIndex) {
     if (outputFormat == NULL) {
         return ERROR_MALFORMED;
     }
@@ -1006,6 +1235,8 @@ status_t MediaImageDecoder::onOutputReceived(
         return ERROR_MALFORMED;
     }
 
+    // Tiles decoded in parallel share the frame, the first one allocates it.
+    std::unique_lock<std::mutex> frameLock(mFrameLock);
     if (mFrame == NULL) {
         sp<IMemory> frameMem = allocVideoFrame(
                 trackMeta(), mWidth, mHeight, mTileWidth, mTileHeight, dstBpp(), bitDepth);
@@ -1018,6 +1249,7 @@ status_t MediaImageDecoder::onOutputReceived(
 
         setFrame(frameMem);
     }
+    frameLock.unlock();
 
     ColorConverter converter((OMX_COLOR_FORMATTYPE)srcFormat, dstFormat());
 
@@ -1049,8 +1281,8 @@ status_t MediaImageDecoder::onOutputReceived(
     crop_height = crop_bottom - crop_top + 1;
 
     int32_t dstLeft, dstTop, dstRight, dstBottom;
-    dstLeft = mTilesDecoded % mGridCols * crop_width;
-    dstTop = mTilesDecoded / mGridCols * crop_height;
+    dstLeft = tileIndex % mGridCols * crop_width;
+    dstTop = tileIndex / mGridCols * crop_height;
     dstRight = dstLeft + crop_width - 1;
     dstBottom = dstTop + crop_height - 1;
 
@@ -1065,8 +1297,6 @@ status_t MediaImageDecoder::onOutputReceived(
         dstBottom = mHeight - 1;
     }
 
-    *done = (++mTilesDecoded >= mTargetTiles);
-
     if (converter.isValid()) {
         converter.convert(
                 (const uint8_t *)videoFrameBuffer->data(),
@@ -1180,11 +1410,191 @@ bool MediaImageDecoder::outputLoop() {
     return done;
 }
 
+status_t MediaImageDecoder::readTile(
+        const sp<MediaCodecBuffer> &codecBuffer, int32_t *tileIndex) {
+    std::lock_guard<std::mutex> lock(mSourceLock);
+    if (mTilesRead >= mTargetTiles) {
+        return ERROR_END_OF_STREAM;
+    }
+
+    MediaBufferBase *mediaBuffer = NULL;
+    status_t err = mSource->read(&mediaBuffer, &mReadOptions);
+    mReadOptions.clearSeekTo();
+    if (err != OK) {
+        ALOGW("Input Error: err=%d", err);
+        return err;
+    }
+
+    if (mediaBuffer->range_length() > codecBuffer->capacity()) {
+        ALOGE("buffer size (%zu) too large for codec input size (%zu)",
+                mediaBuffer->range_length(), codecBuffer->capacity());
+        err = BAD_VALUE;
+    } else {
+        codecBuffer->setRange(0, mediaBuffer->range_length());
+        memcpy(codecBuffer->data(),
+                (const uint8_t*)mediaBuffer->data() + mediaBuffer->range_offset(),
+                mediaBuffer->range_length());
+        *tileIndex = mTilesRead++;
+    }
+    mediaBuffer->release();
+    return err;
+}
+
+status_t MediaImageDecoder::decodeTiles(const sp<MediaCodec> &decoder) {
+    status_t err = OK;
+    sp<AMessage> outputFormat;
+    size_t retriesLeft = kRetryCount;
+    bool inputDone = false;
+    int32_t tilesPending = 0;
+
+    while (err == OK && (!inputDone || tilesPending > 0)) {
+        size_t index;
+        while (!inputDone) {
+            if (decoder->dequeueInputBuffer(&index, 0) != OK) {
+                break;
+            }
+            sp<MediaCodecBuffer> codecBuffer;
+            err = decoder->getInputBuffer(index, &codecBuffer);
+            if (err != OK) {
+                ALOGE("failed to get input buffer %zu", index);
+                break;
+            }
+
+            // The tile index is passed as the timestamp so that each output
+            // buffer can be converted straight into its place in the frame.
+            int32_t tileIndex;
+            err = readTile(codecBuffer, &tileIndex);
+            if (err == ERROR_END_OF_STREAM) {
+                inputDone = true;
+                err = decoder->queueInputBuffer(index, 0, 0, 0, MediaCodec::BUFFER_FLAG_EOS);
+                break;
+            } else if (err != OK) {
+                break;
+            }
+            err = decoder->queueInputBuffer(
+                    index, codecBuffer->offset(), codecBuffer->size(), tileIndex, 0);
+            if (err != OK) {
+                break;
+            }
+            ++tilesPending;
+        }
+        if (err != OK || (inputDone && tilesPending == 0)) {
+            break;
+        }
+
+        size_t offset, size;
+        int64_t ptsUs = 0LL;
+        uint32_t flags = 0;
+        err = decoder->dequeueOutputBuffer(
+                &index, &offset, &size, &ptsUs, &flags, kBufferTimeOutUs);
+        if (err == INFO_FORMAT_CHANGED) {
+            ALOGV("Received format change");
+            err = decoder->getOutputFormat(&outputFormat);
+        } else if (err == INFO_OUTPUT_BUFFERS_CHANGED) {
+            ALOGV("Output buffers changed");
+            err = OK;
+        } else if (err == -EAGAIN) {
+            if (--retriesLeft > 0) {
+                err = OK;
+            }
+        } else if (err == OK) {
+            retriesLeft = kRetryCount;
+            if (size > 0) {
+                if (ptsUs < 0 || ptsUs >= mTargetTiles) {
+                    ALOGE("output buffer for unknown tile %" PRId64, ptsUs);
+                    err = ERROR_MALFORMED;
+                } else {
+                    sp<MediaCodecBuffer> videoFrameBuffer;
+                    err = decoder->getOutputBuffer(index, &videoFrameBuffer);
+                    if (err == OK) {
+                        err = convertTile(videoFrameBuffer, outputFormat, (int32_t)ptsUs);
+                        --tilesPending;
+                    }
+                }
+            } else if (flags & MediaCodec::BUFFER_FLAG_EOS) {
+                ALOGE("decoder reached EOS with %d tiles pending", tilesPending);
+                err = ERROR_MALFORMED;
+            }
+            decoder->releaseOutputBuffer(index);
+        }
+    }
+    if (err != OK) {
+        ALOGW("tile decoding failed: %d (%s)", err, asString(err));
+    }
+    return err;
+}
+
+status_t MediaImageDecoder::extractTilesInParallel() {
+    // The first codec instance is the one set up by init(). Further instances
+    // are added until the limit is reached or one cannot be created, e.g.
+    // because the resource manager denied it; the tiles are then shared by
+    // the instances that could be started.
+    std::vector<sp<MediaCodec>> decoders = {mDecoder};
+    while ((int32_t)decoders.size() < mMaxTileDecoders) {
+        status_t err;
+        sp<ALooper> looper = new ALooper;
+        looper->start();
+        sp<MediaCodec> decoder = MediaCodec::CreateByComponentName(
+                looper, componentName(), &err);
+        if (decoder.get() == NULL || err != OK) {
+            ALOGW("Failed to instantiate tile decoder [%s]", componentName().c_str());
+            break;
+        }
+        err = decoder->configure(mTileFormat, NULL /* surface */, NULL /* crypto */, 0);
+        if (err == OK) {
+            err = decoder->start();
+        }
+        if (err != OK) {
+            ALOGW("tile decoder failed to start: %d (%s)", err, asString(err));
+            decoder->release();
+            break;
+        }
+        decoders.push_back(decoder);
+    }
+    ALOGD("decoding %d tiles on %zu decoders", mTargetTiles, decoders.size());
+
+    std::vector<status_t> results(decoders.size(), OK);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < decoders.size(); ++i) {
+        workers.emplace_back([this, &decoders, &results, i] {
+            results[i] = decodeTiles(decoders[i]);
+        });
+    }
+    results[0] = decodeTiles(decoders[0]);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    for (size_t i = 1; i < decoders.size(); ++i) {
+        decoders[i]->release();
+    }
+
+    mHaveMoreInputs = false;
+    mTilesDecoded = mTilesRead;
+    for (status_t result : results) {
+        if (result != OK) {
+            ALOGE("failed to get video frame (err %d)", result);
+            return result;
+        }
+    }
+    if (mTilesDecoded < mTargetTiles) {
+        ALOGE("only %d of %d tiles decoded", mTilesDecoded, mTargetTiles);
+        return ERROR_MALFORMED;
+    }
+    return OK;
+}
+
 status_t MediaImageDecoder::extractInternal() {
     status_t err = OK;
     bool done = false;
     bool outThreadRunning = false;
 
+    // Only whole images are decoded in parallel, rects are decoded on the
+    // single instance set up by init().
+    if (mMaxTileDecoders > 1 && mTilesRead == 0
+            && mFirstRectTile == 0 && mLastRectTile == mTargetTiles - 1) {
+        return extractTilesInParallel();
+    }
+
     {
         Mutexed<OutputInfo>::Locked outInfo(mOutInfo);
         outInfo->mRetriesLeft = kRetryCount;
@@ -1211,7 +1621,7 @@ status_t MediaImageDecoder::extractInternal() {
         // Queue as many inputs as we possibly can, then block on dequeuing
         // outputs. After getting each output, come back and queue the inputs
         // again to keep the decoder busy.
-        while (mHaveMoreInputs) {
+        while (mHaveMoreInputs && hasTilesToRead()) {
             err = mDecoder->dequeueInputBuffer(&index, 0);
             if (err != OK) {
                 ALOGV("Timed out waiting for input");
@@ -1229,8 +1639,7 @@ status_t MediaImageDecoder::extractInternal() {
 
             MediaBufferBase *mediaBuffer = NULL;
 
-            err = mSource->read(&mediaBuffer, &mReadOptions);
-            mReadOptions.clearSeekTo();
+            err = readNextTile(&mediaBuffer);
             if (err != OK) {
                 mHaveMoreInputs = false;
                 if (!mFirstSample && err == ERROR_END_OF_STREAM) {
@@ -30,7 +30,11 @@
 
 #include <utils/Log.h>
 
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <thread>
+#include <vector>
 #include <fcntl.h>
 
 #include <media/stagefright/MediaSource.h>
@@ -75,6 +79,14 @@ static const uint8_t kNalUnitTypePicParamSet = 0x08;
 static const int64_t kInitialDelayTimeUs     = 700000LL;
 static const int64_t kMaxMetadataSize = 0x4000000LL;   // 64MB max per-frame metadata size
 static const int64_t kMaxCttsOffsetTimeUs = 30 * 60 * 1000000LL;  // 30 minutes
+// A movie fragment is closed without waiting for a sync sample once it is this many
+// times longer than the requested fragment duration.
+static const int64_t kMaxFragmentDurationFactor = 4;
+// Space preallocated ahead of the tracks, as the duration of data at the recent rate.
+static const int64_t kPreAllocateAheadUs = 1000000LL;
+static const uint64_t kMinPreAllocateAheadBytes = 256 * 1024;
+static const uint64_t kMaxPreAllocateAheadBytes = 32 * 1024 * 1024;
+static const int64_t kPreAllocateRateWindowUs = 500000LL;
 static const size_t kESDSScratchBufferSize = 10;  // kMaxAtomSize in Mpeg4Extractor 64MB
 
 static const char kMetaKey_Version[]    = "com.android.version";
@@ -160,7 +172,10 @@ public:
     bool isHevc() const { return mIsHevc; }
     bool isHeic() const { return mIsHeic; }
     bool isAudio() const { return mIsAudio; }
+    bool isVideo() const { return mIsVideo; }
     bool isMPEG4() const { return mIsMPEG4; }
+    int32_t getTimeScale() const { return mTimeScale; }
+    int64_t getStartTimeUs() const { return mStartTimestampUs; }
     bool usePrefix() const { return (mIsAvc || mIsHevc || mIsHeic || mIsDovi)
       && !mNalLengthBitstream; }
     bool isExifData(MediaBufferBase *buffer, uint32_t *tiffHdrOffset) const;
@@ -185,7 +200,8 @@ private:
             : mElementCapacity(elementCapacity),
             mTotalNumTableEntries(0),
             mNumValuesInCurrEntry(0),
-            mCurrTableEntriesElement(NULL) {
+            mCurrTableEntriesElement(NULL),
+            mCountOnly(false) {
             CHECK_GT(mElementCapacity, 0u);
             // Ensure no integer overflow on allocation in add().
             CHECK_LT(ENTRY_SIZE, UINT32_MAX / mElementCapacity);
@@ -256,10 +272,24 @@ private:
             }
         }
 
+        // Only count the values added from now on, for the sample tables of a
+        // fragmented recording which are written out in the movie fragments.
+        void setCountOnly() {
+            CHECK_EQ(mTotalNumTableEntries, 0u);
+            mCountOnly = true;
+        }
+
         // Store a single value.
         // @arg value must be in network byte order.
         void add(const TYPE& value) {
             CHECK_LT(mNumValuesInCurrEntry, mElementCapacity);
+            if (mCountOnly) {
+                if ((++mNumValuesInCurrEntry % ENTRY_SIZE) == 0) {
+                    ++mTotalNumTableEntries;
+                    mNumValuesInCurrEntry = 0;
+                }
+                return;
+            }
             uint32_t nEntries = mTotalNumTableEntries % mElementCapacity;
             uint32_t nValues  = mNumValuesInCurrEntry % ENTRY_SIZE;
             if (nEntries == 0 && nValues == 0) {
@@ -308,10 +338,141 @@ private:
         uint32_t         mNumValuesInCurrEntry;  // up to ENTRY_SIZE
         TYPE             *mCurrTableEntriesElement;
         mutable List<TYPE *>     mTableEntryList;
+        bool             mCountOnly;
 
         DISALLOW_EVIL_CONSTRUCTORS(ListTableEntries);
     };
 
+    // A helper class to hold a single column table, such as the sample sizes or
+    // the chunk offsets, in a compact form until it is written out. Each value is
+    // stored as the zigzag encoded varint of its difference to the previous value,
+    // which takes one to three bytes for typical tables instead of four or eight.
+    template<class TYPE>
+    struct CompactTableEntries {
+        static_assert(sizeof(TYPE) == 4 || sizeof(TYPE) == 8, "TYPE must be 32 or 64 bit");
+        CompactTableEntries()
+            : mNumValues(0),
+            mFirstValue(0),
+            mLastValue(0),
+            mAllValuesEqual(true),
+            mCurrBlock(NULL),
+            mCurrBlockSize(kBlockSize),
+            mCountOnly(false) {
+        }
+
+        // Free the allocated memory.
+        ~CompactTableEntries() {
+            for (uint8_t *block : mBlockList) {
+                delete[] block;
+            }
+        }
+
+        // Only count the values added from now on, for the sample tables of a
+        // fragmented recording which are written out in the movie fragments.
+        void setCountOnly() {
+            CHECK_EQ(mNumValues, 0u);
+            mCountOnly = true;
+        }
+
+        // Store a single value.
+        // @arg value in host byte order.
+        void add(TYPE value) {
+            CHECK_LT(mNumValues, UINT32_MAX);
+            if (!mCountOnly) {
+                if (mNumValues == 0) {
+                    mFirstValue = value;
+                } else if (value != mFirstValue) {
+                    mAllValuesEqual = false;
+                }
+                int64_t delta = (int64_t)((uint64_t)value - (uint64_t)mLastValue);
+                uint64_t zigzag = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+                while (zigzag >= 0x80) {
+                    addByte((uint8_t)(zigzag | 0x80));
+                    zigzag >>= 7;
+                }
+                addByte((uint8_t)zigzag);
+                mLastValue = value;
+            }
+            ++mNumValues;
+        }
+
+        // Write out the table entries:
+        // 1. the number of entries goes first
+        // 2. followed by the values in network byte order
+        // @arg writer the writer to actual write to the storage
+        void write(MPEG4Writer *writer) const {
+            CHECK(!mCountOnly);
+            writer->writeInt32(mNumValues);
+            TYPE values[kWriteBatchSize];
+            size_t numValues = 0;
+            uint32_t numDecoded = 0;
+            uint64_t zigzag = 0;
+            uint32_t shift = 0;
+            TYPE value = 0;
+            for (uint8_t *block : mBlockList) {
+                size_t blockSize = (block == mCurrBlock) ? mCurrBlockSize : kBlockSize;
+                for (size_t i = 0; i < blockSize; ++i) {
+                    zigzag |= (uint64_t)(block[i] & 0x7f) << shift;
+                    if (block[i] & 0x80) {
+                        shift += 7;
+                        continue;
+                    }
+                    int64_t delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+                    value = (TYPE)((uint64_t)value + (uint64_t)delta);
+                    values[numValues++] = toNetworkOrder(value);
+                    if (numValues == kWriteBatchSize) {
+                        writer->write(values, sizeof(TYPE), numValues);
+                        numValues = 0;
+                    }
+                    ++numDecoded;
+                    zigzag = 0;
+                    shift = 0;
+                }
+            }
+            if (numValues > 0) {
+                writer->write(values, sizeof(TYPE), numValues);
+            }
+            CHECK_EQ(numDecoded, mNumValues);
+        }
+
+        // Return the number of entries in the table.
+        uint32_t count() const { return mNumValues; }
+
+        // Return true if the table has entries and they all have the same value.
+        bool allValuesEqual() const { return mNumValues > 0 && mAllValuesEqual; }
+
+        // Return the first value in host byte order.
+        TYPE firstValue() const { return mFirstValue; }
+
+    private:
+        static constexpr size_t kBlockSize = 4096;  // bytes in a block of encoded values
+        static constexpr size_t kWriteBatchSize = 1024;  // values decoded per write
+
+        static TYPE toNetworkOrder(TYPE value) {
+            return sizeof(TYPE) == 8 ? (TYPE)hton64(value) : (TYPE)htonl(value);
+        }
+
+        void addByte(uint8_t byte) {
+            if (mCurrBlockSize == kBlockSize) {
+                mCurrBlock = new uint8_t[kBlockSize];
+                mBlockList.push_back(mCurrBlock);
+                mCurrBlockSize = 0;
+            }
+            mCurrBlock[mCurrBlockSize++] = byte;
+        }
+
+        uint32_t         mNumValues;
+        TYPE             mFirstValue;
+        TYPE             mLastValue;
+        bool             mAllValuesEqual;
+        uint8_t          *mCurrBlock;
+        size_t           mCurrBlockSize;  // bytes used in mCurrBlock
+        List<uint8_t *>  mBlockList;
+        bool             mCountOnly;
+
+        DISALLOW_EVIL_CONSTRUCTORS(CompactTableEntries);
+    };
+
 
 
     MPEG4Writer *mOwner;
@@ -345,8 +506,8 @@ private:
     List<MediaBuffer *> mChunkSamples;
 
     bool mSamplesHaveSameSize;
-    ListTableEntries<uint32_t, 1> *mStszTableEntries;
-    ListTableEntries<off64_t, 1> *mCo64TableEntries;
+    CompactTableEntries<uint32_t> *mStszTableEntries;
+    CompactTableEntries<off64_t> *mCo64TableEntries;
     ListTableEntries<uint32_t, 3> *mStscTableEntries;
     ListTableEntries<uint32_t, 1> *mStssTableEntries;
     ListTableEntries<uint32_t, 2> *mSttsTableEntries;
@@ -533,9 +694,15 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
     mPaused = false;
     mStarted = false;
     mWriterThreadStarted = false;
+    mPendingChunks.store(NULL, std::memory_order_relaxed);
     mSendNotify = false;
     mWriteSeekErr = false;
     mFallocateErr = false;
+    mAsyncWriteActive = false;
+    mFragmentDurationUs = 0;
+    mFragmentSequence = 0;
+    mFragmentedMoovWritten = false;
+    mMehdOffset = 0;
     // Reset following variables for all the sessions and they will be
     // initialized in start(MetaData *param).
     mIsRealTimeRecording = true;
@@ -563,11 +730,20 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
     mResetStatus = OK;
     mPreAllocFirstTime = true;
     mPrevAllTracksTotalMetaDataSizeEstimate = 0;
+    mPreAllocateRequiredEndOffset = 0;
+    mPreAllocateAheadPending = false;
+    mPreAllocateBytesPerSec = 0;
+    mPreAllocateRateStartUs = -1;
+    mPreAllocateRateBytes = 0;
+    mPreAllocateHits = 0;
+    mPreAllocateMisses = 0;
+    mPreAllocateAheadCount = 0;
 
     // Following variables only need to be set for the first recording session.
     // And they will stay the same for all the recording sessions.
     if (isFirstSession) {
         mMoovExtraSize = 0;
+        mPreAllocateGeneration = 0;
         mHasMoovBox = false;
         mMetaKeys = new AMessage();
         addDeviceMeta();
@@ -608,6 +784,15 @@ status_t MPEG4Writer::dump(
     result.append(buffer);
     snprintf(buffer, SIZE, "     mStarted: %s\n", mStarted? "true": "false");
     result.append(buffer);
+    if (mPreAllocationEnabled) {
+        std::lock_guard<std::mutex> l(mFallocMutex);
+        snprintf(buffer, SIZE, "     preallocation hits: %u, misses: %u, ahead: %u\n",
+                mPreAllocateHits, mPreAllocateMisses, mPreAllocateAheadCount);
+        result.append(buffer);
+    }
+    if (mAsyncWriter != nullptr) {
+        mAsyncWriter->dump(&result);
+    }
     ::write(fd, result.string(), result.size());
     for (List<Track *>::iterator it = mTracks.begin();
          it != mTracks.end(); ++it) {
@@ -947,6 +1132,17 @@ status_t MPEG4Writer::start(MetaData *param) {
         return OK;
     }
 
+    int64_t fragmentDurationUs;
+    if (param && param->findInt64(kKeyFragmentDuration, &fragmentDurationUs)
+            && fragmentDurationUs > 0) {
+        if (mHasMoovBox && !mHasFileLevelMeta) {
+            mFragmentDurationUs = fragmentDurationUs;
+            ALOGI("Fragmented recording, fragment duration %" PRId64 " us", mFragmentDurationUs);
+        } else {
+            ALOGW("Fragmented recording is not supported for image tracks");
+        }
+    }
+
     if (!param ||
         !param->findInt32(kKeyTimeScale, &mTimeScale)) {
         // Increased by a factor of 10 to improve precision of segment duration in edit list entry.
@@ -963,7 +1159,8 @@ status_t MPEG4Writer::start(MetaData *param) {
      */
     mStreamableFile =
         (mMaxFileSizeLimitBytes != 0 &&
-         mMaxFileSizeLimitBytes >= kMinStreamableFileSizeInBytes);
+         mMaxFileSizeLimitBytes >= kMinStreamableFileSizeInBytes &&
+         !isFragmented());
 
     /*
      * mWriteBoxToMemory is true if the amount of data in a file-level meta or
@@ -1070,7 +1267,10 @@ status_t MPEG4Writer::start(MetaData *param) {
 
     mOffset = mMdatOffset;
     seekOrPostError(mFd, mMdatOffset, SEEK_SET);
-    write("\x00\x00\x00\x01mdat????????", 16);
+    if (!isFragmented()) {
+        // Fragmented files have one 'mdat' box per movie fragment instead.
+        write("\x00\x00\x00\x01mdat????????", 16);
+    }
 
     /* Confirm whether the writing of the initial file atoms, ftyp and free,
      * are written to the file properly by posting kWhatNoIOErrorSoFar to the
@@ -1366,6 +1566,19 @@ status_t MPEG4Writer::reset(bool stopSource, bool waitForAnyPreviousCallToComple
         return mResetStatus;
     }
 
+    if (isFragmented()) {
+        // The samples are already described by the movie fragments written by
+        // the writer thread, only the overall duration is left to fill in.
+        writeFragmentedDuration(maxDurationUs);
+        mMdatEndOffset = mOffset;
+        status_t errRelease = release();
+        if (err == OK) {
+            err = errRelease;
+        }
+        mResetStatus = err;
+        return mResetStatus;
+    }
+
     // Fix up the size of the 'mdat' chunk.
     seekOrPostError(mFd, mMdatOffset + 8, SEEK_SET);
     uint64_t size = mOffset - mMdatOffset;
@@ -1562,6 +1775,9 @@ void MPEG4Writer::writeFtypBox(MetaData *param) {
         if (mHasMoovBox) {
             writeFourcc("isom");
             writeFourcc("mp42");
+            if (isFragmented()) {
+                writeFourcc("iso6");
+            }
         }
     }
 
@@ -1582,6 +1798,14 @@ static bool isTestModeEnabled() {
 }
 
 void MPEG4Writer::sendSessionSummary() {
+    if (mPreAllocationEnabled) {
+        std::lock_guard<std::mutex> l(mFallocMutex);
+        ALOGI("preallocation hits:%u misses:%u ahead:%u allocated:%" PRId64
+              " bytes rate:%" PRId64 " bytes/s", mPreAllocateHits, mPreAllocateMisses,
+              mPreAllocateAheadCount, (int64_t)mPreAllocateFileEndOffset,
+              mPreAllocateBytesPerSec);
+    }
+
     // Send session summary only if test mode is enabled
     if (!isTestModeEnabled()) {
         return;
@@ -1756,10 +1980,291 @@ size_t MPEG4Writer::write(
     return bytes;
 }
 
+/*
+ * Stages the sample data written by the writer thread in large, page aligned
+ * blocks that a dedicated I/O thread writes out with pwrite64(). The writer
+ * thread only blocks once kMaxInFlightBlocks blocks are waiting for the file,
+ * which absorbs write latency spikes of slow storage without letting the
+ * memory used for pending data grow without bound.
+ */
+struct MPEG4Writer::AsyncWriter {
+    AsyncWriter();
+    ~AsyncWriter();
+
+    // Stage writes to fd starting at the given file offset.
+    void start(int fd, off64_t offset);
+
+    // Copy the data into the current block, submitting it when full.
+    // Returns false if an earlier write to the file failed.
+    bool write(const void *data, size_t size);
+
+    // Submit the current block and wait for all blocks to be written.
+    // Returns false if any write to the file failed.
+    bool drain();
+
+    // File offset following the last staged byte.
+    off64_t offset() const { return mOffset; }
+
+    void dump(String8 *result);
+
+private:
+    static const size_t kBlockSize = 1024 * 1024;
+    static const size_t kBlockAlignment = 4096;
+    static const size_t kMaxInFlightBlocks = 8;
+
+    struct Block {
+        uint8_t *mData;
+        size_t mSize;
+        off64_t mOffset;
+    };
+
+    std::mutex mLock;
+    std::condition_variable mQueueCondition;  // signals the I/O thread
+    std::condition_variable mDoneCondition;   // signals the writer thread
+    std::deque<Block> mQueue;
+    std::vector<uint8_t *> mFreeBlocks;
+    size_t mNumBlocks;
+    bool mWriting;
+    bool mError;
+    bool mExit;
+    int mFd;
+
+    // Only accessed by the writer thread.
+    Block mCurrent;
+    off64_t mOffset;
+
+    // Statistics, guarded by mLock.
+    uint64_t mBytesWritten;
+    uint64_t mNumWrites;
+    uint64_t mNumStalls;
+    int64_t mStallTimeUs;
+    int64_t mMaxWriteTimeUs;
+    size_t mMaxInFlightBytes;
+
+    std::thread mThread;
+
+    bool submit_l(std::unique_lock<std::mutex> &lock);
+    void threadLoop();
+
+    DISALLOW_EVIL_CONSTRUCTORS(AsyncWriter);
+};
+
+MPEG4Writer::AsyncWriter::AsyncWriter()
+    : mNumBlocks(0),
+      mWriting(false),
+      mError(false),
+      mExit(false),
+      mFd(-1),
+      mCurrent{nullptr, 0, 0},
+      mOffset(0),
+      mBytesWritten(0),
+      mNumWrites(0),
+      mNumStalls(0),
+      mStallTimeUs(0),
+      mMaxWriteTimeUs(0),
+      mMaxInFlightBytes(0) {
+    mThread = std::thread(&AsyncWriter::threadLoop, this);
+}
+
+MPEG4Writer::AsyncWriter::~AsyncWriter() {
+    {
+        std::lock_guard<std::mutex> l(mLock);
+        mExit = true;
+        mQueueCondition.notify_one();
+    }
+    mThread.join();
+    for (const Block &block : mQueue) {
+        free(block.mData);
+    }
+    for (uint8_t *data : mFreeBlocks) {
+        free(data);
+    }
+    free(mCurrent.mData);
+}
+
+void MPEG4Writer::AsyncWriter::start(int fd, off64_t offset) {
+    std::lock_guard<std::mutex> l(mLock);
+    CHECK(mQueue.empty() && !mWriting);
+    mFd = fd;
+    mOffset = offset;
+    mCurrent.mSize = 0;
+    mCurrent.mOffset = offset;
+}
+
+bool MPEG4Writer::AsyncWriter::write(const void *data, size_t size) {
+    const uint8_t *ptr = (const uint8_t *)data;
+    while (size > 0) {
+        if (mCurrent.mData == nullptr || mCurrent.mSize == kBlockSize) {
+            std::unique_lock<std::mutex> lock(mLock);
+            if (!submit_l(lock)) {
+                return false;
+            }
+        }
+        const size_t copy = std::min(size, kBlockSize - mCurrent.mSize);
+        memcpy(mCurrent.mData + mCurrent.mSize, ptr, copy);
+        mCurrent.mSize += copy;
+        mOffset += copy;
+        ptr += copy;
+        size -= copy;
+    }
+    return true;
+}
+
+bool MPEG4Writer::AsyncWriter::submit_l(std::unique_lock<std::mutex> &lock) {
+    if (mCurrent.mData != nullptr && mCurrent.mSize > 0) {
+        mQueue.push_back(mCurrent);
+        mQueueCondition.notify_one();
+        size_t inFlightBytes = (mQueue.size() - 1) * kBlockSize + mCurrent.mSize;
+        if (mWriting) {
+            inFlightBytes += kBlockSize;
+        }
+        mMaxInFlightBytes = std::max(mMaxInFlightBytes, inFlightBytes);
+        mCurrent.mData = nullptr;
+    }
+    if (mCurrent.mData == nullptr) {
+        if (mFreeBlocks.empty() && mNumBlocks < kMaxInFlightBlocks) {
+            void *data = nullptr;
+            if (posix_memalign(&data, kBlockAlignment, kBlockSize) != 0) {
+                ALOGE("cannot allocate %zu bytes for asynchronous writes", kBlockSize);
+                mError = true;
+                return false;
+            }
+            mFreeBlocks.push_back((uint8_t *)data);
+            ++mNumBlocks;
+        }
+        if (mFreeBlocks.empty()) {
+            // Back-pressure: every block is waiting for the file.
+            const int64_t stallStartUs = systemTime(SYSTEM_TIME_MONOTONIC) / 1000;
+            mDoneCondition.wait(lock, [this] { return !mFreeBlocks.empty() || mError; });
+            ++mNumStalls;
+            mStallTimeUs += systemTime(SYSTEM_TIME_MONOTONIC) / 1000 - stallStartUs;
+        }
+        if (mError) {
+            return false;
+        }
+        mCurrent.mData = mFreeBlocks.back();
+        mFreeBlocks.pop_back();
+    }
+    mCurrent.mSize = 0;
+    mCurrent.mOffset = mOffset;
+    return !mError;
+}
+
+bool MPEG4Writer::AsyncWriter::drain() {
+    std::unique_lock<std::mutex> lock(mLock);
+    if (mCurrent.mData != nullptr && mCurrent.mSize > 0) {
+        mQueue.push_back(mCurrent);
+        mQueueCondition.notify_one();
+        mCurrent.mData = nullptr;
+    }
+    mDoneCondition.wait(lock, [this] { return mQueue.empty() && !mWriting; });
+    return !mError;
+}
+
+void MPEG4Writer::AsyncWriter::threadLoop() {
+    prctl(PR_SET_NAME, (unsigned long)"MPEG4WriterIO", 0, 0, 0);
+
+    std::unique_lock<std::mutex> lock(mLock);
+    for (;;) {
+        mQueueCondition.wait(lock, [this] { return !mQueue.empty() || mExit; });
+        if (mQueue.empty()) {
+            break;
+        }
+        Block block = mQueue.front();
+        mQueue.pop_front();
+        mWriting = true;
+        const bool skip = mError;
+        const int fd = mFd;
+        lock.unlock();
+
+        bool ok = true;
+        const int64_t writeStartUs = systemTime(SYSTEM_TIME_MONOTONIC) / 1000;
+        for (size_t written = 0; !skip && written < block.mSize; ) {
+            ssize_t n = pwrite64(fd, block.mData + written, block.mSize - written,
+                    block.mOffset + written);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                ALOGE("asynchronous write of %zu bytes at %lld failed: %s(%d)",
+                        block.mSize - written, (long long)(block.mOffset + written),
+                        std::strerror(errno), errno);
+                ok = false;
+                break;
+            }
+            written += n;
+        }
+        const int64_t writeTimeUs = systemTime(SYSTEM_TIME_MONOTONIC) / 1000 - writeStartUs;
+
+        lock.lock();
+        mWriting = false;
+        if (!skip) {
+            if (ok) {
+                mBytesWritten += block.mSize;
+                ++mNumWrites;
+                mMaxWriteTimeUs = std::max(mMaxWriteTimeUs, writeTimeUs);
+            } else {
+                mError = true;
+            }
+        }
+        mFreeBlocks.push_back(block.mData);
+        mDoneCondition.notify_all();
+    }
+}
+
+void MPEG4Writer::AsyncWriter::dump(String8 *result) {
+    std::lock_guard<std::mutex> l(mLock);
+    result->appendFormat("     async writes: %" PRIu64 " bytes in %" PRIu64 " writes, "
+            "max write %" PRId64 " us%s\n",
+            mBytesWritten, mNumWrites, mMaxWriteTimeUs, mError ? ", failed" : "");
+    result->appendFormat("     async back-pressure: %" PRIu64 " stalls, %" PRId64 " us stalled, "
+            "max in flight %zu of %zu bytes\n",
+            mNumStalls, mStallTimeUs, mMaxInFlightBytes, kMaxInFlightBlocks * kBlockSize);
+}
+
+void MPEG4Writer::startAsyncWrites() {
+    if (mAsyncWriter != nullptr && !mAsyncWriteActive && !mWriteSeekErr) {
+        off64_t offset = lseek64(mFd, 0, SEEK_CUR);
+        if (offset >= 0) {
+            mAsyncWriter->start(mFd, offset);
+            mAsyncWriteActive = true;
+        }
+    }
+}
+
+void MPEG4Writer::finishAsyncWrites() {
+    if (!mAsyncWriteActive) {
+        return;
+    }
+    mAsyncWriteActive = false;
+    const bool ok = mAsyncWriter->drain();
+    if (!ok && !mWriteSeekErr) {
+        mWriteSeekErr = true;
+        sp<AMessage> msg = new AMessage(kWhatIOError, mReflector);
+        msg->setInt32("err", ERROR_IO);
+        WARN_UNLESS(msg->post() == OK, "finishAsyncWrites:error posting ERROR_IO");
+    }
+    // The staged data was written with pwrite64(), so the file offset is still where the
+    // first staged byte went.
+    seekOrPostError(mFd, mAsyncWriter->offset(), SEEK_SET);
+}
+
 void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
     if (mWriteSeekErr == true)
         return;
 
+    if (mAsyncWriteActive) {
+        if (mAsyncWriter->write(buf, count)) {
+            return;
+        }
+        mWriteSeekErr = true;
+        ALOGE("writeOrPostError asynchronous write of %zu bytes failed", count);
+        sp<AMessage> msg = new AMessage(kWhatIOError, mReflector);
+        msg->setInt32("err", ERROR_IO);
+        WARN_UNLESS(msg->post() == OK, "writeOrPostError:error posting ERROR_IO");
+        return;
+    }
+
     auto beforeTP = std::chrono::high_resolution_clock::now();
     ssize_t bytesWritten = ::write(fd, buf, count);
     auto afterTP = std::chrono::high_resolution_clock::now();
@@ -1787,6 +2292,7 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
 }
 
 void MPEG4Writer::seekOrPostError(int fd, off64_t offset, int whence) {
+    finishAsyncWrites();
     if (mWriteSeekErr == true)
         return;
     off64_t resOffset = lseek64(fd, offset, whence);
@@ -2032,12 +2538,57 @@ bool MPEG4Writer::preAllocate(uint64_t wantSize) {
     mPrevAllTracksTotalMetaDataSizeEstimate = allTracksTotalMetaDataSizeEstimate;
     ALOGV("mPreAllocateFileEndOffset:%" PRIu64 " mOffset:%" PRIu64, mPreAllocateFileEndOffset,
           mOffset);
-    off64_t lastFileEndOffset = std::max(mPreAllocateFileEndOffset, mOffset);
     uint64_t preAllocateSize = wantSize + approxMOOVBoxSize + approxMetaDataSizeIncrease;
-    ALOGV("preAllocateSize :%" PRIu64 " lastFileEndOffset:%" PRIu64, preAllocateSize,
-          lastFileEndOffset);
+    mPreAllocateRequiredEndOffset =
+            std::max(mPreAllocateRequiredEndOffset, mOffset) + preAllocateSize;
+    ALOGV("preAllocateSize :%" PRIu64 " mPreAllocateRequiredEndOffset:%" PRIu64, preAllocateSize,
+          mPreAllocateRequiredEndOffset);
+
+    // Track the rate at which the tracks ask for space to size the look ahead.
+    const int64_t nowUs = systemTime(SYSTEM_TIME_MONOTONIC) / 1000;
+    if (mPreAllocateRateStartUs < 0) {
+        mPreAllocateRateStartUs = nowUs;
+    }
+    mPreAllocateRateBytes += preAllocateSize;
+    if (nowUs - mPreAllocateRateStartUs >= kPreAllocateRateWindowUs) {
+        int64_t bytesPerSec =
+                mPreAllocateRateBytes * 1000000LL / (nowUs - mPreAllocateRateStartUs);
+        mPreAllocateBytesPerSec = (mPreAllocateBytesPerSec == 0)
+                ? bytesPerSec : (3 * mPreAllocateBytesPerSec + bytesPerSec) / 4;
+        mPreAllocateRateStartUs = nowUs;
+        mPreAllocateRateBytes = 0;
+    }
+
+    const uint64_t aheadSize = preAllocateAheadSize_l();
+    if (mPreAllocateRequiredEndOffset <= mPreAllocateFileEndOffset) {
+        ++mPreAllocateHits;
+        // Extend the allocation on the looper thread before the tracks run out of it.
+        if (!mPreAllocateAheadPending
+                && (uint64_t)(mPreAllocateFileEndOffset - mPreAllocateRequiredEndOffset)
+                        < aheadSize / 2) {
+            sp<AMessage> msg = new AMessage(kWhatPreAllocateAhead, mReflector);
+            msg->setInt32("generation", mPreAllocateGeneration);
+            mPreAllocateAheadPending = (msg->post() == OK);
+        }
+        return true;
+    }
 
-    int res = fallocate64(mFd, FALLOC_FL_KEEP_SIZE, lastFileEndOffset, preAllocateSize);
+    // Allocate what is missing together with the look ahead, or only what is missing
+    // if there is no room for the look ahead.
+    ++mPreAllocateMisses;
+    off64_t lastFileEndOffset = mPreAllocateFileEndOffset;
+    int res = fallocate64(mFd, FALLOC_FL_KEEP_SIZE, lastFileEndOffset,
+            mPreAllocateRequiredEndOffset + aheadSize - lastFileEndOffset);
+    if (res == 0) {
+        mPreAllocateFileEndOffset = mPreAllocateRequiredEndOffset + aheadSize;
+    } else {
+        ALOGW("fallocate with look ahead err:%s, %d, fd:%d", strerror(errno), errno, mFd);
+        res = fallocate64(mFd, FALLOC_FL_KEEP_SIZE, lastFileEndOffset,
+                mPreAllocateRequiredEndOffset - lastFileEndOffset);
+        if (res == 0) {
+            mPreAllocateFileEndOffset = mPreAllocateRequiredEndOffset;
+        }
+    }
     if (res == -1) {
         ALOGE("fallocate err:%s, %d, fd:%d", strerror(errno), errno, mFd);
         sp<AMessage> msg = new AMessage(kWhatFallocateError, mReflector);
@@ -2046,13 +2597,45 @@ bool MPEG4Writer::preAllocate(uint64_t wantSize) {
         mFallocateErr = true;
         ALOGD("preAllocation post:%d", err);
     } else {
-        mPreAllocateFileEndOffset = lastFileEndOffset + preAllocateSize;
         ALOGV("mPreAllocateFileEndOffset:%" PRIu64, mPreAllocateFileEndOffset);
     }
     return (res == -1) ? false : true;
 }
 
+uint64_t MPEG4Writer::preAllocateAheadSize_l() const {
+    uint64_t aheadSize = mPreAllocateBytesPerSec * kPreAllocateAheadUs / 1000000LL;
+    return std::min(std::max(aheadSize, kMinPreAllocateAheadBytes), kMaxPreAllocateAheadBytes);
+}
+
+void MPEG4Writer::preAllocateAhead(int32_t generation) {
+    std::lock_guard<std::mutex> l(mFallocMutex);
+    if (generation != mPreAllocateGeneration) {
+        ALOGV("Ignoring preallocation ahead of a previous session");
+        return;
+    }
+    mPreAllocateAheadPending = false;
+    if (mFallocateErr) {
+        return;
+    }
+    off64_t endOffset = mPreAllocateRequiredEndOffset + preAllocateAheadSize_l();
+    if (endOffset <= mPreAllocateFileEndOffset) {
+        return;
+    }
+    if (fallocate64(mFd, FALLOC_FL_KEEP_SIZE, mPreAllocateFileEndOffset,
+            endOffset - mPreAllocateFileEndOffset) == -1) {
+        // Not fatal, preAllocate() allocates what is needed once it runs out.
+        ALOGW("fallocate ahead err:%s, %d, fd:%d", strerror(errno), errno, mFd);
+        return;
+    }
+    ++mPreAllocateAheadCount;
+    mPreAllocateFileEndOffset = endOffset;
+    ALOGV("mPreAllocateFileEndOffset:%" PRIu64 " ahead", mPreAllocateFileEndOffset);
+}
+
 bool MPEG4Writer::truncatePreAllocation() {
+    std::lock_guard<std::mutex> l(mFallocMutex);
+    // The file is about to be closed, drop any pending look ahead for it.
+    ++mPreAllocateGeneration;
     if (!mPreAllocationEnabled)
         return true;
 
@@ -2202,8 +2785,8 @@ MPEG4Writer::Track::Track(
       mNalLengthBitstream(0),
       mEstimatedTrackSizeBytes(0),
       mSamplesHaveSameSize(true),
-      mStszTableEntries(new ListTableEntries<uint32_t, 1>(1000)),
-      mCo64TableEntries(new ListTableEntries<off64_t, 1>(1000)),
+      mStszTableEntries(new CompactTableEntries<uint32_t>()),
+      mCo64TableEntries(new CompactTableEntries<off64_t>()),
       mStscTableEntries(new ListTableEntries<uint32_t, 3>(1000)),
       mStssTableEntries(new ListTableEntries<uint32_t, 1>(1000)),
       mSttsTableEntries(new ListTableEntries<uint32_t, 2>(1000)),
@@ -2294,11 +2877,11 @@ void MPEG4Writer::Track::resetInternal() {
     mSamplesHaveSameSize = false;
     if (mStszTableEntries != NULL) {
         delete mStszTableEntries;
-        mStszTableEntries = new ListTableEntries<uint32_t, 1>(1000);
+        mStszTableEntries = new CompactTableEntries<uint32_t>();
     }
     if (mCo64TableEntries != NULL) {
         delete mCo64TableEntries;
-        mCo64TableEntries = new ListTableEntries<off64_t, 1>(1000);
+        mCo64TableEntries = new CompactTableEntries<off64_t>();
     }
     if (mStscTableEntries != NULL) {
         delete mStscTableEntries;
@@ -2452,7 +3035,7 @@ bool MPEG4Writer::Track::isExifData(
 
 void MPEG4Writer::Track::addChunkOffset(off64_t offset) {
     CHECK(!mIsHeic);
-    mCo64TableEntries->add(hton64(offset));
+    mCo64TableEntries->add(offset);
 }
 
 void MPEG4Writer::Track::addItemOffsetAndSize(off64_t offset, size_t size, bool isExif) {
@@ -2634,6 +3217,13 @@ void MPEG4Writer::onMessageReceived(const sp<AMessage> &msg) {
             }
             break;
         }
+        case kWhatPreAllocateAhead:
+        {
+            int32_t generation;
+            CHECK(msg->findInt32("generation", &generation));
+            preAllocateAhead(generation);
+            break;
+        }
         /* ::write() or lseek64() wasn't a success, file could be malformed.
          * Or fallocate() failed. reset() and notify client on both the cases.
          */
@@ -2750,28 +3340,84 @@ void *MPEG4Writer::ThreadWrapper(void *me) {
     return NULL;
 }
 
+struct MPEG4Writer::PendingChunk {
+    Chunk mChunk;
+    PendingChunk *mNext;
+
+    explicit PendingChunk(const Chunk& chunk) : mChunk(chunk), mNext(NULL) {}
+};
+
 void MPEG4Writer::bufferChunk(const Chunk& chunk) {
     ALOGV("bufferChunk: %p", chunk.mTrack);
-    Mutex::Autolock autolock(mLock);
-    CHECK_EQ(mDone, false);
+    PendingChunk *pending = new PendingChunk(chunk);
 
-    for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
-         it != mChunkInfos.end(); ++it) {
+    if (!mIsRealTimeRecording) {
+        // The writer thread holds the lock while it writes, which keeps the track
+        // threads from running ahead of it when not recording in real time.
+        Mutex::Autolock autolock(mLock);
+        CHECK_EQ(mDone, false);
+        pushPendingChunk(pending);
+        mChunkReadyCondition.signal();
+        return;
+    }
 
-        if (chunk.mTrack == it->mTrack) {  // Found owner
-            it->mChunks.push_back(chunk);
-            mChunkReadyCondition.signal();
-            return;
-        }
+    if (pushPendingChunk(pending)) {
+        // Taking the lock ensures that the writer thread either sees the chunk
+        // before it waits or is waiting already when it is signalled.
+        Mutex::Autolock autolock(mLock);
+        mChunkReadyCondition.signal();
     }
+}
 
-    CHECK(!"Received a chunk for a unknown track");
+bool MPEG4Writer::pushPendingChunk(PendingChunk *pending) {
+    PendingChunk *head = mPendingChunks.load(std::memory_order_relaxed);
+    do {
+        pending->mNext = head;
+    } while (!mPendingChunks.compare_exchange_weak(
+            head, pending, std::memory_order_release, std::memory_order_relaxed));
+    return head == NULL;
+}
+
+void MPEG4Writer::takePendingChunks() {
+    PendingChunk *pending = mPendingChunks.exchange(NULL, std::memory_order_acquire);
+
+    // Reverse the list to restore the order in which the chunks were pushed.
+    PendingChunk *oldest = NULL;
+    while (pending != NULL) {
+        PendingChunk *next = pending->mNext;
+        pending->mNext = oldest;
+        oldest = pending;
+        pending = next;
+    }
+
+    while (oldest != NULL) {
+        bool found = false;
+        for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+             it != mChunkInfos.end(); ++it) {
+            if (oldest->mChunk.mTrack == it->mTrack) {  // Found owner
+                it->mChunks.push_back(oldest->mChunk);
+                found = true;
+                break;
+            }
+        }
+        CHECK(found || !"Received a chunk for a unknown track");
+        PendingChunk *next = oldest->mNext;
+        delete oldest;
+        oldest = next;
+    }
 }
 
 void MPEG4Writer::writeChunkToFile(Chunk* chunk) {
     ALOGV("writeChunkToFile: %" PRId64 " from %s track",
         chunk->mTimeStampUs, chunk->mTrack->getTrackType());
 
+    startAsyncWrites();
+
+    if (isFragmented()) {
+        addFragmentSamples(chunk);
+        return;
+    }
+
     int32_t isFirstSample = true;
     while (!chunk->mSamples.empty()) {
         List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
@@ -2809,6 +3455,9 @@ void MPEG4Writer::writeAllChunks() {
         writeChunkToFile(&chunk);
         ++outstandingChunks;
     }
+    if (isFragmented()) {
+        writeFragment(true /* flushAll */);
+    }
 
     sendSessionSummary();
 
@@ -2819,6 +3468,8 @@ void MPEG4Writer::writeAllChunks() {
 bool MPEG4Writer::findChunkToWrite(Chunk *chunk) {
     ALOGV("findChunkToWrite");
 
+    takePendingChunks();
+
     int64_t minTimestampUs = 0x7FFFFFFFFFFFFFFFLL;
     Track *track = NULL;
     for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
@@ -2860,6 +3511,283 @@ bool MPEG4Writer::findChunkToWrite(Chunk *chunk) {
     return false;
 }
 
+void MPEG4Writer::addFragmentSamples(Chunk *chunk) {
+    ChunkInfo *info = NULL;
+    ChunkInfo *pacing = NULL;  // The track whose samples start new fragments.
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin(); it != mChunkInfos.end(); ++it) {
+        if (it->mTrack == chunk->mTrack) {
+            info = &*it;
+        }
+        if (mFragmentedMoovWritten && !it->mInMoov) {
+            continue;
+        }
+        if (pacing == NULL || (!pacing->mTrack->isVideo() && it->mTrack->isVideo())) {
+            pacing = &*it;
+        }
+    }
+    CHECK(info != NULL);
+
+    while (!chunk->mSamples.empty()) {
+        List<MediaBuffer *>::iterator it = chunk->mSamples.begin();
+        MediaBuffer *sample = *it;
+        chunk->mSamples.erase(it);
+        if (mFragmentedMoovWritten && !info->mInMoov) {
+            ALOGW("Dropping %s sample, the track started after the movie header was written",
+                    info->mTrack->getTrackType());
+            sample->release();
+            continue;
+        }
+        info->mFragmentSamples.push_back(sample);
+        if (info->mFragmentSamples.size() < 2) {
+            continue;
+        }
+
+        // Start a new fragment at the next sync sample of the pacing track once the
+        // fragment duration is reached, or at any sample of any track once it is
+        // exceeded by far, which bounds the pending samples if the pacing track
+        // stalls. The new sample is kept back and starts the next fragment.
+        int64_t startUs, timeUs;
+        int32_t isSync = 0;
+        CHECK((*info->mFragmentSamples.begin())->meta_data().findInt64(
+                kKeyDecodingTime, &startUs));
+        CHECK(sample->meta_data().findInt64(kKeyDecodingTime, &timeUs));
+        sample->meta_data().findInt32(kKeyIsSyncFrame, &isSync);
+        const int64_t elapsedUs = timeUs - startUs;
+        if (elapsedUs >= kMaxFragmentDurationFactor * mFragmentDurationUs
+                || (info == pacing && isSync && elapsedUs >= mFragmentDurationUs)) {
+            writeFragment(false /* flushAll */);
+        }
+    }
+}
+
+void MPEG4Writer::writeFragment(bool flushAll) {
+    if (!mFragmentedMoovWritten) {
+        // The movie header describes every track, so wait for all of them to
+        // produce their first sample unless that takes too long.
+        bool waitForTracks = false;
+        int64_t pendingUs = 0;
+        for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+             it != mChunkInfos.end(); ++it) {
+            if (it->mFragmentSamples.empty()) {
+                waitForTracks |= !it->mTrack->reachedEOS();
+                continue;
+            }
+            int64_t startUs, endUs;
+            CHECK((*it->mFragmentSamples.begin())->meta_data().findInt64(
+                    kKeyDecodingTime, &startUs));
+            CHECK((*--it->mFragmentSamples.end())->meta_data().findInt64(
+                    kKeyDecodingTime, &endUs));
+            pendingUs = std::max(pendingUs, endUs - startUs);
+        }
+        if (!flushAll && waitForTracks
+                && pendingUs < kMaxFragmentDurationFactor * mFragmentDurationUs) {
+            return;
+        }
+        writeFragmentedMoovBox();
+    }
+
+    struct SampleInfo {
+        uint32_t mSize;
+        uint32_t mDurationTicks;
+        uint32_t mFlags;
+        int32_t mCtsTicks;
+    };
+    std::vector<SampleInfo> samples;
+    std::vector<size_t> trafSampleCounts;
+    int64_t moofSize = 8 + 16;  // moof + mfhd
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin(); it != mChunkInfos.end(); ++it) {
+        size_t count = it->mFragmentSamples.size();
+        if (!flushAll && count > 0) {
+            --count;
+        }
+        if (!it->mInMoov) {
+            count = 0;
+        }
+        trafSampleCounts.push_back(count);
+        if (count > 0) {
+            moofSize += 8 + 16 + 20 + 20 + 16 * count;  // traf + tfhd + tfdt + trun
+        }
+    }
+    if (moofSize == 8 + 16) {
+        return;
+    }
+
+    // Write the sample data first, since the moof box depends on the actual
+    // sample sizes, and fill in the moof box and the mdat header afterwards.
+    const off64_t moofOffset = mOffset;
+    const off64_t mdatOffset = moofOffset + moofSize;
+    mOffset = mdatOffset + 8;
+    seekOrPostError(mFd, mOffset, SEEK_SET);
+    startAsyncWrites();
+    std::vector<int64_t> baseDecodeTimes;
+    size_t trackIndex = 0;
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+         it != mChunkInfos.end(); ++it, ++trackIndex) {
+        const size_t count = trafSampleCounts[trackIndex];
+        if (count == 0) {
+            continue;
+        }
+        Track *track = it->mTrack;
+        const int64_t timeScale = track->getTimeScale();
+        auto toTicks = [timeScale, &it](int64_t timeUs) {
+            return ((it->mStartOffsetUs + timeUs) * timeScale + 500000LL) / 1000000LL;
+        };
+        for (size_t i = 0; i < count; ++i) {
+            List<MediaBuffer *>::iterator sampleIt = it->mFragmentSamples.begin();
+            MediaBuffer *sample = *sampleIt;
+            it->mFragmentSamples.erase(sampleIt);
+
+            int64_t dtsUs, ptsUs;
+            int32_t isSync = 0;
+            CHECK(sample->meta_data().findInt64(kKeyDecodingTime, &dtsUs));
+            CHECK(sample->meta_data().findInt64(kKeyTime, &ptsUs));
+            sample->meta_data().findInt32(kKeyIsSyncFrame, &isSync);
+            const int64_t dtsTicks = toTicks(dtsUs);
+            if (i == 0) {
+                baseDecodeTimes.push_back(dtsTicks);
+            }
+
+            int64_t durationTicks = it->mLastDurationTicks;
+            if (!it->mFragmentSamples.empty()) {
+                int64_t nextDtsUs;
+                CHECK((*it->mFragmentSamples.begin())->meta_data().findInt64(
+                        kKeyDecodingTime, &nextDtsUs));
+                durationTicks = toTicks(nextDtsUs) - dtsTicks;
+            }
+            it->mLastDurationTicks = durationTicks;
+
+            // Present the first sample at its decoding time, the same as the
+            // edit list does for non fragmented files.
+            int64_t ctsTicks = toTicks(ptsUs) - dtsTicks;
+            if (it->mCtsShiftTicks == INT64_MIN) {
+                it->mCtsShiftTicks = ctsTicks;
+            }
+            ctsTicks -= it->mCtsShiftTicks;
+
+            size_t bytesWritten;
+            addSample_l(sample, track->usePrefix(), 0 /* tiffHdrOffset */, &bytesWritten);
+            sample->release();
+
+            SampleInfo info;
+            info.mSize = bytesWritten;
+            info.mDurationTicks = durationTicks;
+            // sample_depends_on, sample_is_non_sync_sample
+            info.mFlags = isSync ? 0x02000000 : 0x01010000;
+            info.mCtsTicks = ctsTicks;
+            samples.push_back(info);
+        }
+    }
+    const off64_t endOffset = mOffset;
+
+    seekOrPostError(mFd, moofOffset, SEEK_SET);
+    mOffset = moofOffset;
+    writeInt32(moofSize);
+    writeFourcc("moof");
+    writeInt32(16);
+    writeFourcc("mfhd");
+    writeInt32(0);                     // version=0, flags=0
+    writeInt32(++mFragmentSequence);   // sequence_number
+    int64_t dataOffset = moofSize + 8;
+    size_t sampleIndex = 0;
+    size_t trafIndex = 0;
+    trackIndex = 0;
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+         it != mChunkInfos.end(); ++it, ++trackIndex) {
+        const size_t count = trafSampleCounts[trackIndex];
+        if (count == 0) {
+            continue;
+        }
+        writeInt32(8 + 16 + 20 + 20 + 16 * count);
+        writeFourcc("traf");
+        writeInt32(16);
+        writeFourcc("tfhd");
+        writeInt32(0x020000);              // version=0, flags=default-base-is-moof
+        writeInt32(it->mTrack->getTrackId().getId());
+        writeInt32(20);
+        writeFourcc("tfdt");
+        writeInt32(1 << 24);               // version=1, flags=0
+        writeInt64(baseDecodeTimes[trafIndex++]);
+        writeInt32(20 + 16 * count);
+        writeFourcc("trun");
+        // version=1 for signed composition offsets, flags=data-offset, sample
+        // duration, size, flags and composition time offset present
+        writeInt32((1 << 24) | 0xF01);
+        writeInt32(count);
+        writeInt32(dataOffset);
+        for (size_t i = 0; i < count; ++i, ++sampleIndex) {
+            const SampleInfo &info = samples[sampleIndex];
+            writeInt32(info.mDurationTicks);
+            writeInt32(info.mSize);
+            writeInt32(info.mFlags);
+            writeInt32(info.mCtsTicks);
+            dataOffset += info.mSize;
+        }
+    }
+    CHECK_EQ(mOffset, mdatOffset);
+    CHECK_LE(endOffset - mdatOffset, (off64_t)UINT32_MAX);
+    writeInt32(endOffset - mdatOffset);
+    writeFourcc("mdat");
+    seekOrPostError(mFd, endOffset, SEEK_SET);
+    mOffset = endOffset;
+    ALOGV("Wrote movie fragment %u, %zu samples, %" PRId64 " bytes",
+            mFragmentSequence, samples.size(), (int64_t)(endOffset - moofOffset));
+}
+
+void MPEG4Writer::writeFragmentedMoovBox() {
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin(); it != mChunkInfos.end(); ++it) {
+        it->mInMoov = !it->mFragmentSamples.empty();
+        if (it->mInMoov) {
+            it->mStartOffsetUs =
+                    std::max((int64_t)0, it->mTrack->getStartTimeUs() - mStartTimestampUs);
+        }
+    }
+
+    beginBox("moov");
+    writeMvhdBox(0 /* durationUs */);
+    if (mAreGeoTagsAvailable) {
+        writeUdtaBox();
+    }
+    writeMoovLevelMetaBox();
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin(); it != mChunkInfos.end(); ++it) {
+        if (it->mInMoov) {
+            it->mTrack->writeTrackHeader();
+        }
+    }
+    beginBox("mvex");
+    beginBox("mehd");
+    writeInt32(1 << 24);  // version=1, flags=0
+    mMehdOffset = mOffset;
+    writeInt64(0);        // fragment_duration, filled in by writeFragmentedDuration()
+    endBox();  // mehd
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin(); it != mChunkInfos.end(); ++it) {
+        if (!it->mInMoov) {
+            continue;
+        }
+        beginBox("trex");
+        writeInt32(0);  // version=0, flags=0
+        writeInt32(it->mTrack->getTrackId().getId());
+        writeInt32(1);  // default_sample_description_index
+        writeInt32(0);  // default_sample_duration
+        writeInt32(0);  // default_sample_size
+        writeInt32(0);  // default_sample_flags
+        endBox();  // trex
+    }
+    endBox();  // mvex
+    endBox();  // moov
+    mFragmentedMoovWritten = true;
+    ALOGI("MOOV atom of the fragmented file was written");
+}
+
+void MPEG4Writer::writeFragmentedDuration(int64_t durationUs) {
+    if (!mFragmentedMoovWritten) {
+        return;
+    }
+    uint64_t duration = hton64((durationUs * mTimeScale + 500000LL) / 1000000LL);
+    seekOrPostError(mFd, mMehdOffset, SEEK_SET);
+    writeOrPostError(mFd, &duration, 8);
+    seekOrPostError(mFd, mOffset, SEEK_SET);
+}
+
 void MPEG4Writer::threadFunc() {
     ALOGV("threadFunc");
 
@@ -2895,6 +3823,7 @@ void MPEG4Writer::threadFunc() {
     }
 
     writeAllChunks();
+    finishAsyncWrites();
     ALOGV("threadFunc mOffset:%lld, mMaxOffsetAppend:%lld", (long long)mOffset,
           (long long)mMaxOffsetAppend);
     mOffset = std::max(mOffset, mMaxOffsetAppend);
@@ -2906,12 +3835,24 @@ status_t MPEG4Writer::startWriterThread() {
     mDone = false;
     mIsFirstChunk = true;
     mDriftTimeUs = 0;
+    mAsyncWriteActive = false;
+    mFragmentSequence = 0;
+    mFragmentedMoovWritten = false;
+    if (property_get_bool("media.mp4writer.async-write", false)) {
+        mAsyncWriter.reset(new AsyncWriter());
+    } else {
+        mAsyncWriter.reset();
+    }
     for (List<Track *>::iterator it = mTracks.begin();
          it != mTracks.end(); ++it) {
         ChunkInfo info;
         info.mTrack = *it;
         info.mPrevChunkTimestampUs = 0;
         info.mMaxInterChunkDurUs = 0;
+        info.mInMoov = false;
+        info.mStartOffsetUs = 0;
+        info.mCtsShiftTicks = INT64_MIN;
+        info.mLastDurationTicks = 0;
         mChunkInfos.push_back(info);
     }
 
@@ -2993,6 +3934,15 @@ status_t MPEG4Writer::Track::start(MetaData *params) {
     pthread_attr_init(&attr);
     pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
 
+    if (mOwner->isFragmented()) {
+        mStszTableEntries->setCountOnly();
+        mCo64TableEntries->setCountOnly();
+        mStscTableEntries->setCountOnly();
+        mStssTableEntries->setCountOnly();
+        mSttsTableEntries->setCountOnly();
+        mCttsTableEntries->setCountOnly();
+    }
+
     mDone = false;
     mStarted = true;
     mTrackDurationUs = 0;
@@ -3550,8 +4500,11 @@ void MPEG4Writer::Track::dumpTimeStamps() {
 
 status_t MPEG4Writer::Track::threadEntry() {
     int32_t count = 0;
-    const int64_t interleaveDurationUs = mOwner->interleaveDuration();
-    const bool hasMultipleTracks = (mOwner->numTracks() > 1);
+    // In fragmented recordings every sample goes to the writer thread on its own,
+    // which groups them into movie fragments.
+    const int64_t interleaveDurationUs =
+            mOwner->isFragmented() ? 0 : mOwner->interleaveDuration();
+    const bool hasMultipleTracks = (mOwner->numTracks() > 1) || mOwner->isFragmented();
     int64_t chunkTimestampUs = 0;
     int32_t nChunks = 0;
     int32_t nActualFrames = 0;        // frames containing non-CSD data (non-0 length)
@@ -3729,6 +4682,13 @@ status_t MPEG4Writer::Track::threadEntry() {
             lastSample = -1;
         }
         ALOGV("sampleFileOffset:%lld", (long long)sampleFileOffset);
+        if (sampleFileOffset != -1 && mOwner->isFragmented()) {
+            ALOGE("Samples already in the file are not supported by fragmented recording");
+            buffer->release();
+            mSource->stop();
+            mIsMalformed = true;
+            break;
+        }
 
         if (mIsMPEGH && !mGotAllCodecSpecificData) {
             err = parseMHASPackets(buffer);
@@ -4010,7 +4970,14 @@ status_t MPEG4Writer::Track::threadEntry() {
                     timestampUs += deltaUs;
                 }
             }
-            mStszTableEntries->add(htonl(sampleSize));
+            if (mOwner->isFragmented()) {
+                // The track fragment run needs the times of each sample.
+                copy->meta_data().setInt64(kKeyDecodingTime, timestampUs);
+                copy->meta_data().setInt64(kKeyTime, mIsVideo
+                        ? timestampUs + cttsOffsetTimeUs - kMaxCttsOffsetTimeUs : timestampUs);
+                copy->meta_data().setInt32(kKeyIsSyncFrame, isSync || !mIsVideo);
+            }
+            mStszTableEntries->add(sampleSize);
 
             if (mStszTableEntries->count() > 2) {
 
@@ -4421,7 +5388,9 @@ void MPEG4Writer::Track::writeTrackHeader() {
     uint32_t now = getMpeg4Time();
     mOwner->beginBox("trak");
         writeTkhdBox(now);
-        writeEdtsBox();
+        if (!mOwner->isFragmented()) {
+            writeEdtsBox();
+        }
         mOwner->beginBox("mdia");
             writeMdhdBox(now);
             writeHdlrBox();
@@ -4465,14 +5434,29 @@ void MPEG4Writer::Track::writeStblBox() {
             writeMetadataFourCCBox();
         }
         mOwner->endBox();  // stsd
-        writeSttsBox();
-        if (mIsVideo) {
-            writeCttsBox();
-            writeStssBox();
+        if (mOwner->isFragmented()) {
+            // The samples are described by the track fragments.
+            for (const char *box : {"stts", "stsc", "stco"}) {
+                mOwner->beginBox(box);
+                mOwner->writeInt32(0);  // version=0, flags=0
+                mOwner->writeInt32(0);  // entry count
+                mOwner->endBox();
+            }
+            mOwner->beginBox("stsz");
+            mOwner->writeInt32(0);  // version=0, flags=0
+            mOwner->writeInt32(0);  // sample size
+            mOwner->writeInt32(0);  // sample count
+            mOwner->endBox();  // stsz
+        } else {
+            writeSttsBox();
+            if (mIsVideo) {
+                writeCttsBox();
+                writeStssBox();
+            }
+            writeStszBox();
+            writeStscBox();
+            writeCo64Box();
         }
-        writeStszBox();
-        writeStscBox();
-        writeCo64Box();
     }
     mOwner->endBox();  // stbl
 }
@@ -4851,7 +5835,8 @@ void MPEG4Writer::Track::writeTkhdBox(uint32_t now) {
     mOwner->writeInt32(now);           // modification time
     mOwner->writeInt32(mTrackId.getId()); // track id starts with 1
     mOwner->writeInt32(0);             // reserved
-    int64_t trakDurationUs = getDurationUs();
+    // The duration of a fragmented track is only known from its fragments.
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int32_t mvhdTimeScale = mOwner->getTimeScale();
     int32_t tkhdDuration =
         (trakDurationUs * mvhdTimeScale + 5E5) / 1E6;
@@ -5054,7 +6039,7 @@ void MPEG4Writer::Track::writeEdtsBox() {
 }
 
 void MPEG4Writer::Track::writeMdhdBox(uint32_t now) {
-    int64_t trakDurationUs = getDurationUs();
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int64_t mdhdDuration = (trakDurationUs * mTimeScale + 5E5) / 1E6;
     mOwner->beginBox("mdhd");
 
@@ -5255,8 +6240,14 @@ void MPEG4Writer::Track::writeStssBox() {
 void MPEG4Writer::Track::writeStszBox() {
     mOwner->beginBox("stsz");
     mOwner->writeInt32(0);  // version=0, flags=0
-    mOwner->writeInt32(0);
-    mStszTableEntries->write(mOwner);
+    if (mStszTableEntries->allValuesEqual()) {
+        // All samples have the same size, so the table itself can be left out.
+        mOwner->writeInt32(mStszTableEntries->firstValue());
+        mOwner->writeInt32(mStszTableEntries->count());
+    } else {
+        mOwner->writeInt32(0);
+        mStszTableEntries->write(mOwner);
+    }
     mOwner->endBox();  // stsz
 }
 
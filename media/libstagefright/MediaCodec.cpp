@@ -19,6 +19,8 @@
 #define LOG_TAG "MediaCodec"
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <iterator>
 #include <set>
 #include <stdlib.h>
 
@@ -159,12 +161,29 @@ static const char *kCodecLatencyAvg = "android.media.mediacodec.latency.avg";
 static const char *kCodecLatencyCount = "android.media.mediacodec.latency.n";
 static const char *kCodecLatencyHist = "android.media.mediacodec.latency.hist"; /* in us */
 static const char *kCodecLatencyUnknown = "android.media.mediacodec.latency.unknown";
+static const char *kCodecLatencyP50 = "android.media.mediacodec.latency.p50";   /* in us */
+static const char *kCodecLatencyP90 = "android.media.mediacodec.latency.p90";   /* in us */
+static const char *kCodecLatencyP99 = "android.media.mediacodec.latency.p99";   /* in us */
+static const char *kCodecRenderDriftMax = "android.media.mediacodec.render-drift.max";   /* in us */
+static const char *kCodecRenderDriftAvg = "android.media.mediacodec.render-drift.avg";   /* in us */
+static const char *kCodecRenderDriftCount = "android.media.mediacodec.render-drift.n";
+static const char *kCodecRenderDriftHist = "android.media.mediacodec.render-drift.hist"; /* in us */
+static const char *kCodecInputStarvationCount = "android.media.mediacodec.input-starvation.n";
+static const char *kCodecOutputStarvationCount = "android.media.mediacodec.output-starvation.n";
+static const char *kCodecConfiguredMs = "android.media.mediacodec.state.configured-ms";
+static const char *kCodecStartedMs = "android.media.mediacodec.state.started-ms";
+static const char *kCodecFlushedMs = "android.media.mediacodec.state.flushed-ms";
+static const char *kCodecStartLatencyUs = "android.media.mediacodec.start.latency-us";
 static const char *kCodecQueueSecureInputBufferError = "android.media.mediacodec.queueSecureInputBufferError";
 static const char *kCodecQueueInputBufferError = "android.media.mediacodec.queueInputBufferError";
 
 static const char *kCodecNumLowLatencyModeOn = "android.media.mediacodec.low-latency.on";  /* 0..n */
 static const char *kCodecNumLowLatencyModeOff = "android.media.mediacodec.low-latency.off";  /* 0..n */
 static const char *kCodecFirstFrameIndexLowLatencyModeOn = "android.media.mediacodec.low-latency.first-frame";  /* 0..n */
+static const char *kCodecLowLatencyMax = "android.media.mediacodec.low-latency.max";   /* in us */
+static const char *kCodecLowLatencyAvg = "android.media.mediacodec.low-latency.avg";   /* in us */
+static const char *kCodecLowLatencyCount = "android.media.mediacodec.low-latency.n";
+static const char *kCodecLowLatencyHist = "android.media.mediacodec.low-latency.hist"; /* in us */
 static const char *kCodecChannelCount = "android.media.mediacodec.channelCount";
 static const char *kCodecSampleRate = "android.media.mediacodec.sampleRate";
 static const char *kCodecVideoEncodedBytes = "android.media.mediacodec.vencode.bytes";
@@ -172,6 +191,11 @@ static const char *kCodecVideoEncodedFrames = "android.media.mediacodec.vencode.
 static const char *kCodecVideoInputBytes = "android.media.mediacodec.video.input.bytes";
 static const char *kCodecVideoInputFrames = "android.media.mediacodec.video.input.frames";
 static const char *kCodecVideoEncodedDurationUs = "android.media.mediacodec.vencode.durationUs";
+// handler latency, only present while looper verbose stats are enabled
+static const char *kCodecHandlerQueueDelayMax =
+        "android.media.mediacodec.handler.queue-delay.max";    /* in us */
+static const char *kCodecHandlerTimeMax = "android.media.mediacodec.handler.time.max";  /* in us */
+static const char *kCodecHandlerTimeAvg = "android.media.mediacodec.handler.time.avg";  /* in us */
 
 // the kCodecRecent* fields appear only in getMetrics() results
 static const char *kCodecRecentLatencyMax = "android.media.mediacodec.recent.max";      /* in us */
@@ -185,6 +209,16 @@ static const char *kCodecPlaybackDurationSec =
 /* -1: shaper disabled
    >=0: number of fields changed */
 static const char *kCodecShapingEnhanced = "android.media.mediacodec.shaped";
+// bitrate changes made while encoding, from shaper feedback
+static const char *kCodecShapingFeedbackUpdates =
+        "android.media.mediacodec.shaped.feedback-updates";
+static const char *kCodecShapingFeedbackBitrate =
+        "android.media.mediacodec.shaped.feedback-bitrate";   /* last bitrate chosen */
+
+// how much encoder output the shaper sees per round of feedback: a GOP, as long as
+// it covers at least the minimum, and at most the maximum for long or open GOPs.
+static const int64_t kShapingFeedbackMinIntervalUs = 1000000ll;
+static const int64_t kShapingFeedbackMaxIntervalUs = 3000000ll;
 
 // XXX suppress until we get our representation right
 static bool kEmitHistogram = false;
@@ -491,6 +525,7 @@ namespace {
 enum {
     kWhatFillThisBuffer      = 'fill',
     kWhatDrainThisBuffer     = 'drai',
+    kWhatDrainTheseBuffers   = 'draN',
     kWhatEOS                 = 'eos ',
     kWhatStartCompleted      = 'Scom',
     kWhatStopCompleted       = 'scom',
@@ -505,6 +540,7 @@ enum {
     kWhatOutputFramesRendered = 'outR',
     kWhatOutputBuffersChanged = 'outC',
     kWhatFirstTunnelFrameReady = 'ftfR',
+    kWhatMetricsUpdated      = 'metU',
 };
 
 class BufferCallback : public CodecBase::BufferCallback {
@@ -516,6 +552,8 @@ public:
             size_t index, const sp<MediaCodecBuffer> &buffer) override;
     virtual void onOutputBufferAvailable(
             size_t index, const sp<MediaCodecBuffer> &buffer) override;
+    virtual void onOutputBuffersAvailable(
+            const std::vector<std::pair<size_t, sp<MediaCodecBuffer>>> &buffers) override;
 private:
     const sp<AMessage> mNotify;
 };
@@ -541,6 +579,22 @@ void BufferCallback::onOutputBufferAvailable(
     notify->post();
 }
 
+void BufferCallback::onOutputBuffersAvailable(
+        const std::vector<std::pair<size_t, sp<MediaCodecBuffer>>> &buffers) {
+    if (buffers.size() == 1) {
+        onOutputBufferAvailable(buffers.front().first, buffers.front().second);
+        return;
+    }
+    if (buffers.empty()) {
+        return;
+    }
+    sp<AMessage> notify(mNotify->dup());
+    notify->setInt32("what", kWhatDrainTheseBuffers);
+    notify->setObject("buffers", new MediaCodec::WrapperObject<
+            std::vector<std::pair<size_t, sp<MediaCodecBuffer>>>>{buffers});
+    notify->post();
+}
+
 class CodecCallback : public CodecBase::CodecCallback {
 public:
     explicit CodecCallback(const sp<AMessage> &notify);
@@ -568,6 +622,7 @@ public:
     virtual void onOutputFramesRendered(const std::list<FrameRenderTracker::Info> &done) override;
     virtual void onOutputBuffersChanged() override;
     virtual void onFirstTunnelFrameReady() override;
+    virtual void onMetricsUpdated(const sp<AMessage> &updatedMetrics) override;
 private:
     const sp<AMessage> mNotify;
 };
@@ -587,6 +642,13 @@ void CodecCallback::onStartCompleted() {
     notify->post();
 }
 
+void CodecCallback::onMetricsUpdated(const sp<AMessage> &updatedMetrics) {
+    sp<AMessage> notify(mNotify->dup());
+    notify->setInt32("what", kWhatMetricsUpdated);
+    notify->setMessage("updated-metrics", updatedMetrics);
+    notify->post();
+}
+
 void CodecCallback::onStopCompleted() {
     sp<AMessage> notify(mNotify->dup());
     notify->setInt32("what", kWhatStopCompleted);
@@ -894,6 +956,13 @@ void MediaCodec::initMediametrics() {
     }
 
     mLatencyHist.setup(kLatencyHistBuckets, kLatencyHistWidth, kLatencyHistFloor);
+    mLowLatencyHist.setup(kLowLatencyHistBuckets, kLowLatencyHistWidth, kLowLatencyHistFloor);
+    mRenderDriftHist.setup(kRenderDriftHistBuckets, kRenderDriftHistWidth, kRenderDriftHistFloor);
+    mLastRenderTimeNs = -1;
+    mLastRenderMediaTimeUs = -1;
+    mInputStarvationCount = 0;
+    mOutputStarvationCount = 0;
+    std::fill(std::begin(mTimeInStateNs), std::end(mTimeInStateNs), 0);
 
     {
         Mutex::Autolock al(mRecentLock);
@@ -928,6 +997,9 @@ void MediaCodec::updateMediametrics() {
         mediametrics_setInt64(mMetricsHandle, kCodecLatencyMin, mLatencyHist.getMin());
         mediametrics_setInt64(mMetricsHandle, kCodecLatencyAvg, mLatencyHist.getAvg());
         mediametrics_setInt64(mMetricsHandle, kCodecLatencyCount, mLatencyHist.getCount());
+        mediametrics_setInt64(mMetricsHandle, kCodecLatencyP50, mLatencyHist.getPercentile(50));
+        mediametrics_setInt64(mMetricsHandle, kCodecLatencyP90, mLatencyHist.getPercentile(90));
+        mediametrics_setInt64(mMetricsHandle, kCodecLatencyP99, mLatencyHist.getPercentile(99));
 
         if (kEmitHistogram) {
             // and the histogram itself
@@ -935,9 +1007,43 @@ void MediaCodec::updateMediametrics() {
             mediametrics_setCString(mMetricsHandle, kCodecLatencyHist, hist.c_str());
         }
     }
+    if (mLowLatencyHist.getCount() != 0) {
+        mediametrics_setInt64(mMetricsHandle, kCodecLowLatencyMax, mLowLatencyHist.getMax());
+        mediametrics_setInt64(mMetricsHandle, kCodecLowLatencyAvg, mLowLatencyHist.getAvg());
+        mediametrics_setInt64(mMetricsHandle, kCodecLowLatencyCount, mLowLatencyHist.getCount());
+
+        if (kEmitHistogram) {
+            std::string hist = mLowLatencyHist.emit();
+            mediametrics_setCString(mMetricsHandle, kCodecLowLatencyHist, hist.c_str());
+        }
+    }
     if (mLatencyUnknown > 0) {
         mediametrics_setInt64(mMetricsHandle, kCodecLatencyUnknown, mLatencyUnknown);
     }
+    if (mRenderDriftHist.getCount() != 0) {
+        mediametrics_setInt64(mMetricsHandle, kCodecRenderDriftMax, mRenderDriftHist.getMax());
+        mediametrics_setInt64(mMetricsHandle, kCodecRenderDriftAvg, mRenderDriftHist.getAvg());
+        mediametrics_setInt64(mMetricsHandle, kCodecRenderDriftCount, mRenderDriftHist.getCount());
+
+        if (kEmitHistogram) {
+            std::string hist = mRenderDriftHist.emit();
+            mediametrics_setCString(mMetricsHandle, kCodecRenderDriftHist, hist.c_str());
+        }
+    }
+    mediametrics_setInt64(mMetricsHandle, kCodecInputStarvationCount, mInputStarvationCount);
+    mediametrics_setInt64(mMetricsHandle, kCodecOutputStarvationCount, mOutputStarvationCount);
+    {
+        // include the time spent in the current state so far
+        nsecs_t timeInStateNs[RELEASING + 1];
+        std::copy(std::begin(mTimeInStateNs), std::end(mTimeInStateNs), timeInStateNs);
+        if (mStateStartNs > 0) {
+            timeInStateNs[mState] += systemTime(SYSTEM_TIME_MONOTONIC) - mStateStartNs;
+        }
+        mediametrics_setInt64(mMetricsHandle, kCodecConfiguredMs,
+                              timeInStateNs[CONFIGURED] / 1000000);
+        mediametrics_setInt64(mMetricsHandle, kCodecStartedMs, timeInStateNs[STARTED] / 1000000);
+        mediametrics_setInt64(mMetricsHandle, kCodecFlushedMs, timeInStateNs[FLUSHED] / 1000000);
+    }
     int64_t playbackDurationSec = mPlaybackDurationAccumulator->getDurationInSeconds();
     if (playbackDurationSec > 0) {
         mediametrics_setInt64(mMetricsHandle, kCodecPlaybackDurationSec, playbackDurationSec);
@@ -970,6 +1076,16 @@ void MediaCodec::updateMediametrics() {
                               mIndexOfFirstFrameWhenLowLatencyOn);
     }
 
+    AHandler::LatencyStats handlerStats;
+    if (getLatencyStats(&handlerStats)) {
+        mediametrics_setInt64(mMetricsHandle, kCodecHandlerQueueDelayMax,
+                              handlerStats.mMaxQueueDelayUs);
+        mediametrics_setInt64(mMetricsHandle, kCodecHandlerTimeMax,
+                              handlerStats.mMaxHandlingTimeUs);
+        mediametrics_setInt64(mMetricsHandle, kCodecHandlerTimeAvg,
+                              handlerStats.mTotalHandlingTimeUs / handlerStats.mNumMessages);
+    }
+
 #if 0
     // enable for short term, only while debugging
     updateEphemeralMediametrics(mMetricsHandle);
@@ -1283,6 +1399,26 @@ void MediaCodec::updatePlaybackDuration(const sp<AMessage> &msg) {
     }
 }
 
+void MediaCodec::updateRenderDrift(const sp<AMessage> &msg) {
+    // The drift of a frame is how much the time between its render and the render of the
+    // previous frame differs from the difference of their media times.
+    int64_t renderTimeNs;
+    int64_t mediaTimeUs;
+    for (size_t index = 0;
+            msg->findInt64(AStringPrintf("%zu-media-time-us", index).c_str(), &mediaTimeUs)
+            && msg->findInt64(AStringPrintf("%zu-system-nano", index).c_str(), &renderTimeNs);
+            ++index) {
+        if (mLastRenderTimeNs >= 0 && mediaTimeUs > mLastRenderMediaTimeUs
+                && renderTimeNs > mLastRenderTimeNs) {
+            int64_t driftUs = (renderTimeNs - mLastRenderTimeNs) / 1000
+                    - (mediaTimeUs - mLastRenderMediaTimeUs);
+            mRenderDriftHist.insert(driftUs < 0 ? -driftUs : driftUs);
+        }
+        mLastRenderTimeNs = renderTimeNs;
+        mLastRenderMediaTimeUs = mediaTimeUs;
+    }
+}
+
 bool MediaCodec::Histogram::setup(int nbuckets, int64_t width, int64_t floor)
 {
     if (nbuckets <= 0 || width <= 0) {
@@ -1350,6 +1486,27 @@ void MediaCodec::Histogram::insert(int64_t sample)
     return;
 }
 
+int64_t MediaCodec::Histogram::getPercentile(int percentile) const
+{
+    if (mCount == 0) {
+        return 0;
+    }
+    // The sample is only known to be within its bucket, so report the upper
+    // edge of the bucket, bounded by the samples actually seen.
+    int64_t target = (mCount * percentile + 99) / 100;
+    int64_t seen = mBelow;
+    if (seen >= target) {
+        return std::min(mFloor, mMax);
+    }
+    for (int i = 0; i < mBucketCount; i++) {
+        seen += mBuckets[i];
+        if (seen >= target) {
+            return std::max(mMin, std::min(mFloor + (i + 1) * mWidth, mMax));
+        }
+    }
+    return mMax;
+}
+
 std::string MediaCodec::Histogram::emit()
 {
     std::string value;
@@ -1427,6 +1584,8 @@ void MediaCodec::statsBufferReceived(int64_t presentationUs, const sp<MediaCodec
             mBytesEncoded += buffer->size();
             mFramesEncoded++;
 
+            feedbackShaper(presentationUs, flags, buffer);
+
             Mutex::Autolock al(mOutputStatsLock);
             int64_t timeUs = 0;
             if (buffer->meta()->findInt64("timeUs", &timeUs)) {
@@ -1501,6 +1660,9 @@ void MediaCodec::statsBufferReceived(int64_t presentationUs, const sp<MediaCodec
     int64_t latencyUs = (nowNs - startdata.startedNs + 500) / 1000;
 
     mLatencyHist.insert(latencyUs);
+    if (mIsLowLatencyModeOn) {
+        mLowLatencyHist.insert(latencyUs);
+    }
 
     // push into the recent samples
     {
@@ -1856,6 +2018,7 @@ status_t MediaCodec::configure(
     }
 
     if (flags & CONFIGURE_FLAG_ENCODE) {
+        mShapedFormat.clear();
         int8_t enableShaping = property_get_bool(enableMediaFormatShapingProperty,
                                                  enableMediaFormatShapingDefault);
         if (!enableShaping) {
@@ -2041,7 +2204,8 @@ static bool connectFormatShaper() {
         }
 
         if (sShaperOps != nullptr
-            && sShaperOps->version != android::mediaformatshaper::SHAPER_VERSION_V1) {
+            && (sShaperOps->version < android::mediaformatshaper::SHAPER_VERSION_V1
+                || sShaperOps->version > android::mediaformatshaper::SHAPER_VERSION_V2)) {
             ALOGW("connectFormatShaper: unhandled version ShaperOps: %d, DISABLED",
                   sShaperOps->version);
             sShaperOps = nullptr;
@@ -2351,12 +2515,109 @@ status_t MediaCodec::shapeMediaFormat(
             // NB: for any field in both format and deltas, the deltas copy wins
             format->extend(deltas);
         }
+
+        // keep what we configured with, so the shaper can revisit it as we encode
+        if (mDomain == DOMAIN_VIDEO
+                && sShaperOps->version >= mediaformatshaper::SHAPER_VERSION_V2
+                && sShaperOps->shapeFeedback != nullptr) {
+            mShapedFormat = format->dup();
+            mShapingIntervalStartUs = -1;
+            mShapingIntervalLastUs = -1;
+            mShapingFeedbackUpdates = 0;
+        }
     }
 
     AMediaFormat_delete(updatedNdkFormat);
     return OK;
 }
 
+void MediaCodec::feedbackShaper(int64_t presentationUs, int32_t flags,
+                                const sp<MediaCodecBuffer> &buffer) {
+    if (mShapedFormat == nullptr || sShaperOps == nullptr) {
+        return;
+    }
+
+    // timestamps going backwards (e.g. after a flush) start a new interval
+    if (mShapingIntervalStartUs < 0 || presentationUs < mShapingIntervalLastUs) {
+        mShapingIntervalStartUs = presentationUs;
+        mShapingIntervalBytes = 0;
+        mShapingIntervalFrames = 0;
+        mShapingIntervalQpSum = 0;
+        mShapingIntervalQpFrames = 0;
+    }
+
+    // a new GOP closes out the previous one, if there is enough of it
+    int64_t durationUs = presentationUs - mShapingIntervalStartUs;
+    bool intervalDone = durationUs >= kShapingFeedbackMaxIntervalUs
+            || ((flags & BUFFER_FLAG_SYNCFRAME) && durationUs >= kShapingFeedbackMinIntervalUs);
+
+    if (intervalDone && mShapingIntervalFrames > 0) {
+        AMediaFormat *stats = AMediaFormat_new();
+        AMediaFormat_setInt64(stats, "frames", mShapingIntervalFrames);
+        AMediaFormat_setInt64(stats, "bytes", mShapingIntervalBytes);
+        AMediaFormat_setInt64(stats, "duration-us", durationUs);
+        if (mShapingIntervalQpFrames > 0) {
+            AMediaFormat_setInt32(stats, KEY_VIDEO_QP_AVERAGE,
+                                  (int32_t)(mShapingIntervalQpSum / mShapingIntervalQpFrames));
+        }
+        AMediaFormat *updates = AMediaFormat_new();
+
+        AString mediaType;
+        mediaformatshaper::shaperHandle_t shaperHandle = nullptr;
+        if (mShapedFormat->findString("mime", &mediaType)) {
+            shaperHandle = sShaperOps->findShaper(mComponentName.c_str(), mediaType.c_str());
+        }
+        if (shaperHandle != nullptr) {
+            sp<AMessage> shapedFormat = mShapedFormat;
+            AMediaFormat *shapedNdkFormat = AMediaFormat_fromMsg(&shapedFormat);
+            int result = (*sShaperOps->shapeFeedback)(shaperHandle, shapedNdkFormat,
+                                                      stats, updates, 0 /* flags */);
+            if (result == 0) {
+                // the shaper keeps its state in the shaped format
+                AMediaFormat_getFormat(shapedNdkFormat, &mShapedFormat);
+
+                sp<AMessage> params;
+                AMediaFormat_getFormat(updates, &params);
+                if (params != nullptr && params->countEntries() > 0) {
+                    ALOGD("feedbackShaper: %s", params->debugString(0).c_str());
+                    int32_t bitrate;
+                    if (mMetricsHandle != 0
+                            && params->findInt32(PARAMETER_KEY_VIDEO_BITRATE, &bitrate)) {
+                        mediametrics_setInt64(mMetricsHandle, kCodecShapingFeedbackUpdates,
+                                              ++mShapingFeedbackUpdates);
+                        mediametrics_setInt32(mMetricsHandle, kCodecShapingFeedbackBitrate,
+                                              bitrate);
+                    }
+                    (void) onSetParameters(params);
+                }
+            }
+            AMediaFormat_delete(shapedNdkFormat);
+        }
+
+        AMediaFormat_delete(updates);
+        AMediaFormat_delete(stats);
+
+        mShapingIntervalStartUs = presentationUs;
+        mShapingIntervalBytes = 0;
+        mShapingIntervalFrames = 0;
+        mShapingIntervalQpSum = 0;
+        mShapingIntervalQpFrames = 0;
+    }
+
+    mShapingIntervalLastUs = presentationUs;
+    mShapingIntervalBytes += buffer->size();
+    mShapingIntervalFrames++;
+
+    // per-frame QP shows up in the output buffer's format when the encoder reports it
+    int32_t qpAverage;
+    if (buffer->meta()->findInt32(KEY_VIDEO_QP_AVERAGE, &qpAverage)
+            || (buffer->format() != nullptr
+                && buffer->format()->findInt32(KEY_VIDEO_QP_AVERAGE, &qpAverage))) {
+        mShapingIntervalQpSum += qpAverage;
+        mShapingIntervalQpFrames++;
+    }
+}
+
 static void mapFormat(AString componentName, const sp<AMessage> &format, const char *kind,
                       bool reverse) {
     AString mediaType;
@@ -2690,6 +2951,47 @@ status_t MediaCodec::queueInputBuffer(
     return PostAndAwaitResponse(msg, &response);
 }
 
+status_t MediaCodec::queueInputAccessUnits(
+        size_t index,
+        size_t offset,
+        size_t size,
+        const std::vector<uint32_t> &accessUnitSizes,
+        int64_t presentationTimeUs,
+        uint32_t flags,
+        AString *errorDetailMsg) {
+    if (errorDetailMsg != NULL) {
+        errorDetailMsg->clear();
+    }
+
+    uint64_t total = 0;
+    for (uint32_t accessUnitSize : accessUnitSizes) {
+        if (accessUnitSize == 0) {
+            return -EINVAL;
+        }
+        total += accessUnitSize;
+    }
+    if (accessUnitSizes.empty() || total != size) {
+        ALOGE("access unit sizes add up to %llu bytes of %zu",
+                (unsigned long long)total, size);
+        return -EINVAL;
+    }
+
+    sp<ABuffer> sizes = new ABuffer(accessUnitSizes.size() * sizeof(uint32_t));
+    memcpy(sizes->data(), accessUnitSizes.data(), sizes->size());
+
+    sp<AMessage> msg = new AMessage(kWhatQueueInputBuffer, this);
+    msg->setSize("index", index);
+    msg->setSize("offset", offset);
+    msg->setSize("size", size);
+    msg->setBuffer("au-sizes", sizes);
+    msg->setInt64("timeUs", presentationTimeUs);
+    msg->setInt32("flags", flags);
+    msg->setPointer("errorDetailMsg", errorDetailMsg);
+
+    sp<AMessage> response;
+    return PostAndAwaitResponse(msg, &response);
+}
+
 status_t MediaCodec::queueSecureInputBuffer(
         size_t index,
         size_t offset,
@@ -3670,6 +3972,11 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
                     }
 
                     CHECK_EQ(mState, STARTING);
+                    if (mStartRequestedNs > 0) {
+                        mediametrics_setInt64(mMetricsHandle, kCodecStartLatencyUs,
+                                (systemTime(SYSTEM_TIME_MONOTONIC) - mStartRequestedNs) / 1000);
+                        mStartRequestedNs = 0;
+                    }
                     if (mDomain == DOMAIN_VIDEO || mDomain == DOMAIN_IMAGE) {
                         mResourceManagerProxy->addResource(
                                 MediaResource::GraphicMemoryResource(getGraphicBufferSize()));
@@ -3711,6 +4018,7 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
                                 asString(TunnelPeekState::kBufferRendered));
                     }
                     updatePlaybackDuration(msg);
+                    updateRenderDrift(msg);
                     // check that we have a notification set
                     if (mOnFrameRenderedNotification != NULL) {
                         sp<AMessage> notify = mOnFrameRenderedNotification->dup();
@@ -3720,6 +4028,22 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
                     break;
                 }
 
+                case kWhatMetricsUpdated:
+                {
+                    sp<AMessage> updatedMetrics;
+                    CHECK(msg->findMessage("updated-metrics", &updatedMetrics));
+                    for (size_t i = 0; i < updatedMetrics->countEntries(); ++i) {
+                        AMessage::Type type;
+                        const char *name = updatedMetrics->getEntryNameAt(i, &type);
+                        int64_t value;
+                        if (type == AMessage::kTypeInt64
+                                && updatedMetrics->findInt64(name, &value)) {
+                            mediametrics_setInt64(mMetricsHandle, name, value);
+                        }
+                    }
+                    break;
+                }
+
                 case kWhatFirstTunnelFrameReady:
                 {
                     if (mState != STARTED) {
@@ -3831,47 +4155,24 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
 
                 case kWhatDrainThisBuffer:
                 {
-                    if ((mFlags & kFlagUseBlockModel) == 0 && mTunneled) {
-                        sp<RefBase> obj;
-                        CHECK(msg->findObject("buffer", &obj));
-                        sp<MediaCodecBuffer> buffer = static_cast<MediaCodecBuffer *>(obj.get());
-                        if (mFlags & kFlagIsAsync) {
-                            // In asynchronous mode, output format change is processed immediately.
-                            handleOutputFormatChangeIfNeeded(buffer);
-                        } else {
-                            postActivityNotificationIfPossible();
-                        }
-                        mBufferChannel->discardBuffer(buffer);
-                        break;
-                    }
-
-                    /* size_t index = */updateBuffers(kPortIndexOutput, msg);
-
-                    if (mState == FLUSHING
-                            || mState == STOPPING
-                            || mState == RELEASING) {
-                        returnBuffersToCodecOnPort(kPortIndexOutput);
-                        break;
-                    }
+                    onDrainThisBuffer(msg);
+                    break;
+                }
 
-                    if (mFlags & kFlagIsAsync) {
-                        sp<RefBase> obj;
-                        CHECK(msg->findObject("buffer", &obj));
-                        sp<MediaCodecBuffer> buffer = static_cast<MediaCodecBuffer *>(obj.get());
-
-                        // In asynchronous mode, output format change is processed immediately.
-                        handleOutputFormatChangeIfNeeded(buffer);
-                        onOutputBufferAvailable();
-                    } else if (mFlags & kFlagDequeueOutputPending) {
-                        CHECK(handleDequeueOutputBuffer(mDequeueOutputReplyID));
-
-                        ++mDequeueOutputTimeoutGeneration;
-                        mFlags &= ~kFlagDequeueOutputPending;
-                        mDequeueOutputReplyID = 0;
-                    } else {
-                        postActivityNotificationIfPossible();
+                case kWhatDrainTheseBuffers:
+                {
+                    sp<RefBase> obj;
+                    CHECK(msg->findObject("buffers", &obj));
+                    const std::vector<std::pair<size_t, sp<MediaCodecBuffer>>> &buffers =
+                        static_cast<WrapperObject<
+                                std::vector<std::pair<size_t, sp<MediaCodecBuffer>>>> *>(
+                                        obj.get())->value;
+                    sp<AMessage> drain = new AMessage;
+                    for (const std::pair<size_t, sp<MediaCodecBuffer>> &buffer : buffers) {
+                        drain->setSize("index", buffer.first);
+                        drain->setObject("buffer", buffer.second);
+                        onDrainThisBuffer(drain);
                     }
-
                     break;
                 }
 
@@ -4273,6 +4574,7 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
 
             mReplyID = replyID;
             setState(STARTING);
+            mStartRequestedNs = systemTime(SYSTEM_TIME_MONOTONIC);
 
             mCodec->initiateStart();
             break;
@@ -4493,6 +4795,7 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
             CHECK(msg->findInt64("timeoutUs", &timeoutUs));
 
             if (timeoutUs == 0LL) {
+                ++mInputStarvationCount;
                 PostReplyWithError(replyID, -EAGAIN);
                 break;
             }
@@ -4522,6 +4825,7 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
 
             CHECK(mFlags & kFlagDequeueInputPending);
 
+            ++mInputStarvationCount;
             PostReplyWithError(mDequeueInputReplyID, -EAGAIN);
 
             mFlags &= ~kFlagDequeueInputPending;
@@ -4575,6 +4879,7 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
             CHECK(msg->findInt64("timeoutUs", &timeoutUs));
 
             if (timeoutUs == 0LL) {
+                ++mOutputStarvationCount;
                 PostReplyWithError(replyID, -EAGAIN);
                 break;
             }
@@ -4604,6 +4909,7 @@ void MediaCodec::onMessageReceived(const sp<AMessage> &msg) {
 
             CHECK(mFlags & kFlagDequeueOutputPending);
 
+            ++mOutputStarvationCount;
             PostReplyWithError(mDequeueOutputReplyID, -EAGAIN);
 
             mFlags &= ~kFlagDequeueOutputPending;
@@ -5060,6 +5366,16 @@ void MediaCodec::setState(State newState) {
         mFlags &= ~kFlagSawMediaServerDie;
     }
 
+    const nsecs_t nowNs = systemTime(SYSTEM_TIME_MONOTONIC);
+    if (mStateStartNs > 0) {
+        mTimeInStateNs[mState] += nowNs - mStateStartNs;
+    }
+    mStateStartNs = nowNs;
+    if (newState == FLUSHING) {
+        // frames rendered after a flush are not paced against the ones before
+        mLastRenderTimeNs = -1;
+    }
+
     mState = newState;
 
     if (mBatteryChecker != nullptr) {
@@ -5252,6 +5568,19 @@ status_t MediaCodec::onQueueInputBuffer(const sp<AMessage> &msg) {
         }
     }
 
+    sp<ABuffer> accessUnitSizes;
+    if (msg->findBuffer("au-sizes", &accessUnitSizes)) {
+        if (hasCryptoOrDescrambler() || c2Buffer || memory) {
+            ALOGE("[%s] access unit sizes are only supported with clear buffers",
+                    mComponentName.c_str());
+            return -EINVAL;
+        }
+        buffer->meta()->setBuffer("au-sizes", accessUnitSizes);
+    } else {
+        // input buffers are reused; drop the sizes of an earlier batch
+        buffer->meta()->removeEntryByName("au-sizes");
+    }
+
     buffer->setRange(offset, size);
     buffer->meta()->setInt64("timeUs", timeUs);
     if (flags & BUFFER_FLAG_EOS) {
@@ -5572,6 +5901,49 @@ void MediaCodec::onInputBufferAvailable() {
     }
 }
 
+void MediaCodec::onDrainThisBuffer(const sp<AMessage> &msg) {
+    if ((mFlags & kFlagUseBlockModel) == 0 && mTunneled) {
+        sp<RefBase> obj;
+        CHECK(msg->findObject("buffer", &obj));
+        sp<MediaCodecBuffer> buffer = static_cast<MediaCodecBuffer *>(obj.get());
+        if (mFlags & kFlagIsAsync) {
+            // In asynchronous mode, output format change is processed immediately.
+            handleOutputFormatChangeIfNeeded(buffer);
+        } else {
+            postActivityNotificationIfPossible();
+        }
+        mBufferChannel->discardBuffer(buffer);
+        return;
+    }
+
+    /* size_t index = */updateBuffers(kPortIndexOutput, msg);
+
+    if (mState == FLUSHING
+            || mState == STOPPING
+            || mState == RELEASING) {
+        returnBuffersToCodecOnPort(kPortIndexOutput);
+        return;
+    }
+
+    if (mFlags & kFlagIsAsync) {
+        sp<RefBase> obj;
+        CHECK(msg->findObject("buffer", &obj));
+        sp<MediaCodecBuffer> buffer = static_cast<MediaCodecBuffer *>(obj.get());
+
+        // In asynchronous mode, output format change is processed immediately.
+        handleOutputFormatChangeIfNeeded(buffer);
+        onOutputBufferAvailable();
+    } else if (mFlags & kFlagDequeueOutputPending) {
+        CHECK(handleDequeueOutputBuffer(mDequeueOutputReplyID));
+
+        ++mDequeueOutputTimeoutGeneration;
+        mFlags &= ~kFlagDequeueOutputPending;
+        mDequeueOutputReplyID = 0;
+    } else {
+        postActivityNotificationIfPossible();
+    }
+}
+
 void MediaCodec::onOutputBufferAvailable() {
     int32_t index;
     while ((index = dequeuePortBuffer(kPortIndexOutput)) >= 0) {
@@ -19,6 +19,7 @@
 #include <utils/Log.h>
 
 #include <binder/IServiceManager.h>
+#include <binder/Parcel.h>
 
 #include <media/IMediaCodecList.h>
 #include <media/IMediaPlayerService.h>
@@ -37,7 +38,10 @@
 #include <media/stagefright/OmxInfoBuilder.h>
 #include <media/stagefright/PersistentSurface.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <utils/threads.h>
 
 #include <cutils/properties.h>
@@ -81,6 +85,37 @@ bool isProfilingNeeded() {
     return profilingNeeded;
 }
 
+constexpr const char* kCodecListCache = "/data/misc/media/media_codecs_cache.bin";
+constexpr int32_t kCodecListCacheVersion = 1;
+
+bool isCodecListCacheEnabled() {
+    return property_get_bool("debug.stagefright.codeclist-cache", true);
+}
+
+// Identifies everything the cached list was built from. The cache is discarded whenever any of
+// the system or vendor builds or the media APEXes change.
+AString getCodecListCacheKey() {
+    AString key;
+    char val[PROPERTY_VALUE_MAX];
+    for (const char *prop : { "ro.build.fingerprint", "ro.vendor.build.fingerprint" }) {
+        property_get(prop, val, "");
+        key.append(val);
+        key.append(";");
+    }
+    for (const char *manifest : { "/apex/com.android.media/apex_manifest.pb",
+                                  "/apex/com.android.media.swcodec/apex_manifest.pb" }) {
+        struct stat st;
+        if (stat(manifest, &st) == 0) {
+            key.append(AStringPrintf("%lld.%lld;",
+                    (long long)st.st_mtime, (long long)st.st_size));
+        } else {
+            key.append("-;");
+        }
+    }
+    key.append(property_get_bool("debug.stagefright.dedupe-codecs", true) ? "1" : "0");
+    return key;
+}
+
 OmxInfoBuilder sOmxInfoBuilder{true /* allowSurfaceEncoders */};
 OmxInfoBuilder sOmxNoSurfaceEncoderInfoBuilder{false /* allowSurfaceEncoders */};
 
@@ -136,6 +171,9 @@ void *MediaCodecList::profilerThreadWrapper(void * /*arg*/) {
         ALOGW("Failed to parse profiling results.");
         return nullptr;
     }
+    if (isCodecListCacheEnabled()) {
+        codecList->writeToCache(kCodecListCache);
+    }
 
     {
         Mutex::Autolock autoLock(sInitMutex);
@@ -149,11 +187,22 @@ sp<IMediaCodecList> MediaCodecList::getLocalInstance() {
     Mutex::Autolock autoLock(sInitMutex);
 
     if (sCodecList == nullptr) {
+        bool profilingNeeded = isProfilingNeeded();
+        bool useCache = isCodecListCacheEnabled();
+        if (useCache && !profilingNeeded) {
+            sCodecList = FromCache(kCodecListCache);
+            if (sCodecList != nullptr) {
+                return sCodecList;
+            }
+        }
         MediaCodecList *codecList = new MediaCodecList(GetBuilders());
         if (codecList->initCheck() == OK) {
             sCodecList = codecList;
+            if (useCache) {
+                codecList->writeToCache(kCodecListCache);
+            }
 
-            if (isProfilingNeeded()) {
+            if (profilingNeeded) {
                 ALOGV("Codec profiling needed, will be run in separated thread.");
                 pthread_t profiler;
                 if (pthread_create(&profiler, nullptr, profilerThreadWrapper, nullptr) != 0) {
@@ -246,9 +295,95 @@ MediaCodecList::MediaCodecList(std::vector<MediaCodecListBuilderBase*> builders)
     }
 }
 
+MediaCodecList::MediaCodecList() {
+}
+
 MediaCodecList::~MediaCodecList() {
 }
 
+// static
+sp<MediaCodecList> MediaCodecList::FromCache(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    Parcel parcel;
+    parcel.setData(static_cast<const uint8_t *>(data), st.st_size);
+    munmap(data, st.st_size);
+
+    int32_t version = 0;
+    if (parcel.readInt32(&version) != OK || version != kCodecListCacheVersion) {
+        ALOGD("ignoring codec list cache of version %d", version);
+        return nullptr;
+    }
+    const char *key = parcel.readCString();
+    if (key == nullptr || getCodecListCacheKey() != key) {
+        ALOGD("ignoring stale codec list cache");
+        return nullptr;
+    }
+    sp<MediaCodecList> codecList = new MediaCodecList();
+    codecList->mGlobalSettings = AMessage::FromParcel(parcel);
+    int32_t count = 0;
+    if (codecList->mGlobalSettings == nullptr || parcel.readInt32(&count) != OK || count <= 0) {
+        ALOGW("corrupted codec list cache");
+        return nullptr;
+    }
+    for (int32_t i = 0; i < count; ++i) {
+        sp<MediaCodecInfo> info = MediaCodecInfo::FromParcel(parcel);
+        if (info == nullptr) {
+            ALOGW("corrupted codec list cache");
+            return nullptr;
+        }
+        codecList->mCodecInfos.push_back(info);
+    }
+    codecList->mInitCheck = OK;
+    ALOGV("loaded %d codecs from %s", count, path);
+    return codecList;
+}
+
+void MediaCodecList::writeToCache(const char *path) const {
+    Parcel parcel;
+    parcel.writeInt32(kCodecListCacheVersion);
+    parcel.writeCString(getCodecListCacheKey().c_str());
+    mGlobalSettings->writeToParcel(&parcel);
+    parcel.writeInt32(mCodecInfos.size());
+    for (const sp<MediaCodecInfo> &info : mCodecInfos) {
+        info->writeToParcel(&parcel);
+    }
+
+    // write to a temporary file and rename it so that readers never see a partial cache
+    AString tmpPath = AStringPrintf("%s.tmp", path);
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ALOGD("cannot create codec list cache %s: %s", tmpPath.c_str(), strerror(errno));
+        return;
+    }
+    const uint8_t *data = parcel.data();
+    size_t remaining = parcel.dataSize();
+    while (remaining > 0) {
+        ssize_t written = TEMP_FAILURE_RETRY(write(fd, data, remaining));
+        if (written <= 0) {
+            break;
+        }
+        data += written;
+        remaining -= written;
+    }
+    close(fd);
+    if (remaining > 0 || rename(tmpPath.c_str(), path) != 0) {
+        ALOGW("failed to write codec list cache %s", path);
+        unlink(tmpPath.c_str());
+    }
+}
+
 status_t MediaCodecList::initCheck() const {
     return mInitCheck;
 }
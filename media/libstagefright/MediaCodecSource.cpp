@@ -20,6 +20,7 @@
 
 #include <inttypes.h>
 
+#include <cutils/properties.h>
 #include <gui/IGraphicBufferProducer.h>
 #include <gui/Surface.h>
 #include <mediadrm/ICrypto.h>
@@ -52,6 +53,8 @@ const int kStopTimeoutUs = 300000; // allow 1 sec for shutting down encoder
 // allow maximum 1 sec for stop time offset. This limits the the delay in the
 // input source.
 const int kMaxStopTimeOffsetUs = 1000000;
+// Encoder output buffers that may be held by the reader at a time without a copy.
+const int32_t kDefaultMaxZeroCopyOutputs = 4;
 
 struct MediaCodecSource::Puller : public AHandler {
     explicit Puller(const sp<MediaSource> &source);
@@ -425,6 +428,17 @@ status_t MediaCodecSource::read(
 }
 
 void MediaCodecSource::signalBufferReturned(MediaBufferBase *buffer) {
+    {
+        Mutexed<std::map<MediaBufferBase *, ZeroCopyOutput>>::Locked outputs(mZeroCopyOutputs);
+        auto it = outputs->find(buffer);
+        if (it != outputs->end()) {
+            // mEncoder is only used on the looper thread.
+            sp<AMessage> msg = new AMessage(kWhatReleaseOutputBuffer, mReflector);
+            msg->setSize("index", it->second.mIndex);
+            msg->post();
+            outputs->erase(it);
+        }
+    }
     buffer->setObserver(0);
     buffer->release();
 }
@@ -481,6 +495,9 @@ MediaCodecSource::MediaCodecSource(
       mBatchSize(0){
     CHECK(mLooper != NULL);
 
+    mMaxZeroCopyOutputs = std::max(0, property_get_int32(
+            "media.stagefright.codecsource.max-zero-copy", kDefaultMaxZeroCopyOutputs));
+
     if (!(mFlags & FLAG_USE_SURFACE_INPUT)) {
         mPuller = new Puller(source);
     }
@@ -980,7 +997,19 @@ void MediaCodecSource::onMessageReceived(const sp<AMessage> &msg) {
                 break;
             }
 
-            MediaBuffer *mbuf = new MediaBuffer(outbuf->size());
+            MediaBuffer *mbuf = NULL;
+            {
+                Mutexed<std::map<MediaBufferBase *, ZeroCopyOutput>>::Locked outputs(
+                        mZeroCopyOutputs);
+                if (outputs->size() < mMaxZeroCopyOutputs) {
+                    mbuf = new MediaBuffer(outbuf->data(), outbuf->size());
+                    outputs->emplace(mbuf, ZeroCopyOutput{(size_t)index, outbuf});
+                }
+            }
+            const bool isZeroCopy = (mbuf != NULL);
+            if (!isZeroCopy) {
+                mbuf = new MediaBuffer(outbuf->size());
+            }
             sp<MetaData> meta = new MetaData(mbuf->meta_data());
             AVUtils::get()->setDeferRelease(meta);
 
@@ -1037,7 +1066,9 @@ void MediaCodecSource::onMessageReceived(const sp<AMessage> &msg) {
             if (flags & MediaCodec::BUFFER_FLAG_SYNCFRAME) {
                 mbuf->meta_data().setInt32(kKeyIsSyncFrame, true);
             }
-            memcpy(mbuf->data(), outbuf->data(), outbuf->size());
+            if (!isZeroCopy) {
+                memcpy(mbuf->data(), outbuf->data(), outbuf->size());
+            }
 
             {
                 Mutexed<Output>::Locked output(mOutput);
@@ -1045,7 +1076,9 @@ void MediaCodecSource::onMessageReceived(const sp<AMessage> &msg) {
                 output->mCond.signal();
             }
 
-            mEncoder->releaseOutputBuffer(index);
+            if (!isZeroCopy) {
+                mEncoder->releaseOutputBuffer(index);
+            }
        } else if (cbID == MediaCodec::CB_ERROR) {
             status_t err;
             CHECK(msg->findInt32("err", &err));
@@ -1059,6 +1092,16 @@ void MediaCodecSource::onMessageReceived(const sp<AMessage> &msg) {
        }
        break;
     }
+    case kWhatReleaseOutputBuffer:
+    {
+        size_t index;
+        CHECK(msg->findSize("index", &index));
+        // The encoder may be gone if the buffer was returned after the source stopped.
+        if (mEncoder != NULL) {
+            mEncoder->releaseOutputBuffer(index);
+        }
+        break;
+    }
     case kWhatStart:
     {
         sp<AReplyToken> replyID;
@@ -24,6 +24,7 @@
 #include <binder/PermissionCache.h>
 #include <binder/IServiceManager.h>
 #include <media/DataSource.h>
+#include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/InterfaceUtils.h>
 #include <media/stagefright/MediaExtractor.h>
 #include <media/stagefright/MediaExtractorFactory.h>
@@ -36,6 +37,11 @@
 
 #include <dirent.h>
 #include <dlfcn.h>
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 namespace android {
 
@@ -81,7 +87,7 @@ sp<IMediaExtractor> MediaExtractorFactory::CreateFromService(
     float confidence;
     sp<ExtractorPlugin> plugin;
     uint32_t creatorVersion = 0;
-    creator = sniff(source, &confidence, &meta, &freeMeta, plugin, &creatorVersion);
+    creator = sniff(source, mime, &confidence, &meta, &freeMeta, plugin, &creatorVersion);
     if (!creator) {
         ALOGV("FAILED to autodetect media content.");
         return NULL;
@@ -128,9 +134,109 @@ std::shared_ptr<std::list<sp<ExtractorPlugin>>> MediaExtractorFactory::gPlugins;
 bool MediaExtractorFactory::gPluginsRegistered = false;
 bool MediaExtractorFactory::gIgnoreVersion = false;
 
+// Serves reads of the start of the source from a buffer that is filled once,
+// so that the sniffers, which mostly all read the first few KB, do not each go
+// to the source (and through binder for the extractor service) for it.
+struct SniffCacheSource : public DataSource {
+    explicit SniffCacheSource(const sp<DataSource> &source)
+        : mSource(source), mCacheSize(0), mCacheFilled(false) {}
+
+    virtual status_t initCheck() const { return mSource->initCheck(); }
+
+    virtual ssize_t readAt(off64_t offset, void *data, size_t size) {
+        if (offset >= 0 && offset < (off64_t)sizeof(mCache)) {
+            fillCache();
+        }
+        if (offset < 0 || offset >= (off64_t)mCacheSize) {
+            return mSource->readAt(offset, data, size);
+        }
+
+        size_t cached = std::min(size, mCacheSize - (size_t)offset);
+        memcpy(data, mCache + offset, cached);
+        if (cached == size) {
+            return cached;
+        }
+        ssize_t n = mSource->readAt(offset + cached, (uint8_t *)data + cached, size - cached);
+        return n > 0 ? (ssize_t)(cached + n) : (ssize_t)cached;
+    }
+
+    virtual status_t getSize(off64_t *size) { return mSource->getSize(size); }
+    virtual uint32_t flags() { return mSource->flags(); }
+    virtual String8 toString() { return mSource->toString(); }
+    virtual String8 getUri() { return mSource->getUri(); }
+    virtual String8 getMIMEType() const { return mSource->getMIMEType(); }
+
+    // Returns the cached start of the source.
+    const uint8_t *prefix(size_t *size) {
+        fillCache();
+        *size = mCacheSize;
+        return mCache;
+    }
+
+private:
+    sp<DataSource> mSource;
+    uint8_t mCache[16384];
+    size_t mCacheSize;
+    bool mCacheFilled;
+
+    void fillCache() {
+        if (!mCacheFilled) {
+            ssize_t n = mSource->readAt(0, mCache, sizeof(mCache));
+            mCacheSize = n > 0 ? n : 0;
+            mCacheFilled = true;
+        }
+    }
+
+    DISALLOW_EVIL_CONSTRUCTORS(SniffCacheSource);
+};
+
+// Returns the file extension that the magic bytes at the start of the source
+// belong to, or NULL. This is only used to try the matching extractor first.
+static const char *extensionForMagic(const uint8_t *data, size_t size) {
+    if (size >= 8 && !memcmp(data + 4, "ftyp", 4)) {
+        return "mp4";
+    } else if (size >= 4 && !memcmp(data, "\x1a\x45\xdf\xa3", 4)) {
+        return "mkv";
+    } else if (size >= 4 && !memcmp(data, "OggS", 4)) {
+        return "ogg";
+    } else if (size >= 4 && !memcmp(data, "fLaC", 4)) {
+        return "flac";
+    } else if (size >= 12 && !memcmp(data, "RIFF", 4) && !memcmp(data + 8, "WAVE", 4)) {
+        return "wav";
+    } else if (size >= 4 && !memcmp(data, "MThd", 4)) {
+        return "mid";
+    } else if (size >= 5 && !memcmp(data, "#!AMR", 5)) {
+        return "amr";
+    } else if (size >= 4 && !memcmp(data, "\x00\x00\x01\xba", 4)) {
+        return "m2p";
+    } else if (size >= 188 * 2 + 1 && data[0] == 0x47 && data[188] == 0x47
+            && data[188 * 2] == 0x47) {
+        return "ts";
+    }
+    return NULL;
+}
+
+static bool pluginSupportsType(const sp<ExtractorPlugin> &plugin, const char *type) {
+    if (type == NULL || plugin->def.def_version != EXTRACTORDEF_VERSION_NDK_V2
+            || plugin->def.u.v3.supported_types == NULL) {
+        return false;
+    }
+    for (const char **t = plugin->def.u.v3.supported_types; *t != NULL; ++t) {
+        if (!strcasecmp(*t, type)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Confidence at or above which an extractor whose magic bytes were found at the
+// start of the source is taken without sniffing the remaining extractors. No
+// extractor claims a source that another recognizes by its magic with more.
+static const float kMagicMatchConfidence = 0.4f;
+
 // static
 void *MediaExtractorFactory::sniff(
-        const sp<DataSource> &source, float *confidence, void **meta,
+        const sp<DataSource> &source, const char *mime, float *confidence, void **meta,
         FreeMetaFunc *freeMeta, sp<ExtractorPlugin> &plugin, uint32_t *creatorVersion) {
     *confidence = 0.0f;
     *meta = nullptr;
@@ -144,20 +250,57 @@ void *MediaExtractorFactory::sniff(
         plugins = gPlugins;
     }
 
-    void *bestCreator = NULL;
+    sp<SniffCacheSource> cacheSource = new SniffCacheSource(source);
+
+    // Try the extractors in the order of what the content is likely to be:
+    // first the one the magic bytes belong to, then the ones for the file
+    // extension or MIME type hint, then the rest in registration order.
+    size_t prefixSize;
+    const uint8_t *prefix = cacheSource->prefix(&prefixSize);
+    const char *magicType = extensionForMagic(prefix, prefixSize);
+
+    String8 uri = source->getUri();
+    const char *uriType = NULL;
+    const char *path = uri.c_str();
+    const char *query = strpbrk(path, "?#");
+    String8 uriPath = query != NULL ? String8(path, query - path) : uri;
+    const char *dot = strrchr(uriPath.c_str(), '.');
+    if (dot != NULL && strchr(dot, '/') == NULL) {
+        uriType = dot + 1;
+    }
+
+    std::vector<std::pair<int, sp<ExtractorPlugin>>> ranked;
     for (auto it = plugins->begin(); it != plugins->end(); ++it) {
-        ALOGV("sniffing %s", (*it)->def.extractor_name);
+        int rank = 0;
+        if (pluginSupportsType(*it, magicType)) {
+            rank = 2;
+        } else if (pluginSupportsType(*it, uriType)
+                || pluginSupportsType(*it, mime)) {
+            rank = 1;
+        }
+        ranked.push_back(std::make_pair(rank, *it));
+    }
+    std::stable_sort(ranked.begin(), ranked.end(),
+            [](const std::pair<int, sp<ExtractorPlugin>> &a,
+               const std::pair<int, sp<ExtractorPlugin>> &b) {
+                return a.first > b.first;
+            });
+
+    void *bestCreator = NULL;
+    for (auto it = ranked.begin(); it != ranked.end(); ++it) {
+        const sp<ExtractorPlugin> &curPlugin = it->second;
+        ALOGV("sniffing %s", curPlugin->def.extractor_name);
         float newConfidence;
         void *newMeta = nullptr;
         FreeMetaFunc newFreeMeta = nullptr;
 
         void *curCreator = NULL;
-        if ((*it)->def.def_version == EXTRACTORDEF_VERSION_NDK_V1) {
-            curCreator = (void*) (*it)->def.u.v2.sniff(
-                    source->wrap(), &newConfidence, &newMeta, &newFreeMeta);
-        } else if ((*it)->def.def_version == EXTRACTORDEF_VERSION_NDK_V2) {
-            curCreator = (void*) (*it)->def.u.v3.sniff(
-                    source->wrap(), &newConfidence, &newMeta, &newFreeMeta);
+        if (curPlugin->def.def_version == EXTRACTORDEF_VERSION_NDK_V1) {
+            curCreator = (void*) curPlugin->def.u.v2.sniff(
+                    cacheSource->wrap(), &newConfidence, &newMeta, &newFreeMeta);
+        } else if (curPlugin->def.def_version == EXTRACTORDEF_VERSION_NDK_V2) {
+            curCreator = (void*) curPlugin->def.u.v3.sniff(
+                    cacheSource->wrap(), &newConfidence, &newMeta, &newFreeMeta);
         }
 
         if (curCreator) {
@@ -168,14 +311,20 @@ void *MediaExtractorFactory::sniff(
                 }
                 *meta = newMeta;
                 *freeMeta = newFreeMeta;
-                plugin = *it;
+                plugin = curPlugin;
                 bestCreator = curCreator;
-                *creatorVersion = (*it)->def.def_version;
+                *creatorVersion = curPlugin->def.def_version;
             } else {
                 if (newMeta != nullptr && newFreeMeta != nullptr) {
                     newFreeMeta(newMeta);
                 }
             }
+
+            if (it->first == 2 && newConfidence >= kMagicMatchConfidence) {
+                ALOGV("%s matched the magic bytes, not sniffing further",
+                        curPlugin->def.extractor_name);
+                break;
+            }
         }
     }
 
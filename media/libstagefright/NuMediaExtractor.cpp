@@ -731,6 +731,66 @@ status_t NuMediaExtractor::readSampleData(const sp<ABuffer> &buffer) {
     return err;
 }
 
+status_t NuMediaExtractor::readSamples(
+        uint8_t *buffer, size_t capacity,
+        SampleInfo *samples, size_t maxSamples, size_t *numSamples) {
+    Mutex::Autolock autoLock(mLock);
+
+    *numSamples = 0;
+    size_t offset = 0;
+    while (*numSamples < maxSamples) {
+        ssize_t minIndex = fetchAllTrackSamples();
+        if (minIndex < 0) {
+            // report the samples read so far, the error repeats on the next call
+            return *numSamples > 0 ? OK : (status_t)minIndex;
+        }
+
+        TrackInfo *info = &mSelectedTracks.editItemAt(minIndex);
+        auto it = info->mSamples.begin();
+        MediaBufferBase *mbuf = it->mBuffer;
+
+        uint32_t type;
+        const void *data;
+        size_t size;
+        if (mbuf->meta_data().findData(kKeyEncryptedSizes, &type, &data, &size)) {
+            return *numSamples > 0 ? OK : ERROR_UNSUPPORTED;
+        }
+
+        const size_t srclen = mbuf->range_length();
+        size_t sampleSize = srclen;
+        if (info->mTrackFlags & kIsVorbis) {
+            // Each sample's data is suffixed by the number of page samples
+            // or -1 if not available.
+            sampleSize += sizeof(int32_t);
+        }
+        if (capacity - offset < sampleSize) {
+            return *numSamples > 0 ? OK : -ENOMEM;
+        }
+
+        memcpy(buffer + offset, (const uint8_t *)mbuf->data() + mbuf->range_offset(), srclen);
+        if (info->mTrackFlags & kIsVorbis) {
+            int32_t numPageSamples;
+            if (!mbuf->meta_data().findInt32(kKeyValidSamples, &numPageSamples)) {
+                numPageSamples = -1;
+            }
+            memcpy(buffer + offset + srclen, &numPageSamples, sizeof(numPageSamples));
+        }
+
+        int32_t isSync;
+        SampleInfo &sample = samples[(*numSamples)++];
+        sample.mTrackIndex = info->mTrackIndex;
+        sample.mSampleTimeUs = it->mSampleTimeUs;
+        sample.mOffset = offset;
+        sample.mSize = sampleSize;
+        sample.mIsSync = mbuf->meta_data().findInt32(kKeyIsSyncFrame, &isSync) && isSync != 0;
+        offset += sampleSize;
+
+        mbuf->release();
+        info->mSamples.erase(it);
+    }
+    return OK;
+}
+
 status_t NuMediaExtractor::getSampleSize(size_t *sampleSize) {
     Mutex::Autolock autoLock(mLock);
 
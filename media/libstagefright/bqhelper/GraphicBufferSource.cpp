@@ -323,6 +323,8 @@ private:
 GraphicBufferSource::GraphicBufferSource() :
     mInitCheck(UNKNOWN_ERROR),
     mNumAvailableUnacquiredBuffers(0),
+    mNumPendingFrames(0),
+    mAsyncFrameIntake(false),
     mNumOutstandingAcquires(0),
     mEndOfStream(false),
     mEndOfStreamSent(false),
@@ -419,6 +421,7 @@ status_t GraphicBufferSource::start() {
     CHECK(!mExecuting);
     mExecuting = true;
     mLastDataspace = HAL_DATASPACE_UNKNOWN;
+    collectPendingFrames_l();
     ALOGV("clearing last dataSpace");
 
     // Start by loading up as many buffers as possible.  We want to do this,
@@ -447,16 +450,22 @@ status_t GraphicBufferSource::start() {
         submitEndOfInputStream_l();
     }
 
-    if (mFrameRepeatIntervalUs > 0LL && mLooper == NULL) {
+    if (mLooper == NULL) {
         mReflector = new AHandlerReflector<GraphicBufferSource>(this);
 
         mLooper = new ALooper;
         mLooper->registerHandler(mReflector);
         mLooper->start();
 
-        if (mLatestBuffer.mBuffer != nullptr) {
+        if (mFrameRepeatIntervalUs > 0LL && mLatestBuffer.mBuffer != nullptr) {
             queueFrameRepeat_l();
         }
+
+        // hand new frames to the looper from now on
+        if (mFrameAvailableMsg == NULL) {
+            mFrameAvailableMsg = new AMessage(kWhatFrameAvailable, mReflector);
+            mAsyncFrameIntake = true;
+        }
     }
 
     return OK;
@@ -479,6 +488,8 @@ status_t GraphicBufferSource::release(){
     sp<ALooper> looper;
     {
         Mutex::Autolock autoLock(mMutex);
+        mAsyncFrameIntake = false;
+        collectPendingFrames_l();
         looper = mLooper;
         if (mLooper != NULL) {
             mLooper->unregisterHandler(mReflector->id());
@@ -523,6 +534,7 @@ status_t GraphicBufferSource::onInputBufferAdded(codec_buffer_id bufferId) {
 status_t GraphicBufferSource::onInputBufferEmptied(codec_buffer_id bufferId, int fenceFd) {
     Mutex::Autolock autoLock(mMutex);
     FileDescriptor::Autoclose fence(fenceFd);
+    collectPendingFrames_l();
 
     ssize_t cbi = mSubmittedCodecBuffers.indexOfKey(bufferId);
     if (cbi < 0) {
@@ -1010,8 +1022,20 @@ status_t GraphicBufferSource::acquireBuffer_l(VideoBuffer *ab) {
 
 // BufferQueue::ConsumerListener callback
 void GraphicBufferSource::onFrameAvailable(const BufferItem& item __unused) {
+    if (mAsyncFrameIntake) {
+        // Post only for the first pending frame; the looper handles all pending frames at once.
+        if (mNumPendingFrames++ == 0) {
+            mFrameAvailableMsg->dup()->post();
+        }
+        return;
+    }
+
     Mutex::Autolock autoLock(mMutex);
+    collectPendingFrames_l();
+    onFrameAvailable_l();
+}
 
+void GraphicBufferSource::onFrameAvailable_l() {
     ALOGV("onFrameAvailable: executing=%d available=%zu+%d",
             mExecuting, mAvailableBuffers.size(), mNumAvailableUnacquiredBuffers);
     ++mNumAvailableUnacquiredBuffers;
@@ -1408,6 +1432,7 @@ status_t GraphicBufferSource::setColorAspects(int32_t aspectsPacked) {
 
 status_t GraphicBufferSource::signalEndOfInputStream() {
     Mutex::Autolock autoLock(mMutex);
+    collectPendingFrames_l();
     ALOGV("signalEndOfInputStream: executing=%d available=%zu+%d eos=%d",
             mExecuting, mAvailableBuffers.size(), mNumAvailableUnacquiredBuffers, mEndOfStream);
 
@@ -1461,6 +1486,16 @@ void GraphicBufferSource::onMessageReceived(const sp<AMessage> &msg) {
             break;
         }
 
+        case kWhatFrameAvailable:
+        {
+            Mutex::Autolock autoLock(mMutex);
+
+            for (int32_t numFrames = mNumPendingFrames.exchange(0); numFrames > 0; --numFrames) {
+                onFrameAvailable_l();
+            }
+            break;
+        }
+
         default:
             TRESPASS();
     }
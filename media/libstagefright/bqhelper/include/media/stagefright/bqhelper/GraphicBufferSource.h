@@ -18,6 +18,8 @@
 
 #define GRAPHIC_BUFFER_SOURCE_H_
 
+#include <atomic>
+
 #include <binder/Status.h>
 #include <utils/RefBase.h>
 
@@ -270,6 +272,22 @@ private:
     // we've been unable to acquire them due to our max acquire count
     int32_t mNumAvailableUnacquiredBuffers;
 
+    // Number of frames signaled by the producer that have not been handled yet. Once the looper
+    // is running, onFrameAvailable only counts the frame here and leaves acquiring, dropping and
+    // submitting it to the looper, so that the producer is not blocked on mMutex or the codec.
+    std::atomic<int32_t> mNumPendingFrames;
+    // whether onFrameAvailable hands frames to the looper (set once mFrameAvailableMsg exists)
+    std::atomic<bool> mAsyncFrameIntake;
+    sp<AMessage> mFrameAvailableMsg;
+
+    // Moves the pending frames to the available but unacquired frames.
+    void collectPendingFrames_l() {
+        mNumAvailableUnacquiredBuffers += mNumPendingFrames.exchange(0);
+    }
+
+    // Handles a frame signaled by the producer.
+    void onFrameAvailable_l();
+
     // Number of frames acquired from consumer (debug only)
     // (as in aquireBuffer called, and release needs to be called)
     int32_t mNumOutstandingAcquires;
@@ -400,6 +418,7 @@ private:
 
     enum {
         kWhatRepeatLastFrame,   ///< queue last frame for reencoding
+        kWhatFrameAvailable,    ///< handle frames signaled by the producer
     };
     enum {
         kRepeatLastFrameCount = 10,
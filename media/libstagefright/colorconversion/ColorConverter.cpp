@@ -21,6 +21,7 @@
 
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AUtils.h>
 #include <media/stagefright/foundation/ColorUtils.h>
 #include <media/stagefright/ColorConverter.h>
 #include <media/stagefright/MediaCodecConstants.h>
@@ -30,7 +31,10 @@
 #include "libyuv/convert_argb.h"
 #include "libyuv/planar_functions.h"
 #include "libyuv/video_common.h"
+#include <algorithm>
 #include <functional>
+#include <thread>
+#include <vector>
 #include <sys/time.h>
 
 #define USE_LIBYUV
@@ -39,11 +43,13 @@
 
 #if defined(__aarch64__) || defined(__ARM_NEON__)
 #define USE_NEON_Y410 1
+#define USE_NEON_P010 1
 #else
 #define USE_NEON_Y410 0
+#define USE_NEON_P010 0
 #endif
 
-#if USE_NEON_Y410
+#if USE_NEON_Y410 || USE_NEON_P010
 #include <arm_neon.h>
 #endif
 
@@ -203,6 +209,10 @@ const struct ColorConverter::Coeffs BT2020_FULL      = { 256, 377,  42, 146, 482
 const struct ColorConverter::Coeffs BT2020_LIMITED   = { 298, 430,  48, 167, 548 };
 const struct ColorConverter::Coeffs BT2020_LTD_10BIT = { 299, 431,  48, 167, 550 };
 
+// Frames at least this large are converted in bands on several threads.
+constexpr size_t kMinParallelConversionPixels = 1920 * 1080;
+constexpr size_t kMaxConversionThreads = 4;
+
 constexpr int CLIP_RANGE_MIN_8BIT = -294;
 constexpr int CLIP_RANGE_MAX_8BIT = 552;
 
@@ -375,6 +385,51 @@ status_t ColorConverter::convert(
         return ERROR_UNSUPPORTED;
     }
 
+    // Split large frames into horizontal bands and convert them in parallel. Bands start on
+    // even rows so that they also start on a chroma row.
+    const size_t numBands = std::min<size_t>(
+            kMaxConversionThreads, std::max(1u, std::thread::hardware_concurrency()));
+    if (src.cropWidth() * src.cropHeight() < kMinParallelConversionPixels || numBands < 2) {
+        return convertBand(src, dst);
+    }
+
+    // the clip tables are created lazily; do it before the workers use them
+    (void)initClip();
+    (void)initClip10Bit();
+
+    const size_t bandHeight = align(divUp(src.cropHeight(), numBands), 2);
+    std::vector<BitmapParams> srcBands, dstBands;
+    for (size_t top = 0; top < src.cropHeight(); top += bandHeight) {
+        const size_t height = std::min(bandHeight, src.cropHeight() - top);
+        srcBands.push_back(src);
+        srcBands.back().mCropTop += top;
+        srcBands.back().mCropBottom = srcBands.back().mCropTop + height - 1;
+        dstBands.push_back(dst);
+        dstBands.back().mCropTop += top;
+        dstBands.back().mCropBottom = dstBands.back().mCropTop + height - 1;
+    }
+
+    // the first band is converted on this thread
+    std::vector<status_t> results(srcBands.size(), OK);
+    std::vector<std::thread> workers;
+    for (size_t band = 1; band < srcBands.size(); ++band) {
+        workers.emplace_back([this, &srcBands, &dstBands, &results, band] {
+            results[band] = convertBand(srcBands[band], dstBands[band]);
+        });
+    }
+    results[0] = convertBand(srcBands[0], dstBands[0]);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    for (status_t result : results) {
+        if (result != OK) {
+            return result;
+        }
+    }
+    return OK;
+}
+
+status_t ColorConverter::convertBand(const BitmapParams &src, const BitmapParams &dst) {
     status_t err;
 
     switch ((int32_t)mSrcFormat) {
@@ -570,9 +625,6 @@ status_t ColorConverter::convertYUV420PlanarUseLibYUV(
         return convertYUV420Planar(src, dst);
     }
 
-    uint8_t *dst_ptr = (uint8_t *)dst.mBits
-        + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
-
     const uint8_t *src_y =
         (const uint8_t *)src.mBits + src.mCropTop * src.mStride + src.mCropLeft;
 
@@ -583,28 +635,39 @@ status_t ColorConverter::convertYUV420PlanarUseLibYUV(
     const uint8_t *src_v =
         src_u + (src.mStride / 2) * (src.mHeight / 2);
 
+    return convertI420UseLibYUV(src_y, src.mStride, src_u, src_v, src.mStride / 2,
+            src.cropWidth(), src.cropHeight(), dst);
+}
+
+status_t ColorConverter::convertI420UseLibYUV(
+        const uint8_t *src_y, size_t src_stride_y,
+        const uint8_t *src_u, const uint8_t *src_v, size_t src_stride_uv,
+        size_t width, size_t height, const BitmapParams &dst) {
+    uint8_t *dst_ptr = (uint8_t *)dst.mBits
+        + dst.mCropTop * dst.mStride + dst.mCropLeft * dst.mBpp;
+
     switch (mDstFormat) {
     case OMX_COLOR_Format16bitRGB565:
     {
         DECLARE_YUV2RGBFUNC(func, RGB565);
-        (*func)(src_y, src.mStride, src_u, src.mStride / 2, src_v, src.mStride / 2,
-                (uint8_t *)dst_ptr, dst.mStride, src.cropWidth(), src.cropHeight());
+        (*func)(src_y, src_stride_y, src_u, src_stride_uv, src_v, src_stride_uv,
+                (uint8_t *)dst_ptr, dst.mStride, width, height);
         break;
     }
 
     case OMX_COLOR_Format32BitRGBA8888:
     {
         DECLARE_YUV2RGBFUNC(func, ABGR);
-        (*func)(src_y, src.mStride, src_u, src.mStride / 2, src_v, src.mStride / 2,
-                (uint8_t *)dst_ptr, dst.mStride, src.cropWidth(), src.cropHeight());
+        (*func)(src_y, src_stride_y, src_u, src_stride_uv, src_v, src_stride_uv,
+                (uint8_t *)dst_ptr, dst.mStride, width, height);
         break;
     }
 
     case OMX_COLOR_Format32bitBGRA8888:
     {
         DECLARE_YUV2RGBFUNC(func, ARGB);
-        (*func)(src_y, src.mStride, src_u, src.mStride / 2, src_v, src.mStride / 2,
-                (uint8_t *)dst_ptr, dst.mStride, src.cropWidth(), src.cropHeight());
+        (*func)(src_y, src_stride_y, src_u, src_stride_uv, src_v, src_stride_uv,
+                (uint8_t *)dst_ptr, dst.mStride, width, height);
         break;
     }
 
@@ -852,7 +915,51 @@ status_t ColorConverter::convertYUV420Planar16(
         return convertYUV420Planar16ToY410(src, dst);
     }
 
+#ifdef USE_LIBYUV
+    return convertYUV420Planar16ToRGB(src, dst);
+#else
     return convertYUV420Planar(src, dst);
+#endif
+}
+
+status_t ColorConverter::convertYUV420Planar16ToRGB(
+        const BitmapParams &src, const BitmapParams &dst) {
+    // The 8-bit destinations only keep the 8 most significant bits, so reduce the source
+    // to 8-bit I420 first and use the same libyuv conversions as 8-bit sources. Color spaces
+    // libyuv does not support use our own conversion.
+    if (!mSrcColorSpace.isH420() && !mSrcColorSpace.isJ420() && !mSrcColorSpace.isI420()) {
+        return convertYUV420Planar(src, dst);
+    }
+
+    const size_t width = src.cropWidth();
+    const size_t height = src.cropHeight();
+    const size_t chromaWidth = (width + 1) / 2;
+    const size_t chromaHeight = (height + 1) / 2;
+    std::vector<uint8_t> planes(width * height + 2 * chromaWidth * chromaHeight);
+    uint8_t *dst_y = planes.data();
+    uint8_t *dst_u = dst_y + width * height;
+    uint8_t *dst_v = dst_u + chromaWidth * chromaHeight;
+
+    const uint8_t *src_y =
+        (const uint8_t *)src.mBits + src.mCropTop * src.mStride + src.mCropLeft * src.mBpp;
+
+    const uint8_t *src_u =
+        (const uint8_t *)src.mBits + src.mStride * src.mHeight
+        + (src.mCropTop / 2) * (src.mStride / 2) + (src.mCropLeft / 2) * src.mBpp;
+
+    const uint8_t *src_v =
+        src_u + (src.mStride / 2) * (src.mHeight / 2);
+
+    // a scale of 16384 shifts 10-bit samples right by 2
+    constexpr int kScale10To8 = 16384;
+    libyuv::Convert16To8Plane((const uint16_t *)src_y, src.mStride / 2, dst_y, width,
+            kScale10To8, width, height);
+    libyuv::Convert16To8Plane((const uint16_t *)src_u, src.mStride / 4, dst_u, chromaWidth,
+            kScale10To8, chromaWidth, chromaHeight);
+    libyuv::Convert16To8Plane((const uint16_t *)src_v, src.mStride / 4, dst_v, chromaWidth,
+            kScale10To8, chromaWidth, chromaHeight);
+
+    return convertI420UseLibYUV(dst_y, width, dst_u, dst_v, chromaWidth, width, height, dst);
 }
 
 status_t ColorConverter::convertYUVP010(
@@ -893,8 +1000,59 @@ status_t ColorConverter::convertYUVP010ToRGBA1010102(
             + src.mStride * src.mHeight
             + (src.mCropTop / 2) * src.mStride + src.mCropLeft * src.mBpp);
 
+#if USE_NEON_P010
+    const int32x4_t vc16 = vdupq_n_s32(_c16);
+    const int32x4_t v512 = vdupq_n_s32(512);
+    const int32x4_t v128 = vdupq_n_s32(128);
+    const int32x4_t vbu = vdupq_n_s32(_b_u);
+    const int32x4_t vneggu = vdupq_n_s32(_neg_g_u);
+    const int32x4_t vneggv = vdupq_n_s32(_neg_g_v);
+    const int32x4_t vrv = vdupq_n_s32(_r_v);
+    const int32x4_t vy = vdupq_n_s32(_y);
+    const int32x4_t vzero = vdupq_n_s32(0);
+    const int32x4_t vmax = vdupq_n_s32(1023);
+    const uint32x4_t valpha = vdupq_n_u32(3u << 30);
+#endif
+
     for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
+        size_t x = 0;
+#if USE_NEON_P010
+        // Same arithmetic as the scalar loop below, 8 pixels at a time. Shifting instead of
+        // dividing by 256 only differs for negative values, which are clipped to 0 either way.
+        uint32_t *dst_rgba = (uint32_t *)dst_ptr;
+        for (; x + 8 <= src.cropWidth(); x += 8) {
+            uint16x8_t y01234567 = vshrq_n_u16(vld1q_u16(src_y + x), 6);
+            uint16x4x2_t uv0123 = vld2_u16(src_uv + x);
+            int32x4_t u = vsubq_s32(
+                    vreinterpretq_s32_u32(vmovl_u16(vshr_n_u16(uv0123.val[0], 6))), v512);
+            int32x4_t v = vsubq_s32(
+                    vreinterpretq_s32_u32(vmovl_u16(vshr_n_u16(uv0123.val[1], 6))), v512);
+
+            // each chroma sample covers two horizontally adjacent pixels
+            int32x4x2_t u_b = vzipq_s32(vmulq_s32(u, vbu), vmulq_s32(u, vbu));
+            int32x4_t uv_g0123 = vmlaq_s32(vmulq_s32(u, vneggu), v, vneggv);
+            int32x4x2_t uv_g = vzipq_s32(uv_g0123, uv_g0123);
+            int32x4x2_t v_r = vzipq_s32(vmulq_s32(v, vrv), vmulq_s32(v, vrv));
+
+            int32x4_t ys[2] = {
+                vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(y01234567))), vc16),
+                vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(y01234567))), vc16),
+            };
+            for (int i = 0; i < 2; ++i) {
+                int32x4_t tmp = vmlaq_s32(v128, ys[i], vy);
+                uint32x4_t b = vreinterpretq_u32_s32(vminq_s32(vmaxq_s32(
+                        vshrq_n_s32(vaddq_s32(tmp, u_b.val[i]), 8), vzero), vmax));
+                uint32x4_t g = vreinterpretq_u32_s32(vminq_s32(vmaxq_s32(
+                        vshrq_n_s32(vaddq_s32(tmp, uv_g.val[i]), 8), vzero), vmax));
+                uint32x4_t r = vreinterpretq_u32_s32(vminq_s32(vmaxq_s32(
+                        vshrq_n_s32(vaddq_s32(tmp, v_r.val[i]), 8), vzero), vmax));
+                uint32x4_t rgba = vorrq_u32(vorrq_u32(r, vshlq_n_u32(g, 10)),
+                                            vorrq_u32(vshlq_n_u32(b, 20), valpha));
+                vst1q_u32(dst_rgba + x + i * 4, rgba);
+            }
+        }
+#endif
+        for (; x < src.cropWidth(); x += 2) {
             signed y1, y2, u, v;
             y1 = (src_y[x] >> 6) - _c16;
             y2 = (src_y[x + 1] >> 6) - _c16;
@@ -36,7 +36,7 @@ inline void initDstYUV(
         uint8_t **dst_y, uint8_t **dst_u, uint8_t **dst_v) {
     *dst_y = (uint8_t *)ycbcr.y + cropTop * ycbcr.ystride + cropLeft;
 
-    int32_t c_offset = (cropTop / 2) * ycbcr.cstride + cropLeft / 2;
+    int32_t c_offset = (cropTop / 2) * ycbcr.cstride + (cropLeft / 2) * ycbcr.chroma_step;
     *dst_v = (uint8_t *)ycbcr.cr + c_offset;
     *dst_u = (uint8_t *)ycbcr.cb + c_offset;
 }
@@ -47,6 +47,9 @@ SoftwareRenderer::SoftwareRenderer(
       mConverter(NULL),
       mYUVMode(None),
       mNativeWindow(nativeWindow),
+      mLockYCbCr(false),
+      mFlexibleSemiPlanar(
+              property_get_bool("debug.stagefright.swrender.flexible-yuv", false)),
       mWidth(0),
       mHeight(0),
       mStride(0),
@@ -130,9 +133,18 @@ void SoftwareRenderer::resetFormatIfChanged(
     // hardware has YUV12 and RGBA8888 support, so convert known formats
     {
         switch (mColorFormat) {
-            case OMX_COLOR_FormatYUV420Planar:
             case OMX_COLOR_FormatYUV420SemiPlanar:
             case OMX_TI_COLOR_FormatYUV420PackedSemiPlanar:
+            {
+                // Gralloc implementations commonly lay out flexible YUV as NV12, which takes
+                // semi-planar frames without splitting the chroma plane.
+                halFormat = mFlexibleSemiPlanar ?
+                        HAL_PIXEL_FORMAT_YCBCR_420_888 : HAL_PIXEL_FORMAT_YV12;
+                bufWidth = (mCropWidth + 1) & ~1;
+                bufHeight = (mCropHeight + 1) & ~1;
+                break;
+            }
+            case OMX_COLOR_FormatYUV420Planar:
             {
                 halFormat = HAL_PIXEL_FORMAT_YV12;
                 bufWidth = (mCropWidth + 1) & ~1;
@@ -177,6 +189,8 @@ void SoftwareRenderer::resetFormatIfChanged(
         }
     }
 
+    delete mConverter;
+    mConverter = NULL;
     if (halFormat == HAL_PIXEL_FORMAT_RGB_565) {
         mConverter = new ColorConverter(
                 mColorFormat, OMX_COLOR_Format16bitRGB565);
@@ -187,6 +201,12 @@ void SoftwareRenderer::resetFormatIfChanged(
         CHECK(mConverter->isValid());
     }
 
+    mLockYCbCr = !mConverter &&
+            (mColorFormat == OMX_COLOR_FormatYUV420Planar ||
+             mColorFormat == OMX_COLOR_FormatYUV420SemiPlanar ||
+             mColorFormat == OMX_TI_COLOR_FormatYUV420PackedSemiPlanar ||
+             mColorFormat == OMX_COLOR_FormatYUV420Planar16);
+
     CHECK(mNativeWindow != NULL);
     CHECK(mCropWidth > 0);
     CHECK(mCropHeight > 0);
@@ -252,7 +272,12 @@ void SoftwareRenderer::clearTracker() {
 std::list<FrameRenderTracker::Info> SoftwareRenderer::render(
         const void *data, size_t , int64_t mediaTimeUs, nsecs_t renderTimeNs,
         size_t numOutputBuffers, const sp<AMessage>& format) {
-    resetFormatIfChanged(format, numOutputBuffers);
+    // Buffers share their format object until the format changes.
+    const bool formatChanged = format != mFormat;
+    if (formatChanged) {
+        resetFormatIfChanged(format, numOutputBuffers);
+        mFormat = format;
+    }
     FrameRenderTracker::Info *info = NULL;
 
     ANativeWindowBuffer *buf;
@@ -276,11 +301,7 @@ std::list<FrameRenderTracker::Info> SoftwareRenderer::render(
 
     void *dst = NULL;
     struct android_ycbcr ycbcr;
-    if ( !mConverter &&
-         (mColorFormat == OMX_COLOR_FormatYUV420Planar ||
-         mColorFormat == OMX_COLOR_FormatYUV420SemiPlanar ||
-         mColorFormat == OMX_TI_COLOR_FormatYUV420PackedSemiPlanar ||
-         mColorFormat == OMX_COLOR_FormatYUV420Planar16)) {
+    if (mLockYCbCr) {
         CHECK_EQ(0, mapper.lockYCbCr(buf->handle,
                 GRALLOC_USAGE_SW_READ_NEVER | GRALLOC_USAGE_SW_WRITE_RARELY,
                 bounds, &ycbcr));
@@ -371,16 +392,27 @@ std::list<FrameRenderTracker::Info> SoftwareRenderer::render(
             dst_y += ycbcr.ystride;
         }
 
-        for (int y = 0; y < (mCropHeight + 1) / 2; ++y) {
-            size_t tmp = (mCropWidth + 1) / 2;
-            for (size_t x = 0; x < tmp; ++x) {
-                dst_u[x] = src_uv[2 * x];
-                dst_v[x] = src_uv[2 * x + 1];
+        const size_t chromaWidth = (mCropWidth + 1) / 2;
+        if (ycbcr.chroma_step == 2 && (uint8_t *)ycbcr.cr == (uint8_t *)ycbcr.cb + 1) {
+            // The window buffer is semi-planar with Cb first, like the frame.
+            for (int y = 0; y < (mCropHeight + 1) / 2; ++y) {
+                memcpy(dst_u, src_uv, chromaWidth * 2);
+
+                src_uv += mWidth;
+                dst_u += ycbcr.cstride;
             }
+        } else {
+            const size_t chromaStep = ycbcr.chroma_step;
+            for (int y = 0; y < (mCropHeight + 1) / 2; ++y) {
+                for (size_t x = 0; x < chromaWidth; ++x) {
+                    dst_u[x * chromaStep] = src_uv[2 * x];
+                    dst_v[x * chromaStep] = src_uv[2 * x + 1];
+                }
 
-            src_uv += mWidth;
-            dst_u += ycbcr.cstride;
-            dst_v += ycbcr.cstride;
+                src_uv += mWidth;
+                dst_u += ycbcr.cstride;
+                dst_v += ycbcr.cstride;
+            }
         }
     } else if (mColorFormat == OMX_COLOR_Format24bitRGB888) {
         uint8_t* srcPtr = (uint8_t*)data + mWidth * mCropTop * 3 + mCropLeft * 3;
@@ -431,7 +463,9 @@ skip_copying:
     // TODO: propagate color aspects to software renderer to allow better
     // color conversion to RGB. For now, just mark dataspace for YUV rendering.
     android_dataspace dataSpace;
-    if (format->findInt32("android._dataspace", (int32_t *)&dataSpace) && dataSpace != mDataSpace) {
+    if (formatChanged
+            && format->findInt32("android._dataspace", (int32_t *)&dataSpace)
+            && dataSpace != mDataSpace) {
         mDataSpace = dataSpace;
 
         if (mConverter != NULL && mConverter->isDstRGB()) {
@@ -446,7 +480,7 @@ skip_copying:
             ALOGW("failed to set dataspace on surface (%d)", err);
         }
     }
-    if (format->contains("hdr-static-info")) {
+    if (formatChanged && format->contains("hdr-static-info")) {
         HDRStaticInfo info;
         if (ColorUtils::getHDRStaticInfoFromFormat(format, &info)
             && memcmp(&mHDRStaticInfo, &info, sizeof(info))) {
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <log/log.h>
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/MediaCodecConstants.h>
+#include <media/stagefright/foundation/ColorUtils.h>
+
+using android::ColorConverter;
+using android::ColorUtils;
+
+struct Conversion {
+    OMX_COLOR_FORMATTYPE src;
+    OMX_COLOR_FORMATTYPE dst;
+    const char *name;
+};
+
+// Every 10-bit source and destination pair that ColorConverter supports.
+static const Conversion kConversions[] = {
+    {OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_FormatYUV444Y410, "I010->Y410"},
+    {OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_Format16bitRGB565, "I010->RGB565"},
+    {OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_Format32BitRGBA8888, "I010->RGBA8888"},
+    {OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_Format32bitBGRA8888, "I010->BGRA8888"},
+    {(OMX_COLOR_FORMATTYPE)COLOR_FormatYUVP010,
+     (OMX_COLOR_FORMATTYPE)COLOR_Format32bitABGR2101010, "P010->RGBA1010102"},
+};
+
+static const uint32_t kStandards[] = {
+    ColorUtils::kColorStandardBT601_625,
+    ColorUtils::kColorStandardBT709,
+    ColorUtils::kColorStandardBT2020,
+};
+
+static constexpr size_t kWidth = 1920;
+static constexpr size_t kHeight = 1080;
+
+/*
+$ adb shell /data/benchmarktest/colorconverter_benchmark/colorconverter_benchmark
+
+BM_ColorConverter/<conversion index>/<standard index>, converting a limited range 1080p frame.
+*/
+
+static size_t getBytesPerPixel(OMX_COLOR_FORMATTYPE format) {
+    switch ((int32_t)format) {
+        case OMX_COLOR_Format16bitRGB565:
+            return 2;
+        case OMX_COLOR_Format32BitRGBA8888:
+        case OMX_COLOR_Format32bitBGRA8888:
+        case COLOR_Format32bitABGR2101010:
+        case OMX_COLOR_FormatYUV444Y410:
+            return 4;
+        default:
+            return 2;  // 16-bit YUV samples
+    }
+}
+
+static void BM_ColorConverter(benchmark::State& state) {
+    const Conversion &conversion = kConversions[state.range(0)];
+    const uint32_t standard = kStandards[state.range(1)];
+
+    ColorConverter converter(conversion.src, conversion.dst);
+    if (!converter.isValid()) {
+        state.SkipWithError("conversion not supported");
+        return;
+    }
+    converter.setSrcColorSpace(standard, ColorUtils::kColorRangeLimited,
+                               ColorUtils::kColorTransferST2084);
+
+    // 10-bit samples, MSB aligned for P010 and LSB aligned for I010.
+    const bool msbAligned = conversion.src == (OMX_COLOR_FORMATTYPE)COLOR_FormatYUVP010;
+    std::minstd_rand gen(state.range(0));
+    std::uniform_int_distribution<uint16_t> dis(64, 940);
+    std::vector<uint16_t> input(kWidth * kHeight * 3 / 2);
+    for (uint16_t &sample : input) {
+        sample = msbAligned ? dis(gen) << 6 : dis(gen);
+    }
+    const size_t dstStride = kWidth * getBytesPerPixel(conversion.dst);
+    std::vector<uint8_t> output(dstStride * kHeight);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(input.data());
+        benchmark::DoNotOptimize(output.data());
+
+        if (android::status_t status = converter.convert(
+                input.data(), kWidth, kHeight, kWidth * 2, 0, 0, kWidth - 1, kHeight - 1,
+                output.data(), kWidth, kHeight, dstStride, 0, 0, kWidth - 1, kHeight - 1);
+            status != android::OK) {
+            state.SkipWithError("convert returned an error");
+            return;
+        }
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+    state.SetLabel(std::string(conversion.name) + " "
+            + asString((ColorUtils::ColorStandard)standard));
+}
+
+static void ColorConverterArgs(benchmark::internal::Benchmark* b) {
+    for (int i = 0; i < (int)std::size(kConversions); i++) {
+        for (int j = 0; j < (int)std::size(kStandards); j++) {
+            b->Args({i, j});
+        }
+    }
+}
+
+BENCHMARK(BM_ColorConverter)->Apply(ColorConverterArgs);
+
+BENCHMARK_MAIN();
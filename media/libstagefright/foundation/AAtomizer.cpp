@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <string.h>
 #include <sys/types.h>
 
 #include "AAtomizer.h"
@@ -25,20 +26,40 @@ AAtomizer AAtomizer::gAtomizer;
 
 // static
 const char *AAtomizer::Atomize(const char *name) {
-    return gAtomizer.atomize(name);
+    return gAtomizer.atomize(name, Hash(name), false /* bounded */);
 }
 
-AAtomizer::AAtomizer() {
-    for (size_t i = 0; i < 128; ++i) {
+// static
+const char *AAtomizer::TryAtomize(const char *name) {
+    // Atoms are never freed, so they can be cached without holding mLock. The cache avoids
+    // contending for mLock when many threads look up the same few names.
+    static thread_local const char *sCache[kNumCachedAtoms];
+
+    const uint32_t hash = Hash(name);
+    const char *&cached = sCache[hash % kNumCachedAtoms];
+    if (cached != NULL && !strcmp(cached, name)) {
+        return cached;
+    }
+
+    const char *atom = gAtomizer.atomize(name, hash, true /* bounded */);
+    if (atom != NULL) {
+        cached = atom;
+    }
+    return atom;
+}
+
+AAtomizer::AAtomizer()
+    : mNumAtoms(0) {
+    for (size_t i = 0; i < kNumBuckets; ++i) {
         mAtoms.push(List<AString>());
     }
 }
 
-const char *AAtomizer::atomize(const char *name) {
+const char *AAtomizer::atomize(const char *name, uint32_t hash, bool bounded) {
     Mutex::Autolock autoLock(mLock);
 
     const size_t n = mAtoms.size();
-    size_t index = AAtomizer::Hash(name) % n;
+    size_t index = hash % n;
     List<AString> &entry = mAtoms.editItemAt(index);
     List<AString>::iterator it = entry.begin();
     while (it != entry.end()) {
@@ -48,12 +69,18 @@ const char *AAtomizer::atomize(const char *name) {
         ++it;
     }
 
+    if (bounded && mNumAtoms >= kMaxNumAtoms) {
+        return NULL;
+    }
+
     entry.push_back(AString(name));
+    ++mNumAtoms;
 
     return (*--entry.end()).c_str();
 }
 
 // static
+__attribute__((no_sanitize("integer")))
 uint32_t AAtomizer::Hash(const char *s) {
     uint32_t sum = 0;
     while (*s != '\0') {
@@ -23,19 +23,74 @@
 
 namespace android {
 
-void AHandler::deliverMessage(const sp<AMessage> &msg) {
+// static
+size_t AHandler::getLatencyBucket(int64_t latencyUs) {
+    size_t bucket = 0;
+    for (int64_t limitUs = 100; latencyUs >= limitUs && bucket + 1 < kNumLatencyBuckets;
+            limitUs *= 10) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+void AHandler::deliverMessage(const sp<AMessage> &msg, int64_t whenUs) {
+    if (!mVerboseStats) {
+        onMessageReceived(msg);
+        mMessageCounter++;
+        return;
+    }
+
+    int64_t startUs = ALooper::GetNowUs();
     onMessageReceived(msg);
+    int64_t endUs = ALooper::GetNowUs();
     mMessageCounter++;
 
-    if (mVerboseStats) {
-        uint32_t what = msg->what();
-        ssize_t idx = mMessages.indexOfKey(what);
-        if (idx < 0) {
-            mMessages.add(what, 1);
-        } else {
-            mMessages.editValueAt(idx)++;
+    recordMessageStats(msg->what(), startUs - whenUs, endUs - startUs);
+}
+
+void AHandler::recordMessageStats(
+        uint32_t what, int64_t queueDelayUs, int64_t handlingTimeUs) {
+    // Messages posted before the clock was read by the looper can appear slightly early.
+    queueDelayUs = queueDelayUs < 0 ? 0 : queueDelayUs;
+
+    Mutex::Autolock autoLock(mStatsLock);
+    ssize_t idx = mMessages.indexOfKey(what);
+    if (idx < 0) {
+        MessageStats stats = {};
+        idx = mMessages.add(what, stats);
+    }
+    MessageStats &stats = mMessages.editValueAt(idx);
+    stats.mCount++;
+    stats.mQueueDelayHist[getLatencyBucket(queueDelayUs)]++;
+    stats.mHandlingTimeHist[getLatencyBucket(handlingTimeUs)]++;
+    if (queueDelayUs > stats.mMaxQueueDelayUs) {
+        stats.mMaxQueueDelayUs = queueDelayUs;
+    }
+    if (handlingTimeUs > stats.mMaxHandlingTimeUs) {
+        stats.mMaxHandlingTimeUs = handlingTimeUs;
+    }
+    stats.mTotalHandlingTimeUs += handlingTimeUs;
+}
+
+bool AHandler::getLatencyStats(LatencyStats *stats) const {
+    if (!mVerboseStats) {
+        return false;
+    }
+
+    Mutex::Autolock autoLock(mStatsLock);
+    *stats = {};
+    for (size_t i = 0; i < mMessages.size(); i++) {
+        const MessageStats &msgStats = mMessages.valueAt(i);
+        stats->mNumMessages += msgStats.mCount;
+        if (msgStats.mMaxQueueDelayUs > stats->mMaxQueueDelayUs) {
+            stats->mMaxQueueDelayUs = msgStats.mMaxQueueDelayUs;
+        }
+        if (msgStats.mMaxHandlingTimeUs > stats->mMaxHandlingTimeUs) {
+            stats->mMaxHandlingTimeUs = msgStats.mMaxHandlingTimeUs;
         }
+        stats->mTotalHandlingTimeUs += msgStats.mTotalHandlingTimeUs;
     }
+    return stats->mNumMessages > 0;
 }
 
 }  // namespace android
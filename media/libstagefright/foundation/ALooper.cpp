@@ -70,7 +70,10 @@ int64_t ALooper::GetNowUs() {
 }
 
 ALooper::ALooper()
-    : mRunningLocally(false) {
+    : mPostedEvents(nullptr),
+      mReadyEvents(nullptr),
+      mReadyEventsTail(nullptr),
+      mRunningLocally(false) {
     // clean up stale AHandlers. Doing it here instead of in the destructor avoids
     // the side effect of objects being deleted from the unregister function recursively.
     gLooperRoster.unregisterStaleHandlers();
@@ -78,6 +81,17 @@ ALooper::ALooper()
 
 ALooper::~ALooper() {
     stop();
+
+    {
+        Mutex::Autolock autoLock(mLock);
+        collectPostedEvents_l();
+        while (mReadyEvents != nullptr) {
+            PostedEvent *event = mReadyEvents;
+            mReadyEvents = event->mNext;
+            delete event;
+        }
+        mReadyEventsTail = nullptr;
+    }
     // stale AHandlers are now cleaned up in the constructor of the next ALooper to come along
 }
 
@@ -166,6 +180,29 @@ status_t ALooper::stop() {
 }
 
 void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
+    if (delayUs <= 0) {
+        // Most messages are posted for immediate delivery, so don't make them contend for mLock
+        // with the looper and other posting threads.
+        PostedEvent *event = new PostedEvent;
+        event->mWhenUs = GetNowUs();
+        event->mMessage = msg;
+
+        PostedEvent *head = mPostedEvents.load(std::memory_order_relaxed);
+        do {
+            event->mNext = head;
+        } while (!mPostedEvents.compare_exchange_weak(
+                head, event, std::memory_order_release, std::memory_order_relaxed));
+
+        // The looper collects posted events with mLock held before it waits, so it can only be
+        // waiting for this event if the list was empty. Taking mLock to signal makes sure the
+        // looper either sees the event or is already waiting.
+        if (head == nullptr) {
+            Mutex::Autolock autoLock(mLock);
+            mQueueChangedCondition.signal();
+        }
+        return;
+    }
+
     Mutex::Autolock autoLock(mLock);
 
     int64_t whenUs;
@@ -193,6 +230,30 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
     mEventQueue.insert(it, event);
 }
 
+void ALooper::collectPostedEvents_l() {
+    PostedEvent *posted = mPostedEvents.exchange(nullptr, std::memory_order_acquire);
+    if (posted == nullptr) {
+        return;
+    }
+
+    // The posted list is newest first, reverse it before appending to the ready list.
+    PostedEvent *reversed = nullptr;
+    PostedEvent *tail = posted;
+    while (posted != nullptr) {
+        PostedEvent *next = posted->mNext;
+        posted->mNext = reversed;
+        reversed = posted;
+        posted = next;
+    }
+
+    if (mReadyEventsTail == nullptr) {
+        mReadyEvents = reversed;
+    } else {
+        mReadyEventsTail->mNext = reversed;
+    }
+    mReadyEventsTail = tail;
+}
+
 bool ALooper::loop() {
     Event event;
 
@@ -201,28 +262,44 @@ bool ALooper::loop() {
         if (mThread == NULL && !mRunningLocally) {
             return false;
         }
-        if (mEventQueue.empty()) {
-            mQueueChangedCondition.wait(mLock);
-            return true;
-        }
-        int64_t whenUs = (*mEventQueue.begin()).mWhenUs;
-        int64_t nowUs = GetNowUs();
+        collectPostedEvents_l();
+
+        // Ready events are always due, but delayed events that became due at or before the
+        // time a ready event was posted are delivered first.
+        if (mReadyEvents != nullptr &&
+                (mEventQueue.empty() || (*mEventQueue.begin()).mWhenUs > mReadyEvents->mWhenUs)) {
+            PostedEvent *ready = mReadyEvents;
+            mReadyEvents = ready->mNext;
+            if (mReadyEvents == nullptr) {
+                mReadyEventsTail = nullptr;
+            }
+            event.mWhenUs = ready->mWhenUs;
+            event.mMessage = std::move(ready->mMessage);
+            delete ready;
+        } else {
+            if (mEventQueue.empty()) {
+                mQueueChangedCondition.wait(mLock);
+                return true;
+            }
+            int64_t whenUs = (*mEventQueue.begin()).mWhenUs;
+            int64_t nowUs = GetNowUs();
+
+            if (whenUs > nowUs) {
+                int64_t delayUs = whenUs - nowUs;
+                if (delayUs > INT64_MAX / 1000) {
+                    delayUs = INT64_MAX / 1000;
+                }
+                mQueueChangedCondition.waitRelative(mLock, delayUs * 1000ll);
 
-        if (whenUs > nowUs) {
-            int64_t delayUs = whenUs - nowUs;
-            if (delayUs > INT64_MAX / 1000) {
-                delayUs = INT64_MAX / 1000;
+                return true;
             }
-            mQueueChangedCondition.waitRelative(mLock, delayUs * 1000ll);
 
-            return true;
+            event = *mEventQueue.begin();
+            mEventQueue.erase(mEventQueue.begin());
         }
-
-        event = *mEventQueue.begin();
-        mEventQueue.erase(mEventQueue.begin());
     }
 
-    event.mMessage->deliver();
+    event.mMessage->deliver(event.mWhenUs);
 
     // NOTE: It's important to note that at this point our "ALooper" object
     // may no longer exist (its final reference may have gone away while
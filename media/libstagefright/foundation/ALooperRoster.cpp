@@ -114,6 +114,27 @@ static void makeFourCC(uint32_t fourcc, char *s, size_t bufsz) {
     }
 }
 
+static void appendHistogram(String8 &s, const uint32_t *hist, size_t numBuckets) {
+    for (size_t i = 0; i < numBuckets; i++) {
+        s.appendFormat("%s%u", i == 0 ? "" : "/", hist[i]);
+    }
+}
+
+// static
+void ALooperRoster::appendMessageStats(
+        String8 &s, const char *what, const AHandler::MessageStats &stats) {
+    s.appendFormat("\n    %s: %u, handling avg %.2fms max %.2fms, queue delay max %.2fms",
+            what,
+            stats.mCount,
+            stats.mCount > 0 ? stats.mTotalHandlingTimeUs / 1000.0 / stats.mCount : 0.0,
+            stats.mMaxHandlingTimeUs / 1000.0,
+            stats.mMaxQueueDelayUs / 1000.0);
+    s.append("\n      handling hist ");
+    appendHistogram(s, stats.mHandlingTimeHist, AHandler::kNumLatencyBuckets);
+    s.append(", queue delay hist ");
+    appendHistogram(s, stats.mQueueDelayHist, AHandler::kNumLatencyBuckets);
+}
+
 void ALooperRoster::dump(int fd, const Vector<String16>& args) {
     bool clear = false;
     bool oldVerbose = verboseStats;
@@ -145,13 +166,12 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
             if (handler != NULL) {
                 handler->mVerboseStats = verboseStats;
                 s.appendFormat(": %" PRIu64 " messages processed", handler->mMessageCounter);
+                Mutex::Autolock statsLock(handler->mStatsLock);
                 if (verboseStats) {
                     for (size_t j = 0; j < handler->mMessages.size(); j++) {
                         char fourcc[15];
                         makeFourCC(handler->mMessages.keyAt(j), fourcc, sizeof(fourcc));
-                        s.appendFormat("\n    %s: %u",
-                                fourcc,
-                                handler->mMessages.valueAt(j));
+                        appendMessageStats(s, fourcc, handler->mMessages.valueAt(j));
                     }
                 } else {
                     handler->mMessages.clear();
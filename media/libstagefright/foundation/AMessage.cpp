@@ -41,6 +41,78 @@ namespace android {
 
 extern ALooperRoster gLooperRoster;
 
+// Longer item names are copied instead of interned.
+static constexpr size_t kMaxAtomNameLength = 64;
+
+// Messages are mostly created and released on looper threads, so freed messages are kept in a
+// per-thread cache and reused by the next allocation on that thread. The cache is disabled with
+// address sanitizers so that use-after-free of messages is still detected.
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(hwaddress_sanitizer)
+#define AMESSAGE_NO_POOL
+#endif
+#endif
+
+#ifndef AMESSAGE_NO_POOL
+namespace {
+
+struct MessagePool {
+    enum {
+        kMaxNumFree = 64,
+    };
+
+    struct FreeBlock {
+        FreeBlock *mNext;
+    };
+
+    FreeBlock *mHead = nullptr;
+    size_t mNumFree = 0;
+
+    ~MessagePool() {
+        while (mHead != nullptr) {
+            FreeBlock *block = mHead;
+            mHead = block->mNext;
+            ::operator delete(block);
+        }
+        // Messages released later during thread exit go straight to the heap.
+        mNumFree = kMaxNumFree;
+    }
+};
+
+thread_local MessagePool gMessagePool;
+
+}  // namespace
+#endif
+
+// static
+void *AMessage::operator new(size_t size) {
+#ifndef AMESSAGE_NO_POOL
+    MessagePool &pool = gMessagePool;
+    if (size == sizeof(AMessage) && pool.mHead != nullptr) {
+        MessagePool::FreeBlock *block = pool.mHead;
+        pool.mHead = block->mNext;
+        --pool.mNumFree;
+        return block;
+    }
+#endif
+    return ::operator new(size);
+}
+
+// static
+void AMessage::operator delete(void *ptr, size_t size) {
+#ifndef AMESSAGE_NO_POOL
+    MessagePool &pool = gMessagePool;
+    if (ptr != nullptr && size == sizeof(AMessage) && pool.mNumFree < MessagePool::kMaxNumFree) {
+        MessagePool::FreeBlock *block = static_cast<MessagePool::FreeBlock *>(ptr);
+        block->mNext = pool.mHead;
+        pool.mHead = block;
+        ++pool.mNumFree;
+        return;
+    }
+#endif
+    ::operator delete(ptr);
+}
+
 status_t AReplyToken::setReply(const sp<AMessage> &reply) {
     if (mReplied) {
         ALOGE("trying to post a duplicate reply");
@@ -89,8 +161,7 @@ void AMessage::setTarget(const sp<const AHandler> &handler) {
 void AMessage::clear() {
     // Item needs to be handled delicately
     for (Item &item : mItems) {
-        delete[] item.mName;
-        item.mName = NULL;
+        item.freeName();
         freeItemValue(&item);
     }
     mItems.clear();
@@ -156,6 +227,10 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
 #endif
     size_t i = 0;
     for (; i < mItems.size(); i++) {
+        if (mItems[i].mName == name) {
+            // |name| is the atom of this item.
+            break;
+        }
         if (len != mItems[i].mNameLength) {
             continue;
         }
@@ -182,8 +257,21 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
 // assumes item's name was uninitialized or NULL
 void AMessage::Item::setName(const char *name, size_t len) {
     mNameLength = len;
-    mName = new char[len + 1];
-    memcpy((void*)mName, name, len + 1);
+    // Names can come from other processes, so fall back to a copy if the atom table is full.
+    mName = (len <= kMaxAtomNameLength) ? AAtomizer::TryAtomize(name) : nullptr;
+    mNameIsAtom = (mName != nullptr);
+    if (!mNameIsAtom) {
+        mName = new char[len + 1];
+        memcpy((void*)mName, name, len + 1);
+    }
+}
+
+void AMessage::Item::freeName() {
+    if (!mNameIsAtom) {
+        delete[] mName;
+    }
+    mName = nullptr;
+    mNameIsAtom = false;
 }
 
 AMessage::Item::Item(const char *name, size_t len)
@@ -202,6 +290,9 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
         freeItemValue(item);
     } else {
         CHECK(mItems.size() < kMaxNumItems);
+        if (mItems.capacity() < kInitialNumItems) {
+            mItems.reserve(kInitialNumItems);
+        }
         i = mItems.size();
         // place a 'blank' item at the end - this is of type kTypeInt32
         mItems.emplace_back(name, len);
@@ -409,14 +500,14 @@ bool AMessage::findRect(
     return true;
 }
 
-void AMessage::deliver() {
+void AMessage::deliver(int64_t whenUs) {
     sp<AHandler> handler = mHandler.promote();
     if (handler == NULL) {
         ALOGW("failed to deliver message as target handler %d is gone.", mTarget);
         return;
     }
 
-    handler->deliverMessage(this);
+    handler->deliverMessage(this, whenUs);
 }
 
 status_t AMessage::post(int64_t delayUs) {
@@ -494,7 +585,10 @@ sp<AMessage> AMessage::dup() const {
         const Item *from = &mItems[i];
         Item *to = &msg->mItems[i];
 
-        to->setName(from->mName, from->mNameLength);
+        // Atoms are shared, only copied names need a new copy.
+        if (!from->mNameIsAtom) {
+            to->setName(from->mName, from->mNameLength);
+        }
         to->mType = from->mType;
 
         switch (from->mType) {
@@ -1010,8 +1104,7 @@ status_t AMessage::setEntryNameAt(size_t index, const char *name) {
     if (findItemIndex(name, len) < mItems.size()) {
         return ALREADY_EXISTS;
     }
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].freeName();
     mItems[index].setName(name, len);
     return OK;
 }
@@ -1075,8 +1168,7 @@ status_t AMessage::removeEntryAt(size_t index) {
         return BAD_INDEX;
     }
     // delete entry data and objects
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].freeName();
     freeItemValue(&mItems[index]);
 
     // swap entry with last entry and clear last entry's data
@@ -1084,6 +1176,7 @@ status_t AMessage::removeEntryAt(size_t index) {
     if (index < lastIndex) {
         mItems[index] = mItems[lastIndex];
         mItems[lastIndex].mName = nullptr;
+        mItems[lastIndex].mNameIsAtom = false;
         mItems[lastIndex].mType = kTypeInt32;
     }
     mItems.pop_back();
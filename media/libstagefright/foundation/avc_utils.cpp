@@ -18,6 +18,7 @@
 #define LOG_TAG "avc_utils"
 #include <utils/Log.h>
 
+#include <string.h>
 
 #include <media/stagefright/foundation/ABitReader.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -288,6 +289,29 @@ void FindAVCDimensions(
     }
 }
 
+const uint8_t *findNextStartCode(const uint8_t *data, size_t size) {
+    const uint8_t *end = data + size;
+    if (size < 3) {
+        return end;
+    }
+
+    // The 0x01 is the rarest byte of the prefix, so let memchr find it and only then
+    // look back at the two bytes before it.
+    const uint8_t *p = data + 2;
+    while (p < end) {
+        p = (const uint8_t *)memchr(p, 0x01, end - p);
+        if (p == NULL) {
+            break;
+        }
+        if (p[-1] == 0x00 && p[-2] == 0x00) {
+            return p - 2;
+        }
+        // a 0x01 in either of the next two bytes would have this 0x01 among its two leading zeros
+        p += 3;
+    }
+    return end;
+}
+
 status_t getNextNALUnit(
         const uint8_t **_data, size_t *_size,
         const uint8_t **nalStart, size_t *nalSize,
@@ -302,17 +326,11 @@ status_t getNextNALUnit(
         return -EAGAIN;
     }
 
-    size_t offset = 0;
-
     // A valid startcode consists of at least two 0x00 bytes followed by 0x01.
-    for (; offset + 2 < size; ++offset) {
-        if (data[offset + 2] == 0x01 && data[offset] == 0x00
-                && data[offset + 1] == 0x00) {
-            break;
-        }
-    }
-    if (offset + 2 >= size) {
-        *_data = &data[offset];
+    size_t offset = findNextStartCode(data, size) - data;
+    if (offset == size) {
+        // keep the last two bytes, they may begin a start code
+        *_data = &data[size - 2];
         *_size = 2;
         return -EAGAIN;
     }
@@ -320,28 +338,12 @@ status_t getNextNALUnit(
 
     size_t startOffset = offset;
 
-    for (;;) {
-        while (offset < size && data[offset] != 0x01) {
-            ++offset;
-        }
-
-        if (offset == size) {
-            if (startCodeFollows) {
-                offset = size + 2;
-                break;
-            }
-
-            return -EAGAIN;
-        }
-
-        if (data[offset - 1] == 0x00 && data[offset - 2] == 0x00) {
-            break;
-        }
-
-        ++offset;
+    size_t nextOffset = findNextStartCode(&data[startOffset], size - startOffset) - data;
+    if (nextOffset == size && !startCodeFollows) {
+        return -EAGAIN;
     }
 
-    size_t endOffset = offset - 2;
+    size_t endOffset = nextOffset;
     while (endOffset > startOffset + 1 && data[endOffset - 1] == 0x00) {
         --endOffset;
     }
@@ -349,9 +351,9 @@ status_t getNextNALUnit(
     *nalStart = &data[startOffset];
     *nalSize = endOffset - startOffset;
 
-    if (offset + 2 < size) {
-        *_data = &data[offset - 2];
-        *_size = size - offset + 2;
+    if (nextOffset + 4 < size) {
+        *_data = &data[nextOffset];
+        *_size = size - nextOffset;
     } else {
         *_data = NULL;
         *_size = 0;
@@ -31,15 +31,28 @@ namespace android {
 struct AAtomizer {
     static const char *Atomize(const char *name);
 
+    // Like Atomize(), but returns NULL instead of adding a new atom once the number of atoms
+    // reaches kMaxNumAtoms. Use this for names that may come from untrusted sources, as atoms
+    // are never freed.
+    static const char *TryAtomize(const char *name);
+
 private:
+    enum {
+        kNumBuckets = 512,
+        kMaxNumAtoms = 4096,
+        // Size of the per-thread cache of recently used atoms.
+        kNumCachedAtoms = 64,
+    };
+
     static AAtomizer gAtomizer;
 
     Mutex mLock;
     Vector<List<AString> > mAtoms;
+    size_t mNumAtoms;
 
     AAtomizer();
 
-    const char *atomize(const char *name);
+    const char *atomize(const char *name, uint32_t hash, bool bounded);
 
     static uint32_t Hash(const char *s);
 
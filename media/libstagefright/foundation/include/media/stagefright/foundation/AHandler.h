@@ -50,6 +50,20 @@ struct AHandler : public RefBase {
         return const_cast<AHandler *>(this);
     }
 
+    // Worst-case message latency of this handler. Only collected while verbose stats are
+    // enabled (dumpsys media.player -von).
+    struct LatencyStats {
+        uint64_t mNumMessages;
+        // Time from when a message was due until it was delivered.
+        int64_t mMaxQueueDelayUs;
+        // Time spent in onMessageReceived().
+        int64_t mMaxHandlingTimeUs;
+        int64_t mTotalHandlingTimeUs;
+    };
+
+    // Returns false if verbose stats are disabled or no message was handled yet.
+    bool getLatencyStats(LatencyStats *stats) const;
+
 protected:
     virtual void onMessageReceived(const sp<AMessage> &msg) = 0;
 
@@ -65,11 +79,30 @@ private:
         mLooper = looper;
     }
 
+    enum {
+        // Latency histogram buckets: <0.1ms, <1ms, <10ms, <100ms, <1s and >=1s.
+        kNumLatencyBuckets = 6,
+    };
+
+    // Per message 'what' stats, only collected while verbose stats are enabled.
+    struct MessageStats {
+        uint32_t mCount;
+        uint32_t mQueueDelayHist[kNumLatencyBuckets];
+        uint32_t mHandlingTimeHist[kNumLatencyBuckets];
+        int64_t mMaxQueueDelayUs;
+        int64_t mMaxHandlingTimeUs;
+        int64_t mTotalHandlingTimeUs;
+    };
+
     bool mVerboseStats;
     uint64_t mMessageCounter;
-    KeyedVector<uint32_t, uint32_t> mMessages;
+    // protects mMessages, which is read by dumpsys on a binder thread.
+    mutable Mutex mStatsLock;
+    KeyedVector<uint32_t, MessageStats> mMessages;
 
-    void deliverMessage(const sp<AMessage> &msg);
+    void deliverMessage(const sp<AMessage> &msg, int64_t whenUs);
+    void recordMessageStats(uint32_t what, int64_t queueDelayUs, int64_t handlingTimeUs);
+    static size_t getLatencyBucket(int64_t latencyUs);
 
     DISALLOW_EVIL_CONSTRUCTORS(AHandler);
 };
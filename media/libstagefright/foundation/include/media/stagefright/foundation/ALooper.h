@@ -26,6 +26,8 @@
 #include <utils/RefBase.h>
 #include <utils/threads.h>
 
+#include <atomic>
+
 namespace android {
 
 struct AHandler;
@@ -69,13 +71,28 @@ private:
         sp<AMessage> mMessage;
     };
 
+    // Event posted for immediate delivery, linked into a singly-linked list.
+    struct PostedEvent {
+        int64_t mWhenUs;
+        sp<AMessage> mMessage;
+        PostedEvent *mNext;
+    };
+
     Mutex mLock;
     Condition mQueueChangedCondition;
 
     AString mName;
 
+    // Events posted with a delay, ordered by delivery time.
     List<Event> mEventQueue;
 
+    // Events posted for immediate delivery are pushed onto mPostedEvents without taking mLock,
+    // newest first. The looper moves them to the FIFO list mReadyEvents (protected by mLock)
+    // and merges them with mEventQueue by delivery time.
+    std::atomic<PostedEvent *> mPostedEvents;
+    PostedEvent *mReadyEvents;
+    PostedEvent *mReadyEventsTail;
+
     struct LooperThread;
     sp<LooperThread> mThread;
     bool mRunningLocally;
@@ -101,6 +118,9 @@ private:
 
     // END --- methods used only by AMessage
 
+    // moves the events posted for immediate delivery to mReadyEvents. Called with mLock held.
+    void collectPostedEvents_l();
+
     bool loop();
 
     DISALLOW_EVIL_CONSTRUCTORS(ALooper);
@@ -18,9 +18,11 @@
 
 #define A_LOOPER_ROSTER_H_
 
+#include <media/stagefright/foundation/AHandler.h>
 #include <media/stagefright/foundation/ALooper.h>
 #include <utils/KeyedVector.h>
 #include <utils/String16.h>
+#include <utils/String8.h>
 
 namespace android {
 
@@ -45,6 +47,9 @@ private:
     KeyedVector<ALooper::handler_id, HandlerInfo> mHandlers;
     ALooper::handler_id mNextHandlerID;
 
+    static void appendMessageStats(
+            String8 &s, const char *what, const AHandler::MessageStats &stats);
+
     DISALLOW_EVIL_CONSTRUCTORS(ALooperRoster);
 };
 
@@ -275,6 +275,10 @@ struct AMessage : public RefBase {
      */
     status_t removeEntryByName(const char *name);
 
+    // AMessage objects are allocated from a small per-thread cache of recently freed messages.
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
 protected:
     virtual ~AMessage();
 
@@ -301,16 +305,22 @@ private:
             AString *stringValue;
             Rect rectValue;
         } u;
+        // Interned with AAtomizer when possible, so lookups with the same atom are a pointer
+        // compare and most names don't need an allocation.
         const char *mName;
         size_t      mNameLength;
         Type mType;
+        bool mNameIsAtom;
         void setName(const char *name, size_t len);
-        Item() : mName(nullptr), mNameLength(0), mType(kTypeInt32) { }
+        void freeName();
+        Item() : mName(nullptr), mNameLength(0), mType(kTypeInt32), mNameIsAtom(false) { }
         Item(const char *name, size_t length);
     };
 
     enum {
-        kMaxNumItems = 256
+        kMaxNumItems = 256,
+        // Item storage reserved when the first item is added, which covers most messages.
+        kInitialNumItems = 4,
     };
     std::vector<Item> mItems;
 
@@ -345,7 +355,8 @@ private:
 
     size_t findItemIndex(const char *name, size_t len) const;
 
-    void deliver();
+    // delivers the message to its handler. |whenUs| is the time the message was due.
+    void deliver(int64_t whenUs);
 
     DISALLOW_EVIL_CONSTRUCTORS(AMessage);
 };
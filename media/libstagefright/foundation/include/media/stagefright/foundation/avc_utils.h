@@ -75,6 +75,11 @@ inline void skipSE(ABitReader *br) {
     (void)parseSEWithFallback(br, 0);
 }
 
+// Returns a pointer to the first 0x00 0x00 0x01 start code prefix in data, or data + size if there
+// is none. Scans with memchr for the 0x01 byte, which is much faster than a byte by byte loop on
+// slice data where start codes are rare.
+const uint8_t *findNextStartCode(const uint8_t *data, size_t size);
+
 status_t getNextNALUnit(
         const uint8_t **_data, size_t *_size,
         const uint8_t **nalStart, size_t *nalSize,
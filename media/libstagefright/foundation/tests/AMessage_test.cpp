@@ -20,8 +20,16 @@
 #include <gtest/gtest.h>
 #include <utils/RefBase.h>
 
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
 #include <media/stagefright/foundation/AMessage.h>
 
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 using namespace android;
 
 class AMessageTest : public ::testing::Test {
@@ -123,3 +131,106 @@ TEST(AMessage_tests, item_manipulation) {
 
 }
 
+namespace {
+
+// Records the messages it receives, in delivery order.
+struct RecordingHandler : public AHandler {
+  void waitForMessages(size_t count) {
+    std::unique_lock<std::mutex> lock(mLock);
+    mCondition.wait_for(lock, std::chrono::seconds(5), [&] { return mReceived.size() >= count; });
+  }
+
+  std::vector<std::pair<uint32_t, int32_t>> received() {
+    std::scoped_lock lock(mLock);
+    return mReceived;
+  }
+
+ protected:
+  void onMessageReceived(const sp<AMessage> &msg) override {
+    int32_t seq = -1;
+    msg->findInt32("seq", &seq);
+    std::scoped_lock lock(mLock);
+    mReceived.emplace_back(msg->what(), seq);
+    mCondition.notify_all();
+  }
+
+ private:
+  std::mutex mLock;
+  std::condition_variable mCondition;
+  std::vector<std::pair<uint32_t, int32_t>> mReceived;
+};
+
+}  // namespace
+
+TEST(AMessage_tests, post_ordering) {
+  sp<ALooper> looper = new ALooper();
+  sp<RecordingHandler> handler = new RecordingHandler();
+  looper->registerHandler(handler);
+  ASSERT_EQ(OK, looper->start());
+
+  constexpr uint32_t kDelayedWhat = 100;
+  constexpr uint32_t kNumThreads = 4;
+  constexpr size_t kNumMessages = 200;
+
+  (new AMessage(kDelayedWhat, handler))->post(500000 /* delayUs */);
+
+  // Immediate messages from each thread are delivered in the order they are posted.
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([t, &handler] {
+      for (int32_t i = 0; i < (int32_t)kNumMessages; ++i) {
+        sp<AMessage> msg = new AMessage(t, handler);
+        msg->setInt32("seq", i);
+        msg->post();
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  handler->waitForMessages(kNumThreads * kNumMessages + 1);
+  looper->stop();
+
+  std::vector<std::pair<uint32_t, int32_t>> received = handler->received();
+  ASSERT_EQ(kNumThreads * kNumMessages + 1, received.size());
+  EXPECT_EQ(kDelayedWhat, received.back().first);
+
+  std::vector<int32_t> nextSeq(kNumThreads, 0);
+  for (size_t i = 0; i + 1 < received.size(); ++i) {
+    ASSERT_LT(received[i].first, kNumThreads);
+    EXPECT_EQ(nextSeq[received[i].first]++, received[i].second);
+  }
+}
+
+TEST(AMessage_tests, item_names) {
+  sp<AMessage> m1 = new AMessage();
+
+  // Names are matched by value, not by pointer.
+  char name[] = "width";
+  m1->setInt32(name, 1280);
+  int32_t i32;
+  EXPECT_TRUE(m1->findInt32("width", &i32));
+  EXPECT_EQ(1280, i32);
+
+  // Changing the caller's buffer doesn't change the item name.
+  name[0] = 'W';
+  EXPECT_FALSE(m1->findInt32(name, &i32));
+  EXPECT_TRUE(m1->findInt32("width", &i32));
+
+  // Long names and renamed entries survive dup() and removal of other entries.
+  std::string longName(200, 'x');
+  m1->setInt32(longName.c_str(), 2);
+  m1->setInt32("height", 720);
+  EXPECT_EQ(OK, m1->setEntryNameAt(m1->findEntryByName("height"), "rows"));
+  EXPECT_EQ(OK, m1->removeEntryByName("width"));
+
+  sp<AMessage> m2 = m1->dup();
+  m1.clear();
+  EXPECT_TRUE(m2->findInt32(longName.c_str(), &i32));
+  EXPECT_EQ(2, i32);
+  EXPECT_TRUE(m2->findInt32("rows", &i32));
+  EXPECT_EQ(720, i32);
+  EXPECT_FALSE(m2->findInt32("height", &i32));
+  EXPECT_FALSE(m2->findInt32("width", &i32));
+}
@@ -350,6 +350,27 @@ TEST_P(AVCFrameTest, FrameTest) {
     }
 }
 
+TEST(StartCodeTest, FindNextStartCodeTest) {
+    // mostly zeros and ones, so that full and partial start codes are common
+    srand(1);
+    uint8_t data[64];
+    for (int iteration = 0; iteration < 10000; ++iteration) {
+        size_t size = rand() % sizeof(data);
+        for (size_t i = 0; i < size; ++i) {
+            int r = rand() % 4;
+            data[i] = r < 2 ? 0x00 : r == 2 ? 0x01 : rand() % 256;
+        }
+        size_t expected = 0;
+        while (expected + 2 < size &&
+               (data[expected] != 0x00 || data[expected + 1] != 0x00 || data[expected + 2] != 0x01)) {
+            ++expected;
+        }
+        if (expected + 2 >= size) expected = size;
+        ASSERT_EQ(findNextStartCode(data, size), data + expected)
+                << "Wrong start code position in a buffer of size " << size;
+    }
+}
+
 INSTANTIATE_TEST_SUITE_P(AVCUtilsTestAll, MpegAudioUnitTest,
                          ::testing::Values(make_tuple(0xFFFB9204, 418, 44100, 2, 128, 1152),
                                            make_tuple(0xFFFB7604, 289, 48000, 2, 96, 1152),
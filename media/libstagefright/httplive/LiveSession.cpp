@@ -223,6 +223,141 @@ bool LiveSession::BandwidthEstimator::estimateBandwidth(
     return true;
 }
 
+// Estimates the bandwidth from the distribution of the throughput of the
+// recent transfers rather than from their average, so that a few unusually
+// fast or slow transfers don't swing the estimate and cause the variant to
+// oscillate. Each transfer is weighted by its size.
+struct LiveSession::PercentileBandwidthEstimator : public LiveSession::BandwidthBaseEstimator {
+    PercentileBandwidthEstimator();
+
+    void addBandwidthMeasurement(size_t numBytes, int64_t delayUs);
+    bool estimateBandwidth(
+            int32_t *bandwidth,
+            bool *isStable = NULL,
+            int32_t *shortTermBps = NULL);
+
+private:
+    static const int32_t kShortTermBandwidthItems = 3;
+    static const size_t kMaxBandwidthHistoryItems = 30;
+    static const int64_t kMaxBandwidthHistoryAgeUs = 30000000LL; // 30 sec
+
+    struct BandwidthEntry {
+        int64_t mTimestampUs;
+        int64_t mDelayUs;
+        size_t mNumBytes;
+        int32_t mBps;
+    };
+
+    Mutex mLock;
+    List<BandwidthEntry> mBandwidthHistory;
+    int32_t mEstimate;
+    int32_t mShortTermEstimate;
+    bool mHasNewSample;
+    bool mIsStable;
+
+    DISALLOW_EVIL_CONSTRUCTORS(PercentileBandwidthEstimator);
+};
+
+LiveSession::PercentileBandwidthEstimator::PercentileBandwidthEstimator() :
+    mEstimate(0),
+    mShortTermEstimate(0),
+    mHasNewSample(false),
+    mIsStable(true) {
+}
+
+void LiveSession::PercentileBandwidthEstimator::addBandwidthMeasurement(
+        size_t numBytes, int64_t delayUs) {
+    AutoMutex autoLock(mLock);
+
+    if (delayUs <= 0) {
+        delayUs = 1;
+    }
+
+    int64_t nowUs = ALooper::GetNowUs();
+    BandwidthEntry entry;
+    entry.mTimestampUs = nowUs;
+    entry.mDelayUs = delayUs;
+    entry.mNumBytes = numBytes;
+    double bps = (double)numBytes * 8E6 / delayUs;
+    entry.mBps = bps > INT32_MAX ? INT32_MAX : (int32_t)bps;
+    mBandwidthHistory.push_back(entry);
+    mHasNewSample = true;
+
+    // keep at least two samples so that an estimate is always available
+    while (mBandwidthHistory.size() > 2
+            && (mBandwidthHistory.size() > kMaxBandwidthHistoryItems
+                || nowUs - mBandwidthHistory.begin()->mTimestampUs
+                        > kMaxBandwidthHistoryAgeUs)) {
+        mBandwidthHistory.erase(mBandwidthHistory.begin());
+    }
+}
+
+bool LiveSession::PercentileBandwidthEstimator::estimateBandwidth(
+        int32_t *bandwidthBps, bool *isStable, int32_t *shortTermBps) {
+    AutoMutex autoLock(mLock);
+
+    if (mBandwidthHistory.size() < 2) {
+        return false;
+    }
+
+    if (mHasNewSample) {
+        mHasNewSample = false;
+
+        Vector<BandwidthEntry> sorted;
+        size_t totalBytes = 0;
+        for (List<BandwidthEntry>::iterator it = mBandwidthHistory.begin();
+                it != mBandwidthHistory.end(); ++it) {
+            sorted.push_back(*it);
+            totalBytes += it->mNumBytes;
+        }
+        sorted.sort([](const BandwidthEntry *a, const BandwidthEntry *b) {
+            return a->mBps < b->mBps ? -1 : a->mBps > b->mBps ? 1 : 0;
+        });
+
+        // byte weighted 25th, 50th and 75th percentiles
+        int32_t percentiles[3] = {0, 0, 0};
+        size_t bytes = 0;
+        size_t next = 0;
+        for (size_t i = 0; i < sorted.size() && next < 3; ++i) {
+            bytes += sorted[i].mNumBytes;
+            while (next < 3 && bytes * 4 >= totalBytes * (next + 1)) {
+                percentiles[next++] = sorted[i].mBps;
+            }
+        }
+        while (next < 3) {
+            percentiles[next++] = sorted[sorted.size() - 1].mBps;
+        }
+        mEstimate = percentiles[1];
+
+        int64_t totalTimeUs = 0;
+        size_t shortTermBytes = 0;
+        List<BandwidthEntry>::iterator it = --mBandwidthHistory.end();
+        for (size_t i = 0; i < kShortTermBandwidthItems && i < mBandwidthHistory.size();
+                i++, it--) {
+            totalTimeUs += it->mDelayUs;
+            shortTermBytes += it->mNumBytes;
+        }
+        mShortTermEstimate = shortTermBytes * 8E6 / totalTimeUs;
+
+        // consider it stable if the recent transfers are not spread out a lot
+        // and the short-term throughput is not much lower than the low end
+        mIsStable = ((int64_t)percentiles[2] <= (int64_t)percentiles[0] * 3 / 2)
+                && mShortTermEstimate > (int64_t)percentiles[0] * 7 / 10;
+        ALOGV("percentile estimate bps 25%%=%d 50%%=%d 75%%=%d short=%d stable=%d",
+                percentiles[0], percentiles[1], percentiles[2],
+                mShortTermEstimate, mIsStable);
+    }
+
+    *bandwidthBps = mEstimate;
+    if (isStable) {
+        *isStable = mIsStable;
+    }
+    if (shortTermBps) {
+        *shortTermBps = mShortTermEstimate;
+    }
+    return true;
+}
+
 //static
 const char *LiveSession::getKeyForStream(StreamType type) {
     switch (type) {
@@ -287,7 +422,9 @@ LiveSession::LiveSession(
       mOrigBandwidthIndex(-1),
       mLastBandwidthBps(-1LL),
       mLastBandwidthStable(false),
-      mBandwidthEstimator(new BandwidthEstimator()),
+      mBandwidthEstimator(property_get_bool("media.httplive.bw-percentile", false)
+              ? sp<BandwidthBaseEstimator>(new PercentileBandwidthEstimator())
+              : sp<BandwidthBaseEstimator>(new BandwidthEstimator())),
       mMaxWidth(720),
       mMaxHeight(480),
       mStreamMask(0),
@@ -152,6 +152,7 @@ protected:
     };
 
     struct BandwidthEstimator;
+    struct PercentileBandwidthEstimator;
     struct BandwidthItem {
         size_t mPlaylistIndex;
         unsigned long mBandwidth;
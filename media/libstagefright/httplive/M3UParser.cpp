@@ -250,7 +250,8 @@ bool M3UParser::MediaGroup::getActiveURI(AString *uri, const char *baseURL) cons
 ////////////////////////////////////////////////////////////////////////////////
 
 M3UParser::M3UParser(
-        const char *baseURI, const void *data, size_t size)
+        const char *baseURI, const void *data, size_t size,
+        const sp<M3UParser> &previous)
     : mInitCheck(NO_INIT),
       mBaseURI(baseURI),
       mIsExtM3U(false),
@@ -263,7 +264,7 @@ M3UParser::M3UParser(
       mDiscontinuitySeq(0),
       mDiscontinuityCount(0),
       mSelectedIndex(-1) {
-    mInitCheck = parse(data, size);
+    mInitCheck = parse(data, size, previous);
 }
 
 M3UParser::~M3UParser() {
@@ -566,11 +567,129 @@ AString M3UParser::MediaGroup::Media::makeURL(const char *baseURL) const {
     return out;
 }
 
-status_t M3UParser::parse(const void *_data, size_t size) {
+// static
+uint64_t M3UParser::HashLine(uint64_t hash, const AString &line) {
+    // FNV-1a, with the line terminator included so that lines cannot merge
+    const uint8_t *data = (const uint8_t *)line.c_str();
+    for (size_t i = 0; i <= line.size(); ++i) {
+        hash = (hash ^ data[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// static
+uint64_t M3UParser::HashValue(uint64_t hash, uint64_t value) {
+    for (size_t i = 0; i < sizeof(value); ++i) {
+        hash = (hash ^ (uint8_t)(value >> (i * 8))) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// static
+bool M3UParser::isItemTag(const AString &line) {
+    return line.startsWith("#EXT-X-KEY")
+            || line.startsWith("#EXTINF")
+            || (line.startsWith("#EXT-X-DISCONTINUITY")
+                    && !line.startsWith("#EXT-X-DISCONTINUITY-SEQUENCE"))
+            || line.startsWith("#EXT-X-BYTERANGE");
+}
+
+status_t M3UParser::parseItemTag(
+        const AString &line, sp<AMessage> *itemMeta, uint64_t *segmentRangeOffset) {
+    if (mIsVariantPlaylist) {
+        return ERROR_MALFORMED;
+    }
+
+    if (line.startsWith("#EXT-X-KEY")) {
+        return parseCipherInfo(line, itemMeta);
+    } else if (line.startsWith("#EXTINF")) {
+        return parseMetaDataDuration(line, itemMeta, "durationUs");
+    } else if (line.startsWith("#EXT-X-DISCONTINUITY")) {
+        if (*itemMeta == NULL) {
+            *itemMeta = new AMessage;
+        }
+        (*itemMeta)->setInt32("discontinuity", true);
+        ++mDiscontinuityCount;
+        return OK;
+    }
+
+    uint64_t length, offset;
+    status_t err = parseByteRange(line, *segmentRangeOffset, &length, &offset);
+
+    if (err == OK) {
+        if (*itemMeta == NULL) {
+            *itemMeta = new AMessage;
+        }
+
+        (*itemMeta)->setInt64("range-offset", offset);
+        (*itemMeta)->setInt64("range-length", length);
+
+        *segmentRangeOffset = offset + length;
+    }
+    return err;
+}
+
+bool M3UParser::reuseItem(
+        const sp<M3UParser> &previous, uint64_t itemHash,
+        sp<AMessage> *itemMeta, uint64_t *segmentRangeOffset) {
+    if (*itemMeta != NULL || mIsVariantPlaylist) {
+        // an #EXT-X-STREAM-INF or a tag that is not hashed applies to this item
+        return false;
+    }
+
+    int32_t seqNumber = 0;
+    if (mMeta != NULL) {
+        mMeta->findInt32("media-sequence", &seqNumber);
+    }
+    int64_t index = (int64_t)seqNumber + mItems.size() - previous->mFirstSeqNumber;
+    if (index < 0 || index >= (int64_t)previous->mItems.size()) {
+        return false;
+    }
+
+    const Item &item = previous->mItems.itemAt(index);
+    if (item.mHash != itemHash) {
+        return false;
+    }
+
+    int32_t discontinuity = 0;
+    item.mMeta->findInt32("discontinuity", &discontinuity);
+    size_t discontinuitySeq = mDiscontinuitySeq + mDiscontinuityCount + (discontinuity ? 1 : 0);
+    int32_t itemDiscontinuitySeq;
+    if (!item.mMeta->findInt32("discontinuity-sequence", &itemDiscontinuitySeq)
+            || (size_t)itemDiscontinuitySeq != discontinuitySeq) {
+        return false;
+    }
+
+    if (discontinuity) {
+        ++mDiscontinuityCount;
+    }
+    int64_t rangeOffset, rangeLength;
+    if (item.mMeta->findInt64("range-offset", &rangeOffset)
+            && item.mMeta->findInt64("range-length", &rangeLength)) {
+        *segmentRangeOffset = rangeOffset + rangeLength;
+    }
+    *itemMeta = item.mMeta;
+    return true;
+}
+
+status_t M3UParser::parse(
+        const void *_data, size_t size, const sp<M3UParser> &previous) {
     int32_t lineNo = 0;
 
     sp<AMessage> itemMeta;
 
+    // When refreshing a media playlist, the tags of each segment are only
+    // parsed if the segment is not in the previous playlist with the same
+    // sequence number and text. Live playlists mostly repeat the previous
+    // refresh, so this saves most of the parsing and allocation.
+    const bool reuseItems = previous != NULL && previous->mInitCheck == OK
+            && !previous->mIsVariantPlaylist && previous->mItems.size() > 0;
+    Vector<AString> itemLines;
+    uint64_t itemHash = HashValue(kHashBasis, 0 /* segmentRangeOffset */);
+    if (reuseItems) {
+        mItems.setCapacity(previous->mItems.size() + 1);
+    }
+
     const char *data = (const char *)_data;
     size_t offset = 0;
     uint64_t segmentRangeOffset = 0;
@@ -601,7 +720,15 @@ status_t M3UParser::parse(const void *_data, size_t size) {
         if (mIsExtM3U) {
             status_t err = OK;
 
-            if (line.startsWith("#EXT-X-TARGETDURATION")) {
+            if (isItemTag(line)) {
+                itemHash = HashLine(itemHash, line);
+                if (reuseItems) {
+                    // parsed once the URI line shows whether the item changed
+                    itemLines.push(line);
+                } else {
+                    err = parseItemTag(line, &itemMeta, &segmentRangeOffset);
+                }
+            } else if (line.startsWith("#EXT-X-TARGETDURATION")) {
                 if (mIsVariantPlaylist) {
                     return ERROR_MALFORMED;
                 }
@@ -611,20 +738,10 @@ status_t M3UParser::parse(const void *_data, size_t size) {
                     return ERROR_MALFORMED;
                 }
                 err = parseMetaData(line, &mMeta, "media-sequence");
-            } else if (line.startsWith("#EXT-X-KEY")) {
-                if (mIsVariantPlaylist) {
-                    return ERROR_MALFORMED;
-                }
-                err = parseCipherInfo(line, &itemMeta);
             } else if (line.startsWith("#EXT-X-ENDLIST")) {
                 mIsComplete = true;
             } else if (line.startsWith("#EXT-X-PLAYLIST-TYPE:EVENT")) {
                 mIsEvent = true;
-            } else if (line.startsWith("#EXTINF")) {
-                if (mIsVariantPlaylist) {
-                    return ERROR_MALFORMED;
-                }
-                err = parseMetaDataDuration(line, &itemMeta, "durationUs");
             } else if (line.startsWith("#EXT-X-DISCONTINUITY-SEQUENCE")) {
                 if (mIsVariantPlaylist) {
                     return ERROR_MALFORMED;
@@ -637,39 +754,12 @@ status_t M3UParser::parse(const void *_data, size_t size) {
                 } else {
                     ALOGI("Failed to parseDiscontinuitySequence %d", err);
                 }
-            } else if (line.startsWith("#EXT-X-DISCONTINUITY")) {
-                if (mIsVariantPlaylist) {
-                    return ERROR_MALFORMED;
-                }
-                if (itemMeta == NULL) {
-                    itemMeta = new AMessage;
-                }
-                itemMeta->setInt32("discontinuity", true);
-                ++mDiscontinuityCount;
             } else if (line.startsWith("#EXT-X-STREAM-INF")) {
                 if (mMeta != NULL) {
                     return ERROR_MALFORMED;
                 }
                 mIsVariantPlaylist = true;
                 err = parseStreamInf(line, &itemMeta);
-            } else if (line.startsWith("#EXT-X-BYTERANGE")) {
-                if (mIsVariantPlaylist) {
-                    return ERROR_MALFORMED;
-                }
-
-                uint64_t length, offset;
-                err = parseByteRange(line, segmentRangeOffset, &length, &offset);
-
-                if (err == OK) {
-                    if (itemMeta == NULL) {
-                        itemMeta = new AMessage;
-                    }
-
-                    itemMeta->setInt64("range-offset", offset);
-                    itemMeta->setInt64("range-length", length);
-
-                    segmentRangeOffset = offset + length;
-                }
             } else if (line.startsWith("#EXT-X-MEDIA")) {
                 err = parseMedia(line);
             }
@@ -680,11 +770,26 @@ status_t M3UParser::parse(const void *_data, size_t size) {
         }
 
         if (!line.startsWith("#")) {
+            itemHash = HashLine(itemHash, line);
+
+            bool reused = false;
+            if (reuseItems) {
+                reused = reuseItem(previous, itemHash, &itemMeta, &segmentRangeOffset);
+                for (size_t i = 0; !reused && i < itemLines.size(); ++i) {
+                    status_t err = parseItemTag(
+                            itemLines.itemAt(i), &itemMeta, &segmentRangeOffset);
+                    if (err != OK) {
+                        return err;
+                    }
+                }
+                itemLines.clear();
+            }
+
             if (itemMeta == NULL) {
                 ALOGV("itemMeta == NULL");
                 return ERROR_MALFORMED;
             }
-            if (!mIsVariantPlaylist) {
+            if (!mIsVariantPlaylist && !reused) {
                 int64_t durationUs;
                 if (!itemMeta->findInt64("durationUs", &durationUs)) {
                     return ERROR_MALFORMED;
@@ -700,13 +805,24 @@ status_t M3UParser::parse(const void *_data, size_t size) {
 
             item->mMeta = itemMeta;
 
+            item->mHash = itemHash;
+
             itemMeta.clear();
+            itemHash = HashValue(kHashBasis, segmentRangeOffset);
         }
 
         offset = offsetLF + 1;
         ++lineNo;
     }
 
+    // tags after the last segment are still checked
+    for (size_t i = 0; i < itemLines.size(); ++i) {
+        status_t err = parseItemTag(itemLines.itemAt(i), &itemMeta, &segmentRangeOffset);
+        if (err != OK) {
+            return err;
+        }
+    }
+
     // playlist has no item, would cause exception
     if (mItems.size() == 0) {
         ALOGE("playlist has no item");
@@ -27,7 +27,10 @@
 namespace android {
 
 struct M3UParser : public RefBase {
-    M3UParser(const char *baseURI, const void *data, size_t size);
+    // If given, the items of |previous| that are unchanged in this playlist
+    // are reused instead of being parsed again.
+    M3UParser(const char *baseURI, const void *data, size_t size,
+            const sp<M3UParser> &previous = NULL);
 
     status_t initCheck() const;
 
@@ -66,9 +69,13 @@ private:
     struct Item {
         AString mURI;
         sp<AMessage> mMeta;
+        // hash of the item's tags, URI and starting byte range offset
+        uint64_t mHash;
         AString makeURL(const char *baseURL) const;
     };
 
+    static const uint64_t kHashBasis = 14695981039346656037ULL;
+
     status_t mInitCheck;
 
     AString mBaseURI;
@@ -89,7 +96,17 @@ private:
     // Media groups keyed by group ID.
     KeyedVector<AString, sp<MediaGroup> > mMediaGroups;
 
-    status_t parse(const void *data, size_t size);
+    status_t parse(const void *data, size_t size, const sp<M3UParser> &previous);
+
+    static bool isItemTag(const AString &line);
+    status_t parseItemTag(
+            const AString &line, sp<AMessage> *itemMeta, uint64_t *segmentRangeOffset);
+    bool reuseItem(
+            const sp<M3UParser> &previous, uint64_t itemHash,
+            sp<AMessage> *itemMeta, uint64_t *segmentRangeOffset);
+
+    static uint64_t HashLine(uint64_t hash, const AString &line);
+    static uint64_t HashValue(uint64_t hash, uint64_t value);
 
     static status_t parseMetaData(
             const AString &line, sp<AMessage> *meta, const char *key);
@@ -17,6 +17,8 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "PlaylistFetcher"
 #include <android-base/macros.h>
+#include <cutils/properties.h>
+#include <utils/Condition.h>
 #include <utils/Log.h>
 #include <utils/misc.h>
 
@@ -55,6 +57,8 @@ const int64_t PlaylistFetcher::kMinBufferedDurationUs = 30000000LL;
 const int64_t PlaylistFetcher::kMaxMonitorDelayUs = 3000000LL;
 // LCM of 188 (size of a TS packet) & 1k works well
 const int32_t PlaylistFetcher::kDownloadBlockSize = 47 * 1024;
+// Segments larger than this are not prefetched and are downloaded block-wise as usual.
+const int64_t PlaylistFetcher::kMaxPrefetchBytes = 8 * 1024 * 1024;
 
 struct PlaylistFetcher::DownloadState : public RefBase {
     DownloadState();
@@ -142,6 +146,174 @@ void PlaylistFetcher::DownloadState::saveState(
     mLastSeqNumberInPlaylist = lastSeqNumberInPlaylist;
 }
 
+/*
+ * Fetches one segment ahead of the fetcher with a downloader of its own. The
+ * HTTP connection of that downloader is reused from segment to segment. The
+ * segment is kept whole in memory until the fetcher takes it, so at most
+ * kMaxPrefetchBytes are buffered.
+ */
+struct PlaylistFetcher::SegmentPrefetcher : public AHandler {
+    explicit SegmentPrefetcher(const sp<HTTPDownloader> &downloader);
+
+    // Starts downloading the given segment, dropping any other prefetch.
+    void prefetch(const AString &uri, int64_t rangeOffset, int64_t rangeLength);
+
+    // Returns true and the complete segment if it is the one being prefetched,
+    // waiting for the download to finish. A prefetch of any other segment
+    // is dropped.
+    bool take(const AString &uri, int64_t rangeOffset, int64_t rangeLength,
+            sp<ABuffer> *buffer, int64_t *delayUs);
+
+    // Drops the prefetch, optionally aborting the download in progress.
+    void cancel(bool disconnect);
+
+protected:
+    virtual ~SegmentPrefetcher() {}
+    virtual void onMessageReceived(const sp<AMessage> &msg);
+
+private:
+    enum {
+        kWhatFetch = 'ftch',
+    };
+
+    sp<HTTPDownloader> mDownloader;
+
+    Mutex mLock;
+    Condition mCondition;
+    int32_t mGeneration;
+    bool mPending;
+    AString mUri;
+    int64_t mRangeOffset;
+    int64_t mRangeLength;
+    sp<ABuffer> mBuffer;
+    int64_t mDelayUs;
+
+    bool isCurrent(int32_t generation);
+    void cancel_l();
+
+    DISALLOW_EVIL_CONSTRUCTORS(SegmentPrefetcher);
+};
+
+PlaylistFetcher::SegmentPrefetcher::SegmentPrefetcher(const sp<HTTPDownloader> &downloader)
+    : mDownloader(downloader),
+      mGeneration(0),
+      mPending(false),
+      mRangeOffset(0),
+      mRangeLength(-1),
+      mDelayUs(0) {
+}
+
+void PlaylistFetcher::SegmentPrefetcher::prefetch(
+        const AString &uri, int64_t rangeOffset, int64_t rangeLength) {
+    Mutex::Autolock autoLock(mLock);
+    cancel_l();
+
+    mPending = true;
+    mUri = uri;
+    mRangeOffset = rangeOffset;
+    mRangeLength = rangeLength;
+
+    sp<AMessage> msg = new AMessage(kWhatFetch, this);
+    msg->setInt32("generation", mGeneration);
+    msg->post();
+}
+
+bool PlaylistFetcher::SegmentPrefetcher::take(
+        const AString &uri, int64_t rangeOffset, int64_t rangeLength,
+        sp<ABuffer> *buffer, int64_t *delayUs) {
+    Mutex::Autolock autoLock(mLock);
+    if (!mPending && mBuffer == NULL) {
+        return false;
+    }
+    if (mUri != uri || mRangeOffset != rangeOffset || mRangeLength != rangeLength) {
+        cancel_l();
+        return false;
+    }
+    while (mPending) {
+        mCondition.wait(mLock);
+    }
+    if (mBuffer == NULL) {
+        // the download failed, was cancelled or went over budget
+        return false;
+    }
+    *buffer = mBuffer;
+    *delayUs = mDelayUs;
+    mBuffer.clear();
+    return true;
+}
+
+void PlaylistFetcher::SegmentPrefetcher::cancel(bool disconnect) {
+    {
+        Mutex::Autolock autoLock(mLock);
+        cancel_l();
+    }
+    if (disconnect) {
+        mDownloader->disconnect();
+    }
+}
+
+void PlaylistFetcher::SegmentPrefetcher::cancel_l() {
+    ++mGeneration;
+    mPending = false;
+    mBuffer.clear();
+    mCondition.broadcast();
+}
+
+bool PlaylistFetcher::SegmentPrefetcher::isCurrent(int32_t generation) {
+    Mutex::Autolock autoLock(mLock);
+    return generation == mGeneration;
+}
+
+void PlaylistFetcher::SegmentPrefetcher::onMessageReceived(const sp<AMessage> &msg) {
+    CHECK_EQ(msg->what(), (uint32_t)kWhatFetch);
+
+    int32_t generation;
+    CHECK(msg->findInt32("generation", &generation));
+
+    AString uri;
+    int64_t rangeOffset, rangeLength;
+    {
+        Mutex::Autolock autoLock(mLock);
+        if (generation != mGeneration) {
+            return;
+        }
+        uri = mUri;
+        rangeOffset = mRangeOffset;
+        rangeLength = mRangeLength;
+    }
+
+    // undo a disconnect from an earlier cancel
+    mDownloader->reconnect();
+
+    sp<ABuffer> buffer;
+    bool connectHTTP = true;
+    ssize_t bytesRead;
+    int64_t startUs = ALooper::GetNowUs();
+    do {
+        // Fetch block-wise so that a stale or oversized download is
+        // abandoned early instead of being read to the end.
+        bytesRead = mDownloader->fetchBlock(
+                uri.c_str(), &buffer, rangeOffset, rangeLength, kDownloadBlockSize,
+                NULL /* actualURL */, connectHTTP);
+        connectHTTP = false;
+
+        if (bytesRead < 0 || !isCurrent(generation)
+                || (int64_t)buffer->capacity() > kMaxPrefetchBytes) {
+            buffer.clear();
+            break;
+        }
+    } while (bytesRead != 0);
+    int64_t delayUs = ALooper::GetNowUs() - startUs;
+
+    Mutex::Autolock autoLock(mLock);
+    if (generation == mGeneration) {
+        mPending = false;
+        mBuffer = buffer;
+        mDelayUs = delayUs;
+        mCondition.broadcast();
+    }
+}
+
 PlaylistFetcher::PlaylistFetcher(
         const sp<AMessage> &notify,
         const sp<LiveSession> &session,
@@ -180,15 +352,29 @@ PlaylistFetcher::PlaylistFetcher(
       mSampleAesKeyItemChanged(false),
       mThresholdRatio(-1.0f),
       mDownloadState(new DownloadState()),
+      mSegmentPrefetched(false),
       mHasMetadata(false) {
     memset(mPlaylistHash, 0, sizeof(mPlaylistHash));
     mHTTPDownloader = mSession->getHTTPDownloader();
 
+    if (property_get_bool("media.httplive.prefetch-segments", false)) {
+        mSegmentPrefetcher = new SegmentPrefetcher(mSession->getHTTPDownloader());
+        mPrefetchLooper = new ALooper;
+        mPrefetchLooper->setName("segment-prefetch");
+        mPrefetchLooper->start();
+        mPrefetchLooper->registerHandler(mSegmentPrefetcher);
+    }
+
     memset(mKeyData, 0, sizeof(mKeyData));
     memset(mAESInitVec, 0, sizeof(mAESInitVec));
 }
 
 PlaylistFetcher::~PlaylistFetcher() {
+    if (mPrefetchLooper != NULL) {
+        mSegmentPrefetcher->cancel(true /* disconnect */);
+        mPrefetchLooper->unregisterHandler(mSegmentPrefetcher->id());
+        mPrefetchLooper->stop();
+    }
 }
 
 int32_t PlaylistFetcher::getFetcherID() const {
@@ -528,6 +714,9 @@ void PlaylistFetcher::setStoppingThreshold(float thresholdRatio, bool disconnect
     }
     if (disconnect) {
         mHTTPDownloader->disconnect();
+        if (mSegmentPrefetcher != NULL) {
+            mSegmentPrefetcher->cancel(true /* disconnect */);
+        }
     }
 }
 
@@ -538,6 +727,9 @@ void PlaylistFetcher::resetStoppingThreshold(bool disconnect) {
     }
     if (disconnect) {
         mHTTPDownloader->disconnect();
+        if (mSegmentPrefetcher != NULL) {
+            mSegmentPrefetcher->cancel(true /* disconnect */);
+        }
     } else {
         // allow reconnect
         mHTTPDownloader->reconnect();
@@ -784,6 +976,7 @@ status_t PlaylistFetcher::onStart(const sp<AMessage> &msg) {
         mSeqNumber = -1;
         mTimeChangeSignaled = false;
         mDownloadState->resetState();
+        mSegmentPrefetched = false;
     }
 
     postMonitorQueue();
@@ -811,6 +1004,7 @@ void PlaylistFetcher::onStop(const sp<AMessage> &msg) {
     }
 
     mDownloadState->resetState();
+    mSegmentPrefetched = false;
     mPacketSources.clear();
     mStreamTypeMask = 0;
 
@@ -942,7 +1136,7 @@ status_t PlaylistFetcher::refreshPlaylist() {
     if (delayUsToRefreshPlaylist() <= 0) {
         bool unchanged;
         sp<M3UParser> playlist = mHTTPDownloader->fetchPlaylist(
-                mURI.c_str(), mPlaylistHash, &unchanged);
+                mURI.c_str(), mPlaylistHash, &unchanged, mPlaylist);
 
         if (playlist == NULL) {
             if (unchanged) {
@@ -1335,6 +1529,38 @@ bool PlaylistFetcher::initDownloadState(
     return true;
 }
 
+void PlaylistFetcher::prefetchNextSegment() {
+    // Only prefetch in steady state, a fetcher that is starting up, switching
+    // or heading for a stopping point may not download the next segment.
+    if (mSegmentPrefetcher == NULL || mStartup || mStopParams != NULL
+            || mPlaylist == NULL) {
+        return;
+    }
+
+    int32_t firstSeqNumberInPlaylist = mPlaylist->getFirstSeqNumber();
+    if (mSeqNumber < firstSeqNumberInPlaylist
+            || mSeqNumber - firstSeqNumberInPlaylist >= (int32_t)mPlaylist->size()) {
+        return;
+    }
+
+    AString uri;
+    sp<AMessage> itemMeta;
+    if (!mPlaylist->itemAt(mSeqNumber - firstSeqNumberInPlaylist, &uri, &itemMeta)) {
+        return;
+    }
+
+    int64_t range_offset, range_length;
+    if (!itemMeta->findInt64("range-offset", &range_offset)
+            || !itemMeta->findInt64("range-length", &range_length)) {
+        range_offset = 0;
+        range_length = -1;
+    }
+    if (range_length > kMaxPrefetchBytes) {
+        return;
+    }
+    mSegmentPrefetcher->prefetch(uri, range_offset, range_length);
+}
+
 void PlaylistFetcher::onDownloadNext() {
     AString uri;
     sp<AMessage> itemMeta;
@@ -1363,6 +1589,7 @@ void PlaylistFetcher::onDownloadNext() {
             return;
         }
         FLOGV("fetching: '%s'", uri.c_str());
+        mSegmentPrefetched = false;
     }
 
     int64_t range_offset, range_length;
@@ -1372,16 +1599,37 @@ void PlaylistFetcher::onDownloadNext() {
         range_length = -1;
     }
 
+    sp<ABuffer> prefetched;
+    int64_t prefetchDelayUs = 0;
+    if (connectHTTP && mSegmentPrefetcher != NULL
+            && mSegmentPrefetcher->take(
+                    uri, range_offset, range_length, &prefetched, &prefetchDelayUs)) {
+        FLOGV("using prefetched segment (%zu bytes)", prefetched->size());
+        mSegmentPrefetched = true;
+    }
+
     // block-wise download
     bool shouldPause = false;
     ssize_t bytesRead;
     mLastIDRTimeUs = -1;
     do {
         int64_t startUs = ALooper::GetNowUs();
-        bytesRead = mHTTPDownloader->fetchBlock(
-                uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
-                NULL /* actualURL */, connectHTTP);
-        int64_t delayUs = ALooper::GetNowUs() - startUs;
+        int64_t delayUs;
+        if (prefetched != NULL) {
+            // the whole segment is handled as a single block
+            buffer = prefetched;
+            prefetched.clear();
+            bytesRead = buffer->size();
+            delayUs = prefetchDelayUs;
+        } else if (mSegmentPrefetched) {
+            bytesRead = 0;
+            delayUs = 0;
+        } else {
+            bytesRead = mHTTPDownloader->fetchBlock(
+                    uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
+                    NULL /* actualURL */, connectHTTP);
+            delayUs = ALooper::GetNowUs() - startUs;
+        }
 
         if (bytesRead == ERROR_NOT_CONNECTED) {
             return;
@@ -1554,6 +1802,8 @@ void PlaylistFetcher::onDownloadNext() {
     }
 
     ++mSeqNumber;
+    mSegmentPrefetched = false;
+    prefetchNextSegment();
 
     // if adapting, pause after found the next starting point
     if (mSeekMode != LiveSession::kSeekModeExactPosition && startUp != mStartup) {
@@ -1753,15 +2003,10 @@ status_t PlaylistFetcher::extractAndQueueAccessUnitsFromTs(const sp<ABuffer> &bu
         mSampleAesKeyItemChanged = false;
     }
 
-    size_t offset = 0;
-    while (offset + 188 <= buffer->size()) {
-        status_t err = mTSParser->feedTSPacket(buffer->data() + offset, 188);
-
-        if (err != OK) {
-            return err;
-        }
-
-        offset += 188;
+    size_t offset;
+    status_t err = mTSParser->feedTSPackets(buffer->data(), buffer->size(), &offset);
+    if (err != OK) {
+        return err;
     }
     // setRange to indicate consumed bytes.
     buffer->setRange(buffer->offset() + offset, buffer->size() - offset);
@@ -1824,7 +2069,7 @@ status_t PlaylistFetcher::extractAndQueueAccessUnitsFromTs(const sp<ABuffer> &bu
         }
     }
 
-    status_t err = OK;
+    err = OK;
     mLastIDRFound = false;
     bool hasAvcOrHevcSource = false;
     for (size_t i = mPacketSources.size(); i > 0;) {
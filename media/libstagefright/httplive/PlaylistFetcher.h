@@ -105,8 +105,10 @@ protected:
     };
 
     struct DownloadState;
+    struct SegmentPrefetcher;
 
     static const int64_t kMaxMonitorDelayUs;
+    static const int64_t kMaxPrefetchBytes;
     static const int32_t kNumSkipFrames;
 
     static bool bufferStartsWithTsSyncByte(const sp<ABuffer>& buffer);
@@ -189,6 +191,14 @@ protected:
 
     sp<DownloadState> mDownloadState;
 
+    // Downloads the segment after the one being parsed on its own looper and
+    // connection, so that the next fetch does not wait a full round trip.
+    // NULL unless media.httplive.prefetch-segments is set.
+    sp<ALooper> mPrefetchLooper;
+    sp<SegmentPrefetcher> mSegmentPrefetcher;
+    // The segment being parsed was fetched whole by mSegmentPrefetcher.
+    bool mSegmentPrefetched;
+
     bool mHasMetadata;
 
     // Set first to true if decrypting the first segment of a playlist segment. When
@@ -228,6 +238,7 @@ protected:
     void initSeqNumberForLiveStream(
             int32_t &firstSeqNumberInPlaylist,
             int32_t &lastSeqNumberInPlaylist);
+    void prefetchNextSegment();
     bool initDownloadState(
             AString &uri,
             sp<AMessage> &itemMeta,
@@ -28,10 +28,19 @@
 #include <utils/String8.h>
 #include <byteswap.h>
 
+#include <algorithm>
+#include <vector>
+
 namespace android {
 
 static const size_t kMaxMetadataSize = 3 * 1024 * 1024;
 
+// When album art is deferred, picture frames of at least this size are not read at open.
+static const size_t kMinDeferredArtSize = 32 * 1024;
+
+// Frames are read through a window of this size, as each read may be an IPC.
+static const size_t kFrameReadWindowSize = 16 * 1024;
+
 struct ID3::MemorySource : public DataSourceBase {
     MemorySource(const uint8_t *data, size_t size)
         : mData(data),
@@ -92,13 +101,17 @@ private:
 };
 
 
-ID3::ID3(DataSourceHelper *sourcehelper, bool ignoreV1, off64_t offset)
+ID3::ID3(DataSourceHelper *sourcehelper, bool ignoreV1, off64_t offset, bool deferAlbumArt)
     : mIsValid(false),
       mData(NULL),
       mSize(0),
       mFirstFrameOffset(0),
       mVersion(ID3_UNKNOWN),
-      mRawSize(0) {
+      mRawSize(0),
+      mDeferredSource(deferAlbumArt ? sourcehelper : NULL),
+      mDeferredArtOffset(0),
+      mDeferredArtSize(0),
+      mDeferredArt(NULL) {
     DataSourceUnwrapper source(sourcehelper);
     mIsValid = parseV2(&source, offset);
 
@@ -113,7 +126,11 @@ ID3::ID3(const uint8_t *data, size_t size, bool ignoreV1)
       mSize(0),
       mFirstFrameOffset(0),
       mVersion(ID3_UNKNOWN),
-      mRawSize(0) {
+      mRawSize(0),
+      mDeferredSource(NULL),
+      mDeferredArtOffset(0),
+      mDeferredArtSize(0),
+      mDeferredArt(NULL) {
     MemorySource *source = new (std::nothrow) MemorySource(data, size);
 
     if (source == NULL)
@@ -132,6 +149,7 @@ ID3::~ID3() {
         free(mData);
         mData = NULL;
     }
+    free(mDeferredArt);
 }
 
 bool ID3::isValid() const {
@@ -217,6 +235,19 @@ struct id3_header {
         return false;
     }
 
+    // Tags without unsynchronization can be walked frame by frame in the source, which
+    // allows skipping large pictures. v2.4 frames may each need transforming, read them whole.
+    if (mDeferredSource != NULL && size >= kMinDeferredArtSize && !(header.flags & 0x80)
+            && (header.version_major == 2 || header.version_major == 3)) {
+        mRawSize = size + sizeof(header);
+        if (!parseV2Frames(source, offset + sizeof(header), size,
+                header.version_major == 2, header.version_major == 3 && (header.flags & 0x40))) {
+            return false;
+        }
+        mVersion = header.version_major == 2 ? ID3_V2_2 : ID3_V2_3;
+        return true;
+    }
+
     mData = (uint8_t *)malloc(size);
 
     if (mData == NULL) {
@@ -388,6 +419,91 @@ struct id3_header {
     return true;
 }
 
+bool ID3::parseV2Frames(DataSourceBase *source, off64_t offset, size_t size,
+        bool isV2_2, bool hasExtHeader) {
+    // Reads [pos, pos + length) of the tag, through the window unless it is a large read.
+    std::vector<uint8_t> window;
+    size_t windowPos = 0;
+    auto readTag = [&](size_t pos, uint8_t *dst, size_t length) {
+        if (length > kFrameReadWindowSize / 2) {
+            return source->readAt(offset + pos, dst, length) == (ssize_t)length;
+        }
+        if (pos < windowPos || pos + length > windowPos + window.size()) {
+            window.resize(std::min(kFrameReadWindowSize, size - pos));
+            windowPos = pos;
+            if (window.size() < length || source->readAt(offset + pos, window.data(),
+                    window.size()) != (ssize_t)window.size()) {
+                window.clear();
+                return false;
+            }
+        }
+        memcpy(dst, &window[pos - windowPos], length);
+        return true;
+    };
+
+    size_t pos = 0;
+    if (hasExtHeader) {
+        // v2.3 does not have syncsafe integers
+        uint8_t extendedHeader[4];
+        if (size < 4 || !readTag(0, extendedHeader, 4)) {
+            return false;
+        }
+        size_t extendedHeaderSize = U32_AT(extendedHeader);
+        if (extendedHeaderSize > size - 4) {
+            return false;
+        }
+        pos = extendedHeaderSize + 4;
+    }
+
+    // The kept frames are copied back to back, the padding is dropped.
+    mData = (uint8_t *)malloc(size);
+    if (mData == NULL) {
+        return false;
+    }
+    mSize = 0;
+    mFirstFrameOffset = 0;
+
+    const size_t headerSize = isV2_2 ? 6 : 10;
+    const char *pictureId = isV2_2 ? "PIC" : "APIC";
+    bool hasPicture = false;
+    while (size - pos >= headerSize) {
+        uint8_t *frame = &mData[mSize];
+        if (!readTag(pos, frame, headerSize)) {
+            break;
+        }
+        if (frame[0] == '\0') {
+            break;  // padding
+        }
+        const size_t frameSize = isV2_2
+                ? (frame[3] << 16) | (frame[4] << 8) | frame[5] : U32_AT(&frame[4]);
+        if (frameSize > size - pos - headerSize) {
+            ALOGV("frame size %zu exceeds the tag", frameSize);
+            break;  // keep the frames before, like the Iterator does.
+        }
+        const size_t totalSize = headerSize + frameSize;
+        const bool isPicture = !memcmp(frame, pictureId, strlen(pictureId));
+        if (isPicture && frameSize >= kMinDeferredArtSize) {
+            // getAlbumArt() only returns the first picture, later large ones are dropped.
+            if (!hasPicture) {
+                mDeferredArtOffset = offset + pos;
+                mDeferredArtSize = totalSize;
+            }
+            hasPicture = true;
+            pos += totalSize;
+            continue;
+        }
+        hasPicture |= isPicture;
+        if (!readTag(pos + headerSize, frame + headerSize, frameSize)) {
+            break;
+        }
+        mSize += totalSize;
+        pos += totalSize;
+    }
+    ALOGV("read %zu of %zu bytes of frames, deferred album art %zu bytes",
+            mSize, size, mDeferredArtSize);
+    return true;
+}
+
 void ID3::removeUnsynchronization() {
 
     // This file has "unsynchronization", so we have to replace occurrences
@@ -950,94 +1066,99 @@ ID3::getAlbumArt(size_t *length, String8 *mime) const {
     *length = 0;
     mime->setTo("");
 
+    if (mDeferredArtSize > 0) {
+        // The first picture was skipped at open, read it now.
+        if (mDeferredArt == NULL) {
+            mDeferredArt = (uint8_t *)malloc(mDeferredArtSize);
+            if (mDeferredArt == NULL) {
+                return NULL;
+            }
+            if (mDeferredSource->readAt(mDeferredArtOffset, mDeferredArt, mDeferredArtSize)
+                    != (ssize_t)mDeferredArtSize) {
+                ALOGW("cannot read deferred album art");
+                free(mDeferredArt);
+                mDeferredArt = NULL;
+                return NULL;
+            }
+        }
+        const size_t headerSize = mVersion == ID3_V2_2 ? 6 : 10;
+        return parseAlbumArt(&mDeferredArt[headerSize], mDeferredArtSize - headerSize,
+                length, mime);
+    }
+
     Iterator it(
             *this,
             (mVersion == ID3_V2_3 || mVersion == ID3_V2_4) ? "APIC" : "PIC");
 
-    while (!it.done()) {
-        size_t size;
-        const uint8_t *data = it.getData(&size);
-        if (!data) {
+    if (it.done()) {
+        return NULL;
+    }
+    size_t size;
+    const uint8_t *data = it.getData(&size);
+    if (!data) {
+        return NULL;
+    }
+    return parseAlbumArt(data, size, length, mime);
+}
+
+const void *ID3::parseAlbumArt(
+        const uint8_t *data, size_t size, size_t *length, String8 *mime) const {
+    if (mVersion == ID3_V2_3 || mVersion == ID3_V2_4) {
+        uint8_t encoding = data[0];
+        size_t consumed = 1;
+
+        // *always* in an 8-bit encoding
+        size_t mimeLen = StringSize(&data[consumed], size - consumed, 0x00);
+        if (mimeLen > size - consumed) {
+            ALOGW("bogus album art size: mime");
             return NULL;
         }
+        mime->setTo((const char *)&data[consumed]);
+        consumed += mimeLen;
 
-        if (mVersion == ID3_V2_3 || mVersion == ID3_V2_4) {
-            uint8_t encoding = data[0];
-            size_t consumed = 1;
+        consumed++;  // picture type
+        if (consumed >= size) {
+            ALOGW("bogus album art size: pic type");
+            return NULL;
+        }
 
-            // *always* in an 8-bit encoding
-            size_t mimeLen = StringSize(&data[consumed], size - consumed, 0x00);
-            if (mimeLen > size - consumed) {
-                ALOGW("bogus album art size: mime");
-                return NULL;
-            }
-            mime->setTo((const char *)&data[consumed]);
-            consumed += mimeLen;
-
-#if 0
-            uint8_t picType = data[consumed];
-            if (picType != 0x03) {
-                // Front Cover Art
-                it.next();
-                continue;
-            }
-#endif
+        size_t descLen = StringSize(&data[consumed], size - consumed, encoding);
+        consumed += descLen;
 
-            consumed++;
-            if (consumed >= size) {
-                ALOGW("bogus album art size: pic type");
-                return NULL;
-            }
+        if (consumed >= size) {
+            ALOGW("bogus album art size: description");
+            return NULL;
+        }
 
-            size_t descLen = StringSize(&data[consumed], size - consumed, encoding);
-            consumed += descLen;
+        *length = size - consumed;
 
-            if (consumed >= size) {
-                ALOGW("bogus album art size: description");
-                return NULL;
-            }
+        return &data[consumed];
+    } else {
+        uint8_t encoding = data[0];
 
-            *length = size - consumed;
+        if (size <= 5) {
+            return NULL;
+        }
 
-            return &data[consumed];
+        if (!memcmp(&data[1], "PNG", 3)) {
+            mime->setTo("image/png");
+        } else if (!memcmp(&data[1], "JPG", 3)) {
+            mime->setTo("image/jpeg");
+        } else if (!memcmp(&data[1], "-->", 3)) {
+            mime->setTo("text/plain");
         } else {
-            uint8_t encoding = data[0];
-
-            if (size <= 5) {
-                return NULL;
-            }
-
-            if (!memcmp(&data[1], "PNG", 3)) {
-                mime->setTo("image/png");
-            } else if (!memcmp(&data[1], "JPG", 3)) {
-                mime->setTo("image/jpeg");
-            } else if (!memcmp(&data[1], "-->", 3)) {
-                mime->setTo("text/plain");
-            } else {
-                return NULL;
-            }
-
-#if 0
-            uint8_t picType = data[4];
-            if (picType != 0x03) {
-                // Front Cover Art
-                it.next();
-                continue;
-            }
-#endif
+            return NULL;
+        }
 
-            size_t descLen = StringSize(&data[5], size - 5, encoding);
-            if (descLen > size - 5) {
-                return NULL;
-            }
+        size_t descLen = StringSize(&data[5], size - 5, encoding);
+        if (descLen > size - 5) {
+            return NULL;
+        }
 
-            *length = size - 5 - descLen;
+        *length = size - 5 - descLen;
 
-            return &data[5 + descLen];
-        }
+        return &data[5 + descLen];
     }
-
-    return NULL;
 }
 
 bool ID3::parseV1(DataSourceBase *source) {
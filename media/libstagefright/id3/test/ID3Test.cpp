@@ -141,6 +141,19 @@ TEST_P(ID3albumArtTest, AlbumArtTest) {
         ASSERT_EQ(data, nullptr) << "Found album art when expected none!";
     }
 
+    // Deferring the album art must not change it.
+    ID3 deferredTag(&helper, false /* ignoreV1 */, 0 /* offset */, true /* deferAlbumArt */);
+    ASSERT_TRUE(deferredTag.isValid()) << "No valid deferred ID3 tag found for " << path;
+    size_t deferredDataSize;
+    String8 deferredMime;
+    const void *deferredData = deferredTag.getAlbumArt(&deferredDataSize, &deferredMime);
+    ASSERT_EQ(deferredData != nullptr, data != nullptr) << "Deferred album art differs";
+    if (data) {
+        ASSERT_EQ(deferredDataSize, dataSize) << "Deferred album art size differs";
+        ASSERT_EQ(deferredMime, mime) << "Deferred album art mime differs";
+        ASSERT_EQ(memcmp(deferredData, data, dataSize), 0) << "Deferred album art differs";
+    }
+
 #if (LOG_NDEBUG == 0)
     hexdump(data, dataSize > 128 ? 128 : dataSize);
 #endif
@@ -17,7 +17,9 @@
 #ifndef FRAME_DECODER_H_
 #define FRAME_DECODER_H_
 
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <media/stagefright/foundation/AString.h>
@@ -51,10 +53,18 @@ struct FrameDecoder : public RefBase {
 
     sp<IMemory> extractFrame(FrameRect *rect = NULL);
 
+    // Extracts the frame at |frameTimeUs| with the codec that extracted the
+    // previous frame. The returned memory is reused by the next extraction.
+    virtual sp<IMemory> extractFrameAtTime(int64_t /*frameTimeUs*/) { return NULL; }
+
     static sp<IMemory> getMetadataOnly(
             const sp<MetaData> &trackMeta, int colorFormat,
             bool thumbnail = false, uint32_t bitDepth = 0);
 
+    // Returns a copy of |frameMem| scaled to |width| x |height|, or of the
+    // same size if either is not positive.
+    static sp<IMemory> scaleFrame(const sp<IMemory> &frameMem, int32_t width, int32_t height);
+
 protected:
     virtual ~FrameDecoder();
 
@@ -85,6 +95,7 @@ protected:
     virtual status_t extractInternal();
 
     sp<MetaData> trackMeta()     const      { return mTrackMeta; }
+    const AString &componentName() const    { return mComponentName; }
     OMX_COLOR_FORMATTYPE dstFormat() const  { return mDstFormat; }
     ui::PixelFormat captureFormat() const   { return mCaptureFormat; }
     int32_t dstBpp()             const      { return mDstBpp; }
@@ -117,6 +128,17 @@ struct VideoFrameDecoder : public FrameDecoder {
             const sp<MetaData> &trackMeta,
             const sp<IMediaSource> &source);
 
+    virtual sp<IMemory> extractFrameAtTime(int64_t frameTimeUs) override;
+
+    // Asks for frames no larger than |width| x |height|, in the orientation of
+    // the returned frame. Must be called before init(). This only takes effect
+    // when the frames are captured from the output surface, where the scaling
+    // is done by the GPU as part of the capture.
+    void setTargetSize(int32_t width, int32_t height) {
+        mTargetWidth = width;
+        mTargetHeight = height;
+    }
+
 protected:
     virtual sp<AMessage> onGetFormatAndSeekOptions(
             int64_t frameTimeUs,
@@ -154,6 +176,13 @@ private:
     int64_t mTargetTimeUs;
     List<int64_t> mSampleDurations;
     int64_t mDefaultSampleDurationUs;
+    // Used by extractFrameAtTime() to choose between decoding forward and seeking.
+    int64_t mLastSampleTimeUs;
+    int64_t mLastSyncTimeUs;
+    int64_t mSyncIntervalUs;
+    int64_t mLastOutputTimeUs;
+    int32_t mTargetWidth;
+    int32_t mTargetHeight;
 
     sp<Surface> initSurface();
     status_t captureSurface();
@@ -201,6 +230,23 @@ private:
     int32_t mTilesDecoded;
     int32_t mTargetTiles;
 
+    // Tiles of the rect being extracted, and the tiles queued to mDecoder in
+    // decoding order. mQueuedTiles and mTilesRead are guarded by mSourceLock.
+    int32_t mFirstRectTile;
+    int32_t mLastRectTile;
+    int32_t mRectLeftCol;
+    int32_t mRectRightCol;
+    int32_t mLastSkippedTile;
+    std::deque<int32_t> mQueuedTiles;
+
+    // Tiled images can be decoded by up to mMaxTileDecoders codec instances
+    // at once, see extractTilesInParallel().
+    int32_t mMaxTileDecoders;
+    int32_t mTilesRead;
+    sp<AMessage> mTileFormat;
+    std::mutex mSourceLock;
+    std::mutex mFrameLock;
+
     struct ImageOutputThread;
     sp<ImageOutputThread> mThread;
     bool mUseMultiThread;
@@ -229,6 +275,16 @@ private:
     Mutexed<OutputInfo> mOutInfo;
 
     bool outputLoop();
+
+    status_t convertTile(
+            const sp<MediaCodecBuffer> &videoFrameBuffer,
+            const sp<AMessage> &outputFormat,
+            int32_t tileIndex);
+    status_t readNextTile(MediaBufferBase **mediaBuffer);
+    bool hasTilesToRead();
+    status_t readTile(const sp<MediaCodecBuffer> &codecBuffer, int32_t *tileIndex);
+    status_t decodeTiles(const sp<MediaCodec> &decoder);
+    status_t extractTilesInParallel();
 };
 
 }  // namespace android
@@ -36,7 +36,10 @@ struct ID3 {
         ID3_V2_4,
     };
 
-    explicit ID3(DataSourceHelper *source, bool ignoreV1 = false, off64_t offset = 0);
+    // If deferAlbumArt is true, a large album art frame is not read until getAlbumArt(), which
+    // then reads it from source. The source must outlive this object in that case.
+    explicit ID3(DataSourceHelper *source, bool ignoreV1 = false, off64_t offset = 0,
+            bool deferAlbumArt = false);
     ID3(const uint8_t *data, size_t size, bool ignoreV1 = false);
     ~ID3();
 
@@ -88,8 +91,18 @@ private:
     // only valid for IDV2+
     size_t mRawSize;
 
+    // Where the first picture frame is in the source, if its reading was deferred.
+    DataSourceHelper *mDeferredSource;
+    off64_t mDeferredArtOffset;
+    size_t mDeferredArtSize;
+    mutable uint8_t *mDeferredArt;  // the frame including its header, once read.
+
     bool parseV1(DataSourceBase *source);
     bool parseV2(DataSourceBase *source, off64_t offset);
+    bool parseV2Frames(DataSourceBase *source, off64_t offset, size_t size,
+            bool isV2_2, bool hasExtHeader);
+    const void *parseAlbumArt(
+            const uint8_t *data, size_t size, size_t *length, String8 *mime) const;
     void removeUnsynchronization();
     bool removeUnsynchronizationV2_4(bool iTunesHack, bool hasGlobalUnsync);
 
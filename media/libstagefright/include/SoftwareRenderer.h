@@ -51,6 +51,12 @@ private:
     ColorConverter *mConverter;
     YUVMode mYUVMode;
     sp<ANativeWindow> mNativeWindow;
+    // the format of the last rendered buffer, formats are not modified once shared
+    sp<AMessage> mFormat;
+    // whether window buffers are locked as YCbCr rather than mapped as one plane
+    bool mLockYCbCr;
+    // whether semi-planar frames go to flexible YUV window buffers
+    bool mFlexibleSemiPlanar;
     int32_t mWidth, mHeight, mStride;
     int32_t mCropLeft, mCropTop, mCropRight, mCropBottom;
     int32_t mCropWidth, mCropHeight;
@@ -287,6 +287,10 @@ protected:
     bool mIsStreamCorruptFree;
     bool mIsLowLatency;
 
+    // Timing of the phases of the current start, reported once the component is executing.
+    sp<AMessage> mStartMetrics;
+    int64_t mStartPhaseTimeUs;
+
     // If "mKeepComponentAllocated" we only transition back to Loaded state
     // and do not release the component instance.
     bool mKeepComponentAllocated;
@@ -20,6 +20,7 @@
 
 #include <media/stagefright/foundation/ABase.h>
 #include <utils/KeyedVector.h>
+#include <utils/List.h>
 #include <utils/RefBase.h>
 #include <utils/Thread.h>
 
@@ -27,6 +28,7 @@
 
 namespace android {
 
+struct ABuffer;
 struct AMessage;
 
 // Helper class to manage a number of live sockets (datagram and stream-based)
@@ -77,6 +79,14 @@ struct ANetworkSession : public RefBase {
             int32_t sessionID, const void *data, ssize_t size = -1,
             bool timeValid = false, int64_t timeUs = -1ll);
 
+    // Queues a number of datagrams for sending, waking up the network thread
+    // only once. On UDP sessions the buffers are queued without being copied
+    // and must not be modified afterwards. The time, if valid, applies to the
+    // last datagram.
+    status_t sendDatagrams(
+            int32_t sessionID, const List<sp<ABuffer> > &datagrams,
+            bool timeValid = false, int64_t timeUs = -1ll);
+
     status_t switchToWebSocketMode(int32_t sessionID);
 
     enum NotificationReason {
@@ -20,6 +20,8 @@
 
 #include <list>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <stdint.h>
 
@@ -182,6 +184,13 @@ struct CodecBase : public AHandler, /* static */ ColorUtils {
          * Notify MediaCodec that the first tunnel frame is ready.
          */
         virtual void onFirstTunnelFrameReady() = 0;
+        /**
+         * Notify MediaCodec of codec specific metrics.
+         *
+         * @param updatedMetrics  int64 entries whose names are metrics keys
+         *                        and whose values replace the current values.
+         */
+        virtual void onMetricsUpdated(const sp<AMessage> &updatedMetrics) = 0;
     };
 
     /**
@@ -212,6 +221,17 @@ struct CodecBase : public AHandler, /* static */ ColorUtils {
          */
         virtual void onOutputBufferAvailable(
                 size_t index, const sp<MediaCodecBuffer> &buffer) = 0;
+        /**
+         * Notify MediaCodec that output buffers are available with given indices,
+         * in the order they are listed. Same as calling onOutputBufferAvailable()
+         * for each buffer, but lets MediaCodec handle them in one dispatch.
+         */
+        virtual void onOutputBuffersAvailable(
+                const std::vector<std::pair<size_t, sp<MediaCodecBuffer>>> &buffers) {
+            for (const std::pair<size_t, sp<MediaCodecBuffer>> &buffer : buffers) {
+                onOutputBufferAvailable(buffer.first, buffer.second);
+            }
+        }
     };
     enum {
         kMaxCodecBufferSize = 8192 * 4096 * 4, // 8K RGBA
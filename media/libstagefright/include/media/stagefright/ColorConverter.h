@@ -94,6 +94,9 @@ private:
     // returns the YUV2RGB matrix coefficients according to the color aspects and bit depth
     const struct Coeffs *getMatrix() const;
 
+    // Converts the cropped area of |src| into that of |dst| on the calling thread.
+    status_t convertBand(const BitmapParams &src, const BitmapParams &dst);
+
     status_t convertCbYCrY(
             const BitmapParams &src, const BitmapParams &dst);
 
@@ -103,6 +106,11 @@ private:
     status_t convertYUV420PlanarUseLibYUV(
             const BitmapParams &src, const BitmapParams &dst);
 
+    status_t convertI420UseLibYUV(
+            const uint8_t *src_y, size_t src_stride_y,
+            const uint8_t *src_u, const uint8_t *src_v, size_t src_stride_uv,
+            size_t width, size_t height, const BitmapParams &dst);
+
     status_t convertYUV420SemiPlanarUseLibYUV(
             const BitmapParams &src, const BitmapParams &dst);
 
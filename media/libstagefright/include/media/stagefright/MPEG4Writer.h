@@ -23,7 +23,9 @@
 #include <media/stagefright/MediaWriter.h>
 #include <utils/List.h>
 #include <utils/threads.h>
+#include <atomic>
 #include <map>
+#include <memory>
 #include <media/stagefright/foundation/AHandlerReflector.h>
 #include <media/stagefright/foundation/ALooper.h>
 #include <mutex>
@@ -89,6 +91,7 @@ private:
         kWhatSwitch                  = 'swch',
         kWhatIOError                 = 'ioer',
         kWhatFallocateError          = 'faer',
+        kWhatPreAllocateAhead        = 'prea',
         kWhatNoIOErrorSoFar          = 'noie'
     };
 
@@ -135,6 +138,12 @@ protected:
                         std::greater<std::chrono::microseconds>> mWriteDurationPQ;
     const uint8_t kWriteDurationsCount = 5;
 
+    // Optional asynchronous backend for the chunks written by the writer thread,
+    // enabled with media.mp4writer.async-write.
+    struct AsyncWriter;
+    std::unique_ptr<AsyncWriter> mAsyncWriter;
+    bool mAsyncWriteActive;  // Writes are staged in mAsyncWriter instead of issued directly.
+
     sp<ALooper> mLooper;
     sp<AHandlerReflector<MPEG4Writer> > mReflector;
 
@@ -145,6 +154,16 @@ protected:
     std::mutex mFallocMutex;
     bool mPreAllocFirstTime; // Pre-allocate space for file and track headers only once per file.
     uint64_t mPrevAllTracksTotalMetaDataSizeEstimate;
+    // Adaptive preallocation state, guarded by mFallocMutex.
+    off64_t mPreAllocateRequiredEndOffset;  // End of the space requested by the tracks so far.
+    int32_t mPreAllocateGeneration;  // Invalidates pending look ahead requests.
+    bool mPreAllocateAheadPending;   // A kWhatPreAllocateAhead message is posted.
+    int64_t mPreAllocateBytesPerSec;  // Recent rate of the requested space.
+    int64_t mPreAllocateRateStartUs;
+    uint64_t mPreAllocateRateBytes;
+    uint32_t mPreAllocateHits;       // Requests served by space allocated earlier.
+    uint32_t mPreAllocateMisses;     // Requests that had to call fallocate.
+    uint32_t mPreAllocateAheadCount;  // Allocations made ahead on the looper.
 
     List<Track *> mTracks;
 
@@ -186,6 +205,12 @@ protected:
         // Max time interval between neighboring chunks
         int64_t mMaxInterChunkDurUs;
 
+        // Fragmented recording: samples of the next movie fragment
+        List<MediaBuffer *> mFragmentSamples;
+        bool mInMoov;                 // Track is described in the moov box
+        int64_t mStartOffsetUs;       // Track start relative to the movie start
+        int64_t mCtsShiftTicks;       // Composition offset of the first sample, or INT64_MIN
+        int64_t mLastDurationTicks;   // Duration of the last written sample
     };
 
     bool            mIsFirstChunk;
@@ -194,6 +219,13 @@ protected:
     List<ChunkInfo> mChunkInfos;            // Chunk infos
     Condition       mChunkReadyCondition;   // Signal that chunks are available
 
+    // Chunks handed over by the track threads, most recent first. The writer
+    // thread takes all of them at once and moves them to mChunkInfos. Only the
+    // push that finds the list empty signals mChunkReadyCondition, so a batch of
+    // chunks costs the writer thread a single wakeup.
+    struct PendingChunk;
+    std::atomic<PendingChunk *> mPendingChunks;
+
     // HEIF writing
     typedef key_value_pair_t< const char *, Vector<uint16_t> > ItemRefs;
     typedef struct _ItemInfo {
@@ -258,9 +290,34 @@ protected:
     // Return true if a chunk is found; otherwise, return false.
     bool findChunkToWrite(Chunk *chunk);
 
+    // Add the chunk to mPendingChunks and return true if that was empty.
+    bool pushPendingChunk(PendingChunk *pending);
+
+    // Move the chunks in mPendingChunks to mChunkInfos, oldest first.
+    void takePendingChunks();
+
     // Actually write the given chunk to the file.
     void writeChunkToFile(Chunk* chunk);
 
+    // Stage the following writes of the writer thread in mAsyncWriter, if enabled.
+    void startAsyncWrites();
+    // Wait for the staged asynchronous writes and move the file offset past them.
+    void finishAsyncWrites();
+
+    // Fragmented recording, see kKeyFragmentDuration. Samples are written out in
+    // movie fragments (moof + mdat) of about mFragmentDurationUs each.
+    int64_t mFragmentDurationUs;
+    uint32_t mFragmentSequence;
+    bool mFragmentedMoovWritten;
+    off64_t mMehdOffset;  // Offset of the fragment duration in the 'mehd' box.
+    bool isFragmented() const { return mFragmentDurationUs > 0; }
+    void addFragmentSamples(Chunk *chunk);
+    // Write the pending samples as a movie fragment. Unless flushAll is set, the
+    // last sample of each track is kept back since its duration is not known yet.
+    void writeFragment(bool flushAll);
+    void writeFragmentedMoovBox();
+    void writeFragmentedDuration(int64_t durationUs);
+
     // Adjust other track media clock (presumably wall clock)
     // based on audio track media clock with the drift time.
     int64_t mDriftTimeUs;
@@ -333,6 +390,12 @@ protected:
      * Truncate file as per the size used for metadata and actual data in a session.
      */
     bool truncatePreAllocation();
+    /*
+     * Extend the preallocated space ahead of the requests of the tracks.
+     * Called on the looper thread, so the track threads rarely call fallocate.
+     */
+    void preAllocateAhead(int32_t generation);
+    uint64_t preAllocateAheadSize_l() const;
 
     // HEIF writing
     void writeIlocBox();
@@ -176,6 +176,18 @@ struct MediaCodec : public AHandler {
             uint32_t flags,
             AString *errorDetailMsg = NULL);
 
+    // Queue an input buffer holding several consecutive access units of the given sizes,
+    // which must add up to |size|. Decoders that report "max-input-access-units" in their
+    // input format decode all of them into one output buffer.
+    status_t queueInputAccessUnits(
+            size_t index,
+            size_t offset,
+            size_t size,
+            const std::vector<uint32_t> &accessUnitSizes,
+            int64_t presentationTimeUs,
+            uint32_t flags,
+            AString *errorDetailMsg = NULL);
+
     status_t queueSecureInputBuffer(
             size_t index,
             size_t offset,
@@ -432,6 +444,7 @@ private:
     Mutex mMetricsLock;
     mediametrics_handle_t mMetricsHandle = 0;
     nsecs_t mLifetimeStartNs = 0;
+    nsecs_t mStartRequestedNs = 0;
     void initMediametrics();
     void updateMediametrics();
     void flushMediametrics();
@@ -441,6 +454,7 @@ private:
     constexpr const char *asString(TunnelPeekState state, const char *default_string="?");
     void updateTunnelPeek(const sp<AMessage> &msg);
     void updatePlaybackDuration(const sp<AMessage> &msg);
+    void updateRenderDrift(const sp<AMessage> &msg);
 
     sp<AMessage> mOutputFormat;
     sp<AMessage> mInputFormat;
@@ -486,6 +500,23 @@ private:
             uint32_t flags,
             mediametrics_handle_t handle);
 
+    // the shaped format of an encoding whose shaper takes feedback, along with
+    // the encoder output gathered since the shaper last saw it.
+    // only touched in configure() and then on the looper (feedbackShaper()).
+    sp<AMessage> mShapedFormat;
+    int64_t mShapingIntervalStartUs = -1;
+    int64_t mShapingIntervalLastUs = -1;
+    int64_t mShapingIntervalBytes = 0;
+    int64_t mShapingIntervalFrames = 0;
+    int64_t mShapingIntervalQpSum = 0;
+    int64_t mShapingIntervalQpFrames = 0;
+    int64_t mShapingFeedbackUpdates = 0;
+
+    // hands the encoder output of the last GOP to the shaper and applies any
+    // parameter updates it returns.
+    void feedbackShaper(int64_t presentationUs, int32_t flags,
+                        const sp<MediaCodecBuffer> &buffer);
+
     // populate the format shaper library with information for this codec encoding
     // for the indicated media type
     status_t setupFormatShaper(AString mediaType);
@@ -574,6 +605,7 @@ private:
 
     void onInputBufferAvailable();
     void onOutputBufferAvailable();
+    void onDrainThisBuffer(const sp<AMessage> &msg);
     void onError(status_t err, int32_t actionCode, const char *detail = NULL);
     void onOutputFormatChanged();
 
@@ -630,6 +662,18 @@ private:
                                                  // when low latency is on
     int64_t mInputBufferCounter;  // number of input buffers queued since last reset/flush
 
+    // dequeue calls that returned -EAGAIN because no buffer was available
+    int64_t mInputStarvationCount = 0;
+    int64_t mOutputStarvationCount = 0;
+
+    // render time and media time of the last rendered frame, for the render drift
+    int64_t mLastRenderTimeNs = -1;
+    int64_t mLastRenderMediaTimeUs = -1;
+
+    // time spent in each state, updated on state changes
+    nsecs_t mStateStartNs = 0;
+    nsecs_t mTimeInStateNs[RELEASING + 1] = {};
+
     class ReleaseSurface;
     std::unique_ptr<ReleaseSurface> mReleaseSurface;
 
@@ -648,6 +692,16 @@ private:
         kLatencyHistWidth = 2000,
         kLatencyHistFloor = 2000,
 
+        // finer buckets for the frames processed while low latency mode is on
+        kLowLatencyHistBuckets = 20,
+        kLowLatencyHistWidth = 500,
+        kLowLatencyHistFloor = 0,
+
+        // the shape of the render drift histogram buckets
+        kRenderDriftHistBuckets = 20,
+        kRenderDriftHistWidth = 1000,
+        kRenderDriftHistFloor = 0,
+
         // how many samples are in the 'recent latency' histogram
         // 300 frames = 5 sec @ 60fps or ~12 sec @ 24fps
         kRecentLatencyFrames = 300,
@@ -674,6 +728,7 @@ private:
         int64_t getCount() const { return mCount; }
         int64_t getSum() const { return mSum; }
         int64_t getAvg() const { return mSum / (mCount == 0 ? 1 : mCount); }
+        int64_t getPercentile(int percentile) const;
         std::string emit();
       private:
         int64_t mFloor, mCeiling, mWidth;
@@ -685,6 +740,8 @@ private:
     };
 
     Histogram mLatencyHist;
+    Histogram mLowLatencyHist;  // latency of the frames queued while low latency is on
+    Histogram mRenderDriftHist; // |render interval - media time interval| between frames
 
     std::function<sp<CodecBase>(const AString &, const char *)> mGetCodecBase;
     std::function<status_t(const AString &, sp<MediaCodecInfo> *)> mGetCodecInfo;
@@ -109,8 +109,24 @@ private:
      */
     MediaCodecList(std::vector<MediaCodecListBuilderBase*> builders);
 
+    /**
+     * Creates an empty list. Only used by `FromCache()`.
+     */
+    MediaCodecList();
+
     ~MediaCodecList();
 
+    /**
+     * Loads a list previously written by `writeToCache()`. Returns null if the cache is
+     * missing, corrupted or was built for a different system, vendor or media APEX version.
+     */
+    static sp<MediaCodecList> FromCache(const char *path);
+
+    /**
+     * Serializes this list to `path` so that later processes can skip building it.
+     */
+    void writeToCache(const char *path) const;
+
     status_t initCheck() const;
 
     MediaCodecList(const MediaCodecList&) = delete;
@@ -23,6 +23,8 @@
 #include <media/stagefright/foundation/Mutexed.h>
 #include <media/stagefright/PersistentSurface.h>
 
+#include <map>
+
 namespace android {
 
 struct ALooper;
@@ -30,6 +32,7 @@ struct AMessage;
 struct AReplyToken;
 class IGraphicBufferProducer;
 struct MediaCodec;
+class MediaCodecBuffer;
 
 struct MediaCodecSource : public MediaSource,
                           public MediaBufferObserver {
@@ -91,6 +94,7 @@ private:
         kWhatSetStopTimeUs,
         kWhatGetFirstSampleSystemTimeUs,
         kWhatStopStalled,
+        kWhatReleaseOutputBuffer,
     };
 
     MediaCodecSource(
@@ -161,6 +165,17 @@ private:
     };
     Mutexed<Output> mOutput;
 
+    // Encoder output buffers handed out without a copy, by the MediaBuffer that
+    // references them. They go back to the encoder when that MediaBuffer is
+    // returned. Once mMaxZeroCopyOutputs are out, output buffers are copied
+    // again so that a slow reader does not hold up the encoder.
+    struct ZeroCopyOutput {
+        size_t mIndex;
+        sp<MediaCodecBuffer> mBuffer;
+    };
+    Mutexed<std::map<MediaBufferBase *, ZeroCopyOutput>> mZeroCopyOutputs;
+    size_t mMaxZeroCopyOutputs;
+
     int32_t mGeneration;
 
     int64_t mPrevBufferTimestampUs;
@@ -260,6 +260,9 @@ enum {
     // Treat empty track as malformed for MediaRecorder.
     kKeyEmptyTrackMalFormed = 'nemt', // bool (int32_t)
 
+    // Write movie fragments of about this duration instead of a single moov.
+    kKeyFragmentDuration = 'frgd', // int64_t (usecs)
+
     kKeyVps              = 'sVps', // int32_t, indicates that a buffer has vps.
     kKeySps              = 'sSps', // int32_t, indicates that a buffer has sps.
     kKeyPps              = 'sPps', // int32_t, indicates that a buffer has pps.
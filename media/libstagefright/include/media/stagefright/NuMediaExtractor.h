@@ -94,6 +94,23 @@ struct NuMediaExtractor : public RefBase {
     status_t getSampleTrackIndex(size_t *trackIndex);
     status_t getSampleTime(int64_t *sampleTimeUs);
     status_t getSampleMeta(sp<MetaData> *sampleMeta);
+
+    struct SampleInfo {
+        size_t mTrackIndex;
+        int64_t mSampleTimeUs;
+        size_t mOffset;  // of the sample data in the batch buffer
+        size_t mSize;
+        bool mIsSync;
+    };
+    // readSamples() copies up to maxSamples samples, in the order advance() visits them, back
+    // to back into buffer and advances past them, all under one lock. The batch ends early
+    // before a sample that does not fit or that is encrypted. That sample stays current, so
+    // its crypto info can still be read through getSampleMeta(). Returns -ENOMEM or
+    // ERROR_UNSUPPORTED if the current sample itself is too large or encrypted.
+    status_t readSamples(
+            uint8_t *buffer, size_t capacity,
+            SampleInfo *samples, size_t maxSamples, size_t *numSamples);
+
     status_t getMetrics(Parcel *reply);
 
     bool getCachedDuration(int64_t *durationUs, bool *eos) const;
@@ -44,6 +44,7 @@
 #include <utils/Vector.h>
 
 #include <inttypes.h>
+#include <string.h>
 
 namespace android {
 using hardware::hidl_string;
@@ -1889,8 +1890,40 @@ status_t ATSParser::feedTSPacket(const void *data, size_t size,
         return BAD_VALUE;
     }
 
-    ABitReader br((const uint8_t *)data, kTSPacketSize);
-    return parseTS(&br, event);
+    return parseTS((const uint8_t *)data, event);
+}
+
+status_t ATSParser::feedTSPackets(const void *_data, size_t size, size_t *consumed) {
+    const uint8_t *data = (const uint8_t *)_data;
+    size_t offset = 0;
+    status_t err = OK;
+    while (offset + kTSPacketSize <= size) {
+        if (data[offset] != 0x47) {
+            // Resynchronize on a sync byte that starts two packets in a row, or
+            // that starts the last whole packet in the buffer.
+            size_t start = offset;
+            const uint8_t *sync = data + offset;
+            while ((sync = (const uint8_t *)memchr(
+                    sync + 1, 0x47, size - (sync + 1 - data))) != NULL) {
+                size_t next = (sync - data) + kTSPacketSize;
+                if (next + kTSPacketSize > size || data[next] == 0x47) {
+                    break;
+                }
+            }
+            offset = sync != NULL ? sync - data : size;
+            ALOGW("skipped %zu bytes to find TS sync byte", offset - start);
+            continue;
+        }
+
+        err = parseTS(data + offset, NULL /* event */);
+        offset += kTSPacketSize;
+        if (err != OK) {
+            break;
+        }
+    }
+
+    *consumed = offset < size ? offset : size;
+    return err;
 }
 
 status_t ATSParser::setMediaCas(const sp<ICas> &cas) {
@@ -2201,37 +2234,42 @@ status_t ATSParser::parseAdaptationField(
     return OK;
 }
 
-status_t ATSParser::parseTS(ABitReader *br, SyncEvent *event) {
+status_t ATSParser::parseTS(const uint8_t *packet, SyncEvent *event) {
     ALOGV("---");
 
-    unsigned sync_byte = br->getBits(8);
+    // The fixed header is decoded from the bytes directly, only the
+    // adaptation field and the payload go through a bit reader.
+    unsigned sync_byte = packet[0];
     if (sync_byte != 0x47u) {
         ALOGE("[error] parseTS: return error as sync_byte=0x%x", sync_byte);
         return BAD_VALUE;
     }
 
-    if (br->getBits(1)) {  // transport_error_indicator
+    if (packet[1] & 0x80) {  // transport_error_indicator
         // silently ignore.
         return OK;
     }
 
-    unsigned payload_unit_start_indicator = br->getBits(1);
+    unsigned payload_unit_start_indicator = (packet[1] >> 6) & 1;
     ALOGV("payload_unit_start_indicator = %u", payload_unit_start_indicator);
 
-    MY_LOGV("transport_priority = %u", br->getBits(1));
+    MY_LOGV("transport_priority = %u", (packet[1] >> 5) & 1);
 
-    unsigned PID = br->getBits(13);
+    unsigned PID = ((packet[1] & 0x1f) << 8) | packet[2];
     ALOGV("PID = 0x%04x", PID);
 
-    unsigned transport_scrambling_control = br->getBits(2);
+    unsigned transport_scrambling_control = packet[3] >> 6;
     ALOGV("transport_scrambling_control = %u", transport_scrambling_control);
 
-    unsigned adaptation_field_control = br->getBits(2);
+    unsigned adaptation_field_control = (packet[3] >> 4) & 3;
     ALOGV("adaptation_field_control = %u", adaptation_field_control);
 
-    unsigned continuity_counter = br->getBits(4);
+    unsigned continuity_counter = packet[3] & 0x0f;
     ALOGV("PID = 0x%04x, continuity_counter = %u", PID, continuity_counter);
 
+    ABitReader bits(packet + 4, kTSPacketSize - 4);
+    ABitReader *br = &bits;
+
     // ALOGI("PID = 0x%04x, continuity_counter = %u", PID, continuity_counter);
 
     status_t err = OK;
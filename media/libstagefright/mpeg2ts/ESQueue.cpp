@@ -33,6 +33,7 @@
 #include <media/cas/DescramblerAPI.h>
 #include <media/hardware/CryptoAPI.h>
 
+#include <algorithm>
 #include <inttypes.h>
 #include <netinet/in.h>
 
@@ -667,25 +668,39 @@ status_t ElementaryStreamQueue::appendData(
         }
     }
 
-    size_t neededSize = (mBuffer == NULL ? 0 : mBuffer->size()) + size;
-    if (mBuffer == NULL || neededSize > mBuffer->capacity()) {
-        neededSize = (neededSize + 65535) & ~65535;
+    // Dequeued data is dropped from the front of mBuffer by skipBufferData()
+    // without moving the rest. The pending data is only moved back to the
+    // start here, once the room at the end runs out, and only if the unused
+    // room at the front is at least as large. Otherwise the buffer grows to
+    // twice the pending data, so that each byte is moved a bounded number of
+    // times no matter how much data is pending.
+    size_t pendingSize = (mBuffer == NULL ? 0 : mBuffer->size());
+    size_t neededSize = pendingSize + size;
+    if (mBuffer == NULL || mBuffer->offset() + neededSize > mBuffer->capacity()) {
+        if (mBuffer != NULL && neededSize <= mBuffer->capacity()
+                && mBuffer->offset() >= pendingSize) {
+            memmove(mBuffer->base(), mBuffer->data(), pendingSize);
+            mBuffer->setRange(0, pendingSize);
+        } else {
+            neededSize = std::max(neededSize, 2 * pendingSize);
+            neededSize = (neededSize + 65535) & ~65535;
 
-        ALOGV("resizing buffer to size %zu", neededSize);
+            ALOGV("resizing buffer to size %zu", neededSize);
 
-        sp<ABuffer> buffer = new ABuffer(neededSize);
-        if (mBuffer != NULL) {
-            memcpy(buffer->data(), mBuffer->data(), mBuffer->size());
-            buffer->setRange(0, mBuffer->size());
-        } else {
-            buffer->setRange(0, 0);
-        }
+            sp<ABuffer> buffer = new ABuffer(neededSize);
+            if (mBuffer != NULL) {
+                memcpy(buffer->data(), mBuffer->data(), mBuffer->size());
+                buffer->setRange(0, mBuffer->size());
+            } else {
+                buffer->setRange(0, 0);
+            }
 
-        mBuffer = buffer;
+            mBuffer = buffer;
+        }
     }
 
     memcpy(mBuffer->data() + mBuffer->size(), data, size);
-    mBuffer->setRange(0, mBuffer->size() + size);
+    mBuffer->setRange(mBuffer->offset(), mBuffer->size() + size);
 
     RangeInfo info;
     info.mLength = size;
@@ -894,11 +909,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnit() {
         memcpy(accessUnit->data(), mBuffer->data(), info.mLength);
         accessUnit->meta()->setInt64("timeUs", info.mTimestampUs);
 
-        memmove(mBuffer->data(),
-                mBuffer->data() + info.mLength,
-                mBuffer->size() - info.mLength);
-
-        mBuffer->setRange(0, mBuffer->size() - info.mLength);
+        skipBufferData(info.mLength);
 
         if (mFormat == NULL) {
             mFormat = new MetaData;
@@ -999,12 +1010,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitEAC3() {
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
+    skipBufferData(syncStartPos + payloadSize);
 
     return accessUnit;
 }
@@ -1063,12 +1069,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAC4() {
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
+    skipBufferData(syncStartPos + payloadSize);
     return accessUnit;
 }
 
@@ -1130,12 +1131,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitPCMAudio() {
         ptr[i] = ntohs(ptr[i]);
     }
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + 4 + payloadSize,
-            mBuffer->size() - 4 - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - 4 - payloadSize);
+    skipBufferData(4 + payloadSize);
 
     return accessUnit;
 }
@@ -1279,9 +1275,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAAC() {
     sp<ABuffer> accessUnit = new ABuffer(offset);
     memcpy(accessUnit->data(), mBuffer->data(), offset);
 
-    memmove(mBuffer->data(), mBuffer->data() + offset,
-            mBuffer->size() - offset);
-    mBuffer->setRange(0, mBuffer->size() - offset);
+    skipBufferData(offset);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
@@ -1289,6 +1283,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAAC() {
     return accessUnit;
 }
 
+void ElementaryStreamQueue::skipBufferData(size_t size) {
+    CHECK_LE(size, mBuffer->size());
+    mBuffer->setRange(mBuffer->offset() + size, mBuffer->size() - size);
+}
+
 int64_t ElementaryStreamQueue::fetchTimestamp(
         size_t size, int32_t *pesOffset, int32_t *pesScramblingControl) {
     int64_t timeUs = -1;
@@ -1466,11 +1465,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitH264() {
             const NALPosition &pos = nals.itemAt(nals.size() - 1);
             size_t nextScan = pos.nalOffset + pos.nalSize;
 
-            memmove(mBuffer->data(),
-                    mBuffer->data() + nextScan,
-                    mBuffer->size() - nextScan);
-
-            mBuffer->setRange(0, mBuffer->size() - nextScan);
+            skipBufferData(nextScan);
 
             int64_t timeUs = fetchTimestamp(nextScan);
             if (timeUs < 0LL) {
@@ -1552,11 +1547,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGAudio() {
     sp<ABuffer> accessUnit = new ABuffer(frameSize);
     memcpy(accessUnit->data(), data, frameSize);
 
-    memmove(mBuffer->data(),
-            mBuffer->data() + frameSize,
-            mBuffer->size() - frameSize);
-
-    mBuffer->setRange(0, mBuffer->size() - frameSize);
+    skipBufferData(frameSize);
 
     int64_t timeUs = fetchTimestamp(frameSize);
     if (timeUs < 0LL) {
@@ -1679,11 +1670,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
         currentStartCode = data[offset + 3];
 
         if (currentStartCode == 0xb3 && mFormat == NULL) {
-            memmove(mBuffer->data(), mBuffer->data() + offset, size - offset);
+            skipBufferData(offset);
+            data = mBuffer->data();
             size -= offset;
             (void)fetchTimestamp(offset);
             offset = 0;
-            mBuffer->setRange(0, size);
         }
 
         if ((prevStartCode == 0xb3 && currentStartCode != 0xb5)
@@ -1712,11 +1703,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
                 sp<ABuffer> csd = new ABuffer(offset);
                 memcpy(csd->data(), data, offset);
 
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                skipBufferData(offset);
                 size -= offset;
                 (void)fetchTimestamp(offset);
                 offset = 0;
@@ -1755,11 +1742,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
                 sp<ABuffer> accessUnit = new ABuffer(offset);
                 memcpy(accessUnit->data(), data, offset);
 
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                skipBufferData(offset);
 
                 int64_t timeUs = fetchTimestamp(offset);
                 if (timeUs < 0LL) {
@@ -1804,25 +1787,19 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
 
 static ssize_t getNextChunkSize(
         const uint8_t *data, size_t size) {
-    static const char kStartCode[] = "\x00\x00\x01";
-
     // per ISO/IEC 14496-2 6.2.1, a chunk has a 3-byte prefix + 1-byte start code
     // we need at least <prefix><start><next prefix> to successfully scan
     if (size < 3 + 1 + 3) {
         return -EAGAIN;
     }
 
-    if (memcmp(kStartCode, data, 3)) {
+    if (findNextStartCode(data, 3) != data) {
         return -EAGAIN;
     }
 
-    size_t offset = 4;
-    while (offset + 2 < size) {
-        if (!memcmp(&data[offset], kStartCode, 3)) {
-            return offset;
-        }
-
-        ++offset;
+    size_t offset = findNextStartCode(&data[4], size - 4) - data;
+    if (offset < size) {
+        return offset;
     }
 
     return -EAGAIN;
@@ -1954,9 +1931,9 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
                     sp<ABuffer> accessUnit = new ABuffer(offset);
                     memcpy(accessUnit->data(), data, offset);
 
-                    memmove(data, &data[offset], size - offset);
+                    skipBufferData(offset);
+                    data = mBuffer->data();
                     size -= offset;
-                    mBuffer->setRange(0, size);
 
                     int64_t timeUs = fetchTimestamp(offset);
                     if (timeUs < 0LL) {
@@ -1992,10 +1969,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
 
         if (discard) {
             (void)fetchTimestamp(offset);
-            memmove(data, &data[offset], size - offset);
+            skipBufferData(offset);
+            data = mBuffer->data();
             size -= offset;
             offset = 0;
-            mBuffer->setRange(0, size);
         } else {
             offset += chunkSize;
         }
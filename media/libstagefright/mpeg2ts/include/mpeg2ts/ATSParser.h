@@ -122,6 +122,13 @@ struct ATSParser : public RefBase {
     status_t feedTSPacket(
             const void *data, size_t size, SyncEvent *event = NULL);
 
+    // Feed all whole TS packets in |data| into the parser. Bytes that are not
+    // part of a packet are skipped by searching for the next sync byte that is
+    // followed by another one a packet later. A trailing partial packet is not
+    // consumed. |*consumed| is set to the number of bytes consumed, also when
+    // an error is returned for a packet.
+    status_t feedTSPackets(const void *data, size_t size, size_t *consumed);
+
     void signalDiscontinuity(
             DiscontinuityType type, const sp<AMessage> &extra);
 
@@ -242,8 +249,8 @@ private:
     status_t parseAdaptationField(
             ABitReader *br, unsigned PID, unsigned *random_access_indicator);
 
-    // see feedTSPacket().
-    status_t parseTS(ABitReader *br, SyncEvent *event);
+    // see feedTSPacket(). |packet| holds kTSPacketSize bytes.
+    status_t parseTS(const uint8_t *packet, SyncEvent *event);
 
     void updatePCR(unsigned PID, uint64_t PCR, uint64_t byteOffsetFromStart);
 
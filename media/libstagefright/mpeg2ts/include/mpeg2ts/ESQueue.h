@@ -129,6 +129,9 @@ protected:
     sp<ABuffer> dequeueAccessUnitPCMAudio();
     sp<ABuffer> dequeueAccessUnitMetadata();
 
+    // drops "size" bytes of dequeued data from the front of mBuffer.
+    void skipBufferData(size_t size);
+
     // consume a logical (compressed) access unit of size "size",
     // returns its timestamp in us (or -1 if no time information).
     int64_t fetchTimestamp(size_t size,
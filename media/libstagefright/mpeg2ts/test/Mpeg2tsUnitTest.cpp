@@ -22,6 +22,9 @@
 #include <stdint.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <datasource/FileSource.h>
 #include <media/stagefright/MediaDefs.h>
 #include <media/stagefright/MetaDataBase.h>
@@ -216,6 +219,27 @@ TEST_P(Mpeg2tsUnitTest, MediaInfoTest) {
     }
 }
 
+TEST_P(Mpeg2tsUnitTest, BatchFeedTest) {
+    // Feed up to 4 MiB of the stream in one call, behind bytes that are not a
+    // TS packet, and check that the parser resynchronizes and finds the sources.
+    constexpr size_t kNumJunkBytes = 5;
+    size_t numPackets = std::min<uint64_t>(mTotalPackets, (4 << 20) / kTSPacketSize);
+    std::vector<uint8_t> data(kNumJunkBytes + numPackets * kTSPacketSize, 0xff);
+    ssize_t numBytesRead =
+            mSource->readAt(0, data.data() + kNumJunkBytes, numPackets * kTSPacketSize);
+    ASSERT_EQ(numBytesRead, (ssize_t)(numPackets * kTSPacketSize)) << "Failed to read stream";
+
+    size_t consumed = 0;
+    status_t err = mParser->feedTSPackets(data.data(), data.size(), &consumed);
+    ASSERT_EQ(err, (status_t)OK) << "Unable to feed TS packets!";
+    ASSERT_EQ(consumed, data.size()) << "Not all TS packets were consumed";
+
+    ASSERT_EQ(mParser->hasSource(ATSParser::VIDEO), bool(mMediaType & kVideoPresent))
+            << "No Video packets found!";
+    ASSERT_EQ(mParser->hasSource(ATSParser::AUDIO), bool(mMediaType & kAudioPresent))
+            << "No Audio packets found!";
+}
+
 INSTANTIATE_TEST_SUITE_P(
         infoTest, Mpeg2tsUnitTest,
         ::testing::Values(make_tuple("crowd_1920x1080_25fps_6700kbps_h264.ts", 0x01, 1),
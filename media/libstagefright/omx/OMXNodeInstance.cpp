@@ -186,6 +186,14 @@ struct BufferMeta {
         return mPortIndex;
     }
 
+    void setBufferID(IOMX::buffer_id buffer) {
+        mBufferID.store(buffer, std::memory_order_release);
+    }
+
+    IOMX::buffer_id getBufferID() {
+        return mBufferID.load(std::memory_order_acquire);
+    }
+
     ~BufferMeta() {
         delete[] mBackup;
     }
@@ -199,6 +207,7 @@ private:
     bool mCopyToOmx;
     OMX_U32 mPortIndex;
     OMX_U8 *mBackup;
+    std::atomic<IOMX::buffer_id> mBufferID{0};
 
     BufferMeta(const BufferMeta &);
     BufferMeta &operator=(const BufferMeta &);
@@ -434,7 +443,7 @@ OMXNodeInstance::OMXNodeInstance(
       mSailed(false),
       mQueriedProhibitedExtensions(false),
       mQuirks(0),
-      mBufferIDCount(0),
+      mNumBufferIDSlots(0),
       mRestorePtsFailed(false),
       mMaxTimestampGapUs(0LL),
       mPrevOriginalTimeUs(-1LL),
@@ -448,6 +457,9 @@ OMXNodeInstance::OMXNodeInstance(
     mNumPortBuffers[1] = 0;
     mDebugLevelBumpPendingBuffers[0] = 0;
     mDebugLevelBumpPendingBuffers[1] = 0;
+    for (std::atomic<BufferIDSlot *> &chunk : mBufferIDSlotChunks) {
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
     mMetadataType[0] = kMetadataBufferTypeInvalid;
     mMetadataType[1] = kMetadataBufferTypeInvalid;
     mPortMode[0] = IOMX::kPortModePresetByteBuffer;
@@ -468,6 +480,9 @@ OMXNodeInstance::OMXNodeInstance(
 OMXNodeInstance::~OMXNodeInstance() {
     free(mName);
     CHECK(mHandle == NULL);
+    for (std::atomic<BufferIDSlot *> &chunk : mBufferIDSlotChunks) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
 }
 
 void OMXNodeInstance::setHandle(OMX_HANDLETYPE handle) {
@@ -2566,20 +2581,39 @@ void OMXNodeInstance::freeActiveBuffers() {
     }
 }
 
+OMXNodeInstance::BufferIDSlot *OMXNodeInstance::getBufferIDSlot(IOMX::buffer_id buffer) {
+    uint32_t index = buffer & (kMaxBufferIDSlots - 1);
+    BufferIDSlot *chunk =
+        mBufferIDSlotChunks[index / kBufferIDSlotsPerChunk].load(std::memory_order_acquire);
+    return chunk == nullptr ? nullptr : &chunk[index % kBufferIDSlotsPerChunk];
+}
+
 IOMX::buffer_id OMXNodeInstance::makeBufferID(OMX_BUFFERHEADERTYPE *bufferHeader) {
     if (bufferHeader == NULL) {
         return 0;
     }
     Mutex::Autolock autoLock(mBufferIDLock);
-    IOMX::buffer_id buffer;
-    do { // handle the very unlikely case of ID overflow
-        if (++mBufferIDCount == 0) {
-            ++mBufferIDCount;
+    uint32_t index;
+    if (!mFreeBufferIDSlots.isEmpty()) {
+        index = mFreeBufferIDSlots.top();
+        mFreeBufferIDSlots.pop();
+    } else {
+        CHECK_LT(mNumBufferIDSlots, (uint32_t)kMaxBufferIDSlots);
+        index = mNumBufferIDSlots++;
+        if (index % kBufferIDSlotsPerChunk == 0) {
+            mBufferIDSlotChunks[index / kBufferIDSlotsPerChunk].store(
+                    new BufferIDSlot[kBufferIDSlotsPerChunk], std::memory_order_release);
         }
-        buffer = (IOMX::buffer_id)mBufferIDCount;
-    } while (mBufferIDToBufferHeader.indexOfKey(buffer) >= 0);
-    mBufferIDToBufferHeader.add(buffer, bufferHeader);
-    mBufferHeaderToBufferID.add(bufferHeader, buffer);
+    }
+    BufferIDSlot *slot = getBufferIDSlot(index);
+    // the generation is never 0, so neither is the buffer id
+    if (++slot->mGeneration >= (1u << (32 - kBufferIDSlotBits))) {
+        slot->mGeneration = 1;
+    }
+    IOMX::buffer_id buffer = (slot->mGeneration << kBufferIDSlotBits) | index;
+    static_cast<BufferMeta *>(bufferHeader->pAppPrivate)->setBufferID(buffer);
+    slot->mHeader.store(bufferHeader, std::memory_order_relaxed);
+    slot->mID.store(buffer, std::memory_order_release);
     return buffer;
 }
 
@@ -2588,13 +2622,19 @@ OMX_BUFFERHEADERTYPE *OMXNodeInstance::findBufferHeader(
     if (buffer == 0) {
         return NULL;
     }
-    Mutex::Autolock autoLock(mBufferIDLock);
-    ssize_t index = mBufferIDToBufferHeader.indexOfKey(buffer);
-    if (index < 0) {
+    BufferIDSlot *slot = getBufferIDSlot(buffer);
+    OMX_BUFFERHEADERTYPE *header = NULL;
+    if (slot != nullptr && slot->mID.load(std::memory_order_acquire) == buffer) {
+        header = slot->mHeader.load(std::memory_order_acquire);
+        // make sure the slot was not reused while reading the header
+        if (slot->mID.load(std::memory_order_acquire) != buffer) {
+            header = NULL;
+        }
+    }
+    if (header == NULL) {
         CLOGW("findBufferHeader: buffer %u not found", buffer);
         return NULL;
     }
-    OMX_BUFFERHEADERTYPE *header = mBufferIDToBufferHeader.valueAt(index);
     BufferMeta *buffer_meta =
         static_cast<BufferMeta *>(header->pAppPrivate);
     if (buffer_meta->getPortIndex() != portIndex) {
@@ -2609,13 +2649,19 @@ IOMX::buffer_id OMXNodeInstance::findBufferID(OMX_BUFFERHEADERTYPE *bufferHeader
     if (bufferHeader == NULL) {
         return 0;
     }
-    Mutex::Autolock autoLock(mBufferIDLock);
-    ssize_t index = mBufferHeaderToBufferID.indexOfKey(bufferHeader);
-    if (index < 0) {
+    IOMX::buffer_id buffer = 0;
+    BufferMeta *buffer_meta = static_cast<BufferMeta *>(bufferHeader->pAppPrivate);
+    if (buffer_meta != NULL) {
+        buffer = buffer_meta->getBufferID();
+    }
+    BufferIDSlot *slot = buffer == 0 ? nullptr : getBufferIDSlot(buffer);
+    if (slot == nullptr
+            || slot->mHeader.load(std::memory_order_acquire) != bufferHeader
+            || slot->mID.load(std::memory_order_acquire) != buffer) {
         CLOGW("findBufferID: bufferHeader %p not found", bufferHeader);
         return 0;
     }
-    return mBufferHeaderToBufferID.valueAt(index);
+    return buffer;
 }
 
 void OMXNodeInstance::invalidateBufferID(IOMX::buffer_id buffer) {
@@ -2623,13 +2669,14 @@ void OMXNodeInstance::invalidateBufferID(IOMX::buffer_id buffer) {
         return;
     }
     Mutex::Autolock autoLock(mBufferIDLock);
-    ssize_t index = mBufferIDToBufferHeader.indexOfKey(buffer);
-    if (index < 0) {
+    BufferIDSlot *slot = getBufferIDSlot(buffer);
+    if (slot == nullptr || slot->mID.load(std::memory_order_relaxed) != buffer) {
         CLOGW("invalidateBufferID: buffer %u not found", buffer);
         return;
     }
-    mBufferHeaderToBufferID.removeItem(mBufferIDToBufferHeader.valueAt(index));
-    mBufferIDToBufferHeader.removeItemsAt(index);
+    slot->mID.store(0, std::memory_order_release);
+    slot->mHeader.store(nullptr, std::memory_order_release);
+    mFreeBufferIDSlots.push(buffer & (kMaxBufferIDSlots - 1));
 }
 
 }  // namespace android
@@ -145,11 +145,28 @@ private:
         IOMX::buffer_id mID;
     };
     Vector<ActiveBuffer> mActiveBuffers;
+
     // for buffer ptr to buffer id translation
+    //
+    // A buffer id is a slot index in its low kBufferIDSlotBits bits and the generation of the
+    // slot in the remaining bits. Slots are allocated in chunks that are never freed before the
+    // node, and are only modified with mBufferIDLock held, so that the buffer and callback paths
+    // can look up buffers without taking the lock.
+    enum : uint32_t {
+        kBufferIDSlotBits = 14,
+        kBufferIDSlotsPerChunk = 64,
+        kMaxBufferIDSlots = 1u << kBufferIDSlotBits,
+        kMaxBufferIDSlotChunks = kMaxBufferIDSlots / kBufferIDSlotsPerChunk,
+    };
+    struct BufferIDSlot {
+        std::atomic<IOMX::buffer_id> mID{0};
+        std::atomic<OMX_BUFFERHEADERTYPE *> mHeader{nullptr};
+        uint32_t mGeneration = 0; // guarded by mBufferIDLock
+    };
     Mutex mBufferIDLock;
-    uint32_t mBufferIDCount;
-    KeyedVector<IOMX::buffer_id, OMX_BUFFERHEADERTYPE *> mBufferIDToBufferHeader;
-    KeyedVector<OMX_BUFFERHEADERTYPE *, IOMX::buffer_id> mBufferHeaderToBufferID;
+    std::atomic<BufferIDSlot *> mBufferIDSlotChunks[kMaxBufferIDSlotChunks];
+    uint32_t mNumBufferIDSlots;
+    Vector<uint32_t> mFreeBufferIDSlots;
 
     bool mLegacyAdaptiveExperiment;
     IOMX::PortMode mPortMode[2];
@@ -194,6 +211,7 @@ private:
     OMX_BUFFERHEADERTYPE *findBufferHeader(IOMX::buffer_id buffer, OMX_U32 portIndex);
     IOMX::buffer_id findBufferID(OMX_BUFFERHEADERTYPE *bufferHeader);
     void invalidateBufferID(IOMX::buffer_id buffer);
+    BufferIDSlot *getBufferIDSlot(IOMX::buffer_id buffer);
 
     bool isProhibitedIndex_l(OMX_INDEXTYPE index);
 
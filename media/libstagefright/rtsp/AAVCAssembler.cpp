@@ -339,7 +339,7 @@ bool AAVCAssembler::dropFramesUntilIframe(const sp<ABuffer> &buffer) {
     return false;
 }
 
-void AAVCAssembler::addSingleNALUnit(const sp<ABuffer> &buffer) {
+bool AAVCAssembler::addSingleNALUnit(const sp<ABuffer> &buffer) {
     ALOGV("addSingleNALUnit of size %zu", buffer->size());
 #if !LOG_NDEBUG
     hexdump(buffer->data(), buffer->size());
@@ -359,7 +359,7 @@ void AAVCAssembler::addSingleNALUnit(const sp<ABuffer> &buffer) {
             source->onIssueFIRByAssembler();
         }
         ALOGV("Dropping P-frame till I-frame provided. rtpTime %u", rtpTime);
-        return;
+        return false;
     }
 
     if (!mNALUnits.empty() && rtpTime != mAccessUnitRTPTime) {
@@ -368,6 +368,7 @@ void AAVCAssembler::addSingleNALUnit(const sp<ABuffer> &buffer) {
     mAccessUnitRTPTime = rtpTime;
 
     mNALUnits.push_back(buffer);
+    return true;
 }
 
 bool AAVCAssembler::addSingleTimeAggregationPacket(const sp<ABuffer> &buffer) {
@@ -513,37 +514,45 @@ ARTPAssembler::AssemblyStatus AAVCAssembler::addFragmentedNALUnit(
 
     // We found all the fragments that make up the complete NAL unit.
 
-    // Leave room for the header. So far totalSize did not include the
-    // header byte.
-    ++totalSize;
-
-    sp<ABuffer> unit = new ABuffer(totalSize);
-    CopyTimes(unit, *queue->begin());
-
-    unit->data()[0] = (nri << 5) | nalType;
-
-    size_t offset = 1;
+    // The fragments are handed to the access unit as slices of the received packets rather
+    // than copied into a new buffer, so their payload is copied only once, by
+    // submitAccessUnit(). The FU header of the first fragment is overwritten in place with
+    // the reconstructed NAL unit header.
+    List<sp<ABuffer> > fragments;
     int32_t cvo = -1;
     sp<ARTPSource> source = nullptr;
     List<sp<ABuffer> >::iterator it = queue->begin();
     for (size_t i = 0; i < totalCount; ++i) {
-        const sp<ABuffer> &buffer = *it;
+        sp<ABuffer> buffer = *it;
 
         ALOGV("piece #%zu/%zu", i + 1, totalCount);
 #if !LOG_NDEBUG
         hexdump(buffer->data(), buffer->size());
 #endif
 
-        memcpy(unit->data() + offset, buffer->data() + 2, buffer->size() - 2);
-
+        if (i == 0) {
+            uint8_t *data = buffer->data();
+            data[1] = (nri << 5) | nalType;
+            buffer->setRange(buffer->offset() + 1, buffer->size() - 1);
+        } else {
+            buffer->setRange(buffer->offset() + 2, buffer->size() - 2);
+            buffer->meta()->setInt32("fu-continuation", true);
+        }
         buffer->meta()->findObject("source", (sp<android::RefBase>*)&source);
         buffer->meta()->findInt32("cvo", &cvo);
-        offset += buffer->size() - 2;
+        fragments.push_back(buffer);
 
         it = queue->erase(it);
     }
 
-    unit->setRange(0, totalSize);
+    sp<ABuffer> unit = *fragments.begin();
+    if (nalType == 0x7 && fragments.size() > 1) {
+        // Parameter sets are parsed by the assembler and have to be contiguous.
+        unit = MakeCompoundFromPackets(fragments);
+        CHECK_EQ(unit->size(), totalSize + 1);
+        fragments.clear();
+        fragments.push_back(unit);
+    }
 
     if (cvo >= 0) {
         unit->meta()->setInt32("cvo", cvo);
@@ -555,7 +564,11 @@ ARTPAssembler::AssemblyStatus AAVCAssembler::addFragmentedNALUnit(
         unit->meta()->setObject("source", source);
     }
 
-    addSingleNALUnit(unit);
+    if (addSingleNALUnit(unit)) {
+        for (it = ++fragments.begin(); it != fragments.end(); ++it) {
+            mNALUnits.push_back(*it);
+        }
+    }
 
     ALOGV("successfully assembled a NAL unit from fragments.");
 
@@ -574,7 +587,9 @@ void AAVCAssembler::submitAccessUnit() {
     size_t totalSize = 0;
     for (List<sp<ABuffer> >::iterator it = mNALUnits.begin();
          it != mNALUnits.end(); ++it) {
-        totalSize += 4 + (*it)->size();
+        int32_t continuation = false;
+        (*it)->meta()->findInt32("fu-continuation", &continuation);
+        totalSize += (continuation ? 0 : 4) + (*it)->size();
     }
 
     sp<ABuffer> accessUnit = new ABuffer(totalSize);
@@ -582,10 +597,15 @@ void AAVCAssembler::submitAccessUnit() {
     int32_t cvo = -1;
     for (List<sp<ABuffer> >::iterator it = mNALUnits.begin();
          it != mNALUnits.end(); ++it) {
-        memcpy(accessUnit->data() + offset, "\x00\x00\x00\x01", 4);
-        offset += 4;
-
         sp<ABuffer> nal = *it;
+
+        // fragments of a NAL unit follow its first fragment without a start code
+        int32_t continuation = false;
+        if (!nal->meta()->findInt32("fu-continuation", &continuation) || !continuation) {
+            memcpy(accessUnit->data() + offset, "\x00\x00\x00\x01", 4);
+            offset += 4;
+        }
+
         memcpy(accessUnit->data() + offset, nal->data(), nal->size());
         offset += nal->size();
 
@@ -30,6 +30,7 @@
 #include <media/stagefright/MetaData.h>
 #include <utils/ByteOrder.h>
 
+#include <errno.h>
 #include <fcntl.h>
 #include <strings.h>
 
@@ -204,6 +205,8 @@ void ARTPWriter::initState() {
     mRTPTimeBase = 0;
     mNumRTPSent = 0;
     mNumRTPOctetsSent = 0;
+    mNumQueuedRTPPackets = 0;
+    mNumRTPBatchesSent = 0;
 
     mOpponentID = 0;
     mBitrate = 192000;
@@ -592,12 +595,14 @@ void ARTPWriter::onRead(const sp<AMessage> &msg) {
             SpsPpsParser(mediaBuf, &mSPSBuf, &mPPSBuf);
             if (mediaBuf->range_length() > 0) {
                 sendAVCData(mediaBuf);
+                flushRTPPackets();
             }
         } else if (mMode == H265) {
             StripStartcode(mediaBuf);
             VpsSpsPpsParser(mediaBuf, &mVPSBuf, &mSPSBuf, &mPPSBuf);
             if (mediaBuf->range_length() > 0) {
                 sendHEVCData(mediaBuf);
+                flushRTPPackets();
             }
         } else if (mMode == H263) {
             sendH263Data(mediaBuf);
@@ -625,23 +630,25 @@ void ARTPWriter::onSendSR(const sp<AMessage> &msg) {
     msg->post(3000000);
 }
 
-void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
-    int sizeSockSt;
-    struct sockaddr *remAddr;
-
+struct sockaddr *ARTPWriter::getRemoteAddr(bool isRTCP, int *sizeSockSt) {
     if (mIsIPv6) {
-        sizeSockSt = sizeof(struct sockaddr_in6);
+        *sizeSockSt = sizeof(struct sockaddr_in6);
         if (isRTCP)
-            remAddr = (struct sockaddr *)&mRTCPAddr6;
+            return (struct sockaddr *)&mRTCPAddr6;
         else
-            remAddr = (struct sockaddr *)&mRTPAddr6;
+            return (struct sockaddr *)&mRTPAddr6;
     } else {
-        sizeSockSt = sizeof(struct sockaddr_in);
+        *sizeSockSt = sizeof(struct sockaddr_in);
         if (isRTCP)
-            remAddr = (struct sockaddr *)&mRTCPAddr;
+            return (struct sockaddr *)&mRTCPAddr;
         else
-            remAddr = (struct sockaddr *)&mRTPAddr;
+            return (struct sockaddr *)&mRTPAddr;
     }
+}
+
+void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
+    int sizeSockSt;
+    struct sockaddr *remAddr = getRemoteAddr(isRTCP, &sizeSockSt);
 
     // Unseal code if moderator is needed (prevent overflow of instant bandwidth)
     // Set limit bits per period through the moderator.
@@ -651,6 +658,10 @@ void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
     ssize_t n = sendto(isRTCP ? mRTCPSocket : mRTPSocket,
             buffer->data(), buffer->size(), 0, remAddr, sizeSockSt);
 
+    onPacketSent(buffer, isRTCP, n);
+}
+
+void ARTPWriter::onPacketSent(const sp<ABuffer> &buffer, bool isRTCP, ssize_t n) {
     if (n != (ssize_t)buffer->size()) {
         ALOGW("packets can not be sent. ret=%d, buf=%d", (int)n, (int)buffer->size());
     } else {
@@ -671,6 +682,72 @@ void ARTPWriter::send(const sp<ABuffer> &buffer, bool isRTCP) {
 #endif
 }
 
+sp<ABuffer> ARTPWriter::getRTPPacketBuffer() {
+    if (mNumQueuedRTPPackets == kMaxRTPBatchSize) {
+        flushRTPPackets();
+    }
+
+    sp<ABuffer> &buffer = mRTPPacketPool[mNumQueuedRTPPackets];
+    if (buffer == NULL) {
+        buffer = new ABuffer(kMaxPacketSize);
+    }
+    buffer->setRange(0, buffer->capacity());
+    return buffer;
+}
+
+// Queues the buffer last returned by getRTPPacketBuffer().
+void ARTPWriter::queueRTPPacket() {
+    CHECK_LT(mNumQueuedRTPPackets, (size_t)kMaxRTPBatchSize);
+    ++mNumQueuedRTPPackets;
+}
+
+void ARTPWriter::flushRTPPackets() {
+    if (mNumQueuedRTPPackets == 0) {
+        return;
+    }
+
+    int sizeSockSt;
+    struct sockaddr *remAddr = getRemoteAddr(false /* isRTCP */, &sizeSockSt);
+
+    for (size_t i = 0; i < mNumQueuedRTPPackets; ++i) {
+        mRTPIovs[i].iov_base = mRTPPacketPool[i]->data();
+        mRTPIovs[i].iov_len = mRTPPacketPool[i]->size();
+
+        struct msghdr &hdr = mRTPMsgs[i].msg_hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_name = remAddr;
+        hdr.msg_namelen = sizeSockSt;
+        hdr.msg_iov = &mRTPIovs[i];
+        hdr.msg_iovlen = 1;
+        mRTPMsgs[i].msg_len = 0;
+    }
+
+    // Bursts are bounded by kMaxRTPBatchSize. The moderator from send() can be unsealed here too.
+    // ModerateInstantTraffic(10, 6 * 1024);
+
+    size_t sent = 0;
+    while (sent < mNumQueuedRTPPackets) {
+        int n = sendmmsg(mRTPSocket, &mRTPMsgs[sent], mNumQueuedRTPPackets - sent, 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            ALOGW("packets can not be sent. ret=%d, errno=%d, dropped=%zu",
+                    n, errno, mNumQueuedRTPPackets - sent);
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            onPacketSent(mRTPPacketPool[sent + i], false /* isRTCP */,
+                    mRTPMsgs[sent + i].msg_len);
+        }
+        sent += n;
+        ++mNumRTPBatchesSent;
+    }
+
+    ALOGV("sent %zu RTP packets, %u batches in total", sent, mNumRTPBatchesSent);
+    mNumQueuedRTPPackets = 0;
+}
+
 void ARTPWriter::addSR(const sp<ABuffer> &buffer) {
     uint8_t *data = buffer->data() + buffer->size();
 
@@ -1046,7 +1123,7 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
         isNonVCL = 1;
     }
 
-    sp<ABuffer> buffer = new ABuffer(kMaxPacketSize);
+    sp<ABuffer> buffer = getRTPPacketBuffer();
     if (mediaBuf->range_length() + TCPIP_HEADER_SIZE + RTP_HEADER_SIZE + RTP_HEADER_EXT_SIZE
             + RTP_PAYLOAD_ROOM_SIZE <= buffer->capacity()) {
         // The data fits into a single packet
@@ -1111,7 +1188,7 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
 
         buffer->setRange(0, mediaBuf->range_length() + (12 + rtpExtIndex));
 
-        send(buffer, false /* isRTCP */);
+        queueRTPPacket();
 
         ++mSeqNo;
         ++mNumRTPSent;
@@ -1125,6 +1202,7 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
 
         bool firstPacket = true;
         while (offset < mediaBuf->range_length()) {
+            buffer = getRTPPacketBuffer();
             size_t size = mediaBuf->range_length() - offset;
             bool lastPacket = true;
             if (size + TCPIP_HEADER_SIZE + RTP_HEADER_SIZE + RTP_HEADER_EXT_SIZE +
@@ -1198,7 +1276,7 @@ void ARTPWriter::sendHEVCData(MediaBufferBase *mediaBuf) {
 
             buffer->setRange(0, 15 + rtpExtIndex + size);
 
-            send(buffer, false /* isRTCP */);
+            queueRTPPacket();
 
             ++mSeqNo;
             ++mNumRTPSent;
@@ -1233,7 +1311,7 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
     }
 
     mTrafficRec->updateClock(ALooper::GetNowUs() / 1000);
-    sp<ABuffer> buffer = new ABuffer(kMaxPacketSize);
+    sp<ABuffer> buffer = getRTPPacketBuffer();
     if (mediaBuf->range_length() + TCPIP_HEADER_SIZE + RTP_HEADER_SIZE + RTP_HEADER_EXT_SIZE
             + RTP_PAYLOAD_ROOM_SIZE <= buffer->capacity()) {
         // The data fits into a single packet
@@ -1298,7 +1376,7 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
 
         buffer->setRange(0, mediaBuf->range_length() + (12 + rtpExtIndex));
 
-        send(buffer, false /* isRTCP */);
+        queueRTPPacket();
 
         ++mSeqNo;
         ++mNumRTPSent;
@@ -1312,6 +1390,7 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
 
         bool firstPacket = true;
         while (offset < mediaBuf->range_length()) {
+            buffer = getRTPPacketBuffer();
             size_t size = mediaBuf->range_length() - offset;
             bool lastPacket = true;
             if (size + TCPIP_HEADER_SIZE + RTP_HEADER_SIZE + RTP_HEADER_EXT_SIZE +
@@ -1382,7 +1461,7 @@ void ARTPWriter::sendAVCData(MediaBufferBase *mediaBuf) {
 
             buffer->setRange(0, 14 + rtpExtIndex + size);
 
-            send(buffer, false /* isRTCP */);
+            queueRTPPacket();
 
             ++mSeqNo;
             ++mNumRTPSent;
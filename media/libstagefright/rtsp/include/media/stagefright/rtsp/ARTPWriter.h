@@ -74,6 +74,11 @@ private:
         kFlagEOS      = 2,
     };
 
+    enum {
+        // Maximum number of RTP packets sent with a single sendmmsg() call.
+        kMaxRTPBatchSize = 64,
+    };
+
     Mutex mLock;
     Condition mCondition;
     uint32_t mFlags;
@@ -122,6 +127,14 @@ private:
     typedef uint64_t Bytes;
     sp<TrafficRecorder<uint32_t /* Time */, Bytes> > mTrafficRec;
 
+    // RTP packets of the current access unit, queued by queueRTPPacket() and sent together by
+    // flushRTPPackets(). The packet buffers are allocated once and reused for every batch.
+    sp<ABuffer> mRTPPacketPool[kMaxRTPBatchSize];
+    struct mmsghdr mRTPMsgs[kMaxRTPBatchSize];
+    struct iovec mRTPIovs[kMaxRTPBatchSize];
+    size_t mNumQueuedRTPPackets;
+    uint32_t mNumRTPBatchesSent;
+
     int32_t mNumSRsSent;
     int32_t mRTPCVOExtMap;
     int32_t mRTPCVODegrees;
@@ -158,6 +171,11 @@ private:
     void sendAMRData(MediaBufferBase *mediaBuf);
 
     void send(const sp<ABuffer> &buffer, bool isRTCP);
+    struct sockaddr *getRemoteAddr(bool isRTCP, int *sizeSockSt);
+    void onPacketSent(const sp<ABuffer> &buffer, bool isRTCP, ssize_t n);
+    sp<ABuffer> getRTPPacketBuffer();
+    void queueRTPPacket();
+    void flushRTPPackets();
     void makeSocketPairAndBind(String8& localIp, int localPort, String8& remoteIp, int remotePort);
 
     void ModerateInstantTraffic(uint32_t samplePeriod, uint32_t limitBytes);
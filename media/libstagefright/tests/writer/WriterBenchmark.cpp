@@ -0,0 +1,362 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "WriterBenchmark"
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/mediarecorder.h>
+#include <media/stagefright/AACWriter.h>
+#include <media/stagefright/AMRWriter.h>
+#include <media/stagefright/MPEG2TSWriter.h>
+#include <media/stagefright/MPEG4Writer.h>
+#include <media/stagefright/MediaAdapter.h>
+#include <media/stagefright/MediaDefs.h>
+#include <media/stagefright/MetaData.h>
+#include <media/stagefright/OggWriter.h>
+#include <media/stagefright/Utils.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <utils/Log.h>
+#include <webm/WebmWriter.h>
+
+using namespace android;
+
+/*
+$ adb shell /data/benchmarktest/writerBenchmark/writerBenchmark
+
+BM_Writer/<writer>/<number of tracks>/<bitrate kbps per track>
+    <writer> is the index in kWriters. The track count is limited to what the
+    writer supports.
+BM_MPEG4WriterHandoff/<number of tracks>/<real time recording>/<interleave duration us>
+    Stresses the chunk handoff between the track threads and the writer thread.
+
+Each track is a stream of synthetic frames fed from its own thread through a
+MediaAdapter, the way the writer fuzzers feed their input. Besides the wall time
+every benchmark reports the CPU time and the read and write system calls of the
+process per iteration, and its peak resident set size. The recording write path
+with real clips is covered by the muxer benchmark in media/tests/benchmark.
+*/
+
+static constexpr int64_t kStreamDurationUs = 60 * 1000000LL;
+
+// AAC LC, 48 kHz, stereo.
+static constexpr uint8_t kAacCsd[] = {0x11, 0x90};
+// OpusHead for 2 channels at 48 kHz with a pre-skip of 312 samples.
+static constexpr uint8_t kOpusHead[] = {'O', 'p', 'u', 's', 'H', 'e', 'a', 'd', 1, 2, 0x38, 0x01,
+                                        0x80, 0xbb, 0x00, 0x00, 0x00, 0x00, 0x00};
+static constexpr int64_t kOpusCodecDelayNs = 6500000;
+static constexpr int64_t kOpusSeekPreRollNs = 80000000;
+
+struct StreamConfig {
+    const char *mime;
+    int64_t frameDurationUs;
+    int32_t syncInterval;  // Frames between sync frames, 1 for audio.
+    size_t fixedFrameSize;  // Size of every frame if the codec has a fixed bitrate.
+};
+
+static const StreamConfig kAacStream = {MEDIA_MIMETYPE_AUDIO_AAC, 21333, 1, 0};
+static const StreamConfig kAmrStream = {MEDIA_MIMETYPE_AUDIO_AMR_NB, 20000, 1, 32};
+static const StreamConfig kOpusStream = {MEDIA_MIMETYPE_AUDIO_OPUS, 20000, 1, 0};
+static const StreamConfig kH263Stream = {MEDIA_MIMETYPE_VIDEO_H263, 33333, 30, 0};
+static const StreamConfig kVp8Stream = {MEDIA_MIMETYPE_VIDEO_VP8, 33333, 30, 0};
+
+struct WriterConfig {
+    const char *name;
+    output_format format;
+    int32_t maxTracks;
+    // The first track uses the first stream, all others the second one.
+    const StreamConfig *firstStream;
+    const StreamConfig *otherStream;
+};
+
+static const WriterConfig kWriters[] = {
+    {"MPEG4", output_format::OUTPUT_FORMAT_MPEG_4, 8, &kH263Stream, &kAacStream},
+    {"WEBM", output_format::OUTPUT_FORMAT_WEBM, 2, &kVp8Stream, &kOpusStream},
+    {"MPEG2TS", output_format::OUTPUT_FORMAT_MPEG2TS, 8, &kAacStream, &kAacStream},
+    {"OGG", output_format::OUTPUT_FORMAT_OGG, 1, &kOpusStream, &kOpusStream},
+    {"AAC_ADTS", output_format::OUTPUT_FORMAT_AAC_ADTS, 1, &kAacStream, &kAacStream},
+    {"AMR_NB", output_format::OUTPUT_FORMAT_AMR_NB, 1, &kAmrStream, &kAmrStream},
+};
+
+static sp<MediaWriter> createWriter(output_format format, int fd) {
+    switch (format) {
+        case output_format::OUTPUT_FORMAT_MPEG_4:
+            return new MPEG4Writer(fd);
+        case output_format::OUTPUT_FORMAT_WEBM:
+            return new WebmWriter(fd);
+        case output_format::OUTPUT_FORMAT_MPEG2TS:
+            return new MPEG2TSWriter(fd);
+        case output_format::OUTPUT_FORMAT_OGG:
+            return new OggWriter(fd);
+        case output_format::OUTPUT_FORMAT_AAC_ADTS:
+            return new AACWriter(fd);
+        case output_format::OUTPUT_FORMAT_AMR_NB:
+            return new AMRWriter(fd);
+        default:
+            return nullptr;
+    }
+}
+
+static sp<MediaAdapter> createTrack(const StreamConfig& stream) {
+    sp<AMessage> format = new AMessage;
+    format->setString("mime", stream.mime);
+    if (!strncmp(stream.mime, "video/", 6)) {
+        format->setInt32("width", 1280);
+        format->setInt32("height", 720);
+    } else if (!strcmp(stream.mime, MEDIA_MIMETYPE_AUDIO_AMR_NB)) {
+        format->setInt32("channel-count", 1);
+        format->setInt32("sample-rate", 8000);
+    } else {
+        format->setInt32("channel-count", 2);
+        format->setInt32("sample-rate", 48000);
+    }
+    if (!strcmp(stream.mime, MEDIA_MIMETYPE_AUDIO_AAC)) {
+        format->setBuffer("csd-0", ABuffer::CreateAsCopy(kAacCsd, sizeof(kAacCsd)));
+    } else if (!strcmp(stream.mime, MEDIA_MIMETYPE_AUDIO_OPUS)) {
+        format->setBuffer("csd-0", ABuffer::CreateAsCopy(kOpusHead, sizeof(kOpusHead)));
+        format->setBuffer("csd-1",
+                ABuffer::CreateAsCopy(&kOpusCodecDelayNs, sizeof(kOpusCodecDelayNs)));
+        format->setBuffer("csd-2",
+                ABuffer::CreateAsCopy(&kOpusSeekPreRollNs, sizeof(kOpusSeekPreRollNs)));
+    }
+    sp<MetaData> trackMeta = new MetaData;
+    convertMessageToMetaData(format, trackMeta);
+    return new MediaAdapter(trackMeta);
+}
+
+static void sendFrames(const sp<MediaAdapter>& track, const StreamConfig& stream,
+                       int32_t numFrames, const std::vector<uint8_t>& frame) {
+    for (int32_t i = 0; i < numFrames; ++i) {
+        MediaBuffer *mediaBuffer = new MediaBuffer((void *)frame.data(), frame.size());
+
+        // Released in MediaAdapter::signalBufferReturned().
+        mediaBuffer->add_ref();
+        MetaDataBase &sampleMetaData = mediaBuffer->meta_data();
+        sampleMetaData.setInt64(kKeyTime, i * stream.frameDurationUs);
+        sampleMetaData.setInt64(kKeyDecodingTime, i * stream.frameDurationUs);
+        if (i % stream.syncInterval == 0) {
+            sampleMetaData.setInt32(kKeyIsSyncFrame, true);
+        }
+
+        // This pushBuffer will wait until the mediaBuffer is consumed.
+        track->pushBuffer(mediaBuffer);
+    }
+    track->stop();
+}
+
+// The resource usage of the process that the benchmarks report.
+struct ResourceUsage {
+    int64_t cpuTimeUs = 0;
+    int64_t readSyscalls = 0;
+    int64_t writeSyscalls = 0;
+    int64_t maxRssKb = 0;
+
+    static ResourceUsage get() {
+        ResourceUsage usage;
+        struct rusage ru;
+        if (getrusage(RUSAGE_SELF, &ru) == 0) {
+            usage.cpuTimeUs = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000LL
+                    + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+            usage.maxRssKb = ru.ru_maxrss;
+        }
+        std::ifstream io("/proc/self/io");
+        std::string key;
+        int64_t value;
+        while (io >> key >> value) {
+            if (key == "syscr:") {
+                usage.readSyscalls = value;
+            } else if (key == "syscw:") {
+                usage.writeSyscalls = value;
+            }
+        }
+        return usage;
+    }
+};
+
+static void setResourceCounters(benchmark::State& state, const ResourceUsage& start) {
+    const ResourceUsage end = ResourceUsage::get();
+    using benchmark::Counter;
+    state.counters["cpu_ms"] =
+            Counter((end.cpuTimeUs - start.cpuTimeUs) / 1000.0, Counter::kAvgIterations);
+    state.counters["read_syscalls"] =
+            Counter(end.readSyscalls - start.readSyscalls, Counter::kAvgIterations);
+    state.counters["write_syscalls"] =
+            Counter(end.writeSyscalls - start.writeSyscalls, Counter::kAvgIterations);
+    state.counters["max_rss_kb"] = end.maxRssKb;
+}
+
+// Write the streams with one feeding thread per track and return the total frame count,
+// or -1 on error.
+static int64_t writeStreams(benchmark::State& state, const sp<MediaWriter>& writer,
+                            MetaData *fileMeta, const std::vector<const StreamConfig *>& streams,
+                            const std::vector<std::vector<uint8_t>>& frames) {
+    std::vector<sp<MediaAdapter>> tracks;
+    for (const StreamConfig *stream : streams) {
+        tracks.push_back(createTrack(*stream));
+        if (writer->addSource(tracks.back()) != OK) {
+            state.SkipWithError("addSource failed");
+            return -1;
+        }
+    }
+    if (writer->start(fileMeta) != OK) {
+        state.SkipWithError("start failed");
+        return -1;
+    }
+
+    int64_t numFrames = 0;
+    std::vector<std::thread> senders;
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        const int32_t trackFrames = kStreamDurationUs / streams[i]->frameDurationUs;
+        senders.emplace_back(sendFrames, tracks[i], std::cref(*streams[i]), trackFrames,
+                             std::cref(frames[i]));
+        numFrames += trackFrames;
+    }
+    for (std::thread& sender : senders) {
+        sender.join();
+    }
+    writer->stop();
+    return numFrames;
+}
+
+static void BM_Writer(benchmark::State& state) {
+    const WriterConfig& config = kWriters[state.range(0)];
+    const int32_t numTracks = std::min((int32_t)state.range(1), config.maxTracks);
+    const int64_t bitrateKbps = state.range(2);
+
+    std::vector<const StreamConfig *> streams;
+    std::vector<std::vector<uint8_t>> frames;
+    for (int32_t i = 0; i < numTracks; ++i) {
+        const StreamConfig *stream = (i == 0) ? config.firstStream : config.otherStream;
+        size_t frameSize = stream->fixedFrameSize;
+        if (frameSize == 0) {
+            frameSize = std::max((int64_t)1,
+                                 bitrateKbps * 1000 * stream->frameDurationUs / 8000000);
+        }
+        std::vector<uint8_t> frame(frameSize, 0x5a);
+        if (stream == &kAmrStream) {
+            frame[0] = 0x3c;  // AMR-NB 12.2 kbps frame header
+        }
+        streams.push_back(stream);
+        frames.push_back(std::move(frame));
+    }
+
+    int64_t numFrames = 0;
+    int64_t numBytes = 0;
+    const ResourceUsage start = ResourceUsage::get();
+    for (auto _ : state) {
+        int fd = memfd_create("writerBenchmark", MFD_ALLOW_SEALING);
+        if (fd < 0) {
+            state.SkipWithError("memfd_create failed");
+            return;
+        }
+        sp<MediaWriter> writer = createWriter(config.format, fd);
+        sp<MetaData> fileMeta = new MetaData;
+        fileMeta->setInt32(kKeyFileType, config.format);
+        fileMeta->setInt32(kKeyRealTimeRecording, true);
+        int64_t frameCount = writeStreams(state, writer, fileMeta.get(), streams, frames);
+
+        state.PauseTiming();
+        numBytes += lseek(fd, 0, SEEK_END);
+        writer.clear();
+        close(fd);
+        state.ResumeTiming();
+        if (frameCount < 0) {
+            return;
+        }
+        numFrames += frameCount;
+    }
+
+    setResourceCounters(state, start);
+    state.SetItemsProcessed(numFrames);
+    state.SetBytesProcessed(numBytes);
+    state.SetLabel(config.name);
+}
+
+static void BM_MPEG4WriterHandoff(benchmark::State& state) {
+    const int32_t numTracks = state.range(0);
+    const bool isRealTimeRecording = state.range(1);
+    const uint32_t interleaveDurationUs = state.range(2);
+    const std::vector<const StreamConfig *> streams(numTracks, &kAacStream);
+    const std::vector<std::vector<uint8_t>> frames(numTracks, std::vector<uint8_t>(400, 0x5a));
+
+    int64_t numFrames = 0;
+    const ResourceUsage start = ResourceUsage::get();
+    for (auto _ : state) {
+        int fd = memfd_create("writerBenchmark", MFD_ALLOW_SEALING);
+        if (fd < 0) {
+            state.SkipWithError("memfd_create failed");
+            return;
+        }
+        sp<MPEG4Writer> writer = new MPEG4Writer(fd);
+        writer->setInterleaveDuration(interleaveDurationUs);
+        sp<MetaData> fileMeta = new MetaData;
+        fileMeta->setInt32(kKeyFileType, output_format::OUTPUT_FORMAT_MPEG_4);
+        fileMeta->setInt32(kKeyRealTimeRecording, isRealTimeRecording);
+        int64_t frameCount = writeStreams(state, writer, fileMeta.get(), streams, frames);
+
+        state.PauseTiming();
+        writer.clear();
+        close(fd);
+        state.ResumeTiming();
+        if (frameCount < 0) {
+            return;
+        }
+        numFrames += frameCount;
+    }
+
+    setResourceCounters(state, start);
+    state.SetItemsProcessed(numFrames);
+}
+
+static void WriterArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t writer = 0; writer < (int64_t)std::size(kWriters); ++writer) {
+        for (int64_t numTracks : {1, 2, 4}) {
+            if (numTracks > 1 && numTracks > kWriters[writer].maxTracks) {
+                continue;
+            }
+            for (int64_t bitrateKbps : {64, 2000, 20000}) {
+                b->Args({writer, numTracks, bitrateKbps});
+            }
+        }
+    }
+}
+
+static void MPEG4WriterHandoffArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t numTracks : {1, 4, 8}) {
+        for (int64_t isRealTimeRecording : {0, 1}) {
+            // Per sample chunks stress the chunk handoff, 1 s chunks are the default.
+            for (int64_t interleaveDurationUs : {0, 1000000}) {
+                b->Args({numTracks, isRealTimeRecording, interleaveDurationUs});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_Writer)->Apply(WriterArgs)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MPEG4WriterHandoff)->Apply(MPEG4WriterHandoffArgs)->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
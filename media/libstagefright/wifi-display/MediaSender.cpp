@@ -35,6 +35,8 @@
 
 namespace android {
 
+static const size_t kNumAccessUnitsPerCPUTimeLog = 300;
+
 MediaSender::MediaSender(
         const sp<ANetworkSession> &netSession,
         const sp<AMessage> &notify)
@@ -44,6 +46,8 @@ MediaSender::MediaSender(
       mGeneration(0),
       mPrevTimeUs(-1ll),
       mInitDoneCount(0),
+      mPacketizeCPUTimeNs(0),
+      mNumPacketizedAccessUnits(0),
       mLogFile(NULL) {
     // mLogFile = fopen("/data/misc/log.ts", "wb");
 }
@@ -248,6 +252,8 @@ status_t MediaSender::queueAccessUnit(
             sp<ABuffer> accessUnit = *info->mAccessUnits.begin();
             info->mAccessUnits.erase(info->mAccessUnits.begin());
 
+            nsecs_t startCPUTimeNs = systemTime(SYSTEM_TIME_THREAD);
+
             sp<ABuffer> tsPackets;
             status_t err = packetizeAccessUnit(
                     minTrackIndex, accessUnit, &tsPackets);
@@ -270,6 +276,17 @@ status_t MediaSender::queueAccessUnit(
             if (err != OK) {
                 return err;
             }
+
+            mPacketizeCPUTimeNs +=
+                systemTime(SYSTEM_TIME_THREAD) - startCPUTimeNs;
+
+            if (++mNumPacketizedAccessUnits == kNumAccessUnitsPerCPUTimeLog) {
+                ALOGV("packetizing took %.2f us of CPU time per access unit",
+                      mPacketizeCPUTimeNs / (mNumPacketizedAccessUnits * 1E3));
+
+                mPacketizeCPUTimeNs = 0;
+                mNumPacketizedAccessUnits = 0;
+            }
         }
     }
 
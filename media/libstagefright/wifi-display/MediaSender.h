@@ -23,6 +23,7 @@
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/foundation/AHandler.h>
 #include <utils/Errors.h>
+#include <utils/Timers.h>
 #include <utils/Vector.h>
 
 namespace android {
@@ -110,6 +111,11 @@ private:
 
     size_t mInitDoneCount;
 
+    // Thread CPU time spent packetizing and sending transport stream
+    // access units, logged periodically.
+    nsecs_t mPacketizeCPUTimeNs;
+    size_t mNumPacketizedAccessUnits;
+
     FILE *mLogFile;
 
     void onSenderNotify(const sp<AMessage> &msg);
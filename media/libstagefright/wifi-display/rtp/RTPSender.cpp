@@ -252,6 +252,8 @@ status_t RTPSender::queueTSPackets(
     int64_t timeUs;
     CHECK(tsPackets->meta()->findInt64("timeUs", &timeUs));
 
+    List<sp<ABuffer> > udpPackets;
+
     size_t srcOffset = 0;
     while (srcOffset < tsPackets->size()) {
         sp<ABuffer> udpPacket =
@@ -290,20 +292,15 @@ status_t RTPSender::queueTSPackets(
         udpPacket->setRange(0, 12 + numTSPackets * 188);
 
         srcOffset += numTSPackets * 188;
-        bool isLastPacket = (srcOffset == tsPackets->size());
-
-        status_t err = sendRTPPacket(
-                udpPacket,
-                true /* storeInHistory */,
-                isLastPacket /* timeValid */,
-                timeUs);
 
-        if (err != OK) {
-            return err;
-        }
+        udpPackets.push_back(udpPacket);
     }
 
-    return OK;
+    return sendRTPPackets(
+            udpPackets,
+            true /* storeInHistory */,
+            true /* timeValid */,
+            timeUs);
 }
 
 status_t RTPSender::queueAVCBuffer(
@@ -459,29 +456,48 @@ status_t RTPSender::queueAVCBuffer(
 status_t RTPSender::sendRTPPacket(
         const sp<ABuffer> &buffer, bool storeInHistory,
         bool timeValid, int64_t timeUs) {
+    List<sp<ABuffer> > packets;
+    packets.push_back(buffer);
+
+    return sendRTPPackets(packets, storeInHistory, timeValid, timeUs);
+}
+
+status_t RTPSender::sendRTPPackets(
+        const List<sp<ABuffer> > &packets, bool storeInHistory,
+        bool timeValid, int64_t timeUs) {
     CHECK(mRTPConnected);
 
-    status_t err = mNetSession->sendRequest(
-            mRTPSessionID, buffer->data(), buffer->size(),
-            timeValid, timeUs);
+    if (packets.empty()) {
+        return OK;
+    }
+
+    // The network session queues UDP packets without copying them, packets
+    // stored in the history are never modified afterwards.
+    status_t err = mNetSession->sendDatagrams(
+            mRTPSessionID, packets, timeValid, timeUs);
 
     if (err != OK) {
         return err;
     }
 
     mLastNTPTime = GetNowNTP();
-    mLastRTPTime = U32_AT(buffer->data() + 4);
+    mLastRTPTime = U32_AT((*--packets.end())->data() + 4);
 
-    ++mNumRTPSent;
-    mNumRTPOctetsSent += buffer->size() - 12;
+    for (List<sp<ABuffer> >::const_iterator it = packets.begin();
+            it != packets.end(); ++it) {
+        const sp<ABuffer> &buffer = *it;
 
-    if (storeInHistory) {
-        if (mHistorySize == kMaxHistorySize) {
-            mHistory.erase(mHistory.begin());
-        } else {
-            ++mHistorySize;
+        ++mNumRTPSent;
+        mNumRTPOctetsSent += buffer->size() - 12;
+
+        if (storeInHistory) {
+            if (mHistorySize == kMaxHistorySize) {
+                mHistory.erase(mHistory.begin());
+            } else {
+                ++mHistorySize;
+            }
+            mHistory.push_back(buffer);
         }
-        mHistory.push_back(buffer);
     }
 
     return OK;
@@ -100,6 +100,12 @@ private:
             const sp<ABuffer> &packet, bool storeInHistory,
             bool timeValid = false, int64_t timeUs = -1ll);
 
+    // Sends all packets with a single request to the network session, the
+    // time, if valid, applies to the last packet.
+    status_t sendRTPPackets(
+            const List<sp<ABuffer> > &packets, bool storeInHistory,
+            bool timeValid = false, int64_t timeUs = -1ll);
+
     void onNetNotify(bool isRTP, const sp<AMessage> &msg);
 
     status_t onRTCPData(const sp<ABuffer> &data);
@@ -115,8 +115,8 @@ int MtpFfsCompatHandle::start(bool ptp) {
 
     for (unsigned i = 0; i < NUM_IO_BUFS; i++) {
         mIobuf[i].bufs.resize(MAX_FILE_CHUNK_SIZE);
-        posix_madvise(mIobuf[i].bufs.data(), MAX_FILE_CHUNK_SIZE,
-                POSIX_MADV_SEQUENTIAL | POSIX_MADV_WILLNEED);
+        posix_madvise(mIobuf[i].bufs.data(), MAX_FILE_CHUNK_SIZE, POSIX_MADV_SEQUENTIAL);
+        posix_madvise(mIobuf[i].bufs.data(), MAX_FILE_CHUNK_SIZE, POSIX_MADV_WILLNEED);
     }
 
     // Get device specific r/w size
@@ -176,7 +176,8 @@ int MtpFfsCompatHandle::receiveFile(mtp_file_range mfr, bool zero_packet) {
     bool read = false;
     bool write = false;
 
-    posix_fadvise(mfr.fd, 0, 0, POSIX_FADV_SEQUENTIAL | POSIX_FADV_NOREUSE);
+    posix_fadvise(mfr.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(mfr.fd, 0, 0, POSIX_FADV_NOREUSE);
 
     // Break down the file into pieces that fit in buffers
     while (file_length > 0 || write) {
@@ -258,7 +259,8 @@ int MtpFfsCompatHandle::sendFile(mtp_file_range mfr) {
     unsigned char *data = mIobuf[0].bufs.data();
     unsigned char *data2 = mIobuf[1].bufs.data();
 
-    posix_fadvise(mfr.fd, 0, 0, POSIX_FADV_SEQUENTIAL | POSIX_FADV_NOREUSE);
+    posix_fadvise(mfr.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(mfr.fd, 0, 0, POSIX_FADV_NOREUSE);
 
     struct aiocb aio;
     aio.aio_fildes = mfr.fd;
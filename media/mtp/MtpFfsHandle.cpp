@@ -113,14 +113,18 @@ bool MtpFfsHandle::openEndpoints(bool ptp) {
 }
 
 void MtpFfsHandle::advise(int fd) {
+    // The advice values are not flags, so each one needs its own call.
     for (unsigned i = 0; i < NUM_IO_BUFS; i++) {
-        if (posix_madvise(mIobuf[i].bufs.data(), MAX_FILE_CHUNK_SIZE,
-                POSIX_MADV_SEQUENTIAL | POSIX_MADV_WILLNEED) != 0)
-            PLOG(ERROR) << "Failed to madvise";
+        for (int advice : {POSIX_MADV_SEQUENTIAL, POSIX_MADV_WILLNEED}) {
+            if (posix_madvise(mIobuf[i].bufs.data(), MAX_FILE_CHUNK_SIZE, advice) != 0)
+                PLOG(ERROR) << "Failed to madvise";
+        }
+    }
+    // Sequential access doubles the kernel's readahead window for the file.
+    for (int advice : {POSIX_FADV_SEQUENTIAL, POSIX_FADV_NOREUSE}) {
+        if (posix_fadvise(fd, 0, 0, advice) != 0)
+            PLOG(ERROR) << "Failed to fadvise";
     }
-    if (posix_fadvise(fd, 0, 0,
-                POSIX_FADV_SEQUENTIAL | POSIX_FADV_NOREUSE | POSIX_FADV_WILLNEED) != 0)
-        PLOG(ERROR) << "Failed to fadvise";
 }
 
 bool MtpFfsHandle::writeDescriptors(bool ptp) {
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MtpObjectCache.h"
+#include "MtpObjectInfo.h"
+#include "mtp.h"
+
+namespace android {
+
+// Upper bounds on the cache size, so that a host walking a huge storage cannot grow it without
+// limit. The cache is simply emptied when a bound is reached.
+static const size_t kMaxCachedObjects = 256 * 1024;
+static const size_t kMaxCachedListHandles = 256 * 1024;
+
+MtpObjectCache::Object::Object(const MtpObjectInfo& info)
+    :   mStorageID(info.mStorageID),
+        mFormat(info.mFormat),
+        mParent(info.mParent),
+        mSize(info.mCompressedSize == 0xFFFFFFFF ? kUnknownSize : info.mCompressedSize),
+        mDateModified(info.mDateModified)
+{
+}
+
+MtpObjectCache::MtpObjectCache()
+    :   mGeneration(0),
+        mListHandleCount(0)
+{
+}
+
+MtpObjectCache::~MtpObjectCache() {
+}
+
+bool MtpObjectCache::isCachedProperty(MtpObjectProperty property) {
+    switch (property) {
+        case MTP_PROPERTY_STORAGE_ID:
+        case MTP_PROPERTY_OBJECT_FORMAT:
+        case MTP_PROPERTY_PARENT_OBJECT:
+        case MTP_PROPERTY_OBJECT_SIZE:
+        case MTP_PROPERTY_DATE_MODIFIED:
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint64_t MtpObjectCache::getGeneration() {
+    std::lock_guard<std::mutex> lg(mMutex);
+    return mGeneration;
+}
+
+bool MtpObjectCache::getObject(MtpObjectHandle handle, Object& outObject) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    auto iter = mObjects.find(handle);
+    if (iter == mObjects.end())
+        return false;
+    outObject = iter->second;
+    return true;
+}
+
+void MtpObjectCache::putObject(MtpObjectHandle handle, const Object& object,
+        uint64_t generation) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    if (generation != mGeneration)
+        return;
+    if (mObjects.size() >= kMaxCachedObjects)
+        mObjects.clear();
+    mObjects[handle] = object;
+}
+
+MtpObjectHandleList* MtpObjectCache::getObjectList(MtpStorageID storageID,
+        MtpObjectFormat format, MtpObjectHandle parent) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    auto iter = mLists.find(ListKey(storageID, format, parent));
+    if (iter == mLists.end())
+        return nullptr;
+    return new MtpObjectHandleList(iter->second);
+}
+
+void MtpObjectCache::putObjectList(MtpStorageID storageID, MtpObjectFormat format,
+        MtpObjectHandle parent, const MtpObjectHandleList& handles, uint64_t generation) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    if (generation != mGeneration)
+        return;
+    if (mListHandleCount + handles.size() > kMaxCachedListHandles) {
+        mLists.clear();
+        mListHandleCount = 0;
+        if (handles.size() > kMaxCachedListHandles)
+            return;
+    }
+
+    MtpObjectHandleList& list = mLists[ListKey(storageID, format, parent)];
+    mListHandleCount += handles.size() - list.size();
+    list = handles;
+}
+
+void MtpObjectCache::invalidateObject(MtpObjectHandle handle) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    mGeneration++;
+    mObjects.erase(handle);
+}
+
+void MtpObjectCache::invalidateObjectAndLists(MtpObjectHandle handle) {
+    std::lock_guard<std::mutex> lg(mMutex);
+    mGeneration++;
+    mObjects.erase(handle);
+    // any list may contain the object, either directly or through a wildcard query
+    mLists.clear();
+    mListHandleCount = 0;
+}
+
+void MtpObjectCache::clear() {
+    std::lock_guard<std::mutex> lg(mMutex);
+    mGeneration++;
+    mObjects.clear();
+    mLists.clear();
+    mListHandleCount = 0;
+}
+
+}  // namespace android
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MTP_OBJECT_CACHE_H
+#define _MTP_OBJECT_CACHE_H
+
+#include "MtpTypes.h"
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+
+namespace android {
+
+class MtpObjectInfo;
+
+// Caches object handle lists and the commonly queried properties of objects, so that hosts
+// enumerating large storages property by property do not cost a database round trip per query.
+// MtpServer invalidates the cache for every change it makes and for every change the database
+// reports through the object added, removed and info changed events.
+//
+// Every invalidation bumps a generation counter. Callers read the generation before querying the
+// database and pass it back when filling the cache, so a result that raced with an invalidation
+// is dropped instead of cached.
+class MtpObjectCache {
+public:
+    static constexpr uint64_t kUnknownSize = UINT64_MAX;
+
+    struct Object {
+        MtpStorageID        mStorageID;
+        MtpObjectFormat     mFormat;
+        MtpObjectHandle     mParent;
+        // kUnknownSize if the object is too large for the 32 bit ObjectInfo size
+        uint64_t            mSize;
+        time_t              mDateModified;
+
+                            Object() = default;
+        explicit            Object(const MtpObjectInfo& info);
+    };
+
+                        MtpObjectCache();
+    virtual             ~MtpObjectCache();
+
+    // returns true if the property can be served from a cached Object
+    static bool         isCachedProperty(MtpObjectProperty property);
+
+    uint64_t            getGeneration();
+
+    bool                getObject(MtpObjectHandle handle, Object& outObject);
+    void                putObject(MtpObjectHandle handle, const Object& object,
+                                    uint64_t generation);
+
+    // returns a new list the caller must delete, or nullptr if the query is not cached
+    MtpObjectHandleList* getObjectList(MtpStorageID storageID, MtpObjectFormat format,
+                                    MtpObjectHandle parent);
+    void                putObjectList(MtpStorageID storageID, MtpObjectFormat format,
+                                    MtpObjectHandle parent, const MtpObjectHandleList& handles,
+                                    uint64_t generation);
+
+    // for changes to a single object that do not move it
+    void                invalidateObject(MtpObjectHandle handle);
+    // for objects that were added, removed or moved
+    void                invalidateObjectAndLists(MtpObjectHandle handle);
+    void                clear();
+
+private:
+    typedef std::tuple<MtpStorageID, MtpObjectFormat, MtpObjectHandle> ListKey;
+
+    std::mutex          mMutex;
+    uint64_t            mGeneration;
+    std::unordered_map<MtpObjectHandle, Object> mObjects;
+    std::map<ListKey, MtpObjectHandleList> mLists;
+    size_t              mListHandleCount;
+};
+
+}; // namespace android
+
+#endif // _MTP_OBJECT_CACHE_H
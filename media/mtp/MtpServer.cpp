@@ -138,6 +138,7 @@ void MtpServer::addStorage(MtpStorage* storage) {
     std::lock_guard<std::mutex> lg(mMutex);
 
     mStorages.push_back(storage);
+    mObjectCache.clear();
     sendStoreAdded(storage->getStorageID());
 }
 
@@ -147,6 +148,7 @@ void MtpServer::removeStorage(MtpStorage* storage) {
     if (iter != mStorages.end()) {
         sendStoreRemoved(storage->getStorageID());
         mStorages.erase(iter);
+        mObjectCache.clear();
     }
 }
 
@@ -249,22 +251,26 @@ void MtpServer::run() {
         delete edit;
     }
     mObjectEditList.clear();
+    mObjectCache.clear();
 
     mHandle->close();
 }
 
 void MtpServer::sendObjectAdded(MtpObjectHandle handle) {
     ALOGV("sendObjectAdded %d\n", handle);
+    mObjectCache.invalidateObjectAndLists(handle);
     sendEvent(MTP_EVENT_OBJECT_ADDED, handle);
 }
 
 void MtpServer::sendObjectRemoved(MtpObjectHandle handle) {
     ALOGV("sendObjectRemoved %d\n", handle);
+    mObjectCache.invalidateObjectAndLists(handle);
     sendEvent(MTP_EVENT_OBJECT_REMOVED, handle);
 }
 
 void MtpServer::sendObjectInfoChanged(MtpObjectHandle handle) {
     ALOGV("sendObjectInfoChanged %d\n", handle);
+    mObjectCache.invalidateObject(handle);
     sendEvent(MTP_EVENT_OBJECT_INFO_CHANGED, handle);
 }
 
@@ -323,6 +329,76 @@ void MtpServer::removeEditObject(MtpObjectHandle handle) {
 
 void MtpServer::commitEdit(ObjectEdit* edit) {
     mDatabase->rescanFile((const char *)edit->mPath, edit->mHandle, edit->mFormat);
+    mObjectCache.invalidateObject(edit->mHandle);
+}
+
+bool MtpServer::getCachedObject(MtpObjectHandle handle, MtpObjectCache::Object& outObject) {
+    if (mObjectCache.getObject(handle, outObject))
+        return true;
+
+    uint64_t generation = mObjectCache.getGeneration();
+    MtpObjectInfo info(handle);
+    if (mDatabase->getObjectInfo(handle, info) != MTP_RESPONSE_OK)
+        return false;
+    outObject = MtpObjectCache::Object(info);
+    mObjectCache.putObject(handle, outObject, generation);
+    return true;
+}
+
+// Writes a single property of a single object from the object cache, either as a property value
+// or as a one element property list. Returns false without writing anything if the property
+// has to be read from the database instead.
+bool MtpServer::putCachedProperty(MtpObjectHandle handle, MtpObjectProperty property,
+        bool propList) {
+    if (!MtpObjectCache::isCachedProperty(property))
+        return false;
+    MtpObjectCache::Object object;
+    if (!getCachedObject(handle, object))
+        return false;
+
+    // if object is being edited the database size may be out of date
+    ObjectEdit* edit = getEditObject(handle);
+    if (edit)
+        object.mSize = edit->mSize;
+    if (property == MTP_PROPERTY_OBJECT_SIZE && object.mSize == MtpObjectCache::kUnknownSize)
+        return false;
+
+    if (propList) {
+        mData.putUInt32(1);
+        mData.putUInt32(handle);
+        mData.putUInt16(property);
+    }
+    switch (property) {
+        case MTP_PROPERTY_STORAGE_ID:
+            if (propList)
+                mData.putUInt16(MTP_TYPE_UINT32);
+            mData.putUInt32(object.mStorageID);
+            break;
+        case MTP_PROPERTY_OBJECT_FORMAT:
+            if (propList)
+                mData.putUInt16(MTP_TYPE_UINT16);
+            mData.putUInt16(object.mFormat);
+            break;
+        case MTP_PROPERTY_PARENT_OBJECT:
+            if (propList)
+                mData.putUInt16(MTP_TYPE_UINT32);
+            mData.putUInt32(object.mParent);
+            break;
+        case MTP_PROPERTY_OBJECT_SIZE:
+            if (propList)
+                mData.putUInt16(MTP_TYPE_UINT64);
+            mData.putUInt64(object.mSize);
+            break;
+        case MTP_PROPERTY_DATE_MODIFIED: {
+            char date[20];
+            formatDateTime(object.mDateModified, date, sizeof(date));
+            if (propList)
+                mData.putUInt16(MTP_TYPE_STR);
+            mData.putString(date);
+            break;
+        }
+    }
+    return true;
 }
 
 
@@ -515,6 +591,7 @@ MtpResponseCode MtpServer::doOpenSession() {
 
     mSessionID = mRequest.getParameter(1);
     mSessionOpen = true;
+    mObjectCache.clear();
 
     return MTP_RESPONSE_OK;
 }
@@ -524,6 +601,7 @@ MtpResponseCode MtpServer::doCloseSession() {
         return MTP_RESPONSE_SESSION_NOT_OPEN;
     mSessionID = 0;
     mSessionOpen = false;
+    mObjectCache.clear();
     return MTP_RESPONSE_OK;
 }
 
@@ -590,9 +668,14 @@ MtpResponseCode MtpServer::doGetObjectHandles() {
     if (!hasStorage(storageID))
         return MTP_RESPONSE_INVALID_STORAGE_ID;
 
-    MtpObjectHandleList* handles = mDatabase->getObjectList(storageID, format, parent);
-    if (handles == NULL)
-        return MTP_RESPONSE_INVALID_OBJECT_HANDLE;
+    MtpObjectHandleList* handles = mObjectCache.getObjectList(storageID, format, parent);
+    if (handles == NULL) {
+        uint64_t generation = mObjectCache.getGeneration();
+        handles = mDatabase->getObjectList(storageID, format, parent);
+        if (handles == NULL)
+            return MTP_RESPONSE_INVALID_OBJECT_HANDLE;
+        mObjectCache.putObjectList(storageID, format, parent, *handles, generation);
+    }
     mData.putAUInt32(handles);
     delete handles;
     return MTP_RESPONSE_OK;
@@ -610,7 +693,14 @@ MtpResponseCode MtpServer::doGetNumObjects() {
     if (!hasStorage(storageID))
         return MTP_RESPONSE_INVALID_STORAGE_ID;
 
-    int count = mDatabase->getNumObjects(storageID, format, parent);
+    int count;
+    MtpObjectHandleList* handles = mObjectCache.getObjectList(storageID, format, parent);
+    if (handles) {
+        count = handles->size();
+        delete handles;
+    } else {
+        count = mDatabase->getNumObjects(storageID, format, parent);
+    }
     if (count >= 0) {
         mResponse.setParameter(1, count);
         return MTP_RESPONSE_OK;
@@ -667,6 +757,8 @@ MtpResponseCode MtpServer::doGetObjectPropValue() {
     ALOGV("GetObjectPropValue %d %s (0x%04X)\n", handle,
           MtpDebug::getObjectPropCodeName(property), property);
 
+    if (putCachedProperty(handle, property, false))
+        return MTP_RESPONSE_OK;
     return mDatabase->getObjectPropertyValue(handle, property, mData);
 }
 
@@ -680,7 +772,9 @@ MtpResponseCode MtpServer::doSetObjectPropValue() {
     ALOGV("SetObjectPropValue %d %s\n", handle,
             MtpDebug::getObjectPropCodeName(property));
 
-    return mDatabase->setObjectPropertyValue(handle, property, mData);
+    MtpResponseCode result = mDatabase->setObjectPropertyValue(handle, property, mData);
+    mObjectCache.invalidateObject(handle);
+    return result;
 }
 
 MtpResponseCode MtpServer::doGetDevicePropValue() {
@@ -729,6 +823,10 @@ MtpResponseCode MtpServer::doGetObjectPropList() {
             handle, MtpDebug::getFormatCodeName(format),
             MtpDebug::getObjectPropCodeName(property), groupCode, depth);
 
+    // hosts often query one property of one object at a time, serve those from the cache
+    if (format == 0 && depth == 0 && handle != 0 && handle != 0xFFFFFFFF
+            && putCachedProperty(handle, property, true))
+        return MTP_RESPONSE_OK;
     return mDatabase->getObjectPropertyList(handle, format, property, groupCode, depth, mData);
 }
 
@@ -739,10 +837,13 @@ MtpResponseCode MtpServer::doGetObjectInfo() {
         return MTP_RESPONSE_INVALID_PARAMETER;
     MtpObjectHandle handle = mRequest.getParameter(1);
     MtpObjectInfo info(handle);
+    uint64_t generation = mObjectCache.getGeneration();
     MtpResponseCode result = mDatabase->getObjectInfo(handle, info);
     if (result == MTP_RESPONSE_OK) {
         char    date[20];
 
+        mObjectCache.putObject(handle, MtpObjectCache::Object(info), generation);
+
         mData.putUInt32(info.mStorageID);
         mData.putUInt16(info.mFormat);
         mData.putUInt16(info.mProtectionStatus);
@@ -1029,6 +1130,7 @@ MtpResponseCode MtpServer::doSendObjectInfo() {
     if (handle == kInvalidObjectHandle) {
         return MTP_RESPONSE_GENERAL_ERROR;
     }
+    mObjectCache.invalidateObjectAndLists(handle);
 
     if (format == MTP_FORMAT_ASSOCIATION) {
         int ret = makeFolder((const char *)path);
@@ -1125,6 +1227,11 @@ MtpResponseCode MtpServer::doMoveObject() {
     // If the move failed, undo the database change
     mDatabase->endMoveObject(info.mParent, parent, info.mStorageID, storageID, objectHandle,
             result == MTP_RESPONSE_OK);
+    // the storage of every object below a moved folder changes as well
+    if (format == MTP_FORMAT_ASSOCIATION)
+        mObjectCache.clear();
+    else
+        mObjectCache.invalidateObjectAndLists(objectHandle);
 
     return result;
 }
@@ -1194,6 +1301,7 @@ MtpResponseCode MtpServer::doCopyObject() {
     }
 
     mDatabase->endCopyObject(handle, result);
+    mObjectCache.invalidateObjectAndLists(handle);
     mResponse.setParameter(1, handle);
     return result;
 }
@@ -1298,6 +1406,7 @@ done:
     mData.reset();
 
     mDatabase->endSendObject(mSendObjectHandle, result == MTP_RESPONSE_OK);
+    mObjectCache.invalidateObjectAndLists(mSendObjectHandle);
     mSendObjectHandle = kInvalidObjectHandle;
     mSendObjectFormat = 0;
     mSendObjectModifiedTime = 0;
@@ -1334,6 +1443,10 @@ MtpResponseCode MtpServer::doDeleteObject() {
     bool success = deletePath((const char *)filePath);
 
     mDatabase->endDeleteObject(handle, success);
+    if (format == MTP_FORMAT_ASSOCIATION)
+        mObjectCache.clear();
+    else
+        mObjectCache.invalidateObjectAndLists(handle);
     return success ? result : MTP_RESPONSE_PARTIAL_DELETION;
 }
 
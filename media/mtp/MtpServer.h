@@ -21,6 +21,7 @@
 #include "MtpDataPacket.h"
 #include "MtpResponsePacket.h"
 #include "MtpEventPacket.h"
+#include "MtpObjectCache.h"
 #include "MtpStringBuffer.h"
 #include "mtp.h"
 #include "MtpUtils.h"
@@ -100,6 +101,9 @@ private:
     };
     std::vector<ObjectEdit*>  mObjectEditList;
 
+    // handle lists and common object properties, to avoid a database query per object
+    MtpObjectCache      mObjectCache;
+
 public:
                         MtpServer(IMtpDatabase* database, int controlFd, bool ptp,
                                     const char *deviceInfoManufacturer,
@@ -132,6 +136,11 @@ private:
     void                removeEditObject(MtpObjectHandle handle);
     void                commitEdit(ObjectEdit* edit);
 
+    bool                getCachedObject(MtpObjectHandle handle,
+                                MtpObjectCache::Object& outObject);
+    bool                putCachedProperty(MtpObjectHandle handle, MtpObjectProperty property,
+                                bool propList);
+
     bool                handleRequest();
 
     MtpResponseCode     doGetDeviceInfo();
@@ -73,9 +73,22 @@ AImage::free() {
         ALOGE("Cannot free AImage before close!");
         return;
     }
+    if (mReader->recycleImage(this)) {
+        return;
+    }
     delete this;
 }
 
+void
+AImage::reuse(BufferItem* buffer, int64_t timestamp, int32_t width, int32_t height) {
+    Mutex::Autolock _l(mLock);
+    mBuffer = buffer;
+    mTimestamp = timestamp;
+    mWidth = width;
+    mHeight = height;
+    mIsClosed = false;
+}
+
 void
 AImage::lockReader() const {
     mReader->mLock.lock();
@@ -173,7 +186,12 @@ media_status_t AImage::lockImage() {
         return AMEDIA_OK;
     }
 
-    auto lockedBuffer = std::make_unique<CpuConsumer::LockedBuffer>();
+    std::unique_ptr<CpuConsumer::LockedBuffer> lockedBuffer = std::move(mSpareLockedBuffer);
+    if (lockedBuffer == nullptr) {
+        lockedBuffer = std::make_unique<CpuConsumer::LockedBuffer>();
+    } else {
+        *lockedBuffer = CpuConsumer::LockedBuffer();
+    }
 
     uint64_t grallocUsage = AHardwareBuffer_convertToGrallocUsageBits(mUsage);
 
@@ -181,6 +199,7 @@ media_status_t AImage::lockImage() {
             lockImageFromBuffer(mBuffer, grallocUsage, mBuffer->mFence->dup(), lockedBuffer.get());
     if (ret != OK) {
         ALOGE("%s: AImage %p failed to lock, error=%d", __FUNCTION__, this, ret);
+        mSpareLockedBuffer = std::move(lockedBuffer);
         return AMEDIA_IMGREADER_CANNOT_LOCK_IMAGE;
     }
 
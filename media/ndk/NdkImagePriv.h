@@ -59,9 +59,13 @@ struct AImage {
     void close() { close(-1); }
     void close(int releaseFenceFd);
 
-    // Remove from object memory. Must be called after close
+    // Remove from object memory, or hand back to the reader for reuse. Must be called after close
     void free();
 
+    // Re-arms a closed image from the reader's pool with a newly acquired buffer.
+    // Caller must obtain reader lock
+    void reuse(BufferItem* buffer, int64_t timestamp, int32_t width, int32_t height);
+
     bool isClosed() const ;
 
     // only For AImage to grab reader lock
@@ -97,9 +101,11 @@ struct AImage {
     const uint64_t             mUsage;  // AHARDWAREBUFFER_USAGE_* flags.
     BufferItem*                mBuffer;
     std::unique_ptr<CpuConsumer::LockedBuffer> mLockedBuffer;
-    const int64_t              mTimestamp;
-    const int32_t              mWidth;
-    const int32_t              mHeight;
+    // Storage of the last unlocked buffer, so that locking a reused image does not allocate
+    std::unique_ptr<CpuConsumer::LockedBuffer> mSpareLockedBuffer;
+    int64_t                    mTimestamp;
+    int32_t                    mWidth;
+    int32_t                    mHeight;
     const int32_t              mNumPlanes;
     bool                       mIsClosed = false;
     mutable Mutex              mLock;
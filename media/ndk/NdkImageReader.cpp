@@ -352,6 +352,10 @@ AImageReader::init() {
     mHandler = new CallbackHandler(this);
     mCbLooper->registerHandler(mHandler);
     mIsOpen = true;
+    {
+        Mutex::Autolock _pl(mImagePoolLock);
+        mImagePoolEnabled = true;
+    }
     return AMEDIA_OK;
 }
 
@@ -384,6 +388,18 @@ void AImageReader::close() {
     }
     mAcquiredImages.clear();
 
+    // Pooled images hold a reference to this reader, delete them to break the cycle
+    List<AImage*> pooledImages;
+    {
+        Mutex::Autolock _pl(mImagePoolLock);
+        mImagePoolEnabled = false;
+        pooledImages = mImagePool;
+        mImagePool.clear();
+    }
+    for (auto it = pooledImages.begin(); it != pooledImages.end(); it++) {
+        (*it)->free();
+    }
+
     // Delete Buffer Items
     for (auto it = mBuffers.begin();
               it != mBuffers.end(); it++) {
@@ -487,11 +503,9 @@ AImageReader::acquireImageLocked(/*out*/AImage** image, /*out*/int* acquireFence
     }
 
     if (mHalFormat == HAL_PIXEL_FORMAT_BLOB) {
-        *image = new AImage(this, mFormat, mUsage, buffer, buffer->mTimestamp,
-                readerWidth, readerHeight, mNumPlanes);
+        *image = obtainImageLocked(buffer, readerWidth, readerHeight);
     } else {
-        *image = new AImage(this, mFormat, mUsage, buffer, buffer->mTimestamp,
-                bufferWidth, bufferHeight, mNumPlanes);
+        *image = obtainImageLocked(buffer, bufferWidth, bufferHeight);
     }
     mAcquiredImages.push_back(*image);
 
@@ -503,6 +517,35 @@ AImageReader::acquireImageLocked(/*out*/AImage** image, /*out*/int* acquireFence
     return AMEDIA_OK;
 }
 
+AImage*
+AImageReader::obtainImageLocked(BufferItem* buffer, int32_t width, int32_t height) {
+    AImage* image = nullptr;
+    {
+        Mutex::Autolock _pl(mImagePoolLock);
+        if (!mImagePool.empty()) {
+            auto it = mImagePool.begin();
+            image = *it;
+            mImagePool.erase(it);
+        }
+    }
+    if (image == nullptr) {
+        return new AImage(this, mFormat, mUsage, buffer, buffer->mTimestamp,
+                width, height, mNumPlanes);
+    }
+    image->reuse(buffer, buffer->mTimestamp, width, height);
+    return image;
+}
+
+bool
+AImageReader::recycleImage(AImage* image) {
+    Mutex::Autolock _pl(mImagePoolLock);
+    if (!mImagePoolEnabled || mImagePool.size() >= static_cast<size_t>(mMaxImages)) {
+        return false;
+    }
+    mImagePool.push_back(image);
+    return true;
+}
+
 BufferItem*
 AImageReader::getBufferItemLocked() {
     if (mBuffers.empty()) {
@@ -542,7 +585,9 @@ AImageReader::releaseImageLocked(AImage* image, int releaseFenceFd, bool clearCa
     mBufferItemConsumer->releaseBuffer(*buffer, bufferFence);
     returnBufferItemLocked(buffer);
     image->mBuffer = nullptr;
-    image->mLockedBuffer = nullptr;
+    if (image->mLockedBuffer != nullptr) {
+        image->mSpareLockedBuffer = std::move(image->mLockedBuffer);
+    }
     image->mIsClosed = true;
 
     if (!clearCache) {
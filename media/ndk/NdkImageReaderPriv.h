@@ -91,6 +91,13 @@ struct AImageReader : public RefBase {
     // Called by AImage/~AImageReader to close image. Caller is responsible to grab AImage::mLock
     void releaseImageLocked(AImage* image, int releaseFenceFd, bool clearCache = true);
 
+    // Returns an AImage wrapping the acquired buffer, reusing a pooled one when available.
+    AImage* obtainImageLocked(BufferItem* buffer, int32_t width, int32_t height);
+
+    // Called by AImage::free to keep a closed image for a later acquire, bounded by mMaxImages.
+    // Returns false if the image should be deleted instead. Does not need the reader lock.
+    bool recycleImage(AImage* image);
+
     static int getBufferWidth(BufferItem* buffer);
     static int getBufferHeight(BufferItem* buffer);
 
@@ -168,6 +175,12 @@ struct AImageReader : public RefBase {
     List<AImage*>              mAcquiredImages;
     bool                       mIsOpen = false;
 
+    // Closed images kept for reuse. AImage::free can run with or without mLock held, so the
+    // pool has its own lock, which is never held while taking another one.
+    Mutex                      mImagePoolLock;
+    List<AImage*>              mImagePool;
+    bool                       mImagePoolEnabled = false;
+
     Mutex                      mLock;
 };
 
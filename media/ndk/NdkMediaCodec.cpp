@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include <mutex>
 #include <set>
+#include <vector>
 
 //#define LOG_NDEBUG 0
 #define LOG_TAG "NdkMediaCodec"
@@ -76,6 +77,7 @@ enum {
     kWhatRequestActivityNotifications,
     kWhatStopActivityNotifications,
     kWhatFrameRenderedNotify,
+    kWhatAsyncBatchNotify,
 };
 
 struct AMediaCodecPersistentSurface : public Surface {
@@ -97,6 +99,9 @@ private:
 public:
     explicit CodecHandler(AMediaCodec *codec);
     virtual void onMessageReceived(const sp<AMessage> &msg);
+private:
+    void postAsyncBatchNotifyLocked();
+    void deliverAsyncBatchLocked();
 };
 
 typedef void (*OnCodecEvent)(AMediaCodec *codec, void *userdata);
@@ -116,6 +121,14 @@ struct AMediaCodec {
     AMediaCodecOnAsyncNotifyCallback mAsyncCallback;
     void *mAsyncCallbackUserData;
 
+    // Set with AMediaCodec_setAsyncNotifyBatchCallback; guarded by mAsyncCallbackLock.
+    bool mAsyncBatchMode;
+    AMediaCodecOnAsyncNotifyBatchCallback mAsyncBatchCallback;
+    bool mAsyncBatchNotifyPosted;
+    std::vector<int32_t> mPendingInputIndices;
+    std::vector<int32_t> mPendingOutputIndices;
+    std::vector<AMediaCodecBufferInfo> mPendingOutputInfos;
+
     sp<AMessage> mFrameRenderedNotify;
     mutable Mutex mFrameRenderedCallbackLock;
     AMediaCodecOnFrameRendered mFrameRenderedCallback;
@@ -126,6 +139,39 @@ CodecHandler::CodecHandler(AMediaCodec *codec) {
     mCodec = codec;
 }
 
+void CodecHandler::postAsyncBatchNotifyLocked() {
+    // Everything that arrives before this message is handled goes in the same batch.
+    if (!mCodec->mAsyncBatchNotifyPosted) {
+        mCodec->mAsyncBatchNotifyPosted = true;
+        (new AMessage(kWhatAsyncBatchNotify, this))->post();
+    }
+}
+
+void CodecHandler::deliverAsyncBatchLocked() {
+    if (!mCodec->mPendingInputIndices.empty()) {
+        if (mCodec->mAsyncBatchCallback.onAsyncInputsAvailable != NULL) {
+            mCodec->mAsyncBatchCallback.onAsyncInputsAvailable(
+                    mCodec,
+                    mCodec->mAsyncCallbackUserData,
+                    mCodec->mPendingInputIndices.data(),
+                    mCodec->mPendingInputIndices.size());
+        }
+        mCodec->mPendingInputIndices.clear();
+    }
+    if (!mCodec->mPendingOutputIndices.empty()) {
+        if (mCodec->mAsyncBatchCallback.onAsyncOutputsAvailable != NULL) {
+            mCodec->mAsyncBatchCallback.onAsyncOutputsAvailable(
+                    mCodec,
+                    mCodec->mAsyncCallbackUserData,
+                    mCodec->mPendingOutputIndices.data(),
+                    mCodec->mPendingOutputInfos.data(),
+                    mCodec->mPendingOutputIndices.size());
+        }
+        mCodec->mPendingOutputIndices.clear();
+        mCodec->mPendingOutputInfos.clear();
+    }
+}
+
 void CodecHandler::onMessageReceived(const sp<AMessage> &msg) {
 
     switch (msg->what()) {
@@ -180,7 +226,10 @@ void CodecHandler::onMessageReceived(const sp<AMessage> &msg) {
                      }
 
                      Mutex::Autolock _l(mCodec->mAsyncCallbackLock);
-                     if (mCodec->mAsyncCallback.onAsyncInputAvailable != NULL) {
+                     if (mCodec->mAsyncBatchMode) {
+                         mCodec->mPendingInputIndices.push_back(index);
+                         postAsyncBatchNotifyLocked();
+                     } else if (mCodec->mAsyncCallback.onAsyncInputAvailable != NULL) {
                          mCodec->mAsyncCallback.onAsyncInputAvailable(
                                  mCodec,
                                  mCodec->mAsyncCallbackUserData,
@@ -226,7 +275,11 @@ void CodecHandler::onMessageReceived(const sp<AMessage> &msg) {
                          (uint32_t)flags};
 
                      Mutex::Autolock _l(mCodec->mAsyncCallbackLock);
-                     if (mCodec->mAsyncCallback.onAsyncOutputAvailable != NULL) {
+                     if (mCodec->mAsyncBatchMode) {
+                         mCodec->mPendingOutputIndices.push_back(index);
+                         mCodec->mPendingOutputInfos.push_back(bufferInfo);
+                         postAsyncBatchNotifyLocked();
+                     } else if (mCodec->mAsyncCallback.onAsyncOutputAvailable != NULL) {
                          mCodec->mAsyncCallback.onAsyncOutputAvailable(
                                  mCodec,
                                  mCodec->mAsyncCallbackUserData,
@@ -254,7 +307,15 @@ void CodecHandler::onMessageReceived(const sp<AMessage> &msg) {
                      AMediaFormat *aMediaFormat = AMediaFormat_fromMsg(&copy);
 
                      Mutex::Autolock _l(mCodec->mAsyncCallbackLock);
-                     if (mCodec->mAsyncCallback.onAsyncFormatChanged != NULL) {
+                     if (mCodec->mAsyncBatchMode) {
+                         deliverAsyncBatchLocked();
+                         if (mCodec->mAsyncBatchCallback.onAsyncFormatChanged != NULL) {
+                             mCodec->mAsyncBatchCallback.onAsyncFormatChanged(
+                                     mCodec,
+                                     mCodec->mAsyncCallbackUserData,
+                                     aMediaFormat);
+                         }
+                     } else if (mCodec->mAsyncCallback.onAsyncFormatChanged != NULL) {
                          mCodec->mAsyncCallback.onAsyncFormatChanged(
                                  mCodec,
                                  mCodec->mAsyncCallbackUserData,
@@ -282,7 +343,17 @@ void CodecHandler::onMessageReceived(const sp<AMessage> &msg) {
                            err, StrMediaError(err).c_str(), actionCode, detail.c_str());
 
                      Mutex::Autolock _l(mCodec->mAsyncCallbackLock);
-                     if (mCodec->mAsyncCallback.onAsyncError != NULL) {
+                     if (mCodec->mAsyncBatchMode) {
+                         deliverAsyncBatchLocked();
+                         if (mCodec->mAsyncBatchCallback.onAsyncError != NULL) {
+                             mCodec->mAsyncBatchCallback.onAsyncError(
+                                     mCodec,
+                                     mCodec->mAsyncCallbackUserData,
+                                     translate_error(err),
+                                     actionCode,
+                                     detail.c_str());
+                         }
+                     } else if (mCodec->mAsyncCallback.onAsyncError != NULL) {
                          mCodec->mAsyncCallback.onAsyncError(
                                  mCodec,
                                  mCodec->mAsyncCallbackUserData,
@@ -303,6 +374,16 @@ void CodecHandler::onMessageReceived(const sp<AMessage> &msg) {
              break;
         }
 
+        case kWhatAsyncBatchNotify:
+        {
+            Mutex::Autolock _l(mCodec->mAsyncCallbackLock);
+            mCodec->mAsyncBatchNotifyPosted = false;
+            if (mCodec->mAsyncBatchMode) {
+                deliverAsyncBatchLocked();
+            }
+            break;
+        }
+
         case kWhatStopActivityNotifications:
         {
             sp<AReplyToken> replyID;
@@ -444,6 +525,9 @@ static AMediaCodec * createAMediaCodec(const char *name,
 
     mData->mAsyncCallback = {};
     mData->mAsyncCallbackUserData = NULL;
+    mData->mAsyncBatchMode = false;
+    mData->mAsyncBatchCallback = {};
+    mData->mAsyncBatchNotifyPosted = false;
 
     return mData;
 }
@@ -572,6 +656,8 @@ media_status_t AMediaCodec_setAsyncNotifyCallback(
         // success.
         mData->mAsyncCallback = callback;
         mData->mAsyncCallbackUserData = userdata;
+        mData->mAsyncBatchMode = false;
+        mData->mAsyncBatchCallback = {};
     }
 
     // always call, codec may have been reset/re-configured since last call.
@@ -590,6 +676,42 @@ media_status_t AMediaCodec_setAsyncNotifyCallback(
     return AMEDIA_OK;
 }
 
+EXPORT
+media_status_t AMediaCodec_setAsyncNotifyBatchCallback(
+        AMediaCodec *mData,
+        AMediaCodecOnAsyncNotifyBatchCallback callback,
+        void *userdata) {
+
+    {
+        Mutex::Autolock _l(mData->mAsyncCallbackLock);
+        if (mData->mAsyncNotify == NULL) {
+            mData->mAsyncNotify = new AMessage(kWhatAsyncNotify, mData->mHandler);
+        }
+        mData->mAsyncCallback = {};
+        mData->mAsyncBatchCallback = callback;
+        mData->mAsyncCallbackUserData = userdata;
+        mData->mAsyncBatchMode = true;
+        mData->mPendingInputIndices.clear();
+        mData->mPendingOutputIndices.clear();
+        mData->mPendingOutputInfos.clear();
+    }
+
+    // always call, codec may have been reset/re-configured since last call.
+    status_t err = mData->mCodec->setCallback(mData->mAsyncNotify);
+    if (err != OK) {
+        {
+            Mutex::Autolock _l(mData->mAsyncCallbackLock);
+            mData->mAsyncBatchMode = false;
+            mData->mAsyncBatchCallback = {};
+            mData->mAsyncCallbackUserData = nullptr;
+        }
+        ALOGE("setAsyncNotifyBatchCallback: err(%d), failed to set async callback", err);
+        return translate_error(err);
+    }
+
+    return AMEDIA_OK;
+}
+
 EXPORT
 media_status_t AMediaCodec_setOnFrameRenderedCallback(
         AMediaCodec *mData,
@@ -27,6 +27,7 @@
 
 
 #include <inttypes.h>
+#include <vector>
 #include <utils/Log.h>
 #include <utils/StrongPointer.h>
 #include <media/hardware/CryptoAPI.h>
@@ -189,6 +190,39 @@ ssize_t AMediaExtractor_readSampleData(AMediaExtractor *mData, uint8_t *buffer,
     return -1;
 }
 
+EXPORT
+media_status_t AMediaExtractor_readSamples(AMediaExtractor *mData,
+        uint8_t *buffer, size_t capacity,
+        AMediaExtractorSampleInfo *samples, size_t maxSamples,
+        size_t *numSamples) {
+    if (mData == NULL || buffer == NULL || samples == NULL || maxSamples == 0
+            || numSamples == NULL) {
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+    *numSamples = 0;
+
+    std::vector<NuMediaExtractor::SampleInfo> infos(maxSamples);
+    size_t count = 0;
+    status_t err = mData->mImpl->readSamples(buffer, capacity, infos.data(), maxSamples, &count);
+    if (err == -ENOMEM) {
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    } else if (err == ERROR_UNSUPPORTED) {
+        return AMEDIA_ERROR_UNSUPPORTED;
+    } else if (err != OK) {
+        return translate_error(err);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        samples[i].offset = infos[i].mOffset;
+        samples[i].size = infos[i].mSize;
+        samples[i].presentationTimeUs = infos[i].mSampleTimeUs;
+        samples[i].flags = infos[i].mIsSync ? AMEDIAEXTRACTOR_SAMPLE_FLAG_SYNC : 0;
+        samples[i].trackIndex = infos[i].mTrackIndex;
+    }
+    *numSamples = count;
+    return AMEDIA_OK;
+}
+
 EXPORT
 ssize_t AMediaExtractor_getSampleSize(AMediaExtractor *mData) {
     size_t sampleSize;
@@ -123,6 +123,38 @@ typedef struct AMediaCodecOnAsyncNotifyCallback {
       AMediaCodecOnAsyncError           onAsyncError;
 } AMediaCodecOnAsyncNotifyCallback;
 
+/**
+ * Called when input buffers become available, if the callback was set with
+ * AMediaCodec_setAsyncNotifyBatchCallback.
+ * The specified indices are the indices of the available input buffers, in the
+ * order they became available. The array is only valid during the call.
+ */
+typedef void (*AMediaCodecOnAsyncInputsAvailable)(
+        AMediaCodec *codec,
+        void *userdata,
+        const int32_t *indices,
+        size_t count);
+/**
+ * Called when output buffers become available, if the callback was set with
+ * AMediaCodec_setAsyncNotifyBatchCallback.
+ * The specified indices are the indices of the available output buffers, in the
+ * order they became available, and bufferInfos[i] describes indices[i].
+ * The arrays are only valid during the call.
+ */
+typedef void (*AMediaCodecOnAsyncOutputsAvailable)(
+        AMediaCodec *codec,
+        void *userdata,
+        const int32_t *indices,
+        const AMediaCodecBufferInfo *bufferInfos,
+        size_t count);
+
+typedef struct AMediaCodecOnAsyncNotifyBatchCallback {
+      AMediaCodecOnAsyncInputsAvailable  onAsyncInputsAvailable;
+      AMediaCodecOnAsyncOutputsAvailable onAsyncOutputsAvailable;
+      AMediaCodecOnAsyncFormatChanged    onAsyncFormatChanged;
+      AMediaCodecOnAsyncError            onAsyncError;
+} AMediaCodecOnAsyncNotifyBatchCallback;
+
 /**
  * Called when an output frame has rendered on the output surface.
  *
@@ -504,6 +536,26 @@ media_status_t AMediaCodec_setOnFrameRenderedCallback(
         AMediaCodecOnFrameRendered callback,
         void *userdata) __INTRODUCED_IN(__ANDROID_API_T__);
 
+/**
+ * Same as AMediaCodec_setAsyncNotifyCallback, except that the buffers which
+ * become available while the callback thread is busy are coalesced and reported
+ * in a single AMediaCodecOnAsyncInputsAvailable or
+ * AMediaCodecOnAsyncOutputsAvailable call. Format changes and errors are
+ * reported after the buffers that became available before them.
+ *
+ * This replaces any callback set with AMediaCodec_setAsyncNotifyCallback, and
+ * vice versa. When called with null callback, this method unregisters any
+ * previously set callback.
+ *
+ * The same threading rules as for AMediaCodec_setAsyncNotifyCallback apply.
+ *
+ * Available since API level 34.
+ */
+media_status_t AMediaCodec_setAsyncNotifyBatchCallback(
+        AMediaCodec*,
+        AMediaCodecOnAsyncNotifyBatchCallback callback,
+        void *userdata) __INTRODUCED_IN(34);
+
 /**
  * Release the crypto if applicable.
  *
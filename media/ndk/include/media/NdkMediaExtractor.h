@@ -258,6 +258,45 @@ int64_t AMediaExtractor_getCachedDuration(AMediaExtractor *) __INTRODUCED_IN(28)
 media_status_t AMediaExtractor_getSampleFormat(AMediaExtractor *ex,
         AMediaFormat *fmt) __INTRODUCED_IN(28);
 
+/**
+ * Describes one sample read by AMediaExtractor_readSamples.
+ */
+typedef struct AMediaExtractorSampleInfo {
+    /** Offset of the sample data in the buffer passed to AMediaExtractor_readSamples. */
+    size_t offset;
+    /** Size of the sample data in bytes. */
+    size_t size;
+    /** Presentation time of the sample in microseconds. */
+    int64_t presentationTimeUs;
+    /** AMEDIAEXTRACTOR_SAMPLE_FLAG_* flags of the sample. */
+    uint32_t flags;
+    /** Index of the track the sample originates from. */
+    int32_t trackIndex;
+} AMediaExtractorSampleInfo;
+
+/**
+ * Reads up to |maxSamples| samples in one call, starting with the current sample, and advances
+ * past them. This is the same as calling AMediaExtractor_readSampleData,
+ * AMediaExtractor_getSampleTime, AMediaExtractor_getSampleFlags,
+ * AMediaExtractor_getSampleTrackIndex and AMediaExtractor_advance for each sample.
+ *
+ * The sample data is stored back to back in |buffer| and samples[i] describes the i-th
+ * sample. The number of samples read is returned in |numSamples|. Fewer than |maxSamples|
+ * samples are read if the next sample does not fit in the remaining capacity, if it is encrypted,
+ * or at the end of the stream. An encrypted sample stays the current sample, so it can be read
+ * with AMediaExtractor_readSampleData and AMediaExtractor_getSampleCryptoInfo.
+ *
+ * Returns AMEDIA_OK if at least one sample was read, AMEDIA_ERROR_END_OF_STREAM if there are no
+ * more samples, AMEDIA_ERROR_INVALID_PARAMETER if the current sample does not fit in |capacity|
+ * bytes, or AMEDIA_ERROR_UNSUPPORTED if the current sample is encrypted.
+ *
+ * Available since API level 34.
+ */
+media_status_t AMediaExtractor_readSamples(AMediaExtractor *ex,
+        uint8_t *buffer, size_t capacity,
+        AMediaExtractorSampleInfo *samples, size_t maxSamples,
+        size_t *numSamples) __INTRODUCED_IN(34);
+
 __END_DECLS
 
 #endif // _NDK_MEDIA_EXTRACTOR_H
@@ -39,6 +39,11 @@ constexpr uint32_t kMaxBufferSize = 1024 * 1024 * 16;
 // AUDIO_ENCODE_DEFAULT_MAX_INPUT_SIZE present in Encoder.java
 constexpr uint32_t kDefaultAudioEncodeFrameSize = 4096;
 
+// constants not defined in NDK api
+constexpr int32_t COLOR_FormatYUV420Planar = 19;
+constexpr int32_t COLOR_FormatYUV420SemiPlanar = 21;
+constexpr int32_t COLOR_FormatYUV420Flexible = 0x7F420888;
+
 template <typename T>
 class CallBackQueue {
   public:
@@ -87,3 +87,71 @@ void Stats::dumpStatistics(string operation, string inputReference, int64_t dura
     out << rowData;
     out.close();
 }
+
+/**
+ * Returns the nearest rank percentile of the values, which are sorted in place.
+ */
+static nsecs_t getPercentile(std::vector<nsecs_t> &values, int32_t percentile) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t rank = (values.size() * percentile + 99) / 100;
+    return values.at(rank ? rank - 1 : 0);
+}
+
+/**
+ * Dumps the stats of a composite extract -> decode -> encode -> mux run for a given input media.
+ *
+ * \param inputReference input media
+ * \param durationUs     is a duration of the input media in microseconds.
+ * \param componentName  describes the codecs of the pipeline.
+ * \param concurrency    the number of pipelines that ran at the same time.
+ * \param statsFile      the file where the stats data is to be written.
+ */
+void Stats::dumpPipelineStatistics(string inputReference, int64_t durationUs,
+                                   string componentName, int32_t concurrency, string statsFile) {
+    ALOGV("In %s", __func__);
+    if (!mOutputTimer.size()) {
+        ALOGE("No output produced");
+        return;
+    }
+    nsecs_t totalTimeTakenNs = getTotalTime();
+    nsecs_t timeTakenPerSec = (totalTimeTakenNs * 1000000) / durationUs;
+    int64_t size = std::accumulate(mFrameSizes.begin(), mFrameSizes.end(), (int64_t)0);
+    int64_t framesPerSec = ((int64_t)mOutputTimer.size() * 1000000000) / totalTimeTakenNs;
+    int64_t bytesPerSec = (size * 1000000000) / totalTimeTakenNs;
+
+    // Write the stats data to file.
+    string rowData = "";
+    rowData.append(to_string(systemTime(CLOCK_MONOTONIC)) + ", ");
+    rowData.append(inputReference + ", ");
+    rowData.append("pipeline, ");
+    rowData.append(componentName + ", ");
+    rowData.append("NDK, ");
+    rowData.append(to_string(concurrency) + ", ");
+    rowData.append(to_string(mInitTimeNs) + ", ");
+    rowData.append(to_string(mDeInitTimeNs) + ", ");
+    rowData.append(to_string(mOutputTimer.size()) + ", ");
+    rowData.append(to_string(framesPerSec) + ", ");
+    rowData.append(to_string(timeTakenPerSec) + ", ");
+    rowData.append(to_string(bytesPerSec) + ", ");
+    rowData.append(to_string(mCpuTimeNs) + ", ");
+    rowData.append(to_string(mPeakRssKb) + ", ");
+    rowData.append(to_string(totalTimeTakenNs));
+    // stages are named in the row, as a pipeline does not run all of them
+    for (auto &stage : mStageLatencies) {
+        rowData.append(", " + stage.first + ", ");
+        rowData.append(to_string(getPercentile(stage.second, 50)) + ", ");
+        rowData.append(to_string(getPercentile(stage.second, 90)) + ", ");
+        rowData.append(to_string(getPercentile(stage.second, 99)) + ", ");
+        rowData.append(to_string(stage.second.back()));
+    }
+    rowData.append(",\n");
+
+    ofstream out(statsFile, ios::out | ios::app);
+    if(out.bad()) {
+        ALOGE("Failed to open stats file for writing!");
+        return;
+    }
+    out << rowData;
+    out.close();
+}
@@ -41,7 +41,9 @@
 
 #include <sys/time.h>
 #include <algorithm>
+#include <map>
 #include <numeric>
+#include <string>
 #include <vector>
 
 // Include local copy of Timers taken from system/core/libutils
@@ -54,6 +56,8 @@ class Stats {
     Stats() {
         mInitTimeNs = 0;
         mDeInitTimeNs = 0;
+        mCpuTimeNs = 0;
+        mPeakRssKb = 0;
     }
 
     ~Stats() {
@@ -67,6 +71,10 @@ class Stats {
     std::vector<int32_t> mFrameSizes;
     std::vector<nsecs_t> mInputTimer;
     std::vector<nsecs_t> mOutputTimer;
+    // Per frame latencies of the stages of a pipeline, by stage name
+    std::map<string, std::vector<nsecs_t>> mStageLatencies;
+    nsecs_t mCpuTimeNs;
+    int64_t mPeakRssKb;
 
   public:
     nsecs_t getCurTime() { return systemTime(CLOCK_MONOTONIC); }
@@ -83,10 +91,20 @@ class Stats {
 
     void addOutputTime() { mOutputTimer.push_back(systemTime(CLOCK_MONOTONIC)); }
 
+    void addStageLatency(const string &stage, nsecs_t latencyNs) {
+        mStageLatencies[stage].push_back(latencyNs);
+    }
+
+    void setResourceUsage(nsecs_t cpuTimeNs, int64_t peakRssKb) {
+        mCpuTimeNs = cpuTimeNs;
+        mPeakRssKb = peakRssKb;
+    }
+
     void reset() {
         if (!mFrameSizes.empty()) mFrameSizes.clear();
         if (!mInputTimer.empty()) mInputTimer.clear();
         if (!mOutputTimer.empty()) mOutputTimer.clear();
+        if (!mStageLatencies.empty()) mStageLatencies.clear();
     }
 
     std::vector<nsecs_t> getOutputTimer() { return mOutputTimer; }
@@ -104,6 +122,10 @@ class Stats {
 
     void dumpStatistics(string operation, string inputReference, int64_t duarationUs,
                         string codecName = "", string mode = "", string statsFile = "");
+
+    void dumpPipelineStatistics(string inputReference, int64_t durationUs,
+                                string componentName = "", int32_t concurrency = 1,
+                                string statsFile = "");
 };
 
 #endif  // __STATS_H__
@@ -26,9 +26,6 @@
 #include "BenchmarkCommon.h"
 #include "Stats.h"
 
-// constant not defined in NDK api
-constexpr int32_t COLOR_FormatYUV420Flexible = 0x7F420888;
-
 struct encParameter {
     int32_t bitrate = -1;
     int32_t numFrames = -1;
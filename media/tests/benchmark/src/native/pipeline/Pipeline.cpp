@@ -0,0 +1,410 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "pipeline"
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include "Pipeline.h"
+
+constexpr int32_t kDefaultFrameRate = 25;
+constexpr int32_t kDefaultVideoBitRate = 8000000 /* 8 Mbps */;
+constexpr int32_t kDefaultAudioBitRate = 128000 /* 128 Kbps */;
+
+static nsecs_t getThreadCpuTimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int32_t Pipeline::setupPipeline(int32_t outFd, pipelineParameter params) {
+    ALOGV("In %s", __func__);
+    mParams = params;
+    mInputFormat = mExtractor->getFormat();
+    if (!mInputFormat) return AMEDIA_ERROR_INVALID_OBJECT;
+
+    const char *mime = nullptr;
+    AMediaFormat_getString(mInputFormat, AMEDIAFORMAT_KEY_MIME, &mime);
+    if (!mime) return AMEDIA_ERROR_INVALID_OBJECT;
+    mMime = mime;
+    mIsVideo = !strncmp(mime, "video/", 6);
+    if (mParams.encoderMime.empty()) mParams.encoderMime = mMime;
+
+    int64_t sTime = mStats->getCurTime();
+    mDecoder = createMediaCodec(mInputFormat, mime, mParams.decoderName, false /*isEncoder*/);
+    if (!mDecoder) return AMEDIA_ERROR_INVALID_OBJECT;
+    media_status_t status = AMediaCodec_start(mDecoder);
+    if (status != AMEDIA_OK) {
+        ALOGE("AMediaCodec_start of the decoder failed %d", status);
+        return status;
+    }
+
+    mMuxer = AMediaMuxer_new(outFd, (OutputFormat)mParams.outputFormat);
+    if (!mMuxer) {
+        ALOGE("Unable to create muxer");
+        return AMEDIA_ERROR_INVALID_OBJECT;
+    }
+    int64_t eTime = mStats->getCurTime();
+    mStats->setInitTime(mStats->getTimeDiff(sTime, eTime));
+    return AMEDIA_OK;
+}
+
+void Pipeline::updateFrameLayout(AMediaFormat *format) {
+    if (mIsVideo) {
+        AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_WIDTH, &mWidth);
+        AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_HEIGHT, &mHeight);
+        if (!AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_STRIDE, &mStride)) mStride = mWidth;
+        if (!AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_SLICE_HEIGHT, &mSliceHeight)) {
+            mSliceHeight = mHeight;
+        }
+        if (!AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_COLOR_FORMAT, &mColorFormat)) {
+            mColorFormat = COLOR_FormatYUV420Flexible;
+        }
+        ALOGV("Decoded frames are %dx%d, stride %d, slice height %d, color format %d", mWidth,
+              mHeight, mStride, mSliceHeight, mColorFormat);
+    } else {
+        AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_SAMPLE_RATE, &mSampleRate);
+        AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_CHANNEL_COUNT, &mNumChannels);
+    }
+}
+
+int32_t Pipeline::setupEncoder() {
+    ALOGV("In %s", __func__);
+    AMediaFormat *format = AMediaFormat_new();
+    if (!format) return AMEDIA_ERROR_INVALID_OBJECT;
+
+    AMediaFormat_setString(format, AMEDIAFORMAT_KEY_MIME, mParams.encoderMime.c_str());
+    int32_t bitrate = mParams.bitrate;
+    if (mIsVideo) {
+        int32_t frameRate = mParams.frameRate;
+        if (frameRate <= 0 &&
+            !AMediaFormat_getInt32(mInputFormat, AMEDIAFORMAT_KEY_FRAME_RATE, &frameRate)) {
+            frameRate = kDefaultFrameRate;
+        }
+        if (bitrate <= 0 &&
+            !AMediaFormat_getInt32(mInputFormat, AMEDIAFORMAT_KEY_BIT_RATE, &bitrate)) {
+            bitrate = kDefaultVideoBitRate;
+        }
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_WIDTH, mWidth);
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_HEIGHT, mHeight);
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_FRAME_RATE, frameRate);
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_I_FRAME_INTERVAL, mParams.iFrameInterval);
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_COLOR_FORMAT,
+                              mParams.colorConvert ? COLOR_FormatYUV420Planar : mColorFormat);
+    } else {
+        if (bitrate <= 0) bitrate = kDefaultAudioBitRate;
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_SAMPLE_RATE, mSampleRate);
+        AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_CHANNEL_COUNT, mNumChannels);
+    }
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_BIT_RATE, bitrate);
+
+    mEncoder = createMediaCodec(format, mParams.encoderMime.c_str(), mParams.encoderName,
+                                true /*isEncoder*/);
+    AMediaFormat_delete(format);
+    if (!mEncoder) return AMEDIA_ERROR_INVALID_OBJECT;
+
+    media_status_t status = AMediaCodec_start(mEncoder);
+    if (status != AMEDIA_OK) ALOGE("AMediaCodec_start of the encoder failed %d", status);
+    return status;
+}
+
+int32_t Pipeline::feedDecoder() {
+    ssize_t inIdx = AMediaCodec_dequeueInputBuffer(mDecoder, kQueueDequeueTimeoutUs);
+    if (inIdx < 0) return AMEDIA_OK;
+
+    size_t bufSize;
+    uint8_t *buf = AMediaCodec_getInputBuffer(mDecoder, inIdx, &bufSize);
+    if (!buf) return AMEDIA_ERROR_IO;
+
+    AMediaCodecBufferInfo info;
+    nsecs_t sTime = mStats->getCurTime();
+    int32_t status = mExtractor->getFrameSample(info);
+    if (status || !info.size) {
+        ALOGV("Input EOS");
+        mSawInputEOS = true;
+        return AMediaCodec_queueInputBuffer(mDecoder, inIdx, 0 /* offset */, 0 /* size */,
+                                            0 /* pts */, AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM);
+    }
+    if ((size_t)info.size > bufSize) {
+        ALOGE("Decoder input buffer of %zu bytes is too small for a sample of %d bytes", bufSize,
+              info.size);
+        return AMEDIA_ERROR_MALFORMED;
+    }
+    memcpy(buf, mExtractor->getFrameBuf(), info.size);
+    nsecs_t eTime = mStats->getCurTime();
+    mStats->addStageLatency(kStageExtract, mStats->getTimeDiff(sTime, eTime));
+
+    mDecodeStartNs[info.presentationTimeUs] = eTime;
+    return AMediaCodec_queueInputBuffer(mDecoder, inIdx, 0 /* offset */, info.size,
+                                        info.presentationTimeUs, 0 /* flags */);
+}
+
+int32_t Pipeline::drainDecoder() {
+    AMediaCodecBufferInfo info;
+    ssize_t outIdx = AMediaCodec_dequeueOutputBuffer(mDecoder, &info, kQueueDequeueTimeoutUs);
+    if (outIdx == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
+        AMediaFormat *format = AMediaCodec_getOutputFormat(mDecoder);
+        updateFrameLayout(format);
+        AMediaFormat_delete(format);
+        return mEncoder ? AMEDIA_OK : setupEncoder();
+    }
+    if (outIdx < 0) return AMEDIA_OK;
+
+    nsecs_t eTime = mStats->getCurTime();
+    auto it = mDecodeStartNs.find(info.presentationTimeUs);
+    if (it != mDecodeStartNs.end()) {
+        mStats->addStageLatency(kStageDecode, mStats->getTimeDiff(it->second, eTime));
+        mDecodeStartNs.erase(it);
+    }
+
+    if (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) {
+        ALOGV("Decoder output EOS");
+        mSawDecoderEOS = true;
+    }
+    if (!mEncoder) {
+        if (mSawDecoderEOS && !info.size) {
+            ALOGE("Decoder did not produce any output");
+            return AMEDIA_ERROR_MALFORMED;
+        }
+        AMediaFormat *format = AMediaCodec_getOutputFormat(mDecoder);
+        updateFrameLayout(format);
+        AMediaFormat_delete(format);
+        int32_t status = setupEncoder();
+        if (status != AMEDIA_OK) return status;
+    }
+    mDecoderOutputIndex = outIdx;
+    mDecoderOutputInfo = info;
+    return AMEDIA_OK;
+}
+
+size_t Pipeline::convertFrame(const uint8_t *src, uint8_t *dst, size_t dstSize) {
+    size_t chromaWidth = (mWidth + 1) / 2;
+    size_t chromaHeight = (mHeight + 1) / 2;
+    size_t lumaSize = (size_t)mWidth * mHeight;
+    size_t frameSize = lumaSize + 2 * chromaWidth * chromaHeight;
+    if (frameSize > dstSize) {
+        ALOGE("Encoder input buffer of %zu bytes is too small for a frame of %zu bytes", dstSize,
+              frameSize);
+        return 0;
+    }
+
+    for (int32_t row = 0; row < mHeight; row++) {
+        memcpy(dst + row * mWidth, src + row * mStride, mWidth);
+    }
+    const uint8_t *srcChroma = src + (size_t)mStride * mSliceHeight;
+    uint8_t *dstU = dst + lumaSize;
+    uint8_t *dstV = dstU + chromaWidth * chromaHeight;
+    if (mColorFormat == COLOR_FormatYUV420SemiPlanar) {
+        for (size_t row = 0; row < chromaHeight; row++) {
+            const uint8_t *srcRow = srcChroma + row * mStride;
+            for (size_t col = 0; col < chromaWidth; col++) {
+                *dstU++ = srcRow[2 * col];
+                *dstV++ = srcRow[2 * col + 1];
+            }
+        }
+    } else if (mColorFormat == COLOR_FormatYUV420Planar ||
+               mColorFormat == COLOR_FormatYUV420Flexible) {
+        // Flexible byte buffers of the software decoders are laid out as planar
+        size_t chromaStride = (mStride + 1) / 2;
+        const uint8_t *srcV = srcChroma + chromaStride * ((mSliceHeight + 1) / 2);
+        for (size_t row = 0; row < chromaHeight; row++) {
+            memcpy(dstU + row * chromaWidth, srcChroma + row * chromaStride, chromaWidth);
+            memcpy(dstV + row * chromaWidth, srcV + row * chromaStride, chromaWidth);
+        }
+    } else {
+        ALOGE("Color conversion from color format %d is not supported", mColorFormat);
+        return 0;
+    }
+    return frameSize;
+}
+
+int32_t Pipeline::feedEncoder() {
+    ssize_t inIdx = AMediaCodec_dequeueInputBuffer(mEncoder, kQueueDequeueTimeoutUs);
+    if (inIdx < 0) return AMEDIA_OK;
+
+    size_t bufSize;
+    uint8_t *buf = AMediaCodec_getInputBuffer(mEncoder, inIdx, &bufSize);
+    size_t outSize;
+    uint8_t *out = AMediaCodec_getOutputBuffer(mDecoder, mDecoderOutputIndex, &outSize);
+    if (!buf || !out) return AMEDIA_ERROR_IO;
+
+    AMediaCodecBufferInfo &info = mDecoderOutputInfo;
+    size_t size = info.size;
+    if (size && mIsVideo && mParams.colorConvert) {
+        nsecs_t sTime = mStats->getCurTime();
+        size = convertFrame(out + info.offset, buf, bufSize);
+        if (!size) return AMEDIA_ERROR_UNSUPPORTED;
+        mStats->addStageLatency(kStageConvert, mStats->getTimeDiff(sTime, mStats->getCurTime()));
+    } else if (size > bufSize && mIsVideo) {
+        ALOGE("Encoder input buffer of %zu bytes is too small for a frame of %zu bytes", bufSize,
+              size);
+        return AMEDIA_ERROR_MALFORMED;
+    } else {
+        // Audio frames larger than the encoder's input buffer are split over several buffers
+        size = min(size, bufSize);
+        memcpy(buf, out + info.offset, size);
+    }
+
+    int64_t presentationTimeUs = info.presentationTimeUs;
+    uint32_t flags = info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM;
+    bool consumed = true;
+    if (size < (size_t)info.size && !mIsVideo) {
+        if (mSampleRate <= 0 || mNumChannels <= 0) return AMEDIA_ERROR_MALFORMED;
+        info.offset += size;
+        info.size -= size;
+        info.presentationTimeUs += size * 1000000LL / (mNumChannels * sizeof(int16_t)) /
+                                   mSampleRate;
+        flags = 0;
+        consumed = false;
+    }
+
+    mEncodeStartNs[presentationTimeUs] = mStats->getCurTime();
+    media_status_t status =
+            AMediaCodec_queueInputBuffer(mEncoder, inIdx, 0 /* offset */, size,
+                                         presentationTimeUs, flags);
+    if (status != AMEDIA_OK) return status;
+
+    if (consumed) {
+        AMediaCodec_releaseOutputBuffer(mDecoder, mDecoderOutputIndex, false);
+        mDecoderOutputIndex = -1;
+    }
+    return AMEDIA_OK;
+}
+
+int32_t Pipeline::drainEncoder() {
+    AMediaCodecBufferInfo info;
+    ssize_t outIdx = AMediaCodec_dequeueOutputBuffer(mEncoder, &info, kQueueDequeueTimeoutUs);
+    if (outIdx == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
+        AMediaFormat *format = AMediaCodec_getOutputFormat(mEncoder);
+        /*
+         * AMediaMuxer_addTrack returns the index of the new track or a negative value
+         * in case of failure, which can be interpreted as a media_status_t.
+         */
+        mMuxerTrack = AMediaMuxer_addTrack(mMuxer, format);
+        AMediaFormat_delete(format);
+        if (mMuxerTrack < 0) {
+            ALOGE("Format not supported by the muxer");
+            return mMuxerTrack;
+        }
+        return AMediaMuxer_start(mMuxer);
+    }
+    if (outIdx < 0) return AMEDIA_OK;
+
+    size_t bufSize;
+    uint8_t *buf = AMediaCodec_getOutputBuffer(mEncoder, outIdx, &bufSize);
+    if (!buf) return AMEDIA_ERROR_IO;
+
+    media_status_t status = AMEDIA_OK;
+    // Codec config is already part of the format given to the muxer
+    if (info.size && !(info.flags & AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG)) {
+        nsecs_t sTime = mStats->getCurTime();
+        auto it = mEncodeStartNs.find(info.presentationTimeUs);
+        if (it != mEncodeStartNs.end()) {
+            mStats->addStageLatency(kStageEncode, mStats->getTimeDiff(it->second, sTime));
+            mEncodeStartNs.erase(it);
+        }
+        if (mMuxerTrack < 0) {
+            ALOGE("Encoder output received before its format");
+            status = AMEDIA_ERROR_INVALID_OPERATION;
+        } else {
+            status = AMediaMuxer_writeSampleData(mMuxer, mMuxerTrack, buf, &info);
+            mStats->addStageLatency(kStageMux, mStats->getTimeDiff(sTime, mStats->getCurTime()));
+            mStats->addOutputTime();
+            mStats->addFrameSize(info.size);
+        }
+    }
+    AMediaCodec_releaseOutputBuffer(mEncoder, outIdx, false);
+
+    if (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) {
+        ALOGV("Encoder output EOS");
+        mSawEncoderEOS = true;
+    }
+    return status;
+}
+
+int32_t Pipeline::process() {
+    ALOGV("In %s", __func__);
+    if (!mDecoder || !mMuxer) return AMEDIA_ERROR_INVALID_OBJECT;
+
+    nsecs_t cpuStartNs = getThreadCpuTimeNs();
+    mStats->setStartTime();
+    int32_t status = AMEDIA_OK;
+    while (!mSawEncoderEOS && status == AMEDIA_OK) {
+        if (!mSawInputEOS) status = feedDecoder();
+        if (status == AMEDIA_OK && mDecoderOutputIndex < 0 && !mSawDecoderEOS) {
+            status = drainDecoder();
+        }
+        if (status == AMEDIA_OK && mDecoderOutputIndex >= 0) status = feedEncoder();
+        if (status == AMEDIA_OK && mEncoder) status = drainEncoder();
+    }
+    if (status != AMEDIA_OK) {
+        ALOGE("Pipeline failed with error %d", status);
+        return status;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    mStats->setResourceUsage(getThreadCpuTimeNs() - cpuStartNs, usage.ru_maxrss);
+    return AMEDIA_OK;
+}
+
+void Pipeline::deInitPipeline() {
+    ALOGV("In %s", __func__);
+    int64_t sTime = mStats->getCurTime();
+    if (mDecoder) {
+        AMediaCodec_stop(mDecoder);
+        AMediaCodec_delete(mDecoder);
+        mDecoder = nullptr;
+    }
+    if (mEncoder) {
+        AMediaCodec_stop(mEncoder);
+        AMediaCodec_delete(mEncoder);
+        mEncoder = nullptr;
+    }
+    if (mMuxer) {
+        if (mMuxerTrack >= 0) AMediaMuxer_stop(mMuxer);
+        AMediaMuxer_delete(mMuxer);
+        mMuxer = nullptr;
+    }
+    int64_t eTime = mStats->getCurTime();
+    mStats->setDeInitTime(mStats->getTimeDiff(sTime, eTime));
+
+    if (mInputFormat) {
+        AMediaFormat_delete(mInputFormat);
+        mInputFormat = nullptr;
+    }
+}
+
+void Pipeline::resetPipeline() {
+    if (mStats) mStats->reset();
+    mDecodeStartNs.clear();
+    mEncodeStartNs.clear();
+    mMuxerTrack = -1;
+    mDecoderOutputIndex = -1;
+    mSawInputEOS = false;
+    mSawDecoderEOS = false;
+    mSawEncoderEOS = false;
+}
+
+void Pipeline::dumpStatistics(string inputReference, int32_t concurrency, string statsFile) {
+    string componentName = (mParams.decoderName.empty() ? mMime : mParams.decoderName) + " -> " +
+                           (mParams.encoderName.empty() ? mParams.encoderMime
+                                                        : mParams.encoderName);
+    mStats->dumpPipelineStatistics(inputReference, mExtractor->getClipDuration(), componentName,
+                                   concurrency, statsFile);
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include <map>
+
+#include <media/NdkMediaMuxer.h>
+
+#include "BenchmarkCommon.h"
+#include "Extractor.h"
+#include "Muxer.h"
+#include "Stats.h"
+
+// Names of the stages whose latency is recorded in Stats
+constexpr char kStageExtract[] = "extract";
+constexpr char kStageDecode[] = "decode";
+constexpr char kStageConvert[] = "convert";
+constexpr char kStageEncode[] = "encode";
+constexpr char kStageMux[] = "mux";
+
+struct pipelineParameter {
+    string decoderName = "";
+    string encoderName = "";
+    // Mime of the encoded output, defaults to the mime of the input track
+    string encoderMime = "";
+    int32_t bitrate = -1;
+    int32_t frameRate = -1;
+    int32_t iFrameInterval = 1;
+    // Repack decoded video frames to tightly packed I420 before encoding them
+    bool colorConvert = false;
+    MUXER_OUTPUT_T outputFormat = MUXER_OUTPUT_FORMAT_MPEG_4;
+};
+
+/**
+ * Transcodes one track of a clip by chaining extractor -> decoder -> (optional) color conversion
+ * -> encoder -> muxer in a single thread, the way an application transcoding a file does.
+ * Several Pipeline instances can run at once, each on its own thread, to measure how the
+ * components behave under concurrency.
+ *
+ * Stats records the latency of every stage per frame, the muxed frames and bytes, and the thread
+ * CPU time and peak RSS of the run. Codec work done in the codec process is not part of the
+ * CPU time.
+ */
+class Pipeline {
+  public:
+    Pipeline()
+        : mDecoder(nullptr),
+          mEncoder(nullptr),
+          mMuxer(nullptr),
+          mInputFormat(nullptr),
+          mMuxerTrack(-1),
+          mDecoderOutputIndex(-1),
+          mIsVideo(false),
+          mWidth(0),
+          mHeight(0),
+          mStride(0),
+          mSliceHeight(0),
+          mColorFormat(0),
+          mSampleRate(0),
+          mNumChannels(0),
+          mSawInputEOS(false),
+          mSawDecoderEOS(false),
+          mSawEncoderEOS(false) {
+        mExtractor = new Extractor();
+        mStats = new Stats();
+    }
+
+    virtual ~Pipeline() {
+        if (mExtractor) delete mExtractor;
+        if (mStats) delete mStats;
+    }
+
+    Stats *getStats() { return mStats; }
+    Extractor *getExtractor() { return mExtractor; }
+
+    /**
+     * Creates and starts the decoder and the muxer for the track set up in the extractor.
+     * The encoder is created once the decoder reports its output format.
+     *
+     * \param outFd  file descriptor the muxer writes to.
+     * \param params codecs and encoding parameters of the pipeline.
+     */
+    int32_t setupPipeline(int32_t outFd, pipelineParameter params);
+
+    /** Runs the pipeline until the muxer received the end of stream. */
+    int32_t process();
+
+    void deInitPipeline();
+
+    void resetPipeline();
+
+    void dumpStatistics(string inputReference, int32_t concurrency, string statsFile = "");
+
+  private:
+    // Queues the next extracted sample, or the end of stream, to the decoder.
+    int32_t feedDecoder();
+
+    // Dequeues the next decoded frame and keeps it until the encoder takes it.
+    int32_t drainDecoder();
+
+    // Copies the held decoded frame to the encoder, converting it if configured to.
+    int32_t feedEncoder();
+
+    // Writes encoded frames to the muxer.
+    int32_t drainEncoder();
+
+    int32_t setupEncoder();
+
+    // Reads the layout of the decoded frames from the decoder's output format.
+    void updateFrameLayout(AMediaFormat *format);
+
+    // Repacks a decoded planar or semi-planar YUV 4:2:0 frame to tightly packed I420.
+    size_t convertFrame(const uint8_t *src, uint8_t *dst, size_t dstSize);
+
+    Extractor *mExtractor;
+    AMediaCodec *mDecoder;
+    AMediaCodec *mEncoder;
+    AMediaMuxer *mMuxer;
+    AMediaFormat *mInputFormat;
+    string mMime;
+    ssize_t mMuxerTrack;
+    pipelineParameter mParams;
+
+    // Decoded frame waiting for an encoder input buffer
+    ssize_t mDecoderOutputIndex;
+    AMediaCodecBufferInfo mDecoderOutputInfo;
+
+    // Layout of the decoded frames
+    bool mIsVideo;
+    int32_t mWidth;
+    int32_t mHeight;
+    int32_t mStride;
+    int32_t mSliceHeight;
+    int32_t mColorFormat;
+    int32_t mSampleRate;
+    int32_t mNumChannels;
+
+    bool mSawInputEOS;
+    bool mSawDecoderEOS;
+    bool mSawEncoderEOS;
+
+    // Time each frame entered a codec, by presentation time
+    map<int64_t, nsecs_t> mDecodeStartNs;
+    map<int64_t, nsecs_t> mEncodeStartNs;
+
+    Stats *mStats;
+};
+
+#endif  // __PIPELINE_H__
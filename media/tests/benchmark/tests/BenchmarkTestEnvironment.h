@@ -42,6 +42,8 @@ class BenchmarkTestEnvironment : public ::testing::Environment {
 
     bool writeStatsHeader();
 
+    bool writePipelineStatsHeader();
+
   private:
     string res;
     string statsFile;
@@ -101,4 +103,28 @@ bool BenchmarkTestEnvironment::writeStatsHeader() {
     return true;
 }
 
+/**
+ * Writes the header of the stats of the pipeline benchmark to a file
+ * <p>
+ * The stats of every stage of the pipeline are appended to each row, starting with the name of
+ * the stage.
+ **/
+bool BenchmarkTestEnvironment::writePipelineStatsHeader() {
+    char statsHeader[] =
+        "currentTime, fileName, operation, componentName, NDK/SDK, concurrency, setupTime, "
+        "destroyTime, numFrames, framesPerSec, timeToProcess1SecContent, "
+        "totalBytesProcessedPerSec, cpuTime, peakRssKb, totalTime, "
+        "[stage, p50Latency, p90Latency, p99Latency, maxLatency]...\n";
+    FILE *fpStats = fopen(statsFile.c_str(), "w");
+    if(!fpStats) {
+        return false;
+    }
+    int32_t numBytes = fwrite(statsHeader, sizeof(char), sizeof(statsHeader), fpStats);
+    fclose(fpStats);
+    if(numBytes != sizeof(statsHeader)) {
+        return false;
+    }
+    return true;
+}
+
 #endif  // __BENCHMARK_TEST_ENVIRONMENT_H__
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "pipelineTest"
+
+#include <thread>
+#include <vector>
+
+#include "BenchmarkTestEnvironment.h"
+#include "Pipeline.h"
+
+#define OUTPUT_FILE_PREFIX "/data/local/tmp/pipeline"
+
+static BenchmarkTestEnvironment *gEnv = nullptr;
+
+class PipelineTest
+    : public ::testing::TestWithParam<
+              tuple</*InputFile*/ string, /*EncoderMime*/ string, /*ColorConvert*/ bool,
+                    /*Concurrency*/ int32_t>> {};
+
+TEST_P(PipelineTest, Transcode) {
+    ALOGV("Transcode the first track of the input through the whole pipeline");
+    string inputReference = get<0>(GetParam());
+    string inputFile = gEnv->getRes() + inputReference;
+    int32_t concurrency = get<3>(GetParam());
+
+    pipelineParameter params;
+    params.encoderMime = get<1>(GetParam());
+    params.colorConvert = get<2>(GetParam());
+
+    vector<Pipeline *> pipelines;
+    vector<FILE *> inputFps;
+    vector<FILE *> outputFps;
+    for (int32_t i = 0; i < concurrency; i++) {
+        FILE *inputFp = fopen(inputFile.c_str(), "rb");
+        ASSERT_NE(inputFp, nullptr) << "Unable to open " << inputFile << " file for reading";
+        inputFps.push_back(inputFp);
+
+        Pipeline *pipeline = new Pipeline();
+        ASSERT_NE(pipeline, nullptr) << "Pipeline creation failed";
+        pipelines.push_back(pipeline);
+
+        Extractor *extractor = pipeline->getExtractor();
+        ASSERT_NE(extractor, nullptr) << "Extractor creation failed";
+
+        // Read file properties
+        struct stat buf;
+        stat(inputFile.c_str(), &buf);
+        size_t fileSize = buf.st_size;
+
+        int32_t trackCount = extractor->initExtractor(fileno(inputFp), fileSize);
+        ASSERT_GT(trackCount, 0) << "initExtractor failed";
+
+        int32_t status = extractor->setupTrackFormat(0);
+        ASSERT_EQ(status, 0) << "Track Format invalid";
+
+        string outputFileName = OUTPUT_FILE_PREFIX + to_string(i) + ".out";
+        FILE *outputFp = fopen(outputFileName.c_str(), "w+b");
+        ASSERT_NE(outputFp, nullptr)
+                << "Unable to open output file" << outputFileName << " for writing";
+        outputFps.push_back(outputFp);
+
+        status = pipeline->setupPipeline(fileno(outputFp), params);
+        ASSERT_EQ(status, AMEDIA_OK) << "setupPipeline failed";
+    }
+
+    // Every pipeline runs on its own thread, all of them at once
+    vector<int32_t> results(concurrency, AMEDIA_OK);
+    vector<thread> threads;
+    for (int32_t i = 0; i < concurrency; i++) {
+        threads.emplace_back([&pipelines, &results, i]() { results[i] = pipelines[i]->process(); });
+    }
+    for (thread &t : threads) t.join();
+
+    for (int32_t i = 0; i < concurrency; i++) {
+        ASSERT_EQ(results[i], AMEDIA_OK) << "Pipeline " << i << " failed";
+        pipelines[i]->deInitPipeline();
+        pipelines[i]->dumpStatistics(inputReference, concurrency, gEnv->getStatsFile());
+        pipelines[i]->resetPipeline();
+        pipelines[i]->getExtractor()->deInitExtractor();
+        delete pipelines[i];
+        fclose(inputFps[i]);
+        fclose(outputFps[i]);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        AudioPipelineTest, PipelineTest,
+        ::testing::Values(make_tuple("bbb_44100hz_2ch_128kbps_aac_30sec.mp4", "", false, 1),
+                          make_tuple("bbb_44100hz_2ch_128kbps_aac_30sec.mp4", "", false, 4),
+                          make_tuple("bbb_16000hz_1ch_9kbps_amrwb_30sec.3gp", "audio/mp4a-latm",
+                                     false, 1)));
+
+INSTANTIATE_TEST_SUITE_P(
+        VideoPipelineTest, PipelineTest,
+        ::testing::Values(make_tuple("crowd_1920x1080_25fps_6700kbps_h264.ts", "", false, 1),
+                          make_tuple("crowd_1920x1080_25fps_6700kbps_h264.ts", "", true, 1),
+                          make_tuple("crowd_1920x1080_25fps_6700kbps_h264.ts", "", false, 2),
+                          make_tuple("crowd_1920x1080_25fps_4000kbps_h265.mkv", "video/avc",
+                                     false, 1),
+                          make_tuple("crowd_1920x1080_25fps_4000kbps_h265.mkv", "video/avc",
+                                     true, 2)));
+
+int main(int argc, char **argv) {
+    gEnv = new BenchmarkTestEnvironment();
+    ::testing::AddGlobalTestEnvironment(gEnv);
+    ::testing::InitGoogleTest(&argc, argv);
+    int status = gEnv->initFromOptions(argc, argv);
+    if (status == 0) {
+        gEnv->setStatsFile("Pipeline.csv");
+        status = gEnv->writePipelineStatsHeader();
+        ALOGV("Stats file = %d\n", status);
+        status = RUN_ALL_TESTS();
+        ALOGV("Pipeline Test result = %d\n", status);
+    }
+    return status;
+}
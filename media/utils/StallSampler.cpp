@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "StallSampler"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
+#include <cutils/properties.h>
+#include <mediautils/MediaUtilsDelayed.h>
+#include <mediautils/StallSampler.h>
+#include <utils/Log.h>
+
+namespace android::mediautils {
+
+extern std::string formatTime(std::chrono::system_clock::time_point t);
+
+/* static */
+size_t StallSampler::getSampleCount() {
+    static const size_t sampleCount = std::min(kMaxSamples,
+            (size_t)std::max(property_get_int32("media.timecheck.stall_samples", 0), 0));
+    return sampleCount;
+}
+
+/* static */
+std::string StallSampler::getStallFilePath() {
+    static const std::string path = [] {
+        char dir[PROPERTY_VALUE_MAX];
+        property_get("media.timecheck.stall_dir", dir,
+                (std::string("/data/misc/") + getprogname()).c_str());
+        return std::string(dir).append("/stall_samples.txt");
+    }();
+    return path;
+}
+
+StallSampler::StallSampler(std::string_view tag, pid_t tid,
+        std::chrono::system_clock::time_point startSystemTime)
+    : mTag(tag)
+    , mTid(tid)
+    , mStartSystemTime(startSystemTime)
+    , mStartSteadyTime(std::chrono::steady_clock::now())
+    , mThreadSnapshot(tid) {}
+
+void StallSampler::sample() {
+    // Unwinding signals the thread, do it outside of the lock.
+    Sample sample{std::chrono::steady_clock::now(), getCallStackStringForTid(mTid)};
+    mThreadSnapshot.onBegin();  // only the first call has an effect.
+    std::lock_guard lg(mLock);
+    mSamples.push_back(std::move(sample));
+}
+
+size_t StallSampler::getSamplesTaken() const {
+    std::lock_guard lg(mLock);
+    return mSamples.size();
+}
+
+std::string StallSampler::toString(bool timeout, float elapsedMs) const {
+    std::string s("--- ");
+    s.append(mTag.asStringView())
+            .append(timeout ? " timeout" : " near miss")
+            .append(" elapsed ms ").append(std::to_string(elapsedMs))
+            .append(" scheduled ").append(formatTime(mStartSystemTime))
+            .append(" on thread ").append(std::to_string(mTid)).append("\n");
+    {
+        std::lock_guard lg(mLock);
+        const std::string* previousStack = nullptr;
+        for (const auto& sample : mSamples) {
+            const auto sampleMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    sample.time - mStartSteadyTime).count();
+            s.append("+").append(std::to_string(sampleMs)).append(" ms");
+            // A stalled thread mostly stays in the same place, elide repeated stacks.
+            if (previousStack != nullptr && *previousStack == sample.stack) {
+                s.append(" same stack\n");
+                continue;
+            }
+            s.append("\n").append(sample.stack);
+            previousStack = &sample.stack;
+        }
+    }
+    s.append(mThreadSnapshot.toString());
+    return s;
+}
+
+void StallSampler::persist(bool timeout, float elapsedMs) const {
+    const std::string path = getStallFilePath();
+    const std::string record = toString(timeout, elapsedMs);
+
+    // Keep at most two generations of samples.
+    struct stat fileStat;
+    if (stat(path.c_str(), &fileStat) == 0 && (size_t)fileStat.st_size >= kMaxFileBytes) {
+        const std::string oldPath = path + ".old";
+        rename(path.c_str(), oldPath.c_str());
+    }
+
+    FILE* file = fopen(path.c_str(), "ae");
+    if (file == nullptr) {
+        ALOGW("%s: cannot open %s: %s", __func__, path.c_str(), strerror(errno));
+        return;
+    }
+    if (fwrite(record.data(), 1, record.size(), file) != record.size()) {
+        ALOGW("%s: cannot write %s: %s", __func__, path.c_str(), strerror(errno));
+    }
+    fclose(file);
+    ALOGI("%s: %s stalled for %f ms, samples in %s",
+            __func__, mTag.c_str(), elapsedMs, path.c_str());
+}
+
+} // android::mediautils
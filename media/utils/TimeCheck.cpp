@@ -133,6 +133,13 @@ TimerThread& TimeCheck::getTimeCheckThread() {
     return sTimeCheckThread;
 }
 
+/* static */
+TimerThread& TimeCheck::getStallSamplerThread() {
+    // Separate from the TimeCheck thread, so the samples do not show in its timeouts.
+    static TimerThread sStallSamplerThread{};
+    return sStallSamplerThread;
+}
+
 
 static bool sSystemReady = false;
 
@@ -140,6 +147,18 @@ void TimeCheck::setSystemReady() {
     sSystemReady = true;
 }
 
+/* static */
+std::shared_ptr<StallSampler> TimeCheck::makeStallSampler(std::string_view tag,
+        Duration timeoutDuration, bool crashOnTimeout,
+        std::chrono::system_clock::time_point startSystemTime) {
+    // Only watchdogs are sampled, statistics-only TimeChecks never time out.
+    if (!crashOnTimeout || timeoutDuration.count() == 0 || !sSystemReady
+            || StallSampler::getSampleCount() == 0) {
+        return {};
+    }
+    return std::make_shared<StallSampler>(tag, gettid(), startSystemTime);
+}
+
 /* static */
 std::string TimeCheck::toString() {
     // note pending and retired are individually locked for maximum concurrency,
@@ -152,7 +171,9 @@ TimeCheck::TimeCheck(std::string_view tag, OnTimerFunc&& onTimer, Duration reque
         Duration secondChanceDuration, bool crashOnTimeout)
     : mTimeCheckHandler{ std::make_shared<TimeCheckHandler>(
             tag, std::move(onTimer), crashOnTimeout, requestedTimeoutDuration,
-            secondChanceDuration, std::chrono::system_clock::now(), gettid()) }
+            secondChanceDuration, std::chrono::system_clock::now(), gettid(),
+            makeStallSampler(tag, requestedTimeoutDuration, crashOnTimeout,
+                    std::chrono::system_clock::now())) }
     , mTimerHandle((requestedTimeoutDuration.count() == 0 || !sSystemReady)
               /* for TimeCheck we don't consider a non-zero secondChanceDuration here */
               ? getTimeCheckThread().trackTask(mTimeCheckHandler->tag)
@@ -165,10 +186,28 @@ TimeCheck::TimeCheck(std::string_view tag, OnTimerFunc&& onTimer, Duration reque
                           timeCheckHandler->onTimeout(timerHandle);
                       },
                       requestedTimeoutDuration,
-                      secondChanceDuration)) {}
+                      secondChanceDuration)) {
+    if (const auto& stallSampler = mTimeCheckHandler->stallSampler) {
+        // Spread the samples over the second half of the total timeout,
+        // the last one is half a sample interval before the deadline.
+        const int64_t sampleCount = StallSampler::getSampleCount();
+        const Duration totalDuration = requestedTimeoutDuration + secondChanceDuration;
+        mSampleHandles.reserve(sampleCount);
+        for (int64_t i = 0; i < sampleCount; ++i) {
+            mSampleHandles.push_back(getStallSamplerThread().scheduleTask(
+                    mTimeCheckHandler->tag,
+                    [stallSampler](TimerThread::Handle) { stallSampler->sample(); },
+                    totalDuration * (2 * (sampleCount + i) + 1) / (4 * sampleCount),
+                    {} /* secondChanceDuration */));
+        }
+    }
+}
 
 TimeCheck::~TimeCheck() {
     if (mTimeCheckHandler) {
+        for (const auto handle : mSampleHandles) {
+            getStallSamplerThread().cancelTask(handle);
+        }
         mTimeCheckHandler->onCancel(mTimerHandle);
     }
 }
@@ -216,13 +255,19 @@ std::string TimeCheck::analyzeTimeouts(
 // (expiration = clock steady start + timeout) is passed into the callback.
 void TimeCheck::TimeCheckHandler::onCancel(TimerThread::Handle timerHandle) const
 {
-    if (TimeCheck::getTimeCheckThread().cancelTask(timerHandle) && onTimer) {
+    if (TimeCheck::getTimeCheckThread().cancelTask(timerHandle) && (onTimer || stallSampler)) {
         const std::chrono::steady_clock::time_point endSteadyTime =
                 std::chrono::steady_clock::now();
         const float elapsedSteadyMs = std::chrono::duration_cast<FloatMs>(
                 endSteadyTime - timerHandle + timeoutDuration).count();
         // send the elapsed steady time for statistics.
-        onTimer(false /* timeout */, elapsedSteadyMs);
+        if (onTimer) {
+            onTimer(false /* timeout */, elapsedSteadyMs);
+        }
+        // Samples are only taken past half the timeout, keep them as a near miss.
+        if (stallSampler && stallSampler->getSamplesTaken() > 0) {
+            stallSampler->persist(false /* timeout */, elapsedSteadyMs);
+        }
     }
 }
 
@@ -252,6 +297,11 @@ void TimeCheck::TimeCheckHandler::onTimeout(TimerThread::Handle timerHandle) con
     // HAL processes which can affect thread behavior.
     const std::string summary = getTimeCheckThread().toString(4 /* retiredCount */);
 
+    // Likewise persist the stack samples while the HAL processes are undisturbed.
+    if (stallSampler) {
+        stallSampler->persist(true /* timeout */, elapsedSteadyMs);
+    }
+
     // Generate audio HAL processes tombstones and allow time to complete
     // before forcing restart
     std::vector<pid_t> pids = TimeCheck::getAudioHalPids();
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <mediautils/TimerThread.h>
+
+using namespace std::chrono_literals;
+using namespace android::mediautils;
+
+namespace {
+
+// Shared by all benchmark threads, as TimeCheck shares one TimerThread per process.
+TimerThread& getTimerThread() {
+    static TimerThread thread;
+    return thread;
+}
+
+// Schedules and cancels a task, the way TimeCheck wraps a binder call.
+void BM_ScheduleCancel(benchmark::State& state) {
+    TimerThread& thread = getTimerThread();
+    for (auto _ : state) {
+        const auto handle = thread.scheduleTask("BM_ScheduleCancel",
+                [](TimerThread::Handle handle __unused) {}, 10s /* timeout */,
+                1s /* secondChance */);
+        benchmark::DoNotOptimize(thread.cancelTask(handle));
+    }
+}
+
+// Same as BM_ScheduleCancel, with other tasks pending in the queue.
+void BM_ScheduleCancelWithPending(benchmark::State& state) {
+    TimerThread& thread = getTimerThread();
+    std::vector<TimerThread::Handle> pending;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        pending.push_back(thread.scheduleTask("pending",
+                [](TimerThread::Handle handle __unused) {}, 20s /* timeout */,
+                1s /* secondChance */));
+    }
+    for (auto _ : state) {
+        const auto handle = thread.scheduleTask("BM_ScheduleCancelWithPending",
+                [](TimerThread::Handle handle __unused) {}, 10s /* timeout */,
+                1s /* secondChance */);
+        benchmark::DoNotOptimize(thread.cancelTask(handle));
+    }
+    for (const auto handle : pending) {
+        thread.cancelTask(handle);
+    }
+}
+
+// Tracks and cancels a task without a timeout.
+void BM_TrackCancel(benchmark::State& state) {
+    TimerThread& thread = getTimerThread();
+    for (auto _ : state) {
+        const auto handle = thread.trackTask("BM_TrackCancel");
+        benchmark::DoNotOptimize(thread.cancelTask(handle));
+    }
+}
+
+BENCHMARK(BM_ScheduleCancel)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_ScheduleCancelWithPending)->Arg(16)->Arg(256)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_TrackCancel)->ThreadRange(1, 16)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -16,6 +16,7 @@
 
 #include <chrono>
 #include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include <mediautils/TimerThread.h>
 
@@ -209,6 +210,39 @@ INSTANTIATE_TEST_CASE_P(
         ::testing::Values(0.f, 0.5f, 1.f)
         );
 
+// Tasks scheduled from different threads are spread over the monitor shards,
+// they must still be cancellable from any thread.
+TEST(TimerThread, TasksFromMultipleThreads) {
+    constexpr size_t kThreads = 2 * TimerThread::MONITOR_SHARDS;
+    TimerThread thread;
+
+    std::array<TimerThread::Handle, kThreads> handles{};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&thread, &handles, i] {
+            handles[i] = thread.scheduleTask(std::to_string(i),
+                    [](TimerThread::Handle handle __unused) {}, 10s, 1s);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    for (const auto handle : handles) {
+        ASSERT_TRUE(TimerThread::isTimeoutHandle(handle));
+    }
+
+    // all tasks pending
+    ASSERT_EQ(kThreads, countChars(thread.pendingToString(), REQUEST_START));
+
+    for (const auto handle : handles) {
+        ASSERT_TRUE(thread.cancelTask(handle));
+        // handle is stale, cancel returns false.
+        ASSERT_FALSE(thread.cancelTask(handle));
+    }
+
+    // 0 tasks pending
+    ASSERT_EQ(0, countChars(thread.pendingToString(), REQUEST_START));
+}
+
 TEST(TimerThread, TrackedTasks) {
     TimerThread thread;
 
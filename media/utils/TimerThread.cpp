@@ -37,10 +37,12 @@ TimerThread::Handle TimerThread::scheduleTask(
         std::string_view tag, TimerCallback&& func,
         Duration timeoutDuration, Duration secondChanceDuration) {
     const auto now = std::chrono::system_clock::now();
+    const pid_t tid = gettid();
     auto request = std::make_shared<const Request>(now, now +
             std::chrono::duration_cast<std::chrono::system_clock::duration>(timeoutDuration),
-            secondChanceDuration, gettid(), tag);
-    return mMonitorThread.add(std::move(request), std::move(func), timeoutDuration);
+            secondChanceDuration, tid, tag);
+    return mMonitorThreads[tid & MONITOR_SHARD_MASK].add(
+            std::move(request), std::move(func), timeoutDuration);
 }
 
 TimerThread::Handle TimerThread::trackTask(std::string_view tag) {
@@ -52,7 +54,8 @@ TimerThread::Handle TimerThread::trackTask(std::string_view tag) {
 
 bool TimerThread::cancelTask(Handle handle) {
     std::shared_ptr<const Request> request = isNoTimeoutHandle(handle) ?
-             mNoTimeoutMap.remove(handle) : mMonitorThread.remove(handle);
+             mNoTimeoutMap.remove(handle) :
+             mMonitorThreads[getMonitorShard(handle)].remove(handle);
     if (!request) return false;
     mRetiredQueue.add(std::move(request));
     return true;
@@ -90,7 +93,7 @@ std::string TimerThread::toString(size_t retiredCount) const {
     return std::string("now ")
             .append(formatTime(std::chrono::system_clock::now()))
             .append("\nsecondChanceCount ")
-            .append(std::to_string(mMonitorThread.getSecondChanceCount()))
+            .append(std::to_string(getSecondChanceCount()))
             .append(analysisSummary)
             .append("\ntimeout [ ")
             .append(requestsToString(timeoutRequests))
@@ -188,7 +191,9 @@ std::vector<std::shared_ptr<const TimerThread::Request>> TimerThread::getPending
     pendingRequests.reserve(kEstimatedPendingRequests); // preallocate vector out of lock.
 
     // following are internally locked calls, which add to our local pendingRequests.
-    mMonitorThread.copyRequests(pendingRequests);
+    for (const auto& monitorThread : mMonitorThreads) {
+        monitorThread.copyRequests(pendingRequests);
+    }
     mNoTimeoutMap.copyRequests(pendingRequests);
 
     // Sort in order of scheduled time.
@@ -200,6 +205,14 @@ std::vector<std::shared_ptr<const TimerThread::Request>> TimerThread::getPending
     return pendingRequests;
 }
 
+size_t TimerThread::getSecondChanceCount() const {
+    size_t count = 0;
+    for (const auto& monitorThread : mMonitorThreads) {
+        count += monitorThread.getSecondChanceCount();
+    }
+    return count;
+}
+
 std::string TimerThread::pendingToString() const {
     return requestsToString(getPendingRequests());
 }
@@ -274,8 +287,9 @@ void TimerThread::NoTimeoutMap::copyRequests(
     }
 }
 
-TimerThread::MonitorThread::MonitorThread(RequestQueue& timeoutQueue)
-        : mTimeoutQueue(timeoutQueue)
+TimerThread::MonitorThread::MonitorThread(RequestQueue& timeoutQueue, size_t shard)
+        : mShard(shard)
+        , mTimeoutQueue(timeoutQueue)
         , mThread([this] { threadFunc(); }) {
      pthread_setname_np(mThread.native_handle(), "TimerThread");
      pthread_setschedprio(mThread.native_handle(), PRIORITY_URGENT_AUDIO);
@@ -376,9 +390,12 @@ TimerThread::Handle TimerThread::MonitorThread::add(
         std::shared_ptr<const Request> request, TimerCallback&& func, Duration timeout) {
     std::lock_guard _l(mMutex);
     const Handle handle = getUniqueHandle_l(timeout);
-    mMonitorRequests.emplace_hint(mMonitorRequests.end(),
+    const auto it = mMonitorRequests.emplace_hint(mMonitorRequests.end(),
             handle, std::make_pair(std::move(request), std::move(func)));
-    mCond.notify_all();
+    // The monitor thread only needs to wake if the earliest deadline changed.
+    if (it == mMonitorRequests.begin()) {
+        mCond.notify_all();
+    }
     return handle;
 }
 
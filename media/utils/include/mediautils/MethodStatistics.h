@@ -16,9 +16,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <sstream>
 #include <string>
+#include <sys/types.h>
 #include <vector>
 
 #include <android-base/thread_annotations.h>
@@ -26,6 +32,68 @@
 
 namespace android::mediautils {
 
+/**
+ * LatencyHistogram counts execution times in bins a factor of 2 apart,
+ * so that percentiles can be estimated at a small constant cost per event.
+ *
+ * Bin 0 holds times below kFirstBinMs, bin i holds times in
+ * [kFirstBinMs * 2^(i-1), kFirstBinMs * 2^i), and the last bin everything above.
+ * Percentiles are interpolated linearly within a bin.
+ */
+class LatencyHistogram {
+public:
+    using FloatType = float;
+    static constexpr size_t kBins = 24;
+    static constexpr FloatType kFirstBinMs = 1.f / 64;  // the last bin starts at 65.5 s.
+
+    void add(FloatType executeMs) {
+        size_t bin = 0;
+        if (executeMs >= kFirstBinMs) {
+            bin = std::min((size_t)std::ilogb(executeMs / kFirstBinMs) + 1, kBins - 1);
+        }
+        ++mCounts[bin];
+        ++mN;
+        mMaxMs = std::max(mMaxMs, executeMs);
+    }
+
+    size_t getN() const { return mN; }
+
+    FloatType getMax() const { return mMaxMs; }
+
+    /**
+     * Returns the estimated execution time below which the fraction p of the events fall.
+     */
+    FloatType getPercentile(FloatType p) const {
+        if (mN == 0) return 0;
+        const FloatType target = std::clamp(p, FloatType(0), FloatType(1)) * mN;
+        size_t below = 0;
+        for (size_t i = 0; i < kBins; ++i) {
+            if (mCounts[i] == 0 || below + mCounts[i] < target) {
+                below += mCounts[i];
+                continue;
+            }
+            const FloatType lower = i == 0 ? 0 : std::ldexp(kFirstBinMs, i - 1);
+            const FloatType upper = i == kBins - 1 ? mMaxMs : std::ldexp(kFirstBinMs, i);
+            const FloatType value =
+                    lower + (upper - lower) * (target - below) / mCounts[i];
+            return std::min(value, mMaxMs);
+        }
+        return mMaxMs;
+    }
+
+    std::string toString() const {
+        std::stringstream ss;
+        ss << "p50=" << getPercentile(0.5f) << " p99=" << getPercentile(0.99f)
+                << " max=" << mMaxMs;
+        return ss.str();
+    }
+
+private:
+    size_t mCounts[kBins]{};
+    size_t mN = 0;
+    FloatType mMaxMs = 0;
+};
+
 /**
  * MethodStatistics is used to associate Binder codes
  * with a method name and execution time statistics.
@@ -35,6 +103,9 @@ namespace android::mediautils {
  *
  * Here, Code is the enumeration type for the method
  * lookup.
+ *
+ * Each method also has a LatencyHistogram, and events may carry the
+ * calling uid to keep a LatencyHistogram per caller, over all methods.
  */
 template <typename Code>
 class MethodStatistics {
@@ -52,20 +123,35 @@ public:
             const std::initializer_list<std::pair<const Code, std::string>>& methodMap = {})
         : mMethodMap{methodMap} {}
 
+    // The uids beyond the first kMaxUids are counted together as kOtherUid.
+    static constexpr size_t kMaxUids = 32;
+    static constexpr uid_t kOtherUid = (uid_t)-1;
+
+    // Suggested period for getPeriodicSummary().
+    static constexpr std::chrono::minutes kSummaryPeriod{30};
+
     /**
      * Adds a method event, typically execution time in ms.
      */
     template <typename C>
     void event(C&& code, FloatType executeMs) {
         std::lock_guard lg(mLock);
-        auto it = mStatisticsMap.lower_bound(code);
-        if (it != mStatisticsMap.end() && it->first == code) {
-            it->second.add(executeMs);
-        } else {
-            // StatsType ctor takes an optional array of data for initialization.
-            FloatType dataArray[1] = { executeMs };
-            mStatisticsMap.emplace_hint(it, std::forward<C>(code), dataArray);
+        event_l(std::forward<C>(code), executeMs);
+    }
+
+    /**
+     * Adds a method event for the calling uid.
+     */
+    template <typename C>
+    void event(C&& code, FloatType executeMs, uid_t uid) {
+        std::lock_guard lg(mLock);
+        event_l(std::forward<C>(code), executeMs);
+        auto it = mUidHistogramMap.find(uid);
+        if (it == mUidHistogramMap.end()) {
+            if (mUidHistogramMap.size() >= kMaxUids) uid = kOtherUid;
+            it = mUidHistogramMap.try_emplace(uid).first;
         }
+        it->second.add(executeMs);
     }
 
     /**
@@ -82,7 +168,7 @@ public:
     size_t getMethodCount(const Code& code) const {
         std::lock_guard lg(mLock);
         auto it = mStatisticsMap.find(code);
-        return it == mStatisticsMap.end() ? 0 : it->second.getN();
+        return it == mStatisticsMap.end() ? 0 : it->second.stats.getN();
     }
 
     /**
@@ -91,7 +177,50 @@ public:
     StatsType getStatistics(const Code& code) const {
         std::lock_guard lg(mLock);
         auto it = mStatisticsMap.find(code);
-        return it == mStatisticsMap.end() ? StatsType{} : it->second;
+        return it == mStatisticsMap.end() ? StatsType{} : it->second.stats;
+    }
+
+    /**
+     * Returns the latency histogram for the method.
+     */
+    LatencyHistogram getHistogram(const Code& code) const {
+        std::lock_guard lg(mLock);
+        auto it = mStatisticsMap.find(code);
+        return it == mStatisticsMap.end() ? LatencyHistogram{} : it->second.histogram;
+    }
+
+    /**
+     * Returns the latency histogram of the calling uid, over all methods.
+     */
+    LatencyHistogram getUidHistogram(uid_t uid) const {
+        std::lock_guard lg(mLock);
+        auto it = mUidHistogramMap.find(uid);
+        return it == mUidHistogramMap.end() ? LatencyHistogram{} : it->second;
+    }
+
+    /**
+     * Returns a compact summary of the method histograms since construction,
+     * "method:n,p50,p99,max;..." with times in ms, once per period and
+     * otherwise an empty string.  Used to deliver the histograms from the event path.
+     */
+    std::string getPeriodicSummary(std::chrono::steady_clock::duration period) {
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard lg(mLock);
+        if (now - mLastSummaryTime < period) return {};
+        mLastSummaryTime = now;
+        std::stringstream ss;
+        for (const auto &[code, entry] : mStatisticsMap) {
+            if constexpr (std::is_same_v<Code, std::string>) {
+                ss << code;
+            } else /* constexpr */ {
+                ss << getMethodForCode(code);
+            }
+            ss << ":" << entry.histogram.getN()
+                    << "," << entry.histogram.getPercentile(0.5f)
+                    << "," << entry.histogram.getPercentile(0.99f)
+                    << "," << entry.histogram.getMax() << ";";
+        }
+        return ss.str();
     }
 
     /**
@@ -101,24 +230,55 @@ public:
         std::stringstream ss;
         std::lock_guard lg(mLock);
         if constexpr (std::is_same_v<Code, std::string>) {
-            for (const auto &[code, stats] : mStatisticsMap) {
+            for (const auto &[code, entry] : mStatisticsMap) {
                 ss << code <<
-                        " n=" << stats.getN() << " " << stats.toString() << "\n";
+                        " n=" << entry.stats.getN() << " " << entry.stats.toString() <<
+                        " " << entry.histogram.toString() << "\n";
             }
         } else /* constexpr */ {
-            for (const auto &[code, stats] : mStatisticsMap) {
+            for (const auto &[code, entry] : mStatisticsMap) {
                 ss << int(code) << " " << getMethodForCode(code) <<
-                        " n=" << stats.getN() << " " << stats.toString() << "\n";
+                        " n=" << entry.stats.getN() << " " << entry.stats.toString() <<
+                        " " << entry.histogram.toString() << "\n";
+            }
+        }
+        if (!mUidHistogramMap.empty()) {
+            ss << "per uid:\n";
+            for (const auto &[uid, histogram] : mUidHistogramMap) {
+                if (uid == kOtherUid) {
+                    ss << "other";
+                } else {
+                    ss << "uid " << uid;
+                }
+                ss << " n=" << histogram.getN() << " " << histogram.toString() << "\n";
             }
         }
         return ss.str();
     }
 
 private:
+    struct Entry {
+        StatsType stats;
+        LatencyHistogram histogram;
+    };
+
+    template <typename C>
+    void event_l(C&& code, FloatType executeMs) REQUIRES(mLock) {
+        auto it = mStatisticsMap.lower_bound(code);
+        if (it == mStatisticsMap.end() || it->first != code) {
+            it = mStatisticsMap.emplace_hint(it, std::forward<C>(code), Entry{});
+        }
+        it->second.stats.add(executeMs);
+        it->second.histogram.add(executeMs);
+    }
+
     // Note: we use a transparent comparator std::less<> for heterogeneous key lookup.
     const std::map<Code, std::string, std::less<>> mMethodMap;
     mutable std::mutex mLock;
-    std::map<Code, StatsType, std::less<>> mStatisticsMap GUARDED_BY(mLock);
+    std::map<Code, Entry, std::less<>> mStatisticsMap GUARDED_BY(mLock);
+    std::map<uid_t, LatencyHistogram> mUidHistogramMap GUARDED_BY(mLock);
+    std::chrono::steady_clock::time_point mLastSummaryTime GUARDED_BY(mLock) =
+            std::chrono::steady_clock::now();
 };
 
 // Managed Statistics support.
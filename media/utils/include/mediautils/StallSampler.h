@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <android-base/thread_annotations.h>
+#include <mediautils/FixedString.h>
+#include <mediautils/ThreadSnapshot.h>
+
+namespace android::mediautils {
+
+/**
+ * Samples the call stack of a thread as it approaches a watchdog deadline,
+ * so that stalls which end just before the deadline (near misses) can be
+ * diagnosed as well as those which end in an abort.
+ *
+ * sample() is called from a timer thread while the monitored thread runs,
+ * persist() appends the samples to the stall file of the process,
+ * getStallFilePath(), which is rotated once it exceeds kMaxFileBytes.
+ *
+ * Sampling is disabled unless the property media.timecheck.stall_samples
+ * is set to the number of samples to take before each deadline.
+ */
+class StallSampler {
+public:
+    static constexpr size_t kMaxSamples = 8;
+    static constexpr size_t kMaxFileBytes = 256 * 1024;
+
+    // Returns the number of samples to take before a deadline, 0 if disabled.
+    static size_t getSampleCount();
+
+    // Returns the file the samples are appended to, by default
+    // /data/misc/<process name>/stall_samples.txt.
+    static std::string getStallFilePath();
+
+    StallSampler(std::string_view tag, pid_t tid,
+            std::chrono::system_clock::time_point startSystemTime);
+
+    // Records the call stack and scheduler state of the thread.
+    void sample();
+
+    // Returns the number of samples taken.
+    size_t getSamplesTaken() const;
+
+    // Appends the samples to the stall file.
+    // \param timeout   true if the deadline expired, false for a near miss.
+    // \param elapsedMs time from the start of monitoring to the end of the stall.
+    void persist(bool timeout, float elapsedMs) const;
+
+    std::string toString(bool timeout, float elapsedMs) const;
+
+private:
+    struct Sample {
+        std::chrono::steady_clock::time_point time;
+        std::string stack;
+    };
+
+    const FixedString62 mTag;
+    const pid_t mTid;
+    const std::chrono::system_clock::time_point mStartSystemTime;
+    const std::chrono::steady_clock::time_point mStartSteadyTime;
+
+    ThreadSnapshot mThreadSnapshot;  // begins at the first sample.
+
+    mutable std::mutex mLock;
+    std::vector<Sample> mSamples GUARDED_BY(mLock);
+};
+
+} // android::mediautils
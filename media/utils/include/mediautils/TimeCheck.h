@@ -17,8 +17,10 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
 #include <vector>
 
+#include <mediautils/StallSampler.h>
 #include <mediautils/TimerThread.h>
 
 namespace android::mediautils {
@@ -82,6 +84,10 @@ class TimeCheck {
      *                  This is used to prevent false timeouts if the steady (monotonic)
      *                  clock advances on aborted suspend.
      * \param crashOnTimeout true if the object issues an abort on timeout.
+     *
+     * If StallSampler::getSampleCount() is not zero, a TimeCheck which crashes on timeout
+     * also samples the stack of its thread during the second half of the total timeout.
+     * The samples are persisted on timeout, or on destruction if any sample was taken.
      */
     explicit TimeCheck(std::string_view tag, OnTimerFunc&& onTimer,
             Duration requestedTimeoutDuration, Duration secondChanceDuration,
@@ -108,7 +114,7 @@ class TimeCheck {
         TimeCheckHandler(S&& _tag, F&& _onTimer, bool _crashOnTimeout,
             Duration _timeoutDuration, Duration _secondChanceDuration,
             std::chrono::system_clock::time_point _startSystemTime,
-            pid_t _tid)
+            pid_t _tid, std::shared_ptr<StallSampler> _stallSampler)
             : tag(std::forward<S>(_tag))
             , onTimer(std::forward<F>(_onTimer))
             , crashOnTimeout(_crashOnTimeout)
@@ -116,6 +122,7 @@ class TimeCheck {
             , secondChanceDuration(_secondChanceDuration)
             , startSystemTime(_startSystemTime)
             , tid(_tid)
+            , stallSampler(std::move(_stallSampler))
             {}
         const FixedString62 tag;
         const OnTimerFunc onTimer;
@@ -124,6 +131,7 @@ class TimeCheck {
         const Duration secondChanceDuration;
         const std::chrono::system_clock::time_point startSystemTime;
         const pid_t tid;
+        const std::shared_ptr<StallSampler> stallSampler;  // null if not sampling.
 
         void onCancel(TimerThread::Handle handle) const;
         void onTimeout(TimerThread::Handle handle) const;
@@ -135,6 +143,10 @@ class TimeCheck {
             float timeoutMs, float elapsedSteadyMs, float elapsedSystemMs);
 
     static TimerThread& getTimeCheckThread();
+    static TimerThread& getStallSamplerThread();
+    static std::shared_ptr<StallSampler> makeStallSampler(std::string_view tag,
+            Duration timeoutDuration, bool crashOnTimeout,
+            std::chrono::system_clock::time_point startSystemTime);
     static void accessAudioHalPids(std::vector<pid_t>* pids, bool update);
 
     // mTimeCheckHandler is immutable, prefer to be first initialized, last destroyed.
@@ -142,6 +154,9 @@ class TimeCheck {
     // is mutually exclusive of the callback, but the price paid for lifetime safety is minimal.
     const std::shared_ptr<const TimeCheckHandler> mTimeCheckHandler;
     const TimerThread::Handle mTimerHandle = TimerThread::INVALID_HANDLE;
+
+    // Sampling tasks on getStallSamplerThread(), empty if not sampling.
+    std::vector<TimerThread::Handle> mSampleHandles;
 };
 
 // Returns a TimeCheck object that sends info to MethodStatistics
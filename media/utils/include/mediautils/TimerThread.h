@@ -54,6 +54,9 @@ class TimerThread {
     // The lsb of the Handle time_point is adjusted to indicate whether there is
     // a timeout action (1) or not (0).
     //
+    // For handles with a timeout action, the bits above the lsb hold the
+    // index of the monitor shard that owns the request.
+    //
 
     template <size_t COUNT>
     static constexpr bool is_power_of_2_v = COUNT > 0 && (COUNT & (COUNT - 1)) == 0;
@@ -73,6 +76,20 @@ class TimerThread {
 
     static constexpr size_t HANDLE_TYPE_MASK = mask_from_count_v<HANDLE_TYPES>;
 
+    // Tasks with a timeout are spread over several monitor threads, chosen by
+    // the tid of the caller, so that concurrent scheduleTask() and cancelTask()
+    // calls from different threads rarely contend for the same lock.
+    static constexpr size_t MONITOR_SHARDS = 4;
+    // MONITOR_SHARDS must be a power of 2.
+    static_assert(is_power_of_2_v<MONITOR_SHARDS>);
+
+    static constexpr size_t MONITOR_SHARD_MASK = mask_from_count_v<MONITOR_SHARDS>;
+
+    static inline size_t getMonitorShard(Handle handle) {
+        return (static_cast<uint64_t>(handle.time_since_epoch().count()) / HANDLE_TYPES)
+                & MONITOR_SHARD_MASK;
+    }
+
     template <typename T>
     static constexpr auto enum_as_value(T x) {
         return static_cast<std::underlying_type_t<T>>(x);
@@ -89,20 +106,22 @@ class TimerThread {
     }
 
     // Returns a unique Handle that doesn't exist in the container.
-    template <size_t MAX_TYPED_HANDLES, size_t HANDLE_TYPE_AS_VALUE, typename C, typename T>
-    static Handle getUniqueHandleForHandleType_l(C container, T timeout) {
-        static_assert(MAX_TYPED_HANDLES > 0 && HANDLE_TYPE_AS_VALUE < MAX_TYPED_HANDLES
-                && is_power_of_2_v<MAX_TYPED_HANDLES>,
+    // The Handle modulo MAX_TYPED_HANDLES is handleTypeAsValue.
+    template <size_t MAX_TYPED_HANDLES, typename C, typename T>
+    static Handle getUniqueHandleForHandleType_l(
+            const C& container, T timeout, size_t handleTypeAsValue) {
+        static_assert(MAX_TYPED_HANDLES > 0 && is_power_of_2_v<MAX_TYPED_HANDLES>,
                 " handles must be power of two");
 
         // Our initial handle is the deadline as computed from steady_clock.
         auto deadline = std::chrono::steady_clock::now() + timeout;
 
         // We adjust the lsbs by the minimum increment to have the correct
-        // HANDLE_TYPE in the least significant bits.
-        auto remainder = deadline.time_since_epoch().count() & HANDLE_TYPE_MASK;
-        size_t offset = HANDLE_TYPE_AS_VALUE > remainder ? HANDLE_TYPE_AS_VALUE - remainder :
-                     MAX_TYPED_HANDLES + HANDLE_TYPE_AS_VALUE - remainder;
+        // HANDLE_TYPE (and shard) in the least significant bits.
+        size_t remainder = deadline.time_since_epoch().count()
+                & mask_from_count_v<MAX_TYPED_HANDLES>;
+        size_t offset = handleTypeAsValue > remainder ? handleTypeAsValue - remainder :
+                     MAX_TYPED_HANDLES + handleTypeAsValue - remainder;
         deadline += std::chrono::steady_clock::duration(offset);
 
         // To avoid key collisions, advance the handle by MAX_TYPED_HANDLES (the modulus factor)
@@ -260,9 +279,8 @@ class TimerThread {
         mutable std::mutex mNTMutex;
         std::map<Handle, std::shared_ptr<const Request>> mMap GUARDED_BY(mNTMutex);
         Handle getUniqueHandle_l() REQUIRES(mNTMutex) {
-            return getUniqueHandleForHandleType_l<
-                    HANDLE_TYPES, enum_as_value(HANDLE_TYPE::NO_TIMEOUT)>(
-                mMap, Duration{} /* timeout */);
+            return getUniqueHandleForHandleType_l<HANDLE_TYPES>(
+                mMap, Duration{} /* timeout */, enum_as_value(HANDLE_TYPE::NO_TIMEOUT));
         }
 
       public:
@@ -277,6 +295,7 @@ class TimerThread {
     // call on timeout.
     // This class is thread-safe.
     class MonitorThread {
+        const size_t mShard;  // index in mMonitorThreads, kept in the Handle.
         std::atomic<size_t> mSecondChanceCount{};
         mutable std::mutex mMutex;
         mutable std::condition_variable mCond GUARDED_BY(mMutex);
@@ -308,13 +327,13 @@ class TimerThread {
 
         void threadFunc();
         Handle getUniqueHandle_l(Duration timeout) REQUIRES(mMutex) {
-            return getUniqueHandleForHandleType_l<
-                    HANDLE_TYPES, enum_as_value(HANDLE_TYPE::TIMEOUT)>(
-                mMonitorRequests, timeout);
+            return getUniqueHandleForHandleType_l<HANDLE_TYPES * MONITOR_SHARDS>(
+                mMonitorRequests, timeout,
+                enum_as_value(HANDLE_TYPE::TIMEOUT) + HANDLE_TYPES * mShard);
         }
 
       public:
-        MonitorThread(RequestQueue &timeoutQueue);
+        MonitorThread(RequestQueue &timeoutQueue, size_t shard);
         ~MonitorThread();
 
         Handle add(std::shared_ptr<const Request> request, TimerCallback&& func,
@@ -358,6 +377,8 @@ class TimerThread {
 
     std::vector<std::shared_ptr<const Request>> getPendingRequests() const;
 
+    size_t getSecondChanceCount() const;
+
     static constexpr size_t kRetiredQueueMax = 16;
     RequestQueue mRetiredQueue{kRetiredQueueMax};  // locked internally
 
@@ -366,9 +387,10 @@ class TimerThread {
 
     NoTimeoutMap mNoTimeoutMap;  // locked internally
 
-    MonitorThread mMonitorThread{mTimeoutQueue};  // This should be initialized last because
-                                                  // the thread is launched immediately.
-                                                  // Locked internally.
+    // These should be initialized last because the threads are launched immediately.
+    // Locked internally.
+    MonitorThread mMonitorThreads[MONITOR_SHARDS]{
+            {mTimeoutQueue, 0}, {mTimeoutQueue, 1}, {mTimeoutQueue, 2}, {mTimeoutQueue, 3}};
 };
 
 }  // namespace android::mediautils
@@ -70,3 +70,37 @@ TEST(methodstatistics_tests, events) {
     ASSERT_EQ(0.f, unsetStats.getMean());
     ASSERT_EQ(0U, methodStatistics.getMethodCount(UNKNOWN_CODE));
 }
+
+TEST(methodstatistics_tests, histograms) {
+    MethodStatistics<CodeType> methodStatistics{
+            {HELLO_CODE, HELLO_NAME},
+            {WORLD_CODE, WORLD_NAME},
+    };
+    constexpr uid_t kUid = 10001;
+
+    // 99 fast calls and a slow one.
+    for (int i = 0; i < 99; ++i) {
+        methodStatistics.event(HELLO_CODE, 1.f, kUid);
+    }
+    methodStatistics.event(HELLO_CODE, 100.f, kUid);
+    methodStatistics.event(WORLD_CODE, 2.f);
+
+    const auto helloHistogram = methodStatistics.getHistogram(HELLO_CODE);
+    ASSERT_EQ(100U, helloHistogram.getN());
+    ASSERT_EQ(100.f, helloHistogram.getMax());
+    // 1 ms is in the bin [1, 2) ms.
+    ASSERT_LE(1.f, helloHistogram.getPercentile(0.5f));
+    ASSERT_GT(2.f, helloHistogram.getPercentile(0.5f));
+    ASSERT_GE(2.f, helloHistogram.getPercentile(0.99f));
+    ASSERT_EQ(100.f, helloHistogram.getPercentile(1.f));
+
+    // Only the events with a uid are counted per uid.
+    ASSERT_EQ(100U, methodStatistics.getUidHistogram(kUid).getN());
+    ASSERT_EQ(0U, methodStatistics.getHistogram(UNKNOWN_CODE).getN());
+
+    // The first summary is only due after a period.
+    ASSERT_EQ("", methodStatistics.getPeriodicSummary(std::chrono::hours(1)));
+    const std::string summary = methodStatistics.getPeriodicSummary({});
+    ASSERT_EQ(0U, summary.find(std::string(HELLO_NAME) + ":100,"));
+    ASSERT_NE(std::string::npos, summary.find(std::string(WORLD_NAME) + ":1,"));
+}
@@ -19,6 +19,7 @@
 #include <mediautils/TimeCheck.h>
 
 #include <atomic>
+#include <thread>
 #include <gtest/gtest.h>
 #include <utils/Log.h>
 
@@ -66,6 +67,23 @@ TEST(timecheck_tests, timeout) {
     ASSERT_GT(elapsedMsRegistered, 0.f);
 }
 
+TEST(timecheck_tests, stall_sampler) {
+    StallSampler stallSampler("stall", gettid(), std::chrono::system_clock::now());
+    ASSERT_EQ(0u, stallSampler.getSamplesTaken());
+
+    // Sample this thread from another thread, as the TimeCheck sampler does.
+    std::thread sampler([&stallSampler] {
+        stallSampler.sample();
+        stallSampler.sample();
+    });
+    sampler.join();
+    ASSERT_EQ(2u, stallSampler.getSamplesTaken());
+
+    const std::string s = stallSampler.toString(false /* timeout */, 10.f /* elapsedMs */);
+    ASSERT_EQ(0u, s.find("--- stall near miss"));
+    ASSERT_NE(std::string::npos, s.find(std::to_string(gettid())));
+}
+
 // Note: We do not test TimeCheck crash because TimeCheck is multithreaded and the
 // EXPECT_EXIT() signal catching is imperfect due to the gtest fork.
 
@@ -751,12 +751,13 @@ void AudioFlinger::dumpClients(int fd, const Vector<String16>& args __unused)
     String8 result;
 
     result.append("Clients:\n");
-    result.append("   pid    heap_size\n");
+    result.append("   pid    heap_size cached cached_bytes  reuse_hit reuse_miss\n");
     for (size_t i = 0; i < mClients.size(); ++i) {
         sp<Client> client = mClients.valueAt(i).promote();
         if (client != 0) {
-            result.appendFormat("%6d %12zu\n", client->pid(),
-                    client->heap()->getMemoryHeap()->getSize());
+            result.appendFormat("%6d %12zu %s\n", client->pid(),
+                    client->heap()->getMemoryHeap()->getSize(),
+                    client->trackMemoryToString().c_str());
         }
     }
 
@@ -1170,6 +1171,20 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
         output.flags = input.flags;
         output.streamType = streamType;
 
+        // Allocate the shared memory of a fast track here, before the thread lock is taken,
+        // if a track of the same configuration was created before. The track then finds
+        // it in the client cache.
+        const bool fastTrackRequest = (input.flags & AUDIO_OUTPUT_FLAG_FAST) != 0
+                && input.sharedBuffer == 0;
+        const Client::TrackMemoryConfig trackMemoryConfig{output.outputId,
+                input.config.format, input.config.channel_mask, input.config.sample_rate,
+                input.frameCount};
+        if (fastTrackRequest) {
+            if (const size_t size = client->trackMemorySize(trackMemoryConfig); size != 0) {
+                client->prepareTrackMemory(size);
+            }
+        }
+
         track = thread->createTrack_l(client, streamType, localAttr, &output.sampleRate,
                                       input.config.format, input.config.channel_mask,
                                       &output.frameCount, &output.notificationFrameCount,
@@ -1179,6 +1194,10 @@ status_t AudioFlinger::createTrack(const media::CreateTrackRequest& _input,
                                       &lStatus, portId, input.audioTrackCallback, isSpatialized);
         LOG_ALWAYS_FATAL_IF((lStatus == NO_ERROR) && (track == 0));
         // we don't abort yet if lStatus != NO_ERROR; there is still work to be done regardless
+        if (lStatus == NO_ERROR && fastTrackRequest
+                && (output.flags & AUDIO_OUTPUT_FLAG_FAST) != 0 && track->getCblk() != 0) {
+            client->setTrackMemorySize(trackMemoryConfig, track->getCblk()->size());
+        }
 
         output.afFrameCount = thread->frameCount();
         output.afSampleRate = thread->sampleRate();
@@ -2220,6 +2239,86 @@ sp<MemoryDealer> AudioFlinger::Client::heap() const
     return mMemoryDealer;
 }
 
+sp<IMemory> AudioFlinger::Client::allocateTrackMemory(size_t size)
+{
+    Mutex::Autolock _l(mTrackMemoryLock);
+    for (auto it = mCachedTrackMemory.begin(); it != mCachedTrackMemory.end(); ++it) {
+        if ((*it)->size() == size) {
+            sp<IMemory> memory = std::move(*it);
+            mCachedTrackMemory.erase(it);
+            ++mTrackMemoryHits;
+            return memory;
+        }
+    }
+    ++mTrackMemoryMisses;
+    sp<IMemory> memory = mMemoryDealer->allocate(size);
+    if (memory == 0 && !mCachedTrackMemory.empty()) {
+        // The cached blocks may be what prevents the allocation, so give them back.
+        mCachedTrackMemory.clear();
+        memory = mMemoryDealer->allocate(size);
+    }
+    return memory;
+}
+
+void AudioFlinger::Client::releaseTrackMemory(sp<IMemory>&& memory)
+{
+    // A reference from the client process means it may still access the memory.
+    if (memory == 0 || memory->getStrongCount() != 1) {
+        return;
+    }
+    Mutex::Autolock _l(mTrackMemoryLock);
+    if (mCachedTrackMemory.size() >= kMaxCachedTrackMemory) {
+        mCachedTrackMemory.erase(mCachedTrackMemory.begin()); // drop the oldest
+    }
+    mCachedTrackMemory.push_back(std::move(memory));
+}
+
+size_t AudioFlinger::Client::trackMemorySize(const TrackMemoryConfig& config) const
+{
+    Mutex::Autolock _l(mTrackMemoryLock);
+    const auto it = mTrackMemorySizes.find(config);
+    return it != mTrackMemorySizes.end() ? it->second : 0;
+}
+
+void AudioFlinger::Client::setTrackMemorySize(const TrackMemoryConfig& config, size_t size)
+{
+    Mutex::Autolock _l(mTrackMemoryLock);
+    if (mTrackMemorySizes.size() >= kMaxTrackMemoryConfigs
+            && mTrackMemorySizes.count(config) == 0) {
+        mTrackMemorySizes.clear();
+    }
+    mTrackMemorySizes[config] = size;
+}
+
+void AudioFlinger::Client::prepareTrackMemory(size_t size)
+{
+    Mutex::Autolock _l(mTrackMemoryLock);
+    for (const auto& memory : mCachedTrackMemory) {
+        if (memory->size() == size) {
+            return;
+        }
+    }
+    sp<IMemory> memory = mMemoryDealer->allocate(size);
+    if (memory == 0) {
+        return;
+    }
+    if (mCachedTrackMemory.size() >= kMaxCachedTrackMemory) {
+        mCachedTrackMemory.erase(mCachedTrackMemory.begin()); // drop the oldest
+    }
+    mCachedTrackMemory.push_back(std::move(memory));
+}
+
+std::string AudioFlinger::Client::trackMemoryToString() const
+{
+    Mutex::Autolock _l(mTrackMemoryLock);
+    size_t cachedBytes = 0;
+    for (const auto& memory : mCachedTrackMemory) {
+        cachedBytes += memory->size();
+    }
+    return StringPrintf("%6zu %12zu %10llu %10llu", mCachedTrackMemory.size(), cachedBytes,
+            (unsigned long long)mTrackMemoryHits, (unsigned long long)mTrackMemoryMisses);
+}
+
 // ----------------------------------------------------------------------------
 
 AudioFlinger::NotificationClient::NotificationClient(const sp<AudioFlinger>& audioFlinger,
@@ -4627,9 +4726,11 @@ status_t AudioFlinger::onTransactWrapper(TransactionCode code,
     }
 
     const std::string methodName = getIAudioFlingerStatistics().getMethodForCode(code);
+    const uid_t callingUid = IPCThreadState::self()->getCallingUid();
     mediautils::TimeCheck check(
             std::string("IAudioFlinger::").append(methodName),
-            [code, methodName](bool timeout, float elapsedMs) { // don't move methodName.
+            [code, methodName, callingUid](bool timeout, float elapsedMs) {
+        // don't move methodName.
         if (timeout) {
             mediametrics::LogItem(mMetricsId)
                 .set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_TIMEOUT)
@@ -4637,7 +4738,17 @@ status_t AudioFlinger::onTransactWrapper(TransactionCode code,
                 .set(AMEDIAMETRICS_PROP_METHODNAME, methodName.c_str())
                 .record();
         } else {
-            getIAudioFlingerStatistics().event(code, elapsedMs);
+            auto& statistics = getIAudioFlingerStatistics();
+            statistics.event(code, elapsedMs, callingUid);
+            if (const std::string summary =
+                    statistics.getPeriodicSummary(statistics.kSummaryPeriod);
+                    !summary.empty()) {
+                mediametrics::LogItem(mMetricsId)
+                    .set(AMEDIAMETRICS_PROP_EVENT,
+                            AMEDIAMETRICS_PROP_EVENT_VALUE_METHODSTATISTICS)
+                    .set(AMEDIAMETRICS_PROP_METHODHISTOGRAMS, summary.c_str())
+                    .record();
+            }
         }
     }, mediautils::TimeCheck::kDefaultTimeoutDuration,
     mediautils::TimeCheck::kDefaultSecondChanceDuration,
@@ -24,14 +24,17 @@
 #include <chrono>
 #include <deque>
 #include <map>
+#include <memory>
 #include <numeric>
 #include <optional>
 #include <set>
 #include <string>
+#include <tuple>
 #include <vector>
 #include <stdint.h>
 #include <sys/types.h>
 #include <limits.h>
+#include <semaphore.h>
 
 #include <android/media/BnAudioTrack.h>
 #include <android/media/IAudioFlingerClient.h>
@@ -84,6 +87,8 @@
 #include <audio_utils/SimpleLog.h>
 #include <audio_utils/TimestampVerifier.h>
 
+#include <cpustats/ThreadCpuAccounting.h>
+
 #include "FastCapture.h"
 #include "FastMixer.h"
 #include <media/nbaio/NBAIO.h>
@@ -505,12 +510,45 @@ private:
         pid_t               pid() const { return mPid; }
         sp<AudioFlinger>    audioFlinger() const { return mAudioFlinger; }
 
+        // Allocates the shared memory of a track from heap(), reusing the memory of a
+        // previously destroyed track of this client of exactly the same size if available.
+        // The cache is per client as the memory is mapped into the client process.
+        sp<IMemory>         allocateTrackMemory(size_t size);
+        // Called by a destroyed track to offer its shared memory for reuse.
+        // The memory is only kept if no one else, such as the client, still references it.
+        void                releaseTrackMemory(sp<IMemory>&& memory);
+        std::string         trackMemoryToString() const;
+
+        // Fast tracks of the same configuration on the same output end up with the same
+        // shared memory size. The size is remembered per configuration so the memory of the
+        // next such track can be prepared before the playback thread lock is taken.
+        using TrackMemoryConfig = std::tuple<audio_io_handle_t, audio_format_t,
+                audio_channel_mask_t, uint32_t /* sampleRate */, size_t /* frameCount */>;
+        size_t              trackMemorySize(const TrackMemoryConfig& config) const;
+        void                setTrackMemorySize(const TrackMemoryConfig& config, size_t size);
+        // Allocates a block of size into the reuse cache unless one is already there, so the
+        // next allocateTrackMemory(size) is served from the cache.
+        void                prepareTrackMemory(size_t size);
+
     private:
         DISALLOW_COPY_AND_ASSIGN(Client);
 
+        // Number of released track memory blocks kept for reuse, covers typical bursts of
+        // short-lived tracks such as SoundPool or UI sounds.
+        static constexpr size_t kMaxCachedTrackMemory = 4;
+        // Number of fast track configurations whose memory size is remembered.
+        static constexpr size_t kMaxTrackMemoryConfigs = 8;
+
         const sp<AudioFlinger> mAudioFlinger;
               sp<MemoryDealer> mMemoryDealer;
         const pid_t         mPid;
+
+        // Declared after mMemoryDealer so it is freed before the heap it belongs to.
+        mutable Mutex       mTrackMemoryLock;
+        std::vector<sp<IMemory>> mCachedTrackMemory; // GUARDED_BY(mTrackMemoryLock)
+        uint64_t            mTrackMemoryHits = 0;    // GUARDED_BY(mTrackMemoryLock)
+        uint64_t            mTrackMemoryMisses = 0;  // GUARDED_BY(mTrackMemoryLock)
+        std::map<TrackMemoryConfig, size_t> mTrackMemorySizes; // GUARDED_BY(mTrackMemoryLock)
     };
 
     // --- Notification Client ---
@@ -866,6 +866,44 @@ void AudioFlinger::EffectModule::process()
     }
 }
 
+bool AudioFlinger::EffectModule::startProcess()
+{
+    mLock.lock();
+    // Only in place insert effects without format or channel conversion qualify:
+    // they read and write their own chain's buffer, so nothing else needs to be done
+    // before or after the effect engine process while other chains are processed.
+    bool started = mState != DESTROYED && mEffectInterface != 0
+            && mInBuffer != 0 && mOutBuffer != 0
+            && isProcessEnabled() && isProcessImplemented()
+            && (mDescriptor.flags & EFFECT_FLAG_TYPE_MASK) == EFFECT_FLAG_TYPE_INSERT
+            && mConfig.inputCfg.buffer.raw == mConfig.outputCfg.buffer.raw
+#ifdef FLOAT_EFFECT_CHAIN
+            && mSupportsFloat
+            && mInChannelCountRequested
+                    == audio_channel_count_from_out_mask(mConfig.inputCfg.channels)
+            && mOutChannelCountRequested
+                    == audio_channel_count_from_out_mask(mConfig.outputCfg.channels)
+#endif
+            ;
+    if (started) {
+        started = mEffectInterface->startProcess() == OK;
+    }
+    if (!started) {
+        mLock.unlock();
+    }
+    return started;
+}
+
+void AudioFlinger::EffectModule::finishProcess()
+{
+    const int ret = mEffectInterface->waitProcess();
+    // force transition to IDLE state when engine is ready, as in process()
+    if (mState == STOPPED && ret == -ENODATA) {
+        mDisableWaitCnt = 1;
+    }
+    mLock.unlock();
+}
+
 void AudioFlinger::EffectModule::reset_l()
 {
     if (mStatus != NO_ERROR || mEffectInterface == 0) {
@@ -2199,6 +2237,64 @@ void AudioFlinger::EffectChain::clearInputBuffer_l()
 
 // Must be called with EffectChain::mLock locked
 void AudioFlinger::EffectChain::process_l()
+{
+    const bool processed = beginProcess_l();
+    if (processed) {
+        for (size_t i = 0; i < mEffects.size(); i++) {
+            mEffects[i]->process();
+        }
+    }
+    endProcess_l(processed);
+}
+
+// static
+void AudioFlinger::EffectChain::processBatch_l(const Vector<sp<EffectChain>>& chains)
+{
+    std::vector<EffectModule *> started;
+    size_t i = 0;
+    while (i < chains.size()) {
+        // Global session chains process the accumulated output of the session chains.
+        if (audio_is_global_session(chains[i]->sessionId())) {
+            chains[i++]->process_l();
+            continue;
+        }
+        size_t end = i;
+        while (end < chains.size() && !audio_is_global_session(chains[end]->sessionId())) {
+            ++end;
+        }
+        std::vector<bool> processed(end - i);
+        size_t maxEffects = 0;
+        for (size_t j = i; j < end; j++) {
+            processed[j - i] = chains[j]->beginProcess_l();
+            if (processed[j - i]) {
+                maxEffects = std::max(maxEffects, chains[j]->mEffects.size());
+            }
+        }
+        // The effects of a chain keep their order, one position at a time for all chains.
+        for (size_t position = 0; position < maxEffects; position++) {
+            for (size_t j = i; j < end; j++) {
+                const sp<EffectChain>& chain = chains[j];
+                if (!processed[j - i] || position >= chain->mEffects.size()) continue;
+                EffectModule *effect = chain->mEffects[position].get();
+                if (effect->startProcess()) {
+                    started.push_back(effect);
+                } else {
+                    effect->process();
+                }
+            }
+            for (EffectModule *effect : started) {
+                effect->finishProcess();
+            }
+            started.clear();
+        }
+        for (size_t j = i; j < end; j++) {
+            chains[j]->endProcess_l(processed[j - i]);
+        }
+        i = end;
+    }
+}
+
+bool AudioFlinger::EffectChain::beginProcess_l()
 {
     // never process effects when:
     // - on an OFFLOAD thread
@@ -2223,7 +2319,6 @@ void AudioFlinger::EffectChain::process_l()
         }
     }
 
-    size_t size = mEffects.size();
     if (doProcess) {
         // Only the input and output buffers of the chain can be external,
         // and 'update' / 'commit' do nothing for allocated buffers, thus
@@ -2232,16 +2327,20 @@ void AudioFlinger::EffectChain::process_l()
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->update();
         }
-        for (size_t i = 0; i < size; i++) {
-            mEffects[i]->process();
-        }
+    }
+    return doProcess;
+}
+
+void AudioFlinger::EffectChain::endProcess_l(bool processed)
+{
+    if (processed) {
         mInBuffer->commit();
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->commit();
         }
     }
     bool doResetVolume = false;
-    for (size_t i = 0; i < size; i++) {
+    for (size_t i = 0; i < mEffects.size(); i++) {
         doResetVolume = mEffects[i]->updateState() || doResetVolume;
     }
     if (doResetVolume) {
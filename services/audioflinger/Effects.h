@@ -228,6 +228,12 @@ public:
     virtual ~EffectModule();
 
     void process();
+    // Split form of process() used by EffectChain::processBatch_l().
+    // If startProcess() returns true, the effect engine is processing in place and
+    // finishProcess() must be called next; mLock is held in between.
+    // Otherwise process() must be called instead.
+    bool startProcess();
+    void finishProcess();
     bool updateState();
     status_t command(int32_t cmdCode,
                      const std::vector<uint8_t>& cmdData,
@@ -450,6 +456,13 @@ public:
 
     void process_l();
 
+    // Processes the chains in order, with the same result as calling process_l() on each.
+    // Effects at the same position in consecutive non global session chains which support
+    // EffectModule::startProcess() are started together and then waited for, so that their
+    // effect engines run concurrently instead of one after the other.
+    // Each chain must be locked, as for process_l().
+    static void processBatch_l(const Vector<sp<EffectChain>>& chains);
+
     void lock() {
         mLock.lock();
     }
@@ -493,6 +506,15 @@ public:
     effect_buffer_t *outBuffer() const {
         return mOutBuffer != 0 ? reinterpret_cast<effect_buffer_t*>(mOutBuffer->ptr()) : NULL;
     }
+    // Points the input and output buffers of the chain to other memory, for a chain
+    // processed by a worker with its own copy of the thread buffers.
+    // Only valid when the chain buffers are mirrors of external memory.
+    void setExternalData_l(void *in, void *out) {
+        mInBuffer->setExternalData(in);
+        if (mOutBuffer != mInBuffer) {
+            mOutBuffer->setExternalData(out);
+        }
+    }
 
     void incTrackCnt() { android_atomic_inc(&mTrackCnt); }
     void decTrackCnt() { android_atomic_dec(&mTrackCnt); }
@@ -657,6 +679,10 @@ private:
 
     void clearInputBuffer_l();
 
+    // process_l() is beginProcess_l(), processing of each effect, then endProcess_l().
+    bool beginProcess_l();
+    void endProcess_l(bool processed);
+
     void setThread(const sp<ThreadBase>& thread);
 
     // true if any effect module within the chain has volume control
@@ -94,6 +94,7 @@ FastMixer::FastMixer(audio_io_handle_t parentIoHandle)
     unsigned i;
     for (i = 0; i < FastMixerState::sMaxFastTracks; ++i) {
         mGenerations[i] = 0;
+        mTrackParamsSequences[i] = 0;
     }
 #ifdef FAST_THREAD_STATISTICS
     mOldLoad.tv_sec = 0;
@@ -132,6 +133,22 @@ void FastMixer::onExit()
     free(mSinkBuffer);
 }
 
+void FastMixer::setTrackParams(int index, float volume, bool muted,
+        bool hapticPlaybackEnabled, os::HapticScale hapticIntensity)
+{
+    LOG_ALWAYS_FATAL_IF(index < 0 || index >= (int)FastMixerState::kMaxFastTracks,
+            "%s: invalid index %d", __func__, index);
+    FastTrackParams &params = mTrackParams[index];
+    params.mVolume.store(volume, std::memory_order_relaxed);
+    params.mMuted.store(muted, std::memory_order_relaxed);
+    if (params.mHapticPlaybackEnabled.load(std::memory_order_relaxed) != hapticPlaybackEnabled
+            || params.mHapticIntensity.load(std::memory_order_relaxed) != hapticIntensity) {
+        params.mHapticPlaybackEnabled.store(hapticPlaybackEnabled, std::memory_order_relaxed);
+        params.mHapticIntensity.store(hapticIntensity, std::memory_order_relaxed);
+        params.mSequence.fetch_add(1, std::memory_order_release);
+    }
+}
+
 bool FastMixer::isSubClassCommand(FastThreadState::Command command)
 {
     switch ((FastMixerState::Command) command) {
@@ -178,8 +195,9 @@ void FastMixer::updateMixerTrack(int index, Reason reason) {
         float vlf, vrf;
         if (fastTrack->mVolumeProvider != nullptr) {
             const gain_minifloat_packed_t vlr = fastTrack->mVolumeProvider->getVolumeLR();
-            vlf = float_from_gain(gain_minifloat_unpack_left(vlr));
-            vrf = float_from_gain(gain_minifloat_unpack_right(vlr));
+            const float volume = trackParamsVolume(index);
+            vlf = volume * float_from_gain(gain_minifloat_unpack_left(vlr));
+            vrf = volume * float_from_gain(gain_minifloat_unpack_right(vlr));
         } else {
             vlf = vrf = AudioMixer::UNITY_GAIN_FLOAT;
         }
@@ -208,6 +226,11 @@ void FastMixer::updateMixerTrack(int index, Reason reason) {
         mMixer->setParameter(index, AudioMixer::TRACK, AudioMixer::HAPTIC_MAX_AMPLITUDE,
                 (void *)(&(fastTrack->mHapticMaxAmplitude)));
 
+        // the haptic parameters from mTrackParams override those of the state
+        // from the next cycle, if they have changed since.
+        mTrackParamsSequences[index] =
+                mTrackParams[index].mSequence.load(std::memory_order_acquire) - 1;
+
         mMixer->enable(index);
         break;
     default:
@@ -408,10 +431,22 @@ void FastMixer::onWork()
             fastTrack->mBufferProvider->onTimestamp(perTrackTimestamp);
 
             const int name = i;
+            const FastTrackParams &params = mTrackParams[i];
+            const uint32_t sequence = params.mSequence.load(std::memory_order_acquire);
+            if (sequence != mTrackParamsSequences[i]) {
+                mTrackParamsSequences[i] = sequence;
+                mMixer->setParameter(name, AudioMixer::TRACK, AudioMixer::HAPTIC_ENABLED,
+                        (void *)(uintptr_t)params.mHapticPlaybackEnabled.load(
+                                std::memory_order_relaxed));
+                mMixer->setParameter(name, AudioMixer::TRACK, AudioMixer::HAPTIC_INTENSITY,
+                        (void *)(uintptr_t)params.mHapticIntensity.load(
+                                std::memory_order_relaxed));
+            }
             if (fastTrack->mVolumeProvider != NULL) {
                 gain_minifloat_packed_t vlr = fastTrack->mVolumeProvider->getVolumeLR();
-                float vlf = float_from_gain(gain_minifloat_unpack_left(vlr));
-                float vrf = float_from_gain(gain_minifloat_unpack_right(vlr));
+                const float volume = trackParamsVolume(i);
+                float vlf = volume * float_from_gain(gain_minifloat_unpack_left(vlr));
+                float vrf = volume * float_from_gain(gain_minifloat_unpack_right(vlr));
 
                 mMixer->setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME0, &vlf);
                 mMixer->setParameter(name, AudioMixer::RAMP_VOLUME, AudioMixer::VOLUME1, &vrf);
@@ -47,6 +47,11 @@ public:
     virtual void setBoottimeOffset(int64_t boottimeOffset) {
         mBoottimeOffset.store(boottimeOffset); /* memory_order_seq_cst */
     }
+
+    // Updates the per-cycle parameters of fast track index, without a state queue push.
+    // Called by the normal mixer, lock-free.
+            void setTrackParams(int index, float volume, bool muted,
+                    bool hapticPlaybackEnabled, os::HapticScale hapticIntensity);
 private:
             FastMixerStateQueue mSQ;
 
@@ -67,12 +72,22 @@ private:
     // called when a fast track of index has been removed, added, or modified
     void updateMixerTrack(int index, Reason reason);
 
+    // volume from mTrackParams[index], 0 if muted.
+    float trackParamsVolume(int index) const {
+        const FastTrackParams &params = mTrackParams[index];
+        return params.mMuted.load(std::memory_order_relaxed)
+                ? 0.f : params.mVolume.load(std::memory_order_relaxed);
+    }
+
     // FIXME these former local variables need comments
     static const FastMixerState sInitial;
 
     FastMixerState  mPreIdle;   // copy of state before we went into idle
     int             mGenerations[FastMixerState::kMaxFastTracks];
                                 // last observed mFastTracks[i].mGeneration
+    FastTrackParams mTrackParams[FastMixerState::kMaxFastTracks];
+    uint32_t        mTrackParamsSequences[FastMixerState::kMaxFastTracks];
+                                // last observed mTrackParams[i].mSequence
     NBAIO_Sink*     mOutputSink;
     int             mOutputSinkGen;
     AudioMixer*     mMixer;
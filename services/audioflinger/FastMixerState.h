@@ -17,6 +17,7 @@
 #ifndef ANDROID_AUDIO_FAST_MIXER_STATE_H
 #define ANDROID_AUDIO_FAST_MIXER_STATE_H
 
+#include <atomic>
 #include <math.h>
 
 #include <audio_utils/minifloat.h>
@@ -41,6 +42,21 @@ protected:
     virtual ~VolumeProvider() { }
 };
 
+// Parameters of a fast track which may change every normal mixer cycle.
+// These are written by the normal mixer and read by the fast mixer each cycle
+// without a FastMixerState push, see FastMixer::setTrackParams().
+struct FastTrackParams {
+    // combined master volume, stream type volume and volume shaper,
+    // applied on top of the VolumeProvider volume.
+    std::atomic<float>      mVolume{1.f};
+    std::atomic<bool>       mMuted{false};
+    std::atomic<bool>       mHapticPlaybackEnabled{false};
+    std::atomic<os::HapticScale> mHapticIntensity{os::HapticScale::MUTE};
+    // incremented after a change of the haptic parameters, which need AudioMixer
+    // reconfiguration; volume and mute are read every cycle.
+    std::atomic<uint32_t>   mSequence{0};
+};
+
 // Represents the state of a fast track
 struct FastTrack {
     FastTrack();
@@ -20,6 +20,7 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include "Configuration.h"
+#include <algorithm>
 #include <linux/futex.h>
 #include <sys/syscall.h>
 #include <audio_utils/clock.h>
@@ -265,6 +266,12 @@ bool FastThread::threadLoop()
                     }
                 }
                 mSleepNs = -1;
+                if (mIsWarm && mPeriodNs > 0) {
+                    constexpr uint32_t kLastBin = FastThreadDumpState::kCycleHistogramBins - 1;
+                    const uint32_t bin = sec > 0 ? kLastBin
+                            : std::min((uint32_t) ((nsec * 4) / mPeriodNs), kLastBin);
+                    mDumpState->mCycleHistogram[bin]++;
+                }
                 if (mIsWarm) {
                     if (sec > 0 || nsec > mUnderrunNs) {
                         ATRACE_NAME("underrun");
@@ -345,6 +352,7 @@ bool FastThread::threadLoop()
                     mDumpState->mMonotonicNs[i] = monotonicNs;
                     LOG_WORK_TIME(monotonicNs);
                     mDumpState->mLoadNs[i] = loadNs;
+                    LOG_CPU_TIME(loadNs);
 #ifdef CPU_FREQUENCY_STATISTICS
                     mDumpState->mCpukHz[i] = kHz;
 #endif
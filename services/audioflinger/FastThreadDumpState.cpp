@@ -29,6 +29,7 @@ FastThreadDumpState::FastThreadDumpState() :
 {
     mMeasuredWarmupTs.tv_sec = 0;
     mMeasuredWarmupTs.tv_nsec = 0;
+    memset(mCycleHistogram, 0, sizeof(mCycleHistogram));
 #ifdef FAST_THREAD_STATISTICS
     increaseSamplingN(1);
 #endif
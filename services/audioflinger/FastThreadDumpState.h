@@ -38,6 +38,12 @@ struct FastThreadDumpState {
     struct timespec mMeasuredWarmupTs;  // measured warmup time
     uint32_t mWarmupCycles;     // number of loop cycles required to warmup
 
+    // Always-on histogram of the cycle times after warmup, for export to mediametrics.
+    // Bin i counts cycles of [i, i + 1) quarters of the expected period; the last bin also
+    // counts all longer cycles.  Each bin is a total since construction, like mUnderruns.
+    static constexpr uint32_t kCycleHistogramBins = 16;
+    uint32_t mCycleHistogram[kCycleHistogramBins];
+
 #ifdef FAST_THREAD_STATISTICS
     // Recently collected samples of per-cycle monotonic time, thread CPU time, and CPU frequency.
     // kSamplingN is max size of sampling frame (statistics), and must be a power of 2 <= 0x8000.
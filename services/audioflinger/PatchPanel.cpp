@@ -20,6 +20,7 @@
 //#define LOG_NDEBUG 0
 
 #include "Configuration.h"
+#include <cutils/properties.h>
 #include <utils/Log.h>
 #include <audio_utils/primitives.h>
 
@@ -47,6 +48,38 @@
 
 namespace android {
 
+// Returns in directConfig the configuration of a direct output that matches the source of a
+// device to device software patch, when enabled, the source is fully specified PCM and the sink
+// does not ask for something else. See PatchPanel::Patch::canStreamDirectly().
+static bool getDirectOutputConfig(const struct audio_port_config &source,
+                                  const audio_config_t &sinkConfig,
+                                  audio_config_t *directConfig)
+{
+    if (!property_get_bool("af.patch.direct_pcm", false /* default_value */)) {
+        return false;
+    }
+    constexpr unsigned int kRequiredMask = AUDIO_PORT_CONFIG_SAMPLE_RATE |
+            AUDIO_PORT_CONFIG_CHANNEL_MASK | AUDIO_PORT_CONFIG_FORMAT;
+    if ((source.config_mask & kRequiredMask) != kRequiredMask ||
+            !audio_is_linear_pcm(source.format)) {
+        return false;
+    }
+    const audio_channel_mask_t channelMask = audio_channel_out_mask_from_count(
+            audio_channel_count_from_in_mask(source.channel_mask));
+    if (channelMask == AUDIO_CHANNEL_INVALID ||
+            (sinkConfig.sample_rate != 0 && sinkConfig.sample_rate != source.sample_rate) ||
+            (sinkConfig.channel_mask != AUDIO_CHANNEL_NONE &&
+                    sinkConfig.channel_mask != channelMask) ||
+            (sinkConfig.format != AUDIO_FORMAT_DEFAULT && sinkConfig.format != source.format)) {
+        return false;
+    }
+    *directConfig = sinkConfig;
+    directConfig->sample_rate = source.sample_rate;
+    directConfig->channel_mask = channelMask;
+    directConfig->format = source.format;
+    return true;
+}
+
 /* List connected audio ports and their attributes */
 status_t AudioFlinger::listAudioPorts(unsigned int *num_ports,
                                 struct audio_port *ports)
@@ -273,14 +306,31 @@ status_t AudioFlinger::PatchPanel::createAudioPatch(const struct audio_patch *pa
                     if (patch->sinks[0].config_mask & AUDIO_PORT_CONFIG_FLAGS) {
                         flags = patch->sinks[0].flags.output;
                     }
-                    sp<ThreadBase> thread = mAudioFlinger.openOutput_l(
-                                                            patch->sinks[0].ext.device.hw_module,
+                    sp<ThreadBase> thread;
+                    audio_config_t directConfig;
+                    if (flags == AUDIO_OUTPUT_FLAG_NONE &&
+                            getDirectOutputConfig(patch->sources[0], config, &directConfig)) {
+                        // Try a direct output matching the source first. createConnections()
+                        // then streams from the input to the output on the output thread alone.
+                        thread = mAudioFlinger.openOutput_l(patch->sinks[0].ext.device.hw_module,
+                                                            &output,
+                                                            &directConfig,
+                                                            &mixerConfig,
+                                                            outputDevice,
+                                                            outputDeviceAddress,
+                                                            AUDIO_OUTPUT_FLAG_DIRECT);
+                        ALOGV("%s() direct output %s", __func__, thread != 0 ? "opened" : "failed");
+                    }
+                    if (thread == 0) {
+                        output = AUDIO_IO_HANDLE_NONE;
+                        thread = mAudioFlinger.openOutput_l(patch->sinks[0].ext.device.hw_module,
                                                             &output,
                                                             &config,
                                                             &mixerConfig,
                                                             outputDevice,
                                                             outputDeviceAddress,
                                                             flags);
+                    }
                     ALOGV("mAudioFlinger.openOutput_l() returned %p", thread.get());
                     if (thread == 0) {
                         status = NO_MEMORY;
@@ -542,7 +592,8 @@ status_t AudioFlinger::PatchPanel::Patch::createConnections(PatchPanel *panel)
 
     sp<RecordThread::PatchRecord> tempRecordTrack;
     const bool usePassthruPatchRecord =
-            (inputFlags & AUDIO_INPUT_FLAG_DIRECT) && (outputFlags & AUDIO_OUTPUT_FLAG_DIRECT);
+            ((inputFlags & AUDIO_INPUT_FLAG_DIRECT) && (outputFlags & AUDIO_OUTPUT_FLAG_DIRECT)) ||
+            canStreamDirectly();
     const size_t playbackFrameCount = mPlayback.thread()->frameCount();
     const size_t recordFrameCount = mRecord.thread()->frameCount();
     size_t frameCount = 0;
@@ -630,6 +681,24 @@ status_t AudioFlinger::PatchPanel::Patch::createConnections(PatchPanel *panel)
     return status;
 }
 
+bool AudioFlinger::PatchPanel::Patch::canStreamDirectly() const
+{
+    // PassthruPatchRecord reads the input stream from the playback thread whenever that thread
+    // needs data, which only suits a direct output thread of our own: a mixer would block on
+    // the input, and a reused thread may have other tracks. No conversion is done on the way,
+    // so both streams must have the same PCM configuration, and the input must not be read
+    // by a fast capture thread.
+    const sp<PlaybackThread> playbackThread = mPlayback.thread();
+    const sp<RecordThread> recordThread = mRecord.thread();
+    return mAudioPatch.num_sources == 1 &&
+            playbackThread->type() == ThreadBase::DIRECT &&
+            audio_is_linear_pcm(playbackThread->format()) &&
+            playbackThread->format() == recordThread->format() &&
+            playbackThread->sampleRate() == recordThread->sampleRate() &&
+            playbackThread->channelCount() == recordThread->channelCount() &&
+            !recordThread->hasFastCapture();
+}
+
 void AudioFlinger::PatchPanel::Patch::clearConnections(PatchPanel *panel)
 {
     ALOGV("%s() mRecord.handle %d mPlayback.handle %d",
@@ -196,6 +196,8 @@ public:
 
         status_t createConnections(PatchPanel *panel);
         void clearConnections(PatchPanel *panel);
+        // true if the input can be streamed to the output on the playback thread alone
+        bool canStreamDirectly() const;
         bool isSoftware() const {
             return mRecord.handle() != AUDIO_PATCH_HANDLE_NONE ||
                     mPlayback.handle() != AUDIO_PATCH_HANDLE_NONE; }
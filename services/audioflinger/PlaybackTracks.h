@@ -342,9 +342,6 @@ private:
                                     // but the slot is only used if track is active
     FastTrackUnderruns  mObservedUnderruns; // Most recently observed value of
                                     // mFastMixerDumpState.mTracks[mFastIndex].mUnderruns
-    volatile float      mCachedVolume;  // combined master volume and stream type volume;
-                                        // 'volatile' means accessed without lock or
-                                        // barrier, but is read/written atomically
     float               mFinalVolume; // combine master volume, stream type volume and track volume
     sp<AudioTrackServerProxy>  mAudioTrackServerProxy;
     bool                mResumeToStopping; // track was paused in stopping state.
@@ -361,10 +358,8 @@ private:
 class OutputTrack : public Track {
 public:
 
-    class Buffer : public AudioBufferProvider::Buffer {
-    public:
-        void *mBuffer;
-    };
+    /** Mixed data of the duplicating thread, shared by the output tracks that queue it. */
+    using SharedBuffer = std::shared_ptr<const std::vector<uint8_t>>;
 
                         OutputTrack(PlaybackThread *thread,
                                 DuplicatingThread *sourceThread,
@@ -379,8 +374,18 @@ public:
                                     AudioSystem::SYNC_EVENT_NONE,
                              audio_session_t triggerSession = AUDIO_SESSION_NONE);
     virtual void        stop();
-            ssize_t     write(void* data, uint32_t frames);
+    /**
+     * Writes frames to the track, waiting at most *waitTimeLeftMs for room in total and
+     * decreasing it by the time waited, so that the output tracks of one duplicating thread
+     * share the wait. Frames that do not fit are queued for the next write: the first output
+     * track of a write that needs to queue copies data to *sharedData, later ones reference it.
+     * @return the number of frames consumed.
+     */
+            ssize_t     write(void* data, uint32_t frames, uint32_t *waitTimeLeftMs,
+                              SharedBuffer *sharedData);
             bool        bufferQueueEmpty() const { return mBufferQueue.size() == 0; }
+            // frames dropped because this track's queue was full. Thread safe.
+            int64_t     droppedFrames() const { return mDroppedFrames.load(); }
             bool        isActive() const { return mActive; }
     const wp<ThreadBase>& thread() const { return mThread; }
 
@@ -407,14 +412,23 @@ private:
 
     void                restartIfDisabled();
 
-    // Maximum number of pending buffers allocated by OutputTrack::write()
+    // Maximum number of pending buffers queued by OutputTrack::write(). When the queue is
+    // full, the oldest one is dropped so that a slow output catches up instead of lagging.
     static const uint8_t kMaxOverFlowBuffers = 10;
 
-    Vector < Buffer* >          mBufferQueue;
+    // Frames of a write() that did not fit in the track buffer yet.
+    struct PendingBuffer {
+        SharedBuffer data;
+        size_t offset;      // in bytes, of the next frame to write
+        size_t frameCount;  // frames left to write
+    };
+
+    std::deque<PendingBuffer>   mBufferQueue;
     AudioBufferProvider::Buffer mOutBuffer;
     bool                        mActive;
-    DuplicatingThread* const    mSourceThread; // for waitTimeMs() in write()
+    DuplicatingThread* const    mSourceThread;
     sp<AudioTrackClientProxy>   mClientProxy;
+    std::atomic<int64_t>        mDroppedFrames{0};
 
     /** Attributes of the source tracks.
      *
@@ -118,6 +118,21 @@ private:
 
             // used by the record thread to convert frames to proper destination format
             RecordBufferConverter              *mRecordBufferConverter;
+
+            // Sharing of the converted data with a track of identical configuration,
+            // see RecordThread::prepareSharedConversion().
+            // track whose converted data was last copied instead of converting
+            wp<RecordTrack>                    mConversionLeader;
+            // same as mConversionLeader for the current read, or nullptr, owned by activeTracks
+            RecordTrack                        *mActiveConversionLeader = nullptr;
+            // mRecordBufferConverter has not converted any data since its reset
+            bool                               mConverterFresh = false;
+            // converted data is retained in mSharedFrames for the current read
+            bool                               mIsConversionLeader = false;
+            std::vector<uint8_t>               mSharedFrames;
+            size_t                             mSharedFrameCount = 0;
+            // frames of the leader mSharedFrames already copied for the current read
+            size_t                             mSharedFramesOffset = 0;
             audio_input_flags_t                mFlags;
 
             bool                               mSilenced;
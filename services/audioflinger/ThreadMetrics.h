@@ -18,6 +18,7 @@
 #define ANDROID_AUDIO_THREADMETRICS_H
 
 #include <mutex>
+#include <vector>
 
 namespace android {
 
@@ -47,6 +48,7 @@ public:
     ~ThreadMetrics() {
         logEndInterval(); // close any open interval groups
         std::lock_guard l(mLock);
+        deliverFastThreadCycles();
         deliverCumulativeMetrics(AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAUDIOINTERVALGROUP);
         mediametrics::LogItem(mMetricsId)
             .set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_DTOR)
@@ -61,6 +63,7 @@ public:
         // The devices we look for change depend on whether the Thread is input or output.
         const std::string& patchDevices = mIsOut ? mCreatePatchOutDevices : mCreatePatchInDevices;
         if (mDevices != patchDevices) {
+            deliverFastThreadCycles(); // attribute to the previous devices
             deliverCumulativeMetrics(AMEDIAMETRICS_PROP_EVENT_VALUE_ENDAUDIOINTERVALGROUP);
             mDevices = patchDevices; // set after endAudioIntervalGroup
             resetIntervalGroupMetrics();
@@ -128,6 +131,41 @@ public:
         mUnderrunFrames += frames;
     }
 
+    // CPU time used by the thread loop over durationNs, delivered every kCpuUsagePeriodNs.
+    static constexpr int64_t kCpuUsagePeriodNs = 300'000'000'000; // 5 minutes
+
+    void logCpuUsage(int64_t cpuNs, int64_t wallNs) const {
+        mediametrics::LogItem(mMetricsId)
+            .set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_CPUUSAGE)
+            .set(AMEDIAMETRICS_PROP_CPUTIMENS, cpuNs)
+            .set(AMEDIAMETRICS_PROP_DURATIONNS, wallNs)
+            .record();
+    }
+
+    // Called periodically by a thread with a FastMixer or FastCapture, with the totals since
+    // construction from its FastThreadDumpState.  The counters are read without synchronization,
+    // so they may be slightly inconsistent with each other.
+    // The changes since the last delivery are delivered at most once per
+    // kFastThreadCyclesPeriodNs, and at the end of each interval group.
+    void logFastThreadCycles(const uint32_t *histogram, size_t bins,
+            uint32_t underruns, uint32_t overruns) {
+        std::lock_guard l(mLock);
+        const int64_t nowNs = systemTime();
+        if (mFastCyclesLastNs == 0) {
+            mFastCyclesLastNs = nowNs; // first call, baseline for the deltas.
+            mFastCyclesLast.assign(histogram, histogram + bins);
+            mFastCycles.assign(bins, 0);
+            mFastUnderrunsLast = underruns;
+            mFastOverrunsLast = overruns;
+            return;
+        }
+        accumulateFastThreadCycles(histogram, bins, underruns, overruns);
+        if (nowNs - mFastCyclesLastNs >= kFastThreadCyclesPeriodNs) {
+            mFastCyclesLastNs = nowNs;
+            deliverFastThreadCycles();
+        }
+    }
+
     const std::string& getMetricsId() const {
         return mMetricsId;
     }
@@ -136,7 +174,7 @@ private:
     // no lock required - all arguments and constants.
     void deliverDeviceMetrics(const char *eventName, const char *devices) const {
         mediametrics::LogItem(mMetricsId)
-            .set(AMEDIAMETRICS_PROP_EVENT, eventName)
+            .set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_FASTTHREADCYCLES)
             .set(mIsOut ? AMEDIAMETRICS_PROP_OUTPUTDEVICES
                    : AMEDIAMETRICS_PROP_INPUTDEVICES, devices)
            .record();
@@ -167,6 +205,43 @@ private:
         }
     }
 
+    // Adds the changes since the last call to the undelivered fast thread counters.
+    // Counters are unsigned so the subtraction handles wraparound.
+    void accumulateFastThreadCycles(const uint32_t *histogram, size_t bins,
+            uint32_t underruns, uint32_t overruns) REQUIRES(mLock) {
+        if (bins != mFastCyclesLast.size()) return;
+        for (size_t i = 0; i < bins; ++i) {
+            mFastCycles[i] += histogram[i] - mFastCyclesLast[i];
+            mFastCyclesLast[i] = histogram[i];
+        }
+        mFastUnderruns += underruns - mFastUnderrunsLast;
+        mFastUnderrunsLast = underruns;
+        mFastOverruns += overruns - mFastOverrunsLast;
+        mFastOverrunsLast = overruns;
+    }
+
+    void deliverFastThreadCycles() REQUIRES(mLock) {
+        int64_t cycles = 0;
+        std::string histogram;
+        for (size_t i = 0; i < mFastCycles.size(); ++i) {
+            cycles += mFastCycles[i];
+            if (i > 0) histogram.append(",");
+            histogram.append(std::to_string(mFastCycles[i]));
+        }
+        if (cycles == 0) return;
+        mediametrics::LogItem(mMetricsId)
+            .set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_FASTTHREADCYCLES)
+            .set(mIsOut ? AMEDIAMETRICS_PROP_OUTPUTDEVICES
+                   : AMEDIAMETRICS_PROP_INPUTDEVICES, mDevices.c_str())
+            .set(AMEDIAMETRICS_PROP_FASTCYCLEHISTOGRAM, histogram)
+            .set(AMEDIAMETRICS_PROP_FASTUNDERRUN, (int32_t)mFastUnderruns)
+            .set(AMEDIAMETRICS_PROP_FASTOVERRUN, (int32_t)mFastOverruns)
+            .record();
+        std::fill(mFastCycles.begin(), mFastCycles.end(), 0);
+        mFastUnderruns = 0;
+        mFastOverruns = 0;
+    }
+
     void resetIntervalGroupMetrics() REQUIRES(mLock) {
         // mDevices is not reset by clear
 
@@ -205,6 +280,16 @@ private:
     bool              mLastUnderrun GUARDED_BY(mLock) = false; // checks consecutive underruns
     int64_t           mUnderrunCount GUARDED_BY(mLock) = 0;    // number of consecutive underruns
     int64_t           mUnderrunFrames GUARDED_BY(mLock) = 0;   // total estimated frames underrun
+
+    // FastMixer or FastCapture cycle statistics, not delivered yet.
+    static constexpr int64_t kFastThreadCyclesPeriodNs = 300'000'000'000; // 5 minutes
+    int64_t           mFastCyclesLastNs GUARDED_BY(mLock) = 0;
+    std::vector<uint32_t> mFastCyclesLast GUARDED_BY(mLock);  // last totals from the dump state
+    uint32_t          mFastUnderrunsLast GUARDED_BY(mLock) = 0;
+    uint32_t          mFastOverrunsLast GUARDED_BY(mLock) = 0;
+    std::vector<int64_t> mFastCycles GUARDED_BY(mLock);      // deltas since last delivery
+    int64_t           mFastUnderruns GUARDED_BY(mLock) = 0;
+    int64_t           mFastOverruns GUARDED_BY(mLock) = 0;
 };
 
 } // namespace android
@@ -236,6 +236,10 @@ static const int kFastTrackMultiplierMax = 2;
 // The actual value to use, which can be specified per-device via property af.fast_track_multiplier.
 static int sFastTrackMultiplier = kFastTrackMultiplier;
 
+// Minimum number of enabled normal tracks before the AudioMixer mixes them on worker threads,
+// when parallel mixing is enabled via property af.mixer.parallel_workers.
+static const int32_t kDefaultParallelMixingTrackThreshold = 16;
+
 // See Thread::readOnlyHeap().
 // Initially this heap is used to allocate client buffers for "fast" AudioRecord.
 // Eventually it will be the single buffer that FastCapture writes into via HAL read(),
@@ -307,6 +311,17 @@ static void sFastTrackMultiplierInit()
 
 #ifdef ADD_BATTERY_DATA
 // To collect the amplifier usage
+// Configures optional parallel mixing of normal tracks, disabled by default.
+static void configureParallelMixing(AudioMixer *audioMixer)
+{
+    const int32_t workers = property_get_int32("af.mixer.parallel_workers", 0);
+    if (workers <= 0) return;
+    const int32_t threshold = property_get_int32(
+            "af.mixer.parallel_track_threshold", kDefaultParallelMixingTrackThreshold);
+    const int64_t cpuMask = property_get_int64("af.mixer.parallel_cpu_mask", 0);
+    audioMixer->setParallelMixing(workers, std::max(threshold, 2), (uint64_t)cpuMask);
+}
+
 static void addBatteryData(uint32_t params) {
     sp<IMediaPlayerService> service = IMediaDeathNotifier::getMediaPlayerService();
     if (service == NULL) {
@@ -2643,6 +2658,11 @@ uint32_t AudioFlinger::PlaybackThread::latency() const
     Mutex::Autolock _l(mLock);
     return latency_l();
 }
+void AudioFlinger::PlaybackThread::processEffectChain_l(const sp<EffectChain>& chain)
+{
+    chain->process_l();
+}
+
 uint32_t AudioFlinger::PlaybackThread::latency_l() const
 {
     uint32_t latency;
@@ -3092,6 +3112,9 @@ void AudioFlinger::PlaybackThread::readOutputParameters_l()
 
     // Check if we want to throttle the processing to no more than 2x normal rate
     mThreadThrottle = property_get_bool("af.thread.throttle", true /* default_value */);
+    // Check if the effect engines of different sessions may process concurrently
+    mBatchEffectProcessing = property_get_bool("af.effect.batch_process",
+            false /* default_value */);
     mThreadThrottleTimeMs = 0;
     mThreadThrottleEndMs = 0;
     mHalfBufferMs = mNormalFrameCount * 1000 / (2 * mSampleRate);
@@ -3792,6 +3815,7 @@ bool AudioFlinger::PlaybackThread::threadLoop()
         mAudioFlinger->requestLogMerge();
 
         cpuStats.sample(myName);
+        accountCpuUsage();
 
         Vector< sp<EffectChain> > effectChains;
         audio_session_t activeHapticSessionId = AUDIO_SESSION_NONE;
@@ -4028,10 +4052,20 @@ bool AudioFlinger::PlaybackThread::threadLoop()
             // TODO use mSleepTimeUs == 0 as an additional condition.
             uint32_t mixerChannelCount = mEffectBufferValid ?
                         audio_channel_count_from_out_mask(mMixerChannelMask) : mChannelCount;
-            if (mMixerBufferValid) {
+            if (mMixerBufferValid && fuseSinkConversion_l()) {
+                // Balance, format conversion and haptic channel adjustment in a single pass.
+                writeFusedSinkBuffer_l();
+            } else if (mMixerBufferValid) {
                 void *buffer = mEffectBufferValid ? mEffectBuffer : mSinkBuffer;
                 audio_format_t format = mEffectBufferValid ? mEffectBufferFormat : mFormat;
 
+                // mBalance applies the balance on this path, either below or after effects.
+                // Track its gains so a later fused pass ramps from where mBalance left off.
+                if (!hasFastMixer() && mChannelMask == AUDIO_CHANNEL_OUT_STEREO) {
+                    mBalance.computeStereoBalance(mMasterBalance.load(),
+                            &mSinkBalanceLeft, &mSinkBalanceRight);
+                }
+
                 // Apply mono blending and balancing if the effect buffer is not valid. Otherwise,
                 // do these processes after effects are applied.
                 if (!mEffectBufferValid) {
@@ -4079,8 +4113,17 @@ bool AudioFlinger::PlaybackThread::threadLoop()
 
             // only process effects if we're going to write
             if (mSleepTimeUs == 0 && mType != OFFLOAD && mType != DIRECT) {
+                // Batching only changes how the effect engines are scheduled, the haptic data
+                // below is outside of the buffer region processed by the effects.
+                const bool batch = mBatchEffectProcessing && effectChains.size() > 1
+                        && !hasPipelinedEffectChain_l();
+                if (batch) {
+                    EffectChain::processBatch_l(effectChains);
+                }
                 for (size_t i = 0; i < effectChains.size(); i ++) {
-                    effectChains[i]->process_l();
+                    if (!batch) {
+                        processEffectChain_l(effectChains[i]);
+                    }
                     // TODO: Write haptic data directly to sink buffer when mixing.
                     if (activeHapticSessionId != AUDIO_SESSION_NONE
                             && activeHapticSessionId == effectChains[i]->sessionId()) {
@@ -4513,6 +4556,104 @@ void AudioFlinger::PlaybackThread::collectTimestamps_l()
 }
 
 // removeTracks_l() must be called with ThreadBase::mLock held
+// Stores one float sample at a given index of the sink buffer, in the sink format.
+struct SinkStorePcm16 {
+    int16_t *dst;
+    void operator()(size_t index, float sample) const {
+        dst[index] = clamp16_from_float(sample);
+    }
+};
+
+struct SinkStorePcm24Packed {
+    uint8_t *dst;
+    void operator()(size_t index, float sample) const {
+        const int32_t value = clamp24_from_float(sample);
+        uint8_t *bytes = dst + index * 3;
+        bytes[0] = value;        // little endian, as memcpy_to_p24_from_float()
+        bytes[1] = value >> 8;
+        bytes[2] = value >> 16;
+    }
+};
+
+// Converts interleaved float frames of (channelCount + hapticChannelCount) samples to the sink.
+// The audio samples are written first, followed by the haptic samples of all frames,
+// which is the layout adjust_channels_non_destructive() produces.
+// For stereo, the balance gains ramp linearly over the buffer from the "from" to the "to" gains.
+// The loops have no cross-iteration dependency so the compiler can vectorize them.
+template <typename Store>
+static void balanceAndConvertToSink(const Store& store, const float *src, size_t frameCount,
+        uint32_t channelCount, uint32_t hapticChannelCount,
+        float fromLeft, float fromRight, float toLeft, float toRight)
+{
+    const uint32_t srcChannelCount = channelCount + hapticChannelCount;
+    if (channelCount == FCC_2 && (fromLeft != 1.f || fromRight != 1.f
+            || toLeft != 1.f || toRight != 1.f)) {
+        const float stepLeft = (toLeft - fromLeft) / frameCount;
+        const float stepRight = (toRight - fromRight) / frameCount;
+        for (size_t i = 0; i < frameCount; ++i) {
+            const float *in = src + i * srcChannelCount;
+            store(i * FCC_2, in[0] * (fromLeft + stepLeft * i));
+            store(i * FCC_2 + 1, in[1] * (fromRight + stepRight * i));
+        }
+    } else if (hapticChannelCount == 0) {
+        for (size_t i = 0; i < frameCount * channelCount; ++i) {
+            store(i, src[i]);
+        }
+    } else {
+        for (size_t i = 0; i < frameCount; ++i) {
+            for (uint32_t ch = 0; ch < channelCount; ++ch) {
+                store(i * channelCount + ch, src[i * srcChannelCount + ch]);
+            }
+        }
+    }
+
+    const size_t hapticOffset = frameCount * channelCount;
+    for (size_t i = 0; i < frameCount; ++i) {
+        for (uint32_t ch = 0; ch < hapticChannelCount; ++ch) {
+            store(hapticOffset + i * hapticChannelCount + ch,
+                    src[i * srcChannelCount + channelCount + ch]);
+        }
+    }
+}
+
+bool AudioFlinger::PlaybackThread::fuseSinkConversion_l()
+{
+    if (mEffectBufferValid || requireMonoBlend()
+            || mMixerBufferFormat != AUDIO_FORMAT_PCM_FLOAT
+            || (mFormat != AUDIO_FORMAT_PCM_16_BIT && mFormat != AUDIO_FORMAT_PCM_24_BIT_PACKED)) {
+        return false;
+    }
+    // The FastMixer applies the balance itself, otherwise it is only fused for stereo.
+    const bool applyBalance = !hasFastMixer() && (mMasterBalance.load() != 0.f
+            || mSinkBalanceLeft != 1.f || mSinkBalanceRight != 1.f);
+    if (applyBalance && mChannelMask != AUDIO_CHANNEL_OUT_STEREO) {
+        return false;
+    }
+    // Without balance or haptics memcpy_by_audio_format() is already a single pass.
+    return applyBalance || mHapticChannelCount > 0;
+}
+
+void AudioFlinger::PlaybackThread::writeFusedSinkBuffer_l()
+{
+    float toLeft = 1.f;
+    float toRight = 1.f;
+    if (!hasFastMixer()) {
+        mBalance.computeStereoBalance(mMasterBalance.load(), &toLeft, &toRight);
+    }
+    const float *src = static_cast<const float *>(mMixerBuffer);
+    if (mFormat == AUDIO_FORMAT_PCM_16_BIT) {
+        balanceAndConvertToSink(SinkStorePcm16{static_cast<int16_t *>(mSinkBuffer)},
+                src, mNormalFrameCount, mChannelCount, mHapticChannelCount,
+                mSinkBalanceLeft, mSinkBalanceRight, toLeft, toRight);
+    } else {
+        balanceAndConvertToSink(SinkStorePcm24Packed{static_cast<uint8_t *>(mSinkBuffer)},
+                src, mNormalFrameCount, mChannelCount, mHapticChannelCount,
+                mSinkBalanceLeft, mSinkBalanceRight, toLeft, toRight);
+    }
+    mSinkBalanceLeft = toLeft;
+    mSinkBalanceRight = toRight;
+}
+
 void AudioFlinger::PlaybackThread::removeTracks_l(const Vector< sp<Track> >& tracksToRemove)
 {
     for (const auto& track : tracksToRemove) {
@@ -4784,6 +4925,7 @@ AudioFlinger::MixerThread::MixerThread(const sp<AudioFlinger>& audioFlinger, Aud
             mSampleRate, mChannelMask, mChannelCount, mFormat, mFrameSize, mFrameCount,
             mNormalFrameCount);
     mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+    configureParallelMixing(mAudioMixer);
 
     if (type == DUPLICATING) {
         // The Duplicating thread uses the AudioMixer and delivers data to OutputTracks
@@ -5210,6 +5352,12 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
     });
     mTracks.clearDeletedTrackIds();
 
+    if (hasFastMixer()) {
+        mThreadMetrics.logFastThreadCycles(mFastMixerDumpState.mCycleHistogram,
+                FastThreadDumpState::kCycleHistogramBins,
+                mFastMixerDumpState.mUnderruns, mFastMixerDumpState.mOverruns);
+    }
+
     mixer_state mixerStatus = MIXER_IDLE;
     // find out which tracks need to be processed
     size_t count = mActiveTracks.size();
@@ -5436,21 +5584,20 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
                     // no acknowledgement required for newly active tracks
                 }
                 sp<AudioTrackServerProxy> proxy = track->mAudioTrackServerProxy;
-                float volume;
-                if (track->isPlaybackRestricted() || mStreamTypes[track->streamType()].mute) {
-                    volume = 0.f;
-                } else {
-                    volume = masterVolume * mStreamTypes[track->streamType()].volume;
-                }
+                const bool muted = track->isPlaybackRestricted()
+                        || mStreamTypes[track->streamType()].mute;
+                float volume = muted
+                        ? 0.f : masterVolume * mStreamTypes[track->streamType()].volume;
 
                 handleVoipVolume_l(&volume);
 
-                // cache the combined master volume and stream type volume for fast mixer; this
-                // lacks any synchronization or barrier so VolumeProvider may read a stale value
+                // pass the combined master volume and stream type volume to the fast mixer
+                // through its lock-free per track parameters, which does not need a push.
                 const float vh = track->getVolumeHandler()->getVolume(
                     proxy->framesReleased()).first;
                 volume *= vh;
-                track->mCachedVolume = volume;
+                mFastMixer->setTrackParams(j, volume, muted,
+                        track->getHapticPlaybackEnabled(), track->getHapticIntensity());
                 gain_minifloat_packed_t vlr = proxy->getVolumeLR();
                 float vlf = volume * float_from_gain(gain_minifloat_unpack_left(vlr));
                 float vrf = volume * float_from_gain(gain_minifloat_unpack_right(vlr));
@@ -5483,9 +5630,10 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
                 // Avoids a misleading display in dumpsys
                 track->mObservedUnderruns.mBitFields.mMostRecent = UNDERRUN_FULL;
             }
+            // haptic changes of active tracks are delivered by setTrackParams() above,
+            // keep the state consistent for a later reconfiguration without a push.
             if (fastTrack->mHapticPlaybackEnabled != track->getHapticPlaybackEnabled()) {
                 fastTrack->mHapticPlaybackEnabled = track->getHapticPlaybackEnabled();
-                didModify = true;
             }
             continue;
         }
@@ -6095,6 +6243,7 @@ bool AudioFlinger::MixerThread::checkForNewParameter_l(const String8& keyValuePa
             readOutputParameters_l();
             delete mAudioMixer;
             mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+            configureParallelMixing(mAudioMixer);
             for (const auto &track : mTracks) {
                 const int trackId = track->id();
                 status_t status = mAudioMixer->create(
@@ -7261,8 +7410,14 @@ void AudioFlinger::DuplicatingThread::threadLoop_sleepTime()
 
 ssize_t AudioFlinger::DuplicatingThread::threadLoop_write()
 {
+    // All output tracks share one wait time, so that a slow output does not hold back the
+    // others by more than that: once it is used up, the remaining outputs take what they have
+    // room for without waiting and queue the rest. The queued data is copied once, for all.
+    uint32_t waitTimeLeftMs = mWaitTimeMs;
+    OutputTrack::SharedBuffer sharedData;
     for (size_t i = 0; i < outputTracks.size(); i++) {
-        const ssize_t actualWritten = outputTracks[i]->write(mSinkBuffer, writeFrames);
+        const ssize_t actualWritten = outputTracks[i]->write(
+                mSinkBuffer, writeFrames, &waitTimeLeftMs, &sharedData);
 
         // Consider the first OutputTrack for timestamp and frame counting.
 
@@ -7312,7 +7467,7 @@ void AudioFlinger::DuplicatingThread::dumpInternals_l(int fd, const Vector<Strin
             } else {
                 ss << "null";
             }
-            ss << ")";
+            ss << ", dropped " << track->droppedFrames() << ")";
         }
     }
     ss << "\n";
@@ -7457,7 +7612,28 @@ AudioFlinger::SpatializerThread::SpatializerThread(const sp<AudioFlinger>& audio
 {
 }
 
+AudioFlinger::SpatializerThread::~SpatializerThread()
+{
+    if (mEffectChainWorker != nullptr) {
+        mEffectChainWorker->exit();
+    }
+}
+
 void AudioFlinger::SpatializerThread::onFirstRef() {
+    // Trades one period of latency on the spatialized path for running the spatializer
+    // concurrently with the mixer, on SoCs where the effect takes most of the period.
+    // The worker is set before the thread loop starts and is not changed afterwards.
+    if (property_get_bool("af.spatializer.pipeline", false /* default_value */)) {
+        sp<EffectChainWorker> worker = new EffectChainWorker();
+        if (worker->run("AudioSpatializerFx", ANDROID_PRIORITY_URGENT_AUDIO) != NO_ERROR) {
+            ALOGW("%s: cannot start the spatializer worker, spatializing on the mixer thread",
+                    __func__);
+        } else {
+            requestSpatializerPriority(getpid(), worker->getTid());
+            mEffectChainWorker = worker;
+        }
+    }
+
     PlaybackThread::onFirstRef();
 
     Mutex::Autolock _l(mLock);
@@ -7613,6 +7789,117 @@ void AudioFlinger::SpatializerThread::checkOutputStageEffects()
     }
 }
 
+void AudioFlinger::SpatializerThread::dumpInternals_l(int fd, const Vector<String16>& args)
+{
+    MixerThread::dumpInternals_l(fd, args);
+    if (mEffectChainWorker != nullptr) {
+        dprintf(fd, "  Spatializer pipeline overruns: %u\n", mEffectChainWorker->overruns());
+    }
+}
+
+void AudioFlinger::SpatializerThread::lockEffectChains_l(
+        Vector< sp<AudioFlinger::EffectChain> >& effectChains)
+{
+    effectChains = mEffectChains;
+    for (size_t i = 0; i < mEffectChains.size(); i++) {
+        if (mEffectChainWorker == nullptr
+                || mEffectChains[i]->sessionId() != AUDIO_SESSION_OUTPUT_STAGE) {
+            mEffectChains[i]->lock();
+        }
+    }
+}
+
+void AudioFlinger::SpatializerThread::unlockEffectChains(
+        const Vector< sp<AudioFlinger::EffectChain> >& effectChains)
+{
+    for (size_t i = 0; i < effectChains.size(); i++) {
+        if (mEffectChainWorker == nullptr
+                || effectChains[i]->sessionId() != AUDIO_SESSION_OUTPUT_STAGE) {
+            effectChains[i]->unlock();
+        }
+    }
+}
+
+void AudioFlinger::SpatializerThread::processEffectChain_l(const sp<EffectChain>& chain)
+{
+    if (mEffectChainWorker == nullptr || chain->sessionId() != AUDIO_SESSION_OUTPUT_STAGE) {
+        chain->process_l();
+        return;
+    }
+    // The OUTPUT_STAGE chain reads the multichannel mix in mEffectBuffer and accumulates
+    // the spatialized stereo output to mPostSpatializerBuffer, haptic channels excluded.
+    mEffectChainWorker->exchange(chain,
+            reinterpret_cast<const effect_buffer_t*>(mEffectBuffer),
+            mEffectBufferSize / sizeof(effect_buffer_t),
+            reinterpret_cast<effect_buffer_t*>(mPostSpatializerBuffer),
+            mPostSpatializerBufferSize / sizeof(effect_buffer_t),
+            mNormalFrameCount * mChannelCount);
+}
+
+AudioFlinger::SpatializerThread::EffectChainWorker::EffectChainWorker()
+    : Thread(false /* canCallJava */)
+{
+    sem_init(&mWakeSem, 0 /* pshared */, 0 /* value */);
+}
+
+AudioFlinger::SpatializerThread::EffectChainWorker::~EffectChainWorker()
+{
+    sem_destroy(&mWakeSem);
+}
+
+void AudioFlinger::SpatializerThread::EffectChainWorker::exit()
+{
+    requestExit();
+    sem_post(&mWakeSem);
+    requestExitAndWait();
+}
+
+void AudioFlinger::SpatializerThread::EffectChainWorker::exchange(const sp<EffectChain>& chain,
+        const effect_buffer_t *in, size_t inSamples, effect_buffer_t *out, size_t outSamples,
+        size_t accumulateSamples)
+{
+    const int state = mState.load(std::memory_order_acquire);
+    if (state == STATE_PENDING) {
+        // The worker is late, drop this period rather than waiting for it.
+        mOverruns.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (state == STATE_DONE && mOutBuffer.size() == outSamples) {
+#ifdef FLOAT_EFFECT_CHAIN
+        accumulate_float(out, mOutBuffer.data(), accumulateSamples);
+#else
+        accumulate_i16(out, mOutBuffer.data(), accumulateSamples);
+#endif
+    }
+    // Only resized when the thread buffers are reallocated.
+    mInBuffer.resize(inSamples);
+    mOutBuffer.resize(outSamples);
+    memcpy(mInBuffer.data(), in, inSamples * sizeof(effect_buffer_t));
+    mChain = chain;
+    mState.store(STATE_PENDING, std::memory_order_release);
+    sem_post(&mWakeSem);
+}
+
+bool AudioFlinger::SpatializerThread::EffectChainWorker::threadLoop()
+{
+    while (sem_wait(&mWakeSem) != 0 && errno == EINTR) {}
+    if (exitPending()) {
+        return false;
+    }
+    if (mState.load(std::memory_order_acquire) != STATE_PENDING) {
+        return true;
+    }
+    ATRACE_NAME("spatializerPipeline");
+    // The chain accumulates to its output buffer.
+    memset(mOutBuffer.data(), 0, mOutBuffer.size() * sizeof(effect_buffer_t));
+    mChain->lock();
+    mChain->setExternalData_l(mInBuffer.data(), mOutBuffer.data());
+    mChain->process_l();
+    mChain->unlock();
+    mState.store(STATE_DONE, std::memory_order_release);
+    return true;
+}
+
 void AudioFlinger::SpatializerThread::onRecommendedLatencyModeChanged(
         std::vector<audio_latency_mode_t> modes) {
     Mutex::Autolock _l(mLock);
@@ -7671,6 +7958,9 @@ AudioFlinger::RecordThread::RecordThread(const sp<AudioFlinger>& audioFlinger,
             (int64_t)(mIsMsdDevice ? AUDIO_DEVICE_IN_BUS // turn on by default for MSD
                                    : AUDIO_DEVICE_NONE));
 
+    // Check if clients with identical configuration may share the conversion of the input
+    mShareConversion = property_get_bool("af.record.share_conversion", false /* default_value */);
+
     // create an NBAIO source for the HAL input stream, and negotiate
     mInputSource = new AudioStreamInSource(input->stream);
     size_t numCounterOffers = 0;
@@ -7843,6 +8133,8 @@ reacquire_wakelock:
 
     // loop while there is work to do
     for (int64_t loopCount = 0;; ++loopCount) {  // loopCount used for statistics tracking
+        accountCpuUsage();
+
         Vector< sp<EffectChain> > effectChains;
 
         // activeTracks accumulates a copy of a subset of mActiveTracks
@@ -8016,6 +8308,9 @@ reacquire_wakelock:
 
         // Push a new fast capture state if fast capture is not already running, or cblk change
         if (mFastCapture != 0) {
+            mThreadMetrics.logFastThreadCycles(mFastCaptureDumpState.mCycleHistogram,
+                    FastThreadDumpState::kCycleHistogramBins,
+                    mFastCaptureDumpState.mUnderruns, mFastCaptureDumpState.mOverruns);
             FastCaptureStateQueue *sq = mFastCapture->sq();
             FastCaptureState *state = sq->begin();
             bool didModify = false;
@@ -8221,6 +8516,10 @@ reacquire_wakelock:
 
         size = activeTracks.size();
 
+        if (mShareConversion) {
+            prepareSharedConversion(activeTracks);
+        }
+
         // loop over each active track
         for (size_t i = 0; i < size; i++) {
             activeTrack = activeTracks[i];
@@ -8267,7 +8566,19 @@ reacquire_wakelock:
                         destinationFramesPossible(
                                 framesIn, mSampleRate, activeTrack->mSampleRate));
 
-                if (activeTrack->isDirect()) {
+                if (activeTrack->mActiveConversionLeader != nullptr) {
+                    // Copy the data already converted for a track with identical configuration.
+                    // The provider is synchronized to the leader after the loop.
+                    const RecordTrack *leader = activeTrack->mActiveConversionLeader;
+                    const size_t frameSize = activeTrack->frameSize();
+                    framesOut = min(framesOut,
+                            leader->mSharedFrameCount - activeTrack->mSharedFramesOffset);
+                    memcpy(activeTrack->mSink.raw,
+                            leader->mSharedFrames.data()
+                                    + activeTrack->mSharedFramesOffset * frameSize,
+                            framesOut * frameSize);
+                    activeTrack->mSharedFramesOffset += framesOut;
+                } else if (activeTrack->isDirect()) {
                     // No RecordBufferConverter used for direct streams. Pass
                     // straight from RecordThread buffer to RecordTrack buffer.
                     AudioBufferProvider::Buffer buffer;
@@ -8285,6 +8596,22 @@ reacquire_wakelock:
                         ALOGE("%s() cannot fill request, status: %d, frameCount: %zu",
                             __func__, status, buffer.frameCount);
                     }
+                } else if (activeTrack->mIsConversionLeader) {
+                    // Retain the converted data for the tracks sharing the conversion.
+                    // Convert into our own buffer, as the client may modify its buffer.
+                    const size_t frameSize = activeTrack->frameSize();
+                    const size_t offset = activeTrack->mSharedFrameCount * frameSize;
+                    activeTrack->mSharedFrames.resize(offset + framesOut * frameSize);
+                    framesOut = activeTrack->mRecordBufferConverter->convert(
+                            activeTrack->mSharedFrames.data() + offset,
+                            activeTrack->mResamplerBufferProvider,
+                            framesOut);
+                    memcpy(activeTrack->mSink.raw, activeTrack->mSharedFrames.data() + offset,
+                            framesOut * frameSize);
+                    activeTrack->mSharedFrameCount += framesOut;
+                    if (framesOut > 0) {
+                        activeTrack->mConverterFresh = false;
+                    }
                 } else {
                     // process frames from the RecordThread buffer provider to the RecordTrack
                     // buffer
@@ -8292,6 +8619,9 @@ reacquire_wakelock:
                             activeTrack->mSink.raw,
                             activeTrack->mResamplerBufferProvider,
                             framesOut);
+                    if (framesOut > 0) {
+                        activeTrack->mConverterFresh = false;
+                    }
                 }
 
                 if (framesOut > 0 && (overrun == OVERRUN_UNKNOWN)) {
@@ -8335,6 +8665,33 @@ reacquire_wakelock:
                 }
             }
 
+            if (activeTrack->mActiveConversionLeader != nullptr) {
+                const RecordTrack *leader = activeTrack->mActiveConversionLeader;
+                if (activeTrack->mSharedFramesOffset == leader->mSharedFrameCount) {
+                    activeTrack->mResamplerBufferProvider->setFront(
+                            leader->mResamplerBufferProvider->getFront());
+                } else if (activeTrack->mRecordBufferConverter->isStateless()) {
+                    // Consume only what was copied, one source frame per converted frame.
+                    // The track will share again when it has caught up with the leader.
+                    activeTrack->mResamplerBufferProvider->setFront(
+                            audio_utils::safe_add_overflow(
+                                    activeTrack->mResamplerBufferProvider->getFront(),
+                                    static_cast<int32_t>(activeTrack->mSharedFramesOffset)));
+                } else {
+                    // The source frames corresponding to the remaining resampled frames
+                    // are unknown, so drop them.
+                    activeTrack->mResamplerBufferProvider->setFront(
+                            leader->mResamplerBufferProvider->getFront());
+                    overrun = OVERRUN_TRUE;
+                }
+                // Don't follow a leader whose client doesn't keep up with the input.
+                if (leader->mResamplerBufferProvider->getFront() != mRsmpInRear) {
+                    ALOGV("%s: track %d stops sharing conversion", __func__, activeTrack->id());
+                    activeTrack->mRecordBufferConverter->reset();
+                    activeTrack->mConversionLeader.clear();
+                }
+            }
+
             switch (overrun) {
             case OVERRUN_TRUE:
                 // client isn't retrieving buffers fast enough
@@ -8750,6 +9107,7 @@ status_t AudioFlinger::RecordThread::start(RecordThread::RecordTrack* recordTrac
         if (!recordTrack->isDirect()) {
             // clear any converter state as new data will be discontinuous
             recordTrack->mRecordBufferConverter->reset();
+            recordTrack->mConverterFresh = true;
         }
         recordTrack->mState = TrackBase::STARTING_2;
         // signal thread to start
@@ -8972,6 +9330,7 @@ void AudioFlinger::RecordThread::dumpInternals_l(int fd, const Vector<String16>&
 
     dprintf(fd, "  Fast capture thread: %s\n", hasFastCapture() ? "yes" : "no");
     dprintf(fd, "  Fast track available: %s\n", mFastTrackAvail ? "yes" : "no");
+    dprintf(fd, "  Shared conversion: %s\n", mShareConversion ? "yes" : "no");
 
     // Make a non-atomic copy of fast capture dump state so it won't change underneath us
     // while we are dumping it.  It may be inconsistent, but it won't mutate!
@@ -9497,6 +9856,59 @@ void AudioFlinger::RecordThread::updateOutDevices(const DeviceDescriptorBaseVect
     }
 }
 
+void AudioFlinger::RecordThread::prepareSharedConversion(
+        const Vector< sp<RecordTrack> >& activeTracks)
+{
+    const size_t size = activeTracks.size();
+    for (size_t i = 0; i < size; i++) {
+        const sp<RecordTrack>& track = activeTracks[i];
+        track->mActiveConversionLeader = nullptr;
+        track->mIsConversionLeader = false;
+        track->mSharedFrameCount = 0;
+        track->mSharedFramesOffset = 0;
+        if (track->isFastTrack() || track->isDirect()) {
+            continue;
+        }
+
+        // A track may copy the data converted for a track processed before it, if it reads from
+        // the same position and if the conversions would produce the same result. For a
+        // resampler, this requires the same history: either the track always followed this
+        // leader, or it has not converted any data yet.
+        const bool stateless = track->mRecordBufferConverter->isStateless();
+        const sp<RecordTrack> previousLeader = track->mConversionLeader.promote();
+        RecordTrack *leader = nullptr;
+        for (size_t j = 0; j < i && track->mFramesToDrop == 0; j++) {
+            const sp<RecordTrack>& candidate = activeTracks[j];
+            if (candidate->isFastTrack() || candidate->isDirect()
+                    || candidate->mActiveConversionLeader != nullptr
+                    || candidate->mFramesToDrop != 0) {
+                continue;
+            }
+            if ((stateless || track->mConverterFresh || candidate == previousLeader)
+                    && candidate->mResamplerBufferProvider->getFront()
+                            == track->mResamplerBufferProvider->getFront()
+                    && candidate->mRecordBufferConverter->isEquivalentTo(
+                            *track->mRecordBufferConverter)) {
+                leader = candidate.get();
+                break;
+            }
+        }
+
+        if (leader != nullptr) {
+            leader->mIsConversionLeader = true;
+            track->mActiveConversionLeader = leader;
+            track->mConversionLeader = leader;
+            // Our own converter has missed the data converted by the leader.
+            track->mConverterFresh = false;
+        } else if (track->mConversionLeader.unsafe_get() != nullptr) {
+            ALOGV("%s: track %d stops sharing conversion", __func__, track->id());
+            // Our converter state is stale, clear it before converting on our own again.
+            track->mRecordBufferConverter->reset();
+            track->mConversionLeader.clear();
+        }
+    }
+}
+
 int32_t AudioFlinger::RecordThread::getOldestFront_l()
 {
     if (mTracks.size() == 0) {
@@ -10055,6 +10467,8 @@ bool AudioFlinger::MmapThread::threadLoop()
 
     while (!exitPending())
     {
+        accountCpuUsage();
+
         Vector< sp<EffectChain> > effectChains;
 
         { // under Thread lock
@@ -447,9 +447,9 @@ public:
                 // ThreadBase mutex before processing the mixer and effects. This guarantees the
                 // integrity of the chains during the process.
                 // Also sets the parameter 'effectChains' to current value of mEffectChains.
-                void lockEffectChains_l(Vector< sp<EffectChain> >& effectChains);
+    virtual     void lockEffectChains_l(Vector< sp<EffectChain> >& effectChains);
                 // unlock effect chains after process
-                void unlockEffectChains(const Vector< sp<EffectChain> >& effectChains);
+    virtual     void unlockEffectChains(const Vector< sp<EffectChain> >& effectChains);
                 // get a copy of mEffectChains vector
                 Vector< sp<EffectChain> > getEffectChains_l() const { return mEffectChains; };
                 // set audio mode to all effect chains
@@ -621,6 +621,14 @@ protected:
 
     virtual     void        dumpInternals_l(int fd __unused, const Vector<String16>& args __unused)
                             { }
+
+                // Called by threadLoop() once per loop iteration, on the thread itself.
+                void        accountCpuUsage() {
+                                if (mCpuAccounting.onCycle()) {
+                                    mThreadMetrics.logCpuUsage(mCpuAccounting.getPeriodCpuNs(),
+                                            mCpuAccounting.getPeriodWallNs());
+                                }
+                            }
     virtual     void        dumpTracks_l(int fd __unused, const Vector<String16>& args __unused) { }
 
 
@@ -633,6 +641,7 @@ protected:
 
                 const sp<AudioFlinger>  mAudioFlinger;
                 ThreadMetrics           mThreadMetrics;
+                ThreadCpuAccounting     mCpuAccounting{ThreadMetrics::kCpuUsagePeriodNs};
                 const bool              mIsOut;
 
                 // updated by PlaybackThread::readOutputParameters_l() or
@@ -907,6 +916,12 @@ protected:
                 // is safe to do so. That will drop the final ref count and destroy the tracks.
     virtual     mixer_state prepareTracks_l(Vector< sp<Track> > *tracksToRemove) = 0;
                 void        removeTracks_l(const Vector< sp<Track> >& tracksToRemove);
+
+                // Whether the mixer buffer can be written to the sink buffer by
+                // writeFusedSinkBuffer_l(), which applies the stereo balance, converts to the
+                // sink format and moves haptic channels in one pass over the buffer.
+                bool        fuseSinkConversion_l();
+                void        writeFusedSinkBuffer_l();
                 status_t    handleVoipVolume_l(float *volume);
 
     // StreamOutHalInterfaceCallback implementation
@@ -940,6 +955,12 @@ protected:
     virtual     void        checkOutputStageEffects() {}
     virtual     void        setHalLatencyMode_l() {}
 
+                // Processes one effect chain of the thread loop, with the chains locked.
+    virtual     void        processEffectChain_l(const sp<EffectChain>& chain);
+                // true if a chain is processed outside of the thread loop,
+                // which excludes EffectChain::processBatch_l().
+    virtual     bool        hasPipelinedEffectChain_l() const { return false; }
+
 
                 void        dumpInternals_l(int fd, const Vector<String16>& args) override;
                 void        dumpTracks_l(int fd, const Vector<String16>& args) override;
@@ -1097,6 +1118,7 @@ protected:
     size_t                          mNormalFrameCount;  // normal mixer and effects
 
     bool                            mThreadThrottle;     // throttle the thread processing
+    bool                            mBatchEffectProcessing; // EffectChain::processBatch_l()
     uint32_t                        mThreadThrottleTimeMs; // throttle time for MIXER threads
     uint32_t                        mThreadThrottleEndMs;  // notify once per throttling
     uint32_t                        mHalfBufferMs;       // half the buffer size in milliseconds
@@ -1318,6 +1340,10 @@ private:
     float                           mMasterVolume;
     std::atomic<float>              mMasterBalance{};
     audio_utils::Balance            mBalance;
+    // Stereo balance gains last applied to the sink buffer, ramped from by
+    // writeFusedSinkBuffer_l().
+    float                           mSinkBalanceLeft = 1.f;
+    float                           mSinkBalanceRight = 1.f;
     int                             mNumWrites;
     int                             mNumDelayedWrites;
     bool                            mInWrite;
@@ -1752,7 +1778,7 @@ public:
                            audio_io_handle_t id,
                            bool systemReady,
                            audio_config_base_t *mixerConfig);
-            ~SpatializerThread() override {}
+            ~SpatializerThread() override;
 
             bool hasFastMixer() const override { return false; }
 
@@ -1773,7 +1799,55 @@ protected:
             void onHalLatencyModesChanged_l() override;
             void setHalLatencyMode_l() override;
 
+            void dumpInternals_l(int fd, const Vector<String16>& args) override;
+
+            // With af.spatializer.pipeline, the AUDIO_SESSION_OUTPUT_STAGE chain holding the
+            // spatializer is not locked with the other chains and is processed by
+            // mEffectChainWorker instead.
+            void lockEffectChains_l(Vector< sp<EffectChain> >& effectChains) override;
+            void unlockEffectChains(const Vector< sp<EffectChain> >& effectChains) override;
+            void processEffectChain_l(const sp<EffectChain>& chain) override;
+            bool hasPipelinedEffectChain_l() const override {
+                return mEffectChainWorker != nullptr;
+            }
+
 private:
+            // Processes an effect chain on its own thread, one period behind the mixer.
+            // Each period the mixer thread collects the output of the previous period and
+            // hands over the next input with exchange(). The buffers are owned by the side
+            // indicated by mState, so the handoff itself takes no lock. The worker locks the
+            // chain while processing it, the mixer thread never waits for the worker:
+            // when the worker has not finished, the period is dropped and counted as an overrun.
+            class EffectChainWorker : public Thread {
+            public:
+                EffectChainWorker();
+                ~EffectChainWorker() override;
+
+                // Called by the mixer thread once per period. Accumulates the first
+                // 'accumulateSamples' of the previous output to 'out' and starts processing 'in'.
+                // The sizes are those of the thread buffers the chain buffers mirror.
+                void exchange(const sp<EffectChain>& chain,
+                        const effect_buffer_t *in, size_t inSamples,
+                        effect_buffer_t *out, size_t outSamples, size_t accumulateSamples);
+                void exit();
+                uint32_t overruns() const { return mOverruns.load(std::memory_order_relaxed); }
+
+            private:
+                bool threadLoop() override;
+
+                enum State {
+                    STATE_IDLE,     // owned by the mixer thread, no output
+                    STATE_PENDING,  // owned by the worker
+                    STATE_DONE,     // owned by the mixer thread, output available
+                };
+                std::atomic<int> mState{STATE_IDLE};
+                sem_t mWakeSem;
+                sp<EffectChain> mChain;
+                std::vector<effect_buffer_t> mInBuffer;
+                std::vector<effect_buffer_t> mOutBuffer;
+                std::atomic<uint32_t> mOverruns{0};
+            };
+
             void updateHalSupportedLatencyModes_l();
 
             // Support low latency mode by default as unless explicitly indicated by the audio HAL
@@ -1786,6 +1860,7 @@ private:
             audio_latency_mode_t mRequestedLatencyMode = AUDIO_LATENCY_MODE_FREE;
 
             sp<EffectHandle> mFinalDownMixer;
+            sp<EffectChainWorker> mEffectChainWorker;
 };
 
 // record thread
@@ -1990,6 +2065,10 @@ private:
             int32_t getOldestFront_l();
             void    updateFronts_l(int32_t offset);
 
+            // Find the active tracks which can copy the converted data of a track processed before
+            // them in the current read, instead of converting the same data again.
+            void    prepareSharedConversion(const Vector< sp<RecordTrack> >& activeTracks);
+
             AudioStreamIn                       *mInput;
             Source                              *mSource;
             SortedVector < sp<RecordTrack> >    mTracks;
@@ -2008,6 +2087,11 @@ private:
             // rolling index that is never cleared
             int32_t                             mRsmpInRear;    // last filled frame + 1
 
+            // Share the conversion of clients with identical configuration, set once in the ctor.
+            // A client with resampling that cannot take all of the shared data overruns right
+            // away, rather than when mRsmpInBuffer is full.
+            bool                                mShareConversion = false;
+
             // For dumpsys
             const sp<MemoryDealer>              mReadOnlyHeap;
 
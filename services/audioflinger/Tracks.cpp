@@ -162,7 +162,7 @@ AudioFlinger::ThreadBase::TrackBase::TrackBase(
     }
 
     if (client != 0) {
-        mCblkMemory = client->heap()->allocate(size);
+        mCblkMemory = client->allocateTrackMemory(size);
         if (mCblkMemory == 0 ||
                 (mCblk = static_cast<audio_track_cblk_t *>(mCblkMemory->unsecurePointer())) == NULL) {
             ALOGE("%s(%d): not enough memory for AudioTrack size=%zu", __func__, mId, size);
@@ -267,6 +267,9 @@ AudioFlinger::ThreadBase::TrackBase::~TrackBase()
     // delete the proxy before deleting the shared memory it refers to, to avoid dangling reference
     mServerProxy.clear();
     releaseCblk();
+    if (mClient != 0 && mCblkMemory != 0) {
+        mClient->releaseTrackMemory(std::move(mCblkMemory));
+    }
     mCblkMemory.clear();    // free the shared memory before releasing the heap it belongs to
     if (mClient != 0) {
         // Client destructor must run with AudioFlinger client mutex locked
@@ -659,7 +662,6 @@ AudioFlinger::PlaybackThread::Track::Track(
         streamType)),
     // mSinkTimestamp
     mFastIndex(-1),
-    mCachedVolume(1.0),
     /* The track might not play immediately after being active, similarly as if its volume was 0.
      * When the track starts playing, its volume will be computed. */
     mFinalVolume(0.f),
@@ -1646,11 +1648,8 @@ gain_minifloat_packed_t AudioFlinger::PlaybackThread::Track::getVolumeLR()
     if (vr > GAIN_FLOAT_UNITY) {
         vr = GAIN_FLOAT_UNITY;
     }
-    // now apply the cached master volume and stream type volume;
-    // this is trusted but lacks any synchronization or barrier so may be stale
-    float v = mCachedVolume;
-    vl *= v;
-    vr *= v;
+    // the master volume and stream type volume are applied by FastMixer,
+    // see FastMixer::setTrackParams().
     // re-combine into packed minifloat
     vlr = gain_minifloat_pack(gain_from_float(vl), gain_from_float(vr));
     // FIXME look at mute, pause, and stop flags
@@ -2015,102 +2014,109 @@ void AudioFlinger::PlaybackThread::OutputTrack::stop()
     mActive = false;
 }
 
-ssize_t AudioFlinger::PlaybackThread::OutputTrack::write(void* data, uint32_t frames)
+ssize_t AudioFlinger::PlaybackThread::OutputTrack::write(void* data, uint32_t frames,
+        uint32_t *waitTimeLeftMs, SharedBuffer *sharedData)
 {
-    Buffer *pInBuffer;
-    Buffer inBuffer;
-    inBuffer.frameCount = frames;
-    inBuffer.raw = data;
-
-    uint32_t waitTimeLeftMs = mSourceThread->waitTimeMs();
+    const int8_t *inData = (const int8_t *)data;
+    size_t inFrames = frames;
+    bool restarted = false;
 
     if (!mActive && frames != 0) {
         (void) start();
     }
 
-    while (waitTimeLeftMs) {
+    while (true) {
         // First write pending buffers, then new data
-        if (mBufferQueue.size()) {
-            pInBuffer = mBufferQueue.itemAt(0);
+        const int8_t *src;
+        size_t srcFrames;
+        if (!mBufferQueue.empty()) {
+            src = mBufferQueue.front().data->data() + mBufferQueue.front().offset;
+            srcFrames = mBufferQueue.front().frameCount;
         } else {
-            pInBuffer = &inBuffer;
+            src = inData;
+            srcFrames = inFrames;
         }
 
-        if (pInBuffer->frameCount == 0) {
+        if (srcFrames == 0) {
             break;
         }
 
         if (mOutBuffer.frameCount == 0) {
-            mOutBuffer.frameCount = pInBuffer->frameCount;
+            mOutBuffer.frameCount = srcFrames;
             nsecs_t startTime = systemTime();
-            status_t status = obtainBuffer(&mOutBuffer, waitTimeLeftMs);
+            // once the wait time is used up, this only takes the room there is
+            status_t status = obtainBuffer(&mOutBuffer, *waitTimeLeftMs);
             if (status != NO_ERROR && status != NOT_ENOUGH_DATA) {
                 ALOGV("%s(%d): thread %d no more output buffers; status %d",
                         __func__, mId,
                         (int)mThreadIoHandle, status);
+                mOutBuffer.frameCount = 0;
                 break;
             }
             uint32_t waitTimeMs = (uint32_t)ns2ms(systemTime() - startTime);
-            if (waitTimeLeftMs >= waitTimeMs) {
-                waitTimeLeftMs -= waitTimeMs;
+            if (*waitTimeLeftMs >= waitTimeMs) {
+                *waitTimeLeftMs -= waitTimeMs;
             } else {
-                waitTimeLeftMs = 0;
+                *waitTimeLeftMs = 0;
             }
             if (status == NOT_ENOUGH_DATA) {
+                mOutBuffer.frameCount = 0;
+                if (restarted) {
+                    break;
+                }
                 restartIfDisabled();
+                restarted = true;
                 continue;
             }
         }
 
-        uint32_t outFrames = pInBuffer->frameCount > mOutBuffer.frameCount ? mOutBuffer.frameCount :
-                pInBuffer->frameCount;
-        memcpy(mOutBuffer.raw, pInBuffer->raw, outFrames * mFrameSize);
+        size_t outFrames = std::min(srcFrames, mOutBuffer.frameCount);
+        memcpy(mOutBuffer.raw, src, outFrames * mFrameSize);
         Proxy::Buffer buf;
         buf.mFrameCount = outFrames;
         buf.mRaw = NULL;
         mClientProxy->releaseBuffer(&buf);
         restartIfDisabled();
-        pInBuffer->frameCount -= outFrames;
-        pInBuffer->raw = (int8_t *)pInBuffer->raw + outFrames * mFrameSize;
         mOutBuffer.frameCount -= outFrames;
         mOutBuffer.raw = (int8_t *)mOutBuffer.raw + outFrames * mFrameSize;
 
-        if (pInBuffer->frameCount == 0) {
-            if (mBufferQueue.size()) {
-                mBufferQueue.removeAt(0);
-                free(pInBuffer->mBuffer);
-                if (pInBuffer != &inBuffer) {
-                    delete pInBuffer;
-                }
+        if (!mBufferQueue.empty()) {
+            PendingBuffer &pending = mBufferQueue.front();
+            pending.offset += outFrames * mFrameSize;
+            pending.frameCount -= outFrames;
+            if (pending.frameCount == 0) {
+                mBufferQueue.pop_front();
                 ALOGV("%s(%d): thread %d released overflow buffer %zu",
                         __func__, mId,
                         (int)mThreadIoHandle, mBufferQueue.size());
-            } else {
-                break;
             }
+        } else {
+            inData += outFrames * mFrameSize;
+            inFrames -= outFrames;
         }
     }
 
-    // If we could not write all frames, allocate a buffer and queue it for next time.
-    if (inBuffer.frameCount) {
+    // If we could not write all frames, queue them for next time.
+    if (inFrames) {
         sp<ThreadBase> thread = mThread.promote();
         if (thread != 0 && !thread->standby()) {
-            if (mBufferQueue.size() < kMaxOverFlowBuffers) {
-                pInBuffer = new Buffer;
-                pInBuffer->mBuffer = malloc(inBuffer.frameCount * mFrameSize);
-                pInBuffer->frameCount = inBuffer.frameCount;
-                pInBuffer->raw = pInBuffer->mBuffer;
-                memcpy(pInBuffer->raw, inBuffer.raw, inBuffer.frameCount * mFrameSize);
-                mBufferQueue.add(pInBuffer);
-                ALOGV("%s(%d): thread %d adding overflow buffer %zu", __func__, mId,
-                        (int)mThreadIoHandle, mBufferQueue.size());
-                // audio data is consumed (stored locally); set frameCount to 0.
-                inBuffer.frameCount = 0;
-            } else {
-                ALOGW("%s(%d): thread %d no more overflow buffers",
-                        __func__, mId, (int)mThreadIoHandle);
-                // TODO: return error for this.
+            if (*sharedData == nullptr) {
+                const int8_t *begin = (const int8_t *)data;
+                *sharedData = std::make_shared<const std::vector<uint8_t>>(
+                        begin, begin + frames * mFrameSize);
             }
+            if (mBufferQueue.size() >= kMaxOverFlowBuffers) {
+                const size_t dropped = mBufferQueue.front().frameCount;
+                mBufferQueue.pop_front();
+                mDroppedFrames += dropped;
+                ALOGW("%s(%d): thread %d overflow, dropped %zu frames",
+                        __func__, mId, (int)mThreadIoHandle, dropped);
+            }
+            mBufferQueue.push_back({*sharedData, (frames - inFrames) * mFrameSize, inFrames});
+            ALOGV("%s(%d): thread %d adding overflow buffer %zu", __func__, mId,
+                    (int)mThreadIoHandle, mBufferQueue.size());
+            // audio data is consumed (stored locally); set frameCount to 0.
+            inFrames = 0;
         }
     }
 
@@ -2120,7 +2126,7 @@ ssize_t AudioFlinger::PlaybackThread::OutputTrack::write(void* data, uint32_t fr
         stop();
     }
 
-    return frames - inBuffer.frameCount;  // number of frames consumed.
+    return frames - inFrames;  // number of frames consumed.
 }
 
 void AudioFlinger::PlaybackThread::OutputTrack::copyMetadataTo(MetadataInserter& backInserter) const
@@ -2154,13 +2160,6 @@ status_t AudioFlinger::PlaybackThread::OutputTrack::obtainBuffer(
 
 void AudioFlinger::PlaybackThread::OutputTrack::clearBufferQueue()
 {
-    size_t size = mBufferQueue.size();
-
-    for (size_t i = 0; i < size; i++) {
-        Buffer *pBuffer = mBufferQueue.itemAt(i);
-        free(pBuffer->mBuffer);
-        delete pBuffer;
-    }
     mBufferQueue.clear();
 }
 
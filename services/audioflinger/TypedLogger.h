@@ -127,6 +127,11 @@ constexpr uint64_t hash(const char (&file)[n], uint32_t line) {
 #define LOG_WORK_TIME(ns) do { NBLog::Writer *x = tlNBLogWriter; if (x != nullptr) \
         x->log<NBLog::EVENT_WORK_TIME>(ns); } while (0)
 
+// Record the thread CPU time in nanoseconds during the cycle of the last LOG_WORK_TIME.
+// Parameter ns should be of type uint32_t.
+#define LOG_CPU_TIME(ns) do { NBLog::Writer *x = tlNBLogWriter; if (x != nullptr) \
+        x->log<NBLog::EVENT_CPU_TIME>(ns); } while (0)
+
 namespace android {
 extern "C" {
 // TODO consider adding a thread_local NBLog::Writer tlStubNBLogWriter and then
@@ -407,6 +407,10 @@ public:
     // retrieves the list of available direct audio profiles for the given audio attributes
     virtual status_t getDirectProfilesForAttributes(const audio_attributes_t* attr,
                                                     AudioProfileVector& audioProfiles) = 0;
+
+    // applies the routing updates coalesced since the last call, requested with
+    // AudioPolicyClientInterface::scheduleDeferredRoutingUpdate()
+    virtual void onDeferredRoutingUpdate() = 0;
 };
 
 // Audio Policy client Interface
@@ -533,6 +537,10 @@ public:
 
     virtual void onRoutingUpdated() = 0;
 
+    // Requests a call to AudioPolicyInterface::onDeferredRoutingUpdate() after the
+    // specified delay. Used to coalesce the output routing updates of bursts of routing events.
+    virtual void scheduleDeferredRoutingUpdate(int delayMs) = 0;
+
     // Used to notify AudioService that an error was encountering when reading
     // the volume ranges, and that they should be re-initialized
     virtual void onVolumeRangeInitRequest() = 0;
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <android-base/file.h>
+#include <cutils/properties.h>
+#include <utils/Log.h>
+
+namespace android {
+
+/**
+ * Binary cache of a parsed configuration file, so that audioserver restarts can skip the
+ * xml parse. The cache records the size and modification time of every file that went into
+ * it (the configuration file and its XIncludes) and is ignored as soon as one of them changes,
+ * or when the build changes, as an update may change how the same files are parsed.
+ * The payload itself is opaque here; each parser versions its own layout.
+ */
+class ConfigCache
+{
+public:
+    /**
+     * @param kind name of the configuration, distinguishes caches of different parsers
+     * @param version layout version of the payload, bumped whenever the layout changes
+     * @param configFile the configuration file the cache stands for
+     */
+    ConfigCache(const char *kind, uint32_t version, const std::string &configFile)
+        : mVersion(version)
+    {
+        char dir[PROPERTY_VALUE_MAX];
+        property_get("audio.policy.config_cache_dir", dir, "/data/misc/audioserver");
+        if (dir[0] == '\0') {
+            return;  // disabled
+        }
+        std::string name = configFile;
+        for (char &c : name) {
+            if (c == '/') c = '_';
+        }
+        mCacheFile = std::string(dir) + "/" + kind + name + ".cache";
+        char build[PROPERTY_VALUE_MAX];
+        property_get("ro.build.fingerprint", build, "");
+        mBuild = build;
+        addSourceFile(configFile);
+    }
+
+    bool isEnabled() const { return !mCacheFile.empty(); }
+
+    /** Adds a file the parsed configuration depends on, e.g. an XInclude. */
+    void addSourceFile(const std::string &path)
+    {
+        mSources.push_back({path, getStamp(path)});
+    }
+
+    /**
+     * Reads the cached payload.
+     * @return true if the cache exists and all the files it was built from are unchanged.
+     */
+    bool load(std::string *payload) const
+    {
+        std::string content;
+        if (!isEnabled() || !base::ReadFileToString(mCacheFile, &content)) {
+            return false;
+        }
+        size_t pos = 0;
+        uint32_t magic = 0, version = 0, nSources = 0;
+        std::string build;
+        if (!read(content, &pos, &magic) || magic != kMagic
+                || !read(content, &pos, &version) || version != mVersion
+                || !read(content, &pos, &build) || build != mBuild
+                || !read(content, &pos, &nSources)) {
+            ALOGW("%s: ignoring incompatible cache %s", __func__, mCacheFile.c_str());
+            return false;
+        }
+        for (uint32_t i = 0; i < nSources; ++i) {
+            std::string path;
+            Stamp stamp;
+            if (!read(content, &pos, &path) || !read(content, &pos, &stamp)) {
+                return false;
+            }
+            if (stamp != getStamp(path)) {
+                ALOGI("%s: cache %s is out of date, %s changed",
+                        __func__, mCacheFile.c_str(), path.c_str());
+                return false;
+            }
+        }
+        uint32_t checksum = 0;
+        if (!read(content, &pos, &checksum) || !read(content, &pos, payload)
+                || pos != content.size() || checksum != getChecksum(*payload)) {
+            ALOGW("%s: cache %s is corrupt", __func__, mCacheFile.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /** Replaces the cache with payload. Failures only cost the next start a parse. */
+    void store(const std::string &payload) const
+    {
+        if (!isEnabled()) {
+            return;
+        }
+        for (const auto &source : mSources) {
+            if (source.second == Stamp{}) {
+                return;  // cannot tell whether it changes, so do not cache it
+            }
+        }
+        std::string content;
+        write(&content, kMagic);
+        write(&content, mVersion);
+        write(&content, mBuild);
+        write(&content, (uint32_t)mSources.size());
+        for (const auto &source : mSources) {
+            write(&content, source.first);
+            write(&content, source.second);
+        }
+        write(&content, getChecksum(payload));
+        write(&content, payload);
+
+        // write it aside and rename into place, so a crash never leaves a partial cache
+        std::string temp = mCacheFile + ".tmp";
+        if (!base::WriteStringToFile(content, temp, 0600, getuid(), getgid())
+                || rename(temp.c_str(), mCacheFile.c_str()) != 0) {
+            ALOGW("%s: failed to write cache %s", __func__, mCacheFile.c_str());
+            unlink(temp.c_str());
+            return;
+        }
+        ALOGV("%s: stored %zu bytes in %s", __func__, payload.size(), mCacheFile.c_str());
+    }
+
+private:
+    static constexpr uint32_t kMagic = 0x41504343;  // 'APCC'
+
+    struct Stamp {
+        int64_t size = 0;
+        int64_t mtimeSec = 0;
+        int64_t mtimeNsec = 0;
+        bool operator==(const Stamp &other) const {
+            return size == other.size && mtimeSec == other.mtimeSec
+                    && mtimeNsec == other.mtimeNsec;
+        }
+        bool operator!=(const Stamp &other) const { return !(*this == other); }
+    };
+
+    static Stamp getStamp(const std::string &path)
+    {
+        struct stat fileStat;
+        if (stat(path.c_str(), &fileStat) != 0) {
+            return {};
+        }
+        return {fileStat.st_size, fileStat.st_mtim.tv_sec, fileStat.st_mtim.tv_nsec};
+    }
+
+    static uint32_t getChecksum(const std::string &data)
+    {
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : data) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        return hash;
+    }
+
+    template <typename T>
+    static void write(std::string *content, const T &value)
+    {
+        content->append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    static void write(std::string *content, const std::string &value)
+    {
+        write(content, (uint32_t)value.size());
+        content->append(value);
+    }
+    template <typename T>
+    static bool read(const std::string &content, size_t *pos, T *value)
+    {
+        if (content.size() - *pos < sizeof(*value)) {
+            return false;
+        }
+        memcpy(value, content.data() + *pos, sizeof(*value));
+        *pos += sizeof(*value);
+        return true;
+    }
+    static bool read(const std::string &content, size_t *pos, std::string *value)
+    {
+        uint32_t size = 0;
+        if (!read(content, pos, &size) || content.size() - *pos < size) {
+            return false;
+        }
+        value->assign(content, *pos, size);
+        *pos += size;
+        return true;
+    }
+
+    const uint32_t mVersion;
+    std::string mBuild;
+    std::string mCacheFile;
+    std::vector<std::pair<std::string, Stamp>> mSources;
+};
+
+} // namespace android
@@ -284,6 +284,20 @@ protected:
 private:
     void refreshTypes();
     void refreshAudioProfiles();
+
+    // Devices are sorted by type first (see do_compare()) and a device never changes type,
+    // so the devices of one type are always the contiguous range [*first, *last).
+    void getTypeRange(audio_devices_t type, size_t *first, size_t *last) const;
+
+    // Adds a device taken from another DeviceVector that is already known not to be in this
+    // one, skipping the duplicate check and the refresh of the cached types and profiles.
+    // Used to build subsets; call refresh() once all devices are added.
+    void addUnique(const sp<DeviceDescriptor>& item) { SortedVector::add(item); }
+    void refresh()
+    {
+        refreshTypes();
+        refreshAudioProfiles();
+    }
     DeviceTypeSet mDeviceTypes;
     AudioProfileVector mSupportedProfiles;
 };
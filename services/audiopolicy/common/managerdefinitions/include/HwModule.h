@@ -24,6 +24,7 @@
 #include <utils/Vector.h>
 #include <system/audio.h>
 #include <cutils/config_utils.h>
+#include <map>
 #include <string>
 
 namespace android {
@@ -65,7 +66,7 @@ public:
     {
         return mDynamicDevices.remove(device) >= 0;
     }
-    DeviceVector getDynamicDevices() const { return mDynamicDevices; }
+    const DeviceVector &getDynamicDevices() const { return mDynamicDevices; }
 
     const InputProfileCollection &getInputProfiles() const { return mInputProfiles; }
     const OutputProfileCollection &getOutputProfiles() const { return mOutputProfiles; }
@@ -121,12 +122,15 @@ public:
 
 private:
     void refreshSupportedDevices();
+    sp<DeviceDescriptor> getDeclaredDeviceFromTagName(const std::string &tagName) const;
 
     const String8 mName; // base name of the audio HW module (primary, a2dp ...)
     audio_module_handle_t mHandle;
     InputProfileCollection mInputProfiles;  // input profiles exposed by this module
     uint32_t mHalVersion; // audio HAL API version
     DeviceVector mDeclaredDevices; // devices declared in audio_policy configuration file.
+    // mDeclaredDevices by tag name, for resolving routes.
+    std::map<std::string, sp<DeviceDescriptor>> mDeclaredDevicesByTagName;
     DeviceVector mDynamicDevices; /**< devices that can be added/removed at runtime (e.g. rsbumix)*/
     AudioRouteVector mRoutes;
     PolicyAudioPortVector mPorts;
@@ -17,6 +17,7 @@
 #define LOG_TAG "APM::Devices"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <set>
 
 #include <android-base/stringprintf.h>
@@ -211,10 +212,28 @@ void DeviceVector::refreshAudioProfiles() {
     }
 }
 
+void DeviceVector::getTypeRange(audio_devices_t type, size_t *first, size_t *last) const
+{
+    auto typeLess = [](const sp<DeviceDescriptor>& device, audio_devices_t t) {
+        return device->type() < t;
+    };
+    auto lessType = [](audio_devices_t t, const sp<DeviceDescriptor>& device) {
+        return t < device->type();
+    };
+    *first = std::lower_bound(begin(), end(), type, typeLess) - begin();
+    *last = std::upper_bound(begin() + *first, end(), type, lessType) - begin();
+}
+
 ssize_t DeviceVector::indexOf(const sp<DeviceDescriptor>& item) const
 {
-    for (size_t i = 0; i < size(); i++) {
-        if (itemAt(i)->equals(item)) { // item may be null sp<>, i.e. AUDIO_DEVICE_NONE
+    if (item == nullptr) { // i.e. AUDIO_DEVICE_NONE
+        return -1;
+    }
+    // equal devices have the same type
+    size_t first, last;
+    getTypeRange(item->type(), &first, &last);
+    for (size_t i = first; i < last; i++) {
+        if (itemAt(i)->equals(item)) {
             return i;
         }
     }
@@ -300,9 +319,10 @@ DeviceVector DeviceVector::getDevicesFromHwModule(audio_module_handle_t moduleHa
     DeviceVector devices;
     for (const auto& device : *this) {
         if (device->getModuleHandle() == moduleHandle) {
-            devices.add(device);
+            devices.addUnique(device);
         }
     }
+    devices.refresh();
     return devices;
 }
 
@@ -310,18 +330,18 @@ sp<DeviceDescriptor> DeviceVector::getDevice(audio_devices_t type, const String8
                                              audio_format_t format) const
 {
     sp<DeviceDescriptor> device;
-    for (size_t i = 0; i < size(); i++) {
-        if (itemAt(i)->type() == type) {
-            // If format is specified, match it and ignore address
-            // Otherwise if address is specified match it
-            // Otherwise always match
-            if (((address == "" || (itemAt(i)->address().compare(address.c_str()) == 0)) &&
-                 format == AUDIO_FORMAT_DEFAULT) ||
-                (itemAt(i)->supportsFormat(format) && format != AUDIO_FORMAT_DEFAULT)) {
-                device = itemAt(i);
-                if (itemAt(i)->address().compare(address.c_str()) == 0) {
-                    break;
-                }
+    size_t first, last;
+    getTypeRange(type, &first, &last);
+    for (size_t i = first; i < last; i++) {
+        // If format is specified, match it and ignore address
+        // Otherwise if address is specified match it
+        // Otherwise always match
+        if (((address == "" || (itemAt(i)->address().compare(address.c_str()) == 0)) &&
+             format == AUDIO_FORMAT_DEFAULT) ||
+            (itemAt(i)->supportsFormat(format) && format != AUDIO_FORMAT_DEFAULT)) {
+            device = itemAt(i);
+            if (itemAt(i)->address().compare(address.c_str()) == 0) {
+                break;
             }
         }
     }
@@ -348,13 +368,16 @@ DeviceVector DeviceVector::getDevicesFromTypes(const DeviceTypeSet& types) const
     if (types.empty()) {
         return devices;
     }
-    for (size_t i = 0; i < size(); i++) {
-        if (types.count(itemAt(i)->type()) != 0) {
-            devices.add(itemAt(i));
+    for (auto type : types) {
+        size_t first, last;
+        getTypeRange(type, &first, &last);
+        for (size_t i = first; i < last; i++) {
+            devices.addUnique(itemAt(i));
             ALOGV("DeviceVector::%s() for type %08x found %p",
                     __func__, itemAt(i)->type(), itemAt(i).get());
         }
     }
+    devices.refresh();
     return devices;
 }
 
@@ -477,9 +500,10 @@ DeviceVector DeviceVector::filter(const DeviceVector &devices) const
     DeviceVector filteredDevices;
     for (const auto &device : *this) {
         if (devices.contains(device)) {
-            filteredDevices.add(device);
+            filteredDevices.addUnique(device);
         }
     }
+    filteredDevices.refresh();
     return filteredDevices;
 }
 
@@ -500,8 +524,9 @@ DeviceVector DeviceVector::filterForEngine() const
         if (audio_is_remote_submix_device(device->type()) && device->address() != "0") {
             continue;
         }
-        filteredDevices.add(device);
+        filteredDevices.addUnique(device);
     }
+    filteredDevices.refresh();
     return filteredDevices;
 }
 
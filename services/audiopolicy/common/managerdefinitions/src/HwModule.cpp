@@ -46,8 +46,7 @@ HwModule::~HwModule()
 std::string HwModule::getTagForDevice(audio_devices_t device, const String8 &address,
                                           audio_format_t codec)
 {
-    DeviceVector declaredDevices = getDeclaredDevices();
-    sp<DeviceDescriptor> deviceDesc = declaredDevices.getDevice(device, address, codec);
+    sp<DeviceDescriptor> deviceDesc = mDeclaredDevices.getDevice(device, address, codec);
     return deviceDesc ? deviceDesc->getTagName() : std::string{};
 }
 
@@ -158,16 +157,25 @@ status_t HwModule::removeInputProfile(const std::string& name)
 void HwModule::setDeclaredDevices(const DeviceVector &devices)
 {
     mDeclaredDevices = devices;
+    mDeclaredDevicesByTagName.clear();
     for (size_t i = 0; i < devices.size(); i++) {
         mPorts.add(devices[i]);
+        // like DeviceVector::getDeviceFromTagName(), the first device wins
+        mDeclaredDevicesByTagName.emplace(devices[i]->getTagName(), devices[i]);
     }
 }
 
+sp<DeviceDescriptor> HwModule::getDeclaredDeviceFromTagName(const std::string &tagName) const
+{
+    auto it = mDeclaredDevicesByTagName.find(tagName);
+    return it != mDeclaredDevicesByTagName.end() ? it->second : nullptr;
+}
+
 sp<DeviceDescriptor> HwModule::getRouteSinkDevice(const sp<AudioRoute> &route) const
 {
     sp<DeviceDescriptor> sinkDevice = 0;
     if (route->getSink()->asAudioPort()->getType() == AUDIO_PORT_TYPE_DEVICE) {
-        sinkDevice = mDeclaredDevices.getDeviceFromTagName(route->getSink()->getTagName());
+        sinkDevice = getDeclaredDeviceFromTagName(route->getSink()->getTagName());
     }
     return sinkDevice;
 }
@@ -177,7 +185,7 @@ DeviceVector HwModule::getRouteSourceDevices(const sp<AudioRoute> &route) const
     DeviceVector sourceDevices;
     for (const auto& source : route->getSources()) {
         if (source->asAudioPort()->getType() == AUDIO_PORT_TYPE_DEVICE) {
-            sourceDevices.add(mDeclaredDevices.getDeviceFromTagName(source->getTagName()));
+            sourceDevices.add(getDeclaredDeviceFromTagName(source->getTagName()));
         }
     }
     return sourceDevices;
@@ -293,9 +301,8 @@ sp<HwModule> HwModuleCollection::getModuleForDeviceType(audio_devices_t type,
         for (const auto& profile : profiles) {
             if (profile->supportsDeviceTypes({type})) {
                 if (encodedFormat != AUDIO_FORMAT_DEFAULT) {
-                    DeviceVector declaredDevices = module->getDeclaredDevices();
-                    sp <DeviceDescriptor> deviceDesc =
-                            declaredDevices.getDevice(type, String8(), encodedFormat);
+                    sp <DeviceDescriptor> deviceDesc = module->getDeclaredDevices().getDevice(
+                            type, String8(), encodedFormat);
                     if (deviceDesc) {
                         if (tagName != nullptr) {
                             *tagName = deviceDesc->getTagName();
@@ -345,7 +352,7 @@ sp<DeviceDescriptor> HwModuleCollection::getDeviceDescriptor(const audio_devices
 
     for (const auto& hwModule : *this) {
         if (!allowToCreate) {
-            auto dynamicDevices = hwModule->getDynamicDevices();
+            const auto& dynamicDevices = hwModule->getDynamicDevices();
             auto dynamicDevice = dynamicDevices.getDevice(deviceType, devAddress, encodedFormat);
             if (dynamicDevice) {
                 return dynamicDevice;
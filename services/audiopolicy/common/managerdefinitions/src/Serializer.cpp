@@ -22,6 +22,7 @@
 #include <utility>
 #include <variant>
 
+#include <binder/Parcel.h>
 #include <libxml/parser.h>
 #include <libxml/xinclude.h>
 #include <media/convert.h>
@@ -29,6 +30,7 @@
 #include <utils/StrongPointer.h>
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
+#include "ConfigCache.h"
 #include "Serializer.h"
 #include "TypeConverter.h"
 
@@ -229,8 +231,9 @@ struct SurroundSoundFormatTraits : public StdCollectionTraits<AudioPolicyConfig:
 class PolicySerializer
 {
 public:
+    // Files pulled in by XInclude are added to cache, if there is one.
     status_t deserialize(const char *configFile, AudioPolicyConfig *config,
-            bool ignoreVendorExtensions = false);
+            bool ignoreVendorExtensions = false, ConfigCache *cache = nullptr);
 
     template <class Trait>
     status_t deserializeCollection(const xmlNode *cur,
@@ -847,8 +850,22 @@ PolicySerializer::deserialize<SurroundSoundFormatTraits>(
     return pair;
 }
 
+// Adds the files included into the document below cur to the cache sources.
+void addXIncludesToCache(const xmlNode *cur, const std::string &baseDir, ConfigCache *cache)
+{
+    for (; cur != NULL; cur = cur->next) {
+        if (cur->type == XML_XINCLUDE_START) {
+            std::string href = getXmlAttribute(cur, "href");
+            if (!href.empty()) {
+                cache->addSourceFile(href[0] == '/' ? href : baseDir + href);
+            }
+        }
+        addXIncludesToCache(cur->children, baseDir, cache);
+    }
+}
+
 status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig *config,
-                                       bool ignoreVendorExtensions)
+                                       bool ignoreVendorExtensions, ConfigCache *cache)
 {
     mIgnoreVendorExtensions = ignoreVendorExtensions;
     auto doc = make_xmlUnique(xmlParseFile(configFile));
@@ -864,6 +881,10 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
     if (xmlXIncludeProcess(doc.get()) < 0) {
         ALOGE("%s: libxml failed to resolve XIncludes on %s document.", __func__, configFile);
     }
+    if (cache != nullptr) {
+        std::string file(configFile);
+        addXIncludesToCache(root, file.substr(0, file.find_last_of('/') + 1), cache);
+    }
 
     if (xmlStrcmp(root->name, reinterpret_cast<const xmlChar*>(rootName)))  {
         ALOGE("%s: No %s root element found in xml data %s.", __func__, rootName,
@@ -901,13 +922,403 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
     return android::OK;
 }
 
+// Binary form of a parsed configuration, for ConfigCache.
+// The configuration is rebuilt through the same constructors and setters the xml
+// deserializers use, so all the cross references (routes, supported devices) come out
+// the same. Bump kCacheVersion whenever the layout changes.
+constexpr uint32_t kCacheVersion = 1;
+
+void writeString(Parcel *parcel, const std::string &value)
+{
+    parcel->writeString8(String8(value.c_str()));
+}
+
+status_t readString(const Parcel &parcel, std::string *value)
+{
+    String8 value8;
+    status_t status = parcel.readString8(&value8);
+    *value = value8.string();
+    return status;
+}
+
+status_t writeCount(Parcel *parcel, size_t count)
+{
+    return parcel->writeInt32(count);
+}
+
+// Reads an element count, sanity checked against what is left in the parcel.
+status_t readCount(const Parcel &parcel, size_t *count)
+{
+    int32_t value;
+    status_t status = parcel.readInt32(&value);
+    if (status != NO_ERROR) return status;
+    if (value < 0 || (size_t)value > parcel.dataAvail()) return BAD_VALUE;
+    *count = value;
+    return NO_ERROR;
+}
+
+void writeAudioProfiles(Parcel *parcel, const AudioProfileVector &profiles)
+{
+    writeCount(parcel, profiles.size());
+    for (const auto &profile : profiles) {
+        parcel->writeUint32(profile->getFormat());
+        writeCount(parcel, profile->getChannels().size());
+        for (const auto channelMask : profile->getChannels()) {
+            parcel->writeUint32(channelMask);
+        }
+        writeCount(parcel, profile->getSampleRates().size());
+        for (const auto sampleRate : profile->getSampleRates()) {
+            parcel->writeUint32(sampleRate);
+        }
+        parcel->writeBool(profile->isDynamicFormat());
+        parcel->writeBool(profile->isDynamicChannels());
+        parcel->writeBool(profile->isDynamicRate());
+        parcel->writeInt32(profile->getEncapsulationType());
+    }
+}
+
+status_t readAudioProfiles(const Parcel &parcel, AudioProfileVector *profiles)
+{
+    size_t count;
+    status_t status = readCount(parcel, &count);
+    for (size_t i = 0; status == NO_ERROR && i < count; ++i) {
+        uint32_t format = parcel.readUint32();
+        size_t n;
+        ChannelMaskSet channelMasks;
+        if ((status = readCount(parcel, &n)) != NO_ERROR) break;
+        for (size_t j = 0; j < n; ++j) {
+            channelMasks.insert(static_cast<audio_channel_mask_t>(parcel.readUint32()));
+        }
+        SampleRateSet sampleRates;
+        if ((status = readCount(parcel, &n)) != NO_ERROR) break;
+        for (size_t j = 0; j < n; ++j) {
+            sampleRates.insert(parcel.readUint32());
+        }
+        bool isDynamicFormat = parcel.readBool();
+        bool isDynamicChannels = parcel.readBool();
+        bool isDynamicRate = parcel.readBool();
+        int32_t encapsulationType;
+        if ((status = parcel.readInt32(&encapsulationType)) != NO_ERROR) break;
+
+        sp<AudioProfile> profile = new AudioProfile(static_cast<audio_format_t>(format),
+                channelMasks, sampleRates,
+                static_cast<audio_encapsulation_type_t>(encapsulationType));
+        profile->setDynamicFormat(isDynamicFormat);
+        profile->setDynamicChannels(isDynamicChannels);
+        profile->setDynamicRate(isDynamicRate);
+        profiles->add(profile);
+    }
+    return status;
+}
+
+status_t writeAudioGains(Parcel *parcel, const AudioGains &gains)
+{
+    writeCount(parcel, gains.size());
+    for (const auto &gain : gains) {
+        auto aidl = gain->toParcelable();
+        if (!aidl.ok()) return BAD_VALUE;
+        parcel->writeParcelable(aidl.value().first);
+        parcel->writeParcelable(aidl.value().second);
+    }
+    return NO_ERROR;
+}
+
+status_t readAudioGains(const Parcel &parcel, AudioGains *gains)
+{
+    size_t count;
+    status_t status = readCount(parcel, &count);
+    for (size_t i = 0; status == NO_ERROR && i < count; ++i) {
+        AudioGain::Aidl aidl;
+        if ((status = parcel.readParcelable(&aidl.first)) != NO_ERROR
+                || (status = parcel.readParcelable(&aidl.second)) != NO_ERROR) {
+            break;
+        }
+        auto gain = AudioGain::fromParcelable(aidl);
+        if (!gain.ok()) return BAD_VALUE;
+        gains->add(gain.value());
+    }
+    return status;
+}
+
+bool containsDevice(const DeviceVector &devices, const sp<DeviceDescriptor> &device)
+{
+    for (const auto &d : devices) {
+        if (d == device) return true;
+    }
+    return false;
+}
+
+status_t writeConfig(Parcel *parcel, const AudioPolicyConfig &config)
+{
+    const HwModuleCollection modules = config.getHwModules();
+    writeCount(parcel, modules.size());
+    for (const auto &module : modules) {
+        writeString(parcel, module->getName());
+        parcel->writeUint32(module->getHalVersionMajor());
+        parcel->writeUint32(module->getHalVersionMinor());
+
+        IOProfileCollection mixPorts = module->getOutputProfiles();
+        mixPorts.appendVector(module->getInputProfiles());
+        writeCount(parcel, mixPorts.size());
+        for (const auto &mixPort : mixPorts) {
+            writeString(parcel, mixPort->getName());
+            parcel->writeInt32(mixPort->getRole());
+            writeAudioProfiles(parcel, mixPort->getAudioProfiles());
+            parcel->writeUint32(mixPort->getFlags());
+            parcel->writeUint32(mixPort->maxOpenCount);
+            parcel->writeUint32(mixPort->maxActiveCount);
+            parcel->writeUint32(mixPort->recommendedMuteDurationMs);
+            if (writeAudioGains(parcel, mixPort->getGains()) != NO_ERROR) return BAD_VALUE;
+        }
+
+        const DeviceVector &devices = module->getDeclaredDevices();
+        writeCount(parcel, devices.size());
+        for (const auto &device : devices) {
+            parcel->writeUint32(device->type());
+            writeString(parcel, device->getTagName());
+            writeString(parcel, device->address());
+            writeCount(parcel, device->encodedFormats().size());
+            for (const auto format : device->encodedFormats()) {
+                parcel->writeUint32(format);
+            }
+            writeAudioProfiles(parcel, device->getAudioProfiles());
+            if (writeAudioGains(parcel, device->getGains()) != NO_ERROR) return BAD_VALUE;
+        }
+
+        const AudioRouteVector &routes = module->getRoutes();
+        writeCount(parcel, routes.size());
+        for (const auto &route : routes) {
+            parcel->writeInt32(route->getType());
+            writeString(parcel, route->getSink()->getTagName());
+            writeCount(parcel, route->getSources().size());
+            for (const auto &source : route->getSources()) {
+                writeString(parcel, source->getTagName());
+            }
+        }
+
+        // in the order they were attached, which is kept by the config's device vectors
+        std::vector<std::string> attachedDevices;
+        DeviceVector allAttachedDevices = config.getOutputDevices();
+        allAttachedDevices.add(config.getInputDevices());
+        for (const auto &device : allAttachedDevices) {
+            if (containsDevice(devices, device)) {
+                attachedDevices.push_back(device->getTagName());
+            }
+        }
+        std::string defaultOutputDevice;
+        if (containsDevice(devices, config.getDefaultOutputDevice())) {
+            defaultOutputDevice = config.getDefaultOutputDevice()->getTagName();
+        }
+        writeCount(parcel, attachedDevices.size());
+        for (const auto &tagName : attachedDevices) {
+            writeString(parcel, tagName);
+        }
+        writeString(parcel, defaultOutputDevice);
+    }
+
+    parcel->writeBool(config.isSpeakerDrcEnabled());
+    parcel->writeBool(config.isCallScreenModeSupported());
+    writeString(parcel, config.getEngineLibraryNameSuffix());
+
+    const AudioPolicyConfig::SurroundFormats &surroundFormats = config.getSurroundFormats();
+    writeCount(parcel, surroundFormats.size());
+    for (const auto &surroundFormat : surroundFormats) {
+        parcel->writeUint32(surroundFormat.first);
+        writeCount(parcel, surroundFormat.second.size());
+        for (const auto subformat : surroundFormat.second) {
+            parcel->writeUint32(subformat);
+        }
+    }
+    return NO_ERROR;
+}
+
+status_t readModule(const Parcel &parcel, AudioPolicyConfig *config, sp<HwModule> *result)
+{
+    std::string name;
+    status_t status = readString(parcel, &name);
+    if (status != NO_ERROR) return status;
+    uint32_t versionMajor = parcel.readUint32();
+    uint32_t versionMinor = parcel.readUint32();
+    sp<HwModule> module = new HwModule(name.c_str(), versionMajor, versionMinor);
+
+    size_t count;
+    IOProfileCollection mixPorts;
+    if ((status = readCount(parcel, &count)) != NO_ERROR) return status;
+    for (size_t i = 0; i < count; ++i) {
+        std::string mixPortName;
+        if ((status = readString(parcel, &mixPortName)) != NO_ERROR) return status;
+        audio_port_role_t role = static_cast<audio_port_role_t>(parcel.readInt32());
+        sp<IOProfile> mixPort = new IOProfile(mixPortName, role);
+        AudioProfileVector profiles;
+        if ((status = readAudioProfiles(parcel, &profiles)) != NO_ERROR) return status;
+        mixPort->setAudioProfiles(profiles);
+        // flags first, as setFlags() may reset maxActiveCount
+        mixPort->setFlags(parcel.readUint32());
+        mixPort->maxOpenCount = parcel.readUint32();
+        mixPort->maxActiveCount = parcel.readUint32();
+        mixPort->recommendedMuteDurationMs = parcel.readUint32();
+        AudioGains gains;
+        if ((status = readAudioGains(parcel, &gains)) != NO_ERROR) return status;
+        mixPort->setGains(gains);
+        mixPorts.add(mixPort);
+    }
+    module->setProfiles(mixPorts);
+
+    DeviceVector devices;
+    if ((status = readCount(parcel, &count)) != NO_ERROR) return status;
+    for (size_t i = 0; i < count; ++i) {
+        audio_devices_t type = static_cast<audio_devices_t>(parcel.readUint32());
+        std::string tagName, address;
+        if ((status = readString(parcel, &tagName)) != NO_ERROR
+                || (status = readString(parcel, &address)) != NO_ERROR) {
+            return status;
+        }
+        size_t nFormats;
+        FormatVector encodedFormats;
+        if ((status = readCount(parcel, &nFormats)) != NO_ERROR) return status;
+        for (size_t j = 0; j < nFormats; ++j) {
+            encodedFormats.push_back(static_cast<audio_format_t>(parcel.readUint32()));
+        }
+        sp<DeviceDescriptor> device =
+                new DeviceDescriptor(type, tagName, address, encodedFormats);
+        AudioProfileVector profiles;
+        if ((status = readAudioProfiles(parcel, &profiles)) != NO_ERROR
+                || (status = readAudioGains(parcel, &device->mGains)) != NO_ERROR) {
+            return status;
+        }
+        device->setAudioProfiles(profiles);
+        if (devices.add(device) < 0) return BAD_VALUE;
+    }
+    module->setDeclaredDevices(devices);
+
+    AudioRouteVector routes;
+    if ((status = readCount(parcel, &count)) != NO_ERROR) return status;
+    for (size_t i = 0; i < count; ++i) {
+        sp<AudioRoute> route =
+                new AudioRoute(static_cast<audio_route_type_t>(parcel.readInt32()));
+        std::string tagName;
+        if ((status = readString(parcel, &tagName)) != NO_ERROR) return status;
+        sp<PolicyAudioPort> sink = module->findPortByTagName(tagName);
+        if (sink == nullptr) return BAD_VALUE;
+        route->setSink(sink);
+        size_t nSources;
+        PolicyAudioPortVector sources;
+        if ((status = readCount(parcel, &nSources)) != NO_ERROR) return status;
+        for (size_t j = 0; j < nSources; ++j) {
+            if ((status = readString(parcel, &tagName)) != NO_ERROR) return status;
+            sp<PolicyAudioPort> source = module->findPortByTagName(tagName);
+            if (source == nullptr) return BAD_VALUE;
+            sources.add(source);
+        }
+        sink->addRoute(route);
+        for (const auto &source : sources) {
+            source->addRoute(route);
+        }
+        route->setSources(sources);
+        routes.add(route);
+    }
+    module->setRoutes(routes);
+
+    if ((status = readCount(parcel, &count)) != NO_ERROR) return status;
+    for (size_t i = 0; i < count; ++i) {
+        std::string tagName;
+        if ((status = readString(parcel, &tagName)) != NO_ERROR) return status;
+        sp<DeviceDescriptor> device = module->getDeclaredDevices().getDeviceFromTagName(tagName);
+        if (device == nullptr) return BAD_VALUE;
+        config->addDevice(device);
+    }
+    std::string defaultOutputDevice;
+    if ((status = readString(parcel, &defaultOutputDevice)) != NO_ERROR) return status;
+    if (!defaultOutputDevice.empty()) {
+        sp<DeviceDescriptor> device =
+                module->getDeclaredDevices().getDeviceFromTagName(defaultOutputDevice);
+        if (device == nullptr) return BAD_VALUE;
+        config->setDefaultOutputDevice(device);
+    }
+
+    *result = module;
+    return NO_ERROR;
+}
+
+status_t readConfig(const Parcel &parcel, AudioPolicyConfig *config)
+{
+    size_t count;
+    status_t status = readCount(parcel, &count);
+    if (status != NO_ERROR) return status;
+    HwModuleCollection modules;
+    for (size_t i = 0; i < count; ++i) {
+        sp<HwModule> module;
+        if ((status = readModule(parcel, config, &module)) != NO_ERROR) return status;
+        modules.add(module);
+    }
+    config->setHwModules(modules);
+
+    config->setSpeakerDrcEnabled(parcel.readBool());
+    config->setCallScreenModeSupported(parcel.readBool());
+    std::string engineLibrarySuffix;
+    if ((status = readString(parcel, &engineLibrarySuffix)) != NO_ERROR) return status;
+    config->setEngineLibraryNameSuffix(engineLibrarySuffix);
+
+    AudioPolicyConfig::SurroundFormats surroundFormats;
+    if ((status = readCount(parcel, &count)) != NO_ERROR) return status;
+    for (size_t i = 0; i < count; ++i) {
+        audio_format_t format = static_cast<audio_format_t>(parcel.readUint32());
+        size_t nSubformats;
+        if ((status = readCount(parcel, &nSubformats)) != NO_ERROR) return status;
+        auto &subformats = surroundFormats[format];
+        for (size_t j = 0; j < nSubformats; ++j) {
+            subformats.insert(static_cast<audio_format_t>(parcel.readUint32()));
+        }
+    }
+    config->setSurroundFormats(surroundFormats);
+
+    // every read above past the end of the parcel fails or reads 0, so check we got it all
+    return parcel.dataAvail() == 0 ? NO_ERROR : BAD_VALUE;
+}
+
+status_t loadCachedConfig(const ConfigCache &cache, AudioPolicyConfig *config)
+{
+    std::string payload;
+    if (!cache.load(&payload)) {
+        return NAME_NOT_FOUND;
+    }
+    Parcel parcel;
+    parcel.setData(reinterpret_cast<const uint8_t *>(payload.data()), payload.size());
+    status_t status = readConfig(parcel, config);
+    if (status != NO_ERROR) {
+        ALOGW("%s: could not load cached configuration: %d", __func__, status);
+        config->clear();
+    }
+    return status;
+}
+
+void storeCachedConfig(const ConfigCache &cache, const AudioPolicyConfig &config)
+{
+    Parcel parcel;
+    if (writeConfig(&parcel, config) != NO_ERROR) {
+        return;
+    }
+    cache.store(std::string(reinterpret_cast<const char *>(parcel.data()), parcel.dataSize()));
+}
+
 }  // namespace
 
 status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config)
 {
+    ConfigCache cache("policy", kCacheVersion, fileName);
+    if (loadCachedConfig(cache, config) == NO_ERROR) {
+        ALOGV("%s: loaded %s from cache", __func__, fileName);
+        return NO_ERROR;
+    }
+
     PolicySerializer serializer;
-    status_t status = serializer.deserialize(fileName, config);
-    if (status != OK) config->clear();
+    status_t status = serializer.deserialize(fileName, config, false /*ignoreVendorExtensions*/,
+            cache.isEnabled() ? &cache : nullptr);
+    if (status != OK) {
+        config->clear();
+    } else {
+        storeCachedConfig(cache, *config);
+    }
     return status;
 }
 
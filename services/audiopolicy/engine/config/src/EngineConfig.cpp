@@ -17,6 +17,7 @@
 #define LOG_TAG "APM::AudioPolicyEngine/Config"
 //#define LOG_NDEBUG 0
 
+#include "ConfigCache.h"
 #include "EngineConfig.h"
 #include <cutils/properties.h>
 #include <media/TypeConverter.h>
@@ -33,6 +34,7 @@
 
 #include <cstdint>
 #include <stdarg.h>
+#include <type_traits>
 #include <string>
 
 namespace android {
@@ -659,9 +661,219 @@ private:
     std::string mErrorMessage;
 };
 
+// Adds the files included into the document below cur to the cache sources.
+void addXIncludesToCache(const xmlNode *cur, const std::string &baseDir, ConfigCache &cache)
+{
+    for (; cur != NULL; cur = cur->next) {
+        if (cur->type == XML_XINCLUDE_START) {
+            std::string href = getXmlAttribute(cur, "href");
+            if (!href.empty()) {
+                cache.addSourceFile(href[0] == '/' ? href : baseDir + href);
+            }
+        }
+        addXIncludesToCache(cur->children, baseDir, cache);
+    }
+}
+
+// Binary form of a parsed Config, for ConfigCache.
+// Bump kCacheVersion whenever the layout or any of the structures in EngineConfig.h change.
+constexpr uint32_t kCacheVersion = 1;
+
+class CacheWriter {
+public:
+    template <typename T>
+    void write(const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        mData.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    void write(const std::string &value) {
+        write((uint32_t)value.size());
+        mData.append(value);
+    }
+    template <typename T>
+    void write(const std::vector<T> &values) {
+        write((uint32_t)values.size());
+        for (const auto &value : values) {
+            write(value);
+        }
+    }
+    void write(const AttributesGroup &group) {
+        write(group.name);
+        write(group.stream);
+        write(group.volumeGroup);
+        write(group.attributesVect);
+    }
+    void write(const CurvePoint &point) {
+        write(point.index);
+        write(point.attenuationInMb);
+    }
+    void write(const VolumeCurve &curve) {
+        write(curve.deviceCategory);
+        write(curve.curvePoints);
+    }
+    void write(const VolumeGroup &group) {
+        write(group.name);
+        write(group.indexMin);
+        write(group.indexMax);
+        write(group.volumeCurves);
+    }
+    void write(const ProductStrategy &strategy) {
+        write(strategy.name);
+        write(strategy.attributesGroups);
+    }
+    void write(const ValuePair &pair) {
+        write(std::get<0>(pair));
+        write(std::get<1>(pair));
+        write(std::get<2>(pair));
+    }
+    void write(const CriterionType &type) {
+        write(type.name);
+        write(type.isInclusive);
+        write(type.valuePairs);
+    }
+    void write(const Criterion &criterion) {
+        write(criterion.name);
+        write(criterion.typeName);
+        write(criterion.defaultLiteralValue);
+    }
+
+    const std::string &data() const { return mData; }
+
+private:
+    std::string mData;
+};
+
+// Mirrors CacheWriter. Every read fails once the data runs out, and the failure sticks.
+class CacheReader {
+public:
+    explicit CacheReader(const std::string &data) : mData(data) {}
+
+    template <typename T>
+    bool read(T *value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (mData.size() - mPos < sizeof(*value)) {
+            return fail();
+        }
+        memcpy(value, mData.data() + mPos, sizeof(*value));
+        mPos += sizeof(*value);
+        return true;
+    }
+    bool read(std::string *value) {
+        uint32_t size;
+        if (!read(&size) || mData.size() - mPos < size) {
+            return fail();
+        }
+        value->assign(mData, mPos, size);
+        mPos += size;
+        return true;
+    }
+    template <typename T>
+    bool read(std::vector<T> *values) {
+        uint32_t size;
+        // each element takes at least a byte, which bounds the allocation on corrupt data
+        if (!read(&size) || mData.size() - mPos < size) {
+            return fail();
+        }
+        values->resize(size);
+        for (auto &value : *values) {
+            if (!read(&value)) return false;
+        }
+        return true;
+    }
+    bool read(AttributesGroup *group) {
+        return read(&group->name) && read(&group->stream) && read(&group->volumeGroup)
+                && read(&group->attributesVect);
+    }
+    bool read(CurvePoint *point) {
+        return read(&point->index) && read(&point->attenuationInMb);
+    }
+    bool read(VolumeCurve *curve) {
+        return read(&curve->deviceCategory) && read(&curve->curvePoints);
+    }
+    bool read(VolumeGroup *group) {
+        return read(&group->name) && read(&group->indexMin) && read(&group->indexMax)
+                && read(&group->volumeCurves);
+    }
+    bool read(ProductStrategy *strategy) {
+        return read(&strategy->name) && read(&strategy->attributesGroups);
+    }
+    bool read(ValuePair *pair) {
+        return read(&std::get<0>(*pair)) && read(&std::get<1>(*pair))
+                && read(&std::get<2>(*pair));
+    }
+    bool read(CriterionType *type) {
+        return read(&type->name) && read(&type->isInclusive) && read(&type->valuePairs);
+    }
+    bool read(Criterion *criterion) {
+        return read(&criterion->name) && read(&criterion->typeName)
+                && read(&criterion->defaultLiteralValue);
+    }
+
+    bool isDone() const { return mPos == mData.size(); }
+
+private:
+    bool fail() {
+        mPos = mData.size() + 1;  // never done
+        return false;
+    }
+
+    const std::string &mData;
+    size_t mPos = 0;
+};
+
+std::string encodeConfig(const Config &config, size_t nbSkippedElements)
+{
+    CacheWriter writer;
+    writer.write(config.version);
+    writer.write(config.productStrategies);
+    writer.write(config.criteria);
+    writer.write(config.criterionTypes);
+    writer.write(config.volumeGroups);
+    writer.write((uint64_t)nbSkippedElements);
+    return writer.data();
+}
+
+ParsingResult decodeConfig(const std::string &data)
+{
+    CacheReader reader(data);
+    auto config = std::make_unique<Config>();
+    uint64_t nbSkippedElements = 0;
+    if (!reader.read(&config->version)
+            || !reader.read(&config->productStrategies)
+            || !reader.read(&config->criteria)
+            || !reader.read(&config->criterionTypes)
+            || !reader.read(&config->volumeGroups)
+            || !reader.read(&nbSkippedElements)
+            || !reader.isDone()) {
+        ALOGW("%s: could not load cached configuration", __func__);
+        return {nullptr, 0};
+    }
+    return {std::move(config), nbSkippedElements};
+}
+
+ParsingResult parseFile(const char* path, ConfigCache &cache);
+
 }  // namespace
 
 ParsingResult parse(const char* path) {
+    ConfigCache cache("engine", kCacheVersion, path);
+    if (std::string data; cache.load(&data)) {
+        ParsingResult result = decodeConfig(data);
+        if (result.parsedConfig != nullptr) {
+            ALOGV("%s: loaded %s from cache", __func__, path);
+            return result;
+        }
+    }
+    ParsingResult result = parseFile(path, cache);
+    if (result.parsedConfig != nullptr) {
+        cache.store(encodeConfig(*result.parsedConfig, result.nbSkippedElement));
+    }
+    return result;
+}
+
+namespace {
+
+ParsingResult parseFile(const char* path, ConfigCache &cache) {
     XmlErrorHandler errorHandler;
     auto doc = make_xmlUnique(xmlParseFile(path));
     if (doc == NULL) {
@@ -681,6 +893,10 @@ ParsingResult parse(const char* path) {
         ALOGE("%s: libxml failed to resolve XIncludes on document %s", __FUNCTION__, path);
         return {nullptr, 0};
     }
+    if (cache.isEnabled()) {
+        std::string file(path);
+        addXIncludesToCache(cur, file.substr(0, file.find_last_of('/') + 1), cache);
+    }
     std::string version = getXmlAttribute(cur, gVersionAttribute);
     if (version.empty()) {
         ALOGE("%s: No version found", __func__);
@@ -701,6 +917,8 @@ ParsingResult parse(const char* path) {
     return {std::move(config), nbSkippedElements};
 }
 
+}  // namespace
+
 android::status_t parseLegacyVolumeFile(const char* path, VolumeGroups &volumeGroups) {
     XmlErrorHandler errorHandler;
     auto doc = make_xmlUnique(xmlParseFile(path));
@@ -220,6 +220,7 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(audio_devices_t deviceT
 status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescriptor> &device,
                                                          audio_policy_dev_state_t state)
 {
+    invalidateOutputDecisionCache();
     // handle output devices
     if (audio_is_output_device(device->type())) {
         SortedVector <audio_io_handle_t> outputs;
@@ -352,14 +353,17 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescript
             checkCloseOutputs();
         }
         (void)updateCallRouting(false /*fromCache*/);
+        // When coalescing, active outputs are rerouted once by onDeferredRoutingUpdate()
+        const bool outputRoutingDeferred = deferRoutingUpdate(false /*forceVolumeReeval*/, 0);
         std::vector<audio_io_handle_t> outputsToReopen;
         const DeviceVector msdOutDevices = getMsdAudioOutDevices();
         const DeviceVector activeMediaDevices =
                 mEngine->getActiveMediaDevices(mAvailableOutputDevices);
         for (size_t i = 0; i < mOutputs.size(); i++) {
             sp<SwAudioOutputDescriptor> desc = mOutputs.valueAt(i);
-            if (desc->isActive() && ((mEngine->getPhoneState() != AUDIO_MODE_IN_CALL) ||
-                (desc != mPrimaryOutput))) {
+            if (!outputRoutingDeferred && desc->isActive() &&
+                    ((mEngine->getPhoneState() != AUDIO_MODE_IN_CALL) ||
+                     (desc != mPrimaryOutput))) {
                 DeviceVector newDevices = getNewOutputDevices(desc, true /*fromCache*/);
                 // do not force device change on duplicated output because if device is 0, it will
                 // also force a device 0 for the two outputs it is duplicated to which may override
@@ -884,6 +888,7 @@ void AudioPolicyManager::connectTelephonyTxAudioSource(
 
 void AudioPolicyManager::setPhoneState(audio_mode_t state)
 {
+    invalidateOutputDecisionCache();
     ALOGV("setPhoneState() state %d", state);
     // store previous phone state for management of sonification strategy below
     int oldState = mEngine->getPhoneState();
@@ -1002,6 +1007,7 @@ audio_mode_t AudioPolicyManager::getPhoneState() {
 void AudioPolicyManager::setForceUse(audio_policy_force_use_t usage,
                                      audio_policy_forced_cfg_t config)
 {
+    invalidateOutputDecisionCache();
     ALOGV("setForceUse() usage %d, config %d, mPhoneState %d", usage, config, mEngine->getPhoneState());
     if (config == mEngine->getForceUse(usage)) {
         return;
@@ -1224,6 +1230,19 @@ status_t AudioPolicyManager::getAudioAttributes(audio_attributes_t *dstAttr,
     return NO_ERROR;
 }
 
+AudioPolicyManager::OutputDecisionKey AudioPolicyManager::makeOutputDecisionKey(
+        const audio_attributes_t& attr,
+        audio_stream_type_t stream,
+        uid_t uid,
+        const audio_config_t *config,
+        audio_output_flags_t flags)
+{
+    return {toString(attr), stream, config->sample_rate, config->channel_mask, config->format,
+            config->offload_info.usage, flags, uid,
+            mEffects.isNonOffloadableEffectEnabled() || mMasterMono, isVrAudioModeOn(),
+            mSpatializerOutput != nullptr ? mSpatializerOutput->mIoHandle : AUDIO_IO_HANDLE_NONE};
+}
+
 status_t AudioPolicyManager::getOutputForAttrInt(
         audio_attributes_t *resultAttr,
         audio_io_handle_t *output,
@@ -1260,6 +1279,34 @@ status_t AudioPolicyManager::getOutputForAttrInt(
     ALOGV("%s() attributes=%s stream=%s session %d selectedDeviceId %d", __func__,
           toString(*resultAttr).c_str(), toString(*stream).c_str(), session, requestedPortId);
 
+    // Explicit routing, MSD patches and haptic generators attached to the session make the
+    // decision depend on more than the key, do not cache them.
+    const bool useOutputDecisionCache = mOutputDecisionCacheEnabled
+            && requestedPortId == AUDIO_PORT_HANDLE_NONE
+            && msdDevices.isEmpty()
+            && (session == AUDIO_SESSION_NONE
+                || mEffects.getIoForSession(session, FX_IID_HAPTICGENERATOR)
+                        == AUDIO_IO_HANDLE_NONE);
+    OutputDecisionKey decisionKey;
+    if (useOutputDecisionCache) {
+        decisionKey = makeOutputDecisionKey(*resultAttr, *stream, uid, config, *flags);
+        auto it = mOutputDecisionCache.find(decisionKey);
+        if (it != mOutputDecisionCache.end()) {
+            const OutputDecision& decision = it->second;
+            if (mOutputs.valueFor(decision.output) != nullptr) {
+                *output = decision.output;
+                *flags = decision.flags;
+                *selectedDeviceId = decision.selectedDeviceId;
+                *outputType = decision.outputType;
+                *isSpatialized = decision.isSpatialized;
+                ALOGV("%s returns cached output %d selectedDeviceId %d",
+                      __func__, *output, *selectedDeviceId);
+                return NO_ERROR;
+            }
+            mOutputDecisionCache.erase(it);
+        }
+    }
+
     // The primary output is the explicit routing (eg. setPreferredDevice) if specified,
     //       otherwise, fallback to the dynamic policies, if none match, query the engine.
     // Secondary outputs are always found by dynamic policies as the engine do not support them
@@ -1389,6 +1436,17 @@ status_t AudioPolicyManager::getOutputForAttrInt(
         *outputType = API_OUTPUT_LEGACY;
     }
 
+    if (useOutputDecisionCache && primaryMix == nullptr
+            && (secondaryMixes == nullptr || secondaryMixes->empty())) {
+        // Direct outputs are opened for the client, only a mixed output can be shared.
+        const sp<SwAudioOutputDescriptor> desc = mOutputs.valueFor(*output);
+        if (desc != nullptr && !desc->isDuplicated()
+                && (desc->mFlags & AUDIO_OUTPUT_FLAG_DIRECT) == 0) {
+            mOutputDecisionCache[decisionKey] =
+                    {*output, *flags, *selectedDeviceId, *outputType, *isSpatialized};
+        }
+    }
+
     ALOGV("%s returns output %d selectedDeviceId %d", __func__, *output, *selectedDeviceId);
 
     return NO_ERROR;
@@ -1626,6 +1684,16 @@ status_t AudioPolicyManager::openDirectOutput(audio_stream_type_t stream,
     return NO_ERROR;
 }
 
+bool AudioPolicyManager::isVrAudioModeOn()
+{
+    String8 value;
+    String8 reply =  mpClientInterface->getParameters(AUDIO_IO_HANDLE_NONE,
+                                          String8("vr_audio_mode_on"));
+    AudioParameter repliedParameter(reply);
+    return repliedParameter.get(String8("vr_audio_mode_on"), value) == NO_ERROR &&
+            value.contains("true");
+}
+
 audio_io_handle_t AudioPolicyManager::getOutputForDevices(
         const DeviceVector &devices,
         audio_session_t session,
@@ -1643,12 +1711,7 @@ audio_io_handle_t AudioPolicyManager::getOutputForDevices(
             : config->channel_mask;
 
 
-    String8 value;
-    String8 reply =  mpClientInterface->getParameters(AUDIO_IO_HANDLE_NONE,
-                                          String8("vr_audio_mode_on"));
-    AudioParameter repliedParameter(reply);
-    if (repliedParameter.get(String8("vr_audio_mode_on"), value) == NO_ERROR &&
-        value.contains("true")) {
+    if (isVrAudioModeOn()) {
         ALOGI("%s VR mode is on, switch to primary output requested flags 0x%X",__func__, *flags);
         *flags = (audio_output_flags_t)(*flags &
                     (~(AUDIO_OUTPUT_FLAG_FAST|AUDIO_OUTPUT_FLAG_RAW)));
@@ -2254,6 +2317,7 @@ status_t AudioPolicyManager::startSource(const sp<SwAudioOutputDescriptor>& outp
                                          const sp<TrackClientDescriptor>& client,
                                          uint32_t *delayMs)
 {
+    invalidateOutputDecisionCache();
     // cannot start playback of STREAM_TTS if any other output is being used
     uint32_t beaconMuteLatency = 0;
 
@@ -2490,6 +2554,7 @@ status_t AudioPolicyManager::stopOutput(audio_port_handle_t portId)
 status_t AudioPolicyManager::stopSource(const sp<SwAudioOutputDescriptor>& outputDesc,
                                         const sp<TrackClientDescriptor>& client)
 {
+    invalidateOutputDecisionCache();
     // always handle stream stop, check which stream type is stopping
     audio_stream_type_t stream = client->stream();
     auto clientVolSrc = client->volumeSource();
@@ -3614,6 +3679,7 @@ bool AudioPolicyManager::isSourceActive(audio_source_t source) const
 
 status_t AudioPolicyManager::registerPolicyMixes(const Vector<AudioMix>& mixes)
 {
+    invalidateOutputDecisionCache();
     ALOGV("registerPolicyMixes() %zu mix(es)", mixes.size());
     status_t res = NO_ERROR;
     bool checkOutputs = false;
@@ -3751,6 +3817,7 @@ status_t AudioPolicyManager::registerPolicyMixes(const Vector<AudioMix>& mixes)
 
 status_t AudioPolicyManager::unregisterPolicyMixes(Vector<AudioMix> mixes)
 {
+    invalidateOutputDecisionCache();
     ALOGV("unregisterPolicyMixes() num mixes %zu", mixes.size());
     status_t res = NO_ERROR;
     bool checkOutputs = false;
@@ -3839,6 +3906,7 @@ bool  AudioPolicyManager::areAllDevicesSupported(
 
 status_t AudioPolicyManager::setUidDeviceAffinities(uid_t uid,
         const AudioDeviceTypeAddrVector& devices) {
+    invalidateOutputDecisionCache();
     ALOGV("%s() uid=%d num devices %zu", __FUNCTION__, uid, devices.size());
     if (!areAllDevicesSupported(devices, audio_is_output_device, __func__)) {
         return BAD_VALUE;
@@ -3856,6 +3924,7 @@ status_t AudioPolicyManager::setUidDeviceAffinities(uid_t uid,
 }
 
 status_t AudioPolicyManager::removeUidDeviceAffinities(uid_t uid) {
+    invalidateOutputDecisionCache();
     ALOGV("%s() uid=%d", __FUNCTION__, uid);
     status_t res = mPolicyMixes.removeUidDeviceAffinities(uid);
     if (res != NO_ERROR) {
@@ -3874,6 +3943,7 @@ status_t AudioPolicyManager::removeUidDeviceAffinities(uid_t uid) {
 status_t AudioPolicyManager::setDevicesRoleForStrategy(product_strategy_t strategy,
                                                        device_role_t role,
                                                        const AudioDeviceTypeAddrVector &devices) {
+    invalidateOutputDecisionCache();
     ALOGV("%s() strategy=%d role=%d %s", __func__, strategy, role,
             dumpAudioDeviceTypeAddrVector(devices).c_str());
 
@@ -3905,6 +3975,45 @@ status_t AudioPolicyManager::setDevicesRoleForStrategy(product_strategy_t strate
 
 void AudioPolicyManager::updateCallAndOutputRouting(bool forceVolumeReeval, uint32_t delayMs)
 {
+    invalidateOutputDecisionCache();
+    if (deferRoutingUpdate(forceVolumeReeval, delayMs)) {
+        return;
+    }
+    updateCallAndOutputRoutingInt(forceVolumeReeval, delayMs);
+}
+
+bool AudioPolicyManager::deferRoutingUpdate(bool forceVolumeReeval, uint32_t delayMs)
+{
+    if (mRoutingCoalescingMs == 0) {
+        return false;
+    }
+    mPendingForceVolumeReeval = mPendingForceVolumeReeval || forceVolumeReeval;
+    if (!mRoutingUpdatePending) {
+        mRoutingUpdatePending = true;
+        // The update of the first event of a burst is delayed by at least the window, which
+        // also covers the unmute delay it requested.
+        const uint32_t windowMs = std::max(mRoutingCoalescingMs, delayMs);
+        ALOGV("%s deferring routing update by %u ms", __func__, windowMs);
+        mpClientInterface->scheduleDeferredRoutingUpdate(windowMs);
+    }
+    return true;
+}
+
+void AudioPolicyManager::onDeferredRoutingUpdate()
+{
+    if (!mRoutingUpdatePending) {
+        return;
+    }
+    mRoutingUpdatePending = false;
+    const bool forceVolumeReeval = mPendingForceVolumeReeval;
+    mPendingForceVolumeReeval = false;
+    ALOGV("%s applying coalesced routing update", __func__);
+    updateCallAndOutputRoutingInt(forceVolumeReeval, 0 /*delayMs*/);
+}
+
+void AudioPolicyManager::updateCallAndOutputRoutingInt(bool forceVolumeReeval, uint32_t delayMs)
+{
+    invalidateOutputDecisionCache();
     uint32_t waitMs = 0;
     bool wasLeUnicastActive = isLeUnicastActive();
     if (updateCallRouting(true /*fromCache*/, delayMs, &waitMs) == NO_ERROR) {
@@ -3953,6 +4062,7 @@ void AudioPolicyManager::updateInputRouting() {
 status_t AudioPolicyManager::removeDevicesRoleForStrategy(product_strategy_t strategy,
                                                           device_role_t role)
 {
+    invalidateOutputDecisionCache();
     ALOGV("%s() strategy=%d role=%d", __func__, strategy, role);
 
     status_t status = mEngine->removeDevicesRoleForStrategy(strategy, role);
@@ -4055,6 +4165,7 @@ status_t AudioPolicyManager::getDevicesForRoleAndCapturePreset(
 
 status_t AudioPolicyManager::setUserIdDeviceAffinities(int userId,
         const AudioDeviceTypeAddrVector& devices) {
+    invalidateOutputDecisionCache();
     ALOGV("%s() userId=%d num devices %zu", __func__, userId, devices.size());
     if (!areAllDevicesSupported(devices, audio_is_output_device, __func__)) {
         return BAD_VALUE;
@@ -4074,6 +4185,7 @@ status_t AudioPolicyManager::setUserIdDeviceAffinities(int userId,
 }
 
 status_t AudioPolicyManager::removeUserIdDeviceAffinities(int userId) {
+    invalidateOutputDecisionCache();
     ALOGV("%s() userId=%d", __FUNCTION__, userId);
     status_t status = mPolicyMixes.removeUserIdDeviceAffinities(userId);
     if (status != NO_ERROR) {
@@ -4114,6 +4226,8 @@ void AudioPolicyManager::dump(String8 *dst) const
     }
     dst->appendFormat(" TTS output %savailable\n", mTtsOutputAvailable ? "" : "not ");
     dst->appendFormat(" Master mono: %s\n", mMasterMono ? "on" : "off");
+    dst->appendFormat(" Routing coalescing: %u ms%s\n", mRoutingCoalescingMs,
+            mRoutingUpdatePending ? " (update pending)" : "");
     dst->appendFormat(" Communication Strategy id: %d\n", mCommunnicationStrategy);
     dst->appendFormat(" Config source: %s\n", mConfig.getSource().c_str()); // getConfig not const
 
@@ -5903,7 +6017,11 @@ AudioPolicyManager::AudioPolicyManager(AudioPolicyClientInterface *clientInterfa
     mBeaconMuted(false),
     mTtsOutputAvailable(false),
     mMasterMono(false),
-    mMusicEffectOutput(AUDIO_IO_HANDLE_NONE)
+    mMusicEffectOutput(AUDIO_IO_HANDLE_NONE),
+    mOutputDecisionCacheEnabled(
+            property_get_bool("audio.policy.output_decision_cache", false /* default_value */)),
+    mRoutingCoalescingMs(std::max(0, property_get_int32(
+            "audio.policy.routing_coalescing_ms", 0 /* default_value */)))
 {
 }
 
@@ -6162,6 +6280,7 @@ void AudioPolicyManager::addOutput(audio_io_handle_t output,
                                    const sp<SwAudioOutputDescriptor>& outputDesc)
 {
     mOutputs.add(output, outputDesc);
+    invalidateOutputDecisionCache();
     applyStreamVolumes(outputDesc, DeviceTypeSet(), 0 /* delayMs */, true /* force */);
     updateMono(output); // update mono status when adding to output list
     selectOutputForMusicEffects();
@@ -6175,6 +6294,7 @@ void AudioPolicyManager::removeOutput(audio_io_handle_t output)
         mPrimaryOutput = nullptr;
     }
     mOutputs.removeItem(output);
+    invalidateOutputDecisionCache();
     selectOutputForMusicEffects();
 }
 
@@ -7191,6 +7311,7 @@ uint32_t AudioPolicyManager::setBeaconMute(bool mute) {
 
 void AudioPolicyManager::updateDevicesAndOutputs()
 {
+    invalidateOutputDecisionCache();
     mEngine->updateDeviceSelectionCache();
     mPreviousOutputs = mOutputs;
 }
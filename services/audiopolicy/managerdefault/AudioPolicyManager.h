@@ -18,7 +18,10 @@
 
 #include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
+#include <string>
+#include <tuple>
 #include <unordered_set>
 
 #include <stdint.h>
@@ -402,6 +405,8 @@ public:
 
         void onNewAudioModulesAvailable() override;
 
+        void onDeferredRoutingUpdate() override;
+
         status_t initialize();
 
 protected:
@@ -419,6 +424,20 @@ protected:
         AudioPolicyConfig& getConfig() { return mConfig; }
         void loadConfig();
 
+        // Enables the cache of getOutputForAttr() routing decisions, see mOutputDecisionCache.
+        // Disabled by default unless "audio.policy.output_decision_cache" is set.
+        void setOutputDecisionCacheEnabled(bool enabled) {
+            mOutputDecisionCacheEnabled = enabled;
+            invalidateOutputDecisionCache();
+        }
+        // Must be called every time a condition that affects the output selected for
+        // a new client is changed, in addition to updateDevicesAndOutputs().
+        void invalidateOutputDecisionCache() { mOutputDecisionCache.clear(); }
+
+        // Sets the window used to coalesce output routing updates, 0 to disable coalescing.
+        // Disabled by default unless "audio.policy.routing_coalescing_ms" is set.
+        void setRoutingCoalescingMs(uint32_t windowMs) { mRoutingCoalescingMs = windowMs; }
+
         // From AudioPolicyManagerObserver
         virtual const AudioPatchCollection &getAudioPatches() const
         {
@@ -634,9 +653,18 @@ protected:
 
         /**
          * @brief updates routing for all outputs (including call if call in progress).
+         * When routing updates are coalesced, see mRoutingCoalescingMs, the update is deferred
+         * and merged with the ones requested until it is applied by onDeferredRoutingUpdate().
          * @param delayMs delay for unmuting if required
          */
         void updateCallAndOutputRouting(bool forceVolumeReeval = true, uint32_t delayMs = 0);
+        void updateCallAndOutputRoutingInt(bool forceVolumeReeval, uint32_t delayMs);
+
+        /**
+         * @brief defers the routing update of all outputs if routing updates are coalesced.
+         * @return true if the update was deferred, false if it must be applied now.
+         */
+        bool deferRoutingUpdate(bool forceVolumeReeval, uint32_t delayMs);
 
         bool isCallRxAudioSource(const sp<SourceClientDescriptor> &source) {
             return mCallRxSourceClient != nullptr && source == mCallRxSourceClient;
@@ -992,6 +1020,38 @@ protected:
 
         bool isMsdPatch(const audio_patch_handle_t &handle) const;
 
+        // Routing decisions of getOutputForAttrInt() for requests that the engine resolved to
+        // an already opened mixed output, so that creating another client with the same
+        // attributes, config and flags does not walk the strategies and output profiles again.
+        // Keyed by attributes, stream, config, requested flags, uid and the transient state that
+        // getOutputForDevices() reads without it being part of the routing state.
+        using OutputDecisionKey = std::tuple<std::string /*attributes*/,
+                                             audio_stream_type_t,
+                                             uint32_t /*sampleRate*/,
+                                             audio_channel_mask_t,
+                                             audio_format_t,
+                                             audio_usage_t /*offloadUsage*/,
+                                             audio_output_flags_t,
+                                             uid_t,
+                                             bool /*directOutputRestricted*/,
+                                             bool /*vrAudioModeOn*/,
+                                             audio_io_handle_t /*spatializerOutput*/>;
+        struct OutputDecision {
+            audio_io_handle_t output;
+            audio_output_flags_t flags;
+            audio_port_handle_t selectedDeviceId;
+            output_type_t outputType;
+            bool isSpatialized;
+        };
+        bool mOutputDecisionCacheEnabled;
+        std::map<OutputDecisionKey, OutputDecision> mOutputDecisionCache;
+
+        // Window in ms during which the output routing updates triggered by routing events are
+        // merged and applied once, 0 if they are applied immediately.
+        uint32_t mRoutingCoalescingMs;
+        bool mRoutingUpdatePending = false;
+        bool mPendingForceVolumeReeval = false;
+
 private:
         sp<SourceClientDescriptor> startAudioSourceInternal(
                 const struct audio_port_config *source, const audio_attributes_t *attributes,
@@ -1071,6 +1131,13 @@ protected:
                 std::vector<sp<AudioPolicyMix>> *secondaryMixes,
                 output_type_t *outputType,
                 bool *isSpatialized);
+        OutputDecisionKey makeOutputDecisionKey(const audio_attributes_t& attr,
+                audio_stream_type_t stream,
+                uid_t uid,
+                const audio_config_t *config,
+                audio_output_flags_t flags);
+        // returns true if the HAL reports that VR audio mode is on
+        bool isVrAudioModeOn();
         // internal method to return the output handle for the given device and format
         virtual audio_io_handle_t getOutputForDevices(
                 const DeviceVector &devices,
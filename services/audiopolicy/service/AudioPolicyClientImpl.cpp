@@ -282,6 +282,11 @@ void AudioPolicyService::AudioPolicyClient::onVolumeRangeInitRequest()
     mAudioPolicyService->onVolumeRangeInitRequest();
 }
 
+void AudioPolicyService::AudioPolicyClient::scheduleDeferredRoutingUpdate(int delayMs)
+{
+    mAudioPolicyService->scheduleDeferredRoutingUpdate(delayMs);
+}
+
 audio_unique_id_t AudioPolicyService::AudioPolicyClient::newAudioUniqueId(audio_unique_id_use_t use)
 {
     return AudioSystem::newAudioUniqueId(use);
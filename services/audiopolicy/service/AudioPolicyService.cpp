@@ -21,6 +21,8 @@
 #undef __STRICT_ANSI__
 #define __STDINT_LIMITS
 #define __STDC_LIMIT_MACROS
+#include <algorithm>
+#include <inttypes.h>
 #include <stdint.h>
 #include <sys/time.h>
 #include <dlfcn.h>
@@ -244,6 +246,10 @@ void AudioPolicyService::onFirstRef()
         mAudioCommandThread = new AudioCommandThread(String8("ApmAudio"), this);
         // start output activity command thread
         mOutputCommandThread = new AudioCommandThread(String8("ApmOutput"), this);
+        // start audio patch command thread
+        mPatchCommandThread = new AudioCommandThread(String8("ApmPatch"), this);
+        // start set parameters command thread
+        mParametersCommandThread = new AudioCommandThread(String8("ApmParameters"), this);
 
         mAudioPolicyClient = new AudioPolicyClient(this);
 
@@ -297,6 +303,8 @@ AudioPolicyService::~AudioPolicyService()
 {
     mAudioCommandThread->exit();
     mOutputCommandThread->exit();
+    mPatchCommandThread->exit();
+    mParametersCommandThread->exit();
 
     mDestroyAudioPolicyManager(mAudioPolicyManager);
     unloadAudioPolicyManager();
@@ -507,6 +515,21 @@ void AudioPolicyService::doOnVolumeRangeInitRequest()
     }
 }
 
+void AudioPolicyService::scheduleDeferredRoutingUpdate(int delayMs)
+{
+    mOutputCommandThread->deferredRoutingUpdateCommand(delayMs);
+}
+
+void AudioPolicyService::doOnDeferredRoutingUpdate()
+{
+    Mutex::Autolock _l(mLock);
+    if (mAudioPolicyManager == nullptr) {
+        return;
+    }
+    mAudioPolicyManager->onDeferredRoutingUpdate();
+    onCheckSpatializer_l();
+}
+
 void AudioPolicyService::onCheckSpatializer()
 {
     Mutex::Autolock _l(mLock);
@@ -602,19 +625,19 @@ status_t AudioPolicyService::clientCreateAudioPatch(const struct audio_patch *pa
                                                 audio_patch_handle_t *handle,
                                                 int delayMs)
 {
-    return mAudioCommandThread->createAudioPatchCommand(patch, handle, delayMs);
+    return mPatchCommandThread->createAudioPatchCommand(patch, handle, delayMs);
 }
 
 status_t AudioPolicyService::clientReleaseAudioPatch(audio_patch_handle_t handle,
                                                  int delayMs)
 {
-    return mAudioCommandThread->releaseAudioPatchCommand(handle, delayMs);
+    return mPatchCommandThread->releaseAudioPatchCommand(handle, delayMs);
 }
 
 status_t AudioPolicyService::clientSetAudioPortConfig(const struct audio_port_config *config,
                                                       int delayMs)
 {
-    return mAudioCommandThread->setAudioPortConfigCommand(config, delayMs);
+    return mPatchCommandThread->setAudioPortConfigCommand(config, delayMs);
 }
 
 AudioPolicyService::NotificationClient::NotificationClient(
@@ -1206,6 +1229,19 @@ status_t AudioPolicyService::dump(int fd, const Vector<String16>& args __unused)
             mOutputCommandThread->dump(fd);
         }
 
+        String8 pctPtr = String8::format("PatchCommandThread: %p\n", mPatchCommandThread.get());
+        write(fd, pctPtr.string(), pctPtr.size());
+        if (mPatchCommandThread != 0) {
+            mPatchCommandThread->dump(fd);
+        }
+
+        String8 prctPtr = String8::format("ParametersCommandThread: %p\n",
+                mParametersCommandThread.get());
+        write(fd, prctPtr.string(), prctPtr.size());
+        if (mParametersCommandThread != 0) {
+            mParametersCommandThread->dump(fd);
+        }
+
         if (mAudioPolicyManager) {
             mAudioPolicyManager->dump(fd);
         } else {
@@ -1336,9 +1372,11 @@ status_t AudioPolicyService::onTransact(
     }
 
     const std::string methodName = getIAudioPolicyServiceStatistics().getMethodForCode(code);
+    const uid_t callingUid = IPCThreadState::self()->getCallingUid();
     mediautils::TimeCheck check(
             std::string("IAudioPolicyService::").append(methodName),
-            [code, methodName](bool timeout, float elapsedMs) { // don't move methodName.
+            [code, methodName, callingUid](bool timeout, float elapsedMs) {
+        // don't move methodName.
         if (timeout) {
             mediametrics::LogItem(AMEDIAMETRICS_KEY_AUDIO_POLICY)
                 .set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_TIMEOUT)
@@ -1346,7 +1384,17 @@ status_t AudioPolicyService::onTransact(
                 .set(AMEDIAMETRICS_PROP_METHODNAME, methodName.c_str())
                 .record();
         } else {
-            getIAudioPolicyServiceStatistics().event(code, elapsedMs);
+            auto& statistics = getIAudioPolicyServiceStatistics();
+            statistics.event(code, elapsedMs, callingUid);
+            if (const std::string summary =
+                    statistics.getPeriodicSummary(statistics.kSummaryPeriod);
+                    !summary.empty()) {
+                mediametrics::LogItem(AMEDIAMETRICS_KEY_AUDIO_POLICY)
+                    .set(AMEDIAMETRICS_PROP_EVENT,
+                            AMEDIAMETRICS_PROP_EVENT_VALUE_METHODSTATISTICS)
+                    .set(AMEDIAMETRICS_PROP_METHODHISTOGRAMS, summary.c_str())
+                    .record();
+            }
         }
     }, mediautils::TimeCheck::kDefaultTimeoutDuration,
     mediautils::TimeCheck::kDefaultSecondChanceDuration,
@@ -1981,6 +2029,7 @@ bool AudioPolicyService::AudioCommandThread::threadLoop()
                   ++numTimesBecameEmpty;
                 }
                 mLastCommand = command;
+                const nsecs_t startTime = systemTime();
 
                 switch (command->mCommand) {
                 case SET_VOLUME: {
@@ -2217,9 +2266,23 @@ bool AudioPolicyService::AudioCommandThread::threadLoop()
                     mLock.lock();
                     } break;
 
+                case DEFERRED_ROUTING_UPDATE: {
+                    ALOGV("AudioCommandThread() processing deferred routing update");
+                    svc = mService.promote();
+                    if (svc == 0) {
+                        break;
+                    }
+                    mLock.unlock();
+                    svc->doOnDeferredRoutingUpdate();
+                    mLock.lock();
+                    } break;
+
                 default:
                     ALOGW("AudioCommandThread() unknown command %d", command->mCommand);
                 }
+                const nsecs_t endTime = systemTime();
+                mLatency.add(endTime - command->mTime);
+                mExecutionTime.add(endTime - startTime);
                 {
                     Mutex::Autolock _l(command->mLock);
                     if (command->mWaitStatus) {
@@ -2292,6 +2355,9 @@ status_t AudioPolicyService::AudioCommandThread::dump(int fd)
         result.append("     none\n");
     }
 
+    mLatency.dump(&result, "Latency");
+    mExecutionTime.dump(&result, "Execution");
+
     write(fd, result.string(), result.size());
 
     dumpReleaseLock(mLock, locked);
@@ -2299,6 +2365,28 @@ status_t AudioPolicyService::AudioCommandThread::dump(int fd)
     return NO_ERROR;
 }
 
+void AudioPolicyService::AudioCommandThread::LatencyHistogram::add(nsecs_t latencyNs)
+{
+    const nsecs_t latencyMs = ns2ms(latencyNs);
+    size_t bin = 0;
+    while (bin < kNumBins - 1 && latencyMs >= kBinLimitsMs[bin]) {
+        bin++;
+    }
+    mCounts[bin]++;
+    mMaxNs = std::max(mMaxNs, latencyNs);
+}
+
+void AudioPolicyService::AudioCommandThread::LatencyHistogram::dump(
+        String8 *dst, const char *name) const
+{
+    dst->appendFormat("  %s (ms):", name);
+    for (size_t bin = 0; bin < kNumBins - 1; bin++) {
+        dst->appendFormat(" <%d: %" PRIu64, kBinLimitsMs[bin], mCounts[bin]);
+    }
+    dst->appendFormat(" >=%d: %" PRIu64 ", max %.3f\n",
+            kBinLimitsMs[kNumBins - 2], mCounts[kNumBins - 1], mMaxNs * 1e-6);
+}
+
 status_t AudioPolicyService::AudioCommandThread::volumeCommand(audio_stream_type_t stream,
                                                                float volume,
                                                                audio_io_handle_t output,
@@ -2561,6 +2649,14 @@ void AudioPolicyService::AudioCommandThread::volRangeInitReqCommand()
     sendCommand(command);
 }
 
+void AudioPolicyService::AudioCommandThread::deferredRoutingUpdateCommand(int delayMs)
+{
+    sp<AudioCommand>command = new AudioCommand();
+    command->mCommand = DEFERRED_ROUTING_UPDATE;
+    ALOGV("AudioCommandThread() adding deferred routing update delay %d", delayMs);
+    sendCommand(command, delayMs);
+}
+
 status_t AudioPolicyService::AudioCommandThread::sendCommand(sp<AudioCommand>& command, int delayMs)
 {
     {
@@ -2732,6 +2828,10 @@ void AudioPolicyService::AudioCommandThread::insertCommand_l(sp<AudioCommand>& c
             // command may come from different requests, do not filter
         } break;
 
+        case DEFERRED_ROUTING_UPDATE: {
+            // audio policy manager has at most one update pending, do not filter
+        } break;
+
         default:
             break;
         }
@@ -2791,8 +2891,8 @@ void AudioPolicyService::setParameters(audio_io_handle_t ioHandle,
                                        const char *keyValuePairs,
                                        int delayMs)
 {
-    mAudioCommandThread->parametersCommand(ioHandle, keyValuePairs,
-                                           delayMs);
+    mParametersCommandThread->parametersCommand(ioHandle, keyValuePairs,
+                                                delayMs);
 }
 
 int AudioPolicyService::setStreamVolume(audio_stream_type_t stream,
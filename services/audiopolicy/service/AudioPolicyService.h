@@ -44,6 +44,7 @@
 #include <android/hardware/BnSensorPrivacyListener.h>
 #include <android/content/AttributionSourceState.h>
 
+#include <iterator>
 #include <unordered_map>
 
 namespace android {
@@ -348,6 +349,9 @@ public:
     void onVolumeRangeInitRequest();
     void doOnVolumeRangeInitRequest();
 
+    void scheduleDeferredRoutingUpdate(int delayMs);
+    void doOnDeferredRoutingUpdate();
+
     /**
      * Spatializer SpatializerPolicyCallback implementation.
      * onCheckSpatializer() sends an event on mOutputCommandThread which executes
@@ -538,6 +542,7 @@ private:
             CHECK_SPATIALIZER_OUTPUT, // verify if spatializer effect should be created or moved
             UPDATE_ACTIVE_SPATIALIZER_TRACKS, // Update active track counts on spalializer output
             VOL_RANGE_INIT_REQUEST, // request to reset the volume range indices
+            DEFERRED_ROUTING_UPDATE, // apply routing updates coalesced by audio policy manager
         };
 
         AudioCommandThread (String8 name, const wp<AudioPolicyService>& service);
@@ -590,6 +595,7 @@ private:
                     void        checkSpatializerCommand();
                     void        updateActiveSpatializerTracksCommand();
                     void        volRangeInitReqCommand();
+                    void        deferredRoutingUpdateCommand(int delayMs);
 
                     void        insertCommand_l(AudioCommand *command, int delayMs = 0);
     private:
@@ -700,12 +706,28 @@ private:
             bool mSuspended;
         };
 
+        // Histogram of command latencies, for dumpsys.
+        class LatencyHistogram {
+        public:
+            void add(nsecs_t latencyNs);
+            void dump(String8 *dst, const char *name) const;
+        private:
+            static constexpr int kBinLimitsMs[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+            static constexpr size_t kNumBins = std::size(kBinLimitsMs) + 1;  // last bin unbounded
+            uint64_t mCounts[kNumBins] = {};
+            nsecs_t mMaxNs = 0;
+        };
+
         Mutex   mLock;
         Condition mWaitWorkCV;
         Vector < sp<AudioCommand> > mAudioCommands; // list of pending commands
         sp<AudioCommand> mLastCommand;      // last processed command (used by dump)
         String8 mName;                      // string used by wake lock fo delayed commands
         wp<AudioPolicyService> mService;
+        // from the time a command was due to its completion, including the wait behind the
+        // commands before it
+        LatencyHistogram mLatency;
+        LatencyHistogram mExecutionTime;    // time spent executing a command
     };
 
     class AudioPolicyClient : public AudioPolicyClientInterface
@@ -819,6 +841,8 @@ private:
 
         virtual void onVolumeRangeInitRequest();
 
+        void scheduleDeferredRoutingUpdate(int delayMs) override;
+
         virtual audio_unique_id_t newAudioUniqueId(audio_unique_id_use_t use);
 
         void setSoundTriggerCaptureState(bool active) override;
@@ -1041,8 +1065,13 @@ private:
     // Note: lock acquisition order is always mLock > mEffectsLock:
     // mLock protects AudioPolicyManager methods that can call into audio flinger
     // and possibly back in to audio policy service and acquire mEffectsLock.
-    sp<AudioCommandThread> mAudioCommandThread;     // audio commands thread
+    // Commands are spread over several threads, so that a slow HAL call of one kind (e.g. an
+    // audio patch) does not hold back the others (e.g. volume). Commands that go to the same
+    // thread keep their order.
+    sp<AudioCommandThread> mAudioCommandThread;     // volume and effect commands
     sp<AudioCommandThread> mOutputCommandThread;    // process stop and release output
+    sp<AudioCommandThread> mPatchCommandThread;     // audio patch and port config commands
+    sp<AudioCommandThread> mParametersCommandThread; // set parameters commands
     AudioPolicyInterface *mAudioPolicyManager;
     AudioPolicyClient *mAudioPolicyClient;
     std::vector<audio_usage_t> mSupportedSystemUsages;
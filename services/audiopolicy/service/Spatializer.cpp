@@ -122,12 +122,6 @@ public:
     };
     static constexpr const char *kNumFramesKey = "numFrames";
     static constexpr const char *kModeKey = "mode";
-    static constexpr const char *kTranslation0Key = "translation0";
-    static constexpr const char *kTranslation1Key = "translation1";
-    static constexpr const char *kTranslation2Key = "translation2";
-    static constexpr const char *kRotation0Key = "rotation0";
-    static constexpr const char *kRotation1Key = "rotation1";
-    static constexpr const char *kRotation2Key = "rotation2";
     static constexpr const char *kLatencyModesKey = "latencyModes";
 
     class LatencyModes : public RefBase {
@@ -166,16 +160,9 @@ public:
                     spatializer->calculateHeadPose();
                 }
                 } break;
-            case kWhatOnHeadToStagePose: {
-                std::vector<float> headToStage(sHeadPoseKeys.size());
-                for (size_t i = 0 ; i < sHeadPoseKeys.size(); i++) {
-                    if (!msg->findFloat(sHeadPoseKeys[i], &headToStage[i])) {
-                        ALOGE("%s: Cannot find kTranslation0Key!", __func__);
-                        return;
-                    }
-                }
-                spatializer->onHeadToStagePoseMsg(headToStage);
-                } break;
+            case kWhatOnHeadToStagePose:
+                spatializer->onHeadToStagePoseMsg();
+                break;
             case kWhatOnActualModeChange: {
                 int mode;
                 if (!msg->findInt32(kModeKey, &mode)) {
@@ -205,15 +192,6 @@ private:
     std::once_flag mPrioritySetFlag;
 };
 
-const std::vector<const char *> Spatializer::sHeadPoseKeys = {
-    Spatializer::EngineCallbackHandler::kTranslation0Key,
-    Spatializer::EngineCallbackHandler::kTranslation1Key,
-    Spatializer::EngineCallbackHandler::kTranslation2Key,
-    Spatializer::EngineCallbackHandler::kRotation0Key,
-    Spatializer::EngineCallbackHandler::kRotation1Key,
-    Spatializer::EngineCallbackHandler::kRotation2Key,
-};
-
 // ---------------------------------------------------------------------------
 sp<Spatializer> Spatializer::create(SpatializerPolicyCallback *callback) {
     sp<Spatializer> spatializer;
@@ -758,14 +736,21 @@ void Spatializer::onHeadToStagePose(const Pose3f& headToStage) {
             "onHeadToStagePose() called with no head tracking support!");
 
     auto vec = headToStage.toVector();
-    LOG_ALWAYS_FATAL_IF(vec.size() != sHeadPoseKeys.size(),
+    LOG_ALWAYS_FATAL_IF(vec.size() != kHeadPoseSize,
             "%s invalid head to stage vector size %zu", __func__, vec.size());
-    sp<AMessage> msg =
-            new AMessage(EngineCallbackHandler::kWhatOnHeadToStagePose, mHandler);
-    for (size_t i = 0 ; i < sHeadPoseKeys.size(); i++) {
-        msg->setFloat(sHeadPoseKeys[i], vec[i]);
+    // Poses arrive at sensor rate. Only the most recent one is applied to the engine, so a
+    // message is posted only if the handler has consumed the previous pose.
+    bool post;
+    {
+        std::lock_guard lock(mPendingHeadToStageLock);
+        post = mPendingHeadToStage.empty();
+        mPendingHeadToStage = std::move(vec);
+    }
+    if (post) {
+        sp<AMessage> msg =
+                new AMessage(EngineCallbackHandler::kWhatOnHeadToStagePose, mHandler);
+        msg->post();
     }
-    msg->post();
 }
 
 void Spatializer::resetEngineHeadPose_l() {
@@ -773,20 +758,34 @@ void Spatializer::resetEngineHeadPose_l() {
     if (mEngine == nullptr) {
         return;
     }
-    const std::vector<float> headToStage(6, 0.0);
+    const std::vector<float> headToStage(kHeadPoseSize, 0.0);
     setEffectParameter_l(SPATIALIZER_PARAM_HEAD_TO_STAGE, headToStage);
+    mEngineHeadToStage = headToStage;
     setEffectParameter_l(SPATIALIZER_PARAM_HEADTRACKING_MODE,
             std::vector<SpatializerHeadTrackingMode>{SpatializerHeadTrackingMode::DISABLED});
 }
 
-void Spatializer::onHeadToStagePoseMsg(const std::vector<float>& headToStage) {
+void Spatializer::onHeadToStagePoseMsg() {
     ALOGV("%s", __func__);
+    std::vector<float> headToStage;
+    {
+        std::lock_guard lock(mPendingHeadToStageLock);
+        headToStage.swap(mPendingHeadToStage);
+    }
+    if (headToStage.empty()) {
+        return;
+    }
     sp<media::ISpatializerHeadTrackingCallback> callback;
     {
         std::lock_guard lock(mLock);
         callback = mHeadTrackingCallback;
         if (mEngine != nullptr) {
-            setEffectParameter_l(SPATIALIZER_PARAM_HEAD_TO_STAGE, headToStage);
+            // Each update is an effect command round trip to the audio HAL, skip it while
+            // the head is still.
+            if (headToStage != mEngineHeadToStage) {
+                setEffectParameter_l(SPATIALIZER_PARAM_HEAD_TO_STAGE, headToStage);
+                mEngineHeadToStage = headToStage;
+            }
             const auto record = recordFromTranslationRotationVector(headToStage);
             mPoseRecorder.record(record);
             mPoseDurableRecorder.record(record);
@@ -861,6 +860,7 @@ status_t Spatializer::attachOutput(audio_io_handle_t output, size_t numActiveTra
             // remove FX instance
             mEngine->setEnabled(false);
             mEngine.clear();
+            mEngineHeadToStage.clear();
             mPoseController.reset();
             AudioSystem::removeSupportedLatencyModesCallback(this);
         }
@@ -925,6 +925,7 @@ audio_io_handle_t Spatializer::detachOutput() {
         // remove FX instance
         mEngine->setEnabled(false);
         mEngine.clear();
+        mEngineHeadToStage.clear();
         AudioSystem::removeSupportedLatencyModesCallback(this);
         output = mOutput;
         mOutput = AUDIO_IO_HANDLE_NONE;
@@ -187,7 +187,7 @@ private:
     void onHeadToStagePose(const media::Pose3f& headToStage) override;
     void onActualModeChange(media::HeadTrackingMode mode) override;
 
-    void onHeadToStagePoseMsg(const std::vector<float>& headToStage);
+    void onHeadToStagePoseMsg();
     void onActualModeChangeMsg(media::HeadTrackingMode mode);
     void onSupportedLatencyModesChangedMsg(
             audio_io_handle_t output, std::vector<audio_latency_mode_t>&& modes);
@@ -398,7 +398,15 @@ private:
     size_t mNumActiveTracks GUARDED_BY(mLock) = 0;
     std::vector<audio_latency_mode_t> mSupportedLatencyModes GUARDED_BY(mLock);
 
-    static const std::vector<const char*> sHeadPoseKeys;
+    // Number of values in a head to stage pose: translation then rotation vector.
+    static constexpr size_t kHeadPoseSize = 6;
+
+    // Latest pose from the pose controller not yet consumed by the callback handler.
+    std::mutex mPendingHeadToStageLock;
+    std::vector<float> mPendingHeadToStage GUARDED_BY(mPendingHeadToStageLock);
+
+    // Last pose sent to the engine, empty if unknown.
+    std::vector<float> mEngineHeadToStage GUARDED_BY(mLock);
 
     // Local log for command messages.
     static constexpr int mMaxLocalLogLine = 10;
@@ -84,6 +84,26 @@ constexpr float kScreenStillnessTranslationThreshold = 0.1f;
 // Screen is considered to have moved significantly if rotated by this much (in radians, approx).
 constexpr float kScreenStillnessRotationThreshold = 15.0f / 180 * M_PI;
 
+// In incremental mode, the pose graph is only recomputed this often while the sensors are still.
+// This must be well below kFreshnessTimeout.
+constexpr auto kStillRecalculationPeriod = 40ms;
+
+// In incremental mode, a sensor is considered still if translated by less than this much (in
+// meters, approx) since the last recomputation.
+constexpr float kStillTranslationThreshold = 0.005f;
+
+// In incremental mode, a sensor is considered still if rotated by less than this much (in radians,
+// approx) since the last recomputation.
+constexpr float kStillRotationThreshold = 0.5f / 180 * M_PI;
+
+// In incremental mode, the head-to-stage pose is only reported when translated by this much (in
+// meters, approx) since the last reported pose.
+constexpr float kOutputTranslationThreshold = 0.002f;
+
+// In incremental mode, the head-to-stage pose is only reported when rotated by this much (in
+// radians, approx) since the last reported pose.
+constexpr float kOutputRotationThreshold = 0.25f / 180 * M_PI;
+
 // Time units for system clock ticks. This is what the Sensor Framework timestamps represent and
 // what we use for pose filtering.
 using Ticks = std::chrono::nanoseconds;
@@ -102,6 +122,8 @@ SpatializerPoseController::SpatializerPoseController(Listener* listener,
                                         std::optional<std::chrono::microseconds> maxUpdatePeriod)
     : mListener(listener),
       mSensorPeriod(sensorPeriod),
+      mIncrementalProcessing(
+              property_get_bool("audio.spatializer.incremental_pose_processing", false)),
       mProcessor(createHeadTrackingProcessor(HeadTrackingProcessor::Options{
               .maxTranslationalVelocity = kMaxTranslationalVelocity / kTicksPerSecond,
               .maxRotationalVelocity = kMaxRotationalVelocity / kTicksPerSecond,
@@ -121,6 +143,12 @@ SpatializerPoseController::SpatializerPoseController(Listener* listener,
               .screenStillnessWindowDuration = Ticks(kScreenStillnessWindowDuration).count(),
               .screenStillnessTranslationalThreshold = kScreenStillnessTranslationThreshold,
               .screenStillnessRotationalThreshold = kScreenStillnessRotationThreshold,
+              .stillRecalculationPeriod =
+                      mIncrementalProcessing ? Ticks(kStillRecalculationPeriod).count() : 0,
+              .stillTranslationalThreshold = kStillTranslationThreshold,
+              .stillRotationalThreshold = kStillRotationThreshold,
+              .outputTranslationalThreshold = kOutputTranslationThreshold,
+              .outputRotationalThreshold = kOutputRotationThreshold,
       })),
       mPoseProvider(SensorPoseProvider::create("headtracker", this)),
       mThread([this, maxUpdatePeriod] { // It's important that mThread is initialized after
@@ -128,7 +156,7 @@ SpatializerPoseController::SpatializerPoseController(Listener* listener,
                                         // function that may use any member
                                         // of this class.
           while (true) {
-              Pose3f headToStage;
+              std::optional<Pose3f> headToStage;
               std::optional<HeadTrackingMode> modeIfChanged;
               {
                   std::unique_lock lock(mMutex);
@@ -148,7 +176,9 @@ SpatializerPoseController::SpatializerPoseController(Listener* listener,
               }
 
               // Invoke the callbacks outside the lock.
-              mListener->onHeadToStagePose(headToStage);
+              if (headToStage) {
+                  mListener->onHeadToStagePose(headToStage.value());
+              }
               if (modeIfChanged) {
                   mListener->onActualModeChange(modeIfChanged.value());
               }
@@ -282,14 +312,16 @@ void SpatializerPoseController::waitUntilCalculated() {
     mCondVar.wait(lock, [this] { return mCalculated; });
 }
 
-std::tuple<media::Pose3f, std::optional<media::HeadTrackingMode>>
+std::tuple<std::optional<media::Pose3f>, std::optional<media::HeadTrackingMode>>
 SpatializerPoseController::calculate_l() {
-    Pose3f headToStage;
+    std::optional<Pose3f> headToStage;
     HeadTrackingMode mode;
     std::optional<media::HeadTrackingMode> modeIfChanged;
 
     mProcessor->calculate(elapsedRealtimeNano());
-    headToStage = mProcessor->getHeadToStagePose();
+    if (!mIncrementalProcessing || mProcessor->hasOutputChanged()) {
+        headToStage = mProcessor->getHeadToStagePose();
+    }
     mode = mProcessor->getActualMode();
     if (!mActualMode.has_value() || mActualMode.value() != mode) {
         mActualMode = mode;
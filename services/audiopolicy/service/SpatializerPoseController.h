@@ -133,6 +133,8 @@ class SpatializerPoseController : private media::SensorPoseProvider::Listener {
     mutable std::timed_mutex mMutex;
     Listener* const mListener;
     const std::chrono::microseconds mSensorPeriod;
+    // Whether the processor runs in incremental mode and only changed poses are reported.
+    const bool mIncrementalProcessing;
     // Order matters for the following two members to ensure correct destruction.
     std::unique_ptr<media::HeadTrackingProcessor> mProcessor;
     std::unique_ptr<media::SensorPoseProvider> mPoseProvider;
@@ -167,9 +169,11 @@ class SpatializerPoseController : private media::SensorPoseProvider::Listener {
 
     /**
      * Calculates the new outputs and updates internal state. Must be called with the lock held.
-     * Returns values that should be passed to the respective callbacks.
+     * Returns values that should be passed to the respective callbacks, the pose being nullopt if
+     * it has not changed noticeably since the last one reported in incremental mode.
      */
-    std::tuple<media::Pose3f, std::optional<media::HeadTrackingMode>> calculate_l();
+    std::tuple<std::optional<media::Pose3f>, std::optional<media::HeadTrackingMode>>
+    calculate_l();
 };
 
 }  // namespace android
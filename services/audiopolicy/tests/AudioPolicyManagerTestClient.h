@@ -145,6 +145,14 @@ public:
 
     }
 
+    void scheduleDeferredRoutingUpdate(int delayMs __unused) override {
+        mDeferredRoutingUpdateCount++;
+    }
+
+    size_t getDeferredRoutingUpdateCount() const {
+        return mDeferredRoutingUpdateCount;
+    }
+
     status_t updateSecondaryOutputs(
             const TrackSecondaryOutputsMap& trackSecondaryOutputs __unused) override {
         return NO_ERROR;
@@ -158,6 +166,7 @@ private:
     std::set<std::string> mAllowedModuleNames;
     size_t mAudioPortListUpdateCount = 0;
     size_t mRoutingUpdatedUpdateCount = 0;
+    size_t mDeferredRoutingUpdateCount = 0;
 };
 
 } // namespace android
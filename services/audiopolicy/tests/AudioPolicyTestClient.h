@@ -85,6 +85,7 @@ public:
                                         audio_patch_handle_t patchHandle __unused,
                                         audio_source_t source __unused) override { }
     void onRoutingUpdated() override { }
+    void scheduleDeferredRoutingUpdate(int delayMs __unused) override { }
     void onVolumeRangeInitRequest() override { }
     void setEffectSuspended(int effectId __unused,
                             audio_session_t sessionId __unused,
@@ -37,6 +37,8 @@ class AudioPolicyTestManager : public AudioPolicyManager {
     using AudioPolicyManager::getDirectProfilesForAttributes;
     using AudioPolicyManager::setDeviceConnectionState;
     using AudioPolicyManager::deviceToAudioPort;
+    using AudioPolicyManager::setOutputDecisionCacheEnabled;
+    using AudioPolicyManager::setRoutingCoalescingMs;
     uint32_t getAudioPortGeneration() const { return mAudioPortGeneration; }
 };
 
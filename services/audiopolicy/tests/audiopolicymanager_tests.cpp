@@ -1632,6 +1632,69 @@ TEST_F(AudioPolicyManagerTestDeviceConnection, RoutingUpdate) {
     ASSERT_EQ(3, mClient->getRoutingUpdatedCounter());
 }
 
+TEST_F(AudioPolicyManagerTestDeviceConnection, CoalescedRoutingUpdates) {
+    mManager->setRoutingCoalescingMs(50);
+    auto config = mManager->getForceUse(AUDIO_POLICY_FORCE_FOR_MEDIA);
+    auto newConfig = config == AUDIO_POLICY_FORCE_BT_A2DP ?
+            AUDIO_POLICY_FORCE_NONE : AUDIO_POLICY_FORCE_BT_A2DP;
+
+    // A burst of routing events schedules a single deferred routing update
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(
+            AUDIO_DEVICE_OUT_BLUETOOTH_SCO, AUDIO_POLICY_DEVICE_STATE_AVAILABLE,
+            "a", "b", AUDIO_FORMAT_DEFAULT));
+    mManager->setForceUse(AUDIO_POLICY_FORCE_FOR_MEDIA, newConfig);
+    mManager->setForceUse(AUDIO_POLICY_FORCE_FOR_MEDIA, config);
+    EXPECT_EQ(1, mClient->getDeferredRoutingUpdateCount());
+
+    // Once the update is applied, the next event schedules a new one
+    mManager->onDeferredRoutingUpdate();
+    mManager->setForceUse(AUDIO_POLICY_FORCE_FOR_MEDIA, newConfig);
+    EXPECT_EQ(2, mClient->getDeferredRoutingUpdateCount());
+    mManager->onDeferredRoutingUpdate();
+
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(
+            AUDIO_DEVICE_OUT_BLUETOOTH_SCO, AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE,
+            "a", "b", AUDIO_FORMAT_DEFAULT));
+    mManager->onDeferredRoutingUpdate();
+}
+
+TEST_F(AudioPolicyManagerTestDeviceConnection, OutputDecisionCacheFollowsConnection) {
+    mManager->setOutputDecisionCacheEnabled(true);
+    const std::string hdmiAddress = "audio_policy_test_out_hdmi";
+
+    audio_port_handle_t speakerId = AUDIO_PORT_HANDLE_NONE;
+    audio_io_handle_t speakerOutput = AUDIO_IO_HANDLE_NONE;
+    getOutputForAttr(&speakerId, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO,
+            k48000SamplingRate, AUDIO_OUTPUT_FLAG_NONE, &speakerOutput);
+    // The same request is served from the cache with the same decision.
+    audio_port_handle_t selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    audio_io_handle_t output = AUDIO_IO_HANDLE_NONE;
+    getOutputForAttr(&selectedDeviceId, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO,
+            k48000SamplingRate, AUDIO_OUTPUT_FLAG_NONE, &output);
+    EXPECT_EQ(speakerId, selectedDeviceId);
+    EXPECT_EQ(speakerOutput, output);
+
+    // Connecting a device must not return the decision cached before the connection.
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(
+            AUDIO_DEVICE_OUT_HDMI, AUDIO_POLICY_DEVICE_STATE_AVAILABLE,
+            hdmiAddress.c_str(), "test_out_hdmi", AUDIO_FORMAT_DEFAULT));
+    audio_port_v7 hdmiPort;
+    ASSERT_TRUE(findDevicePort(AUDIO_PORT_ROLE_SINK, AUDIO_DEVICE_OUT_HDMI, hdmiAddress,
+            &hdmiPort));
+    selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    getOutputForAttr(&selectedDeviceId, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO,
+            k48000SamplingRate, AUDIO_OUTPUT_FLAG_NONE);
+    EXPECT_EQ(hdmiPort.id, selectedDeviceId);
+
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(
+            AUDIO_DEVICE_OUT_HDMI, AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE,
+            hdmiAddress.c_str(), "test_out_hdmi", AUDIO_FORMAT_DEFAULT));
+    selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    getOutputForAttr(&selectedDeviceId, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO,
+            k48000SamplingRate, AUDIO_OUTPUT_FLAG_NONE);
+    EXPECT_EQ(speakerId, selectedDeviceId);
+}
+
 TEST_P(AudioPolicyManagerTestDeviceConnection, SetDeviceConnectionState) {
     const audio_devices_t type = std::get<0>(GetParam());
     const std::string name = std::get<1>(GetParam());
@@ -25,8 +25,10 @@
 #define ALOGVV(...) if (0) ALOGV(__VA_ARGS__)
 #endif
 
+#include <algorithm>
 #include <inttypes.h>
 
+#include <android-base/properties.h>
 #include <utils/Log.h>
 #include <utils/Trace.h>
 #include <gui/Surface.h>
@@ -171,11 +173,13 @@ ZslProcessor::ZslProcessor(
     // Need to keep buffer queue longer than metadata queue because sometimes buffer arrives
     // earlier than metadata which causes the buffer corresponding to oldest metadata being
     // removed.
-    mFrameListDepth = pipelineMaxDepth;
+    mMaxFrameListDepth = pipelineMaxDepth;
+    mFrameListDepth = mMaxFrameListDepth;
     mBufferQueueDepth = mFrameListDepth + 1;
 
     mZslQueue.insertAt(0, mBufferQueueDepth);
     mFrameList.resize(mFrameListDepth);
+    mFrameCandidates.resize(mFrameListDepth);
     sp<CaptureSequencer> captureSequencer = mSequencer.promote();
     if (captureSequencer != 0) captureSequencer->setZslProcessor(this);
 }
@@ -212,9 +216,42 @@ void ZslProcessor::onResultAvailable(const CaptureResult &result) {
     if (timestamp <= mLatestClearedBufferTimestamp) return;
 
     mFrameList[mFrameListHead] = result.mMetadata;
+    FrameCandidate &candidate = mFrameCandidates[mFrameListHead];
+    candidate.timestamp = timestamp;
+    candidate.goodForCapture = isGoodCandidate(result.mMetadata);
     mFrameListHead = (mFrameListHead + 1) % mFrameListDepth;
 }
 
+void ZslProcessor::updateQueueDepthLocked(const Parameters &params) {
+    size_t frameListDepth = mMaxFrameListDepth;
+
+    // A zero budget keeps the full pipeline depth. Low RAM devices default to a budget small
+    // enough to keep only a couple of full size buffers around.
+    bool lowRam = android::base::GetBoolProperty("ro.config.low_ram", false);
+    uint64_t budgetKb = android::base::GetUintProperty<uint64_t>(
+            "ro.camera.zsl.max_buffer_memory_kb", lowRam ? 32768 : 0);
+    // The ZSL stream uses an implementation defined format, which is YUV 4:2:0 in practice
+    uint64_t bufferBytes = (uint64_t) params.fastInfo.usedZslSize.width *
+            params.fastInfo.usedZslSize.height * 3 / 2;
+    if (budgetKb != 0 && bufferBytes != 0) {
+        // The buffer queue holds one more buffer than the frame list
+        uint64_t buffers = budgetKb * 1024 / bufferBytes;
+        uint64_t frames = buffers > 1 ? buffers - 1 : 0;
+        frameListDepth = std::min<uint64_t>(std::max<uint64_t>(frames, kMinFrameListDepth),
+                mMaxFrameListDepth);
+    }
+
+    if (frameListDepth == mFrameListDepth) return;
+
+    ALOGV("%s: Camera %d: ZSL frame list depth %zu -> %zu for %" PRIu64 " byte buffers",
+            __FUNCTION__, mId, mFrameListDepth, frameListDepth, bufferBytes);
+    mFrameListDepth = frameListDepth;
+    mBufferQueueDepth = mFrameListDepth + 1;
+    mZslQueue.clear();
+    mZslQueue.insertAt(0, mBufferQueueDepth);
+    clearZslResultQueueLocked();
+}
+
 status_t ZslProcessor::updateStream(const Parameters &params) {
     ATRACE_CALL();
     ALOGV("%s: Configuring ZSL streams", __FUNCTION__);
@@ -253,6 +290,7 @@ status_t ZslProcessor::updateStream(const Parameters &params) {
         sp<IGraphicBufferProducer> producer;
         sp<IGraphicBufferConsumer> consumer;
         BufferQueue::createBufferQueue(&producer, &consumer);
+        updateQueueDepthLocked(params);
         mProducer = new RingBufferConsumer(consumer, GRALLOC_USAGE_HW_CAMERA_ZSL,
             mBufferQueueDepth);
         mProducer->setName(String8("Camera2-ZslRingBufferConsumer"));
@@ -673,8 +711,10 @@ status_t ZslProcessor::clearZslQueueLocked() {
 
 void ZslProcessor::clearZslResultQueueLocked() {
     mFrameList.clear();
+    mFrameCandidates.clear();
     mFrameListHead = 0;
     mFrameList.resize(mFrameListDepth);
+    mFrameCandidates.resize(mFrameListDepth);
 }
 
 void ZslProcessor::dump(int fd, const Vector<String16>& /*args*/) const {
@@ -754,88 +794,84 @@ bool ZslProcessor::isFixedFocusMode(uint8_t afMode) const {
     }
 }
 
+bool ZslProcessor::isGoodCandidate(const CameraMetadata &frame) const {
+    camera_metadata_ro_entry_t entry;
+    entry = frame.find(ANDROID_CONTROL_AE_STATE);
+    if (entry.count == 0) {
+        /**
+         * This is most likely a HAL bug. The aeState field is
+         * mandatory, so it should always be in a metadata packet.
+         */
+        ALOGW("%s: ZSL queue frame has no AE state field!",
+                __FUNCTION__);
+        return false;
+    }
+    if (entry.data.u8[0] != ANDROID_CONTROL_AE_STATE_CONVERGED &&
+            entry.data.u8[0] != ANDROID_CONTROL_AE_STATE_LOCKED) {
+        ALOGVV("%s: ZSL queue frame AE state is %d, need "
+               "full capture",  __FUNCTION__, entry.data.u8[0]);
+        return false;
+    }
+
+    entry = frame.find(ANDROID_CONTROL_AF_MODE);
+    if (entry.count == 0) {
+        ALOGW("%s: ZSL queue frame has no AF mode field!",
+                __FUNCTION__);
+        return false;
+    }
+    // Check AF state if device has focuser and focus mode isn't fixed
+    if (mHasFocuser) {
+        uint8_t afMode = entry.data.u8[0];
+        if (!isFixedFocusMode(afMode)) {
+            // Make sure the candidate frame has good focus.
+            entry = frame.find(ANDROID_CONTROL_AF_STATE);
+            if (entry.count == 0) {
+                ALOGW("%s: ZSL queue frame has no AF state field!",
+                        __FUNCTION__);
+                return false;
+            }
+            uint8_t afState = entry.data.u8[0];
+            if (afState != ANDROID_CONTROL_AF_STATE_PASSIVE_FOCUSED &&
+                    afState != ANDROID_CONTROL_AF_STATE_FOCUSED_LOCKED &&
+                    afState != ANDROID_CONTROL_AF_STATE_NOT_FOCUSED_LOCKED) {
+                ALOGVV("%s: ZSL queue frame AF state is %d is not good for capture,"
+                        " skip it", __FUNCTION__, afState);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 nsecs_t ZslProcessor::getCandidateTimestampLocked(size_t* metadataIdx) const {
     /**
      * Find the smallest timestamp we know about so far
      * - ensure that aeState is either converged or locked
+     *
+     * The convergence of each frame is evaluated when its metadata arrives, so this only
+     * walks the candidate table.
      */
 
     size_t idx = 0;
     nsecs_t minTimestamp = -1;
 
-    size_t emptyCount = mFrameList.size();
+    size_t emptyCount = mFrameCandidates.size();
 
-    for (size_t j = 0; j < mFrameList.size(); j++) {
-        const CameraMetadata &frame = mFrameList[j];
-        if (!frame.isEmpty()) {
+    for (size_t j = 0; j < mFrameCandidates.size(); j++) {
+        const FrameCandidate &candidate = mFrameCandidates[j];
+        if (candidate.timestamp == -1) continue;
 
-            emptyCount--;
-
-            camera_metadata_ro_entry_t entry;
-            entry = frame.find(ANDROID_SENSOR_TIMESTAMP);
-            if (entry.count == 0) {
-                ALOGE("%s: Can't find timestamp in frame!",
-                        __FUNCTION__);
-                continue;
-            }
-            nsecs_t frameTimestamp = entry.data.i64[0];
-            if (minTimestamp > frameTimestamp || minTimestamp == -1) {
-
-                entry = frame.find(ANDROID_CONTROL_AE_STATE);
-
-                if (entry.count == 0) {
-                    /**
-                     * This is most likely a HAL bug. The aeState field is
-                     * mandatory, so it should always be in a metadata packet.
-                     */
-                    ALOGW("%s: ZSL queue frame has no AE state field!",
-                            __FUNCTION__);
-                    continue;
-                }
-                if (entry.data.u8[0] != ANDROID_CONTROL_AE_STATE_CONVERGED &&
-                        entry.data.u8[0] != ANDROID_CONTROL_AE_STATE_LOCKED) {
-                    ALOGVV("%s: ZSL queue frame AE state is %d, need "
-                           "full capture",  __FUNCTION__, entry.data.u8[0]);
-                    continue;
-                }
-
-                entry = frame.find(ANDROID_CONTROL_AF_MODE);
-                if (entry.count == 0) {
-                    ALOGW("%s: ZSL queue frame has no AF mode field!",
-                            __FUNCTION__);
-                    continue;
-                }
-                // Check AF state if device has focuser and focus mode isn't fixed
-                if (mHasFocuser) {
-                    uint8_t afMode = entry.data.u8[0];
-                    if (!isFixedFocusMode(afMode)) {
-                        // Make sure the candidate frame has good focus.
-                        entry = frame.find(ANDROID_CONTROL_AF_STATE);
-                        if (entry.count == 0) {
-                            ALOGW("%s: ZSL queue frame has no AF state field!",
-                                    __FUNCTION__);
-                            continue;
-                        }
-                        uint8_t afState = entry.data.u8[0];
-                        if (afState != ANDROID_CONTROL_AF_STATE_PASSIVE_FOCUSED &&
-                                afState != ANDROID_CONTROL_AF_STATE_FOCUSED_LOCKED &&
-                                afState != ANDROID_CONTROL_AF_STATE_NOT_FOCUSED_LOCKED) {
-                            ALOGVV("%s: ZSL queue frame AF state is %d is not good for capture,"
-                                    " skip it", __FUNCTION__, afState);
-                            continue;
-                        }
-                    }
-                }
-
-                minTimestamp = frameTimestamp;
-                idx = j;
-            }
-
-            ALOGVV("%s: Saw timestamp %" PRId64, __FUNCTION__, frameTimestamp);
+        emptyCount--;
+        if (candidate.goodForCapture &&
+                (minTimestamp > candidate.timestamp || minTimestamp == -1)) {
+            minTimestamp = candidate.timestamp;
+            idx = j;
         }
+
+        ALOGVV("%s: Saw timestamp %" PRId64, __FUNCTION__, candidate.timestamp);
     }
 
-    if (emptyCount == mFrameList.size()) {
+    if (emptyCount == mFrameCandidates.size()) {
         /**
          * This could be mildly bad and means our ZSL was triggered before
          * there were any frames yet received by the camera framework.
@@ -122,10 +122,20 @@ class ZslProcessor :
         CameraMetadata frame;
     };
 
+    // Candidate state of a frame in mFrameList, evaluated once when its metadata arrives
+    struct FrameCandidate {
+        nsecs_t timestamp = -1;    // -1 for an empty slot
+        bool goodForCapture = false;
+    };
+
     static const int32_t kDefaultMaxPipelineDepth = 4;
+    // Fewest frames kept when the ZSL ring is shrunk to save memory
+    static constexpr size_t kMinFrameListDepth = 2;
+    size_t mMaxFrameListDepth;
     size_t mBufferQueueDepth;
     size_t mFrameListDepth;
     std::vector<CameraMetadata> mFrameList;
+    std::vector<FrameCandidate> mFrameCandidates;
     size_t mFrameListHead;
 
     ZslPair mNextPair;
@@ -155,6 +165,13 @@ class ZslProcessor :
 
     nsecs_t getCandidateTimestampLocked(size_t* metadataIdx) const;
 
+    // Whether AE, and AF when relevant, have settled in the frame so it can be reprocessed
+    bool isGoodCandidate(const CameraMetadata &frame) const;
+
+    // Chooses the frame list and ring buffer depth for the ZSL stream size, shrinking them
+    // when the full-size ring would not fit the memory budget
+    void updateQueueDepthLocked(const Parameters &params);
+
     status_t enqueueInputBufferByTimestamp( nsecs_t timestamp,
         nsecs_t* actualTimestamp);
     status_t clearInputRingBufferLocked(nsecs_t* latestTimestamp);
@@ -846,18 +846,42 @@ status_t CameraProviderManager::dump(int fd, const Vector<String16>& args) {
 
 void CameraProviderManager::ProviderInfo::initializeProviderInfoCommon(
         const std::vector<std::string> &devices) {
-    for (auto& device : devices) {
+    nsecs_t startTime = systemTime();
+
+    // Querying the static info of a device from the HAL and fixing it up is independent of the
+    // other devices, so do it for all devices concurrently. The devices are then added in the
+    // order the provider listed them.
+    struct PendingDevice {
+        std::unique_ptr<DeviceInfo> deviceInfo;
         std::string id;
-        status_t res = addDevice(device, CameraDeviceStatus::PRESENT, &id);
+        std::future<status_t> result;
+    };
+    std::vector<PendingDevice> pendingDevices(devices.size());
+    for (size_t i = 0; i < devices.size(); i++) {
+        ALOGI("Enumerating new camera device: %s", devices[i].c_str());
+        auto& pendingDevice = pendingDevices[i];
+        pendingDevice.result = std::async(
+                (devices.size() > 1) ? std::launch::async : std::launch::deferred,
+                [this, &device = devices[i], &pendingDevice]() {
+                    return createDeviceInfo(device, &pendingDevice.deviceInfo, &pendingDevice.id);
+                });
+    }
+
+    for (size_t i = 0; i < devices.size(); i++) {
+        auto& pendingDevice = pendingDevices[i];
+        status_t res = pendingDevice.result.get();
         if (res != OK) {
             ALOGE("%s: Unable to enumerate camera device '%s': %s (%d)",
-                    __FUNCTION__, device.c_str(), strerror(-res), res);
+                    __FUNCTION__, devices[i].c_str(), strerror(-res), res);
             continue;
         }
+        addDeviceInfo(std::move(pendingDevice.deviceInfo), pendingDevice.id,
+                CameraDeviceStatus::PRESENT);
     }
 
-    ALOGI("Camera provider %s ready with %zu camera devices",
-            mProviderName.c_str(), mDevices.size());
+    mInitializationDuration = systemTime() - startTime;
+    ALOGI("Camera provider %s ready with %zu camera devices in %" PRId64 " ms",
+            mProviderName.c_str(), mDevices.size(), ns2ms(mInitializationDuration));
 
     // Process cached status callbacks
     {
@@ -1873,6 +1897,23 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
 
     ALOGI("Enumerating new camera device: %s", name.c_str());
 
+    std::unique_ptr<DeviceInfo> deviceInfo;
+    std::string id;
+    status_t res = createDeviceInfo(name, &deviceInfo, &id);
+    if (res != OK) {
+        return res;
+    }
+    addDeviceInfo(std::move(deviceInfo), id, initialStatus);
+
+    if (parsedId != nullptr) {
+        *parsedId = id;
+    }
+    return OK;
+}
+
+status_t CameraProviderManager::ProviderInfo::createDeviceInfo(const std::string& name,
+        /*out*/ std::unique_ptr<DeviceInfo>* deviceInfo, /*out*/ std::string* parsedId) {
+    ATRACE_CALL();
     uint16_t major, minor;
     std::string type, id;
     IPCTransport transport = getIPCTransport();
@@ -1893,7 +1934,6 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
         return BAD_VALUE;
     }
 
-    std::unique_ptr<DeviceInfo> deviceInfo;
     switch (transport) {
         case IPCTransport::HIDL:
             switch (major) {
@@ -1917,9 +1957,16 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
             return BAD_VALUE;
     }
 
-    deviceInfo = initializeDeviceInfo(name, mProviderTagid, id, minor);
-    if (deviceInfo == nullptr) return BAD_VALUE;
-    deviceInfo->notifyDeviceStateChange(getDeviceState());
+    *deviceInfo = initializeDeviceInfo(name, mProviderTagid, id, minor);
+    if (*deviceInfo == nullptr) return BAD_VALUE;
+    (*deviceInfo)->notifyDeviceStateChange(getDeviceState());
+
+    *parsedId = id;
+    return OK;
+}
+
+void CameraProviderManager::ProviderInfo::addDeviceInfo(std::unique_ptr<DeviceInfo> deviceInfo,
+        const std::string& id, CameraDeviceStatus initialStatus) {
     deviceInfo->mStatus = initialStatus;
     bool isAPI1Compatible = deviceInfo->isAPI1Compatible();
 
@@ -1934,11 +1981,6 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
             mUniqueAPI1CompatibleCameraIds.push_back(id);
         }
     }
-
-    if (parsedId != nullptr) {
-        *parsedId = id;
-    }
-    return OK;
 }
 
 void CameraProviderManager::ProviderInfo::removeDevice(std::string id) {
@@ -1998,6 +2040,8 @@ status_t CameraProviderManager::ProviderInfo::dump(int fd, const Vector<String16
             mMinorVersion,
             mIsRemote ? "remote" : "passthrough",
             mDevices.size());
+    dprintf(fd, "  Initial device enumeration took %" PRId64 " ms\n",
+            ns2ms(mInitializationDuration));
 
     for (auto& device : mDevices) {
         dprintf(fd, "== Camera HAL device %s (v%d.%d) static information: ==\n", device->mName.c_str(),
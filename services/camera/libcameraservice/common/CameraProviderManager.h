@@ -17,6 +17,7 @@
 #ifndef ANDROID_SERVERS_CAMERA_CAMERAPROVIDER_H
 #define ANDROID_SERVERS_CAMERA_CAMERAPROVIDER_H
 
+#include <list>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
@@ -486,6 +487,7 @@ private:
         status_t dump(int fd, const Vector<String16>& args) const;
 
         void initializeProviderInfoCommon(const std::vector<std::string> &devices);
+
         /**
          * Setup vendor tags for this provider
          */
@@ -659,6 +661,46 @@ private:
                     const std::vector<std::string>& publicCameraIds);
             virtual ~DeviceInfo3() {};
         protected:
+            /**
+             * Cache of the HAL stream combination query results of this device, keyed by the
+             * converted HAL stream configuration, most recently used first. Switching back and
+             * forth between camera modes then doesn't repeat the HAL round trip for the same
+             * stream combination.
+             */
+            template <typename StreamConfigurationT>
+            class StreamCombinationCache {
+              public:
+                bool lookup(const StreamConfigurationT& configuration, bool *isSupported) {
+                    std::lock_guard<std::mutex> lock(mLock);
+                    for (auto it = mEntries.begin(); it != mEntries.end(); it++) {
+                        if (it->first == configuration) {
+                            *isSupported = it->second;
+                            mEntries.splice(mEntries.begin(), mEntries, it);
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                void insert(const StreamConfigurationT& configuration, bool isSupported) {
+                    std::lock_guard<std::mutex> lock(mLock);
+                    mEntries.emplace_front(configuration, isSupported);
+                    if (mEntries.size() > kMaxEntries) {
+                        mEntries.pop_back();
+                    }
+                }
+
+                void clear() {
+                    std::lock_guard<std::mutex> lock(mLock);
+                    mEntries.clear();
+                }
+
+              private:
+                static constexpr size_t kMaxEntries = 16;
+                std::mutex mLock;
+                std::list<std::pair<StreamConfigurationT, bool>> mEntries;
+            };
+
             // Modified by derived transport specific (hidl / aidl) class
             CameraMetadata mCameraCharacteristics;
             // Map device states to sensor orientations
@@ -729,6 +771,9 @@ private:
         std::vector<CameraStatusInfoT> mCachedStatus;
         // End of scope for mInitLock
 
+        // Time taken by the initial device enumeration, const after initialization
+        nsecs_t mInitializationDuration = 0;
+
         std::unique_ptr<ProviderInfo::DeviceInfo>
         virtual initializeDeviceInfo(
                 const std::string &name, const metadata_vendor_id_t tagId,
@@ -753,6 +798,15 @@ private:
                 const std::string& name, CameraDeviceStatus initialStatus,
                 /*out*/ std::string* parsedId);
 
+        // Validate the device name and query the device info from the HAL. Device infos of
+        // different devices can be created concurrently, and must then be added with
+        // addDeviceInfo.
+        status_t createDeviceInfo(const std::string& name,
+                /*out*/ std::unique_ptr<DeviceInfo>* deviceInfo, /*out*/ std::string* parsedId);
+
+        void addDeviceInfo(std::unique_ptr<DeviceInfo> deviceInfo, const std::string& id,
+                CameraDeviceStatus initialStatus);
+
         void cameraDeviceStatusChangeInternal(const std::string& cameraDeviceName,
                 CameraDeviceStatus newStatus);
 
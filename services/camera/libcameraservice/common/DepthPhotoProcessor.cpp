@@ -31,14 +31,19 @@
 #include <dynamic_depth/pose.h>
 #include <dynamic_depth/profile.h>
 #include <dynamic_depth/profiles.h>
+#include <future>
+#include <inttypes.h>
 #include <jpeglib.h>
 #include <libexif/exif-data.h>
 #include <libexif/exif-system.h>
 #include <math.h>
 #include <sstream>
+#include <streambuf>
 #include <utils/Errors.h>
 #include <utils/ExifUtils.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
+#include <utils/Trace.h>
 #include <xmpmeta/xmp_data.h>
 #include <xmpmeta/xmp_writer.h>
 
@@ -79,6 +84,92 @@ namespace camera3 {
 // near/far values and impact the range inverse coding.
 static const float CONFIDENCE_THRESHOLD = .15f;
 
+// Read only stream buffer that references the main jpeg buffer directly instead of
+// copying it into a string stream.
+class JpegInputStreamBuf : public std::streambuf {
+public:
+    JpegInputStreamBuf(const char *buffer, size_t size) {
+        char *start = const_cast<char *>(buffer);
+        setg(start, start, start + size);
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+            std::ios_base::openmode which) override {
+        if (!(which & std::ios_base::in)) {
+            return pos_type(off_type(-1));
+        }
+
+        char *target;
+        switch (dir) {
+            case std::ios_base::beg:
+                target = eback() + off;
+                break;
+            case std::ios_base::cur:
+                target = gptr() + off;
+                break;
+            case std::ios_base::end:
+                target = egptr() + off;
+                break;
+            default:
+                return pos_type(off_type(-1));
+        }
+        if ((target < eback()) || (target > egptr())) {
+            return pos_type(off_type(-1));
+        }
+
+        setg(eback(), target, egptr());
+        return pos_type(target - eback());
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+// Output stream buffer that writes the depth photo straight into the output buffer instead
+// of an intermediate string stream. Data that doesn't fit is dropped but still counted, so
+// that the required size can be reported.
+class DepthPhotoOutputStreamBuf : public std::streambuf {
+public:
+    DepthPhotoOutputStreamBuf(void *buffer, size_t size) : mDroppedSize(0) {
+        char *start = static_cast<char *>(buffer);
+        setp(start, start + size);
+    }
+
+    size_t size() const {
+        return static_cast<size_t>(pptr() - pbase()) + mDroppedSize;
+    }
+
+protected:
+    std::streamsize xsputn(const char *s, std::streamsize count) override {
+        std::streamsize copySize = std::min<std::streamsize>(count, epptr() - pptr());
+        memcpy(pptr(), s, copySize);
+        pbump(static_cast<int>(copySize));
+        mDroppedSize += count - copySize;
+        return count;
+    }
+
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            mDroppedSize++;
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+            std::ios_base::openmode which) override {
+        // Only position queries are supported.
+        if ((off != 0) || (dir != std::ios_base::cur) || !(which & std::ios_base::out)) {
+            return pos_type(off_type(-1));
+        }
+        return pos_type(size());
+    }
+
+private:
+    size_t mDroppedSize;
+};
+
 ExifOrientation getExifOrientation(const unsigned char *jpegBuffer, size_t jpegBufferSize) {
     if ((jpegBuffer == nullptr) || (jpegBufferSize == 0)) {
         return ExifOrientation::ORIENTATION_UNDEFINED;
@@ -342,6 +433,7 @@ std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFra
         return nullptr;
     }
 
+    nsecs_t startTime = systemTime();
     std::vector<float> points, confidence;
 
     size_t pointCount = inputFrame.mDepthMapWidth * inputFrame.mDepthMapHeight;
@@ -386,41 +478,63 @@ std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFra
         confidenceIt++; pointIt++;
     }
 
+    nsecs_t unpackTime = systemTime();
+
     DepthMapParams depthParams(DepthFormat::kRangeInverse, near, far, DepthUnits::kMeters,
             "android/depthmap");
     depthParams.confidence_uri = "android/confidencemap";
     depthParams.mime = "image/jpeg";
     depthParams.depth_image_data.resize(inputFrame.mMaxJpegSize);
     depthParams.confidence_data.resize(inputFrame.mMaxJpegSize);
-    size_t actualJpegSize;
-    auto ret = encodeGrayscaleJpeg(width, height, pointsQuantized.data(),
-            depthParams.depth_image_data.data(), inputFrame.mMaxJpegSize,
-            inputFrame.mJpegQuality, exifOrientation, actualJpegSize);
+
+    // The depth and confidence maps are independent, encode the confidence map
+    // on a separate thread while the depth map is encoded on this one.
+    size_t actualConfidenceJpegSize = 0;
+    auto confidenceRet = std::async(std::launch::async, [&]() {
+        ATRACE_NAME("encodeConfidenceMap");
+        return encodeGrayscaleJpeg(width, height, confidenceQuantized.data(),
+                depthParams.confidence_data.data(), inputFrame.mMaxJpegSize,
+                inputFrame.mJpegQuality, exifOrientation, actualConfidenceJpegSize);
+    });
+
+    size_t actualJpegSize = 0;
+    status_t ret;
+    {
+        ATRACE_NAME("encodeDepthMap");
+        ret = encodeGrayscaleJpeg(width, height, pointsQuantized.data(),
+                depthParams.depth_image_data.data(), inputFrame.mMaxJpegSize,
+                inputFrame.mJpegQuality, exifOrientation, actualJpegSize);
+    }
+    auto confidenceStatus = confidenceRet.get();
     if (ret != NO_ERROR) {
         ALOGE("%s: Depth map compression failed!", __FUNCTION__);
         return nullptr;
     }
     depthParams.depth_image_data.resize(actualJpegSize);
 
-    ret = encodeGrayscaleJpeg(width, height, confidenceQuantized.data(),
-            depthParams.confidence_data.data(), inputFrame.mMaxJpegSize,
-            inputFrame.mJpegQuality, exifOrientation, actualJpegSize);
-    if (ret != NO_ERROR) {
+    if (confidenceStatus != NO_ERROR) {
         ALOGE("%s: Confidence map compression failed!", __FUNCTION__);
         return nullptr;
     }
-    depthParams.confidence_data.resize(actualJpegSize);
+    depthParams.confidence_data.resize(actualConfidenceJpegSize);
+
+    nsecs_t encodeTime = systemTime();
+    ALOGV("%s: Depth map unpack %" PRId64 " us, depth and confidence map encoding %" PRId64
+            " us", __FUNCTION__, ns2us(unpackTime - startTime), ns2us(encodeTime - unpackTime));
 
     return DepthMap::FromData(depthParams, items);
 }
 
 int processDepthPhotoFrame(DepthPhotoInputFrame inputFrame, size_t depthPhotoBufferSize,
         void* depthPhotoBuffer /*out*/, size_t* depthPhotoActualSize /*out*/) {
+    ATRACE_CALL();
     if ((inputFrame.mMainJpegBuffer == nullptr) || (inputFrame.mDepthMapBuffer == nullptr) ||
             (depthPhotoBuffer == nullptr) || (depthPhotoActualSize == nullptr)) {
         return BAD_VALUE;
     }
 
+    nsecs_t startTime = systemTime();
+
     std::vector<std::unique_ptr<Item>> items;
     std::vector<std::unique_ptr<Camera>> cameraList;
     auto image = Image::FromDataForPrimaryImage("image/jpeg", &items);
@@ -434,12 +548,16 @@ int processDepthPhotoFrame(DepthPhotoInputFrame inputFrame, size_t depthPhotoBuf
             reinterpret_cast<const unsigned char*> (inputFrame.mMainJpegBuffer),
             inputFrame.mMainJpegSize);
     bool switchDimensions;
-    cameraParams->depth_map = processDepthMapFrame(inputFrame, exifOrientation, &items,
-            &switchDimensions);
+    {
+        ATRACE_NAME("processDepthMapFrame");
+        cameraParams->depth_map = processDepthMapFrame(inputFrame, exifOrientation, &items,
+                &switchDimensions);
+    }
     if (cameraParams->depth_map == nullptr) {
         ALOGE("%s: Depth map processing failed!", __FUNCTION__);
         return BAD_VALUE;
     }
+    nsecs_t depthMapTime = systemTime();
 
     // It is not possible to generate an imaging model without intrinsic calibration.
     if (inputFrame.mIsIntrinsicCalibrationValid) {
@@ -495,22 +613,32 @@ int processDepthPhotoFrame(DepthPhotoInputFrame inputFrame, size_t depthPhotoBuf
         return BAD_VALUE;
     }
 
-    std::istringstream inputJpegStream(
-            std::string(inputFrame.mMainJpegBuffer, inputFrame.mMainJpegSize));
-    std::ostringstream outputJpegStream;
-    if (!WriteImageAndMetadataAndContainer(&inputJpegStream, device.get(), &outputJpegStream)) {
-        ALOGE("%s: Failed writing depth output", __FUNCTION__);
-        return BAD_VALUE;
+    // Read the main jpeg and write the final depth photo in place, without
+    // intermediate copies.
+    JpegInputStreamBuf inputJpegStreamBuf(inputFrame.mMainJpegBuffer, inputFrame.mMainJpegSize);
+    std::istream inputJpegStream(&inputJpegStreamBuf);
+    DepthPhotoOutputStreamBuf outputJpegStreamBuf(depthPhotoBuffer, depthPhotoBufferSize);
+    std::ostream outputJpegStream(&outputJpegStreamBuf);
+    {
+        ATRACE_NAME("WriteImageAndMetadataAndContainer");
+        if (!WriteImageAndMetadataAndContainer(&inputJpegStream, device.get(),
+                    &outputJpegStream)) {
+            ALOGE("%s: Failed writing depth output", __FUNCTION__);
+            return BAD_VALUE;
+        }
     }
 
-    *depthPhotoActualSize = static_cast<size_t> (outputJpegStream.tellp());
+    *depthPhotoActualSize = outputJpegStreamBuf.size();
     if (*depthPhotoActualSize > depthPhotoBufferSize) {
         ALOGE("%s: Depth photo output buffer not sufficient, needed %zu actual %zu", __FUNCTION__,
                 *depthPhotoActualSize, depthPhotoBufferSize);
         return NO_MEMORY;
     }
 
-    memcpy(depthPhotoBuffer, outputJpegStream.str().c_str(), *depthPhotoActualSize);
+    nsecs_t endTime = systemTime();
+    ALOGV("%s: Depth map processing %" PRId64 " us, depth photo container %" PRId64 " us,"
+            " total %" PRId64 " us", __FUNCTION__, ns2us(depthMapTime - startTime),
+            ns2us(endTime - depthMapTime), ns2us(endTime - startTime));
 
     return 0;
 }
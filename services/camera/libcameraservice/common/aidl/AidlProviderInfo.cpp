@@ -723,6 +723,10 @@ status_t AidlProviderInfo::AidlDeviceInfo3::isSessionConfigurationSupported(
         return OK;
     }
 
+    if (mStreamCombinationCache.lookup(streamConfiguration, status)) {
+        return OK;
+    }
+
     const std::shared_ptr<camera::device::ICameraDevice> interface =
             startDeviceInterface();
 
@@ -737,10 +741,17 @@ status_t AidlProviderInfo::AidlDeviceInfo3::isSessionConfigurationSupported(
         ALOGE("%s: Unexpected binder error: %s", __FUNCTION__, ret.getMessage());
         return mapToStatusT(ret);
     }
+    mStreamCombinationCache.insert(streamConfiguration, *status);
     return OK;
 
 }
 
+void AidlProviderInfo::AidlDeviceInfo3::notifyDeviceStateChange(int64_t newState) {
+    // The supported stream combinations may depend on the device state.
+    mStreamCombinationCache.clear();
+    DeviceInfo3::notifyDeviceStateChange(newState);
+}
+
 status_t AidlProviderInfo::convertToAidlHALStreamCombinationAndCameraIdsLocked(
         const std::vector<CameraIdAndSessionConfiguration> &cameraIdsAndSessionConfigs,
         const std::set<std::string>& perfClassPrimaryCameraIds,
@@ -131,9 +131,14 @@ struct AidlProviderInfo : public CameraProviderManager::ProviderInfo {
                 const SessionConfiguration &/*configuration*/,
                 bool overrideForPerfClass, camera3::metadataGetter /*getMetadata*/,
                 bool *status/*status*/);
+        virtual void notifyDeviceStateChange(int64_t newState) override;
 
         std::shared_ptr<aidl::android::hardware::camera::device::ICameraDevice>
                 startDeviceInterface();
+
+      private:
+        StreamCombinationCache<aidl::android::hardware::camera::device::StreamConfiguration>
+                mStreamCombinationCache;
     };
 
  private:
@@ -847,6 +847,10 @@ status_t HidlProviderInfo::HidlDeviceInfo3::isSessionConfigurationSupported(
         return OK;
     }
 
+    if (mStreamCombinationCache.lookup(configuration_3_7, status)) {
+        return OK;
+    }
+
     const sp<hardware::camera::device::V3_2::ICameraDevice> interface =
             startDeviceInterface();
 
@@ -899,9 +903,19 @@ status_t HidlProviderInfo::HidlDeviceInfo3::isSessionConfigurationSupported(
         res = UNKNOWN_ERROR;
     }
 
+    if (res == OK) {
+        mStreamCombinationCache.insert(configuration_3_7, *status);
+    }
+
     return res;
 }
 
+void HidlProviderInfo::HidlDeviceInfo3::notifyDeviceStateChange(int64_t newState) {
+    // The supported stream combinations may depend on the device state.
+    mStreamCombinationCache.clear();
+    DeviceInfo3::notifyDeviceStateChange(newState);
+}
+
 status_t HidlProviderInfo::convertToHALStreamCombinationAndCameraIdsLocked(
         const std::vector<CameraIdAndSessionConfiguration> &cameraIdsAndSessionConfigs,
         const std::set<std::string>& perfClassPrimaryCameraIds,
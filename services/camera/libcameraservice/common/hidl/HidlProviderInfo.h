@@ -107,7 +107,12 @@ struct HidlProviderInfo : public CameraProviderManager::ProviderInfo,
                 const SessionConfiguration &/*configuration*/,
                 bool overrideForPerfClass, camera3::metadataGetter getMetadata,
                 bool *status/*status*/);
+        virtual void notifyDeviceStateChange(int64_t newState) override;
         sp<hardware::camera::device::V3_2::ICameraDevice> startDeviceInterface();
+
+      private:
+        StreamCombinationCache<hardware::camera::device::V3_7::StreamConfiguration>
+                mStreamCombinationCache;
     };
 
  private:
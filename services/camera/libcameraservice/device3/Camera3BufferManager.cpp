@@ -33,6 +33,9 @@ Camera3BufferManager::Camera3BufferManager() {
 }
 
 Camera3BufferManager::~Camera3BufferManager() {
+    if (mBufferPreallocator != nullptr) {
+        mBufferPreallocator->stop();
+    }
 }
 
 status_t Camera3BufferManager::registerStream(wp<Camera3OutputStream>& stream,
@@ -112,6 +115,22 @@ status_t Camera3BufferManager::registerStream(wp<Camera3OutputStream>& stream,
        currentStreamSet.maxAllowedBufferCount = streamInfo.totalBufferCount;
     }
 
+    // Allocate the first buffers of the stream in the background, so that the first frames
+    // after the stream configuration don't wait for Gralloc.
+    if (mBufferPreallocator == nullptr) {
+        mBufferPreallocator = new BufferPreallocator(this);
+        status_t res = mBufferPreallocator->run("C3BufMgr-Prealloc");
+        if (res != OK) {
+            ALOGE("%s: Unable to start buffer preallocation thread: %s (%d)", __FUNCTION__,
+                    strerror(-res), res);
+            mBufferPreallocator.clear();
+        }
+    }
+    if (mBufferPreallocator != nullptr) {
+        mBufferPreallocator->preallocate(streamInfo,
+                std::min(streamInfo.totalBufferCount, kMaxPreallocatedBufferCount));
+    }
+
     return OK;
 }
 
@@ -137,6 +156,16 @@ status_t Camera3BufferManager::unregisterStream(int streamId, int streamSetId, b
     handOutBufferCounts.removeItem(streamId);
     attachedBufferCounts.removeItem(streamId);
 
+    // Drop the buffers preallocated for this stream.
+    BufferList& preallocatedBuffers = currentSet.preallocatedBuffers;
+    for (auto it = preallocatedBuffers.begin(); it != preallocatedBuffers.end();) {
+        if (it->indexOfKey(streamId) != NAME_NOT_FOUND) {
+            it = preallocatedBuffers.erase(it);
+        } else {
+            it++;
+        }
+    }
+
     // Remove the stream info from info map and recalculate the buffer count water mark.
     infoMap.removeItem(streamId);
     currentSet.maxAllowedBufferCount = 0;
@@ -283,34 +312,41 @@ status_t Camera3BufferManager::getBufferForStream(int streamId, int streamSetId,
             streamId, streamSetId, isMultiRes);
 
     if (mGrallocVersion < HARDWARE_DEVICE_API_VERSION(1,0)) {
-        const StreamInfo& info = streamSet.streamInfoMap.valueFor(streamId);
         GraphicBufferEntry buffer;
-        buffer.fenceFd = -1;
-        buffer.graphicBuffer = new GraphicBuffer(
-                info.width, info.height, PixelFormat(info.format), info.combinedUsage,
-                std::string("Camera3BufferManager pid [") +
-                        std::to_string(getpid()) + "]");
-        status_t res = buffer.graphicBuffer->initCheck();
-
-        ALOGV("%s: allocating a new graphic buffer (%dx%d, format 0x%x) %p with handle %p",
-                __FUNCTION__, info.width, info.height, info.format,
-                buffer.graphicBuffer.get(), buffer.graphicBuffer->handle);
-        if (res < 0) {
-            ALOGE("%s: graphic buffer allocation failed: (error %d %s) ",
-                    __FUNCTION__, res, strerror(-res));
-            return res;
+        status_t res;
+        if (!takePreallocatedBufferLocked(streamId, streamSet, &buffer)) {
+            // Allocate without holding the lock, so that other streams are not blocked
+            // on Gralloc.
+            const StreamInfo info = streamSet.streamInfoMap.valueFor(streamId);
+            mLock.unlock();
+            res = allocateBuffer(info, &buffer);
+            mLock.lock();
+            if (res != OK) {
+                return res;
+            }
+            if (!checkIfStreamRegisteredLocked(streamId, streamSetKey)) {
+                ALOGE("%s: stream %d was unregistered from stream set %d(%d) during allocation",
+                        __FUNCTION__, streamId, streamSetId, isMultiRes);
+                return BAD_VALUE;
+            }
         }
-        ALOGV("%s: allocation done", __FUNCTION__);
+
+        // The stream set may have changed while the lock was released.
+        StreamSet &currentStreamSet = mStreamSetMap.editValueFor(streamSetKey);
+        size_t& currentBufferCount = currentStreamSet.handoutBufferCountMap.editValueFor(streamId);
+        size_t& currentAttachedBufferCount =
+                currentStreamSet.attachedBufferCountMap.editValueFor(streamId);
 
         // Increase the hand-out and attached buffer counts for tracking purposes.
-        bufferCount++;
-        attachedBufferCount++;
+        currentBufferCount++;
+        currentAttachedBufferCount++;
         // Update the water mark to be the max hand-out buffer count + 1. An additional buffer is
         // added to reduce the chance of buffer allocation during stream steady state, especially
         // for cases where one stream is active, the other stream may request some buffers randomly.
-        if (bufferCount + 1 > streamSet.allocatedBufferWaterMark) {
-            streamSet.allocatedBufferWaterMark = bufferCount + 1;
+        if (currentBufferCount + 1 > currentStreamSet.allocatedBufferWaterMark) {
+            currentStreamSet.allocatedBufferWaterMark = currentBufferCount + 1;
         }
+        trimPreallocatedBuffersLocked(streamId, currentStreamSet);
         *gb = buffer.graphicBuffer;
         *fenceFd = buffer.fenceFd;
         ALOGV("%s: get buffer (%p) with handle (%p).",
@@ -467,6 +503,8 @@ void Camera3BufferManager::dump(int fd, const Vector<String16>& args) const {
                 mStreamSetMap[i].maxAllowedBufferCount);
         lines.appendFormat("          Stream set buffer count water mark: %zu\n",
                 mStreamSetMap[i].allocatedBufferWaterMark);
+        lines.appendFormat("          Preallocated buffer count: %zu\n",
+                mStreamSetMap[i].preallocatedBuffers.size());
         lines.appendFormat("          Handout buffer counts:\n");
         for (size_t m = 0; m < mStreamSetMap[i].handoutBufferCountMap.size(); m++) {
             int streamId = mStreamSetMap[i].handoutBufferCountMap.keyAt(m);
@@ -485,6 +523,155 @@ void Camera3BufferManager::dump(int fd, const Vector<String16>& args) const {
     write(fd, lines.string(), lines.size());
 }
 
+status_t Camera3BufferManager::allocateBuffer(const StreamInfo& info,
+        GraphicBufferEntry* buffer /*out*/) {
+    ATRACE_CALL();
+    buffer->fenceFd = -1;
+    buffer->graphicBuffer = new GraphicBuffer(
+            info.width, info.height, PixelFormat(info.format), info.combinedUsage,
+            std::string("Camera3BufferManager pid [") +
+                    std::to_string(getpid()) + "]");
+    status_t res = buffer->graphicBuffer->initCheck();
+
+    ALOGV("%s: allocating a new graphic buffer (%dx%d, format 0x%x) %p with handle %p",
+            __FUNCTION__, info.width, info.height, info.format,
+            buffer->graphicBuffer.get(), buffer->graphicBuffer->handle);
+    if (res < 0) {
+        ALOGE("%s: graphic buffer allocation failed: (error %d %s) ",
+                __FUNCTION__, res, strerror(-res));
+        buffer->graphicBuffer.clear();
+        return res;
+    }
+    ALOGV("%s: allocation done", __FUNCTION__);
+
+    return OK;
+}
+
+bool Camera3BufferManager::takePreallocatedBufferLocked(int streamId, StreamSet& streamSet,
+        GraphicBufferEntry* buffer /*out*/) {
+    BufferList& preallocatedBuffers = streamSet.preallocatedBuffers;
+    for (auto it = preallocatedBuffers.begin(); it != preallocatedBuffers.end(); it++) {
+        ssize_t idx = it->indexOfKey(streamId);
+        if (idx != NAME_NOT_FOUND) {
+            *buffer = it->valueAt(idx);
+            preallocatedBuffers.erase(it);
+            ALOGV("%s: Stream %d: using preallocated buffer %p", __FUNCTION__, streamId,
+                    buffer->graphicBuffer.get());
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Camera3BufferManager::trimPreallocatedBuffersLocked(int streamId, StreamSet& streamSet) {
+    size_t totalAllocatedBufferCount = streamSet.preallocatedBuffers.size();
+    for (size_t i = 0; i < streamSet.attachedBufferCountMap.size(); i++) {
+        totalAllocatedBufferCount += streamSet.attachedBufferCountMap[i];
+    }
+
+    BufferList& preallocatedBuffers = streamSet.preallocatedBuffers;
+    for (auto it = preallocatedBuffers.begin();
+            it != preallocatedBuffers.end() &&
+            totalAllocatedBufferCount > streamSet.maxAllowedBufferCount;) {
+        if (it->indexOfKey(streamId) == NAME_NOT_FOUND) {
+            ALOGV("%s: Stream %d: dropping a preallocated buffer of another stream",
+                    __FUNCTION__, streamId);
+            it = preallocatedBuffers.erase(it);
+            totalAllocatedBufferCount--;
+        } else {
+            it++;
+        }
+    }
+}
+
+void Camera3BufferManager::onBufferPreallocated(const StreamInfo& info,
+        const GraphicBufferEntry& buffer) {
+    Mutex::Autolock l(mLock);
+
+    StreamSetKey streamSetKey = {info.streamSetId, info.isMultiRes};
+    if (!checkIfStreamRegisteredLocked(info.streamId, streamSetKey)) {
+        ALOGV("%s: stream %d was unregistered, dropping preallocated buffer", __FUNCTION__,
+                info.streamId);
+        return;
+    }
+
+    // The stream may have been re-registered with a different configuration meanwhile.
+    StreamSet& streamSet = mStreamSetMap.editValueFor(streamSetKey);
+    const StreamInfo& currentInfo = streamSet.streamInfoMap.valueFor(info.streamId);
+    if (currentInfo.width != info.width || currentInfo.height != info.height ||
+            currentInfo.format != info.format ||
+            currentInfo.combinedUsage != info.combinedUsage) {
+        ALOGV("%s: stream %d configuration changed, dropping preallocated buffer", __FUNCTION__,
+                info.streamId);
+        return;
+    }
+
+    size_t totalAllocatedBufferCount = streamSet.preallocatedBuffers.size();
+    for (size_t i = 0; i < streamSet.attachedBufferCountMap.size(); i++) {
+        totalAllocatedBufferCount += streamSet.attachedBufferCountMap[i];
+    }
+    if (totalAllocatedBufferCount >= streamSet.maxAllowedBufferCount) {
+        ALOGV("%s: stream set %d(%d) has enough buffers, dropping preallocated buffer",
+                __FUNCTION__, streamSetKey.id, streamSetKey.isMultiRes);
+        return;
+    }
+
+    BufferEntry entry;
+    entry.add(info.streamId, buffer);
+    streamSet.preallocatedBuffers.push_back(entry);
+}
+
+Camera3BufferManager::BufferPreallocator::BufferPreallocator(wp<Camera3BufferManager> parent) :
+        Thread(/*canCallJava*/false), mParent(parent), mStopped(false) {
+}
+
+void Camera3BufferManager::BufferPreallocator::preallocate(const StreamInfo& info,
+        size_t bufferCount) {
+    Mutex::Autolock l(mLock);
+    for (size_t i = 0; i < bufferCount; i++) {
+        mPendingBuffers.push_back(info);
+    }
+    mPendingSignal.signal();
+}
+
+void Camera3BufferManager::BufferPreallocator::stop() {
+    Mutex::Autolock l(mLock);
+    mPendingBuffers.clear();
+    mStopped = true;
+    requestExit();
+    mPendingSignal.signal();
+}
+
+bool Camera3BufferManager::BufferPreallocator::threadLoop() {
+    StreamInfo info;
+    {
+        Mutex::Autolock l(mLock);
+        if (mStopped) {
+            return false;
+        }
+        if (mPendingBuffers.empty()) {
+            mPendingSignal.waitRelative(mLock, kWaitDuration);
+            return !mStopped;
+        }
+        info = mPendingBuffers.front();
+        mPendingBuffers.pop_front();
+    }
+
+    GraphicBufferEntry buffer;
+    if (allocateBuffer(info, &buffer) != OK) {
+        return true;
+    }
+
+    sp<Camera3BufferManager> parent = mParent.promote();
+    if (parent == nullptr) {
+        return false;
+    }
+    parent->onBufferPreallocated(info, buffer);
+
+    return true;
+}
+
 bool Camera3BufferManager::checkIfStreamRegisteredLocked(int streamId,
         StreamSetKey streamSetKey) const {
     ssize_t setIdx = mStreamSetMap.indexOfKey(streamSetKey);
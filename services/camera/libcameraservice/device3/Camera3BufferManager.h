@@ -20,8 +20,10 @@
 #include <list>
 #include <algorithm>
 #include <ui/GraphicBuffer.h>
+#include <utils/Condition.h>
 #include <utils/RefBase.h>
 #include <utils/KeyedVector.h>
+#include <utils/Thread.h>
 #include "Camera3OutputStream.h"
 
 namespace android {
@@ -41,6 +43,10 @@ class Camera3OutputStream;
  * In doing so, it reduces the memory footprint unless it is already minimal without impacting
  * performance.
  *
+ * To avoid stalling the first frames of a session on Gralloc, a few buffers are allocated for
+ * each registered stream on a background thread. getBufferForStream() hands out these
+ * preallocated buffers before allocating new ones.
+ *
  */
 class Camera3BufferManager: public virtual RefBase {
 public:
@@ -70,7 +76,8 @@ public:
      * uses buffer manager to manage the stream buffers, it should disable the BufferQueue
      * allocation via IGraphicBufferProducer::allowAllocation(false).
      *
-     * Registering an already registered stream has no effect.
+     * Registering an already registered stream has no effect. Registering a new stream queues
+     * the allocation of up to kMaxPreallocatedBufferCount buffers for it on a background thread.
      *
      * Return values:
      *
@@ -198,6 +205,9 @@ private:
     // (BUFFER_FREE_THRESHOLD + steady state handout buffer count) buffers.
     static const int BUFFER_FREE_THRESHOLD = 3;
 
+    // The max number of buffers allocated ahead of time for each registered stream.
+    static constexpr size_t kMaxPreallocatedBufferCount = 2;
+
     /**
      * Lock to synchronize the access to the methods of this class.
      */
@@ -283,6 +293,11 @@ private:
          * An attached buffer may be free or handed out
          */
         BufferCountMap attachedBufferCountMap;
+        /**
+         * Buffers allocated ahead of time that were not handed out to their streams yet.
+         * Together with the attached buffers, they are bounded by maxAllowedBufferCount.
+         */
+        BufferList preallocatedBuffers;
 
         StreamSet() {
             allocatedBufferWaterMark = 0;
@@ -324,6 +339,61 @@ private:
      * free one if so.
      */
     status_t checkAndFreeBufferOnOtherStreamsLocked(int streamId, StreamSetKey streamSetKey);
+
+    /**
+     * Allocate a new graphic buffer for the stream. Must be called without mLock held.
+     */
+    static status_t allocateBuffer(const StreamInfo& info, GraphicBufferEntry* buffer /*out*/);
+
+    /**
+     * Take a preallocated buffer of the stream out of the stream set, if there is one.
+     */
+    bool takePreallocatedBufferLocked(int streamId, StreamSet& streamSet,
+            GraphicBufferEntry* buffer /*out*/);
+
+    /**
+     * Drop preallocated buffers of the other streams in the stream set while the allocated
+     * buffers of the stream set exceed its max allowed buffer count.
+     */
+    void trimPreallocatedBuffersLocked(int streamId, StreamSet& streamSet);
+
+    /**
+     * Add a buffer allocated by the preallocator to the stream set of the stream, if the stream
+     * is still registered with the same configuration and needs more buffers.
+     */
+    void onBufferPreallocated(const StreamInfo& info, const GraphicBufferEntry& buffer);
+
+    /**
+     * Background thread allocating buffers for newly registered streams, in FIFO order.
+     */
+    class BufferPreallocator : public Thread {
+      public:
+        explicit BufferPreallocator(wp<Camera3BufferManager> parent);
+
+        /**
+         * Queue up the allocation of bufferCount buffers for the stream.
+         */
+        void preallocate(const StreamInfo& info, size_t bufferCount);
+
+        /**
+         * Drop all pending allocations and stop the thread.
+         */
+        void stop();
+
+      private:
+        virtual bool threadLoop() override;
+
+        static const nsecs_t kWaitDuration = 500000000; // 500 ms
+
+        wp<Camera3BufferManager> mParent;
+        Mutex mLock;
+        Condition mPendingSignal;
+        // Guarded by mLock
+        std::list<StreamInfo> mPendingBuffers;
+        bool mStopped;
+    };
+    // Created on the first stream registration, guarded by mLock
+    sp<BufferPreallocator> mBufferPreallocator;
 };
 
 } // namespace camera3
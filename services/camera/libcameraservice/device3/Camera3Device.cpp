@@ -650,7 +650,10 @@ status_t Camera3Device::dump(int fd, const Vector<String16> &args) {
     if (mRequestThread != NULL) {
         mRequestThread->dumpCaptureRequestLatency(fd,
                 "    ProcessCaptureRequest latency histogram:");
+        mRequestThread->dumpSettingsStats(fd, "    Request settings sent to HAL:");
     }
+    mSessionStatsBuilder.dumpResultTiming(fd, "    ProcessCaptureResult processing time:");
+    mSessionStatsBuilder.dumpStageLatency(fd, "    Capture stage latency histograms:");
 
     {
         lines = String8("    Last request sent:\n");
@@ -3347,7 +3350,7 @@ bool Camera3Device::RequestThread::sendRequestsBatch() {
 
         if (!triggerRemoveFailed) {
             // Remove any previously queued triggers (after unlock)
-            status_t removeTriggerRes = removeTriggers(mPrevRequest);
+            status_t removeTriggerRes = removeTriggers(nextRequest.captureRequest);
             if (removeTriggerRes != OK) {
                 triggerRemoveFailed = true;
                 triggerFailedRequest = nextRequest;
@@ -3443,15 +3446,16 @@ void Camera3Device::RequestThread::updateNextRequest(NextRequest& nextRequest) {
         camera_metadata_t* cloned = clone_camera_metadata(halRequest.settings);
         mLatestRequest.acquire(cloned);
 
-        mLatestPhysicalRequest.clear();
-        for (uint32_t i = 0; i < halRequest.num_physcam_settings; i++) {
-            cloned = clone_camera_metadata(halRequest.physcam_settings[i]);
-            mLatestPhysicalRequest.emplace(halRequest.physcam_id[i],
-                    CameraMetadata(cloned));
-        }
-
+        // The physical settings are only kept for the tag monitor
         sp<Camera3Device> parent = mParent.promote();
-        if (parent != NULL) {
+        if (parent != NULL && parent->mTagMonitor.isMonitoringEnabled()) {
+            mLatestPhysicalRequest.clear();
+            for (uint32_t i = 0; i < halRequest.num_physcam_settings; i++) {
+                cloned = clone_camera_metadata(halRequest.physcam_settings[i]);
+                mLatestPhysicalRequest.emplace(halRequest.physcam_id[i],
+                        CameraMetadata(cloned));
+            }
+
             int32_t inputStreamId = -1;
             if (halRequest.input_buffer != nullptr) {
               inputStreamId = Camera3Stream::cast(halRequest.input_buffer->stream)->getId();
@@ -3627,13 +3631,13 @@ bool Camera3Device::RequestThread::threadLoop() {
     }
 
     // Submit a batch of requests to HAL.
-    // Use flush lock only when submitting multilple requests in a batch.
+    // Use flush lock only when submitting a high speed recording batch.
     // TODO: The problem with flush lock is flush() will be blocked by process_capture_request()
     // which may take a long time to finish so synchronizing flush() and
     // process_capture_request() defeats the purpose of cancelling requests ASAP with flush().
     // For now, only synchronize for high speed recording and we should figure something out for
     // removing the synchronization.
-    bool useFlushLock = mNextRequests.size() > 1;
+    bool useFlushLock = mNextRequests[0].captureRequest->mBatchSize > 1;
 
     if (useFlushLock) {
         mFlushLock.lock();
@@ -3701,8 +3705,10 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
         // Prepare a request to HAL
         halRequest->frame_number = captureRequest->mResultExtras.frameNumber;
 
-        // Insert any queued triggers (before metadata is locked)
-        status_t res = insertTriggers(captureRequest);
+        // Insert any queued triggers (before metadata is locked). In a batch of queued requests,
+        // triggers only go into the first one so they can be removed again after submission;
+        // triggers set in the meantime are picked up by the next batch.
+        status_t res = (i == 0 || batchedRequest) ? insertTriggers(captureRequest) : 0;
         if (res < 0) {
             SET_ERR("RequestThread: Unable to insert triggers "
                     "(capture request %d, HAL device: %s (%d)",
@@ -3716,6 +3722,12 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
 
         bool testPatternChanged = overrideTestPattern(captureRequest);
 
+        // Only the request object differs from the last one, so the settings may still be the
+        // same, e.g. for the requests of a repeating burst.
+        bool onlyRequestChanged = mPrevRequest != nullptr && mPrevRequest != captureRequest &&
+                !triggersMixedIn && !captureRequest->mRotateAndCropChanged &&
+                !testPatternChanged;
+
         // If the request is the same as last, or we had triggers now or last time or
         // changing overrides this time
         bool newRequest =
@@ -3863,8 +3875,28 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
                           e.data.u8[0]);
                 }
             }
+
+            if (onlyRequestChanged && isSameAsPrevSettings(captureRequest, halRequest->settings)) {
+                // Leave request.settings NULL, the HAL already has the same settings
+                captureRequest->mSettingsList.begin()->metadata.unlock(halRequest->settings);
+                halRequest->settings = nullptr;
+                newRequest = false;
+                mSettingsIdenticalCount++;
+                ALOGVV("%s: Request settings are the same as last, REUSED", __FUNCTION__);
+            } else {
+                mPrevSettings = halRequest->settings;
+                mPrevPhysicalSettings.clear();
+                for (auto it = ++captureRequest->mSettingsList.begin();
+                        it != captureRequest->mSettingsList.end(); it++) {
+                    it->metadata.sort();
+                    mPrevPhysicalSettings.push_back(*it);
+                }
+                mSettingsSentCount++;
+                mSettingsSentBytes += get_camera_metadata_size(halRequest->settings);
+            }
         } else {
             // leave request.settings NULL to indicate 'reuse latest given'
+            mSettingsReusedCount++;
             ALOGVV("%s: Request settings are REUSED",
                    __FUNCTION__);
         }
@@ -4369,9 +4401,135 @@ void Camera3Device::RequestThread::waitForNextRequestBatch() {
         ALOGE("RequestThread: only get %zu out of %zu requests. Skipping requests.",
                 mNextRequests.size(), batchSize);
         cleanUpFailedRequests(/*sendRequestError*/true);
+        return;
     }
 
-    return;
+    addQueuedRequestsToBatchLocked();
+}
+
+void Camera3Device::RequestThread::addQueuedRequestsToBatchLocked() {
+    // Send the rest of a burst or repeating burst to the HAL along with its first request, so
+    // that it costs a single processCaptureRequest call. Requests that would need handling
+    // which is only done for the first request of a batch (input buffers, high speed batches,
+    // session parameter changes) are left for the next batch.
+    const sp<CaptureRequest> firstRequest = mNextRequests[0].captureRequest;
+    if (firstRequest->mBatchSize > 1 || firstRequest->mInputStream != nullptr) {
+        return;
+    }
+
+    while (mNextRequests.size() < kMaxRequestBatchSize && !mRequestQueue.empty()) {
+        const sp<CaptureRequest>& queuedRequest = *mRequestQueue.begin();
+        if (queuedRequest->mBatchSize > 1 || queuedRequest->mInputStream != nullptr ||
+                !hasSameSessionParameters(firstRequest, queuedRequest)) {
+            break;
+        }
+
+        // The frame number and settings live in the request, so it can be in flight only once
+        // per batch.
+        bool inBatch = false;
+        for (const auto& nextRequest : mNextRequests) {
+            if (nextRequest.captureRequest == queuedRequest) {
+                inBatch = true;
+                break;
+            }
+        }
+        if (inBatch) {
+            break;
+        }
+
+        NextRequest additionalRequest;
+        additionalRequest.captureRequest = waitForNextRequestLocked();
+        if (additionalRequest.captureRequest == nullptr) {
+            break;
+        }
+
+        additionalRequest.halRequest = camera_capture_request_t();
+        additionalRequest.submitted = false;
+        mNextRequests.add(additionalRequest);
+    }
+}
+
+bool Camera3Device::RequestThread::hasSameSessionParameters(const sp<CaptureRequest>& request,
+        const sp<CaptureRequest>& otherRequest) const {
+    const CameraMetadata& settings = request->mSettingsList.begin()->metadata;
+    const CameraMetadata& otherSettings = otherRequest->mSettingsList.begin()->metadata;
+    for (auto tag : mSessionParamKeys) {
+        camera_metadata_ro_entry entry = settings.find(tag);
+        camera_metadata_ro_entry otherEntry = otherSettings.find(tag);
+        if (entry.count != otherEntry.count || entry.type != otherEntry.type) {
+            return false;
+        }
+        if (entry.count > 0 && memcmp(entry.data.u8, otherEntry.data.u8,
+                camera_metadata_type_size[entry.type] * entry.count) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Camera3Device::RequestThread::isSameAsPrevSettings(const sp<CaptureRequest>& request,
+        const camera_metadata_t* settings) {
+    if (mPrevSettings.isEmpty() || settings == nullptr ||
+            request->mSettingsList.size() != mPrevPhysicalSettings.size() + 1) {
+        return false;
+    }
+    if (!isSameMetadata(settings, mPrevSettings)) {
+        return false;
+    }
+
+    auto it = ++request->mSettingsList.begin();
+    for (size_t i = 0; it != request->mSettingsList.end(); it++, i++) {
+        if (it->cameraId != mPrevPhysicalSettings[i].cameraId) {
+            return false;
+        }
+        it->metadata.sort();
+        const camera_metadata_t* physicalSettings = it->metadata.getAndLock();
+        bool same = isSameMetadata(physicalSettings, mPrevPhysicalSettings[i].metadata);
+        it->metadata.unlock(physicalSettings);
+        if (!same) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Camera3Device::RequestThread::isSameMetadata(const camera_metadata_t* metadata,
+        const CameraMetadata& otherMetadata) {
+    // Both are sorted, so equal metadata have their entries in the same order
+    const camera_metadata_t* other = otherMetadata.getAndLock();
+    size_t entryCount = get_camera_metadata_entry_count(metadata);
+    bool same = entryCount == get_camera_metadata_entry_count(other);
+    for (size_t i = 0; same && i < entryCount; i++) {
+        camera_metadata_ro_entry_t entry, otherEntry;
+        if (get_camera_metadata_ro_entry(metadata, i, &entry) != OK ||
+                get_camera_metadata_ro_entry(other, i, &otherEntry) != OK) {
+            same = false;
+            break;
+        }
+        same = entry.tag == otherEntry.tag && entry.type == otherEntry.type &&
+                entry.count == otherEntry.count &&
+                memcmp(entry.data.u8, otherEntry.data.u8,
+                        camera_metadata_type_size[entry.type] * entry.count) == 0;
+    }
+    otherMetadata.unlock(other);
+    return same;
+}
+
+void Camera3Device::RequestThread::dumpSettingsStats(int fd, const char* name) {
+    int64_t sentCount = mSettingsSentCount;
+    int64_t reusedCount = mSettingsReusedCount;
+    int64_t identicalCount = mSettingsIdenticalCount;
+    if (sentCount + reusedCount + identicalCount == 0) {
+        return;
+    }
+
+    String8 lines;
+    lines.appendFormat("%s\n", name);
+    lines.appendFormat("      Sent: %" PRId64 " (%" PRId64 " KB)\n", sentCount,
+            mSettingsSentBytes.load() / 1024);
+    lines.appendFormat("      Reused from the same request: %" PRId64 "\n", reusedCount);
+    lines.appendFormat("      Reused with identical settings: %" PRId64 "\n", identicalCount);
+    write(fd, lines.string(), lines.size());
 }
 
 sp<Camera3Device::CaptureRequest>
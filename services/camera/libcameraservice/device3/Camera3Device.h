@@ -17,6 +17,7 @@
 #ifndef ANDROID_SERVERS_CAMERA3DEVICE_H
 #define ANDROID_SERVERS_CAMERA3DEVICE_H
 
+#include <atomic>
 #include <utility>
 #include <unordered_map>
 #include <set>
@@ -894,6 +895,9 @@ class Camera3Device :
             mRequestLatency.dump(fd, name);
         }
 
+        // dump how often request settings were sent to the HAL or reused
+        void dumpSettingsStats(int fd, const char* name);
+
         void signalPipelineDrain(const std::vector<int>& streamIds);
         void resetPipelineDrain();
 
@@ -933,6 +937,9 @@ class Camera3Device :
 
         static const nsecs_t kRequestTimeout = 50e6; // 50 ms
 
+        // Maximum number of already queued requests submitted to the HAL in one call
+        static const size_t kMaxRequestBatchSize = 4;
+
         // TODO: does this need to be adjusted for long exposure requests?
         static const nsecs_t kRequestSubmitTimeout = 200e6; // 200 ms
 
@@ -951,6 +958,23 @@ class Camera3Device :
         // Waits for a request, or returns NULL if times out. Must be called with mRequestLock hold.
         sp<CaptureRequest> waitForNextRequestLocked();
 
+        // Add requests that are already queued behind the first request in mNextRequests to the
+        // batch, without waiting for new ones. Must be called with mRequestLock held.
+        void addQueuedRequestsToBatchLocked();
+
+        // Whether the two requests have the same session parameter values
+        bool hasSameSessionParameters(const sp<CaptureRequest>& request,
+                const sp<CaptureRequest>& otherRequest) const;
+
+        // Whether the request's settings, including physical camera settings, are the same as
+        // the last settings sent to the HAL. settings is the locked logical camera settings.
+        bool isSameAsPrevSettings(const sp<CaptureRequest>& request,
+                const camera_metadata_t* settings);
+
+        // Whether two sorted metadata buffers have the same entries
+        static bool isSameMetadata(const camera_metadata_t* metadata,
+                const CameraMetadata& otherMetadata);
+
         // Prepare HAL requests and output buffers in mNextRequests. Return TIMED_OUT if getting any
         // output buffer timed out. If an error is returned, the caller should clean up the pending
         // request batch.
@@ -1041,6 +1065,17 @@ class Camera3Device :
         std::vector<int>   mStreamIdsToBeDrained;
 
         sp<CaptureRequest> mPrevRequest;
+        // Copy of the last settings sent to the HAL for mPrevRequest
+        CameraMetadata     mPrevSettings;
+        std::vector<PhysicalCameraSettings> mPrevPhysicalSettings;
+
+        // Number of requests sent with new settings, and their total size, and number of
+        // requests that reused the last settings because they were from the same request or
+        // had identical settings
+        std::atomic<int64_t> mSettingsSentCount = 0;
+        std::atomic<int64_t> mSettingsSentBytes = 0;
+        std::atomic<int64_t> mSettingsReusedCount = 0;
+        std::atomic<int64_t> mSettingsIdenticalCount = 0;
         int32_t            mPrevTriggers;
         std::set<std::string> mPrevCameraIdsWithZoom;
 
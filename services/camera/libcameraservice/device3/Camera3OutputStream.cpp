@@ -529,6 +529,9 @@ void Camera3OutputStream::dump(int fd, const Vector<String16> &args) const {
 
     mDequeueBufferLatency.dump(fd,
         "      DequeueBuffer latency histogram:");
+    if (mPreviewFrameSpacer != nullptr) {
+        mPreviewFrameSpacer->dump(fd);
+    }
 }
 
 status_t Camera3OutputStream::setTransform(int transform, bool mayChangeMirror) {
@@ -1000,6 +1003,7 @@ status_t Camera3OutputStream::disconnectLocked() {
 
     if (mPreviewFrameSpacer != nullptr) {
         mPreviewFrameSpacer->requestExit();
+        mPreviewFrameSpacer->logAndResetStats();
     }
 
     ALOGV("%s: disconnecting stream %d from native window", __FUNCTION__, getId());
@@ -168,12 +168,11 @@ void insertResultLocked(CaptureOutputStates& states, CaptureResult *result, uint
 }
 
 
-void sendPartialCaptureResult(CaptureOutputStates& states,
+// Must be called with outputLock held
+void sendPartialCaptureResultLocked(CaptureOutputStates& states,
         const camera_metadata_t * partialResult,
         const CaptureResultExtras &resultExtras, uint32_t frameNumber) {
     ATRACE_CALL();
-    std::lock_guard<std::mutex> l(states.outputLock);
-
     CaptureResult captureResult;
     captureResult.mResultExtras = resultExtras;
     captureResult.mMetadata = partialResult;
@@ -214,7 +213,8 @@ void sendPartialCaptureResult(CaptureOutputStates& states,
     }
 }
 
-void sendCaptureResult(
+// Must be called with outputLock held
+void sendCaptureResultLocked(
         CaptureOutputStates& states,
         CameraMetadata &pendingMetadata,
         CaptureResultExtras &resultExtras,
@@ -227,8 +227,6 @@ void sendCaptureResult(
     if (pendingMetadata.isEmpty())
         return;
 
-    std::lock_guard<std::mutex> l(states.outputLock);
-
     // TODO: need to track errors for tighter bounds on expected frame number
     if (reprocess) {
         if (frameNumber < states.nextReprocResultFrameNum) {
@@ -278,6 +276,8 @@ void sendCaptureResult(
     nsecs_t sensorTimestamp = timestamp.data.i64[0];
 
     for (auto& physicalMetadata : captureResult.mPhysicalMetadatas) {
+        // Sort so that lookups by the result mappers below use binary search
+        physicalMetadata.mPhysicalCameraMetadata.sort();
         camera_metadata_entry timestamp =
                 physicalMetadata.mPhysicalCameraMetadata.find(ANDROID_SENSOR_TIMESTAMP);
         if (timestamp.count == 0) {
@@ -364,18 +364,39 @@ void sendCaptureResult(
         }
     }
 
-    std::unordered_map<std::string, CameraMetadata> monitoredPhysicalMetadata;
-    for (auto& m : physicalMetadatas) {
-        monitoredPhysicalMetadata.emplace(String8(m.mPhysicalCameraId).string(),
-                CameraMetadata(m.mPhysicalCameraMetadata));
+    // Only copy the physical metadata for the tag monitor if it's going to be looked at
+    if (states.tagMonitor.isMonitoringEnabled()) {
+        std::unordered_map<std::string, CameraMetadata> monitoredPhysicalMetadata;
+        for (auto& m : physicalMetadatas) {
+            monitoredPhysicalMetadata.emplace(String8(m.mPhysicalCameraId).string(),
+                    CameraMetadata(m.mPhysicalCameraMetadata));
+        }
+        states.tagMonitor.monitorMetadata(TagMonitor::RESULT,
+                frameNumber, sensorTimestamp, captureResult.mMetadata,
+                monitoredPhysicalMetadata);
     }
-    states.tagMonitor.monitorMetadata(TagMonitor::RESULT,
-            frameNumber, sensorTimestamp, captureResult.mMetadata,
-            monitoredPhysicalMetadata);
 
     insertResultLocked(states, &captureResult, frameNumber);
 }
 
+void sendCaptureResult(
+        CaptureOutputStates& states,
+        CameraMetadata &pendingMetadata,
+        CaptureResultExtras &resultExtras,
+        CameraMetadata &collectedPartialResult,
+        uint32_t frameNumber,
+        bool reprocess, bool zslStillCapture, bool rotateAndCropAuto,
+        const std::set<std::string>& cameraIdsWithZoom,
+        const std::vector<PhysicalCaptureResultInfo>& physicalMetadatas) {
+    if (pendingMetadata.isEmpty())
+        return;
+
+    std::lock_guard<std::mutex> l(states.outputLock);
+    sendCaptureResultLocked(states, pendingMetadata, resultExtras, collectedPartialResult,
+            frameNumber, reprocess, zslStillCapture, rotateAndCropAuto, cameraIdsWithZoom,
+            physicalMetadatas);
+}
+
 void removeInFlightMapEntryLocked(CaptureOutputStates& states, int idx) {
     ATRACE_CALL();
     InFlightRequestMap& inflightMap = states.inflightMap;
@@ -442,6 +463,11 @@ void removeInFlightRequestIfReadyLocked(CaptureOutputStates& states, int idx) {
         }
 
         sessionStatsBuilder.incResultCounter(request.skipResultMetadata);
+        if (request.requestStatus == OK && !request.skipResultMetadata) {
+            sessionStatsBuilder.incStageLatencyCounters(request.requestTimeNs,
+                    request.halSubmitTimeNs, request.shutterNotifyTimeNs,
+                    request.partialResultTimeNs, request.finalResultTimeNs, systemTime());
+        }
 
         removeInFlightMapEntryLocked(states, idx);
         ALOGVV("%s: removed frame %d from InFlightMap", __FUNCTION__, frameNumber);
@@ -464,6 +490,24 @@ bool erasePhysicalCameraIdSet(
     return found;
 }
 
+// Result metadata picked up from the in-flight map, to be corrected and queued once the
+// in-flight lock has been released.
+struct PendingResultDelivery {
+    enum {
+        NONE = 0,
+        PARTIAL,
+        FINAL,
+    } type = NONE;
+    CaptureResultExtras resultExtras;
+    CameraMetadata metadata; // only for final results
+    CameraMetadata collectedPartialResult;
+    bool reprocess = false;
+    bool zslStillCapture = false;
+    bool rotateAndCropAuto = false;
+    std::set<std::string> cameraIdsWithZoom;
+    std::vector<PhysicalCaptureResultInfo> physicalMetadatas;
+};
+
 void processCaptureResult(CaptureOutputStates& states, const camera_capture_result *result) {
     ATRACE_CALL();
 
@@ -496,9 +540,17 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
     // in-flight request and they will be returned when the shutter timestamp
     // arrives. Update the in-flight status and remove the in-flight entry if
     // all result data and shutter timestamp have been received.
+    //
+    // Metadata correction and queueing of the result are done after the in-flight lock is
+    // released, so that the request thread isn't blocked behind the mappers. The output lock is
+    // taken before the in-flight lock is dropped to keep results queued in HAL order.
     nsecs_t shutterTimestamp = 0;
+    PendingResultDelivery delivery;
+    std::unique_lock<std::mutex> outputLock(states.outputLock, std::defer_lock);
+    nsecs_t inflightLockDuration = 0;
     {
         std::lock_guard<std::mutex> l(states.inflightLock);
+        nsecs_t inflightLockTime = systemTime();
         ssize_t idx = states.inflightMap.indexOfKey(frameNumber);
         if (idx == NAME_NOT_FOUND) {
             SET_ERR("Unknown frame number for capture result: %d",
@@ -585,12 +637,15 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
             }
             if (isPartialResult) {
                 request.collectedPartialResult.append(result->result);
+                if (request.partialResultTimeNs == 0) {
+                    request.partialResultTimeNs = systemTime();
+                }
             }
 
             if (isPartialResult && request.hasCallback) {
-                // Send partial capture result
-                sendPartialCaptureResult(states, result->result, request.resultExtras,
-                        frameNumber);
+                // Send partial capture result once the in-flight lock is released
+                delivery.type = PendingResultDelivery::PARTIAL;
+                delivery.resultExtras = request.resultExtras;
             }
         }
 
@@ -625,6 +680,7 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
                     request.collectedPartialResult);
             }
             request.haveResultMetadata = true;
+            request.finalResultTimeNs = systemTime();
             request.errorBufStrategy = ERROR_BUF_RETURN_NOTIFY;
         }
 
@@ -673,18 +729,44 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
                 request.pendingMetadata = result->result;
                 request.collectedPartialResult = collectedPartialResult;
             } else if (request.hasCallback) {
-                CameraMetadata metadata;
-                metadata = result->result;
-                sendCaptureResult(states, metadata, request.resultExtras,
-                    collectedPartialResult, frameNumber,
-                    hasInputBufferInRequest, request.zslCapture && request.stillCapture,
-                    request.rotateAndCropAuto, request.cameraIdsWithZoom,
-                    request.physicalMetadatas);
+                // Send capture result once the in-flight lock is released
+                delivery.type = PendingResultDelivery::FINAL;
+                delivery.resultExtras = request.resultExtras;
+                delivery.metadata = result->result;
+                delivery.collectedPartialResult.acquire(collectedPartialResult);
+                delivery.reprocess = hasInputBufferInRequest;
+                delivery.zslStillCapture = request.zslCapture && request.stillCapture;
+                delivery.rotateAndCropAuto = request.rotateAndCropAuto;
+                delivery.cameraIdsWithZoom = request.cameraIdsWithZoom;
+                delivery.physicalMetadatas = request.physicalMetadatas;
             }
         }
         removeInFlightRequestIfReadyLocked(states, idx);
+
+        if (delivery.type != PendingResultDelivery::NONE) {
+            outputLock.lock();
+        }
+        inflightLockDuration = systemTime() - inflightLockTime;
     } // scope for states.inFlightLock
 
+    nsecs_t deliveryDuration = 0;
+    if (delivery.type != PendingResultDelivery::NONE) {
+        nsecs_t deliveryTime = systemTime();
+        if (delivery.type == PendingResultDelivery::PARTIAL) {
+            sendPartialCaptureResultLocked(states, result->result, delivery.resultExtras,
+                    frameNumber);
+        } else {
+            sendCaptureResultLocked(states, delivery.metadata, delivery.resultExtras,
+                    delivery.collectedPartialResult, frameNumber,
+                    delivery.reprocess, delivery.zslStillCapture,
+                    delivery.rotateAndCropAuto, delivery.cameraIdsWithZoom,
+                    delivery.physicalMetadatas);
+        }
+        outputLock.unlock();
+        deliveryDuration = systemTime() - deliveryTime;
+    }
+    states.sessionStatsBuilder.incResultTimingCounter(inflightLockDuration, deliveryDuration);
+
     if (result->input_buffer != NULL) {
         if (hasInputBufferInRequest) {
             Camera3Stream *stream =
@@ -877,6 +959,7 @@ void notifyShutter(CaptureOutputStates& states, const camera_shutter_msg_t &msg)
             }
 
             r.shutterTimestamp = msg.timestamp;
+            r.shutterNotifyTimeNs = systemTime();
             if (msg.readout_timestamp_valid) {
                 r.resultExtras.hasReadoutTimestamp = true;
                 r.resultExtras.readoutTimestamp = msg.readout_timestamp;
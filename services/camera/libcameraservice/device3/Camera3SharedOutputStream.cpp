@@ -106,6 +106,15 @@ status_t Camera3SharedOutputStream::attachBufferToSplitterLocked(
 }
 
 
+void Camera3SharedOutputStream::dump(int fd, const Vector<String16> &args) const {
+    Camera3OutputStream::dump(fd, args);
+
+    sp<Camera3StreamSplitter> splitter = mStreamSplitter;
+    if (splitter != nullptr) {
+        splitter->dump(fd);
+    }
+}
+
 status_t Camera3SharedOutputStream::notifyBufferReleased(ANativeWindowBuffer *anwBuffer) {
     Mutex::Autolock l(mLock);
     status_t res = OK;
@@ -71,6 +71,8 @@ public:
             const std::vector<size_t> &removedSurfaceIds,
             KeyedVector<sp<Surface>, size_t> *outputMap/*out*/);
 
+    virtual void dump(int fd, const Vector<String16> &args) const;
+
     virtual bool getOfflineProcessingSupport() const {
         // As per Camera spec. shared streams currently do not support
         // offline mode.
@@ -144,6 +144,13 @@ void Camera3StreamSplitter::disconnect() {
     mOutputSlots.clear();
     mConsumerBufferCount.clear();
 
+    if (mOutputStats.size() > 0) {
+        String8 lines;
+        formatOutputStatsLocked(lines);
+        SP_LOGI("Output statistics:\n%s", lines.string());
+        mOutputStats.clear();
+    }
+
     if (mConsumer.get() != nullptr) {
         mConsumer->consumerDisconnect();
     }
@@ -393,21 +400,51 @@ status_t Camera3StreamSplitter::outputBufferLocked(const sp<IGraphicBufferProduc
         // If we just discovered that this output has been abandoned, note
         // that, increment the release count so that we still release this
         // buffer eventually, and move on to the next output
+        mOutputStats[surfaceId].queueErrorCount++;
         onAbandonedLocked();
         decrementBufRefCountLocked(bufferItem.mGraphicBuffer->getId(), surfaceId);
         return res;
     }
 
+    OutputStats& stats = mOutputStats[surfaceId];
+    stats.queuedCount++;
     // If the queued buffer replaces a pending buffer in the async
     // queue, no onBufferReleased is called by the buffer queue.
     // Proactively trigger the callback to avoid buffer loss.
     if (queueOutput.bufferReplaced) {
+        stats.replacedCount++;
         onBufferReplacedLocked(output, surfaceId);
     }
 
     return res;
 }
 
+void Camera3StreamSplitter::dump(int fd) {
+    Mutex::Autolock lock(mMutex);
+    if (mOutputStats.size() == 0) {
+        return;
+    }
+
+    String8 lines;
+    lines.appendFormat("      Stream splitter %s outputs:\n", mConsumerName.string());
+    formatOutputStatsLocked(lines);
+    write(fd, lines.string(), lines.size());
+}
+
+void Camera3StreamSplitter::formatOutputStatsLocked(String8& lines) {
+    for (const auto& it : mOutputStats) {
+        const OutputStats& stats = it.second;
+        lines.appendFormat("        Surface %zu: queued %" PRIu64 ", replaced %" PRIu64
+                ", attach errors %" PRIu64 ", queue errors %" PRIu64
+                ", attach time avg %" PRId64 " us, max %" PRId64 " us\n",
+                it.first, stats.queuedCount, stats.replacedCount, stats.attachErrorCount,
+                stats.queueErrorCount,
+                stats.attachCount > 0 ?
+                        ns2us(stats.totalAttachTime) / (int64_t) stats.attachCount : 0,
+                ns2us(stats.maxAttachTime));
+    }
+}
+
 String8 Camera3StreamSplitter::getUniqueConsumerName() {
     static volatile int32_t counter = 0;
     return String8::format("Camera3StreamSplitter-%d", android_atomic_inc(&counter));
@@ -454,9 +491,16 @@ status_t Camera3StreamSplitter::attachBufferToOutputs(ANativeWindowBuffer* anb,
         //we block while holding the lock, onFrameAvailable and onBufferReleased
         //will block as well because they need to acquire the same lock.
         mMutex.unlock();
+        nsecs_t attachStart = systemTime();
         res = gbp->attachBuffer(&slot, gb);
+        nsecs_t attachTime = systemTime() - attachStart;
         mMutex.lock();
+        OutputStats& stats = mOutputStats[surface_id];
+        stats.attachCount++;
+        stats.totalAttachTime += attachTime;
+        stats.maxAttachTime = std::max(stats.maxAttachTime, attachTime);
         if (res != OK) {
+            stats.attachErrorCount++;
             SP_LOGE("%s: Cannot attachBuffer from GraphicBufferProducer %p: %s (%d)",
                     __FUNCTION__, gbp.get(), strerror(-res), res);
             // TODO: might need to detach/cleanup the already attached buffers before return?
@@ -94,6 +94,9 @@ public:
     // Disconnect the buffer queue from output surfaces.
     void disconnect();
 
+    // Dump the per-output buffer statistics.
+    void dump(int fd);
+
 private:
     // From IConsumerListener
     //
@@ -224,6 +227,9 @@ private:
     // Get unique name for the buffer queue consumer
     String8 getUniqueConsumerName();
 
+    // Write the per-output buffer statistics to lines.
+    void formatOutputStatsLocked(String8& lines);
+
     // Helper function to get the BufferQueue slot where a particular buffer is attached to.
     int getSlotForOutputLocked(const sp<IGraphicBufferProducer>& gbp,
             const sp<GraphicBuffer>& gb);
@@ -279,6 +285,25 @@ private:
     std::unordered_map<sp<IGraphicBufferProducer>, std::unique_ptr<OutputSlots>,
             GBPHash> mOutputSlots;
 
+    // Buffer statistics of an output surface, to tell which consumer is
+    // slowing down or losing frames of a shared stream.
+    struct OutputStats {
+        // Buffers queued to the output successfully
+        uint64_t queuedCount = 0;
+        // Queued buffers that the output dropped because it had a newer one
+        uint64_t replacedCount = 0;
+        // Buffers that failed to attach to or queue to the output
+        uint64_t attachErrorCount = 0;
+        uint64_t queueErrorCount = 0;
+        // Time spent in attachBuffer, which blocks when the consumer is slow
+        uint64_t attachCount = 0;
+        nsecs_t totalAttachTime = 0;
+        nsecs_t maxAttachTime = 0;
+    };
+
+    //Map surface ids -> output buffer statistics
+    std::unordered_map<size_t, OutputStats> mOutputStats;
+
     //A set of buffers that could potentially stay in some of the outputs after removal
     //and therefore should be detached from the input queue.
     std::unordered_set<uint64_t> mDetachedBuffers;
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include "device3/DistortionMapper.h"
 #include "utils/SessionConfigurationUtilsHost.h"
@@ -278,7 +279,7 @@ status_t DistortionMapper::mapRawToCorrected(int32_t *coordPairs, int coordCount
     }
 
     for (int i = 0; i < coordCount * 2; i += 2) {
-        const GridQuad *quad = findEnclosingQuad(coordPairs + i, mapperInfo->mDistortedGrid);
+        const GridQuad *quad = findEnclosingQuad(coordPairs + i, *mapperInfo);
         if (quad == nullptr) {
             ALOGE("Raw to corrected mapping failure: No quad found for (%d, %d)",
                     *(coordPairs + i), *(coordPairs + i + 1));
@@ -488,43 +489,143 @@ status_t DistortionMapper::buildGrids(DistortionMapperInfo *mapperInfo) {
         }
     }
 
+    buildLookupGrid(mapperInfo);
+
     mapperInfo->mValidGrids = true;
     return OK;
 }
 
+void DistortionMapper::getLookupCellRange(float minValue, float maxValue, float lookupMin,
+        float invCellSize, int *firstCell, int *lastCell) {
+    // Clamp to the lookup grid; values at the far edge of the grid belong to the last cell
+    const float maxCell = kLookupGridSize - 1;
+    *firstCell = static_cast<int>(
+            std::min(maxCell, std::max(0.f, std::floor((minValue - lookupMin) * invCellSize))));
+    *lastCell = static_cast<int>(
+            std::min(maxCell, std::max(0.f, std::floor((maxValue - lookupMin) * invCellSize))));
+}
+
+void DistortionMapper::buildLookupGrid(DistortionMapperInfo *mapperInfo) {
+    const std::vector<GridQuad>& grid = mapperInfo->mDistortedGrid;
+
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    float maxY = std::numeric_limits<float>::lowest();
+    for (const GridQuad& quad : grid) {
+        for (size_t i = 0; i < quad.coords.size(); i += 2) {
+            minX = std::min(minX, quad.coords[i]);
+            maxX = std::max(maxX, quad.coords[i]);
+            minY = std::min(minY, quad.coords[i + 1]);
+            maxY = std::max(maxY, quad.coords[i + 1]);
+        }
+    }
+    mapperInfo->mLookupMinX = minX;
+    mapperInfo->mLookupMinY = minY;
+    mapperInfo->mLookupInvCellWidth = kLookupGridSize / std::max(maxX - minX, 1.f);
+    mapperInfo->mLookupInvCellHeight = kLookupGridSize / std::max(maxY - minY, 1.f);
+
+    // Bounding box cell range of every quad
+    std::vector<std::array<int, 4>> quadCells(grid.size());
+    std::vector<uint32_t> cellCounts(kLookupGridSize * kLookupGridSize, 0);
+    for (size_t q = 0; q < grid.size(); q++) {
+        const auto& coords = grid[q].coords;
+        float quadMinX = std::min({coords[0], coords[2], coords[4], coords[6]});
+        float quadMaxX = std::max({coords[0], coords[2], coords[4], coords[6]});
+        float quadMinY = std::min({coords[1], coords[3], coords[5], coords[7]});
+        float quadMaxY = std::max({coords[1], coords[3], coords[5], coords[7]});
+        auto& cells = quadCells[q];
+        getLookupCellRange(quadMinX, quadMaxX, minX, mapperInfo->mLookupInvCellWidth,
+                &cells[0], &cells[1]);
+        getLookupCellRange(quadMinY, quadMaxY, minY, mapperInfo->mLookupInvCellHeight,
+                &cells[2], &cells[3]);
+        for (int cy = cells[2]; cy <= cells[3]; cy++) {
+            for (int cx = cells[0]; cx <= cells[1]; cx++) {
+                cellCounts[cy * kLookupGridSize + cx]++;
+            }
+        }
+    }
+
+    mapperInfo->mLookupCellStart.resize(cellCounts.size() + 1);
+    mapperInfo->mLookupCellStart[0] = 0;
+    for (size_t c = 0; c < cellCounts.size(); c++) {
+        mapperInfo->mLookupCellStart[c + 1] = mapperInfo->mLookupCellStart[c] + cellCounts[c];
+    }
+
+    // Fill the cells in quad order so lookups find the same quad as a search of the whole grid
+    mapperInfo->mLookupQuads.resize(mapperInfo->mLookupCellStart.back());
+    std::vector<uint32_t> cellFill(mapperInfo->mLookupCellStart.begin(),
+            mapperInfo->mLookupCellStart.end() - 1);
+    for (size_t q = 0; q < grid.size(); q++) {
+        const auto& cells = quadCells[q];
+        for (int cy = cells[2]; cy <= cells[3]; cy++) {
+            for (int cx = cells[0]; cx <= cells[1]; cx++) {
+                mapperInfo->mLookupQuads[cellFill[cy * kLookupGridSize + cx]++] =
+                        static_cast<uint16_t>(q);
+            }
+        }
+    }
+}
+
+// Point-in-quad test:
+// Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
+// edges (or on top of one of the edges or corners), traversed in a consistent direction.
+// This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
+// have the same sign (or be zero) for all edges.
+// For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
+// En is to the left of Ep, or overlapping.
+static inline bool isInsideQuad(float x, float y, const DistortionMapper::GridQuad& quad) {
+    const float &x1 = quad.coords[0];
+    const float &y1 = quad.coords[1];
+    const float &x2 = quad.coords[2];
+    const float &y2 = quad.coords[3];
+    const float &x3 = quad.coords[4];
+    const float &y3 = quad.coords[5];
+    const float &x4 = quad.coords[6];
+    const float &y4 = quad.coords[7];
+
+    float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
+    if (s1 > 0) return false;
+    float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
+    if (s2 > 0) return false;
+    float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
+    if (s3 > 0) return false;
+    float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
+    if (s4 > 0) return false;
+
+    return true;
+}
+
+const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
+        const int32_t pt[2], const DistortionMapperInfo& mapperInfo) {
+    const float x = pt[0];
+    const float y = pt[1];
+
+    // Points outside of the lookup grid are clamped to an edge cell, and then fail the
+    // point-in-quad test of all of its quads
+    int cx, cy, unused;
+    getLookupCellRange(x, x, mapperInfo.mLookupMinX, mapperInfo.mLookupInvCellWidth,
+            &cx, &unused);
+    getLookupCellRange(y, y, mapperInfo.mLookupMinY, mapperInfo.mLookupInvCellHeight,
+            &cy, &unused);
+    size_t cell = cy * kLookupGridSize + cx;
+    for (uint32_t i = mapperInfo.mLookupCellStart[cell];
+            i < mapperInfo.mLookupCellStart[cell + 1]; i++) {
+        const GridQuad& quad = mapperInfo.mDistortedGrid[mapperInfo.mLookupQuads[i]];
+        if (isInsideQuad(x, y, quad)) {
+            return &quad;
+        }
+    }
+    return nullptr;
+}
+
 const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
         const int32_t pt[2], const std::vector<GridQuad>& grid) {
     const float x = pt[0];
     const float y = pt[1];
 
     for (const GridQuad& quad : grid) {
-        const float &x1 = quad.coords[0];
-        const float &y1 = quad.coords[1];
-        const float &x2 = quad.coords[2];
-        const float &y2 = quad.coords[3];
-        const float &x3 = quad.coords[4];
-        const float &y3 = quad.coords[5];
-        const float &x4 = quad.coords[6];
-        const float &y4 = quad.coords[7];
-
-        // Point-in-quad test:
-
-        // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
-        // edges (or on top of one of the edges or corners), traversed in a consistent direction.
-        // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
-        // have the same sign (or be zero) for all edges.
-        // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
-        // En is to the left of Ep, or overlapping.
-        float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
-        if (s1 > 0) continue;
-        float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
-        if (s2 > 0) continue;
-        float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
-        if (s3 > 0) continue;
-        float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
-        if (s4 > 0) continue;
-
-        return &quad;
+        if (isInsideQuad(x, y, quad)) return &quad;
     }
     return nullptr;
 }
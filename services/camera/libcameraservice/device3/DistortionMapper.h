@@ -155,12 +155,25 @@ class DistortionMapper : public CoordinateMapper {
 
         std::vector<GridQuad> mCorrectedGrid;
         std::vector<GridQuad> mDistortedGrid;
+
+        // Uniform lookup grid over the bounding box of mDistortedGrid. The quads whose
+        // bounding box overlaps cell c are mLookupQuads[mLookupCellStart[c]] up to
+        // mLookupQuads[mLookupCellStart[c + 1]], in mDistortedGrid order.
+        float mLookupMinX, mLookupMinY;
+        float mLookupInvCellWidth, mLookupInvCellHeight;
+        std::vector<uint32_t> mLookupCellStart;
+        std::vector<uint16_t> mLookupQuads;
     };
 
     // Find which grid quad encloses the point; returns null if none do
     static const GridQuad* findEnclosingQuad(
             const int32_t pt[2], const std::vector<GridQuad>& grid);
 
+    // Find which quad of the distorted grid encloses the point using the lookup grid; returns
+    // the same quad as a search through the whole distorted grid, or null if none do
+    static const GridQuad* findEnclosingQuad(
+            const int32_t pt[2], const DistortionMapperInfo& mapperInfo);
+
     // Calculate 'horizontal' interpolation coordinate for the point and the quad
     // Assumes the point P is within the quad Q.
     // Given quad with points P1-P4, and edges E12-E41, and considering the edge segments as
@@ -184,6 +197,8 @@ class DistortionMapper : public CoordinateMapper {
 
     // Number of quads in each dimension of the mapping grids
     constexpr static size_t kGridSize = 15;
+    // Number of cells in each dimension of the quad lookup grid
+    constexpr static size_t kLookupGridSize = 32;
     // Margin to expand the grid by to ensure it doesn't clip the domain
     constexpr static float kGridMargin = 0.05f;
     // Fuzziness for float inequality tests
@@ -209,6 +224,13 @@ class DistortionMapper : public CoordinateMapper {
     // Utility to create reverse mapping grids
     status_t buildGrids(DistortionMapperInfo *mapperInfo);
 
+    // Utility to create the quad lookup grid for the distorted grid
+    static void buildLookupGrid(DistortionMapperInfo *mapperInfo);
+
+    // Returns the lookup grid cell range covering [minValue, maxValue] in one dimension
+    static void getLookupCellRange(float minValue, float maxValue, float lookupMin,
+            float invCellSize, int *firstCell, int *lastCell);
+
     DistortionMapperInfo mDistortionMapperInfo;
     DistortionMapperInfo mDistortionMapperInfoMaximumResolution;
 
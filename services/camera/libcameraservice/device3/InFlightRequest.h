@@ -188,6 +188,14 @@ struct InFlightRequest {
     // Time of capture request (from systemTime) in Ns
     nsecs_t requestTimeNs;
 
+    // Times (from systemTime) in Ns at which the request was registered for submission to the
+    // HAL, and at which the shutter, the first partial result and the final result metadata
+    // arrived from the HAL. 0 if not arrived yet.
+    nsecs_t halSubmitTimeNs;
+    nsecs_t shutterNotifyTimeNs;
+    nsecs_t partialResultTimeNs;
+    nsecs_t finalResultTimeNs;
+
     // What shared surfaces an output should go to
     SurfaceMap outputSurfaces;
 
@@ -215,6 +223,10 @@ struct InFlightRequest {
             zslCapture(false),
             rotateAndCropAuto(false),
             requestTimeNs(0),
+            halSubmitTimeNs(0),
+            shutterNotifyTimeNs(0),
+            partialResultTimeNs(0),
+            finalResultTimeNs(0),
             transform(-1) {
     }
 
@@ -242,6 +254,10 @@ struct InFlightRequest {
             rotateAndCropAuto(rotateAndCropAuto),
             cameraIdsWithZoom(idsWithZoom),
             requestTimeNs(requestNs),
+            halSubmitTimeNs(systemTime()),
+            shutterNotifyTimeNs(0),
+            partialResultTimeNs(0),
+            finalResultTimeNs(0),
             outputSurfaces(outSurfaces),
             transform(-1) {
     }
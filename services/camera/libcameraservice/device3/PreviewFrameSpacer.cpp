@@ -18,6 +18,8 @@
 #define ATRACE_TAG ATRACE_TAG_CAMERA
 //#define LOG_NDEBUG 0
 
+#include <cstdlib>
+
 #include <utils/Log.h>
 
 #include "PreviewFrameSpacer.h"
@@ -29,7 +31,8 @@ namespace camera3 {
 
 PreviewFrameSpacer::PreviewFrameSpacer(wp<Camera3OutputStream> parent, sp<Surface> consumer) :
         mParent(parent),
-        mConsumer(consumer) {
+        mConsumer(consumer),
+        mFrameJitter(kFrameJitterBinSize) {
 }
 
 PreviewFrameSpacer::~PreviewFrameSpacer() {
@@ -63,8 +66,10 @@ bool PreviewFrameSpacer::threadLoop() {
     // If the readout interval exceeds threshold, directly queue
     // cached buffer.
     if (readoutInterval >= kFrameIntervalThreshold) {
-        mPendingBuffers.pop();
-        queueBufferToClientLocked(buffer, currentTime);
+        popBufferLocked(currentTime);
+        mLock.unlock();
+        queueBufferToClient(buffer);
+        mLock.lock();
         return true;
     }
 
@@ -83,8 +88,10 @@ bool PreviewFrameSpacer::threadLoop() {
     ALOGV("%s: readoutInterval %" PRId64 ", waited for %" PRId64
             ", timestamp %" PRId64, __FUNCTION__, readoutInterval,
             mPendingBuffers.size() < 2 ? frameWaitTime : 0, buffer.timestamp);
-    mPendingBuffers.pop();
-    queueBufferToClientLocked(buffer, currentTime);
+    popBufferLocked(currentTime);
+    mLock.unlock();
+    queueBufferToClient(buffer);
+    mLock.lock();
     return true;
 }
 
@@ -95,8 +102,32 @@ void PreviewFrameSpacer::requestExit() {
     mBufferCond.signal();
 }
 
-void PreviewFrameSpacer::queueBufferToClientLocked(
-        const BufferHolder& bufferHolder, nsecs_t currentTime) {
+void PreviewFrameSpacer::dump(int fd) const {
+    Mutex::Autolock l(mLock);
+    mFrameJitter.dump(fd, "      Preview frame interval jitter histogram:");
+}
+
+void PreviewFrameSpacer::logAndResetStats() {
+    Mutex::Autolock l(mLock);
+    mFrameJitter.log("Preview frame interval jitter histogram");
+    mFrameJitter.reset();
+}
+
+PreviewFrameSpacer::BufferHolder PreviewFrameSpacer::popBufferLocked(nsecs_t currentTime) {
+    BufferHolder bufferHolder = mPendingBuffers.front();
+    mPendingBuffers.pop();
+
+    nsecs_t readoutInterval = bufferHolder.readoutTimestamp - mLastCameraReadoutTime;
+    if (mLastCameraPresentTime != 0 && readoutInterval < kFrameIntervalThreshold) {
+        nsecs_t presentInterval = currentTime - mLastCameraPresentTime;
+        mFrameJitter.add(0, std::abs(presentInterval - readoutInterval));
+    }
+    mLastCameraPresentTime = currentTime;
+    mLastCameraReadoutTime = bufferHolder.readoutTimestamp;
+    return bufferHolder;
+}
+
+void PreviewFrameSpacer::queueBufferToClient(const BufferHolder& bufferHolder) {
     sp<Camera3OutputStream> parent = mParent.promote();
     if (parent == nullptr) {
         ALOGV("%s: Parent camera3 output stream was destroyed", __FUNCTION__);
@@ -125,8 +156,6 @@ void PreviewFrameSpacer::queueBufferToClientLocked(
     }
 
     parent->onCachedBufferQueued();
-    mLastCameraPresentTime = currentTime;
-    mLastCameraReadoutTime = bufferHolder.readoutTimestamp;
 }
 
 }; // namespace camera3
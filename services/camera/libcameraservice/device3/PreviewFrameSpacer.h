@@ -25,6 +25,8 @@
 #include <utils/Thread.h>
 #include <utils/Timers.h>
 
+#include "utils/LatencyHistogram.h"
+
 namespace android {
 
 namespace camera3 {
@@ -59,6 +61,10 @@ class PreviewFrameSpacer : public Thread {
     bool threadLoop() override;
     void requestExit() override;
 
+    // Dump and reset the frame interval jitter statistics
+    void dump(int fd) const;
+    void logAndResetStats();
+
   private:
     // structure holding cached preview buffer info
     struct BufferHolder {
@@ -73,7 +79,12 @@ class PreviewFrameSpacer : public Thread {
                 releaseFence(rf) {}
     };
 
-    void queueBufferToClientLocked(const BufferHolder& bufferHolder, nsecs_t currentTime);
+    // Queue the buffer to the consumer. Called without mLock held, since
+    // queueBuffer may block and the capture result path must not wait on it.
+    void queueBufferToClient(const BufferHolder& bufferHolder);
+
+    // Remove the oldest cached buffer and record its presentation time
+    BufferHolder popBufferLocked(nsecs_t currentTime);
 
     wp<Camera3OutputStream> mParent;
     sp<ANativeWindow> mConsumer;
@@ -83,7 +94,10 @@ class PreviewFrameSpacer : public Thread {
     std::queue<BufferHolder> mPendingBuffers;
     nsecs_t mLastCameraReadoutTime = 0;
     nsecs_t mLastCameraPresentTime = 0;
-    static constexpr nsecs_t kWaitDuration = 5000000LL; // 50ms
+    // Deviation of the presentation intervals from the readout intervals
+    CameraLatencyHistogram mFrameJitter;
+    static constexpr int32_t kFrameJitterBinSize = 1; // in ms
+    static constexpr nsecs_t kWaitDuration = 5000000LL; // 5ms
     static constexpr nsecs_t kFrameIntervalThreshold = 80000000LL; // 80ms
     static constexpr nsecs_t kMaxFrameWaitTime = 10000000LL; // 10ms
     static constexpr nsecs_t kFrameAdjustThreshold = 2000000LL; // 2ms
@@ -30,10 +30,10 @@ namespace android {
 namespace camera3 {
 
 StatusTracker::StatusTracker(wp<Camera3Device> parent) :
-        mComponentsChanged(false),
         mParent(parent),
         mNextComponentId(0),
-        mIdleFence(new Fence()),
+        mActiveComponentCount(0),
+        mIdleFence(Fence::NO_FENCE),
         mDeviceState(IDLE) {
 }
 
@@ -41,47 +41,36 @@ StatusTracker::~StatusTracker() {
 }
 
 int StatusTracker::addComponent(std::string componentName) {
-    int id;
-    ssize_t err;
-    {
-        Mutex::Autolock l(mLock);
-        id = mNextComponentId++;
-        ALOGV("%s: Adding new component %d", __FUNCTION__, id);
+    Mutex::Autolock l(mLock);
+    int id = mNextComponentId++;
+    ALOGV("%s: Adding new component %d", __FUNCTION__, id);
 
-        err = mStates.add(id, IDLE);
-        if (componentName.empty()) {
-            componentName = std::to_string(id);
-        }
-        mComponentNames.add(id, componentName);
-        ALOGE_IF(err < 0, "%s: Can't add new component %d (%s): %s (%zd)",
-                __FUNCTION__, id, componentName.c_str(), strerror(-err), err);
+    ssize_t err = mStates.add(id, IDLE);
+    if (componentName.empty()) {
+        componentName = std::to_string(id);
     }
+    mComponentNames.add(id, componentName);
+    ALOGE_IF(err < 0, "%s: Can't add new component %d (%s): %s (%zd)",
+            __FUNCTION__, id, componentName.c_str(), strerror(-err), err);
 
-    if (err >= 0) {
-        Mutex::Autolock pl(mPendingLock);
-        mComponentsChanged = true;
-        mPendingChangeSignal.signal();
-    }
+    // New components start idle, so the overall device state can't change
 
     return err < 0 ? err : id;
 }
 
 void StatusTracker::removeComponent(int id) {
-    ssize_t idx;
-    {
-        Mutex::Autolock l(mLock);
-        ALOGV("%s: Removing component %d", __FUNCTION__, id);
-        idx = mStates.removeItem(id);
-        mComponentNames.removeItem(id);
-    }
+    Mutex::Autolock l(mLock);
+    ALOGV("%s: Removing component %d", __FUNCTION__, id);
+    ssize_t idx = mStates.indexOfKey(id);
+    if (idx < 0) return;
 
-    if (idx >= 0) {
-        Mutex::Autolock pl(mPendingLock);
-        mComponentsChanged = true;
-        mPendingChangeSignal.signal();
+    if (mStates.valueAt(idx) == ACTIVE) {
+        mActiveComponentCount--;
     }
+    mStates.removeItemsAt(idx);
+    mComponentNames.removeItem(id);
 
-    return;
+    updateDeviceStateLocked();
 }
 
 
@@ -111,32 +100,39 @@ void StatusTracker::markComponent(int id, ComponentState state,
         const sp<Fence>& componentFence) {
     ALOGV("%s: Component %d is now %s", __FUNCTION__, id,
             state == IDLE ? "idle" : "active");
-    Mutex::Autolock l(mPendingLock);
+    Mutex::Autolock l(mLock);
+
+    ssize_t idx = mStates.indexOfKey(id);
+    // Ignore notices for unknown components
+    if (idx < 0) return;
 
-    StateChange newState = {
-        id,
-        state,
-        componentFence
-    };
+    if (mStates.valueAt(idx) != state) {
+        mStates.replaceValueAt(idx, state);
+        if (state == ACTIVE) {
+            mActiveComponentCount++;
+        } else {
+            mActiveComponentCount--;
+        }
+    }
+    if (componentFence != nullptr && componentFence->isValid()) {
+        mIdleFence = Fence::merge(String8("idleFence"), mIdleFence, componentFence);
+    }
 
-    mPendingChangeQueue.add(newState);
-    mPendingChangeSignal.signal();
+    updateDeviceStateLocked();
 }
 
 void StatusTracker::requestExit() {
     // First mark thread dead
     Thread::requestExit();
     // Then exit any waits
-    mPendingChangeSignal.signal();
+    Mutex::Autolock l(mLock);
+    mStateChangeSignal.signal();
 }
 
 StatusTracker::ComponentState StatusTracker::getDeviceStateLocked() {
-    for (size_t i = 0; i < mStates.size(); i++) {
-        if (mStates.valueAt(i) == ACTIVE) {
-            ALOGV("%s: Component %d not idle", __FUNCTION__,
-                    mStates.keyAt(i));
-            return ACTIVE;
-        }
+    if (mActiveComponentCount > 0) {
+        ALOGV("%s: %zu components not idle", __FUNCTION__, mActiveComponentCount);
+        return ACTIVE;
     }
     // - If not yet signaled, getSignalTime returns INT64_MAX
     // - If invalid fence or error, returns -1
@@ -148,18 +144,38 @@ StatusTracker::ComponentState StatusTracker::getDeviceStateLocked() {
 
     ALOGV_IF(!fencesDone, "%s: Fences still to wait on", __FUNCTION__);
 
+    if (fencesDone) {
+        // No need to keep merging new fences into ones that have already signalled
+        mIdleFence = Fence::NO_FENCE;
+    }
+
     return fencesDone ? IDLE : ACTIVE;
 }
 
+void StatusTracker::updateDeviceStateLocked() {
+    ComponentState newState = getDeviceStateLocked();
+    if (newState != mDeviceState) {
+        mDeviceState = newState;
+        // Only collect changes to overall device state
+        mStateTransitions.add(newState);
+        mStateChangeSignal.signal();
+    } else if (mActiveComponentCount == 0 && newState == ACTIVE) {
+        // All components are idle, but their fences haven't signalled yet
+        mStateChangeSignal.signal();
+    }
+}
+
 bool StatusTracker::threadLoop() {
     status_t res;
+    sp<Camera3Device> parent;
+    Vector<ComponentState> transitions;
 
-    // Wait for state updates
     {
-        Mutex::Autolock pl(mPendingLock);
-        while (mPendingChangeQueue.size() == 0 && !mComponentsChanged) {
-            res = mPendingChangeSignal.waitRelative(mPendingLock,
-                    kWaitDuration);
+        Mutex::Autolock l(mLock);
+        // Wait for overall state transitions, or for idle fences to wait on
+        while (mStateTransitions.size() == 0 &&
+                !(mActiveComponentCount == 0 && mDeviceState == ACTIVE)) {
+            res = mStateChangeSignal.waitRelative(mLock, kWaitDuration);
             if (exitPending()) return false;
             if (res != OK) {
                 if (res != TIMED_OUT) {
@@ -170,62 +186,35 @@ bool StatusTracker::threadLoop() {
                 break;
             }
         }
-    }
-
-    // After new pending states appear, or timeout, check if we're idle.  Even
-    // with timeout, need to check to account for fences that may still be
-    // clearing out
-    sp<Camera3Device> parent;
-    {
-        Mutex::Autolock pl(mPendingLock);
-        Mutex::Autolock l(mLock);
 
-        // Collect all pending state updates and see if the device
-        // collectively transitions between idle and active for each one
-
-        // First pass for changed components or fence completions
-        ComponentState prevState = getDeviceStateLocked();
-        if (prevState != mDeviceState) {
-            // Only collect changes to overall device state
-            mStateTransitions.add(prevState);
-        }
-        // For each pending component state update, check if we've transitioned
-        // to a new overall device state
-        for (size_t i = 0; i < mPendingChangeQueue.size(); i++) {
-            const StateChange &newState = mPendingChangeQueue[i];
-            ssize_t idx = mStates.indexOfKey(newState.id);
-            // Ignore notices for unknown components
-            if (idx >= 0) {
-                // Update single component state
-                mStates.replaceValueAt(idx, newState.state);
-                mIdleFence = Fence::merge(String8("idleFence"),
-                        mIdleFence, newState.fence);
-                // .. and see if overall device state has changed
-                ComponentState newState = getDeviceStateLocked();
-                if (newState != prevState) {
-                    mStateTransitions.add(newState);
-                }
-                prevState = newState;
-            }
+        if (mStateTransitions.size() == 0 && mActiveComponentCount == 0 &&
+                mDeviceState == ACTIVE) {
+            // The only thing keeping the device active is the idle fence, so
+            // wait on it directly instead of polling it.
+            sp<Fence> idleFence = mIdleFence;
+            mLock.unlock();
+            res = idleFence->wait(kWaitDuration / 1000000LL);
+            mLock.lock();
+            if (exitPending()) return false;
+            ALOGE_IF(res != OK && res != TIMED_OUT, "%s: Error waiting on idle fence: %s (%d)",
+                    __FUNCTION__, strerror(-res), res);
+            // Components may have changed while waiting, so recheck everything
+            updateDeviceStateLocked();
         }
-        mPendingChangeQueue.clear();
-        mComponentsChanged = false;
-
-        // Store final state after all pending state changes are done with
 
-        mDeviceState = prevState;
+        transitions = mStateTransitions;
+        mStateTransitions.clear();
         parent = mParent.promote();
     }
 
     // Notify parent for all intermediate transitions
-    if (mStateTransitions.size() > 0 && parent.get()) {
-        for (size_t i = 0; i < mStateTransitions.size(); i++) {
-            bool idle = (mStateTransitions[i] == IDLE);
+    if (transitions.size() > 0 && parent.get()) {
+        for (size_t i = 0; i < transitions.size(); i++) {
+            bool idle = (transitions[i] == IDLE);
             ALOGV("Camera device is now %s", idle ? "idle" : "active");
             parent->notifyStatus(idle);
         }
     }
-    mStateTransitions.clear();
 
     return true;
 }
@@ -42,6 +42,11 @@ namespace camera3 {
  * The parent is responsible for synchronizing the status updates with its
  * internal state correctly, which means the notifyStatus call to the parent may
  * block for a while.
+ *
+ * Component state changes are applied by the calling thread as they happen,
+ * with a running count of active components. The tracker thread is only woken
+ * up when the overall device state changes, to deliver the transition to the
+ * parent, or to wait on the idle fences of the last component to go idle.
  */
 class StatusTracker: public Thread {
   public:
@@ -84,43 +89,38 @@ class StatusTracker: public Thread {
     void markComponent(int id, ComponentState state,
             const sp<Fence>& componentFence);
 
-    // Guards mPendingChange, mPendingStates, mComponentsChanged
-    Mutex mPendingLock;
-
-    Condition mPendingChangeSignal;
-
-    struct StateChange {
-        int id;
-        ComponentState state;
-        sp<Fence> fence;
-    };
-    // A queue of yet-to-be-processed state changes to components
-    Vector<StateChange> mPendingChangeQueue;
-    bool mComponentsChanged;
+    // Recompute the overall device state after a component change, and queue
+    // up a transition for the parent if it changed. Wakes up the tracker
+    // thread only when there is something for it to do.
+    void updateDeviceStateLocked();
 
     wp<Camera3Device> mParent;
 
-    // Guards rest of internals. Must be locked after mPendingLock if both used.
+    // Guards all internals
     Mutex mLock;
 
+    // Signaled when there are transitions to deliver or idle fences to wait on
+    Condition mStateChangeSignal;
+
     int mNextComponentId;
 
     // Current component states
     KeyedVector<int, ComponentState> mStates;
     KeyedVector<int, std::string> mComponentNames;
-    // Merged fence for all processed state changes
+    // Number of components in mStates that are currently ACTIVE
+    size_t mActiveComponentCount;
+    // Merged fence for all component idle updates not yet known to have signalled
     sp<Fence> mIdleFence;
     // Current overall device state
     ComponentState mDeviceState;
 
-    // Private to threadLoop
-
     // Determine current overall device state
     // We're IDLE iff
     // - All components are currently IDLE
     // - The merged fence for all component updates has signalled
     ComponentState getDeviceStateLocked();
 
+    // Overall device state transitions not yet delivered to the parent
     Vector<ComponentState> mStateTransitions;
 
     static const nsecs_t kWaitDuration = 250000000LL; // 250 ms
@@ -446,21 +446,23 @@ void ZoomRatioMapper::scaleCoordinates(int32_t* coordPairs, int coordCount,
     // the active array (shifted by 0.5 pixel as well).
     // 3. Shift the coordinate system back by directly using the pixel center
     // coordinate.
+    const float centerX = (arrayWidth - 2) / 2;
+    const float centerY = (arrayHeight - 2) / 2;
+    const int32_t right = arrayWidth - 1;
+    const int32_t bottom = arrayHeight - 1;
     for (int i = 0; i < coordCount * 2; i += 2) {
         float x = coordPairs[i];
         float y = coordPairs[i + 1];
-        float xCentered = x - (arrayWidth - 2) / 2;
-        float yCentered = y - (arrayHeight - 2) / 2;
+        float xCentered = x - centerX;
+        float yCentered = y - centerY;
         float scaledX = xCentered * scaleRatio;
         float scaledY = yCentered * scaleRatio;
-        scaledX += (arrayWidth - 2) / 2;
-        scaledY += (arrayHeight - 2) / 2;
+        scaledX += centerX;
+        scaledY += centerY;
         coordPairs[i] = static_cast<int32_t>(std::round(scaledX));
         coordPairs[i+1] = static_cast<int32_t>(std::round(scaledY));
         // Clamp to within activeArray/preCorrectionActiveArray
         if (clamp) {
-            int32_t right = arrayWidth - 1;
-            int32_t bottom = arrayHeight - 1;
             coordPairs[i] =
                     std::min(right, std::max(0, coordPairs[i]));
             coordPairs[i+1] =
@@ -482,10 +484,8 @@ void ZoomRatioMapper::scaleRects(int32_t* rects, int rectCount,
             rects[i + 1] + rects[i + 3] - 1
         };
 
-        // top-left
-        scaleCoordinates(coords, 1, scaleRatio, true /*clamp*/, arrayWidth, arrayHeight);
-        // bottom-right
-        scaleCoordinates(coords+2, 1, scaleRatio, true /*clamp*/, arrayWidth, arrayHeight);
+        // top-left and bottom-right
+        scaleCoordinates(coords, 2, scaleRatio, true /*clamp*/, arrayWidth, arrayHeight);
 
         // Map back to (l, t, width, height)
         rects[i] = coords[0];
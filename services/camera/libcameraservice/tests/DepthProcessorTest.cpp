@@ -143,6 +143,13 @@ TEST(DepthProcessorTest, BasicDepthPhotoValidation) {
                 &actualDepthPhotoSize), 0);
     ASSERT_TRUE((actualDepthPhotoSize > 0) && (depthPhotoBuffer.size() >= actualDepthPhotoSize));
 
+    // An output buffer that is too small must fail and report the required size.
+    std::vector<uint8_t> smallDepthPhotoBuffer(actualDepthPhotoSize - 1);
+    size_t requiredDepthPhotoSize = 0;
+    ASSERT_EQ(processDepthPhotoFrame(inputFrame, smallDepthPhotoBuffer.size(),
+                smallDepthPhotoBuffer.data(), &requiredDepthPhotoSize), NO_MEMORY);
+    ASSERT_EQ(requiredDepthPhotoSize, actualDepthPhotoSize);
+
     // The final depth photo must consist of three jpeg images:
     //  - the main color image
     //  - the depth map image
@@ -348,6 +348,68 @@ TEST(DistortionMapperTest, LargeTransform) {
     RandomTransformTest(this, testActiveArray, m, /*clamp*/false, /*simple*/false);
 }
 
+// Check that the quad lookup grid finds the same quads as a search of the whole distorted grid,
+// and record how long both take
+TEST(DistortionMapperTest, QuadLookup) {
+    status_t res;
+
+    float bigDistortion[] = {0.1, -0.003, 0.004, 0.02, 0.01};
+
+    DistortionMapper m;
+    setupTestMapper(&m, bigDistortion, testICal,
+            /*activeArray*/testActiveArray,
+            /*preCorrectionActiveArray*/testPreCorrActiveArray);
+
+    // Build the mapping grids
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+    auto coords = basicCoords;
+    res = m.mapRawToCorrected(coords.data(), 1, mapperInfo, /*clamp*/false, /*simple*/false);
+    ASSERT_EQ(res, OK);
+
+    unsigned int seed = 1234;
+    const size_t coordCount = 1e5;
+    std::default_random_engine gen(seed);
+    // Include points outside of the grid
+    std::uniform_int_distribution<int> x_dist(-testPreCorrActiveArray[2] / 2,
+            testPreCorrActiveArray[2] * 3 / 2);
+    std::uniform_int_distribution<int> y_dist(-testPreCorrActiveArray[3] / 2,
+            testPreCorrActiveArray[3] * 3 / 2);
+
+    std::vector<int32_t> randCoords(coordCount * 2);
+    for (size_t i = 0; i < randCoords.size(); i += 2) {
+        randCoords[i] = x_dist(gen);
+        randCoords[i + 1] = y_dist(gen);
+    }
+
+    std::vector<const DistortionMapper::GridQuad*> gridQuads(coordCount);
+    base::Timer gridTimer;
+    for (size_t i = 0; i < coordCount; i++) {
+        gridQuads[i] = DistortionMapper::findEnclosingQuad(randCoords.data() + i * 2,
+                mapperInfo->mDistortedGrid);
+    }
+    auto gridDuration = gridTimer.duration();
+
+    std::vector<const DistortionMapper::GridQuad*> lookupQuads(coordCount);
+    base::Timer lookupTimer;
+    for (size_t i = 0; i < coordCount; i++) {
+        lookupQuads[i] = DistortionMapper::findEnclosingQuad(randCoords.data() + i * 2,
+                *mapperInfo);
+    }
+    auto lookupDuration = lookupTimer.duration();
+
+    for (size_t i = 0; i < coordCount; i++) {
+        ASSERT_EQ(gridQuads[i], lookupQuads[i]) << "(" << randCoords[i * 2] << ", " <<
+                randCoords[i * 2 + 1] << ")";
+    }
+
+    RecordProperty("GridSearchDurationPerCoordUs", base::StringPrintf("%f",
+            (std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+                gridDuration) / coordCount).count()));
+    RecordProperty("LookupDurationPerCoordUs", base::StringPrintf("%f",
+            (std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+                lookupDuration) / coordCount).count()));
+}
+
 // Compare against values calculated by OpenCV
 // undistortPoints() method, which is the same as mapRawToCorrected
 // Ignore clamping
@@ -18,10 +18,13 @@
 #define ATRACE_TAG ATRACE_TAG_CAMERA
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <numeric>
 
 #include <inttypes.h>
+#include <unistd.h>
 #include <utils/Log.h>
+#include <utils/String8.h>
 
 #include "SessionStatsBuilder.h"
 
@@ -125,6 +128,65 @@ void SessionStatsBuilder::onDeviceError() {
     mDeviceError = true;
 }
 
+void SessionStatsBuilder::incResultTimingCounter(int64_t inflightLockDurationNs,
+        int64_t deliveryDurationNs) {
+    std::lock_guard<std::mutex> l(mLock);
+    mResultTimingCount++;
+    mInflightLockTotalNs += inflightLockDurationNs;
+    mInflightLockMaxNs = std::max(mInflightLockMaxNs, inflightLockDurationNs);
+    mDeliveryTotalNs += deliveryDurationNs;
+    mDeliveryMaxNs = std::max(mDeliveryMaxNs, deliveryDurationNs);
+}
+
+void SessionStatsBuilder::dumpResultTiming(int fd, const char* name) {
+    std::lock_guard<std::mutex> l(mLock);
+    if (mResultTimingCount == 0) {
+        return;
+    }
+
+    String8 lines;
+    lines.appendFormat("%s (%" PRId64 ") results\n", name, mResultTimingCount);
+    lines.appendFormat("      In-flight lock held: avg %" PRId64 " us, max %" PRId64 " us\n",
+            mInflightLockTotalNs / mResultTimingCount / 1000, mInflightLockMaxNs / 1000);
+    lines.appendFormat("      Metadata correction and delivery: avg %" PRId64 " us, max %" PRId64
+            " us\n", mDeliveryTotalNs / mResultTimingCount / 1000, mDeliveryMaxNs / 1000);
+    write(fd, lines.string(), lines.size());
+}
+
+void SessionStatsBuilder::incStageLatencyCounters(nsecs_t requestTimeNs,
+        nsecs_t halSubmitTimeNs, nsecs_t shutterTimeNs, nsecs_t partialResultTimeNs,
+        nsecs_t finalResultTimeNs, nsecs_t completeTimeNs) {
+    if (halSubmitTimeNs == 0) return;
+
+    std::lock_guard<std::mutex> l(mLock);
+    if (requestTimeNs != 0) {
+        mRequestQueueLatency.add(requestTimeNs, halSubmitTimeNs);
+    }
+    if (shutterTimeNs != 0) {
+        mShutterLatency.add(halSubmitTimeNs, shutterTimeNs);
+    }
+    if (partialResultTimeNs != 0) {
+        mPartialResultLatency.add(halSubmitTimeNs, partialResultTimeNs);
+    }
+    if (finalResultTimeNs != 0) {
+        mFinalResultLatency.add(halSubmitTimeNs, finalResultTimeNs);
+    }
+    mCompleteLatency.add(halSubmitTimeNs, completeTimeNs);
+}
+
+void SessionStatsBuilder::dumpStageLatency(int fd, const char* name) {
+    std::lock_guard<std::mutex> l(mLock);
+    String8 lines;
+    lines.appendFormat("%s\n", name);
+    write(fd, lines.string(), lines.size());
+
+    mRequestQueueLatency.dump(fd, "      Request submit to HAL submit:");
+    mShutterLatency.dump(fd, "      HAL submit to shutter:");
+    mPartialResultLatency.dump(fd, "      HAL submit to first partial result:");
+    mFinalResultLatency.dump(fd, "      HAL submit to final result:");
+    mCompleteLatency.dump(fd, "      HAL submit to request completion:");
+}
+
 void StreamStats::updateLatencyHistogram(int32_t latencyMs) {
     size_t i;
     for (i = 0; i < mCaptureLatencyBins.size(); i++) {
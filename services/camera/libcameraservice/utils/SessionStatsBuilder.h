@@ -23,6 +23,8 @@
 #include <map>
 #include <mutex>
 
+#include "LatencyHistogram.h"
+
 namespace android {
 
 // Helper class to build stream stats
@@ -76,14 +78,50 @@ public:
     void incResultCounter(bool dropped);
     void onDeviceError();
 
+    // Capture result processing time counters. These are kept for dumpsys and are not reset by
+    // buildAndReset.
+    void incResultTimingCounter(int64_t inflightLockDurationNs, int64_t deliveryDurationNs);
+    void dumpResultTiming(int fd, const char* name);
+
+    // Per-stage capture latency counters of a completed request. All times are from systemTime,
+    // and stages that didn't happen are 0. These are kept for dumpsys and are not reset by
+    // buildAndReset.
+    void incStageLatencyCounters(nsecs_t requestTimeNs, nsecs_t halSubmitTimeNs,
+            nsecs_t shutterTimeNs, nsecs_t partialResultTimeNs, nsecs_t finalResultTimeNs,
+            nsecs_t completeTimeNs);
+    void dumpStageLatency(int fd, const char* name);
+
     SessionStatsBuilder() : mRequestCount(0), mErrorResultCount(0),
-             mCounterStopped(false), mDeviceError(false) {}
+             mCounterStopped(false), mDeviceError(false), mResultTimingCount(0),
+             mInflightLockTotalNs(0), mInflightLockMaxNs(0), mDeliveryTotalNs(0),
+             mDeliveryMaxNs(0),
+             mRequestQueueLatency(kStageLatencyBinSizeMs),
+             mShutterLatency(kStageLatencyBinSizeMs),
+             mPartialResultLatency(kStageLatencyBinSizeMs),
+             mFinalResultLatency(kStageLatencyBinSizeMs),
+             mCompleteLatency(kStageLatencyBinSizeMs) {}
 private:
     std::mutex mLock;
     int64_t mRequestCount;
     int64_t mErrorResultCount;
     bool mCounterStopped;
     bool mDeviceError;
+    // Time spent in processCaptureResult with the in-flight lock held, and time spent
+    // correcting and queueing result metadata after it has been released.
+    int64_t mResultTimingCount;
+    int64_t mInflightLockTotalNs;
+    int64_t mInflightLockMaxNs;
+    int64_t mDeliveryTotalNs;
+    int64_t mDeliveryMaxNs;
+    // Time from the app submitting a request until it is sent to the HAL, and from sending it to
+    // the HAL until the shutter, the first partial result, the final result and the whole request
+    // completing.
+    static const int32_t kStageLatencyBinSizeMs = 20;
+    CameraLatencyHistogram mRequestQueueLatency;
+    CameraLatencyHistogram mShutterLatency;
+    CameraLatencyHistogram mPartialResultLatency;
+    CameraLatencyHistogram mFinalResultLatency;
+    CameraLatencyHistogram mCompleteLatency;
     std::string mUserTag;
     // Map from stream id to stream statistics
     std::map<int, StreamStats> mStatsMap;
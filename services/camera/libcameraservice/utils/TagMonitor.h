@@ -64,6 +64,10 @@ class TagMonitor {
     // Disable monitoring; does not clear the event log
     void disableMonitoring();
 
+    // Whether any tags are being monitored. Callers can use this to skip
+    // preparing metadata for monitorMetadata.
+    bool isMonitoringEnabled() const { return mMonitoringEnabled; }
+
     // Scan through the metadata and update the monitoring information
     void monitorMetadata(eventSource source, int64_t frameNumber,
             nsecs_t timestamp, const CameraMetadata& metadata,
@@ -20,6 +20,7 @@
 #include <sys/mman.h>
 #include <utils/Log.h>
 #include <binder/PermissionCache.h>
+#include <media/nblog/Archive.h>
 #include <media/nblog/Merger.h>
 #include <media/nblog/NBLog.h>
 #include <mediautils/ServiceUtilities.h>
@@ -107,7 +108,8 @@ status_t MediaLogService::dump(int fd, const Vector<String16>& args __unused)
 
     if (args.size() > 0) {
         const String8 arg0(args[0]);
-        if (!strcmp(arg0.string(), "-r")) {
+        const bool binary = !strcmp(arg0.string(), "-b");
+        if (binary || !strcmp(arg0.string(), "-r")) {
             // needed because mReaders is protected by mLock
             bool locked = dumpTryLock(mLock);
 
@@ -122,6 +124,17 @@ status_t MediaLogService::dump(int fd, const Vector<String16>& args __unused)
                 return NO_ERROR;
             }
 
+            if (binary) {
+                // Raw snapshots for offline analysis, see NBLog::ArchiveReader.
+                status_t status = NBLog::writeArchiveHeader(fd);
+                for (size_t i = 0; status == NO_ERROR && i < mDumpReaders.size(); i++) {
+                    const auto snapshot = mDumpReaders[i]->getSnapshot();
+                    status = NBLog::writeArchiveRecord(fd, mDumpReaders[i]->name(), *snapshot);
+                }
+                ALOGW_IF(status != NO_ERROR, "%s: archive write failed: %d", __func__, status);
+                mLock.unlock();
+                return NO_ERROR;
+            }
             for (const auto &dumpReader : mDumpReaders) {
                 if (fd >= 0) {
                     dprintf(fd, "\n%s:\n", dumpReader->name().c_str());
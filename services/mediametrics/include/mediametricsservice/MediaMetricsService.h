@@ -17,8 +17,10 @@
 #pragma once
 
 #include <atomic>
+#include <cstring>
 #include <deque>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 
@@ -56,10 +58,30 @@ public:
         return submitInternal(item, false /* release */);
     }
 
+    /**
+     * Submits a buffer of one or more items in byte string form.
+     *
+     * Clients batch items into a single buffer; as every item starts
+     * with its total size, the items are simply concatenated.
+     *
+     * \return status of the last item submitted, or BAD_VALUE if the
+     *         buffer is malformed, in which case the remaining items are dropped.
+     */
     status_t submitBuffer(const char *buffer, size_t length) {
-        mediametrics::Item *item = new mediametrics::Item();
-        return item->readFromByteString(buffer, length)
-                ?: submitInternal(item, true /* release */);
+        status_t status = BAD_VALUE;  // an empty buffer has nothing to submit.
+        while (length > 0) {
+            uint32_t size;
+            if (length < sizeof(size)) return BAD_VALUE;
+            memcpy(&size, buffer, sizeof(size));
+            if (size == 0 || size > length) return BAD_VALUE;
+            auto item = std::make_unique<mediametrics::Item>();
+            status = item->readFromByteString(buffer, size);
+            if (status != NO_ERROR) return status;
+            status = submitInternal(item.release(), true /* release */);
+            buffer += size;
+            length -= size;
+        }
+        return status;
     }
 
     status_t dump(int fd, const Vector<String16>& args) override;
@@ -16,11 +16,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <any>
 #include <map>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
@@ -66,7 +68,122 @@ std::ostream & operator<< (std::ostream& s,
 class TimeMachine final { // made final as we have copy constructor instead of dup() override.
 public:
     using Elem = Item::Prop::Elem;  // use the Item property element.
-    using PropertyHistory = std::multimap<int64_t /* time */, Elem>;
+
+    /**
+     * PropertyHistory is the time sequence of values for a single property.
+     *
+     * It is stored in columns: a vector of times in increasing order, and a vector
+     * of values with the same index.  While all the values are of the same type
+     * (the common case) the values are stored in a vector of that type, and only
+     * a property which changes type falls back to a vector of Elem.
+     *
+     * This avoids the tree node allocation of a multimap per sample; an int32_t
+     * sample takes 12 bytes instead of more than 80.
+     */
+    class PropertyHistory {
+    public:
+        size_t size() const { return mTimes.size(); }
+        bool empty() const { return mTimes.empty(); }
+
+        // Index of the first sample with a time greater than time.
+        size_t upperBound(int64_t time) const {
+            return std::upper_bound(mTimes.begin(), mTimes.end(), time) - mTimes.begin();
+        }
+
+        // Index of the first sample with a time not less than time.
+        size_t lowerBound(int64_t time) const {
+            return std::lower_bound(mTimes.begin(), mTimes.end(), time) - mTimes.begin();
+        }
+
+        int64_t timeAt(size_t index) const { return mTimes[index]; }
+
+        Elem valueAt(size_t index) const {
+            return std::visit([index](const auto& column) { return Elem{column[index]}; },
+                    mValues);
+        }
+
+        // Returns a pointer to the value at index if it is of type T, nullptr otherwise.
+        template <typename T>
+        const T* getIf(size_t index) const {
+            if (const auto column = std::get_if<std::vector<T>>(&mValues)) {
+                return &(*column)[index];
+            }
+            if (const auto column = std::get_if<std::vector<Elem>>(&mValues)) {
+                return std::get_if<T>(&(*column)[index]);
+            }
+            return nullptr;
+        }
+
+        // Returns true if the most recent value equals el.  Must not be empty.
+        bool backEquals(const Elem& el) const {
+            return std::visit([&el](const auto& column) {
+                using V = typename std::decay_t<decltype(column)>::value_type;
+                if constexpr (std::is_same_v<V, Elem>) {
+                    return column.back() == el;
+                } else {
+                    const V* value = std::get_if<V>(&el);
+                    return value != nullptr && column.back() == *value;
+                }
+            }, mValues);
+        }
+
+        // Inserts a sample after any samples with the same or an earlier time.
+        void insert(int64_t time, Elem&& el) {
+            // almost always appended, as items are roughly in time order.
+            const size_t index = mTimes.empty() || time >= mTimes.back()
+                    ? mTimes.size() : upperBound(time);
+            if (mTimes.empty()) {
+                // the first value determines the type of the column.
+                std::visit([this](const auto& value) {
+                    using V = std::decay_t<decltype(value)>;
+                    if constexpr (std::is_same_v<V, std::monostate>) {
+                        mValues.emplace<std::vector<Elem>>();
+                    } else {
+                        mValues.emplace<std::vector<V>>();
+                    }
+                }, el);
+            }
+            const bool inserted = std::visit([index, &el](auto& column) {
+                using V = typename std::decay_t<decltype(column)>::value_type;
+                if constexpr (std::is_same_v<V, Elem>) {
+                    column.insert(column.begin() + index, std::move(el));
+                    return true;
+                } else {
+                    V* value = std::get_if<V>(&el);
+                    if (value == nullptr) return false;
+                    column.insert(column.begin() + index, std::move(*value));
+                    return true;
+                }
+            }, mValues);
+            if (!inserted) {
+                // the type changed, so the values must be stored as Elem from now on.
+                std::vector<Elem> elems;
+                elems.reserve(mTimes.size() + 1);
+                std::visit([&elems](const auto& column) {
+                    for (const auto& value : column) elems.emplace_back(value);
+                }, mValues);
+                elems.insert(elems.begin() + index, std::move(el));
+                mValues = std::move(elems);
+            }
+            mTimes.insert(mTimes.begin() + index, time);
+        }
+
+        // Removes the oldest sample.  Must not be empty.
+        void eraseFront() {
+            mTimes.erase(mTimes.begin());
+            std::visit([](auto& column) { column.erase(column.begin()); }, mValues);
+        }
+
+    private:
+        std::vector<int64_t> mTimes;
+        std::variant<
+                std::vector<Elem>,
+                std::vector<int32_t>,
+                std::vector<int64_t>,
+                std::vector<double>,
+                std::vector<std::string>,
+                std::vector<std::pair<int64_t, int64_t>>> mValues;
+    };
 
 private:
 
@@ -111,11 +228,9 @@ private:
             const auto tsptr = mPropertyMap.find(property);
             if (tsptr == mPropertyMap.end()) return BAD_VALUE;
             const auto& timeSequence = tsptr->second;
-            auto eptr = timeSequence.upper_bound(time);
-            if (eptr == timeSequence.begin()) return BAD_VALUE;
-            --eptr;
-            if (eptr == timeSequence.end()) return BAD_VALUE;
-            const T* vptr = std::get_if<T>(&eptr->second);
+            const size_t index = timeSequence.upperBound(time);
+            if (index == 0) return BAD_VALUE;
+            const T* vptr = timeSequence.getIf<T>(index - 1);
             if (vptr == nullptr) return BAD_VALUE;
             *value = *vptr;
             return NO_ERROR;
@@ -149,13 +264,13 @@ private:
             Elem el{std::forward<T>(e)};
             if (timeSequence.empty()           // no elements
                     || property.back() == AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED
-                    || timeSequence.rbegin()->second != el) { // value changed
-                timeSequence.emplace_hint(timeSequence.end(), time, std::move(el));
+                    || !timeSequence.backEquals(el)) { // value changed
+                timeSequence.insert(time, std::move(el));
 
                 if (timeSequence.size() > kTimeSequenceMaxElements) {
                     ALOGV("%s: restricting maximum elements (discarding oldest) for %s",
                             __func__, property.c_str());
-                    timeSequence.erase(timeSequence.begin());
+                    timeSequence.eraseFront();
                 }
             }
         }
@@ -184,9 +299,9 @@ private:
                 const std::string &key,
                 const std::pair<std::string /* prop */, PropertyHistory>& tsPair,
                 int64_t time) {
-            const auto timeSequence = tsPair.second;
-            auto eptr = timeSequence.lower_bound(time);
-            if (eptr == timeSequence.end()) {
+            const auto& timeSequence = tsPair.second;
+            size_t index = timeSequence.lowerBound(time);
+            if (index == timeSequence.size()) {
                 return {}; // don't dump anything. tsPair.first + "={};\n";
             }
             std::stringstream ss;
@@ -194,14 +309,15 @@ private:
 
             time_string_t last_timestring{}; // last timestring used.
             while (true) {
-                const time_string_t timestring = mediametrics::timeStringFromNs(eptr->first);
+                const time_string_t timestring =
+                        mediametrics::timeStringFromNs(timeSequence.timeAt(index));
                 // find common prefix offset.
                 const size_t offset = commonTimePrefixPosition(timestring.time,
                         last_timestring.time);
                 last_timestring = timestring;
                 ss << "(" << (offset == 0 ? "" : "~") << &timestring.time[offset]
-                    << ") " << eptr->second;
-                if (++eptr == timeSequence.end()) {
+                    << ") " << timeSequence.valueAt(index);
+                if (++index == timeSequence.size()) {
                     break;
                 }
                 ss << ", ";
@@ -326,23 +442,38 @@ public:
         }
 
         // handle remote properties, if any
+        if (deferred.empty()) return NO_ERROR;
+
+        struct RemoteProp {
+            std::string key;
+            std::string name;
+            const mediametrics::Item::Prop *prop;
+            std::shared_ptr<KeyHistory> keyHistory;
+        };
+        std::vector<RemoteProp> remoteProps;
+        remoteProps.reserve(deferred.size());
         for (const auto propptr : deferred) {
-            const auto &prop = *propptr;
-            const std::string &name = prop.getName();
+            const std::string &name = propptr->getName();
             size_t end = name.find_first_of(']'); // TODO: handle nested [] or escape?
             if (end == 0) continue;
             std::string remoteKey = name.substr(1, end - 1);
             std::string remoteName = name.substr(end + 1);
             if (remoteKey.size() == 0 || remoteName.size() == 0) continue;
-            std::shared_ptr<KeyHistory> remoteKeyHistory;
-            {
-                std::lock_guard lock(mLock);
-                auto it = mHistory.find(remoteKey);
-                if (it == mHistory.end()) continue;
-                remoteKeyHistory = it->second;
+            remoteProps.push_back({std::move(remoteKey), std::move(remoteName), propptr, {}});
+        }
+
+        // resolve all the remote keys with a single acquisition of mLock.
+        {
+            std::lock_guard lock(mLock);
+            for (auto &remoteProp : remoteProps) {
+                auto it = mHistory.find(remoteProp.key);
+                if (it != mHistory.end()) remoteProp.keyHistory = it->second;
             }
-            std::lock_guard lock(getLockForKey(remoteKey));
-            remoteKeyHistory->putProp(remoteName, prop, time);
+        }
+        for (const auto &remoteProp : remoteProps) {
+            if (!remoteProp.keyHistory) continue;
+            std::lock_guard lock(getLockForKey(remoteProp.key));
+            remoteProp.keyHistory->putProp(remoteProp.name, *remoteProp.prop, time);
         }
         return NO_ERROR;
     }
@@ -96,7 +96,8 @@ public:
 
         (void)gc(garbage);
         mLog.emplace_hint(mLog.end(), time, item);
-        mItemMap[key].emplace_hint(mItemMap[key].end(), time, item);
+        auto& keyLog = mItemMap[key];
+        keyLog.emplace_hint(keyLog.end(), time, item);
         return NO_ERROR;  // no errors for now.
     }
 
@@ -444,6 +444,31 @@ bool statsd_codec(const std::shared_ptr<const mediametrics::Item>& item,
     }
     AStatsEvent_writeInt32(event, hdrFormat);
 
+    // The per-frame instrumentation is not part of the atom yet; it is only
+    // included in the log below.
+    int64_t latencyP50 = -1;
+    (void)item->getInt64("android.media.mediacodec.latency.p50", &latencyP50);
+    int64_t latencyP90 = -1;
+    (void)item->getInt64("android.media.mediacodec.latency.p90", &latencyP90);
+    int64_t latencyP99 = -1;
+    (void)item->getInt64("android.media.mediacodec.latency.p99", &latencyP99);
+    int64_t renderDriftMax = -1;
+    (void)item->getInt64("android.media.mediacodec.render-drift.max", &renderDriftMax);
+    int64_t renderDriftAvg = -1;
+    (void)item->getInt64("android.media.mediacodec.render-drift.avg", &renderDriftAvg);
+    int64_t renderDriftCount = -1;
+    (void)item->getInt64("android.media.mediacodec.render-drift.n", &renderDriftCount);
+    int64_t inputStarvationCount = -1;
+    (void)item->getInt64("android.media.mediacodec.input-starvation.n", &inputStarvationCount);
+    int64_t outputStarvationCount = -1;
+    (void)item->getInt64("android.media.mediacodec.output-starvation.n", &outputStarvationCount);
+    int64_t configuredMs = -1;
+    (void)item->getInt64("android.media.mediacodec.state.configured-ms", &configuredMs);
+    int64_t startedMs = -1;
+    (void)item->getInt64("android.media.mediacodec.state.started-ms", &startedMs);
+    int64_t flushedMs = -1;
+    (void)item->getInt64("android.media.mediacodec.state.flushed-ms", &flushedMs);
+
     int err = AStatsEvent_write(event);
     if (err < 0) {
       ALOGE("Failed to write codec metrics to statsd (%d)", err);
@@ -524,6 +549,18 @@ bool statsd_codec(const std::shared_ptr<const mediametrics::Item>& item,
             << " original_qp_p_max:" << qpPMaxOri
             << " original_qp_b_min:" << qpBMinOri
             << " original_qp_b_max:" << qpBMaxOri
+
+            << " latency_p50:" << latencyP50
+            << " latency_p90:" << latencyP90
+            << " latency_p99:" << latencyP99
+            << " render_drift_max:" << renderDriftMax
+            << " render_drift_avg:" << renderDriftAvg
+            << " render_drift_count:" << renderDriftCount
+            << " input_starvation_count:" << inputStarvationCount
+            << " output_starvation_count:" << outputStarvationCount
+            << " configured_millis:" << configuredMs
+            << " started_millis:" << startedMs
+            << " flushed_millis:" << flushedMs
             << " }";
     statsdLog->log(android::util::MEDIAMETRICS_CODEC_REPORTED, log.str());
 
@@ -438,6 +438,31 @@ TEST(mediametrics_tests, item_byteserialization) {
   free(data);
 }
 
+TEST(mediametrics_tests, submit_batched_buffer) {
+  mediametrics::Item item("audiotrack");
+  item.setInt32("i32", 1);
+  mediametrics::Item item2("audiotrack");
+  item2.setCString("string", "abc");
+
+  char *data;
+  size_t length;
+  char *data2;
+  size_t length2;
+  ASSERT_EQ(0, item.writeToByteString(&data, &length));
+  ASSERT_EQ(0, item2.writeToByteString(&data2, &length2));
+  std::vector<char> batch(data, data + length);
+  batch.insert(batch.end(), data2, data2 + length2);
+  free(data);
+  free(data2);
+
+  sp mediaMetrics = new MediaMetricsService();
+  ASSERT_EQ(NO_ERROR, mediaMetrics->submitBuffer(batch.data(), batch.size()));
+
+  // a truncated item is rejected.
+  ASSERT_EQ(BAD_VALUE, mediaMetrics->submitBuffer(batch.data(), batch.size() - 1));
+  ASSERT_EQ(BAD_VALUE, mediaMetrics->submitBuffer(batch.data(), 0));
+}
+
 TEST(mediametrics_tests, item_iteration) {
   mediametrics::Item item;
   item.setInt32("i32", 1)
@@ -609,6 +634,39 @@ TEST(mediametrics_tests, time_machine_storage) {
   ASSERT_EQ("abcdefghijklmnopqrstuvwxyz", s);
 }
 
+TEST(mediametrics_tests, time_machine_history) {
+  android::mediametrics::TimeMachine timeMachine;
+  auto item = std::make_shared<mediametrics::Item>("Key");
+  (*item).set("value", (int32_t)1)
+         .setTimestamp(10);
+  ASSERT_EQ(NO_ERROR, timeMachine.put(item, true));
+
+  // values may arrive out of time order.
+  auto item2 = std::make_shared<mediametrics::Item>("Key");
+  (*item2).set("value", (int32_t)2)
+          .setTimestamp(5);
+  ASSERT_EQ(NO_ERROR, timeMachine.put(item2, true));
+
+  // the property changes type.
+  auto item3 = std::make_shared<mediametrics::Item>("Key");
+  (*item3).set("value", "three")
+          .setTimestamp(20);
+  ASSERT_EQ(NO_ERROR, timeMachine.put(item3, true));
+
+  int32_t i32;
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Key", "value", &i32, -1, 4));
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key", "value", &i32, -1, 7));
+  ASSERT_EQ(2, i32);
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key", "value", &i32, -1, 15));
+  ASSERT_EQ(1, i32);
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Key", "value", &i32, -1, 20));
+
+  std::string s;
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key", "value", &s, -1, 20));
+  ASSERT_EQ("three", s);
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Key", "value", &s, -1, 15));
+}
+
 TEST(mediametrics_tests, time_machine_remote_key) {
   auto item = std::make_shared<mediametrics::Item>("Key1");
   (*item).set("one", (int32_t)1)
@@ -25,6 +25,7 @@
 #include <binder/IServiceManager.h>
 #include <cutils/sched_policy.h>
 #include <dirent.h>
+#include <media/MediaMetricsItem.h>
 #include <media/MediaResourcePolicy.h>
 #include <media/stagefright/ProcessInfo.h>
 #include <mediautils/BatteryNotifier.h>
@@ -34,6 +35,11 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <utils/Timers.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <thread>
 
 #include "IMediaResourceMonitor.h"
 #include "ResourceManagerService.h"
@@ -161,14 +167,16 @@ static bool hasResourceType(MediaResource::Type type, MediaResource::SubType sub
     return false;
 }
 
-static bool hasResourceType(MediaResource::Type type, MediaResource::SubType subType,
-        const ResourceInfos& infos) {
-    for (size_t i = 0; i < infos.size(); ++i) {
-        if (hasResourceType(type, subType, infos[i].resources)) {
-            return true;
-        }
+static ResourcePidIndex::key_type getPidIndexKey(MediaResource::Type type,
+        MediaResource::SubType subType) {
+    switch (type) {
+        // Codec subtypes are separate resources, see hasResourceType().
+        case MediaResource::Type::kSecureCodec:
+        case MediaResource::Type::kNonSecureCodec:
+            return {type, subType};
+        default:
+            return {type, MediaResource::SubType::kUnspecifiedSubType};
     }
-    return false;
 }
 
 static ResourceInfos& getResourceInfosForEdit(int pid, PidResourceInfosMap& map) {
@@ -471,6 +479,7 @@ Status ResourceManagerService::addResource(int32_t pid, int32_t uid, int64_t cli
             }
             onFirstAdded(res, info);
             info.resources[resType] = res;
+            addToPidIndex_l(pid, res);
         } else {
             mergeResources(info.resources[resType], res);
         }
@@ -537,6 +546,7 @@ Status ResourceManagerService::removeResource(int32_t pid, int64_t clientId,
                 resource.value -= res.value;
             } else {
                 onLastRemoved(res, info);
+                removeFromPidIndex_l(pid, resource);
                 actualRemoved.value = resource.value;
                 info.resources.erase(resType);
             }
@@ -592,6 +602,7 @@ Status ResourceManagerService::removeResource(int pid, int64_t clientId, bool ch
         onLastRemoved(it->second, info);
     }
 
+    removeFromPidIndex_l(pid, info.resources);
     removeCookieAndUnlink_l(info.client, info.cookie);
 
     if (mObserverService != nullptr && !info.resources.empty()) {
@@ -710,28 +721,91 @@ Status ResourceManagerService::reclaimResource(int32_t callingPid,
     return Status::ok();
 }
 
+// The longest time to wait for the clients to reclaim their resources.
+static constexpr std::chrono::milliseconds kReclaimTimeout{3000};
+
+static void logReclaimMetrics(size_t clientCount, const char* result, nsecs_t latencyNs) {
+    std::unique_ptr<mediametrics::Item> item(mediametrics::Item::create("resourcemanager.reclaim"));
+    item->setInt32("clients", (int32_t)clientCount);
+    item->setCString("result", result);
+    item->setInt64("latencyMs", (int64_t)ns2ms(latencyNs));
+    item->selfrecord();
+}
+
 bool ResourceManagerService::reclaimUnconditionallyFrom(
         const Vector<std::shared_ptr<IResourceManagerClient>> &clients) {
     if (clients.size() == 0) {
         return false;
     }
 
-    std::shared_ptr<IResourceManagerClient> failedClient;
+    // Every client reclaims on its own thread, so that one slow client does not hold up
+    // the others. The state is shared with the threads, as they may outlive this call.
+    struct ReclaimState {
+        std::mutex lock;
+        std::condition_variable condition;
+        size_t pending;
+        std::vector<bool> done;
+        std::vector<bool> success;
+    };
+    auto state = std::make_shared<ReclaimState>();
+    state->pending = clients.size();
+    state->done.resize(clients.size(), false);
+    state->success.resize(clients.size(), false);
+
+    const nsecs_t startTimeNs = systemTime();
     for (size_t i = 0; i < clients.size(); ++i) {
         String8 log = String8::format("reclaimResource from client %p", clients[i].get());
         mServiceLog->add(log);
-        bool success;
-        Status status = clients[i]->reclaimResource(&success);
-        if (!status.isOk() || !success) {
-            failedClient = clients[i];
-            break;
+        std::thread([state, client = clients[i], i] {
+            bool success = false;
+            Status status = client->reclaimResource(&success);
+            std::lock_guard l(state->lock);
+            state->done[i] = true;
+            state->success[i] = status.isOk() && success;
+            --state->pending;
+            state->condition.notify_all();
+        }).detach();
+    }
+
+    std::shared_ptr<IResourceManagerClient> failedClient;
+    bool timedOut = false;
+    {
+        std::unique_lock l(state->lock);
+        // Stop waiting as soon as any client fails, as the reclaim cannot succeed anymore.
+        const auto finished = [&state] {
+            if (state->pending == 0) return true;
+            for (size_t i = 0; i < state->done.size(); ++i) {
+                if (state->done[i] && !state->success[i]) return true;
+            }
+            return false;
+        };
+        timedOut = !state->condition.wait_for(l, kReclaimTimeout, finished);
+        for (size_t i = 0; i < clients.size(); ++i) {
+            if (state->done[i] && !state->success[i]) {
+                failedClient = clients[i];
+                break;
+            }
         }
     }
+    const nsecs_t latencyNs = systemTime() - startTimeNs;
 
-    if (failedClient == NULL) {
+    if (failedClient == NULL && !timedOut) {
+        mServiceLog->add(String8::format("reclaimResource from %zu clients took %lld ms",
+                clients.size(), (long long)ns2ms(latencyNs)));
+        logReclaimMetrics(clients.size(), "success", latencyNs);
         return true;
     }
 
+    if (failedClient == NULL) {
+        // The clients that did not respond keep their resources until they are done.
+        ALOGW("Timed out reclaiming resources from %zu clients", clients.size());
+        mServiceLog->add(String8::format("reclaimResource timed out after %lld ms",
+                (long long)ns2ms(latencyNs)));
+        logReclaimMetrics(clients.size(), "timeout", latencyNs);
+        return false;
+    }
+    logReclaimMetrics(clients.size(), "failed", latencyNs);
+
     int failedClientPid = -1;
     {
         Mutex::Autolock lock(mLock);
@@ -740,6 +814,7 @@ bool ResourceManagerService::reclaimUnconditionallyFrom(
             ResourceInfos &infos = mMap.editValueAt(i);
             for (size_t j = 0; j < infos.size();) {
                 if (infos[j].client == failedClient) {
+                    removeFromPidIndex_l(mMap.keyAt(i), infos[j].resources);
                     j = infos.removeItemsAt(j);
                     found = true;
                 } else {
@@ -966,18 +1041,22 @@ bool ResourceManagerService::getPriority_l(int pid, int* priority) {
 bool ResourceManagerService::getAllClients_l(int callingPid, MediaResource::Type type,
         MediaResource::SubType subType, Vector<std::shared_ptr<IResourceManagerClient>> *clients) {
     Vector<std::shared_ptr<IResourceManagerClient>> temp;
-    for (size_t i = 0; i < mMap.size(); ++i) {
-        ResourceInfos &infos = mMap.editValueAt(i);
-        for (size_t j = 0; j < infos.size(); ++j) {
-            if (hasResourceType(type, subType, infos[j].resources)) {
-                if (!isCallingPriorityHigher_l(callingPid, mMap.keyAt(i))) {
-                    // some higher/equal priority process owns the resource,
-                    // this request can't be fulfilled.
-                    ALOGE("getAllClients_l: can't reclaim resource %s from pid %d",
-                            asString(type), mMap.keyAt(i));
-                    return false;
+    const std::map<int, size_t>* pids = getPidsForResource_l(type, subType);
+    if (pids != nullptr) {
+        // only the processes holding the requested resource type are considered.
+        for (const auto& [pid, entries] : *pids) {
+            const ResourceInfos &infos = mMap.valueFor(pid);
+            for (size_t j = 0; j < infos.size(); ++j) {
+                if (hasResourceType(type, subType, infos[j].resources)) {
+                    if (!isCallingPriorityHigher_l(callingPid, pid)) {
+                        // some higher/equal priority process owns the resource,
+                        // this request can't be fulfilled.
+                        ALOGE("getAllClients_l: can't reclaim resource %s from pid %d",
+                                asString(type), pid);
+                        return false;
+                    }
+                    temp.push_back(infos[j].client);
                 }
-                temp.push_back(infos[j].client);
             }
         }
     }
@@ -1025,16 +1104,12 @@ bool ResourceManagerService::getLowestPriorityPid_l(MediaResource::Type type,
         MediaResource::SubType subType, int *lowestPriorityPid, int *lowestPriority) {
     int pid = -1;
     int priority = -1;
-    for (size_t i = 0; i < mMap.size(); ++i) {
-        if (mMap.valueAt(i).size() == 0) {
-            // no client on this process.
-            continue;
-        }
-        if (!hasResourceType(type, subType, mMap.valueAt(i))) {
-            // doesn't have the requested resource type
-            continue;
-        }
-        int tempPid = mMap.keyAt(i);
+    // only the processes holding the requested resource type are considered.
+    const std::map<int, size_t>* pids = getPidsForResource_l(type, subType);
+    if (pids == nullptr) {
+        return false;
+    }
+    for (const auto& [tempPid, entries] : *pids) {
         int tempPriority;
         if (!getPriority_l(tempPid, &tempPriority)) {
             ALOGV("getLowestPriorityPid_l: can't get priority of pid %d, skipped", tempPid);
@@ -1054,6 +1129,39 @@ bool ResourceManagerService::getLowestPriorityPid_l(MediaResource::Type type,
     return (pid != -1);
 }
 
+void ResourceManagerService::addToPidIndex_l(int pid, const MediaResourceParcel& resource) {
+    ++mPidIndex[getPidIndexKey(resource.type, resource.subType)][pid];
+}
+
+void ResourceManagerService::removeFromPidIndex_l(int pid, const MediaResourceParcel& resource) {
+    auto typeIt = mPidIndex.find(getPidIndexKey(resource.type, resource.subType));
+    if (typeIt == mPidIndex.end()) {
+        return;
+    }
+    auto pidIt = typeIt->second.find(pid);
+    if (pidIt == typeIt->second.end()) {
+        return;
+    }
+    if (--pidIt->second == 0) {
+        typeIt->second.erase(pidIt);
+        if (typeIt->second.empty()) {
+            mPidIndex.erase(typeIt);
+        }
+    }
+}
+
+void ResourceManagerService::removeFromPidIndex_l(int pid, const ResourceList& resources) {
+    for (auto it = resources.begin(); it != resources.end(); it++) {
+        removeFromPidIndex_l(pid, it->second);
+    }
+}
+
+const std::map<int, size_t>* ResourceManagerService::getPidsForResource_l(
+        MediaResource::Type type, MediaResource::SubType subType) const {
+    auto it = mPidIndex.find(getPidIndexKey(type, subType));
+    return it == mPidIndex.end() ? nullptr : &it->second;
+}
+
 bool ResourceManagerService::isCallingPriorityHigher_l(int callingPid, int pid) {
     int callingPidPriority;
     if (!getPriority_l(callingPid, &callingPidPriority)) {
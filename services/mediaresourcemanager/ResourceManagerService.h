@@ -61,6 +61,11 @@ struct ResourceInfo {
 typedef KeyedVector<int64_t, ResourceInfo> ResourceInfos;
 typedef KeyedVector<int, ResourceInfos> PidResourceInfosMap;
 
+// For each resource type, the pids holding it and the number of resource entries
+// of the type they hold. Codec resources are indexed by subtype as well.
+typedef std::map<std::pair<MediaResource::Type, MediaResource::SubType>,
+        std::map<int /* pid */, size_t /* entries */>> ResourcePidIndex;
+
 class ResourceManagerService : public BnResourceManagerService {
 public:
     struct SystemCallbackInterface : public RefBase {
@@ -116,8 +121,8 @@ private:
     friend class DeathNotifier;
     friend class OverrideProcessInfoDeathNotifier;
 
-    // Reclaims resources from |clients|. Returns true if reclaim succeeded
-    // for all clients.
+    // Reclaims resources from |clients| in parallel. Returns true if reclaim succeeded
+    // for all clients before the timeout.
     bool reclaimUnconditionallyFrom(const Vector<std::shared_ptr<IResourceManagerClient>> &clients);
 
     // Gets the list of all the clients who own the specified resource type.
@@ -149,6 +154,16 @@ private:
 
     bool isCallingPriorityHigher_l(int callingPid, int pid);
 
+    // Keeps mPidIndex up to date when a resource entry is added to or removed from
+    // a client of pid.
+    void addToPidIndex_l(int pid, const MediaResourceParcel& resource);
+    void removeFromPidIndex_l(int pid, const MediaResourceParcel& resource);
+    void removeFromPidIndex_l(int pid, const ResourceList& resources);
+
+    // Returns the pids holding the specified resource type, or nullptr if there are none.
+    const std::map<int, size_t>* getPidsForResource_l(MediaResource::Type type,
+            MediaResource::SubType subType) const;
+
     // A helper function basically calls getLowestPriorityBiggestClient_l and add
     // the result client to the given Vector.
     void getClientForResource_l(int callingPid, const MediaResourceParcel *res,
@@ -176,6 +191,7 @@ private:
     sp<SystemCallbackInterface> mSystemCB;
     sp<ServiceLog> mServiceLog;
     PidResourceInfosMap mMap;
+    ResourcePidIndex mPidIndex;
     bool mSupportsMultipleSecureCodecs;
     bool mSupportsSecureWithNonSecureCodec;
     int32_t mCpuBoostCount;
@@ -721,6 +721,10 @@ public:
         int priority2;
         processInfo.getPriority(kTestPid2, &priority2);
         EXPECT_EQ(priority2, priority);
+
+        // kTestPid2 no longer holds a non-secure codec once mTestClient2 is removed.
+        mService->removeClient(kTestPid2, getId(mTestClient2));
+        EXPECT_FALSE(mService->getLowestPriorityPid_l(type, subType, &pid, &priority));
     }
 
     void testIsCallingPriorityHigher() {
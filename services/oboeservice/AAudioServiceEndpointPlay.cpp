@@ -63,7 +63,101 @@ aaudio_result_t AAudioServiceEndpointPlay::open(const aaudio::AAudioStreamReques
     return result;
 }
 
+// Returns the only client stream that is started, if there is exactly one stream
+// that should be processed during this burst. Otherwise returns nullptr.
+sp<AAudioServiceStreamShared> AAudioServiceEndpointPlay::getSoleStartedStream_l() {
+    sp<AAudioServiceStreamShared> soleStream;
+    for (const auto& clientStream : mRegisteredStreams) {
+        if (clientStream->isSuspended()) {
+            continue; // dead stream
+        }
+        aaudio_stream_state_t state = clientStream->getState();
+        if (state == AAUDIO_STREAM_STATE_STOPPING) {
+            return nullptr; // needs the mixer to drain without underflow
+        } else if (state != AAUDIO_STREAM_STATE_STARTED) {
+            continue; // this stream is not running so skip it.
+        }
+        if (soleStream != nullptr) {
+            return nullptr; // more than one stream, so we need to mix
+        }
+        soleStream = static_cast<AAudioServiceStreamShared *>(clientStream.get());
+    }
+    return soleStream;
+}
+
+// Mix data from each active stream into the mixer output buffer.
+void AAudioServiceEndpointPlay::mixStreams_l(int64_t mmapFramesWritten) {
+    mMixer.clear();
+
+    int index = 0;
+    for (const auto& clientStream : mRegisteredStreams) {
+        int64_t clientFramesRead = 0;
+        bool allowUnderflow = true;
+
+        if (clientStream->isSuspended()) {
+            continue; // dead stream
+        }
+
+        aaudio_stream_state_t state = clientStream->getState();
+        if (state == AAUDIO_STREAM_STATE_STOPPING) {
+            allowUnderflow = false; // just read what is already in the FIFO
+        } else if (state != AAUDIO_STREAM_STATE_STARTED) {
+            continue; // this stream is not running so skip it.
+        }
+
+        sp<AAudioServiceStreamShared> streamShared =
+                static_cast<AAudioServiceStreamShared *>(clientStream.get());
+
+        {
+            // Lock the AudioFifo to protect against close.
+            std::lock_guard <std::mutex> lock(streamShared->audioDataQueueLock);
+            std::shared_ptr<SharedRingBuffer> audioDataQueue
+                    = streamShared->getAudioDataQueue_l();
+            std::shared_ptr<FifoBuffer> fifo;
+            if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())) {
+
+                // Determine offset between framePosition in client's stream
+                // vs the underlying MMAP stream.
+                clientFramesRead = fifo->getReadCounter();
+                // These two indices refer to the same frame.
+                int64_t positionOffset = mmapFramesWritten - clientFramesRead;
+                streamShared->setTimestampPositionOffset(positionOffset);
+
+                int32_t framesMixed = mMixer.mix(index, fifo, allowUnderflow);
+
+                if (streamShared->isFlowing()) {
+                    // Consider it an underflow if we got less than a burst
+                    // after the data started flowing.
+                    bool underflowed = allowUnderflow
+                                       && framesMixed < mMixer.getFramesPerBurst();
+                    if (underflowed) {
+                        streamShared->incrementXRunCount();
+                    }
+                } else if (framesMixed > 0) {
+                    // Mark beginning of data flow after a start.
+                    streamShared->setFlowing(true);
+                }
+                clientFramesRead = fifo->getReadCounter();
+            }
+        }
+
+        if (clientFramesRead > 0) {
+            // This timestamp represents the completion of data being read out of the
+            // client buffer. It is sent to the client and used in the timing model
+            // to decide when the client has room to write more data.
+            Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
+            streamShared->markTransferTime(timestamp);
+        }
+
+        index++; // just used for labelling tracks in systrace
+    }
+}
+
 // Mix data from each application stream and write result to the shared MMAP stream.
+//
+// If a single client stream is running and a full burst is contiguous in its FIFO,
+// the mixer is bypassed and the burst is written to the MMAP stream directly
+// from the client FIFO, saving a clear and a copy of the burst.
 void *AAudioServiceEndpointPlay::callbackLoop() {
     ALOGD("%s() entering >>>>>>>>>>>>>>> MIXER", __func__);
     aaudio_result_t result = AAUDIO_OK;
@@ -71,80 +165,55 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
 
     // result might be a frame count
     while (mCallbackEnabled.load() && getStreamInternal()->isActive() && (result >= 0)) {
-        // Mix data from each active stream.
-        mMixer.clear();
+        sp<AAudioServiceStreamShared> bypassStream;
+        // Holding the queue keeps the FIFO memory valid even if the client closes.
+        std::shared_ptr<SharedRingBuffer> bypassQueue;
+        const void *bypassData = nullptr;
 
         { // brackets are for lock_guard
-            int index = 0;
             int64_t mmapFramesWritten = getStreamInternal()->getFramesWritten();
 
             std::lock_guard <std::mutex> lock(mLockStreams);
-            for (const auto& clientStream : mRegisteredStreams) {
-                int64_t clientFramesRead = 0;
-                bool allowUnderflow = true;
-
-                if (clientStream->isSuspended()) {
-                    continue; // dead stream
-                }
-
-                aaudio_stream_state_t state = clientStream->getState();
-                if (state == AAUDIO_STREAM_STATE_STOPPING) {
-                    allowUnderflow = false; // just read what is already in the FIFO
-                } else if (state != AAUDIO_STREAM_STATE_STARTED) {
-                    continue; // this stream is not running so skip it.
-                }
-
-                sp<AAudioServiceStreamShared> streamShared =
-                        static_cast<AAudioServiceStreamShared *>(clientStream.get());
-
-                {
-                    // Lock the AudioFifo to protect against close.
-                    std::lock_guard <std::mutex> lock(streamShared->audioDataQueueLock);
-                    std::shared_ptr<SharedRingBuffer> audioDataQueue
-                            = streamShared->getAudioDataQueue_l();
-                    std::shared_ptr<FifoBuffer> fifo;
-                    if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())) {
-
-                        // Determine offset between framePosition in client's stream
-                        // vs the underlying MMAP stream.
-                        clientFramesRead = fifo->getReadCounter();
-                        // These two indices refer to the same frame.
-                        int64_t positionOffset = mmapFramesWritten - clientFramesRead;
-                        streamShared->setTimestampPositionOffset(positionOffset);
-
-                        int32_t framesMixed = mMixer.mix(index, fifo, allowUnderflow);
-
-                        if (streamShared->isFlowing()) {
-                            // Consider it an underflow if we got less than a burst
-                            // after the data started flowing.
-                            bool underflowed = allowUnderflow
-                                               && framesMixed < mMixer.getFramesPerBurst();
-                            if (underflowed) {
-                                streamShared->incrementXRunCount();
-                            }
-                        } else if (framesMixed > 0) {
-                            // Mark beginning of data flow after a start.
-                            streamShared->setFlowing(true);
-                        }
-                        clientFramesRead = fifo->getReadCounter();
-                    }
-                }
-
-                if (clientFramesRead > 0) {
-                    // This timestamp represents the completion of data being read out of the
-                    // client buffer. It is sent to the client and used in the timing model
-                    // to decide when the client has room to write more data.
-                    Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
-                    streamShared->markTransferTime(timestamp);
+            bypassStream = getSoleStartedStream_l();
+            if (bypassStream != nullptr) {
+                // Lock the AudioFifo to protect against close.
+                std::lock_guard <std::mutex> lock(bypassStream->audioDataQueueLock);
+                std::shared_ptr<SharedRingBuffer> audioDataQueue
+                        = bypassStream->getAudioDataQueue_l();
+                std::shared_ptr<FifoBuffer> fifo;
+                WrappingBuffer wrappingBuffer;
+                if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())
+                        && fifo->getFullDataAvailable(&wrappingBuffer) >= getFramesPerBurst()
+                        && wrappingBuffer.numFrames[0] >= getFramesPerBurst()) {
+                    // These two indices refer to the same frame.
+                    int64_t positionOffset = mmapFramesWritten - fifo->getReadCounter();
+                    bypassStream->setTimestampPositionOffset(positionOffset);
+                    bypassQueue = audioDataQueue;
+                    bypassData = wrappingBuffer.data[0];
                 }
+            }
+            if (bypassData == nullptr) {
+                mixStreams_l(mmapFramesWritten);
+            }
+        }
 
-                index++; // just used for labelling tracks in systrace
+        // Write mixer output (or the sole client data) to stream using a blocking write.
+        result = getStreamInternal()->write(
+                bypassData != nullptr ? bypassData : mMixer.getOutputBuffer(),
+                getFramesPerBurst(), timeoutNanos);
+
+        if (bypassData != nullptr) {
+            std::shared_ptr<FifoBuffer> fifo = bypassQueue->getFifoBuffer();
+            fifo->advanceReadIndex(getFramesPerBurst());
+            // A full burst was available, so this is never an underflow.
+            if (!bypassStream->isFlowing()) {
+                // Mark beginning of data flow after a start.
+                bypassStream->setFlowing(true);
             }
+            Timestamp timestamp(fifo->getReadCounter(), AudioClock::getNanoseconds());
+            bypassStream->markTransferTime(timestamp);
         }
 
-        // Write mixer output to stream using a blocking write.
-        result = getStreamInternal()->write(mMixer.getOutputBuffer(),
-                                            getFramesPerBurst(), timeoutNanos);
         if (result == AAUDIO_ERROR_DISCONNECTED) {
             ALOGD("%s() write() returned AAUDIO_ERROR_DISCONNECTED", __func__);
             AAudioServiceEndpointShared::handleDisconnectRegisteredStreamsAsync();
@@ -45,6 +45,10 @@ public:
     void *callbackLoop() override;
 
 private:
+    android::sp<AAudioServiceStreamShared> getSoleStartedStream_l();
+
+    void mixStreams_l(int64_t mmapFramesWritten);
+
     bool                     mLatencyTuningEnabled = false; // TODO implement tuning
     AAudioMixer              mMixer;    //
 };
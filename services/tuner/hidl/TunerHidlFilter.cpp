@@ -921,10 +921,22 @@ HidlDemuxFilterDownloadSettings TunerHidlFilter::getHidlDownloadSettings(
 }
 
 /////////////// FilterCallback ///////////////////////
+TunerHidlFilter::FilterCallback::~FilterCallback() {
+    {
+        std::lock_guard<std::mutex> lock(mDispatchLock);
+        mDispatchStopped = true;
+        mPendingCallbacks.clear();
+    }
+    mDispatchCondition.notify_all();
+    if (mDispatchThread.joinable()) {
+        mDispatchThread.join();
+    }
+}
+
 Return<void> TunerHidlFilter::FilterCallback::onFilterStatus(HidlDemuxFilterStatus status) {
     Mutex::Autolock _l(mCallbackLock);
     if (mTunerFilterCallback != nullptr) {
-        mTunerFilterCallback->onFilterStatus(static_cast<DemuxFilterStatus>(status));
+        queueStatus_l(static_cast<DemuxFilterStatus>(status));
     }
     return Void();
 }
@@ -948,7 +960,9 @@ Return<void> TunerHidlFilter::FilterCallback::onFilterEvent_1_1(
         vector<DemuxFilterEvent> tunerEvents;
 
         getAidlFilterEvent(events, eventsExt, tunerEvents);
-        mTunerFilterCallback->onFilterEvent(tunerEvents);
+        if (!tunerEvents.empty()) {
+            queueEvents_l(move(tunerEvents));
+        }
     }
     return Void();
 }
@@ -956,7 +970,7 @@ Return<void> TunerHidlFilter::FilterCallback::onFilterEvent_1_1(
 void TunerHidlFilter::FilterCallback::sendSharedFilterStatus(int32_t status) {
     Mutex::Autolock _l(mCallbackLock);
     if (mTunerFilterCallback != nullptr && mOriginalCallback != nullptr) {
-        mTunerFilterCallback->onFilterStatus(static_cast<DemuxFilterStatus>(status));
+        queueStatus_l(static_cast<DemuxFilterStatus>(status));
     }
 }
 
@@ -979,6 +993,77 @@ void TunerHidlFilter::FilterCallback::detachCallbacks() {
     Mutex::Autolock _l(mCallbackLock);
     mOriginalCallback = nullptr;
     mTunerFilterCallback = nullptr;
+
+    // The filter is closed, nothing that is still pending is of use to the client.
+    std::lock_guard<std::mutex> lock(mDispatchLock);
+    mPendingCallbacks.clear();
+}
+
+void TunerHidlFilter::FilterCallback::queueEvents_l(vector<DemuxFilterEvent>&& events) {
+    std::lock_guard<std::mutex> lock(mDispatchLock);
+    if (mDispatchStopped) {
+        return;
+    }
+
+    if (!mPendingCallbacks.empty() && !mPendingCallbacks.back().isStatus &&
+        mPendingCallbacks.back().callback == mTunerFilterCallback) {
+        vector<DemuxFilterEvent>& pending = mPendingCallbacks.back().events;
+        pending.insert(pending.end(), make_move_iterator(events.begin()),
+                       make_move_iterator(events.end()));
+        return;
+    }
+
+    PendingCallback pendingCallback{
+            .callback = mTunerFilterCallback,
+            .isStatus = false,
+            .events = move(events),
+    };
+    mPendingCallbacks.push_back(move(pendingCallback));
+    if (!mDispatchThread.joinable()) {
+        mDispatchThread = std::thread(&TunerHidlFilter::FilterCallback::dispatchLoop, this);
+    }
+    mDispatchCondition.notify_one();
+}
+
+void TunerHidlFilter::FilterCallback::queueStatus_l(DemuxFilterStatus status) {
+    std::lock_guard<std::mutex> lock(mDispatchLock);
+    if (mDispatchStopped) {
+        return;
+    }
+
+    PendingCallback pendingCallback{
+            .callback = mTunerFilterCallback,
+            .isStatus = true,
+            .status = status,
+    };
+    mPendingCallbacks.push_back(move(pendingCallback));
+    if (!mDispatchThread.joinable()) {
+        mDispatchThread = std::thread(&TunerHidlFilter::FilterCallback::dispatchLoop, this);
+    }
+    mDispatchCondition.notify_one();
+}
+
+void TunerHidlFilter::FilterCallback::dispatchLoop() {
+    std::unique_lock<std::mutex> lock(mDispatchLock);
+    while (true) {
+        mDispatchCondition.wait(lock,
+                                [this] { return mDispatchStopped || !mPendingCallbacks.empty(); });
+        if (mDispatchStopped) {
+            break;
+        }
+
+        PendingCallback pendingCallback = move(mPendingCallbacks.front());
+        mPendingCallbacks.pop_front();
+
+        // Events queued while the client handles this callback are merged into one batch.
+        lock.unlock();
+        if (pendingCallback.isStatus) {
+            pendingCallback.callback->onFilterStatus(pendingCallback.status);
+        } else {
+            pendingCallback.callback->onFilterEvent(pendingCallback.events);
+        }
+        lock.lock();
+    }
 }
 
 /////////////// FilterCallback Helper Methods ///////////////////////
@@ -36,7 +36,11 @@
 #include <fmq/MessageQueue.h>
 #include <utils/Mutex.h>
 
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <thread>
 
 using ::aidl::android::hardware::common::NativeHandle;
 using ::aidl::android::hardware::common::fmq::MQDescriptor;
@@ -120,6 +124,7 @@ public:
     public:
         FilterCallback(const shared_ptr<ITunerFilterCallback> tunerFilterCallback)
               : mTunerFilterCallback(tunerFilterCallback){};
+        virtual ~FilterCallback();
 
         virtual Return<void> onFilterEvent(const HidlDemuxFilterEvent& filterEvent);
         virtual Return<void> onFilterEvent_1_1(const HidlDemuxFilterEvent& filterEvent,
@@ -132,6 +137,21 @@ public:
         void detachCallbacks();
 
     private:
+        // A status or a batch of events waiting to be delivered to a client callback.
+        struct PendingCallback {
+            shared_ptr<ITunerFilterCallback> callback;
+            bool isStatus;
+            DemuxFilterStatus status;
+            vector<DemuxFilterEvent> events;
+        };
+
+        // Queues events for the dispatch thread, merging them with events that are still
+        // waiting for the same client. Called with mCallbackLock held.
+        void queueEvents_l(vector<DemuxFilterEvent>&& events);
+        // Queues a status for the dispatch thread. Called with mCallbackLock held.
+        void queueStatus_l(DemuxFilterStatus status);
+        void dispatchLoop();
+
         void getAidlFilterEvent(const vector<HidlDemuxFilterEvent::Event>& events,
                                 const vector<HidlDemuxFilterEventExt::Event>& eventsExt,
                                 vector<DemuxFilterEvent>& aidlEvents);
@@ -163,6 +183,15 @@ public:
         shared_ptr<ITunerFilterCallback> mTunerFilterCallback;
         shared_ptr<ITunerFilterCallback> mOriginalCallback;
         Mutex mCallbackLock;
+
+        // Callbacks are delivered to the client on a separate thread, so the HAL callback
+        // thread never waits for the client. Events that arrive while the client is busy are
+        // delivered together in one callback.
+        std::mutex mDispatchLock;
+        std::condition_variable mDispatchCondition;
+        std::deque<PendingCallback> mPendingCallbacks;
+        std::thread mDispatchThread;
+        bool mDispatchStopped = false;
     };
 
     TunerHidlFilter(sp<HidlIFilter> filter, sp<FilterCallback> cb, DemuxFilterType type);